@@ -0,0 +1,763 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Config.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Flash-backed key / value configuration store: network credentials, country code, host name and tuning values survive a reboot, so that
+   changing them does not require flashing a new Firmware. CONFIG_SECTORS sectors are reserved at the end of flash.
+   - Append-only: changing a value appends a record (Magic, Key, Length, Value, CRC-16) to the active sector; the latest valid record of a key wins.
+     A record interrupted by a power loss fails its CRC check and is ignored. An unchanged value is not written again.
+   - Wear leveling: when the active sector is full, the latest value of each key is copied to the next sector of the ring, which becomes active.
+     Its header (with the generation number) is written last, so that the new sector only becomes valid once complete: a power loss during
+     compaction leaves the previous sector active. Each sector is erased once every CONFIG_SECTORS compactions.
+   - Loading: at boot, the active sector is selected from the headers and scanned once to build an index (offset of the latest record of each key).
+     Values are then read in O(1) from the index, directly from flash (execute-in-place area).
+   Flash is erased, programmed and verified through Pico-WiFi-Flash.c, which also provides the CRC-16.
+   On a host, flash is replaced by a RAM image (see wifi_config_image()), so that the store can be tested (power loss, corruption, rotation).
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Flash access, sector header and CRC-16 moved to Pico-WiFi-Flash.c (shared with Pico-WiFi-Queue.c).
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "ctype.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "Pico-WiFi-Config.h"
+#include "Pico-WiFi-Flash.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define CONFIG_MAGIC            0x31464357     // "WCF1", first word of a valid sector header.
+#define CONFIG_HEADER_SIZE              12     // Magic u32, Sequence u32, CRC-16 of both, 2 bytes of padding.
+#define CONFIG_RECORD_MAGIC           0x5A     // first byte of a record; 0xFF is free space.
+#define CONFIG_RECORD_OVERHEAD           5     // Magic, Key, Length, then CRC-16 after the value.
+#define CONFIG_RECORD_SIZE(Length)  (((Length) + CONFIG_RECORD_OVERHEAD + 3) & ~3)    // records are aligned on 4 bytes.
+#define CONFIG_NO_SECTOR    CONFIG_SECTORS
+#define CONFIG_KNOWN_KEYS                6
+
+#define CONFIG_FLASH_DATA(Offset)  WIFI_FLASH_DATA(&ConfigFlash, Offset)
+
+_Static_assert(WIFI_FLASH_HEADER_SIZE <= CONFIG_HEADER_SIZE, "sector header does not fit in CONFIG_HEADER_SIZE");
+
+/* Every key fits in a sector after compaction. */
+_Static_assert(CONFIG_HEADER_SIZE + (CONFIG_MAX_KEYS * CONFIG_RECORD_SIZE(CONFIG_MAX_VALUE)) <= CONFIG_SECTOR_SIZE, "CONFIG_MAX_KEYS x CONFIG_MAX_VALUE does not fit in a sector");
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UINT8  Active;                                       // active sector, CONFIG_NO_SECTOR: nothing saved yet.
+  UINT32 Sequence;                                     // generation of the active sector.
+  UINT16 Free;                                         // offset of free space in the active sector.
+  UINT16 Index[CONFIG_MAX_KEYS];                       // offset of the latest record of each key in the active sector, 0: not set.
+  struct struct_config_stats Stats;
+} Config = {CONFIG_NO_SECTOR};
+
+static const struct
+{
+  const UCHAR *Name;
+  UINT8 Type;
+} KeyInfo[CONFIG_KNOWN_KEYS] =
+{
+  {"ssid",     CONFIG_TYPE_STRING},
+  {"password", CONFIG_TYPE_SECRET},
+  {"country",  CONFIG_TYPE_COUNTRY},
+  {"hostname", CONFIG_TYPE_STRING},
+  {"power",    CONFIG_TYPE_NUMBER},
+  {"export",   CONFIG_TYPE_NUMBER}
+};
+
+#if PICO_ON_DEVICE
+/* Last CONFIG_SECTORS sectors of flash. */
+static const struct struct_flash_region ConfigFlash = {PICO_FLASH_SIZE_BYTES - (CONFIG_SECTORS * CONFIG_SECTOR_SIZE), CONFIG_SECTORS * CONFIG_SECTOR_SIZE, NULL};
+#else   // PICO_ON_DEVICE
+static UINT8 ConfigImage[CONFIG_SECTORS * CONFIG_SECTOR_SIZE];
+static UINT8 FlagImage;                                // image has been erased (0xFF) once.
+static const struct struct_flash_region ConfigFlash = {0, sizeof(ConfigImage), ConfigImage};
+#endif  // PICO_ON_DEVICE
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log data to log file. */
+extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Append a record to the active sector. */
+static INT16 config_append(UINT8 Key, const void *Value, UINT8 Length);
+
+/* Build a record in caller's buffer and return its size. */
+static UINT16 config_build_record(UINT8 *Record, UINT8 Key, const void *Value, UINT8 Length);
+
+/* Copy the latest value of each key to the next sector, which becomes active. */
+static INT16 config_compact(UINT8 Key, const void *Value, UINT8 Length);
+
+/* Scan a sector and build the index of its records. */
+static INT16 config_scan(UINT8 Sector);
+
+/* Return the type of a key. */
+static UINT8 config_type(UINT8 Key);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=config_append(). */
+/* ============================================================================================================================================================= *\
+              Append a record to the active sector. The sector is compacted first when the record does not fit (or when nothing has been saved yet).
+\* ============================================================================================================================================================= */
+static INT16 config_append(UINT8 Key, const void *Value, UINT8 Length)
+{
+  UINT8 Record[CONFIG_RECORD_SIZE(CONFIG_MAX_VALUE)];
+
+  UINT16 Size;
+
+
+  if ((Config.Active == CONFIG_NO_SECTOR) || ((Config.Free + CONFIG_RECORD_SIZE(Length)) > CONFIG_SECTOR_SIZE)) return config_compact(Key, Value, Length);
+
+  Size = config_build_record(Record, Key, Value, Length);
+  if (wifi_flash_program(&ConfigFlash, (Config.Active * CONFIG_SECTOR_SIZE) + Config.Free, Record, Size) != 0)
+  {
+    /* Whatever has been written is ignored (CRC); next write goes to a fresh sector. */
+    ++Config.Stats.Errors;
+    Config.Free = CONFIG_SECTOR_SIZE;
+    return -1;
+  }
+
+  Config.Index[Key] = (Length == 0) ? 0 : Config.Free;
+  Config.Free += Size;
+  ++Config.Stats.Writes;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=config_build_record(). */
+/* ============================================================================================================================================================= *\
+         Build a record in caller's buffer: Magic, Key, Length, Value, CRC-16 (little-endian) of all previous bytes, 0xFF up to the next 4-byte boundary.
+                                                     Value may live in flash. Return the size of the record.
+\* ============================================================================================================================================================= */
+static UINT16 config_build_record(UINT8 *Record, UINT8 Key, const void *Value, UINT8 Length)
+{
+  UINT16 Crc;
+  UINT16 Size;
+
+
+  Size = CONFIG_RECORD_SIZE(Length);
+  memset(Record, 0xFF, Size);
+  Record[0] = CONFIG_RECORD_MAGIC;
+  Record[1] = Key;
+  Record[2] = Length;
+  if (Length != 0) memcpy(&Record[3], Value, Length);
+  Crc = wifi_flash_crc16(0xFFFF, Record, Length + 3);
+  Record[Length + 3] = (UINT8)Crc;
+  Record[Length + 4] = (UINT8)(Crc >> 8);
+
+  return Size;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=config_compact(). */
+/* ============================================================================================================================================================= *\
+             Erase the next sector of the ring and copy the latest value of each key to it, Key being given its new Value (erased when Length is 0).
+                  The header is written last: until then, the previous sector remains the active one, so a power loss at any time loses nothing.
+\* ============================================================================================================================================================= */
+static INT16 config_compact(UINT8 Key, const void *Value, UINT8 Length)
+{
+  UINT8 Record[CONFIG_RECORD_SIZE(CONFIG_MAX_VALUE)];
+  UINT8 Header[CONFIG_HEADER_SIZE];
+  UINT8 Loop1UInt8;
+  UINT8 Sector;
+
+  UINT16 Offset;
+  UINT16 Size;
+
+  UINT32 Sequence;
+
+  const UINT8 *Old;
+
+
+  Sector   = (Config.Active == CONFIG_NO_SECTOR) ? 0 : ((Config.Active + 1) % CONFIG_SECTORS);
+  Sequence = Config.Sequence + 1;
+
+  wifi_flash_erase(&ConfigFlash, Sector * CONFIG_SECTOR_SIZE);
+  ++Config.Stats.Erases;
+
+  Offset = CONFIG_HEADER_SIZE;
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_MAX_KEYS; ++Loop1UInt8)
+  {
+    if (Loop1UInt8 == Key)
+    {
+      if (Length == 0) continue;
+      Size = config_build_record(Record, Key, Value, Length);
+    }
+    else
+    {
+      if (Config.Index[Loop1UInt8] == 0) continue;
+      Old  = CONFIG_FLASH_DATA((Config.Active * CONFIG_SECTOR_SIZE) + Config.Index[Loop1UInt8]);
+      Size = CONFIG_RECORD_SIZE(Old[2]);
+      memcpy(Record, Old, Size);  // flash is not readable while it is programmed: copy to RAM first.
+    }
+
+    if (wifi_flash_program(&ConfigFlash, (Sector * CONFIG_SECTOR_SIZE) + Offset, Record, Size) != 0)
+    {
+      ++Config.Stats.Errors;
+      return -1;
+    }
+    Offset += Size;
+  }
+
+  /* Commit. */
+  memset(Header, 0xFF, sizeof(Header));
+  wifi_flash_header(Header, CONFIG_MAGIC, Sequence);
+  if (wifi_flash_program(&ConfigFlash, Sector * CONFIG_SECTOR_SIZE, Header, sizeof(Header)) != 0)
+  {
+    ++Config.Stats.Errors;
+    return -1;
+  }
+
+  Config.Active   = Sector;
+  Config.Sequence = Sequence;
+  config_scan(Sector);
+  ++Config.Stats.Writes;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=config_scan(). */
+/* ============================================================================================================================================================= *\
+         Scan the records of a sector and build the index (latest record of each key). Scan stops at free space (0xFF), or at a record that is not valid:
+          it has been interrupted by a power loss or flash is corrupted. In that case, free space is considered exhausted, so that the next write moves
+                                       the valid records to a fresh sector. Return -1 if an invalid record has been found.
+\* ============================================================================================================================================================= */
+static INT16 config_scan(UINT8 Sector)
+{
+  UINT8 Length;
+
+  UINT16 Offset;
+  UINT16 Size;
+
+  const UINT8 *Record;
+
+
+  memset(Config.Index, 0x00, sizeof(Config.Index));
+
+  Offset = CONFIG_HEADER_SIZE;
+  while (Offset < CONFIG_SECTOR_SIZE)
+  {
+    Record = CONFIG_FLASH_DATA((Sector * CONFIG_SECTOR_SIZE) + Offset);
+
+    /* Free space. */
+    if (Record[0] == 0xFF) break;
+
+    Length = Record[2];
+    Size   = CONFIG_RECORD_SIZE(Length);
+    if ((Record[0] != CONFIG_RECORD_MAGIC) || (Record[1] >= CONFIG_MAX_KEYS) || (Length > CONFIG_MAX_VALUE) || ((Offset + Size) > CONFIG_SECTOR_SIZE) ||
+        (wifi_flash_crc16(0xFFFF, Record, Length + 3) != ((UINT16)Record[Length + 3] | ((UINT16)Record[Length + 4] << 8))))
+    {
+      ++Config.Stats.Errors;
+      Config.Free = CONFIG_SECTOR_SIZE;
+      return -1;
+    }
+
+    /* Length 0: key has been erased. */
+    Config.Index[Record[1]] = (Length == 0) ? 0 : Offset;
+    Offset += Size;
+  }
+  Config.Free = Offset;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=config_type(). */
+/* ============================================================================================================================================================= *\
+                                                  Return the type of a key. Keys of the application are binary.
+\* ============================================================================================================================================================= */
+static UINT8 config_type(UINT8 Key)
+{
+  if (Key < CONFIG_KNOWN_KEYS) return KeyInfo[Key].Type;
+
+  return CONFIG_TYPE_BINARY;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_display(). */
+/* ============================================================================================================================================================= *\
+                  Display the configuration store: state of the flash sectors, statistics and value of each key (passwords are never displayed).
+\* ============================================================================================================================================================= */
+void wifi_config_display(void)
+{
+  UCHAR Text[(CONFIG_MAX_VALUE * 2) + 1];
+
+  UINT8 Loop1UInt8;
+  UINT8 Loop2UInt8;
+  UINT8 Value[CONFIG_MAX_VALUE];
+
+  INT16 Length;
+
+  UINT32 Number;
+
+  struct struct_config_stats Stats;
+
+
+  wifi_config_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "==============================================================================\r");
+  log_info(__LINE__, __func__, "                           Configuration store\r");
+  log_info(__LINE__, __func__, "==============================================================================\r");
+  if (Stats.ActiveSector == CONFIG_NO_SECTOR)
+    log_info(__LINE__, __func__, "Nothing saved yet (%u sectors of %u bytes reserved).\r", CONFIG_SECTORS, CONFIG_SECTOR_SIZE);
+  else
+    log_info(__LINE__, __func__, "Active sector: %u of %u   Generation: %lu   Used: %u / %u bytes\r", Stats.ActiveSector + 1, CONFIG_SECTORS, Stats.Sequence, Stats.BytesUsed, CONFIG_SECTOR_SIZE);
+  log_info(__LINE__, __func__, "Loaded in %lu usec   Writes: %lu   Unchanged (skipped): %lu   Sector erases: %lu   Errors: %lu\r",
+           Stats.LoadUsec, Stats.Writes, Stats.WritesSkipped, Stats.Erases, Stats.Errors);
+  log_info(__LINE__, __func__, "------------------------------------------------------------------------------\r");
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_MAX_KEYS; ++Loop1UInt8)
+  {
+    Length = wifi_config_get(Loop1UInt8, Value, sizeof(Value));
+    if (Length < 0)
+    {
+      if (Loop1UInt8 < CONFIG_KNOWN_KEYS) log_info(__LINE__, __func__, "%-10s (not set, compiled-in default)\r", wifi_config_key_name(Loop1UInt8));
+      continue;
+    }
+
+    switch (config_type(Loop1UInt8))
+    {
+      case (CONFIG_TYPE_STRING):
+        log_info(__LINE__, __func__, "%-10s <%.*s>\r", wifi_config_key_name(Loop1UInt8), Length, Value);
+      break;
+
+      case (CONFIG_TYPE_SECRET):
+        log_info(__LINE__, __func__, "%-10s (%d characters)\r", wifi_config_key_name(Loop1UInt8), Length);
+      break;
+
+      case (CONFIG_TYPE_NUMBER):
+        wifi_config_get_u32(Loop1UInt8, &Number);
+        log_info(__LINE__, __func__, "%-10s %lu\r", wifi_config_key_name(Loop1UInt8), Number);
+      break;
+
+      case (CONFIG_TYPE_COUNTRY):
+        wifi_config_get_u32(Loop1UInt8, &Number);
+        log_info(__LINE__, __func__, "%-10s %c%c\r", wifi_config_key_name(Loop1UInt8), (UCHAR)Number, (UCHAR)(Number >> 8));
+      break;
+
+      default:
+        for (Loop2UInt8 = 0; Loop2UInt8 < Length; ++Loop2UInt8)
+          sprintf(&Text[Loop2UInt8 * 2], "%2.2X", Value[Loop2UInt8]);
+        Text[Length * 2] = 0x00;
+        log_info(__LINE__, __func__, "key %-6u %s\r", Loop1UInt8, Text);
+      break;
+    }
+  }
+  log_info(__LINE__, __func__, "==============================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_erase(). */
+/* ============================================================================================================================================================= *\
+                                      Erase a key: its compiled-in default applies again. Return -1 in case of flash error.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_erase(UINT8 Key)
+{
+  return wifi_config_set(Key, NULL, 0);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_format(). */
+/* ============================================================================================================================================================= *\
+                                     Erase the whole configuration store (all sectors). All compiled-in defaults apply again.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_format(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_SECTORS; ++Loop1UInt8)
+    wifi_flash_erase(&ConfigFlash, Loop1UInt8 * CONFIG_SECTOR_SIZE);
+  Config.Stats.Erases += CONFIG_SECTORS;
+
+  Config.Active   = CONFIG_NO_SECTOR;
+  Config.Sequence = 0;
+  Config.Free     = CONFIG_SECTOR_SIZE;
+  memset(Config.Index, 0x00, sizeof(Config.Index));
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_get(). */
+/* ============================================================================================================================================================= *\
+                 Retrieve the value of a key in caller's buffer (truncated to Size). Return the length of the value, or -1 if the key is not set.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_get(UINT8 Key, void *Value, UINT8 Size)
+{
+  UINT8 Length;
+
+  const UINT8 *Record;
+
+
+  if ((Key >= CONFIG_MAX_KEYS) || (Config.Index[Key] == 0)) return -1;
+
+  Record = CONFIG_FLASH_DATA((Config.Active * CONFIG_SECTOR_SIZE) + Config.Index[Key]);
+  Length = Record[2];
+  memcpy(Value, &Record[3], (Length < Size) ? Length : Size);
+
+  return Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                             Retrieve configuration store statistics.
+\* ============================================================================================================================================================= */
+void wifi_config_get_stats(struct struct_config_stats *Stats)
+{
+  UINT8 Loop1UInt8;
+
+
+  *Stats = Config.Stats;
+  Stats->ActiveSector = Config.Active;
+  Stats->Sequence     = Config.Sequence;
+  Stats->BytesUsed    = (Config.Active == CONFIG_NO_SECTOR) ? 0 : Config.Free;
+  Stats->Keys         = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_MAX_KEYS; ++Loop1UInt8)
+    if (Config.Index[Loop1UInt8] != 0) ++Stats->Keys;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_get_string(). */
+/* ============================================================================================================================================================= *\
+              Retrieve a string value, with end-of-string, truncated to the size of caller's buffer. Return its length, or -1 if the key is not set.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_get_string(UINT8 Key, UCHAR *String, UINT8 Size)
+{
+  INT16 Length;
+
+
+  if (Size == 0) return -1;
+
+  Length = wifi_config_get(Key, String, Size - 1);
+  if (Length < 0) return -1;
+
+  if (Length > (Size - 1)) Length = Size - 1;
+  String[Length] = 0x00;
+
+  return Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_get_u32(). */
+/* ============================================================================================================================================================= *\
+                                          Retrieve a number. Return -1 if the key is not set or does not hold a number.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_get_u32(UINT8 Key, UINT32 *Value)
+{
+  UINT8 Data[4];
+
+
+  if (wifi_config_get(Key, Data, sizeof(Data)) != sizeof(Data)) return -1;
+
+  *Value = wifi_flash_get_u32(Data);
+
+  return 0;
+}
+
+
+
+
+
+#if PICO_ON_DEVICE == 0
+/* $PAGE */
+/* $TITLE=wifi_config_image(). */
+/* ============================================================================================================================================================= *\
+            Return the RAM image replacing flash on a host (CONFIG_SECTORS x CONFIG_SECTOR_SIZE bytes). A test may save it to a file and load it back,
+                            corrupt it or truncate a record to simulate a power loss, then call wifi_config_init() again to "reboot".
+\* ============================================================================================================================================================= */
+UINT8 *wifi_config_image(void)
+{
+  if (FlagImage == FLAG_OFF)
+  {
+    memset(ConfigImage, 0xFF, sizeof(ConfigImage));
+    FlagImage = FLAG_ON;
+  }
+
+  return ConfigImage;
+}
+#endif  // PICO_ON_DEVICE
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_init(). */
+/* ============================================================================================================================================================= *\
+               Load the configuration store: select the sector with a valid header and the highest generation, then build the index of its records.
+                            Nothing is written to flash. Must be called once at start-up, before any other wifi_config_xxx() function.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_init(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 Sequence;
+
+  UINT64 StartTime;
+
+
+  StartTime = wifi_flash_time_us();
+
+#if PICO_ON_DEVICE == 0
+  wifi_config_image();
+#endif  // PICO_ON_DEVICE
+
+  Config.Active   = CONFIG_NO_SECTOR;
+  Config.Sequence = 0;
+  Config.Free     = CONFIG_SECTOR_SIZE;
+  memset(Config.Index, 0x00, sizeof(Config.Index));
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_SECTORS; ++Loop1UInt8)
+  {
+    if (wifi_flash_header_valid(CONFIG_FLASH_DATA(Loop1UInt8 * CONFIG_SECTOR_SIZE), CONFIG_MAGIC, &Sequence) != 0) continue;
+
+    if ((Config.Active == CONFIG_NO_SECTOR) || (Sequence > Config.Sequence))
+    {
+      Config.Active   = Loop1UInt8;
+      Config.Sequence = Sequence;
+    }
+  }
+
+  if (Config.Active != CONFIG_NO_SECTOR) config_scan(Config.Active);
+
+  Config.Stats.LoadUsec = (UINT32)(wifi_flash_time_us() - StartTime);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_key(). */
+/* ============================================================================================================================================================= *\
+            Return the key matching a name ("ssid", "password", "country", "hostname", "power", "export") or a key number. Return -1 if there is none.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_key(const UCHAR *Name)
+{
+  UINT8 Loop1UInt8;
+
+  UCHAR *End;
+
+  UINT32 Key;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < CONFIG_KNOWN_KEYS; ++Loop1UInt8)
+    if (strcmp(Name, KeyInfo[Loop1UInt8].Name) == 0) return Loop1UInt8;
+
+  Key = strtoul(Name, (char **)&End, 10);
+  if ((End == Name) || (*End != 0x00) || (Key >= CONFIG_MAX_KEYS)) return -1;
+
+  return (INT16)Key;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_key_name(). */
+/* ============================================================================================================================================================= *\
+                                                                    Return the name of a key.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_config_key_name(UINT8 Key)
+{
+  if (Key < CONFIG_KNOWN_KEYS) return KeyInfo[Key].Name;
+
+  return "user";
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_set(). */
+/* ============================================================================================================================================================= *\
+         Save the value of a key (Length 0 erases it). Nothing is written if the value is unchanged. Return -1 if the key or the length is out of range,
+                                                   or in case of flash error (the previous value is then kept).
+\* ============================================================================================================================================================= */
+INT16 wifi_config_set(UINT8 Key, const void *Value, UINT8 Length)
+{
+  const UINT8 *Record;
+
+
+  if ((Key >= CONFIG_MAX_KEYS) || (Length > CONFIG_MAX_VALUE)) return -1;
+
+  /* Unchanged: spare the flash. */
+  if (Config.Index[Key] == 0)
+  {
+    if (Length == 0)
+    {
+      ++Config.Stats.WritesSkipped;
+      return 0;
+    }
+  }
+  else
+  {
+    Record = CONFIG_FLASH_DATA((Config.Active * CONFIG_SECTOR_SIZE) + Config.Index[Key]);
+    if ((Record[2] == Length) && (memcmp(&Record[3], Value, Length) == 0))
+    {
+      ++Config.Stats.WritesSkipped;
+      return 0;
+    }
+  }
+
+  return config_append(Key, Value, Length);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_set_string(). */
+/* ============================================================================================================================================================= *\
+                                                           Save a string value (without end-of-string).
+\* ============================================================================================================================================================= */
+INT16 wifi_config_set_string(UINT8 Key, const UCHAR *String)
+{
+  if (strlen(String) > CONFIG_MAX_VALUE) return -1;
+
+  return wifi_config_set(Key, String, strlen(String));
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_set_text(). */
+/* ============================================================================================================================================================= *\
+           Save a value given as text (terminal menu, network shell), converted according to the type of the key: numbers in decimal or 0x hexadecimal,
+                    country as two letters (CA, US, ...), binary values of the application as is. Return -1 if the text can not be converted.
+\* ============================================================================================================================================================= */
+INT16 wifi_config_set_text(UINT8 Key, const UCHAR *Text)
+{
+  UCHAR *End;
+
+  UINT32 Number;
+
+
+  switch (config_type(Key))
+  {
+    case (CONFIG_TYPE_NUMBER):
+      Number = strtoul(Text, (char **)&End, 0);
+      if ((End == Text) || (*End != 0x00)) return -1;
+    return wifi_config_set_u32(Key, Number);
+
+    case (CONFIG_TYPE_COUNTRY):
+      if ((strlen(Text) != 2) || !isalpha(Text[0]) || !isalpha(Text[1])) return -1;
+    return wifi_config_set_u32(Key, (UINT32)toupper(Text[0]) | ((UINT32)toupper(Text[1]) << 8));
+
+    default:
+    return wifi_config_set_string(Key, Text);
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_config_set_u32(). */
+/* ============================================================================================================================================================= *\
+                                                                  Save a number (little-endian).
+\* ============================================================================================================================================================= */
+INT16 wifi_config_set_u32(UINT8 Key, UINT32 Value)
+{
+  UINT8 Data[4];
+
+
+  Data[0] = (UINT8)Value;
+  Data[1] = (UINT8)(Value >> 8);
+  Data[2] = (UINT8)(Value >> 16);
+  Data[3] = (UINT8)(Value >> 24);
+
+  return wifi_config_set(Key, Data, sizeof(Data));
+}
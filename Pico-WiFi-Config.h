@@ -0,0 +1,108 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Config.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Config.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_CONFIG_H
+#define _WIFI_CONFIG_H
+
+#include "baseline.h"
+#include "Pico-WiFi-Flash.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define CONFIG_SECTORS                   4     // flash sectors reserved at the end of flash, used in turn (wear leveling).
+#define CONFIG_SECTOR_SIZE  WIFI_FLASH_SECTOR_SIZE
+#define CONFIG_PAGE_SIZE    WIFI_FLASH_PAGE_SIZE
+#define CONFIG_MAX_KEYS                 32
+#define CONFIG_MAX_VALUE                64     // longest value, in bytes.
+
+/* Keys. */
+#define CONFIG_KEY_SSID                  0     // network name (string).
+#define CONFIG_KEY_PASSWORD              1     // network password (string, never displayed).
+#define CONFIG_KEY_COUNTRY               2     // cyw43 country code (two letters, stored as a number).
+#define CONFIG_KEY_HOSTNAME              3     // host name (string, see wifi_set_host_name()).
+#define CONFIG_KEY_POWER_PROFILE         4     // radio power profile (number, see wifi_set_power_profile()).
+#define CONFIG_KEY_EXPORT_MODE           5     // export mode at start-up (number, see Pico-WiFi-Export.h).
+#define CONFIG_KEY_USER                 16     // first key free for the application (up to CONFIG_MAX_KEYS - 1).
+
+/* Value types (display and wifi_config_set_text()). */
+#define CONFIG_TYPE_BINARY               0
+#define CONFIG_TYPE_STRING               1
+#define CONFIG_TYPE_SECRET               2     // string, never displayed.
+#define CONFIG_TYPE_NUMBER               3     // UINT32, little-endian.
+#define CONFIG_TYPE_COUNTRY              4     // UINT32, two letters in the low bytes (CYW43_COUNTRY()).
+
+
+/* Configuration store statistics. */
+struct struct_config_stats
+{
+  UINT8  ActiveSector;                         // CONFIG_SECTORS: nothing has been saved yet.
+  UINT32 Sequence;                             // generation of the active sector, incremented at each compaction.
+  UINT16 BytesUsed;                            // in the active sector, header included.
+  UINT8  Keys;                                 // keys set.
+  UINT32 Writes;                               // records appended.
+  UINT32 WritesSkipped;                        // value unchanged, nothing written.
+  UINT32 Erases;                               // sectors erased (compactions).
+  UINT32 Errors;                               // flash verify failures and corrupted records found.
+  UINT32 LoadUsec;                             // duration of wifi_config_init().
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display the configuration store. */
+void wifi_config_display(void);
+
+/* Erase a key. */
+INT16 wifi_config_erase(UINT8 Key);
+
+/* Erase the whole configuration store. */
+INT16 wifi_config_format(void);
+
+/* Retrieve the value of a key. Return its length, or -1 if the key is not set. */
+INT16 wifi_config_get(UINT8 Key, void *Value, UINT8 Size);
+
+/* Retrieve configuration store statistics. */
+void wifi_config_get_stats(struct struct_config_stats *Stats);
+
+/* Retrieve a string value. Return its length, or -1 if the key is not set. */
+INT16 wifi_config_get_string(UINT8 Key, UCHAR *String, UINT8 Size);
+
+/* Retrieve a number. Return -1 if the key is not set. */
+INT16 wifi_config_get_u32(UINT8 Key, UINT32 *Value);
+
+#if PICO_ON_DEVICE == 0
+/* Return the RAM image replacing flash on a host. */
+UINT8 *wifi_config_image(void);
+#endif  // PICO_ON_DEVICE
+
+/* Load the configuration store from flash. */
+INT16 wifi_config_init(void);
+
+/* Return the key matching a name (or a number), or -1. */
+INT16 wifi_config_key(const UCHAR *Name);
+
+/* Return the name of a key. */
+const UCHAR *wifi_config_key_name(UINT8 Key);
+
+/* Save the value of a key. */
+INT16 wifi_config_set(UINT8 Key, const void *Value, UINT8 Length);
+
+/* Save a string value. */
+INT16 wifi_config_set_string(UINT8 Key, const UCHAR *String);
+
+/* Save a value given as text, converted according to the type of the key. */
+INT16 wifi_config_set_text(UINT8 Key, const UCHAR *Text);
+
+/* Save a number. */
+INT16 wifi_config_set_u32(UINT8 Key, UINT32 Value);
+
+#endif  // _WIFI_CONFIG_H
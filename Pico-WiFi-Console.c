@@ -0,0 +1,622 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Console.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Interrupt-driven console input for Pico-WiFi-Module and the user program.
+   The stdio "characters available" interrupt wakes a task of the cooperative scheduler (see Pico-WiFi-Sched.c), which drains the
+   characters received into a bounded line editor (<Backspace>, <Ctrl-U>, <ESC>, history recalled with <Up> / <Down>).
+   Echo is sent in one block per burst of characters. Complete lines are queued and the task selected with wifi_console_set_notify()
+   receives SCHED_EVENT_LINE. Nothing runs while no key is pressed.
+   Output: wifi_console_write() sends a complete line in one stdio transfer instead of one transfer per printf() fragment, and
+   lines written between wifi_console_batch_begin() and wifi_console_batch_end() are grouped into transfers of up to CONSOLE_OUT_SIZE
+   bytes. While no terminal is connected to USB, output is discarded at once instead of waiting for the USB time-out.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "pico/stdlib.h"
+#include "unistd.h"
+
+#if PICO_CYW43_ARCH_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif  // PICO_CYW43_ARCH_FREERTOS
+
+#include "Pico-WiFi-Console.h"
+#include "Pico-WiFi-Module.h"
+#include "Pico-WiFi-Sched.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UCHAR  Line[CONSOLE_LINE_SIZE];                      // line being edited.
+  UINT8  Length;
+  UINT8  EscState;                                     // 0: none, 1: <ESC> received, 2: inside an escape sequence.
+  UCHAR  Queue[CONSOLE_QUEUE_SIZE][CONSOLE_LINE_SIZE];  // complete lines, circular buffer.
+  UINT8  QueueHead;
+  UINT8  QueueTail;
+  UINT8  QueueCount;
+  UCHAR  History[CONSOLE_HISTORY_SIZE][CONSOLE_LINE_SIZE];
+  UINT8  HistoryCount;                                 // lines in history.
+  UINT8  HistoryNewest;                                // slot of the most recent line.
+  UINT8  HistoryRecall;                                // 0: new line being typed, n: n-th most recent line recalled.
+  UCHAR  Echo[CONSOLE_ECHO_SIZE];
+  UINT16 EchoLength;
+  UINT32 LinesLost;                                    // lines discarded because the queue was full.
+  struct struct_sched_task *Task;
+  struct struct_sched_task *Notify;
+} Console;
+
+static struct
+{
+  UCHAR  Buffer[CONSOLE_OUT_SIZE];                     // output held during a batch.
+  UINT16 Length;
+  UINT8  BatchDepth;                                   // nested wifi_console_batch_begin() calls.
+  UINT32 BatchOwner;                                   // thread (core or FreeRTOS task) running the batch.
+  struct struct_console_stats Stats;
+} ConsoleOut;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Add characters to the echo buffer. */
+static void console_echo(const UCHAR *Data, UINT16 Length);
+
+/* Erase the line being edited from the terminal. */
+static void console_erase(void);
+
+/* Send the echo buffer to the terminal. */
+static void console_flush(void);
+
+/* Replace the line being edited by a line of the history. */
+static void console_history_recall(INT16 Direction);
+
+/* Process one character received. */
+static void console_key(UCHAR Character);
+
+/* Queue the line being edited and notify the reader. */
+static void console_line_done(UINT8 FlagCancel);
+
+/* Identify the calling thread. */
+static UINT32 console_owner(void);
+
+/* Send data to stdio in a single transfer. */
+static void console_send(const UCHAR *Data, UINT16 Length);
+
+/* Console task: drain stdin into the line editor. */
+static void console_task(struct struct_sched_task *Task, UINT32 Events);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_echo(). */
+/* ============================================================================================================================================================= *\
+                      Add characters to the echo buffer. The buffer is sent when full, and at the end of each burst of characters received.
+\* ============================================================================================================================================================= */
+static void console_echo(const UCHAR *Data, UINT16 Length)
+{
+  UINT16 Loop1UInt16;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Length; ++Loop1UInt16)
+  {
+    if (Console.EchoLength >= CONSOLE_ECHO_SIZE) console_flush();
+    Console.Echo[Console.EchoLength++] = Data[Loop1UInt16];
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_erase(). */
+/* ============================================================================================================================================================= *\
+                                                          Erase the line being edited from the terminal.
+\* ============================================================================================================================================================= */
+static void console_erase(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Console.Length; ++Loop1UInt8)
+    console_echo("\b \b", 3);
+  Console.Length = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_flush(). */
+/* ============================================================================================================================================================= *\
+                                                     Send the echo buffer to the terminal in a single write.
+\* ============================================================================================================================================================= */
+static void console_flush(void)
+{
+  if (Console.EchoLength == 0) return;
+
+  wifi_console_write(Console.Echo, Console.EchoLength);
+  Console.EchoLength = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_history_recall(). */
+/* ============================================================================================================================================================= *\
+                    Replace the line being edited by the previous (Direction = 1, <Up>) or next (Direction = -1, <Down>) line of the history.
+                                                    Going down past the most recent line gives an empty line.
+\* ============================================================================================================================================================= */
+static void console_history_recall(INT16 Direction)
+{
+  UINT8 Slot;
+
+  INT16 Recall;
+
+
+  Recall = Console.HistoryRecall + Direction;
+  if ((Recall < 0) || (Recall > Console.HistoryCount)) return;
+
+  console_erase();
+  Console.HistoryRecall = (UINT8)Recall;
+  if (Recall == 0) return;
+
+  Slot = (Console.HistoryNewest + CONSOLE_HISTORY_SIZE - (Recall - 1)) % CONSOLE_HISTORY_SIZE;
+  strcpy(Console.Line, Console.History[Slot]);
+  Console.Length = strlen(Console.Line);
+  console_echo(Console.Line, Console.Length);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_key(). */
+/* ============================================================================================================================================================= *\
+                                     Process one character received. Escape sequences other than <Up> and <Down> are ignored.
+\* ============================================================================================================================================================= */
+static void console_key(UCHAR Character)
+{
+  if (Console.EscState == 1)
+  {
+    wifi_sched_timer(Console.Task, 0);
+    if ((Character == '[') || (Character == 'O'))
+    {
+      Console.EscState = 2;
+      return;
+    }
+
+    /* <ESC> alone: cancel the line, then process the character normally. */
+    Console.EscState = 0;
+    console_line_done(FLAG_ON);
+  }
+  else if (Console.EscState == 2)
+  {
+    /* Parameters of the sequence until its final byte. */
+    if ((Character < 0x40) || (Character > 0x7E)) return;
+
+    Console.EscState = 0;
+    if (Character == 'A') console_history_recall(1);
+    if (Character == 'B') console_history_recall(-1);
+    return;
+  }
+
+  switch (Character)
+  {
+    case (0x08):
+    case (0x7F):
+      /* <Backspace> */
+      if (Console.Length > 0)
+      {
+        --Console.Length;
+        console_echo("\b \b", 3);  // erase character under the cursor.
+      }
+    break;
+
+    case (0x0A):
+      /* <Line feed> following <Enter> on some terminals. */
+    break;
+
+    case (0x0D):
+      /* <Enter> */
+      console_line_done(FLAG_OFF);
+    break;
+
+    case (0x15):
+      /* <Ctrl-U> */
+      console_erase();
+    break;
+
+    case (0x1B):
+      /* <ESC>: wait to see if an escape sequence follows. */
+      Console.EscState = 1;
+      wifi_sched_timer(Console.Task, CONSOLE_ESC_MSEC);
+    break;
+
+    default:
+      if (Character < 0x20) break;  // other control characters.
+      if (Console.Length >= (CONSOLE_LINE_SIZE - 1))
+      {
+        console_echo("\a", 1);  // line full.
+        break;
+      }
+      Console.Line[Console.Length++] = Character;
+      console_echo(&Character, 1);
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_line_done(). */
+/* ============================================================================================================================================================= *\
+                Queue the line being edited and notify the reader with SCHED_EVENT_LINE. As with the former polled input, an empty line is queued
+                                   as "\r" and a line cancelled with <ESC> as "\x1B". Non-empty lines are added to the history.
+\* ============================================================================================================================================================= */
+static void console_line_done(UINT8 FlagCancel)
+{
+  UCHAR *Slot;
+
+
+  console_echo("\r", 1);
+  console_flush();
+
+  Console.Line[Console.Length] = 0x00;  // end-of-string
+  if ((FlagCancel == FLAG_OFF) && (Console.Length > 0))
+  {
+    /* Add to history, unless it repeats the most recent line. */
+    if ((Console.HistoryCount == 0) || (strcmp(Console.History[Console.HistoryNewest], Console.Line) != 0))
+    {
+      if (Console.HistoryCount > 0) Console.HistoryNewest = (Console.HistoryNewest + 1) % CONSOLE_HISTORY_SIZE;
+      strcpy(Console.History[Console.HistoryNewest], Console.Line);
+      if (Console.HistoryCount < CONSOLE_HISTORY_SIZE) ++Console.HistoryCount;
+    }
+  }
+
+  if (Console.QueueCount >= CONSOLE_QUEUE_SIZE)
+  {
+    ++Console.LinesLost;
+  }
+  else
+  {
+    Slot = Console.Queue[Console.QueueHead];
+    if (FlagCancel == FLAG_ON)
+      strcpy(Slot, "\x1B");
+    else if (Console.Length == 0)
+      strcpy(Slot, "\r");
+    else
+      strcpy(Slot, Console.Line);
+    Console.QueueHead = (Console.QueueHead + 1) % CONSOLE_QUEUE_SIZE;
+    ++Console.QueueCount;
+  }
+
+  Console.Length        = 0;
+  Console.HistoryRecall = 0;
+  wifi_sched_post(Console.Notify, SCHED_EVENT_LINE);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_owner(). */
+/* ============================================================================================================================================================= *\
+                                                Identify the calling thread: its core, or its task with FreeRTOS.
+\* ============================================================================================================================================================= */
+static UINT32 console_owner(void)
+{
+#if PICO_CYW43_ARCH_FREERTOS
+  return (UINT32)xTaskGetCurrentTaskHandle();
+#else   // PICO_CYW43_ARCH_FREERTOS
+  return get_core_num() + 1;
+#endif  // PICO_CYW43_ARCH_FREERTOS
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_send(). */
+/* ============================================================================================================================================================= *\
+                         Send data to stdio in a single transfer. It waits while the USB buffer is full (backpressure from the terminal),
+                    but data is discarded at once while no terminal is connected, rather than after the stdio USB time-out for each transfer.
+\* ============================================================================================================================================================= */
+static void console_send(const UCHAR *Data, UINT16 Length)
+{
+  if (Length == 0) return;
+
+  if (!stdio_usb_connected())
+  {
+    ConsoleOut.Stats.BytesDropped += Length;
+    return;
+  }
+
+  write(STDOUT_FILENO, Data, Length);
+  ++ConsoleOut.Stats.Transfers;
+  ConsoleOut.Stats.BytesSent += Length;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=console_task(). */
+/* ============================================================================================================================================================= *\
+                     Console task: woken by the stdio interrupt (SCHED_EVENT_INPUT), it drains all characters received into the line editor,
+                                then echoes them in one block. Its timer tells a lone <ESC> from the start of an escape sequence.
+\* ============================================================================================================================================================= */
+static void console_task(struct struct_sched_task *Task, UINT32 Events)
+{
+  INT16 DataInput;
+
+
+  if ((Events & SCHED_EVENT_TIMER) && (Console.EscState == 1))
+  {
+    /* Nothing followed <ESC>: cancel the line. */
+    Console.EscState = 0;
+    console_line_done(FLAG_ON);
+  }
+
+  while ((DataInput = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+  {
+    if (DataInput == 0) continue;
+    console_key((UCHAR)DataInput);
+  }
+  console_flush();
+
+  wifi_sched_wait(Task, SCHED_EVENT_INPUT | SCHED_EVENT_TIMER, 0);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_batch_begin(). */
+/* ============================================================================================================================================================= *\
+                     Hold console output of the calling thread until wifi_console_batch_end(), so that many lines go out in a few transfers.
+            Calls may be nested. Output of other threads, and of interrupt handlers, is still sent at once. Must not be called from interrupt context.
+\* ============================================================================================================================================================= */
+void wifi_console_batch_begin(void)
+{
+  if (ConsoleOut.BatchDepth == 0)
+    ConsoleOut.BatchOwner = console_owner();
+  else if (ConsoleOut.BatchOwner != console_owner())
+    return;  // another thread runs a batch: this one is not batched.
+
+  ++ConsoleOut.BatchDepth;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_batch_end(). */
+/* ============================================================================================================================================================= *\
+                            End of a batch started with wifi_console_batch_begin(): output held is sent when the outermost batch ends.
+\* ============================================================================================================================================================= */
+void wifi_console_batch_end(void)
+{
+  if ((ConsoleOut.BatchDepth == 0) || (ConsoleOut.BatchOwner != console_owner())) return;
+
+  if (--ConsoleOut.BatchDepth == 0) wifi_console_flush();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_flush(). */
+/* ============================================================================================================================================================= *\
+                                  Send console output held in the batch buffer. Only the thread running the batch may flush it.
+\* ============================================================================================================================================================= */
+void wifi_console_flush(void)
+{
+  if ((ConsoleOut.Length == 0) || (ConsoleOut.BatchOwner != console_owner())) return;
+
+  console_send(ConsoleOut.Buffer, ConsoleOut.Length);
+  ConsoleOut.Length = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_get_line(). */
+/* ============================================================================================================================================================= *\
+                         Retrieve the oldest complete line, truncated to fit the caller's buffer of Size bytes (end-of-string included).
+                              Return the length of the string, or -1 if no line is waiting. Must be called from the scheduler core.
+\* ============================================================================================================================================================= */
+INT16 wifi_console_get_line(UCHAR *String, UINT16 Size)
+{
+  UINT16 Length;
+
+
+  if ((Console.QueueCount == 0) || (Size == 0)) return -1;
+
+  Length = strlen(Console.Queue[Console.QueueTail]);
+  if (Length > (Size - 1)) Length = Size - 1;
+  memcpy(String, Console.Queue[Console.QueueTail], Length);
+  String[Length] = 0x00;  // end-of-string
+
+  Console.QueueTail = (Console.QueueTail + 1) % CONSOLE_QUEUE_SIZE;
+  --Console.QueueCount;
+
+  return Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                               Retrieve console output statistics.
+\* ============================================================================================================================================================= */
+void wifi_console_get_stats(struct struct_console_stats *Stats)
+{
+  *Stats = ConsoleOut.Stats;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_read_line(). */
+/* ============================================================================================================================================================= *\
+                 Wait for a complete line and retrieve it (see wifi_console_get_line()). While waiting, the Wi-Fi stack and the other tasks keep
+                                        running, and the core sleeps until the next interrupt when there is nothing to do.
+\* ============================================================================================================================================================= */
+INT16 wifi_console_read_line(UCHAR *String, UINT16 Size)
+{
+  INT16 Length;
+
+
+  while ((Length = wifi_console_get_line(String, Size)) < 0)
+  {
+    wifi_poll();
+    if (wifi_sched_yield() == 0) wifi_sched_idle(at_the_end_of_time);
+  }
+
+  return Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_set_notify(). */
+/* ============================================================================================================================================================= *\
+                             Select the task receiving SCHED_EVENT_LINE when a line is complete (NULL: none, lines are only queued).
+\* ============================================================================================================================================================= */
+void wifi_console_set_notify(struct struct_sched_task *Task)
+{
+  Console.Notify = Task;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_start(). */
+/* ============================================================================================================================================================= *\
+                   Start the console task and route the stdio interrupt to it. Must be called after wifi_sched_init(), from the scheduler core.
+                                                           Return -1 if the task could not be created.
+\* ============================================================================================================================================================= */
+INT16 wifi_console_start(struct struct_sched_task *Notify)
+{
+  Console.Notify = Notify;
+  if (Console.Task != NULL) return 0;
+
+  Console.Task = wifi_sched_create("console", console_task, NULL);
+  if (Console.Task == NULL) return -1;
+
+  wifi_sched_stdin(Console.Task);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_console_write(). */
+/* ============================================================================================================================================================= *\
+                             Write data to the console. Callers pass a complete line (or more), which goes out in a single transfer.
+                   During a batch of the calling thread, data is held in the batch buffer, which is sent when the next line does not fit in it.
+\* ============================================================================================================================================================= */
+void wifi_console_write(const UCHAR *Data, UINT16 Length)
+{
+  ++ConsoleOut.Stats.Writes;
+
+  if ((ConsoleOut.BatchDepth == 0) || (__get_current_exception() != 0) || (ConsoleOut.BatchOwner != console_owner()))
+  {
+    console_send(Data, Length);
+    return;
+  }
+
+  if ((ConsoleOut.Length + Length) > CONSOLE_OUT_SIZE) wifi_console_flush();
+
+  if (Length > CONSOLE_OUT_SIZE)
+  {
+    console_send(Data, Length);
+    return;
+  }
+
+  memcpy(&ConsoleOut.Buffer[ConsoleOut.Length], Data, Length);
+  ConsoleOut.Length += Length;
+
+  return;
+}
@@ -0,0 +1,68 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Console.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Console.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_CONSOLE_H
+#define _WIFI_CONSOLE_H
+
+#include "baseline.h"
+#include "Pico-WiFi-Sched.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define CONSOLE_LINE_SIZE              129     // longest line that can be typed, plus end-of-string.
+#define CONSOLE_QUEUE_SIZE               4     // complete lines waiting to be read.
+#define CONSOLE_HISTORY_SIZE             8     // lines that may be recalled with <Up> / <Down>.
+#define CONSOLE_ECHO_SIZE              128     // echo is sent in one block per burst of characters received.
+#define CONSOLE_ESC_MSEC                30     // <ESC> not followed by an escape sequence within this delay cancels the line.
+#define CONSOLE_OUT_SIZE              2048     // output batch buffer (see wifi_console_batch_begin()).
+
+
+/* Console output statistics. */
+struct struct_console_stats
+{
+  UINT32 Writes;                               // calls to wifi_console_write().
+  UINT32 Transfers;                            // blocks sent to stdio.
+  UINT32 BytesSent;
+  UINT32 BytesDropped;                         // output discarded while no terminal is connected to USB.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Hold console output of the calling thread until wifi_console_batch_end(). */
+void wifi_console_batch_begin(void);
+
+/* Send console output held since wifi_console_batch_begin(). */
+void wifi_console_batch_end(void);
+
+/* Send console output held in the batch buffer. */
+void wifi_console_flush(void);
+
+/* Retrieve the oldest complete line, truncated to the size of the caller's buffer. Return its length, or -1 if no line is waiting. */
+INT16 wifi_console_get_line(UCHAR *String, UINT16 Size);
+
+/* Retrieve console output statistics. */
+void wifi_console_get_stats(struct struct_console_stats *Stats);
+
+/* Wait for a complete line, while the Wi-Fi stack and the other tasks keep running. */
+INT16 wifi_console_read_line(UCHAR *String, UINT16 Size);
+
+/* Select the task receiving SCHED_EVENT_LINE when a line is complete. */
+void wifi_console_set_notify(struct struct_sched_task *Task);
+
+/* Start the console task. Must be called after wifi_sched_init(). */
+INT16 wifi_console_start(struct struct_sched_task *Notify);
+
+/* Write a complete line (or more) to the console in a single transfer. */
+void wifi_console_write(const UCHAR *Data, UINT16 Length);
+
+#endif  // _WIFI_CONSOLE_H
@@ -0,0 +1,479 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Core1.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Optional dual-core split for Pico-WiFi-Module (WIFI_CORE1 CMake option).
+   With pico_cyw43_arch_lwip_threadsafe_background, cyw43 and lwIP work runs in interrupt handlers on the core that called
+   cyw43_arch_init(). wifi_core1_start() calls it from core 1, so that the Wi-Fi stack, the connect supervisor (health monitor)
+   and the network applications run on core 1, and core 0 is left to the application's time-critical code.
+   The cores talk through two lock-free single-producer / single-consumer queues of fixed-size messages:
+   - core 0 -> core 1: function calls and MQTT publications (producer: core 0 application code, not interrupt handlers).
+   - core 1 -> core 0: start-up result, Wi-Fi health events, call results and MQTT messages received.
+   On core 1, messages are pushed with the cyw43 lwIP lock held, so that the core 1 loop and the lwIP callbacks are never producers at the same time.
+   wifi_core1_jitter() measures the lateness of a periodic control loop, to compare a firmware built with and without the split.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Jitter benchmark services the Wi-Fi stack with wifi_poll() (poll architecture).
+                    - Core 1 accepts to be held while core 0 writes the configuration store to flash (flash_safe_execute()).
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stddef.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "hardware/sync.h"
+#include "pico/flash.h"
+#if WIFI_CORE1
+#include "pico/multicore.h"
+#endif  // WIFI_CORE1
+
+#include "Pico-WiFi-Core1.h"
+#include "Pico-WiFi-MQTT.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  struct struct_spsc Command;                          // core 0 -> core 1.
+  struct struct_spsc Event;                            // core 1 -> core 0.
+  struct struct_wifi *StructWiFi;                      // owned by core 1 once started.
+  UINT8 FlagStarted;
+} Core1;
+
+#if WIFI_CORE1
+static UINT32 Core1Stack[CORE1_STACK_SIZE / sizeof(UINT32)];
+#endif  // WIFI_CORE1
+
+/* Upper limit (usec) of each bin of the control-loop lateness histogram. */
+static const UINT32 JitterBinLimit[CORE1_JITTER_BINS] = {1, 2, 5, 10, 20, 50, 100, 0xFFFFFFFF};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Core 1 entry point: network start-up, then command loop. */
+static void core1_entry(void);
+
+/* Execute a command received from core 0. */
+static void core1_execute(struct struct_core1_msg *Message);
+
+/* Forward Wi-Fi health events to core 0. */
+static void core1_health_callback(UINT8 Event, struct struct_wifi *StructWiFi, void *Context);
+
+/* Remove the oldest message from a queue (consumer side). */
+static INT16 core1_pop(struct struct_spsc *Queue, struct struct_core1_msg *Message);
+
+/* Add a message to a queue (producer side). */
+static INT16 core1_push(struct struct_spsc *Queue, const struct struct_core1_msg *Message);
+
+/* Push a message to core 0 from core 1. */
+static void core1_send_event(UINT8 Type, INT16 Value, UINT32 Tag);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_entry(). */
+/* ============================================================================================================================================================= *\
+                                                           Core 1 entry point: network start-up, then command loop.
+               cyw43 is initialized from here, so cyw43 and lwIP interrupt work is serviced by core 1. Between commands, core 1 sleeps in __wfe():
+                              it is woken by its own interrupts (cyw43, lwIP timers) and by the __sev() of core 0 after each message.
+\* ============================================================================================================================================================= */
+static void core1_entry(void)
+{
+  INT16 ReturnCode;
+
+  struct struct_core1_msg Message;
+
+
+  /* Core 0 may hold this core while it writes to flash (see Pico-WiFi-Config.c). */
+  flash_safe_execute_core_init();
+
+  ReturnCode = wifi_init(Core1.StructWiFi);
+  if (ReturnCode == 0)
+  {
+    cyw43_arch_enable_sta_mode();
+    ReturnCode = wifi_connect(Core1.StructWiFi);
+  }
+  if (ReturnCode == 0)
+  {
+    wifi_health_subscribe(core1_health_callback, NULL);
+    wifi_health_start(Core1.StructWiFi);
+  }
+  core1_send_event(CORE1_EVENT_READY, ReturnCode, 0);
+
+  while (1)
+  {
+    while (core1_pop(&Core1.Command, &Message) == 0) core1_execute(&Message);
+    __wfe();
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_execute(). */
+/* ============================================================================================================================================================= *\
+                                                                Execute a command received from core 0 (core 1).
+\* ============================================================================================================================================================= */
+static void core1_execute(struct struct_core1_msg *Message)
+{
+  UINT16 TopicLength;
+
+  INT16 ReturnCode;
+
+
+  switch (Message->Type)
+  {
+    case (CORE1_CMD_CALL):
+      ReturnCode = Message->Function(Message->Arg);
+    break;
+
+    case (CORE1_CMD_PUBLISH):
+      TopicLength = strlen(Message->Data);
+      ReturnCode  = wifi_mqtt_publish(Message->Data, &Message->Data[TopicLength + 1], Message->Length - TopicLength - 1, (UINT8)Message->Value, FLAG_OFF);
+    break;
+
+    default:
+      ReturnCode = -1;
+    break;
+  }
+  core1_send_event(CORE1_EVENT_RESULT, ReturnCode, Message->Tag);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_health_callback(). */
+/* ============================================================================================================================================================= *\
+                                                            Forward Wi-Fi health events to core 0 (lwIP context, core 1).
+\* ============================================================================================================================================================= */
+static void core1_health_callback(UINT8 Event, struct struct_wifi *StructWiFi, void *Context)
+{
+  struct struct_core1_msg Message;
+
+
+  memset(&Message, 0x00, sizeof(Message));
+  Message.Type  = CORE1_EVENT_HEALTH;
+  Message.Value = Event;
+  core1_push(&Core1.Event, &Message);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_pop(). */
+/* ============================================================================================================================================================= *\
+                                        Remove the oldest message from a queue (consumer side). Return -1 if the queue is empty.
+\* ============================================================================================================================================================= */
+static INT16 core1_pop(struct struct_spsc *Queue, struct struct_core1_msg *Message)
+{
+  UINT16 Tail;
+
+
+  Tail = Queue->Tail;
+  if (Tail == Queue->Head) return -1;
+
+  __dmb();  // read the message only after having seen the new head.
+  *Message = Queue->Slot[Tail & (CORE1_QUEUE_SIZE - 1)];
+  __dmb();  // slot is free for the producer only after it has been read.
+  Queue->Tail = Tail + 1;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_push(). */
+/* ============================================================================================================================================================= *\
+                                               Add a message to a queue (producer side). Return -1 if the queue is full.
+\* ============================================================================================================================================================= */
+static INT16 core1_push(struct struct_spsc *Queue, const struct struct_core1_msg *Message)
+{
+  UINT16 Count;
+  UINT16 Head;
+
+
+  Head  = Queue->Head;
+  Count = (UINT16)(Head - Queue->Tail);
+  if (Count >= CORE1_QUEUE_SIZE)
+  {
+    ++Queue->Full;
+    return -1;
+  }
+
+  Queue->Slot[Head & (CORE1_QUEUE_SIZE - 1)] = *Message;
+  __dmb();  // message must be visible to the other core before the new head.
+  Queue->Head = Head + 1;
+  if (Count + 1 > Queue->HighWater) Queue->HighWater = Count + 1;
+  __sev();  // wake the other core if it waits in __wfe().
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=core1_send_event(). */
+/* ============================================================================================================================================================= *\
+                                          Push a message to core 0 from the core 1 loop, with the lwIP lock held (see file header).
+\* ============================================================================================================================================================= */
+static void core1_send_event(UINT8 Type, INT16 Value, UINT32 Tag)
+{
+  struct struct_core1_msg Message;
+
+
+  memset(&Message, 0x00, sizeof(Message));
+  Message.Type  = Type;
+  Message.Value = Value;
+  Message.Tag   = Tag;
+
+  cyw43_arch_lwip_begin();
+  core1_push(&Core1.Event, &Message);
+  cyw43_arch_lwip_end();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_call(). */
+/* ============================================================================================================================================================= *\
+                    Queue a call of Function(Arg) on core 1 (core 0 application code only). Function runs outside lwIP context, like user code,
+                     so it may use any API of the module. Its return code comes back as CORE1_EVENT_RESULT with Tag. Return -1 if queue is full.
+\* ============================================================================================================================================================= */
+INT16 wifi_core1_call(core1_function Function, void *Arg, UINT32 Tag)
+{
+  struct struct_core1_msg Message;
+
+
+  if (Core1.FlagStarted == FLAG_OFF) return -1;
+
+  memset(&Message, 0x00, offsetof(struct struct_core1_msg, Data));
+  Message.Type     = CORE1_CMD_CALL;
+  Message.Tag      = Tag;
+  Message.Function = Function;
+  Message.Arg      = Arg;
+
+  return core1_push(&Core1.Command, &Message);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_display_jitter(). */
+/* ============================================================================================================================================================= *\
+                                                                   Display control-loop jitter results.
+\* ============================================================================================================================================================= */
+void wifi_core1_display_jitter(struct struct_core1_jitter *Jitter)
+{
+  UINT8 Loop1UInt8;
+
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "     Control-loop lateness (%s)\r", WIFI_CORE1 ? "network on core 1" : "network interrupts on core 0");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Cycles:                   %lu\r", Jitter->Cycles);
+  log_info(__LINE__, __func__, "Lateness (usec):          min %lu   average %lu   max %lu\r", Jitter->LateMin, Jitter->LateAverage, Jitter->LateMax);
+  for (Loop1UInt8 = 0; Loop1UInt8 < CORE1_JITTER_BINS; ++Loop1UInt8)
+  {
+    if (JitterBinLimit[Loop1UInt8] == 0xFFFFFFFF)
+      log_info(__LINE__, __func__, "   > %4lu usec:           %lu\r", JitterBinLimit[Loop1UInt8 - 1], Jitter->Histogram[Loop1UInt8]);
+    else
+      log_info(__LINE__, __func__, "  <= %4lu usec:           %lu\r", JitterBinLimit[Loop1UInt8], Jitter->Histogram[Loop1UInt8]);
+  }
+  log_info(__LINE__, __func__, "Queues core 0 -> 1:       peak %u / %u   full %lu\r", Core1.Command.HighWater, CORE1_QUEUE_SIZE, Core1.Command.Full);
+  log_info(__LINE__, __func__, "Queues core 1 -> 0:       peak %u / %u   full %lu\r", Core1.Event.HighWater, CORE1_QUEUE_SIZE, Core1.Event.Full);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_get_event(). */
+/* ============================================================================================================================================================= *\
+                                        Retrieve the next message sent by core 1 (core 0 only). Return -1 if there is none.
+\* ============================================================================================================================================================= */
+INT16 wifi_core1_get_event(struct struct_core1_msg *Message)
+{
+  return core1_pop(&Core1.Event, Message);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_jitter(). */
+/* ============================================================================================================================================================= *\
+                   Measure lateness of a periodic control loop on the calling core: the loop busy-waits for each deadline, PeriodUsec apart,
+                           and records how late it noticed it. Interrupt handlers running on the same core show up as late cycles.
+                                              Run it under network load, in firmware built with and without WIFI_CORE1.
+\* ============================================================================================================================================================= */
+void wifi_core1_jitter(UINT32 PeriodUsec, UINT32 Cycles, struct struct_core1_jitter *Jitter)
+{
+  UINT8 Loop2UInt8;
+
+  UINT32 Late;
+  UINT32 Loop1UInt32;
+
+  UINT64 Deadline;
+  UINT64 LateTotal;
+
+
+  memset(Jitter, 0x00, sizeof(*Jitter));
+  Jitter->LateMin = 0xFFFFFFFF;
+  LateTotal       = 0;
+
+  Deadline = time_us_64() + PeriodUsec;
+  for (Loop1UInt32 = 0; Loop1UInt32 < Cycles; ++Loop1UInt32)
+  {
+    while (time_us_64() < Deadline) wifi_poll();  // control loop of the application services the stack (poll architecture).
+    Late = (UINT32)(time_us_64() - Deadline);
+
+    LateTotal += Late;
+    if (Late < Jitter->LateMin) Jitter->LateMin = Late;
+    if (Late > Jitter->LateMax) Jitter->LateMax = Late;
+    for (Loop2UInt8 = 0; Late > JitterBinLimit[Loop2UInt8]; ++Loop2UInt8);
+    ++Jitter->Histogram[Loop2UInt8];
+
+    /* Next deadline keeps the period fixed, even after a late cycle. */
+    Deadline += PeriodUsec;
+  }
+
+  Jitter->Cycles = Cycles;
+  if (Cycles) Jitter->LateAverage = (UINT32)(LateTotal / Cycles);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_mqtt_callback(). */
+/* ============================================================================================================================================================= *\
+                          MQTT message callback forwarding received messages to core 0 (lwIP context, core 1). Give it to wifi_mqtt_start()
+                              when the client is started on core 1. Messages that do not fit in CORE1_MSG_DATA bytes are truncated.
+\* ============================================================================================================================================================= */
+void wifi_core1_mqtt_callback(const UCHAR *Topic, UINT16 TopicLength, const UCHAR *Payload, UINT16 PayloadLength, void *Context)
+{
+  struct struct_core1_msg Message;
+
+
+  if (TopicLength > (CORE1_MSG_DATA - 1)) TopicLength = CORE1_MSG_DATA - 1;
+  if (PayloadLength > (CORE1_MSG_DATA - 1 - TopicLength)) PayloadLength = CORE1_MSG_DATA - 1 - TopicLength;
+
+  memset(&Message, 0x00, offsetof(struct struct_core1_msg, Data));
+  Message.Type   = CORE1_EVENT_MQTT_MESSAGE;
+  Message.Length = TopicLength + 1 + PayloadLength;
+  memcpy(Message.Data, Topic, TopicLength);
+  Message.Data[TopicLength] = 0x00;
+  memcpy(&Message.Data[TopicLength + 1], Payload, PayloadLength);
+  core1_push(&Core1.Event, &Message);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_publish(). */
+/* ============================================================================================================================================================= *\
+                          Queue an MQTT publication to core 1 (core 0 application code only). Topic and payload are copied into the message,
+                                           so they must fit together in CORE1_MSG_DATA - 1 bytes. Return -1 if queue is full.
+\* ============================================================================================================================================================= */
+INT16 wifi_core1_publish(const UCHAR *Topic, const void *Payload, UINT16 Length, UINT8 QoS, UINT32 Tag)
+{
+  UINT16 TopicLength;
+
+  struct struct_core1_msg Message;
+
+
+  TopicLength = strlen(Topic);
+  if ((Core1.FlagStarted == FLAG_OFF) || ((TopicLength + 1 + Length) > CORE1_MSG_DATA)) return -1;
+
+  memset(&Message, 0x00, offsetof(struct struct_core1_msg, Data));
+  Message.Type   = CORE1_CMD_PUBLISH;
+  Message.Length = TopicLength + 1 + Length;
+  Message.Value  = QoS;
+  Message.Tag    = Tag;
+  memcpy(Message.Data, Topic, TopicLength + 1);
+  memcpy(&Message.Data[TopicLength + 1], Payload, Length);
+
+  return core1_push(&Core1.Command, &Message);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_core1_start(). */
+/* ============================================================================================================================================================= *\
+                    Start the Wi-Fi stack and connect supervisor on core 1: cyw43 initialization, connection and health monitor.
+                   StructWiFi belongs to core 1 from then on. Completion is reported by CORE1_EVENT_READY (see wifi_core1_get_event()).
+                                                  Return -1 if the firmware has been built without WIFI_CORE1.
+\* ============================================================================================================================================================= */
+INT16 wifi_core1_start(struct struct_wifi *StructWiFi)
+{
+#if WIFI_CORE1
+  if (Core1.FlagStarted == FLAG_ON) return -1;
+
+  Core1.StructWiFi  = StructWiFi;
+  Core1.FlagStarted = FLAG_ON;
+  multicore_launch_core1_with_stack(core1_entry, Core1Stack, sizeof(Core1Stack));
+
+  return 0;
+#else   // WIFI_CORE1
+  return -1;
+#endif  // WIFI_CORE1
+}
@@ -0,0 +1,102 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Core1.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Core1.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_CORE1_H
+#define _WIFI_CORE1_H
+
+#include "Pico-WiFi-Module.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#ifndef WIFI_CORE1
+#define WIFI_CORE1                       0     // 1 = Wi-Fi stack and network applications run on core 1 (set by CMakeLists.txt).
+#endif  // WIFI_CORE1
+
+#define CORE1_QUEUE_SIZE                16     // messages in each direction (must be a power of 2).
+#define CORE1_MSG_DATA                  96     // payload bytes carried by a message.
+#define CORE1_STACK_SIZE              8192     // core 1 stack: cyw43 and lwIP interrupt handlers run on it.
+#define CORE1_JITTER_BINS                8     // bins of the control-loop lateness histogram.
+
+/* Messages from core 0 to core 1. */
+#define CORE1_CMD_CALL                   1     // run Function(Arg) on core 1; result comes back as CORE1_EVENT_RESULT.
+#define CORE1_CMD_PUBLISH                2     // MQTT publish: Data = topic, 0x00, payload; Value = QoS.
+
+/* Messages from core 1 to core 0. */
+#define CORE1_EVENT_READY                1     // network start-up completed; Value = wifi_connect() return code.
+#define CORE1_EVENT_HEALTH               2     // Wi-Fi health event; Value = WIFI_EVENT_xxx.
+#define CORE1_EVENT_RESULT               3     // CORE1_CMD_CALL / CORE1_CMD_PUBLISH completed; Value = return code, Tag = Tag of the command.
+#define CORE1_EVENT_MQTT_MESSAGE         4     // MQTT message received: Data = topic, 0x00, payload; Length = total bytes used in Data.
+
+
+/* Function run on core 1 by CORE1_CMD_CALL. */
+typedef INT16 (*core1_function)(void *Arg);
+
+
+/* Message exchanged between cores. */
+struct struct_core1_msg
+{
+  UINT8  Type;
+  UINT8  Length;                               // bytes used in Data.
+  INT16  Value;
+  UINT32 Tag;                                  // free for the application, returned with CORE1_EVENT_RESULT.
+  core1_function Function;
+  void  *Arg;
+  UCHAR  Data[CORE1_MSG_DATA];
+};
+
+
+/* Lock-free single-producer / single-consumer queue. Head is only written by the producer core, Tail only by the consumer core. */
+struct struct_spsc
+{
+  volatile UINT16 Head;
+  volatile UINT16 Tail;
+  UINT16 HighWater;                            // highest number of messages waiting (written by producer).
+  UINT32 Full;                                 // messages refused because the queue was full (written by producer).
+  struct struct_core1_msg Slot[CORE1_QUEUE_SIZE];
+};
+
+
+/* Control-loop lateness, as measured by wifi_core1_jitter(). Times are in usec. */
+struct struct_core1_jitter
+{
+  UINT32 Cycles;
+  UINT32 LateMin;
+  UINT32 LateMax;
+  UINT32 LateAverage;
+  UINT32 Histogram[CORE1_JITTER_BINS];         // see JitterBinLimit[] in Pico-WiFi-Core1.c.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Queue a function call to core 1. */
+INT16 wifi_core1_call(core1_function Function, void *Arg, UINT32 Tag);
+
+/* Display control-loop jitter results. */
+void wifi_core1_display_jitter(struct struct_core1_jitter *Jitter);
+
+/* Retrieve the next message sent by core 1. */
+INT16 wifi_core1_get_event(struct struct_core1_msg *Message);
+
+/* Measure lateness of a periodic control loop on the calling core. */
+void wifi_core1_jitter(UINT32 PeriodUsec, UINT32 Cycles, struct struct_core1_jitter *Jitter);
+
+/* MQTT message callback forwarding received messages to core 0. */
+void wifi_core1_mqtt_callback(const UCHAR *Topic, UINT16 TopicLength, const UCHAR *Payload, UINT16 PayloadLength, void *Context);
+
+/* Queue an MQTT publication to core 1. */
+INT16 wifi_core1_publish(const UCHAR *Topic, const void *Payload, UINT16 Length, UINT8 QoS, UINT32 Tag);
+
+/* Start the Wi-Fi stack and connect supervisor on core 1. */
+INT16 wifi_core1_start(struct struct_wifi *StructWiFi);
+
+#endif  // _WIFI_CORE1_H
@@ -0,0 +1,840 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-DNS.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Caching DNS resolver built on the lwIP raw API, part of Pico-WiFi-Module.
+   lwIP's dns_gethostbyname() does not report the TTL of its answers, so the module sends its own IPv4 (A) queries
+   to the DNS servers configured in lwIP (by DHCP or dns_setserver()) and keeps the answers in a small cache:
+   - Entries are kept for the TTL given by the server (bounded by DNS_MIN_TTL_SEC and DNS_MAX_TTL_SEC).
+   - Entries used since their last refresh are refreshed in background when DNS_PREFETCH_PERCENT of their TTL remains,
+     so that names looked up regularly (MQTT broker, NTP servers) are always answered from cache.
+   - Names that do not exist (NXDOMAIN or no IPv4 address) are remembered for DNS_NEGATIVE_TTL_SEC.
+   - The cache may be pre-seeded from a const table in flash, so that known names resolve before the network is up.
+     Seeded entries are refreshed from the network as soon as they are used.
+   Several callers looking up the same name share a single query. A query that gets no answer is sent again to the next DNS server.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Answers are only accepted from the server the query was sent to; waiters are detached before being notified.
+                    - Truncated or malformed answers no longer replace a cached address with a negative entry.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "ctype.h"
+#include "stdio.h"
+#include "string.h"
+#include "strings.h"
+
+#include "lwip/dns.h"
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-DNS.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define DNS_HEADER_SIZE     12
+#define DNS_PACKET_MAX     512              // largest DNS message over UDP.
+#define DNS_NO_ENTRY      0xFF
+
+
+static struct
+{
+  struct
+  {
+    UCHAR  Name[DNS_CACHE_NAME_LENGTH + 1];
+    ip_addr_t Address;
+    ip_addr_t Server;                       // DNS server the last query was sent to (answers from elsewhere are ignored).
+    UINT8  State;
+    UINT8  FlagQuery;                       // query in progress (first lookup or background refresh).
+    UINT8  FlagUsed;                        // looked up since last refresh.
+    UINT8  FlagSeeded;                      // address comes from the seed table, not from the network.
+    UINT8  Retries;                         // queries sent for current lookup.
+    UINT16 QueryId;
+    UINT32 TtlSec;
+    UINT64 Expiry;
+    UINT64 LastUsed;
+    UINT64 QueryStart;                      // first query of current lookup.
+    UINT64 QuerySent;                       // last query of current lookup.
+  } Entry[DNS_CACHE_SIZE];
+  struct
+  {
+    UINT8 Entry;
+    wifi_dns_callback Callback;             // NULL = free slot.
+    void *Arg;
+  } Waiter[DNS_MAX_WAITERS];
+  UINT8 FlagTimer;
+  UCHAR Packet[DNS_PACKET_MAX];             // answer being parsed (lwIP context only).
+  struct udp_pcb *UdpPcb;
+  struct struct_dns_stats Stats;
+} Dns;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Find a name in cache. */
+static UINT8 dns_cache_find(const UCHAR *Name);
+
+/* Allocate a cache entry for a new name. */
+static UINT8 dns_cache_new(const UCHAR *Name);
+
+/* Notify the callers waiting for a cache entry. */
+static void dns_complete(UINT8 Index, const ip_addr_t *Address);
+
+/* Encode a host name as DNS labels. */
+static UINT16 dns_encode_name(const UCHAR *Name, UCHAR *Buffer);
+
+/* Answer received from a DNS server. */
+static void dns_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port);
+
+/* Send a query for a cache entry. */
+static void dns_send_query(UINT8 Index);
+
+/* Skip an encoded name in a DNS message. */
+static UINT16 dns_skip_name(const UCHAR *Packet, UINT16 Length, UINT16 Offset);
+
+/* Expiry, time-out and prefetch timer. */
+static void dns_timer(void *Arg);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_cache_find(). */
+/* ============================================================================================================================================================= *\
+                                                           Find a name in cache. Return DNS_NO_ENTRY if not found.
+\* ============================================================================================================================================================= */
+static UINT8 dns_cache_find(const UCHAR *Name)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+    if ((Dns.Entry[Loop1UInt8].State != DNS_ENTRY_FREE) && (strcasecmp(Dns.Entry[Loop1UInt8].Name, Name) == 0)) return Loop1UInt8;
+
+  return DNS_NO_ENTRY;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_cache_new(). */
+/* ============================================================================================================================================================= *\
+                    Allocate a cache entry for a new name. When the cache is full, the least recently used entry without a query in progress is evicted.
+                                                 Return DNS_NO_ENTRY if all entries have a query in progress.
+\* ============================================================================================================================================================= */
+static UINT8 dns_cache_new(const UCHAR *Name)
+{
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+
+
+  Index = DNS_NO_ENTRY;
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+  {
+    if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_FREE)
+    {
+      Index = Loop1UInt8;
+      break;
+    }
+
+    if (Dns.Entry[Loop1UInt8].FlagQuery == FLAG_ON) continue;
+    if ((Index == DNS_NO_ENTRY) || (Dns.Entry[Loop1UInt8].LastUsed < Dns.Entry[Index].LastUsed)) Index = Loop1UInt8;
+  }
+  if (Index == DNS_NO_ENTRY) return DNS_NO_ENTRY;
+
+  if (Dns.Entry[Index].State != DNS_ENTRY_FREE) ++Dns.Stats.Evicted;
+
+  memset(&Dns.Entry[Index], 0x00, sizeof(Dns.Entry[Index]));
+  strcpy(Dns.Entry[Index].Name, Name);
+  Dns.Entry[Index].LastUsed = WIFI_TIME_US();
+
+  return Index;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_complete(). */
+/* ============================================================================================================================================================= *\
+                                               Notify the callers waiting for a cache entry (Address is NULL if the lookup failed).
+                                    The entry must already be in its final state (freed if the lookup failed) when this function is called.
+\* ============================================================================================================================================================= */
+static void dns_complete(UINT8 Index, const ip_addr_t *Address)
+{
+  UCHAR Name[DNS_CACHE_NAME_LENGTH + 1];
+
+  UINT8 Count;
+  UINT8 Loop1UInt8;
+
+  ip_addr_t Result;
+
+  struct
+  {
+    wifi_dns_callback Callback;
+    void *Arg;
+  } Notify[DNS_MAX_WAITERS];
+
+
+  /* Detach all waiters of the entry before notifying any of them: a callback may start another lookup, which may reuse
+     this entry (and its name) and the waiter slots just freed. Those new waiters must not be notified here. */
+  strcpy(Name, Dns.Entry[Index].Name);
+  if (Address != NULL) ip_addr_copy(Result, *Address);
+  Count = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_MAX_WAITERS; ++Loop1UInt8)
+  {
+    if ((Dns.Waiter[Loop1UInt8].Callback == NULL) || (Dns.Waiter[Loop1UInt8].Entry != Index)) continue;
+
+    Notify[Count].Callback = Dns.Waiter[Loop1UInt8].Callback;
+    Notify[Count].Arg      = Dns.Waiter[Loop1UInt8].Arg;
+    Dns.Waiter[Loop1UInt8].Callback = NULL;
+    ++Count;
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Count; ++Loop1UInt8)
+    Notify[Loop1UInt8].Callback(Name, (Address != NULL) ? &Result : NULL, Notify[Loop1UInt8].Arg);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_encode_name(). */
+/* ============================================================================================================================================================= *\
+                                 Encode a host name as DNS labels ("www.example.com" -> 3www7example3com0). Return encoded length, 0 if invalid.
+\* ============================================================================================================================================================= */
+static UINT16 dns_encode_name(const UCHAR *Name, UCHAR *Buffer)
+{
+  UINT8 LabelLength;
+
+  UINT16 Length;
+  UINT16 LabelStart;
+
+
+  LabelStart  = 0;
+  LabelLength = 0;
+  Length      = 1;
+  for (; *Name != 0x00; ++Name)
+  {
+    if (*Name == '.')
+    {
+      if (LabelLength == 0) return 0;
+      Buffer[LabelStart] = LabelLength;
+      LabelStart  = Length++;
+      LabelLength = 0;
+      continue;
+    }
+
+    if (++LabelLength > 63) return 0;
+    Buffer[Length++] = *Name;
+  }
+  if (LabelLength == 0) return 0;
+  Buffer[LabelStart] = LabelLength;
+  Buffer[Length++]   = 0x00;
+
+  return Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_receive(). */
+/* ============================================================================================================================================================= *\
+                                                                   Answer received from a DNS server.
+\* ============================================================================================================================================================= */
+static void dns_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port)
+{
+  UCHAR *Packet;
+  UCHAR Question[DNS_CACHE_NAME_LENGTH + 2];
+
+  UINT8 FlagFound;
+  UINT8 FlagMalformed;
+  UINT8 Index;
+  UINT8 ResponseCode;
+
+  UINT16 AnswerCount;
+  UINT16 Class;
+  UINT16 DataLength;
+  UINT16 Id;
+  UINT16 Length;
+  UINT16 Loop1UInt16;
+  UINT16 Offset;
+  UINT16 QuestionLength;
+  UINT16 Type;
+
+  UINT32 Latency;
+  UINT32 RecordTtl;
+  UINT32 Ttl;
+
+  UINT64 TimeNow;
+
+
+  TimeNow = WIFI_TIME_US();
+  Packet  = Dns.Packet;
+  Length  = pbuf_copy_partial(PBuf, Packet, DNS_PACKET_MAX, 0);
+  pbuf_free(PBuf);
+
+  if ((Port != DNS_SERVER_PORT) || (Length < DNS_HEADER_SIZE) || ((Packet[2] & 0x80) == 0)) return;
+
+  /* Find the lookup this answer belongs to: same ID, from the server the query was sent to. */
+  Id = ((UINT16)Packet[0] << 8) | Packet[1];
+  for (Index = 0; Index < DNS_CACHE_SIZE; ++Index)
+    if ((Dns.Entry[Index].FlagQuery == FLAG_ON) && (Dns.Entry[Index].QueryId == Id) && ip_addr_cmp(Address, &Dns.Entry[Index].Server)) break;
+  if (Index == DNS_CACHE_SIZE) return;
+
+  /* The question must be echoed back unchanged (case aside). */
+  QuestionLength = dns_encode_name(Dns.Entry[Index].Name, Question);
+  if ((QuestionLength == 0) || (Length < DNS_HEADER_SIZE + QuestionLength + 4)) return;
+  for (Loop1UInt16 = 0; Loop1UInt16 < QuestionLength; ++Loop1UInt16)
+    if (tolower(Packet[DNS_HEADER_SIZE + Loop1UInt16]) != tolower(Question[Loop1UInt16])) return;
+
+  ResponseCode = Packet[3] & 0x0F;
+  if ((ResponseCode != 0) && (ResponseCode != 3))
+  {
+    /* Server failure or refusal: next DNS server is tried on next tick. */
+    Dns.Entry[Index].QuerySent = 0;
+
+    return;
+  }
+
+  /* Walk answer records. The TTL retained is the lowest of the chain (CNAME and A records). */
+  AnswerCount = ((UINT16)Packet[6] << 8) | Packet[7];
+  Offset      = DNS_HEADER_SIZE + QuestionLength + 4;
+  FlagFound     = FLAG_OFF;
+  FlagMalformed = FLAG_OFF;
+  Ttl           = DNS_MAX_TTL_SEC;
+  for (Loop1UInt16 = 0; (ResponseCode == 0) && (Loop1UInt16 < AnswerCount); ++Loop1UInt16)
+  {
+    Offset = dns_skip_name(Packet, Length, Offset);
+    if ((Offset == 0) || (Offset + 10 > Length))
+    {
+      FlagMalformed = FLAG_ON;
+      break;
+    }
+
+    Type       = ((UINT16)Packet[Offset] << 8) | Packet[Offset + 1];
+    Class      = ((UINT16)Packet[Offset + 2] << 8) | Packet[Offset + 3];
+    RecordTtl  = ((UINT32)Packet[Offset + 4] << 24) | ((UINT32)Packet[Offset + 5] << 16) | ((UINT32)Packet[Offset + 6] << 8) | Packet[Offset + 7];
+    DataLength = ((UINT16)Packet[Offset + 8] << 8) | Packet[Offset + 9];
+    Offset += 10;
+    if (Offset + DataLength > Length)
+    {
+      FlagMalformed = FLAG_ON;
+      break;
+    }
+
+    if ((Class == 1) && ((Type == 1) || (Type == 5)))
+    {
+      if (RecordTtl < Ttl) Ttl = RecordTtl;
+      if ((Type == 1) && (DataLength == 4) && (FlagFound == FLAG_OFF))
+      {
+        IP_ADDR4(&Dns.Entry[Index].Address, Packet[Offset], Packet[Offset + 1], Packet[Offset + 2], Packet[Offset + 3]);
+        FlagFound = FLAG_ON;
+      }
+    }
+    Offset += DataLength;
+  }
+
+  /* Truncated (TC) or malformed answer without address: it tells nothing about the name. A cached address being refreshed is kept;
+     a first lookup tries the next server on next tick. Only NXDOMAIN and complete answers without address are cached as negative. */
+  if ((FlagFound == FLAG_OFF) && (ResponseCode == 0) && ((Packet[2] & 0x02) || (FlagMalformed == FLAG_ON)))
+  {
+    ++Dns.Stats.BadAnswers;
+    if (Dns.Entry[Index].State == DNS_ENTRY_PENDING)
+    {
+      Dns.Entry[Index].QuerySent = 0;
+    }
+    else
+    {
+      Dns.Entry[Index].FlagQuery = FLAG_OFF;
+      Dns.Entry[Index].FlagUsed  = FLAG_OFF;
+    }
+
+    return;
+  }
+
+  Dns.Entry[Index].FlagQuery = FLAG_OFF;
+  Dns.Entry[Index].FlagUsed  = FLAG_OFF;
+
+  if (FlagFound == FLAG_ON)
+  {
+    if (Ttl < DNS_MIN_TTL_SEC) Ttl = DNS_MIN_TTL_SEC;
+    Dns.Entry[Index].State      = DNS_ENTRY_VALID;
+    Dns.Entry[Index].FlagSeeded = FLAG_OFF;
+    Dns.Entry[Index].TtlSec     = Ttl;
+    Dns.Entry[Index].Expiry     = TimeNow + (Ttl * 1000000ull);
+
+    Latency = (UINT32)(TimeNow - Dns.Entry[Index].QueryStart);
+    Dns.Stats.LatencyTotalUs += Latency;
+    if (Latency > Dns.Stats.LatencyMaxUs) Dns.Stats.LatencyMaxUs = Latency;
+    ++Dns.Stats.Resolved;
+
+    dns_complete(Index, &Dns.Entry[Index].Address);
+  }
+  else
+  {
+    /* NXDOMAIN, or complete answer without IPv4 address (NODATA). */
+    Dns.Entry[Index].State  = DNS_ENTRY_NEGATIVE;
+    Dns.Entry[Index].TtlSec = DNS_NEGATIVE_TTL_SEC;
+    Dns.Entry[Index].Expiry = TimeNow + (DNS_NEGATIVE_TTL_SEC * 1000000ull);
+    ++Dns.Stats.NxDomain;
+
+    dns_complete(Index, NULL);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_send_query(). */
+/* ============================================================================================================================================================= *\
+                                           Send a query for a cache entry, to the next DNS server each time the query is repeated.
+\* ============================================================================================================================================================= */
+static void dns_send_query(UINT8 Index)
+{
+  UCHAR *Packet;
+
+  UINT8 Loop1UInt8;
+
+  UINT16 NameLength;
+
+  const ip_addr_t *Server;
+
+  struct pbuf *PBuf;
+
+
+  Dns.Entry[Index].FlagQuery = FLAG_ON;
+  Dns.Entry[Index].QuerySent = WIFI_TIME_US();
+  ++Dns.Entry[Index].Retries;
+
+  if (Dns.UdpPcb == NULL)
+  {
+    Dns.UdpPcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+    if (Dns.UdpPcb == NULL) return;
+    udp_recv(Dns.UdpPcb, dns_receive, NULL);
+  }
+
+  /* Next configured server (skip empty slots). */
+  Server = NULL;
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_MAX_SERVERS; ++Loop1UInt8)
+  {
+    Server = dns_getserver((Dns.Entry[Index].Retries + Loop1UInt8 - 1) % DNS_MAX_SERVERS);
+    if ((Server != NULL) && !ip_addr_isany(Server)) break;
+    Server = NULL;
+  }
+  if (Server == NULL) return;
+  ip_addr_copy(Dns.Entry[Index].Server, *Server);
+
+  PBuf = pbuf_alloc(PBUF_TRANSPORT, DNS_HEADER_SIZE + DNS_CACHE_NAME_LENGTH + 2 + 4, PBUF_RAM);
+  if (PBuf == NULL) return;
+
+  /* Header: new random ID, recursion desired, one question. */
+  Dns.Entry[Index].QueryId = (UINT16)LWIP_RAND();
+  Packet = (UCHAR *)PBuf->payload;
+  memset(Packet, 0x00, DNS_HEADER_SIZE);
+  Packet[0] = (UCHAR)(Dns.Entry[Index].QueryId >> 8);
+  Packet[1] = (UCHAR)Dns.Entry[Index].QueryId;
+  Packet[2] = 0x01;
+  Packet[5] = 0x01;
+
+  /* Question: name, type A, class IN. */
+  NameLength = dns_encode_name(Dns.Entry[Index].Name, &Packet[DNS_HEADER_SIZE]);
+  Packet[DNS_HEADER_SIZE + NameLength]     = 0x00;
+  Packet[DNS_HEADER_SIZE + NameLength + 1] = 0x01;
+  Packet[DNS_HEADER_SIZE + NameLength + 2] = 0x00;
+  Packet[DNS_HEADER_SIZE + NameLength + 3] = 0x01;
+  pbuf_realloc(PBuf, DNS_HEADER_SIZE + NameLength + 4);
+
+  if (udp_sendto(Dns.UdpPcb, PBuf, Server, DNS_SERVER_PORT) == ERR_OK) ++Dns.Stats.QueriesSent;
+  pbuf_free(PBuf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_skip_name(). */
+/* ============================================================================================================================================================= *\
+                                   Skip an encoded name (labels, possibly ending with a compression pointer). Return offset after name, 0 if invalid.
+\* ============================================================================================================================================================= */
+static UINT16 dns_skip_name(const UCHAR *Packet, UINT16 Length, UINT16 Offset)
+{
+  while (Offset < Length)
+  {
+    if (Packet[Offset] == 0x00) return Offset + 1;
+    if ((Packet[Offset] & 0xC0) == 0xC0) return ((Offset + 2) <= Length) ? (Offset + 2) : 0;
+    Offset += Packet[Offset] + 1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dns_timer(). */
+/* ============================================================================================================================================================= *\
+                                                  Expiry, time-out and prefetch timer (lwIP context, every DNS_TICK_MSEC).
+\* ============================================================================================================================================================= */
+static void dns_timer(void *Arg)
+{
+  UINT8 FlagLinkUp;
+  UINT8 Loop1UInt8;
+
+  UINT64 Remaining;
+  UINT64 TimeNow;
+
+
+  TimeNow    = WIFI_TIME_US();
+  FlagLinkUp = ((netif_default != NULL) && netif_is_link_up(netif_default)) ? FLAG_ON : FLAG_OFF;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+  {
+    if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_FREE) continue;
+
+    /* Query without answer: send again to next server, or give up. */
+    if ((Dns.Entry[Loop1UInt8].FlagQuery == FLAG_ON) && ((TimeNow - Dns.Entry[Loop1UInt8].QuerySent) >= (DNS_QUERY_TIMEOUT_MSEC * 1000ull)))
+    {
+      if (Dns.Entry[Loop1UInt8].Retries < DNS_QUERY_RETRIES)
+      {
+        dns_send_query(Loop1UInt8);
+      }
+      else
+      {
+        ++Dns.Stats.Timeouts;
+        Dns.Entry[Loop1UInt8].FlagQuery = FLAG_OFF;
+        if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_PENDING)
+        {
+          /* Free the entry before notifying: a waiter resolving the name again from its callback starts a new lookup. */
+          Dns.Entry[Loop1UInt8].State = DNS_ENTRY_FREE;
+          dns_complete(Loop1UInt8, NULL);
+          continue;
+        }
+      }
+    }
+    if (Dns.Entry[Loop1UInt8].FlagQuery == FLAG_ON) continue;
+
+    /* End of TTL. */
+    if ((Dns.Entry[Loop1UInt8].State != DNS_ENTRY_PENDING) && (TimeNow >= Dns.Entry[Loop1UInt8].Expiry))
+    {
+      ++Dns.Stats.Expired;
+      Dns.Entry[Loop1UInt8].State = DNS_ENTRY_FREE;
+      continue;
+    }
+
+    /* Refresh entries in use before they expire (seeded entries as soon as they are used). */
+    if ((Dns.Entry[Loop1UInt8].State == DNS_ENTRY_VALID) && (Dns.Entry[Loop1UInt8].FlagUsed == FLAG_ON) && (FlagLinkUp == FLAG_ON))
+    {
+      Remaining = Dns.Entry[Loop1UInt8].Expiry - TimeNow;
+      if ((Dns.Entry[Loop1UInt8].FlagSeeded == FLAG_ON) || (Remaining <= (Dns.Entry[Loop1UInt8].TtlSec * 10000ull * DNS_PREFETCH_PERCENT)))
+      {
+        ++Dns.Stats.Prefetches;
+        Dns.Entry[Loop1UInt8].Retries    = 0;
+        Dns.Entry[Loop1UInt8].QueryStart = TimeNow;
+        dns_send_query(Loop1UInt8);
+      }
+    }
+  }
+
+  sys_timeout(DNS_TICK_MSEC, dns_timer, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_dns_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                              Display resolver statistics and cache content.
+\* ============================================================================================================================================================= */
+void wifi_dns_display_stats(void)
+{
+  static const UCHAR *StateName[] = {"free", "pending", "valid", "negative"};
+
+  UCHAR Address[16];
+
+  UINT8 Loop1UInt8;
+
+  UINT64 Remaining;
+  UINT64 TimeNow;
+
+  struct struct_dns_stats Stats;
+
+
+  wifi_dns_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                     DNS resolver statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Lookups:                  %lu   hits: %lu   negative hits: %lu   misses: %lu\r", Stats.Lookups, Stats.Hits, Stats.NegativeHits, Stats.Misses);
+  if (Stats.Lookups)
+    log_info(__LINE__, __func__, "Hit rate:                 %lu %%\r", ((Stats.Hits + Stats.NegativeHits) * 100) / Stats.Lookups);
+  log_info(__LINE__, __func__, "Queries sent:             %lu   prefetches: %lu   timeouts: %lu\r", Stats.QueriesSent, Stats.Prefetches, Stats.Timeouts);
+  log_info(__LINE__, __func__, "Answers:                  %lu resolved   %lu non-existent   %lu ignored (truncated or malformed)\r", Stats.Resolved, Stats.NxDomain,
+           Stats.BadAnswers);
+  if (Stats.Resolved)
+    log_info(__LINE__, __func__, "Query latency:            average %llu usec   max %lu usec\r", Stats.LatencyTotalUs / Stats.Resolved, Stats.LatencyMaxUs);
+  log_info(__LINE__, __func__, "Entries expired:          %lu   evicted: %lu\r", Stats.Expired, Stats.Evicted);
+  log_info(__LINE__, __func__, "----------------------------------------------------------------------\r");
+
+  WIFI_LWIP_BEGIN();
+  TimeNow = WIFI_TIME_US();
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+  {
+    if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_FREE) continue;
+
+    Remaining = (Dns.Entry[Loop1UInt8].Expiry > TimeNow) ? ((Dns.Entry[Loop1UInt8].Expiry - TimeNow) / 1000000ull) : 0;
+    if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_VALID)
+      ipaddr_ntoa_r(&Dns.Entry[Loop1UInt8].Address, Address, sizeof(Address));
+    else
+      strcpy(Address, "-");
+    log_info(__LINE__, __func__, "%-32s %-8s %-15s %6llu sec%s\r", Dns.Entry[Loop1UInt8].Name, StateName[Dns.Entry[Loop1UInt8].State], Address, Remaining,
+             Dns.Entry[Loop1UInt8].FlagSeeded ? " (seed)" : "");
+  }
+  WIFI_LWIP_END();
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_dns_flush(). */
+/* ============================================================================================================================================================= *\
+                                               Remove all entries from cache. Callers waiting for a lookup are told it failed.
+\* ============================================================================================================================================================= */
+void wifi_dns_flush(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 PendingMask;
+
+
+  WIFI_LWIP_BEGIN();
+  /* Free every entry first, keeping first lookups in progress out of reach of eviction until their waiters have been told. */
+  PendingMask = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+  {
+    if (Dns.Entry[Loop1UInt8].State == DNS_ENTRY_PENDING)
+    {
+      PendingMask |= (1ul << Loop1UInt8);
+      continue;
+    }
+    Dns.Entry[Loop1UInt8].State     = DNS_ENTRY_FREE;
+    Dns.Entry[Loop1UInt8].FlagQuery = FLAG_OFF;
+  }
+
+  /* Then fail them one at a time (callbacks may start new lookups, which only take free entries). */
+  for (Loop1UInt8 = 0; Loop1UInt8 < DNS_CACHE_SIZE; ++Loop1UInt8)
+  {
+    if ((PendingMask & (1ul << Loop1UInt8)) == 0) continue;
+
+    Dns.Entry[Loop1UInt8].State     = DNS_ENTRY_FREE;
+    Dns.Entry[Loop1UInt8].FlagQuery = FLAG_OFF;
+    dns_complete(Loop1UInt8, NULL);
+  }
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_dns_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                     Retrieve resolver statistics.
+\* ============================================================================================================================================================= */
+void wifi_dns_get_stats(struct struct_dns_stats *Stats)
+{
+  WIFI_LWIP_BEGIN();
+  *Stats = Dns.Stats;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_dns_resolve(). */
+/* ============================================================================================================================================================= *\
+                           Resolve a host name (or dotted IPv4 address) through the cache. Same usage as lwIP's dns_gethostbyname():
+                           Return  0: Address is filled in.
+                           Return  1: lookup in progress, Callback (if not NULL) will be called with the result.
+                           Return -1: name does not exist (remembered from a recent answer), invalid name or no resource available.
+\* ============================================================================================================================================================= */
+INT16 wifi_dns_resolve(const UCHAR *Name, ip_addr_t *Address, wifi_dns_callback Callback, void *Arg)
+{
+  UCHAR Labels[DNS_CACHE_NAME_LENGTH + 2];
+
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+
+  INT16 ReturnCode;
+
+
+  if (ipaddr_aton(Name, Address)) return 0;
+  if ((strlen(Name) > DNS_CACHE_NAME_LENGTH) || (dns_encode_name(Name, Labels) == 0)) return -1;
+
+  WIFI_LWIP_BEGIN();
+  if (Dns.FlagTimer == FLAG_OFF)
+  {
+    Dns.FlagTimer = FLAG_ON;
+    sys_timeout(DNS_TICK_MSEC, dns_timer, NULL);
+  }
+  ++Dns.Stats.Lookups;
+
+  Index = dns_cache_find(Name);
+  if ((Index != DNS_NO_ENTRY) && (Dns.Entry[Index].State == DNS_ENTRY_VALID))
+  {
+    *Address = Dns.Entry[Index].Address;
+    Dns.Entry[Index].FlagUsed = FLAG_ON;
+    Dns.Entry[Index].LastUsed = WIFI_TIME_US();
+    ++Dns.Stats.Hits;
+    WIFI_LWIP_END();
+
+    return 0;
+  }
+
+  if ((Index != DNS_NO_ENTRY) && (Dns.Entry[Index].State == DNS_ENTRY_NEGATIVE))
+  {
+    ++Dns.Stats.NegativeHits;
+    WIFI_LWIP_END();
+
+    return -1;
+  }
+
+  /* Not in cache, or first lookup already in progress. */
+  ++Dns.Stats.Misses;
+  if (Index == DNS_NO_ENTRY)
+  {
+    Index = dns_cache_new(Name);
+    if (Index == DNS_NO_ENTRY)
+    {
+      WIFI_LWIP_END();
+
+      return -1;
+    }
+    Dns.Entry[Index].State      = DNS_ENTRY_PENDING;
+    Dns.Entry[Index].QueryStart = WIFI_TIME_US();
+    dns_send_query(Index);
+  }
+
+  ReturnCode = 1;
+  if (Callback != NULL)
+  {
+    for (Loop1UInt8 = 0; Loop1UInt8 < DNS_MAX_WAITERS; ++Loop1UInt8)
+      if (Dns.Waiter[Loop1UInt8].Callback == NULL) break;
+
+    if (Loop1UInt8 < DNS_MAX_WAITERS)
+    {
+      Dns.Waiter[Loop1UInt8].Entry    = Index;
+      Dns.Waiter[Loop1UInt8].Callback = Callback;
+      Dns.Waiter[Loop1UInt8].Arg      = Arg;
+    }
+    else
+    {
+      ReturnCode = -1;
+    }
+  }
+  WIFI_LWIP_END();
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_dns_seed(). */
+/* ============================================================================================================================================================= *\
+                            Pre-seed the cache with a table of host names and addresses (typically a const table in flash, at boot).
+                        Seeded names resolve at once, even before the network is up, and are refreshed from the network when first used.
+                                                                Return the number of entries seeded.
+\* ============================================================================================================================================================= */
+UINT8 wifi_dns_seed(const struct struct_dns_seed *Seeds, UINT8 Count)
+{
+  UCHAR Labels[DNS_CACHE_NAME_LENGTH + 2];
+
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+  UINT8 Seeded;
+
+  ip_addr_t Address;
+
+
+  Seeded = 0;
+
+  WIFI_LWIP_BEGIN();
+  for (Loop1UInt8 = 0; Loop1UInt8 < Count; ++Loop1UInt8)
+  {
+    if ((strlen(Seeds[Loop1UInt8].Name) > DNS_CACHE_NAME_LENGTH) || (dns_encode_name(Seeds[Loop1UInt8].Name, Labels) == 0)) continue;
+    if (!ipaddr_aton(Seeds[Loop1UInt8].Address, &Address)) continue;
+
+    Index = dns_cache_find(Seeds[Loop1UInt8].Name);
+    if (Index == DNS_NO_ENTRY) Index = dns_cache_new(Seeds[Loop1UInt8].Name);
+    if ((Index == DNS_NO_ENTRY) || (Dns.Entry[Index].State == DNS_ENTRY_PENDING)) continue;
+
+    Dns.Entry[Index].State      = DNS_ENTRY_VALID;
+    Dns.Entry[Index].Address    = Address;
+    Dns.Entry[Index].FlagSeeded = FLAG_ON;
+    Dns.Entry[Index].FlagUsed   = FLAG_OFF;
+    Dns.Entry[Index].TtlSec     = Seeds[Loop1UInt8].TtlSec;
+    Dns.Entry[Index].Expiry     = WIFI_TIME_US() + (Seeds[Loop1UInt8].TtlSec * 1000000ull);
+    ++Seeded;
+  }
+  WIFI_LWIP_END();
+
+  return Seeded;
+}
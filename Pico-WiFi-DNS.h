@@ -0,0 +1,89 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-DNS.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-DNS.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_DNS_H
+#define _WIFI_DNS_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define DNS_CACHE_SIZE                   8     // host names kept in cache (32 at most).
+#define DNS_CACHE_NAME_LENGTH           63     // longest host name kept in cache.
+#define DNS_MAX_WAITERS                  8     // callbacks waiting for lookups in progress.
+#define DNS_QUERY_TIMEOUT_MSEC        2000     // query is sent again (to next DNS server) after this delay.
+#define DNS_QUERY_RETRIES                3     // queries sent before a lookup fails.
+#define DNS_MIN_TTL_SEC                 10     // shorter TTLs are raised to this value.
+#define DNS_MAX_TTL_SEC              86400     // longer TTLs are lowered to this value.
+#define DNS_NEGATIVE_TTL_SEC            30     // non-existent names (NXDOMAIN) are remembered for this delay.
+#define DNS_PREFETCH_PERCENT            10     // entries used since last refresh are refreshed when this part of their TTL remains.
+#define DNS_TICK_MSEC                 1000     // period of the expiry / prefetch timer.
+
+/* Cache entry states. */
+#define DNS_ENTRY_FREE                   0
+#define DNS_ENTRY_PENDING                1     // first lookup in progress.
+#define DNS_ENTRY_VALID                  2     // address known (may also be refreshing in background).
+#define DNS_ENTRY_NEGATIVE               3     // name does not exist.
+
+
+/* Host name and address to pre-seed in cache at boot. A const table of seeds stays in flash. */
+struct struct_dns_seed
+{
+  const UCHAR *Name;
+  const UCHAR *Address;                        // dotted IPv4 address.
+  UINT32 TtlSec;                               // validity before the entry must be refreshed from the network.
+};
+
+
+/* Resolver statistics. */
+struct struct_dns_stats
+{
+  UINT32 Lookups;                              // calls to wifi_dns_resolve().
+  UINT32 Hits;                                 // answered from cache.
+  UINT32 NegativeHits;                         // answered "does not exist" from cache.
+  UINT32 Misses;                               // required a query to a DNS server.
+  UINT32 Prefetches;                           // background refreshes of entries in use.
+  UINT32 Expired;                              // entries dropped at end of TTL.
+  UINT32 Evicted;                              // entries dropped to make room for new names.
+  UINT32 QueriesSent;
+  UINT32 Timeouts;                             // lookups without any answer after DNS_QUERY_RETRIES queries.
+  UINT32 NxDomain;                             // answers "does not exist" (or no IPv4 address).
+  UINT32 BadAnswers;                           // truncated or malformed answers without address, ignored.
+  UINT32 Resolved;                             // answers with an address (lookups and refreshes).
+  UINT64 LatencyTotalUs;                       // sum of query-to-answer delays of resolved names.
+  UINT32 LatencyMaxUs;
+};
+
+
+/* Callback for lookups in progress, compatible with lwIP's dns_found_callback. Address is NULL if the name could not be resolved.
+   Called from lwIP context, must not block. */
+typedef void (*wifi_dns_callback)(const char *Name, const ip_addr_t *Address, void *Arg);
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display resolver statistics and cache content. */
+void wifi_dns_display_stats(void);
+
+/* Remove all entries from cache. */
+void wifi_dns_flush(void);
+
+/* Retrieve resolver statistics. */
+void wifi_dns_get_stats(struct struct_dns_stats *Stats);
+
+/* Resolve a host name through the cache. */
+INT16 wifi_dns_resolve(const UCHAR *Name, ip_addr_t *Address, wifi_dns_callback Callback, void *Arg);
+
+/* Pre-seed the cache with a table of host names and addresses. */
+UINT8 wifi_dns_seed(const struct struct_dns_seed *Seeds, UINT8 Count);
+
+#endif  // _WIFI_DNS_H
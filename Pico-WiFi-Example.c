@@ -8,9 +8,9 @@
    Pico-WiFi-Example.c
    St-Louys Andre - October 2024
    astlouys@gmail.com
-   Revision 06-JAN-2025
+   Revision 18-OCT-2026
    Langage: C with arm-none-eabi
-   Version 2.02
+   Version 2.03
 
    Raspberry Pi Pico Firmware to test the Pico-WiFi-Driver library.
    This firmware doesn't do much useful thing, but it shows how to implement
@@ -33,6 +33,35 @@
    06-JAN-2025 2.01 - Add a way to monitor Wi-Fi network health and implement a callback to do it.
                     - Other minor and cosmetic changes.
    14-MAY-2025 2.02 - Cleanup, cosmetic and optimization changes.
+   18-OCT-2026 2.03 - Replace the 5-seconds polling callback by the event-driven Wi-Fi health monitor of Pico-WiFi-Module.
+                    - Replace lwIP contrib ping by the multi-target ping engine (no more firmware restart to stop it).
+                    - Add an iperf2-compatible TCP / UDP throughput benchmark.
+                    - Add display of lwIP memory pool, heap and link statistics.
+                    - Add zero-copy stream benchmark.
+                    - Add MQTT publish test.
+                   - Add SNTP time synchronization; log lines are time stamped once time is known.
+                   - Add DNS lookup through the resolver cache.
+                   - Add radio power profile selection and latency probe.
+                   - Add optional dual-core split (WIFI_CORE1) and control-loop jitter benchmark.
+                   - Support poll and FreeRTOS cyw43 architectures (WIFI_ARCH); add CPU use measurement.
+                   - Menu, scan, logon and ping run as tasks of the cooperative scheduler (Pico-WiFi-Sched).
+                   - Interrupt-driven console input with line editor and history (Pico-WiFi-Console); input_string() respects caller buffer size.
+                   - log_info() and scan table lines go out in a single console transfer; add console output benchmark.
+                   - Scan rows are built with the formatters of Pico-WiFi-Module instead of printf(); add formatter benchmark.
+                   - Add binary / CSV / JSON export of scan results and status snapshots (Pico-WiFi-Export).
+                   - Add network command shell (Pico-WiFi-Shell): scan, info, ping, reinit and restart over TCP; cyw43 re-init shared with option 5.
+                   - Add headless boot (WIFI_HEADLESS): network starts at once, terminal is detected in the background; add boot timeline (option 20, shell "boot").
+                   - Option 5 and shell "reinit" run the tiered recovery of Pico-WiFi-Module instead of a full cyw43 re-init; add shell "recovery".
+                   - Network name, password, country, host name, power profile and export mode are read from the configuration store in flash
+                     (Pico-WiFi-Config), compiled-in values being the defaults; credentials of a successful logon are saved (option 21, shell "config").
+                   - Advertise the Pico with mDNS / DNS-SD (Pico-WiFi-MDNS): "<ExtraHostName>.local" and the shell port as a _picowifi._tcp service.
+                   - Add HTTP client benchmark (Pico-WiFi-HTTP): new connection per request vs keep-alive vs pipelining, and chunked upload (option 23).
+                   - Add HTTP status server (Pico-WiFi-HTTPD): status page, /status.json and /scan.json, content precompressed in flash
+                     (WIFI_HTTPD_PORT, option 24, shell "httpd").
+                   - Add store-and-forward telemetry queue in flash (Pico-WiFi-Queue): samples are kept while the link is down and posted in
+                     rate-limited batches once it is back; enqueue / drain benchmark (option 25, shell "queue").
+                   - Network shell is off unless WIFI_SHELL_PORT is given (it has no authentication).
+                   - Shell "config" is read-only: settings are only changed from the local console (option 21).
 \* ============================================================================================================================================================= */
 
 
@@ -48,11 +77,31 @@
 #include "pico/bootrom.h"
 #include "pico/cyw43_arch.h"
 #include "pico/stdlib.h"
+#include "Pico-WiFi-Config.h"
+#include "Pico-WiFi-Console.h"
+#include "Pico-WiFi-Core1.h"
+#include "Pico-WiFi-DNS.h"
+#include "Pico-WiFi-Export.h"
+#include "Pico-WiFi-HTTP.h"
+#include "Pico-WiFi-HTTPD.h"
+#include "Pico-WiFi-Iperf.h"
+#include "Pico-WiFi-MDNS.h"
+#include "Pico-WiFi-MQTT.h"
 #include "Pico-WiFi-Module.h"
-#include "ping.h"
+#include "Pico-WiFi-Ping.h"
+#include "Pico-WiFi-Queue.h"
+#include "Pico-WiFi-SNTP.h"
+#include "Pico-WiFi-Sched.h"
+#include "Pico-WiFi-Shell.h"
+#include "Pico-WiFi-Stream.h"
 #include "stdarg.h"
 #include <stdio.h>
 
+#if PICO_CYW43_ARCH_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif  // PICO_CYW43_ARCH_FREERTOS
+
 
 
 /* $TITLE=Definitions and macros. */
@@ -60,8 +109,75 @@
 /* ============================================================================================================================================================= *\
                                                                        Definitions and macros.
 \* ============================================================================================================================================================= */
+#define IPERF_ADDRESS "192.168.0.2"        // default address of the PC running iperf.
 #define MAX_NETWORKS  200                  // maximum number of Access Points for allocated memory.
+#ifndef MQTT_BROKER_IP
+#define MQTT_BROKER_IP "192.168.0.2"       // default address of the MQTT broker (may be given by CMakeLists.txt).
+#endif  // MQTT_BROKER_IP
+#define MQTT_TEST_COUNT     100            // default number of messages published by the MQTT test.
+#define MQTT_TEST_TOPIC     "pico/test"
+#ifndef HTTP_SERVER_IP
+#define HTTP_SERVER_IP "192.168.0.2"       // default address of the PC running tools/wifi_http_sink.py (may be given by CMakeLists.txt).
+#endif  // HTTP_SERVER_IP
+#define HTTP_SERVER_PORT    8080           // port of tools/wifi_http_sink.py.
+#define HTTP_BENCH_COUNT      50           // default number of requests of each pass of the HTTP client benchmark.
+#define HTTP_BENCH_UPLOAD  65536           // bytes sent by the chunked upload pass of the HTTP client benchmark.
+#define HTTP_BENCH_MSEC    30000           // longest wait for the responses of one pass.
+#define JITTER_CYCLES       5000           // cycles of the control-loop jitter benchmark.
+#define JITTER_PERIOD_USEC  1000           // period of the control loop of the jitter benchmark.
+#define JITTER_PING_MSEC      10           // interval of the pings generating network load during the jitter benchmark.
+#define CPU_TEST_MSEC       3000           // duration of each idle loop count of the CPU use measurement.
+#define CPU_PING_MSEC          5           // interval of the pings generating network load during the CPU use measurement.
+#if PICO_CYW43_ARCH_FREERTOS
+#define MAIN_TASK_PRIORITY  (tskIDLE_PRIORITY + 1)    // below cyw43 / lwIP tasks.
+#define MAIN_TASK_STACK     (8192 / sizeof(StackType_t))
+#endif  // PICO_CYW43_ARCH_FREERTOS
+#define DNS_TEST_NAME       "pool.ntp.org" // default host name looked up by the DNS test.
+#define SNTP_SERVER_COUNT   4              // number of pool servers queried in parallel by the SNTP client.
 #define PING_ADDRESS  "192.168.0.2"
+#define PING_INTERVAL_MSEC  1000           // default delay between two pings to the same target.
+#define PING_REPORT_MSEC    5000           // delay between two progress reports while ping is running.
+#define SCAN_POLL_MSEC        50           // delay between two checks of the end of the Access Points scan.
+#define MENU_POLL_MSEC      1000           // menu task also checks for lines typed at this interval, in case a notification has been missed.
+#define CONSOLE_BENCH_LINES  200           // lines of the scan table printed by each pass of the console output benchmark.
+#define FORMAT_BENCH_ROWS   1000           // scan rows formatted by each pass of the formatter benchmark.
+#define SCAN_ROW_SIZE        100           // one row of the scan table, as built by format_scan_row().
+#ifndef WIFI_SHELL_PORT
+#define WIFI_SHELL_PORT        0           // TCP port of the network shell, 0 to disable it (no authentication: opt-in, see CMakeLists.txt).
+#endif  // WIFI_SHELL_PORT
+#define SHELL_PING_COUNT       4           // default number of echo requests of the shell "ping" command.
+#define SHELL_CLOSE_MSEC     500           // delay for the last reply to go out before the shell sessions are closed (reinit, restart).
+#define SHELL_COMMANDS       (sizeof(ShellCommand) / sizeof(ShellCommand[0]))
+#ifndef WIFI_HTTPD_PORT
+#define WIFI_HTTPD_PORT     HTTPD_DEFAULT_PORT   // TCP port of the HTTP status server, 0 to disable it (may be given by CMakeLists.txt).
+#endif  // WIFI_HTTPD_PORT
+#define HTTPD_HANDLERS       (sizeof(HttpdHandler) / sizeof(HttpdHandler[0]))
+#define HTTPD_RSSI_MSEC     2000           // RSSI shown by the HTTP status server is read again when older than this.
+#define QUEUE_SAMPLE_MSEC  10000           // telemetry sample enqueued by task_queue() while sampling is on (option 25).
+#define QUEUE_POLL_MSEC     1000           // link state is also checked this often (health events only come while the monitor runs).
+#define QUEUE_BENCH_RECORDS 1000           // default number of records of the telemetry queue benchmark.
+#define QUEUE_BENCH_LENGTH    64           // default record length of the telemetry queue benchmark.
+#define MDNS_TXT_COUNT       (sizeof(MdnsTxt) / sizeof(MdnsTxt[0]))
+#ifndef WIFI_HEADLESS
+#define WIFI_HEADLESS          0           // 1: do not wait for a terminal before starting the network (may be given by CMakeLists.txt).
+#endif  // WIFI_HEADLESS
+#define BOOT_CONSOLE_POLL_MSEC  250        // delay between two checks for a terminal connected to CDC USB, after start-up.
+
+/* States of the terminal menu task. */
+#define MENU_STATE_DISPLAY     0           // menu must be displayed.
+#define MENU_STATE_INPUT       1           // waiting for a menu choice.
+#define MENU_STATE_BUSY        2           // waiting for completion of an operation run as a task (scan, logon).
+#define MENU_STATE_PING        3           // ping in progress, waiting for <Enter> to stop it.
+
+/* Passes of the HTTP client benchmark. */
+#define HTTP_BENCH_CLOSE       0           // "Connection: close": new TCP connection for each request.
+#define HTTP_BENCH_KEEPALIVE   1           // one request at a time on a kept-alive connection.
+#define HTTP_BENCH_PIPELINE    2           // requests queued back to back, pipelined on kept-alive connections.
+#define HTTP_BENCH_STREAM      3           // one chunked upload of HTTP_BENCH_UPLOAD bytes.
+
+/* States of the boot task (bit flags). */
+#define BOOT_STATE_CONNECTING  0x01        // network connection started at boot is in progress.
+#define BOOT_STATE_CONSOLE     0x02        // terminal has been detected.
 
 
 
@@ -73,6 +189,36 @@
 UINT8 FlagLogon;
 UINT8 APNumber;
 
+struct struct_sched_task *MenuTask;        // terminal menu.
+struct struct_sched_task *PingTask;        // ping progress reports.
+UCHAR MenuString[CONSOLE_LINE_SIZE];       // menu choice typed.
+UINT8 MenuOption;                          // menu option in progress.
+
+volatile UINT8 DnsLookupDone;              // set by callback_dns_lookup() when a lookup completes.
+ip_addr_t DnsLookupAddress;
+
+const UCHAR *const SntpServer[SNTP_SERVER_COUNT] = {"0.pool.ntp.org", "1.pool.ntp.org", "2.pool.ntp.org", "3.pool.ntp.org"};
+
+volatile UINT16 HttpBenchDone;             // responses (or errors) received by callback_http_bench().
+volatile UINT16 HttpBenchErrors;           // failed requests and error status.
+UINT32 HttpBenchProduced;                  // bytes given by http_bench_producer() to the chunked upload.
+const UCHAR HttpBenchBody[] = "{\"device\":\"PicoW\",\"temperature\":21.5,\"humidity\":40}";
+const UCHAR *const HttpBenchName[] = {"New connection per request", "Keep-alive, one at a time", "Keep-alive, pipelined"};
+
+INT32 HttpdRssi;                           // RSSI shown by the HTTP status server (see httpd_rssi()).
+UINT64 HttpdRssiTime;                      // time stamp of HttpdRssi, in usec since boot.
+volatile UINT8 HttpdRssiPending;           // httpd_rssi_refresh() has been queued and has not run yet.
+
+struct struct_sched_task *QueueTask;       // telemetry queue (see task_queue()).
+UINT8 QueueSampling;                       // a telemetry sample is enqueued every QUEUE_SAMPLE_MSEC (option 25).
+UINT64 QueueSampleTime;                    // time of the next sample, in usec since boot.
+UINT16 QueueRecord;                        // record of the batch being sent that queue_producer() is at...
+UINT16 QueueOffset;                        // ... and byte of this record.
+UINT8 QueueSeparator;                      // queue_producer() must write '[', ',' or ']' before going on.
+
+/* TXT record of the _picowifi._tcp service advertised by mDNS (see Pico-WiFi-MDNS.c). */
+const UCHAR *const MdnsTxt[] = {"app=Pico-WiFi-Example", "version=2.03", "shell=telnet"};
+
 struct
 {
   INT8  SignalStrength;
@@ -82,8 +228,6 @@ struct
   UCHAR NetworkName[40];
 }WlanFound[MAX_NETWORKS];
 
-struct repeating_timer Handle5SecTimer;
-
 
 
 /* $TITLE=Function prototypes. */
@@ -91,20 +235,107 @@ struct repeating_timer Handle5SecTimer;
 /* ============================================================================================================================================================= *\
                                                                      Function prototypes.
 \* ============================================================================================================================================================= */
-/* Callback in charge of Wi-Fi network monitoring. */
-bool callback_5sec_timer(struct repeating_timer *t);
+/* Result of a DNS lookup. */
+void callback_dns_lookup(const char *Name, const ip_addr_t *Address, void *Arg);
+
+/* Response of a request of the HTTP client benchmark. */
+void callback_http_bench(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context);
+
+/* Response to a batch of the telemetry queue. */
+void callback_queue(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context);
+
+/* Subscriber to Wi-Fi health monitor events. */
+void callback_wifi_health(UINT8 Event, struct struct_wifi *StructWiFi, void *Context);
+
+/* Shell command: display the boot timeline. */
+void command_boot(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display the configuration store (read-only over the network). */
+void command_config(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display HTTP status server statistics. */
+void command_httpd(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display Wi-Fi network information. */
+void command_info(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display mDNS responder statistics. */
+void command_mdns(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: ping an IP address. */
+void command_ping(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display telemetry queue statistics. */
+void command_queue(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: display Wi-Fi link recovery statistics. */
+void command_recovery(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: recover the Wi-Fi link. */
+void command_reinit(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: restart the Firmware. */
+void command_restart(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Shell command: scan Wi-Fi frequencies for available Access Points. */
+void command_scan(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Apply the settings saved in the configuration store. */
+void config_load(struct struct_wifi *StructWiFi);
+
+/* Export the scan table in current export mode. */
+void export_results(void);
+
+/* Formatter benchmark: format scan rows and return the time per row. */
+UINT32 format_bench(UINT8 Mode);
+
+/* Build one row of the scan table. */
+void format_scan_row(UCHAR *Row, UINT16 Number, const UCHAR *Name, INT16 Rssi, UINT8 Channel, const UINT8 *MacAddress, UINT32 Security);
 
 /* Retrieve Pico's Unique ID from the flash IC. */
 void get_pico_unique_id(UCHAR *PicoUniqueId);
 
+/* HTTP client benchmark: run one pass and return its duration in usec. */
+UINT64 http_bench(const ip_addr_t *Address, UINT8 Mode, UINT16 Count);
+
+/* Body of the chunked upload of the HTTP client benchmark. */
+INT32 http_bench_producer(UCHAR *Buffer, UINT16 Size, void *Context);
+
+/* Escape a string for JSON or HTML. */
+UCHAR *httpd_escape(UCHAR *Buffer, UINT16 Size, const UCHAR *String, UINT8 FlagJson);
+
+/* RSSI shown by the HTTP status server. */
+INT32 httpd_rssi(void);
+
+/* Read the RSSI shown by the HTTP status server. */
+void httpd_rssi_refresh(void *Arg);
+
+/* HTTP status server: results of the last scan. */
+INT16 httpd_scan(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context);
+
+/* HTTP status server: network information and counters. */
+INT16 httpd_status(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context);
+
+/* HTTP status server: single-value server-side include tags. */
+INT16 httpd_tag(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context);
+
 /* Read data from stdin. */
-void input_string(UCHAR *String);
+void input_string(UCHAR *String, UINT16 Size);
 
 /* Log data to log file. */
 void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
 
+/* FreeRTOS task running the main program. */
+void main_task(void *Parameters);
+
 /* Logon to local network. */
-void network_logon(struct struct_wifi *StructWiFi);
+INT16 network_logon(struct struct_wifi *StructWiFi);
+
+/* Report the result of the logon to local network. */
+void network_logon_done(struct struct_wifi *StructWiFi);
+
+/* Console output benchmark: print lines of the scan table and return the number of lines per second. */
+UINT32 print_bench(UINT8 Mode);
 
 /* Print results of the scan process. */
 void print_results(UINT8 SortOrder);
@@ -112,6 +343,15 @@ void print_results(UINT8 SortOrder);
 /* Print a single entry. */
 void print_single_entry(UINT16 EntryNumber);
 
+/* Print a single entry with one printf() per field, as before (console output benchmark only). */
+void print_single_entry_legacy(UINT16 EntryNumber);
+
+/* Body of a batch of the telemetry queue: JSON array of its records. */
+INT32 queue_producer(UCHAR *Buffer, UINT16 Size, void *Context);
+
+/* Sender of the telemetry queue: post a batch to the HTTP server. */
+INT16 queue_send(const struct struct_queue_batch *Batch, void *Context);
+
 /* Reverse order of two specific results. */
 void reverse_order(UINT16 Position1, UINT16 Position2);
 
@@ -121,13 +361,66 @@ static int scan_results(void *env, const cyw43_ev_scan_result_t *result);
 /* Sort results of the scan process. */
 void sort_results(UINT8 SortOrder);
 
-/* Terminal menu when a CDC USB connection is detected during power up sequence. */
-void term_menu(struct struct_wifi *StructWiFi);
+/* Connect at boot (headless) and detect a terminal connected later. */
+void task_boot(struct struct_sched_task *Task, UINT32 Events);
+
+/* End of a ping started by the shell. */
+void task_command_ping(struct struct_sched_task *Task, UINT32 Events);
+
+/* Terminal menu task. */
+void task_menu(struct struct_sched_task *Task, UINT32 Events);
+
+/* Ping progress reports. */
+void task_ping(struct struct_sched_task *Task, UINT32 Events);
+
+/* Telemetry queue: sample, then drain while the link is up. */
+void task_queue(struct struct_sched_task *Task, UINT32 Events);
+
+/* Scan Wi-Fi frequencies for available Access Points. */
+void task_scan(struct struct_sched_task *Task, UINT32 Events);
+
+/* Execute a terminal menu option. */
+UINT8 term_menu(struct struct_wifi *StructWiFi, UINT8 Menu);
+
+/* Display the terminal menu. */
+void term_menu_display(void);
 
 /* Wipe results. */
 void wipe_results(void);
 
 
+/* Commands of the network shell (see Pico-WiFi-Shell.c), in addition to its built-in "help", "quit" and "who". */
+const struct struct_shell_command ShellCommand[] =
+{
+  {"boot",     "Display the boot timeline.",                                                         command_boot},
+  {"config",   "config [show]: display the settings (changes from the local console only).",         command_config},
+  {"httpd",    "Display HTTP status server statistics.",                                             command_httpd},
+  {"info",     "Display Wi-Fi network information.",                                                 command_info},
+  {"mdns",     "Display mDNS / DNS-SD responder statistics.",                                        command_mdns},
+  {"ping",     "ping <IP address> [count]: ping an IP address.",                                     command_ping},
+  {"queue",    "Display telemetry queue statistics.",                                                command_queue},
+  {"recovery", "Display Wi-Fi link recovery statistics.",                                            command_recovery},
+  {"reinit",   "reinit [1-3]: recover the Wi-Fi link, starting at this tier.",                       command_reinit},
+  {"restart",  "Restart the Firmware.",                                                              command_restart},
+  {"scan",     "Scan Wi-Fi frequencies for available Access Points.",                                command_scan}
+};
+
+
+/* Dynamic content of the HTTP status server (see Pico-WiFi-HTTPD.c): JSON endpoints, then server-side include tags of httpd/info.shtml. */
+const struct struct_httpd_handler HttpdHandler[] =
+{
+  {"/scan.json",   "application/json", httpd_scan},
+  {"/status.json", "application/json", httpd_status},
+  {"errors",       NULL,               httpd_tag},
+  {"host",         NULL,               httpd_tag},
+  {"ip",           NULL,               httpd_tag},
+  {"rssi",         NULL,               httpd_tag},
+  {"scan",         NULL,               httpd_scan},
+  {"ssid",         NULL,               httpd_tag},
+  {"uptime",       NULL,               httpd_tag}
+};
+
+
 
 
 /* $PAGE */
@@ -148,30 +441,50 @@ int main()
   UINT16 Loop1UInt16;
 
   struct struct_wifi StructWiFi;
+#if WIFI_CORE1
+  struct struct_core1_msg Core1Message;
+#endif  // WIFI_CORE1
+  struct struct_config_stats ConfigStats;
 
-  absolute_time_t ScanTime;
+
+
+#if PICO_CYW43_ARCH_FREERTOS
+  /* With FreeRTOS, cyw43_arch_init() must be called from a task, once the scheduler is running.
+     First call starts the scheduler, which calls main() again from main_task(). */
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+  {
+    xTaskCreate(main_task, "Main", MAIN_TASK_STACK, NULL, MAIN_TASK_PRIORITY, NULL);
+    vTaskStartScheduler();  // never returns.
+  }
+#endif  // PICO_CYW43_ARCH_FREERTOS
 
 
   /* --------------------------------------------------------------------------------------------------------------------------- *\
                                                             Initializations.
   \* --------------------------------------------------------------------------------------------------------------------------- */
+  wifi_boot_mark(WIFI_BOOT_MAIN);  // clocks and C runtime have been initialized by the SDK before main().
   Delay        = 0;
   FlagLogon    = FLAG_OFF;  // logon has not been done on entry.
   FlagScanning = FLAG_OFF;
-  ScanTime     = nil_time;
   StructWiFi.CountryCode = COUNTRY_CODE;
   stdio_init_all();
+  wifi_boot_mark(WIFI_BOOT_STDIO);
 
   strcpy(StructWiFi.NetworkName,     WIFI_SSID);      // network name is read from environment variable (see User Guide).
   strcpy(StructWiFi.NetworkPassword, WIFI_PASSWORD);  // password is read from environment variable (see User Guide).
 
+  /* Settings saved in flash replace the compiled-in values above. */
+  config_load(&StructWiFi);
+
 
 
   /* --------------------------------------------------------------------------------------------------------------------------- *\
                                                     Wait for CDC USB connection.
                                   PicoW will blink its LED while waiting for a CDC USB connection.
                                It will give up and continue after a while and continue with the code.
+                 Headless boot (WIFI_HEADLESS) does not wait: the network is started at once and the terminal is detected by task_boot().
   \* --------------------------------------------------------------------------------------------------------------------------- */
+#if WIFI_HEADLESS == 0
   /* Wait for CDC USB connection. */
   printf("[%5u] - Before delay, waiting for a CDC USB connection.\r", __LINE__);
   sleep_ms(1000);  // slow down startup sequence for debugging purposes.
@@ -185,6 +498,7 @@ int main()
     /* If we waited for more than 120 seconds for a CDC USB connection, get out of the loop and continue. */
     if (Delay > 120) break;
   }
+#endif  // WIFI_HEADLESS
 
   get_pico_unique_id(PicoUniqueId);
 
@@ -194,13 +508,34 @@ int main()
   log_info(__LINE__, __func__, "                                    Pico unique ID: <%s>.\r", PicoUniqueId);
   log_info(__LINE__, __func__, "==============================================================================================================\r");
   log_info(__LINE__, __func__, "Main program entry point (Delay: %u msec waiting for CDC USB connection).\r", (Delay * 50));
+  wifi_config_get_stats(&ConfigStats);
+  log_info(__LINE__, __func__, "Configuration store: %u setting(s) loaded from flash in %lu usec.\r", ConfigStats.Keys, ConfigStats.LoadUsec);
 
 
 
   /* Check if CDC USB connection has been detected.*/
-  if (stdio_usb_connected()) log_info(__LINE__, __func__, "CDC USB connection has been detected.\r", __LINE__);
+  if (stdio_usb_connected())
+  {
+    wifi_boot_mark(WIFI_BOOT_CONSOLE);
+    log_info(__LINE__, __func__, "CDC USB connection has been detected.\r", __LINE__);
+  }
 
 
+#if WIFI_CORE1
+  /* Wi-Fi stack, connection and health monitor run on core 1. Wait for start-up to complete. */
+  log_info(__LINE__, __func__, "Starting network on core 1.\r");
+  wifi_core1_start(&StructWiFi);
+  while (wifi_core1_get_event(&Core1Message) != 0) sleep_ms(10);
+  if (Core1Message.Value != 0)
+  {
+    log_info(__LINE__, __func__, "Failed to start network on core 1 (return code: %d).\r", Core1Message.Value);
+  }
+  else
+  {
+    log_info(__LINE__, __func__, "Network started on core 1.\r\r\r");
+    FlagLogon = FLAG_ON;
+  }
+#else   // WIFI_CORE1
   if (wifi_init(&StructWiFi))
   {
     log_info(__LINE__, __func__, "Failed to initialize cyw43\r");
@@ -215,15 +550,36 @@ int main()
   /* Set station mode. */
   log_info(__LINE__, __func__, "Setting station mode\r\r\r");
   cyw43_arch_enable_sta_mode();
+
+  /* Link recovery tells its subscribers when cyw43 is re-initialized, even if the health monitor has not been started (option 7). */
+  wifi_health_subscribe(callback_wifi_health, NULL);
+#endif  // WIFI_CORE1
   
 
   /* --------------------------------------------------------------------------------------------------------------------------- *\
-                                                      Loop on the terminal menu.
+                          Run the terminal menu as a task of the cooperative scheduler (see Pico-WiFi-Sched.c).
   \* --------------------------------------------------------------------------------------------------------------------------- */
-  while (1)
-  {
-    term_menu(&StructWiFi);
-  }
+  wifi_sched_init();
+  MenuTask = wifi_sched_create("menu", task_menu, &StructWiFi);
+  wifi_console_start(MenuTask);
+  wifi_sched_create("boot", task_boot, &StructWiFi);
+
+  /* Telemetry is kept in flash while the network is down, and sent in batches once it is back (see Pico-WiFi-Queue.c). */
+  QueueTask = wifi_sched_create("queue", task_queue, &StructWiFi);
+
+  /* Menu commands are also available over the network (see Pico-WiFi-Shell.c), once the Pico is connected. */
+  if ((WIFI_SHELL_PORT != 0) && (wifi_shell_start(WIFI_SHELL_PORT, ShellCommand, SHELL_COMMANDS, &StructWiFi) == 0))
+    log_info(__LINE__, __func__, "Network shell listening on TCP port %u.\r", WIFI_SHELL_PORT);
+
+  /* Status page and JSON endpoints, served from flash (see httpd/ and Pico-WiFi-HTTPD.c). */
+  if ((WIFI_HTTPD_PORT != 0) && (wifi_httpd_start(WIFI_HTTPD_PORT, HttpdHandler, HTTPD_HANDLERS, &StructWiFi) == 0))
+    log_info(__LINE__, __func__, "HTTP status server listening on TCP port %u.\r", WIFI_HTTPD_PORT);
+
+  /* The Pico is found by name or by browsing the service, without sweeping the subnet. Records are announced once connected.
+     Without the shell, only the host name is advertised (no service on port 0). */
+  if (wifi_mdns_start(WIFI_SHELL_PORT, MdnsTxt, MDNS_TXT_COUNT) == 0)
+    log_info(__LINE__, __func__, "mDNS responder started (service %s).\r", (WIFI_SHELL_PORT != 0) ? MDNS_SERVICE_TYPE : "none");
+  wifi_sched_run();  // never returns.
 
   return 0;
 }
@@ -232,65 +588,65 @@ int main()
 
 
 
-/* $TITLE=callback_5sec_timer() */
+/* $TITLE=callback_dns_lookup() */
 /* $PAGE */
 /* ============================================================================================================================================================= *\
-                                                          Callback in charge of monitoring Wi-Fi network health.
+                                                                        Result of a DNS lookup.
+                                                          NOTE: Called from lwIP context. Must not block.
 \* ============================================================================================================================================================= */
-bool callback_5sec_timer(struct repeating_timer *t)
+void callback_dns_lookup(const char *Name, const ip_addr_t *Address, void *Arg)
 {
-  INT ReturnCode;
-
-  UINT16 Loop1UInt16;
-
-  static UINT64 TimeStamp;
-
-
-  if (TimeStamp == 0ll) TimeStamp = time_us_64();  // keep track of callback launch.
-
-  ReturnCode = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
-  if (ReturnCode == CYW43_LINK_UP)
+  if (Address != NULL)
   {
-    // log_info(__LINE__, __func__, "time_us_64(): %12llu     TimeStamp: %12llu     TimeStamp + (30 * 1000000): %12llu\r", time_us_64(), TimeStamp, (TimeStamp + (30 * 1000000)));
-    if (time_us_64() < (TimeStamp + (15 * 1000000))) log_info(__LINE__, __func__, "Wi-Fi connection OK.\r");
-    wifi_blink(50, 200, 1);
+    DnsLookupAddress = *Address;
+    DnsLookupDone    = 1;
   }
   else
   {
-    if (time_us_64() < (TimeStamp + (15 * 1000000))) log_info(__LINE__, __func__, "Problems with Wi-Fi connection...\r");
-    wifi_blink(50, 200, 3);
+    DnsLookupDone = 2;
   }
 
-  return true;
+  return;
 }
 
 
 
 
 
+/* $TITLE=callback_http_bench() */
 /* $PAGE */
-/* $TITLE=get_pico_unique_id() */
 /* ============================================================================================================================================================= *\
-                                                           Retrieve Pico's Unique ID from the flash IC.
+                                                       Response of a request of the HTTP client benchmark.
+                                                          NOTE: Called from lwIP context. Must not block.
 \* ============================================================================================================================================================= */
-void get_pico_unique_id(UCHAR *PicoUniqueId)
+void callback_http_bench(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context)
 {
-  UINT8 Loop1UInt8;
+  if ((Event == HTTP_EVENT_ERROR) || ((Event == HTTP_EVENT_DONE) && (Response->Status >= 300))) ++HttpBenchErrors;
+  if ((Event == HTTP_EVENT_DONE) || (Event == HTTP_EVENT_ERROR)) ++HttpBenchDone;
 
-  pico_unique_board_id_t board_id;
+  return;
+}
 
 
-  /* Retrieve Pico Unique ID from its flash memory IC. */
-  pico_get_unique_board_id(&board_id);
 
-  /* Build the Unique ID string in hex. */
-  PicoUniqueId[0] = 0x00;  // initialize as null string on entry.
-  for (Loop1UInt8 = 0; Loop1UInt8 < PICO_UNIQUE_BOARD_ID_SIZE_BYTES; ++Loop1UInt8)
-  {
-    // log_info(__LINE__, __func__, "%2u - 0x%2.2X\r", Loop1UInt8, board_id.id[Loop1UInt8]);
-    sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "%2.2X", board_id.id[Loop1UInt8]);
-    if ((Loop1UInt8 % 2) && (Loop1UInt8 != 7)) sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "-");
-  }
+
+
+/* $TITLE=callback_queue() */
+/* $PAGE */
+/* ============================================================================================================================================================= *\
+               Response to a batch of the telemetry queue: a success status removes its records from the queue, anything else sends it again later.
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+void callback_queue(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context)
+{
+  if (Event == HTTP_EVENT_DONE)
+    wifi_queue_done((Response->Status < 300) ? 0 : -1);
+  else if (Event == HTTP_EVENT_ERROR)
+    wifi_queue_done(-1);
+  else
+    return;
+
+  wifi_sched_post(QueueTask, SCHED_EVENT_DONE);
 
   return;
 }
@@ -299,101 +655,69 @@ void get_pico_unique_id(UCHAR *PicoUniqueId)
 
 
 
+/* $TITLE=callback_wifi_health() */
 /* $PAGE */
-/* $TITLE=input_string() */
 /* ============================================================================================================================================================= *\
-                                                                    Read a string from stdin.
+                                                          Subscriber to Wi-Fi health monitor events.
+                               NOTE: Called from lwIP context as soon as the event occurs. Must not block (no sleep_ms(), no input_string()).
 \* ============================================================================================================================================================= */
-void input_string(UCHAR *String)
+void callback_wifi_health(UINT8 Event, struct struct_wifi *StructWiFi, void *Context)
 {
-  INT8 DataInput;
+  UCHAR Address[WIFI_IP_STRING_SIZE];
 
-  UINT8 FlagLocalDebug = FLAG_OFF;
-  UINT8 Loop1UInt8;
 
-  UINT32 IdleTimer;
+  /* Telemetry queue starts or stops draining when the link changes. */
+  if (QueueTask != NULL) wifi_sched_post(QueueTask, SCHED_EVENT_NETWORK);
 
+  switch (Event)
+  {
+    case (WIFI_EVENT_IP_ACQUIRED):
+    case (WIFI_EVENT_IP_CHANGED):
+      log_info(__LINE__, __func__, "Wi-Fi event: %s <%s>.\r", wifi_event_name(Event), wifi_format_ip(Address, &StructWiFi->PicoIPAddress));
+    break;
 
-  if (FlagLocalDebug) printf("Entering input_string().\r");
+    case (WIFI_EVENT_LINK_DOWN):
+      log_info(__LINE__, __func__, "Wi-Fi event: %s (total link drops: %lu).\r", wifi_event_name(Event), StructWiFi->LinkDownCount);
+    break;
 
-  Loop1UInt8 = 0;
-  IdleTimer  = time_us_32();  // initialize time-out timer with current system timer.
-  do
-  {
-    DataInput = getchar_timeout_us(50000);
+    case (WIFI_EVENT_RECONNECTING):
+      log_info(__LINE__, __func__, "Wi-Fi event: %s (attempt: %lu).\r", wifi_event_name(Event), StructWiFi->ReconnectCount);
+    break;
 
-    switch (DataInput)
-    {
-      case (PICO_ERROR_TIMEOUT):
-      case (0):
-#if 0
-        /* This section if we want input_string() to return after a timeout wait time. */ 
-        if ((time_us_32() - IdleTimer) > 300000000l)
-        {
-          printf("[%5u] - Input timeout %lu - %lu = %lu!!\r\r\r", __LINE__, time_us_32(), IdleTimer, time_us_32() - IdleTimer);
-          String[0]  = 0x1B;  // time-out waiting for a keystroke.
-          Loop1UInt8 = 1;     // end-of-string will be added when exiting while loop.
-          DataInput  = 0x0D;
-        }
-#endif  // 0
-        continue;
-      break;
+    case (WIFI_EVENT_REINIT_START):
+      /* Shell and HTTP connections do not survive the re-initialization of cyw43 (see wifi_recover_start()). */
+      log_info(__LINE__, __func__, "Wi-Fi event: %s.\r", wifi_event_name(Event));
+      wifi_shell_stop();
+      wifi_httpd_stop();
+    break;
 
-      case (8):
-        /* <Backspace> */
-        IdleTimer = time_us_32();  // restart time-out timer.
-        if (Loop1UInt8 > 0)
-        {
-          --Loop1UInt8;
-          String[Loop1UInt8] = 0x00;
-          printf("%c %c", 0x08, 0x08);  // erase character under the cursor.
-        }
-      break;
+    case (WIFI_EVENT_REINIT_DONE):
+      log_info(__LINE__, __func__, "Wi-Fi event: %s.\r", wifi_event_name(Event));
+      if (WIFI_SHELL_PORT != 0) wifi_shell_start(WIFI_SHELL_PORT, ShellCommand, SHELL_COMMANDS, StructWiFi);
+      if (WIFI_HTTPD_PORT != 0) wifi_httpd_start(WIFI_HTTPD_PORT, HttpdHandler, HTTPD_HANDLERS, StructWiFi);
+    break;
 
-      case (27):
-        /* <ESC> */
-        IdleTimer = time_us_32();  // restart time-out timer.
-        if (Loop1UInt8 == 0)
-        {
-          String[Loop1UInt8++] = (UCHAR)DataInput;
-          String[Loop1UInt8++] = 0x00;
-        }
-        printf("\r");
-      break;
+    default:
+      log_info(__LINE__, __func__, "Wi-Fi event: %s.\r", wifi_event_name(Event));
+    break;
+  }
+
+  return;
+}
 
-      case (0x0D):
-        /* <Enter> */
-        IdleTimer = time_us_32();  // restart time-out timer.
-        if (Loop1UInt8 == 0)
-        {
-          String[Loop1UInt8++] = (UCHAR)DataInput;
-          String[Loop1UInt8++] = 0x00;
-        }
-        printf("\r");
-      break;
-
-      default:
-        IdleTimer = time_us_32();  // restart time-out timer.
-        printf("%c", (UCHAR)DataInput);
-        String[Loop1UInt8] = (UCHAR)DataInput;
-        // printf("Loop1UInt8: %3u   %2.2X - %c\r", Loop1UInt8, DataInput, DataInput);  /// for debugging purposes.
-        ++Loop1UInt8;
-      break;
-    }
-    sleep_ms(10);
-  } while((Loop1UInt8 < 128) && (DataInput != 0x0D));
 
-  String[Loop1UInt8] = '\0';  // end-of-string
-  /// printf("\r\r\r");
 
-  /* Optionally display each character entered. */
-  /***
-  for (Loop1UInt8 = 0; Loop1UInt8 < 10; ++Loop1UInt8)
-    printf("%2u:[%2.2X]   ", Loop1UInt8, String[Loop1UInt8]);
-  printf("\r");
-  ***/
 
-  if (FlagLocalDebug) printf("Exiting input_string().\r");
+
+/* $PAGE */
+/* $TITLE=command_boot(). */
+/* ============================================================================================================================================================= *\
+                                                            Shell command: display the boot timeline.
+\* ============================================================================================================================================================= */
+void command_boot(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_boot_display();
 
   return;
 }
@@ -403,71 +727,55 @@ void input_string(UCHAR *String)
 
 
 /* $PAGE */
-/* $TITLE=log_info()) */
+/* $TITLE=command_config(). */
 /* ============================================================================================================================================================= *\
-                                                            Log info to log file through Pico UART or CDC USB.
+                     Shell command: display the configuration store ("config" or "config show"). The network shell has no authentication, so
+                              changes (set, erase, format) are refused here: they are only made from the local console (option 21).
 \* ============================================================================================================================================================= */
-void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+void command_config(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
 {
-  UCHAR Dum1Str[256];
-  UCHAR TimeStamp[128];
+  if ((Argc == 1) || ((Argc == 2) && (strcmp(Argv[1], "show") == 0)))
+  {
+    /* Output of log_info() is copied to the session while the command runs (passwords are never displayed). */
+    wifi_config_display();
+    return;
+  }
 
-  UINT Loop1UInt;
-  UINT StartChar;
+  wifi_shell_printf(Session, "Read-only over the network: change the settings from the local console (option 21).\r");
 
-  va_list argp;
+  return;
+}
 
 
-  /* Transfer the text to print to variable Dum1Str */
-  va_start(argp, Format);
-  vsnprintf(Dum1Str, sizeof(Dum1Str), Format, argp);
-  va_end(argp);
 
-  /* Trap special control code for <HOME>. Replace "home" by appropriate control characters for "Home" on a VT101. */
-  if (strcmp(Dum1Str, "home") == 0)
-  {
-    Dum1Str[0] = 0x1B; // ESC code
-    Dum1Str[1] = '[';
-    Dum1Str[2] = 'H';
-    Dum1Str[3] = 0x00;
-  }
 
-  /* Trap special control code for <CLS>. Replace "cls" by appropriate control characters for "Clear screen" on a VT101. */
-  if (strcmp(Dum1Str, "cls") == 0)
-  {
-    Dum1Str[0] = 0x1B; // ESC code
-    Dum1Str[1] = '[';
-    Dum1Str[2] = '2';
-    Dum1Str[3] = 'J';
-    Dum1Str[4] = 0x00;
-  }
 
-  /* Time stamp will not be printed if first character is a '-' (for title line when starting debug, for example),
-     or if first character is a line feed '\r' when we simply want add line spacing in the debug log,
-     or if first character is the beginning of a control stream (for example 'Home' or "Clear screen'). */
-  if ((Dum1Str[0] != '-') && (Dum1Str[0] != '\r') && (Dum1Str[0] != 0x1B) && (Dum1Str[0] != '|'))
-  {
-    /* Send line number through UART. */
-    printf("[%7u] - ", LineNumber);
+/* $PAGE */
+/* $TITLE=command_httpd(). */
+/* ============================================================================================================================================================= *\
+                                                     Shell command: display HTTP status server statistics.
+\* ============================================================================================================================================================= */
+void command_httpd(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_httpd_display_stats();
+
+  return;
+}
 
-    /* Display function name. */
-    printf("[%s]", FunctionName);
-    for (Loop1UInt = strlen(FunctionName); Loop1UInt < 25; ++Loop1UInt)
-    {
-      printf(" ");
-    }
-    printf("- ");
 
 
-    /* Retrieve current time stamp. */
-    // date_stamp(TimeStamp);
 
-    /* Send time stamp through UART. */
-    // printf(TimeStamp);
-  }
 
-  /* Send string through stdout. */
-  printf(Dum1Str);
+/* $PAGE */
+/* $TITLE=command_info(). */
+/* ============================================================================================================================================================= *\
+                                                        Shell command: display Wi-Fi network information.
+\* ============================================================================================================================================================= */
+void command_info(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_display_info((struct struct_wifi *)Session->Context);
 
   return;
 }
@@ -477,70 +785,62 @@ void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
 
 
 /* $PAGE */
-/* $TITLE=network_logon(). */
+/* $TITLE=command_mdns(). */
 /* ============================================================================================================================================================= *\
-                                                                   Logon to local network.
+                                                    Shell command: display mDNS / DNS-SD responder statistics.
 \* ============================================================================================================================================================= */
-void network_logon(struct struct_wifi *StructWiFi)
+void command_mdns(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
 {
-  UCHAR String[65];
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_mdns_display_stats();
 
-  INT16 ReturnCode;
+  return;
+}
 
 
-  /* --------------------------------------------------------------------------------------------------------------------------- *\
-                                       Give an opportunity for user to change network nanme (SSID).
-  \* --------------------------------------------------------------------------------------------------------------------------- */
-  log_info(__LINE__, __func__, "Current network name is <%s>\r", StructWiFi->NetworkName);
-  log_info(__LINE__, __func__, "Enter new network name or <Enter> to keep current one: ");
-  input_string(String);
-  if ((String[0] != 0x0D) && (String[0] != 0x1B))
-  {
-    strcpy(StructWiFi->NetworkName, String);
-    log_info(__LINE__, __func__, "Network name has been changed to: <%s>.\r", StructWiFi->NetworkName);
-  }
-  else
-  {
-    log_info(__LINE__, __func__, "Network name has not been changed: <%s>.\r", StructWiFi->NetworkName);
-  }
-  log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-  input_string(String);
 
 
 
-  /* --------------------------------------------------------------------------------------------------------------------------- *\
-                                      Give an opportunity for user to change network password.
-  \* --------------------------------------------------------------------------------------------------------------------------- */
-  printf("\r\r");
-  log_info(__LINE__, __func__, "Current network password is <%s>\r", StructWiFi->NetworkPassword);
-  log_info(__LINE__, __func__, "Enter new network password or <Enter> to keep current one: ");
-  input_string(String);
-  if ((String[0] != 0x0D) && (String[0] != 0x1B))
+/* $PAGE */
+/* $TITLE=command_ping(). */
+/* ============================================================================================================================================================= *\
+                    Shell command: ping an IP address Count times (SHELL_PING_COUNT by default). The command completes in task_command_ping(),
+                                   which displays the statistics once the last echo request has been answered or has timed out.
+\* ============================================================================================================================================================= */
+void command_ping(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  UINT16 Count;
+
+  ip_addr_t Address;
+
+  struct struct_sched_task *Task;
+
+
+  if ((Argc < 2) || !ip4addr_aton(Argv[1], &Address))
   {
-    strcpy(StructWiFi->NetworkPassword, String);
-    log_info(__LINE__, __func__, "Network password has been changed to: <%s>.\r", StructWiFi->NetworkPassword);
+    wifi_shell_printf(Session, "Usage: ping <IP address> [count]\r");
+    return;
   }
-  else
+  Count = (Argc > 2) ? atoi(Argv[2]) : 0;
+  if (Count == 0) Count = SHELL_PING_COUNT;
+
+  if (ping_is_running())
   {
-    log_info(__LINE__, __func__, "Network password has not been changed: <%s>.\r", StructWiFi->NetworkPassword);
+    wifi_shell_printf(Session, "Ping already in progress.\r");
+    return;
   }
-  log_info(__LINE__, __func__, "Press <Enter> to continue: ", __LINE__);
-  input_string(String);
-
-
 
-  /* --------------------------------------------------------------------------------------------------------------------------- *\
-                                                     Establish WiFi connection.
-  \* --------------------------------------------------------------------------------------------------------------------------- */
-  printf("\r\r");
-  log_info(__LINE__, __func__, "Trying to establish Wi-Fi connection.\r");
-  if ((ReturnCode = wifi_connect(StructWiFi)) != 0)
+  ping_clear_targets();
+  ping_target_add(&Address, PING_INTERVAL_MSEC, Count);
+  if ((ping_start() != 0) || ((Task = wifi_sched_create("shell ping", task_command_ping, Session)) == NULL))
   {
-    log_info(__LINE__, __func__, "Error while trying to establish a Wi-Fi connection (ReturnCode: %d).\r", ReturnCode);
-    log_info(__LINE__, __func__, "Aborting Firmware...\r");
+    ping_stop();
+    wifi_shell_printf(Session, "Failed to start the ping engine.\r");
+    return;
   }
-  log_info(__LINE__, __func__, "Wi-Fi connection established successfully.\r");
-  FlagLogon = FLAG_ON;
+  wifi_shell_printf(Session, "Pinging <%s> %u times.\r", ip4addr_ntoa(&Address), Count);
+  wifi_sched_wait(Task, SCHED_EVENT_TIMER, ((UINT32)Count * PING_INTERVAL_MSEC) + PING_TIMEOUT_MSEC);
+  wifi_shell_hold(Session);
 
   return;
 }
@@ -550,40 +850,31 @@ void network_logon(struct struct_wifi *StructWiFi)
 
 
 /* $PAGE */
-/* $TITLE=print_result(). */
+/* $TITLE=command_queue(). */
 /* ============================================================================================================================================================= *\
-                                                                  Print results of the IP scan process.
+                                                        Shell command: display telemetry queue statistics.
 \* ============================================================================================================================================================= */
-void print_results(UINT8 SortOrder)
+void command_queue(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
 {
-  UINT16 Loop1UInt16;
-  UINT16 Loop2UInt16;
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_queue_display_stats();
 
+  return;
+}
 
-  /* Display  header. */
-  log_info(__LINE__, __func__, "==================================================================================================================================\r");
-  log_info(__LINE__, __func__, "                                                  Results of Access Points scan.\r");
 
-  switch (SortOrder)
-  {
-    case (1):
-      log_info(__LINE__, __func__, "                                             Listed in the order they were scanned.\r");
-    break;
-  
-    case (2):
-      log_info(__LINE__, __func__, "                                         Results have been sorted by MAC address order.\r");
-    break;
-  }
 
-  log_info(__LINE__, __func__, "==================================================================================================================================\r");
-  log_info(__LINE__, __func__, "         Network                        Signal    Channel       MAC             ------------------   Security   ------------------\r");
-  log_info(__LINE__, __func__, "          name                         strength               address\r");
-  log_info(__LINE__, __func__, "==================================================================================================================================\r");
 
-  for (Loop1UInt16 = 1; WlanFound[Loop1UInt16].Channel; ++Loop1UInt16)
-    print_single_entry(Loop1UInt16);
 
-  log_info(__LINE__, __func__, "==================================================================================================================================\r\r\r");
+/* $PAGE */
+/* $TITLE=command_recovery(). */
+/* ============================================================================================================================================================= *\
+                                                      Shell command: display Wi-Fi link recovery statistics.
+\* ============================================================================================================================================================= */
+void command_recovery(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  /* Output of log_info() is copied to the session while the command runs. */
+  wifi_recover_display();
 
   return;
 }
@@ -593,59 +884,52 @@ void print_results(UINT8 SortOrder)
 
 
 /* $PAGE */
-/* $TITLE=print_single_entry(). */
+/* $TITLE=command_reinit(). */
 /* ============================================================================================================================================================= *\
-                                                                      Print a single entry.
+                    Shell command: recover the Wi-Fi link, from tier 1 (rejoin) unless another first tier is given (see wifi_recover_start()).
+                The session may be closed by the recovery (always by tier 3, which re-initializes cyw43); the Pico then reconnects to the network.
 \* ============================================================================================================================================================= */
-void print_single_entry(UINT16 EntryNumber)
+void command_reinit(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
 {
-  UINT16 Loop1UInt16;
+  UINT8 Tier;
 
+  struct struct_wifi *StructWiFi;
 
-  log_info(__LINE__, __func__, "%3u)   %-32s  %4d      %3ld   ", EntryNumber, WlanFound[EntryNumber].NetworkName, WlanFound[EntryNumber].SignalStrength, WlanFound[EntryNumber].Channel);
 
-  for (Loop1UInt16 = 0; Loop1UInt16 < 6; ++Loop1UInt16)
+  StructWiFi = (struct struct_wifi *)Session->Context;
+
+  Tier = (Argc > 1) ? (UINT8)(atoi(Argv[1]) - 1) : WIFI_RECOVER_REJOIN;
+  if (Tier >= WIFI_RECOVER_TIERS)
   {
-    printf("%02X", WlanFound[EntryNumber].MacAddress[Loop1UInt16]);
-    if (Loop1UInt16 < 5) printf(":");
+    wifi_shell_printf(Session, "Invalid tier <%s> (1 to %u).\r", Argv[1], WIFI_RECOVER_TIERS);
+    return;
   }
 
-  printf("     %u   ", WlanFound[EntryNumber].Security);
+  wifi_shell_printf(Session, "Recovering the Wi-Fi link from tier %u (%s), the session may be closed. See \"recovery\" afterwards.\r", Tier + 1, wifi_recover_tier_name(Tier));
+  wifi_sleep_ms(SHELL_CLOSE_MSEC);
 
-#if 0
-  switch (WlanFound[EntryNumber].Security)
-  {
-    case (0):
-      printf("Open network");
-    break;
+  if (wifi_recover_start(StructWiFi, Tier, NULL) != 0) wifi_shell_printf(Session, "A connection or a recovery is already in progress.\r");
 
-    case (0x00200002):
-      printf("Encrypted      WPA");
-    break;
+  return;
+}
 
-    case (0x00400004):
-      printf("Encrypted      WPA2");
-    break;
 
-    case (0x00400006):
-      printf("Encrypted      WPA / WPA2 mixed");
-    break;
 
-    case (0x01000004):
-      printf("Encrypted      WPA3 / AES");
-    break;
 
-    case (0x01400004):
-      printf("Encrypted      WPA2 / WPA3");
-    break;
 
-    default:
-      printf("security mode not found: 0x%X", WlanFound[EntryNumber].Security);
-    break;
-  }
-#endif  // 0
+/* $PAGE */
+/* $TITLE=command_restart(). */
+/* ============================================================================================================================================================= *\
+                                                               Shell command: restart the Firmware.
+\* ============================================================================================================================================================= */
+void command_restart(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  wifi_shell_printf(Session, "Restarting the Firmware...\r");
+  wifi_sleep_ms(SHELL_CLOSE_MSEC);
 
-  printf("\r");
+  cyw43_arch_deinit();
+  watchdog_enable(1, 1);
+  wifi_sleep_ms(3000);
 
   return;
 }
@@ -655,35 +939,52 @@ void print_single_entry(UINT16 EntryNumber)
 
 
 /* $PAGE */
-/* $TITLE=reverse_order(). */
+/* $TITLE=command_scan(). */
 /* ============================================================================================================================================================= *\
-                                                                  Reverse order of two specific results.
+            Shell command: scan Wi-Fi frequencies for available Access Points. The scan runs as a task (see task_scan()), which completes the command.
 \* ============================================================================================================================================================= */
-void reverse_order(UINT16 Position1, UINT16 Position2)
+void command_scan(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
 {
-  UCHAR *PointerFrom;
-  UCHAR *PointerTo;
+  if (cyw43_wifi_scan_active(&cyw43_state) == true)
+  {
+    wifi_shell_printf(Session, "A scan is already in progress.\r");
+    return;
+  }
 
-  UINT16 Loop1UInt16;
+  if (wifi_sched_create("scan", task_scan, Session) == NULL)
+  {
+    wifi_shell_printf(Session, "No task available to run the scan.\r");
+    return;
+  }
+  wifi_shell_hold(Session);
 
+  return;
+}
 
-  /* Use first vector position [0] for temporary storage. */
-  PointerFrom = (UCHAR *)&WlanFound[Position1];
-  PointerTo   = (UCHAR *)&WlanFound[0];
-  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
-    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
 
-  /* Transfer first member. */
-  PointerFrom = (UCHAR *)&WlanFound[Position2];
-  PointerTo   = (UCHAR *)&WlanFound[Position1];
-  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
-    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
 
-  /* Transfer other member. */
-  PointerFrom = (UCHAR *)&WlanFound[0];
-  PointerTo   = (UCHAR *)&WlanFound[Position2];
-  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
-    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
+
+
+/* $PAGE */
+/* $TITLE=config_load(). */
+/* ============================================================================================================================================================= *\
+               Load the configuration store and apply the settings saved in flash. Settings that have not been saved keep their compiled-in value.
+\* ============================================================================================================================================================= */
+void config_load(struct struct_wifi *StructWiFi)
+{
+  UCHAR String[WIFI_HOST_NAME_SIZE];
+
+  UINT32 Value;
+
+
+  wifi_config_init();
+
+  wifi_config_get_string(CONFIG_KEY_SSID,     StructWiFi->NetworkName,     sizeof(StructWiFi->NetworkName));
+  wifi_config_get_string(CONFIG_KEY_PASSWORD, StructWiFi->NetworkPassword, sizeof(StructWiFi->NetworkPassword));
+  if (wifi_config_get_u32(CONFIG_KEY_COUNTRY, &Value) == 0) StructWiFi->CountryCode = (UINT16)Value;
+  if (wifi_config_get_string(CONFIG_KEY_HOSTNAME, String, sizeof(String)) > 0) wifi_set_host_name(String);
+  if (wifi_config_get_u32(CONFIG_KEY_POWER_PROFILE, &Value) == 0) wifi_set_power_profile((UINT8)Value);
+  if (wifi_config_get_u32(CONFIG_KEY_EXPORT_MODE, &Value) == 0) wifi_export_set_mode((UINT8)Value);
 
   return;
 }
@@ -693,88 +994,72 @@ void reverse_order(UINT16 Position1, UINT16 Position2)
 
 
 /* $PAGE */
-/* $TITLE=scan_result(). */
+/* $TITLE=export_results(). */
 /* ============================================================================================================================================================= *\
-                                                                  Retrieve results of the IP scan process.
+                   Export the scan table in current export mode (binary, CSV or JSON), followed by a status snapshot (see Pico-WiFi-Export.c).
 \* ============================================================================================================================================================= */
-static int scan_results(void *env, const cyw43_ev_scan_result_t *Result)
+void export_results(void)
 {
-  UINT8 Loop1UInt8;
+  UINT16 Count;
+  UINT16 Loop1UInt16;
 
 
-  if (Result)
-  {
-    log_info(__LINE__, __func__, "%2u)   %-32s   %4d      %3ld   %02X:%02X:%02X:%02X:%02X:%02X     %u     \r",
-           APNumber,
-           Result->ssid, Result->rssi, Result->channel,
-           Result->bssid[0], Result->bssid[1], Result->bssid[2], Result->bssid[3], Result->bssid[4], Result->bssid[5],
-           Result->auth_mode);
+  for (Count = 0; ((Count + 1) < MAX_NETWORKS) && WlanFound[Count + 1].Channel; ++Count);
 
-    strcpy(WlanFound[APNumber].NetworkName, Result->ssid);
-    WlanFound[APNumber].SignalStrength = Result->rssi;
-    WlanFound[APNumber].Channel        = Result->channel;
-    WlanFound[APNumber].Security       = Result->auth_mode;
-    for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(Result->bssid); ++Loop1UInt8)
-      WlanFound[APNumber].MacAddress[Loop1UInt8] = Result->bssid[Loop1UInt8];
+  wifi_export_begin();
+  wifi_export_scan_begin(Count);
+  for (Loop1UInt16 = 1; Loop1UInt16 <= Count; ++Loop1UInt16)
+    wifi_export_scan_entry(Loop1UInt16, WlanFound[Loop1UInt16].NetworkName, WlanFound[Loop1UInt16].SignalStrength, WlanFound[Loop1UInt16].Channel,
+                           WlanFound[Loop1UInt16].Security, WlanFound[Loop1UInt16].MacAddress);
+  wifi_export_end();
 
-    // printf("[%5u] = %d\r", __LINE__, Result->auth_type);
-    // printf("[%5u] = %d\r", __LINE__, Result->hidden);
-    // printf("[%5u] = %d\r", __LINE__, Result->security);
+  return;
+}
 
-    ++APNumber;
-  }
 
 
-#if 0
-  if (Result->auth_mode == CYW43_AUTH_OPEN)           printf("CYW43_AUTH_OPEN\r");
-  if (Result->auth_mode == CYW43_AUTH_WPA_TKIP_PSK)   printf("CYW43_AUTH_WPA_TKIP_PSK\r");
-  if (Result->auth_mode == CYW43_AUTH_WPA2_AES_PSK)   printf("CYW43_AUTH_WPA2_AES_PSK\r");
-  if (Result->auth_mode == CYW43_AUTH_WPA2_MIXED_PSK) printf("CYW43_AUTH_WPA2_MIXED_PSK\r");
 
 
+/* $PAGE */
+/* $TITLE=format_bench(). */
+/* ============================================================================================================================================================= *\
+                     Formatter benchmark: build FORMAT_BENCH_ROWS rows of the scan table, without printing them, and return the time per row
+                   in nanoseconds (0 if all rows came out empty). Mode 0: snprintf() with the former format string. Mode 1: format_scan_row().
+\* ============================================================================================================================================================= */
+UINT32 format_bench(UINT8 Mode)
+{
+  UCHAR Row[SCAN_ROW_SIZE];
 
-    [CYW43_EV_SET_SSID] = "SET_SSID",
-    [CYW43_EV_JOIN] = "JOIN",
-    [CYW43_EV_AUTH] = "AUTH",
-    [CYW43_EV_DEAUTH_IND] = "DEAUTH_IND",
-    [CYW43_EV_ASSOC] = "ASSOC",
-    [CYW43_EV_DISASSOC] = "DISASSOC",
-    [CYW43_EV_DISASSOC_IND] = "DISASSOC_IND",
-    [CYW43_EV_LINK] = "LINK",
-    [CYW43_EV_PSK_SUP] = "PSK_SUP",
-    [CYW43_EV_ESCAN_RESULT] = "ESCAN_RESULT",
-    [CYW43_EV_CSA_COMPLETE_IND] = "CSA_COMPLETE_IND",
-    [CYW43_EV_ASSOC_REQ_IE] = "ASSOC_REQ_IE",
-    [CYW43_EV_ASSOC_RESP_IE] = "ASSOC_RESP_IE",
+  UINT16 Entry;
+  UINT16 Loop1UInt16;
 
+  UINT32 Sink;  // sum of bytes read back from the rows, keeps the compiler from dropping rows that are never printed.
 
+  UINT64 Elapsed;
 
 
-  switch ((UINT32)Result->auth_mode)
+  Entry   = 1;
+  Sink    = 0;
+  Elapsed = time_us_64();
+  for (Loop1UInt16 = 0; Loop1UInt16 < FORMAT_BENCH_ROWS; ++Loop1UInt16)
   {
-    case (CYW43_AUTH_OPEN):
-      printf("No authorisation required\r");
-    break;
-
-    case (CYW43_AUTH_WPA_TKIP_PSK):
-      printf(" WPA authorisation\r");
-    break;
-
-    case (CYW43_AUTH_WPA2_AES_PSK):
-      printf("WPA2 authorization\r");
-    break;
-
-    case (CYW43_AUTH_WPA2_MIXED_PSK):
-      printf("WPA2/WPA mixed (currently same as CYW43_AUTH_WPA2_AES_PSK)\r");
-    break;
-
-    default:
-      printf("Authorization mode tbd: %d\r", Result->auth_mode);
-    break;
+    if (Mode == 0)
+      snprintf(Row, sizeof(Row), "%3u)   %-32s  %4d      %3u   %02X:%02X:%02X:%02X:%02X:%02X     %u   \r", Entry, WlanFound[Entry].NetworkName, WlanFound[Entry].SignalStrength, WlanFound[Entry].Channel,
+               WlanFound[Entry].MacAddress[0], WlanFound[Entry].MacAddress[1], WlanFound[Entry].MacAddress[2], WlanFound[Entry].MacAddress[3], WlanFound[Entry].MacAddress[4], WlanFound[Entry].MacAddress[5],
+               WlanFound[Entry].Security);
+    else
+      format_scan_row(Row, Entry, WlanFound[Entry].NetworkName, WlanFound[Entry].SignalStrength, WlanFound[Entry].Channel, WlanFound[Entry].MacAddress, WlanFound[Entry].Security);
+    Sink += Row[Loop1UInt16 % 64];
+
+    ++Entry;
+    if ((Entry >= MAX_NETWORKS) || (WlanFound[Entry].Channel == 0)) Entry = 1;
   }
-#endif  // 0
+  Elapsed = time_us_64() - Elapsed;
 
-  return 0;
+  /* Rows all empty: formatter is broken, timing is meaningless. */
+  if (Sink == 0) return 0;
+
+  return (UINT32)((Elapsed * 1000ull) / FORMAT_BENCH_ROWS);
 }
 
 
@@ -782,72 +1067,77 @@ static int scan_results(void *env, const cyw43_ev_scan_result_t *Result)
 
 
 /* $PAGE */
-/* $TITLE=scan_wifi(). */
+/* $TITLE=format_scan_row(). */
 /* ============================================================================================================================================================= *\
-                                                        Scan Wi-Fi frequencies for available Access Points.
+                   Build one row of the scan table into Row (at least SCAN_ROW_SIZE bytes), with the same layout as the former printf() format
+                          "%3u)   %-32s  %4d      %3u   MAC     %u   \r", using the formatters of Pico-WiFi-Module instead of printf().
 \* ============================================================================================================================================================= */
-void scan_wifi(void)
+void format_scan_row(UCHAR *Row, UINT16 Number, const UCHAR *Name, INT16 Rssi, UINT8 Channel, const UINT8 *MacAddress, UINT32 Security)
 {
-  UCHAR *Dum1Ptr;
+  UCHAR *Pos;
 
-  INT16 ReturnCode;
+  UINT8 Length;
 
-  UINT16 Loop1UInt16;
 
+  Pos = Row;
+  Pos += strlen(wifi_format_int(Pos, Number, 3));
+  memcpy(Pos, ")   ", 4);
+  Pos += 4;
 
-  APNumber = 1;
+  /* Network name, padded to 32 characters (SSID is at most 32 characters). */
+  for (Length = 0; (Length < 32) && Name[Length]; ++Length);
+  memcpy(Pos, Name, Length);
+  memset(&Pos[Length], ' ', 32 - Length);
+  Pos += 32;
+  memcpy(Pos, "  ", 2);
+  Pos += 2;
 
-  cyw43_wifi_scan_options_t ScanOptions = {0};
+  Pos += strlen(wifi_format_rssi(Pos, Rssi));
+  memcpy(Pos, "      ", 6);
+  Pos += 6;
 
+  Pos += strlen(wifi_format_channel(Pos, Channel));
+  memcpy(Pos, "   ", 3);
+  Pos += 3;
 
-  /* Wipe WlanFound structure on entry. */
-  log_info(__LINE__, __func__, "sizeof(WlanFound): %u\r", sizeof(WlanFound));
-  Dum1Ptr = (UCHAR *)&WlanFound[0];
-  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound); ++Loop1UInt16)
-    Dum1Ptr = '\0';
+  wifi_format_mac(Pos, MacAddress, ':');
+  Pos += WIFI_MAC_STRING_SIZE - 1;
+  memcpy(Pos, "     ", 5);
+  Pos += 5;
+
+  Pos += strlen(wifi_format_int(Pos, (INT32)Security, 0));
+  strcpy(Pos, "   \r");
+
+  return;
+}
 
 
-  /* Scan Wi-Fi frequency to find available Access Points. */
-  log_info(__LINE__, __func__, "========================================================================================\r");
-  log_info(__LINE__, __func__, "                  Scan Wi-Fi spectrum to find available Access Points.\r");
-  log_info(__LINE__, __func__, "                         Listed in the order they were scanned.\r");
-  log_info(__LINE__, __func__, "               Using frequencies used in the following country: %c%c Rev: %u\r", COUNTRY_CODE, (COUNTRY_CODE >> 8), (COUNTRY_CODE >> 16));
-  log_info(__LINE__, __func__, "========================================================================================\r");
-  log_info(__LINE__, __func__, "         Network                        Signal    Channel       MAC        Security\r");
-  log_info(__LINE__, __func__, "          name                         strength               address\r");
-  log_info(__LINE__, __func__, "========================================================================================\r");
 
-  ReturnCode   = cyw43_wifi_scan(&cyw43_state, &ScanOptions, NULL, scan_results);
-  if (ReturnCode != 0)
-  {
-    log_info(__LINE__, __func__, "Error while trying to scan Wi-Fi spectrum...\r");
-  }
-  else
-  {
-    while (cyw43_wifi_scan_active(&cyw43_state) == true);  // wait until the scan is over...
-    log_info(__LINE__, __func__, "========================================================================================\r\r\r\r");
-  }
 
 
-  print_results(1);
-  sort_results(2);
-  print_results(2);
-  wipe_results();
+/* $PAGE */
+/* $TITLE=get_pico_unique_id() */
+/* ============================================================================================================================================================= *\
+                                                           Retrieve Pico's Unique ID from the flash IC.
+\* ============================================================================================================================================================= */
+void get_pico_unique_id(UCHAR *PicoUniqueId)
+{
+  UINT8 Loop1UInt8;
 
+  pico_unique_board_id_t board_id;
+
+
+  /* Retrieve Pico Unique ID from its flash memory IC. */
+  pico_get_unique_board_id(&board_id);
 
-#if PICO_CYW43_ARCH_POLL
-    // if you are using pico_cyw43_arch_poll, then you must poll periodically from your
-    // main loop (not from a timer) to check for Wi-Fi driver or lwIP work that needs to be done.
-    cyw43_arch_poll();
-    // you can poll as often as you like, however if you have nothing else to do you can
-    // choose to sleep until either a specified time, or cyw43_arch_poll() has work to do:
-    cyw43_arch_wait_for_work_until(ScanTime);
-#else
-    // if you are not using pico_cyw43_arch_poll, then WiFI driver and lwIP work
-    // is done via interrupt in the background. This sleep is just an example of some (blocking)
-    // work you might be doing.
-    sleep_ms(1000);
-#endif
+  /* Build the Unique ID string in hex. */
+  PicoUniqueId[0] = 0x00;  // initialize as null string on entry.
+  for (Loop1UInt8 = 0; Loop1UInt8 < PICO_UNIQUE_BOARD_ID_SIZE_BYTES; ++Loop1UInt8)
+  {
+    // log_info(__LINE__, __func__, "%2u - 0x%2.2X\r", Loop1UInt8, board_id.id[Loop1UInt8]);
+    sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "%2.2X", board_id.id[Loop1UInt8]);
+    if ((Loop1UInt8 % 2) && (Loop1UInt8 != 7)) sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "-");
+  }
 
   return;
 }
@@ -855,317 +1145,2183 @@ void scan_wifi(void)
 
 
 
+
 /* $PAGE */
-/* $TITLE=sort_result(). */
+/* $TITLE=http_bench(). */
 /* ============================================================================================================================================================= *\
-                                                                  Sort results of the IP scan process.
+                                               HTTP client benchmark: run one pass and return its duration in usec.
+                                     Requests are telemetry-like posts; their responses are counted by callback_http_bench().
 \* ============================================================================================================================================================= */
-void sort_results(UINT8 SortOrder)
+UINT64 http_bench(const ip_addr_t *Address, UINT8 Mode, UINT16 Count)
 {
-  UINT16 Loop1UInt16;
-  UINT16 Loop2UInt16;
-  UINT8  MacPosition;
+  INT16 ReturnCode;
 
+  UINT16 Sent;
 
-  // log_info(__LINE__, __func__, "Entering sort_results().\r");
+  UINT64 TimeStamp;
 
-  switch (SortOrder)
+  struct struct_http_request Request;
+
+
+  memset(&Request, 0x00, sizeof(Request));
+  Request.Address    = *Address;
+  Request.Port       = HTTP_SERVER_PORT;
+  Request.Method     = "POST";
+  Request.Path       = "/telemetry";
+  Request.Headers    = (Mode == HTTP_BENCH_CLOSE) ? "Content-Type: application/json\r\nConnection: close\r\n" : "Content-Type: application/json\r\n";
+  Request.Body       = HttpBenchBody;
+  Request.BodyLength = strlen(HttpBenchBody);
+  Request.Callback   = callback_http_bench;
+
+  if (Mode == HTTP_BENCH_STREAM)
   {
-    case (2):
-      /* Sort by MAC address. */
-      for (Loop1UInt16 = 1; WlanFound[Loop1UInt16].Channel; ++Loop1UInt16)
-      {
-        for (Loop2UInt16 = Loop1UInt16 + 1; WlanFound[Loop2UInt16].Channel; ++Loop2UInt16)
-        {
-          /***
-          printf("[%5u] - Comparing %u and %u\r", __LINE__, Loop1UInt16, Loop2UInt16);
-          print_single_entry(Loop1UInt16);
-          print_single_entry(Loop2UInt16);
-          ***/
+    Request.Path       = "/upload";
+    Request.Headers    = "Content-Type: application/octet-stream\r\n";
+    Request.Body       = NULL;
+    Request.BodyLength = 0;
+    Request.Producer   = http_bench_producer;
+    HttpBenchProduced  = 0;
+    Count = 1;
+  }
 
-          MacPosition = 0;
-          while((WlanFound[Loop2UInt16].MacAddress[MacPosition] == WlanFound[Loop1UInt16].MacAddress[MacPosition]) && (MacPosition < 6)) ++MacPosition;
-          if ((MacPosition < 6) && (WlanFound[Loop2UInt16].MacAddress[MacPosition] < WlanFound[Loop1UInt16].MacAddress[MacPosition]))
-          {
-            // printf("[%5u] - Inverting\r", __LINE__);
-            reverse_order(Loop1UInt16, Loop2UInt16);
-          }
-        }
-      }
+  HttpBenchDone   = 0;
+  HttpBenchErrors = 0;
+  TimeStamp = time_us_64();
+  for (Sent = 0; Sent < Count; )
+  {
+    /* Except when pipelining, wait for the response before sending the next request. */
+    if ((Mode != HTTP_BENCH_PIPELINE) && (HttpBenchDone < Sent))
+    {
+      if ((time_us_64() - TimeStamp) > (HTTP_BENCH_MSEC * 1000ull)) break;
+      wifi_sleep_ms(1);
+      continue;
+    }
 
-    break;
+    ReturnCode = wifi_http_request(&Request);
+    if (ReturnCode == -2)
+    {
+      /* All request slots in use: wait for a response. */
+      wifi_sleep_ms(1);
+      continue;
+    }
+    if (ReturnCode != 0) break;
+    ++Sent;
   }
 
-  // log_info(__LINE__, __func__, "Exiting sort_results().\r");
+  while ((HttpBenchDone < Sent) && ((time_us_64() - TimeStamp) < (HTTP_BENCH_MSEC * 1000ull))) wifi_sleep_ms(1);
+  HttpBenchErrors += (Sent - HttpBenchDone) + (Count - Sent);
 
-  return;
+  return (time_us_64() - TimeStamp);
 }
 
 
 
 
+
 /* $PAGE */
-/* $TITLE=term_menu()) */
+/* $TITLE=http_bench_producer(). */
 /* ============================================================================================================================================================= *\
-                                          Terminal menu when a CDC USB connection is detected during power up sequence.
+                        Body of the chunked upload of the HTTP client benchmark: HTTP_BENCH_UPLOAD bytes, given as TCP has room for them.
+                                                         NOTE: Called from lwIP context. Must not block.
 \* ============================================================================================================================================================= */
-void term_menu(struct struct_wifi *StructWiFi)
+INT32 http_bench_producer(UCHAR *Buffer, UINT16 Size, void *Context)
 {
-  UCHAR String[33];
+  if (HttpBenchProduced >= HTTP_BENCH_UPLOAD) return -1;
 
-  UINT8 Loop1UInt16;
-  UINT8 Menu;
+  if (Size > (HTTP_BENCH_UPLOAD - HttpBenchProduced)) Size = HTTP_BENCH_UPLOAD - HttpBenchProduced;
+  memset(Buffer, 'A' + ((HttpBenchProduced / HTTP_CHUNK_SIZE) % 26), Size);
+  HttpBenchProduced += Size;
 
-  ip_addr_t PingAddress;
-  ip_addr_t TestAddress;
+  return Size;
+}
 
 
-  while (1)
-  {
-    printf("\r\r\r");
-    log_info(__LINE__, __func__, "               Terminal menu\r");
-    log_info(__LINE__, __func__, "               =============\r");
-    log_info(__LINE__, __func__, "          1) - Scan Wi-Fi frequencies for available Access Points.\r");
-    log_info(__LINE__, __func__, "          2) - Logon to local network.\r");
-    log_info(__LINE__, __func__, "          3) - Display Wi-Fi network information.\r");
-    log_info(__LINE__, __func__, "          4) - Blink Picow's LED.\r");
-    log_info(__LINE__, __func__, "          5) - Re-initialize cyw43.\r");
-    log_info(__LINE__, __func__, "          6) - Ping a specific IP address.\r");
-    log_info(__LINE__, __func__, "          7) - Start a callback to monitor Wi-Fi network health.\r");
-    log_info(__LINE__, __func__, "         88) - Restart the Firmware.\r");
-    log_info(__LINE__, __func__, "         99) - Switch Pico in upload mode\r\r");
-
-    log_info(__LINE__, __func__, "               Enter your choice: ");
-    input_string(String);
-
-    /* If user pressed <Enter> only, loop back to menu. */
-    if (String[0] == 0x0D) continue;
-
-    /* If user pressed <ESC>, loop back to menu. */
-    if (String[0] == 0x1B)
-    {
-      String[0] = 0x00;
-      printf("\r\r\r");
 
-      return;
-    }
 
 
-    /* User pressed a menu option, execute it. */
-    Menu = atoi(String);
+/* $PAGE */
+/* $TITLE=httpd_escape(). */
+/* ============================================================================================================================================================= *\
+                 Copy a string into a buffer of Size bytes (end-of-string included), escaped for a JSON string (FlagJson) or for HTML text.
+                                        Characters that would not fit are dropped. Returns Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *httpd_escape(UCHAR *Buffer, UINT16 Size, const UCHAR *String, UINT8 FlagJson)
+{
+  UINT16 Length;
 
-    switch(Menu)
-    {
-       case (1):
-        /* Scan Wi-Fi frequencies of specified country to find avaible Access Points. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "NOTE: For some obscur reason, the scan must be done just after cyw43 initialization.\r");
-        log_info(__LINE__, __func__, "      Some results will not be reported on further reports once network login has been done\r");
-        log_info(__LINE__, __func__, "      You can select the menu option to re-initialize the cyw43.\r");
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-
-        log_info(__LINE__, __func__, "Scan Wi-Fi frequencies to find available Access Points.\r");
-        log_info(__LINE__, __func__, "=======================================================\r\r");
-        scan_wifi();
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-        printf("\r\r");
-      break;
+  UCHAR Escape[8];
+
+
+  Length = 0;
+  for (; *String != 0x00; ++String)
+  {
+    if (FlagJson && ((*String == '"') || (*String == '\\')))
+      sprintf(Escape, "\\%c", *String);
+    else if (FlagJson && (*String < 0x20))
+      sprintf(Escape, "\\u%04X", *String);
+    else if (!FlagJson && ((*String == '&') || (*String == '<') || (*String == '>') || (*String == '"')))
+      sprintf(Escape, "&#%u;", *String);
+    else
+    {
+      Escape[0] = *String;
+      Escape[1] = 0x00;
+    }
+
+    if ((Length + strlen(Escape)) >= Size) break;
+    strcpy(&Buffer[Length], Escape);
+    Length += strlen(Escape);
+  }
+  Buffer[Length] = 0x00;
+
+  return Buffer;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_rssi(). */
+/* ============================================================================================================================================================= *\
+                     Return the RSSI of the Wi-Fi link for the HTTP status server. cyw43 is not queried from lwIP context: the value returned
+                     is the one of the last read, and a new read is queued to the cooperative scheduler when it is older than HTTPD_RSSI_MSEC.
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+INT32 httpd_rssi(void)
+{
+  if ((HttpdRssiPending == FLAG_OFF) && ((time_us_64() - HttpdRssiTime) > (HTTPD_RSSI_MSEC * 1000ull)))
+  {
+    HttpdRssiPending = FLAG_ON;
+    if (wifi_sched_call(httpd_rssi_refresh, NULL) != 0) HttpdRssiPending = FLAG_OFF;
+  }
+
+  return HttpdRssi;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_rssi_refresh(). */
+/* ============================================================================================================================================================= *\
+                                       Read the RSSI of the Wi-Fi link for the HTTP status server (deferred call, see httpd_rssi()).
+\* ============================================================================================================================================================= */
+void httpd_rssi_refresh(void *Arg)
+{
+  INT32 Rssi;
+
+
+  Rssi = 0;
+  if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP) cyw43_wifi_get_rssi(&cyw43_state, &Rssi);
+  HttpdRssi        = Rssi;
+  HttpdRssiTime    = time_us_64();
+  HttpdRssiPending = FLAG_OFF;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_scan(). */
+/* ============================================================================================================================================================= *\
+                    Render handler of the HTTP status server for the results of the last scan: "/scan.json" (opening, one item per network,
+                                                  closing) or the "scan" tag of info.shtml (one table row per network).
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+INT16 httpd_scan(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context)
+{
+  UINT8 FlagJson;
+
+  UINT16 Entry;
+
+  UCHAR Mac[WIFI_MAC_STRING_SIZE];
+  UCHAR NetworkName[sizeof(WlanFound[0].NetworkName) * 6];  // worst case of httpd_escape().
+
+
+  /* Scan table starts at entry 1 and ends at the first entry without channel. */
+  FlagJson = (Name[0] == '/');
+  if (FlagJson && (Item == 0)) return snprintf(Buffer, Size, "{\"networks\":[");
+  Entry = FlagJson ? Item : Item + 1;
+
+  if ((Entry < MAX_NETWORKS) && (WlanFound[Entry].Channel != 0))
+  {
+    httpd_escape(NetworkName, sizeof(NetworkName), WlanFound[Entry].NetworkName, FlagJson);
+    wifi_format_mac(Mac, WlanFound[Entry].MacAddress, ':');
+    if (FlagJson)
+      return snprintf(Buffer, Size, "%s{\"ssid\":\"%s\",\"rssi\":%d,\"channel\":%u,\"mac\":\"%s\",\"security\":%u}", (Entry == 1) ? "" : ",",
+                      NetworkName, WlanFound[Entry].SignalStrength, WlanFound[Entry].Channel, Mac, WlanFound[Entry].Security);
+    else
+      return snprintf(Buffer, Size, "<tr><td>%s</td><td>%d</td><td>%u</td><td>%s</td></tr>\n", NetworkName, WlanFound[Entry].SignalStrength,
+                      WlanFound[Entry].Channel, Mac);
+  }
+
+  /* JSON is closed by one more item, past the last network. */
+  if (FlagJson && (Entry <= MAX_NETWORKS) && ((Entry == 1) || (WlanFound[Entry - 1].Channel != 0)))
+    return snprintf(Buffer, Size, "]}");
+
+  return -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_status(). */
+/* ============================================================================================================================================================= *\
+                         Render handler of the HTTP status server for "/status.json": network information, then counters (two items).
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+INT16 httpd_status(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context)
+{
+  INT Link;
+
+  UCHAR Address[WIFI_IP_STRING_SIZE];
+  UCHAR Mac[WIFI_MAC_STRING_SIZE];
+  UCHAR NetworkName[sizeof(((struct struct_wifi *)0)->NetworkName) * 6];  // worst case of httpd_escape().
+
+  struct struct_httpd_stats HttpdStats;
+  struct struct_wifi *StructWiFi;
+  struct struct_wifi_stats Stats;
+
+
+  StructWiFi = (struct struct_wifi *)Context;
+
+  switch (Item)
+  {
+    case (0):
+      Link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+      httpd_escape(NetworkName, sizeof(NetworkName), StructWiFi->NetworkName, FLAG_ON);
+      return snprintf(Buffer, Size, "{\"host\":\"%s\",\"ssid\":\"%s\",\"ip\":\"%s\",\"mac\":\"%s\",\"link\":\"%s\",\"rssi\":%ld,\"health\":%u,\"uptime\":%lu,",
+                      StructWiFi->ExtraHostName, NetworkName, wifi_format_ip(Address, &StructWiFi->PicoIPAddress),
+                      wifi_format_mac(Mac, StructWiFi->MacAddress, ':'), (Link == CYW43_LINK_UP) ? "up" : (Link < 0) ? "failed" : "down",
+                      httpd_rssi(), (StructWiFi->FlagHealth == FLAG_ON), to_ms_since_boot(get_absolute_time()));
+
+    case (1):
+      wifi_stats_get(&Stats);
+      wifi_httpd_get_stats(&HttpdStats);
+      return snprintf(Buffer, Size, "\"errors\":%lu,\"linkdown\":%lu,\"reconnect\":%lu,\"heap\":%lu,\"heapsize\":%lu,\"requests\":%lu}",
+                      StructWiFi->TotalErrors, StructWiFi->LinkDownCount, StructWiFi->ReconnectCount, Stats.HeapUsed, Stats.HeapSize,
+                      HttpdStats.Requests);
+
+    default:
+    break;
+  }
+
+  return -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tag(). */
+/* ============================================================================================================================================================= *\
+                               Render handler of the HTTP status server for the single-value tags of info.shtml (one item each).
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+INT16 httpd_tag(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context)
+{
+  UCHAR Address[WIFI_IP_STRING_SIZE];
+  UCHAR NetworkName[sizeof(((struct struct_wifi *)0)->NetworkName) * 5];  // worst case of httpd_escape().
+
+  struct struct_wifi *StructWiFi;
+
+
+  if (Item != 0) return -1;
+
+  StructWiFi = (struct struct_wifi *)Context;
+
+  if (strcmp(Name, "errors") == 0)
+    return snprintf(Buffer, Size, "%lu", StructWiFi->TotalErrors);
+
+  if (strcmp(Name, "host") == 0)
+    return snprintf(Buffer, Size, "%s", httpd_escape(NetworkName, sizeof(NetworkName), StructWiFi->ExtraHostName, FLAG_OFF));
+
+  if (strcmp(Name, "ip") == 0)
+    return snprintf(Buffer, Size, "%s", wifi_format_ip(Address, &StructWiFi->PicoIPAddress));
+
+  if (strcmp(Name, "rssi") == 0)
+    return snprintf(Buffer, Size, "%ld", httpd_rssi());
+
+  if (strcmp(Name, "ssid") == 0)
+    return snprintf(Buffer, Size, "%s", httpd_escape(NetworkName, sizeof(NetworkName), StructWiFi->NetworkName, FLAG_OFF));
+
+  if (strcmp(Name, "uptime") == 0)
+    return snprintf(Buffer, Size, "%lu", to_ms_since_boot(get_absolute_time()) / 1000);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=input_string(). */
+/* ============================================================================================================================================================= *\
+                                          Read a string from stdin into a buffer of Size bytes (end-of-string included).
+                           While waiting for keystrokes, the Wi-Fi stack and the other tasks of the cooperative scheduler keep running,
+                                                         and the core sleeps when there is nothing to do.
+\* ============================================================================================================================================================= */
+void input_string(UCHAR *String, UINT16 Size)
+{
+  UINT8 FlagLocalDebug = FLAG_OFF;
+
+
+  if (FlagLocalDebug) printf("Entering input_string().\r");
+
+  /* Lines are typed and edited in Pico-WiFi-Console; String never receives more than Size - 1 characters. */
+  wifi_console_read_line(String, Size);
+
+  if (FlagLocalDebug) printf("Exiting input_string().\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info()) */
+/* ============================================================================================================================================================= *\
+                                                            Log info to log file through Pico UART or CDC USB.
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  UCHAR Dum1Str[256];
+  UCHAR Line[512];
+  UCHAR TimeStamp[128];
+
+  UINT Length;
+  UINT StartChar;
+
+  va_list argp;
+
+
+  /* Transfer the text to print to variable Dum1Str */
+  va_start(argp, Format);
+  vsnprintf(Dum1Str, sizeof(Dum1Str), Format, argp);
+  va_end(argp);
+
+  /* Trap special control code for <HOME>. Replace "home" by appropriate control characters for "Home" on a VT101. */
+  if (strcmp(Dum1Str, "home") == 0)
+  {
+    Dum1Str[0] = 0x1B; // ESC code
+    Dum1Str[1] = '[';
+    Dum1Str[2] = 'H';
+    Dum1Str[3] = 0x00;
+  }
+
+  /* Trap special control code for <CLS>. Replace "cls" by appropriate control characters for "Clear screen" on a VT101. */
+  if (strcmp(Dum1Str, "cls") == 0)
+  {
+    Dum1Str[0] = 0x1B; // ESC code
+    Dum1Str[1] = '[';
+    Dum1Str[2] = '2';
+    Dum1Str[3] = 'J';
+    Dum1Str[4] = 0x00;
+  }
+
+  /* Time stamp will not be printed if first character is a '-' (for title line when starting debug, for example),
+     or if first character is a line feed '\r' when we simply want add line spacing in the debug log,
+     or if first character is the beginning of a control stream (for example 'Home' or "Clear screen'). */
+  Length = 0;
+  if ((Dum1Str[0] != '-') && (Dum1Str[0] != '\r') && (Dum1Str[0] != 0x1B) && (Dum1Str[0] != '|'))
+  {
+    /* Line number, then function name padded to 25 characters. */
+    Length = sprintf(Line, "[%7u] - [%s]%*s- ", LineNumber, FunctionName, (strlen(FunctionName) < 25) ? (int)(25 - strlen(FunctionName)) : 0, "");
+
+    /* Retrieve current time stamp (available once SNTP has synchronized, kept across Wi-Fi reconnections). */
+    if (wifi_sntp_date_stamp(TimeStamp) == 0)
+      Length += sprintf(&Line[Length], "%s - ", TimeStamp);
+  }
+
+  /* Send the whole line through stdout in a single transfer. */
+  Length += snprintf(&Line[Length], sizeof(Line) - Length, "%s", Dum1Str);
+  if (Length >= sizeof(Line)) Length = sizeof(Line) - 1;
+  wifi_console_write(Line, Length);
+
+  /* Copy the line to the shell sessions running a command. */
+  wifi_shell_mirror(Line, Length);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main_task(). */
+/* ============================================================================================================================================================= *\
+                                                      FreeRTOS task running the main program (see beginning of main()).
+\* ============================================================================================================================================================= */
+void main_task(void *Parameters)
+{
+  main();
+
+#if PICO_CYW43_ARCH_FREERTOS
+  vTaskDelete(NULL);  // a task must not return.
+#endif  // PICO_CYW43_ARCH_FREERTOS
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=network_logon(). */
+/* ============================================================================================================================================================= *\
+                                                                   Logon to local network.
+                         The connection itself runs as a task: the menu task receives SCHED_EVENT_DONE when it completes (see network_logon_done()).
+\* ============================================================================================================================================================= */
+INT16 network_logon(struct struct_wifi *StructWiFi)
+{
+  UCHAR String[65];
+
+
+  /* --------------------------------------------------------------------------------------------------------------------------- *\
+                                       Give an opportunity for user to change network nanme (SSID).
+  \* --------------------------------------------------------------------------------------------------------------------------- */
+  log_info(__LINE__, __func__, "Current network name is <%s>\r", StructWiFi->NetworkName);
+  log_info(__LINE__, __func__, "Enter new network name or <Enter> to keep current one: ");
+  input_string(String, sizeof(String));
+  if ((String[0] != 0x0D) && (String[0] != 0x1B))
+  {
+    strcpy(StructWiFi->NetworkName, String);
+    log_info(__LINE__, __func__, "Network name has been changed to: <%s>.\r", StructWiFi->NetworkName);
+  }
+  else
+  {
+    log_info(__LINE__, __func__, "Network name has not been changed: <%s>.\r", StructWiFi->NetworkName);
+  }
+  log_info(__LINE__, __func__, "Press <Enter> to continue: ");
+  input_string(String, sizeof(String));
+
+
+
+  /* --------------------------------------------------------------------------------------------------------------------------- *\
+                                      Give an opportunity for user to change network password.
+  \* --------------------------------------------------------------------------------------------------------------------------- */
+  printf("\r\r");
+  log_info(__LINE__, __func__, "Current network password is <%s>\r", StructWiFi->NetworkPassword);
+  log_info(__LINE__, __func__, "Enter new network password or <Enter> to keep current one: ");
+  input_string(String, sizeof(String));
+  if ((String[0] != 0x0D) && (String[0] != 0x1B))
+  {
+    strcpy(StructWiFi->NetworkPassword, String);
+    log_info(__LINE__, __func__, "Network password has been changed to: <%s>.\r", StructWiFi->NetworkPassword);
+  }
+  else
+  {
+    log_info(__LINE__, __func__, "Network password has not been changed: <%s>.\r", StructWiFi->NetworkPassword);
+  }
+  log_info(__LINE__, __func__, "Press <Enter> to continue: ", __LINE__);
+  input_string(String, sizeof(String));
+
+
+
+  /* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                     Establish WiFi connection.
+  \* --------------------------------------------------------------------------------------------------------------------------- */
+  printf("\r\r");
+  log_info(__LINE__, __func__, "Trying to establish Wi-Fi connection.\r");
+  if (wifi_connect_start(StructWiFi, MenuTask) != 0)
+  {
+    log_info(__LINE__, __func__, "A Wi-Fi connection is already in progress.\r");
+    return -1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=network_logon_done(). */
+/* ============================================================================================================================================================= *\
+                                     Report the result of the logon to local network, once the connection task has completed.
+\* ============================================================================================================================================================= */
+void network_logon_done(struct struct_wifi *StructWiFi)
+{
+  if (StructWiFi->FlagHealth == FLAG_OFF)
+  {
+    log_info(__LINE__, __func__, "Error while trying to establish a Wi-Fi connection.\r");
+    return;
+  }
+
+  log_info(__LINE__, __func__, "Wi-Fi connection established successfully.\r");
+  FlagLogon = FLAG_ON;
+
+  /* Credentials that work are kept for next start-up (nothing is written if they did not change). */
+  if ((wifi_config_set_string(CONFIG_KEY_SSID, StructWiFi->NetworkName) != 0) || (wifi_config_set_string(CONFIG_KEY_PASSWORD, StructWiFi->NetworkPassword) != 0))
+    log_info(__LINE__, __func__, "Failed to save network credentials to flash.\r");
+  wifi_display_info(StructWiFi);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=print_bench(). */
+/* ============================================================================================================================================================= *\
+                      Console output benchmark: print CONSOLE_BENCH_LINES lines of the scan table, cycling through the Access Points found,
+                       and return the number of lines per second. Mode 0: one printf() per field, as before. Mode 1: one transfer per line.
+                                               Mode 2: lines batched in transfers of up to CONSOLE_OUT_SIZE bytes.
+\* ============================================================================================================================================================= */
+UINT32 print_bench(UINT8 Mode)
+{
+  UINT16 Entry;
+  UINT16 Loop1UInt16;
+
+  UINT64 Elapsed;
+
+
+  if (Mode == 2) wifi_console_batch_begin();
+
+  Entry   = 1;
+  Elapsed = time_us_64();
+  for (Loop1UInt16 = 0; Loop1UInt16 < CONSOLE_BENCH_LINES; ++Loop1UInt16)
+  {
+    if (Mode == 0)
+      print_single_entry_legacy(Entry);
+    else
+      print_single_entry(Entry);
+
+    ++Entry;
+    if ((Entry >= MAX_NETWORKS) || (WlanFound[Entry].Channel == 0)) Entry = 1;
+  }
+
+  if (Mode == 2) wifi_console_batch_end();
+  Elapsed = time_us_64() - Elapsed;
+
+  if (Elapsed == 0) return 0;
+  return (UINT32)(((UINT64)CONSOLE_BENCH_LINES * 1000000ull) / Elapsed);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=print_result(). */
+/* ============================================================================================================================================================= *\
+                                                                  Print results of the IP scan process.
+\* ============================================================================================================================================================= */
+void print_results(UINT8 SortOrder)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+
+
+  /* Machine-readable export instead of the text table (see option 19). */
+  if (wifi_export_get_mode() != EXPORT_MODE_TEXT)
+  {
+    export_results();
+    return;
+  }
+
+  /* Lines of the table go out in a few large transfers (see Pico-WiFi-Console.c). */
+  wifi_console_batch_begin();
+
+  /* Display  header. */
+  log_info(__LINE__, __func__, "==================================================================================================================================\r");
+  log_info(__LINE__, __func__, "                                                  Results of Access Points scan.\r");
+
+  switch (SortOrder)
+  {
+    case (1):
+      log_info(__LINE__, __func__, "                                             Listed in the order they were scanned.\r");
+    break;
+  
+    case (2):
+      log_info(__LINE__, __func__, "                                         Results have been sorted by MAC address order.\r");
+    break;
+  }
+
+  log_info(__LINE__, __func__, "==================================================================================================================================\r");
+  log_info(__LINE__, __func__, "         Network                        Signal    Channel       MAC             ------------------   Security   ------------------\r");
+  log_info(__LINE__, __func__, "          name                         strength               address\r");
+  log_info(__LINE__, __func__, "==================================================================================================================================\r");
+
+  for (Loop1UInt16 = 1; WlanFound[Loop1UInt16].Channel; ++Loop1UInt16)
+    print_single_entry(Loop1UInt16);
+
+  log_info(__LINE__, __func__, "==================================================================================================================================\r\r\r");
+
+  wifi_console_batch_end();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=print_single_entry(). */
+/* ============================================================================================================================================================= *\
+                                                                      Print a single entry.
+\* ============================================================================================================================================================= */
+void print_single_entry(UINT16 EntryNumber)
+{
+  UCHAR Row[SCAN_ROW_SIZE];
+
+
+  /* Whole line in a single log_info() call. */
+  format_scan_row(Row, EntryNumber, WlanFound[EntryNumber].NetworkName, WlanFound[EntryNumber].SignalStrength, WlanFound[EntryNumber].Channel,
+                  WlanFound[EntryNumber].MacAddress, WlanFound[EntryNumber].Security);
+  log_info(__LINE__, __func__, "%s", Row);
+
+#if 0
+  switch (WlanFound[EntryNumber].Security)
+  {
+    case (0):
+      printf("Open network");
+    break;
+
+    case (0x00200002):
+      printf("Encrypted      WPA");
+    break;
+
+    case (0x00400004):
+      printf("Encrypted      WPA2");
+    break;
+
+    case (0x00400006):
+      printf("Encrypted      WPA / WPA2 mixed");
+    break;
+
+    case (0x01000004):
+      printf("Encrypted      WPA3 / AES");
+    break;
+
+    case (0x01400004):
+      printf("Encrypted      WPA2 / WPA3");
+    break;
+
+    default:
+      printf("security mode not found: 0x%X", WlanFound[EntryNumber].Security);
+    break;
+  }
+#endif  // 0
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=print_single_entry_legacy(). */
+/* ============================================================================================================================================================= *\
+                     Print a single entry with one printf() per field and per MAC byte, and the log_info() header padded one space at a time,
+                          the way it was printed before the console writer. Only used by the console output benchmark, as the reference.
+\* ============================================================================================================================================================= */
+void print_single_entry_legacy(UINT16 EntryNumber)
+{
+  UINT16 Loop1UInt16;
+
+
+  printf("[%7u] - ", __LINE__);
+  printf("[%s]", __func__);
+  for (Loop1UInt16 = strlen(__func__); Loop1UInt16 < 25; ++Loop1UInt16)
+    printf(" ");
+  printf("- ");
+
+  printf("%3u)   %-32s  %4d      %3u   ", EntryNumber, WlanFound[EntryNumber].NetworkName, WlanFound[EntryNumber].SignalStrength, WlanFound[EntryNumber].Channel);
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < 6; ++Loop1UInt16)
+  {
+    printf("%02X", WlanFound[EntryNumber].MacAddress[Loop1UInt16]);
+    if (Loop1UInt16 < 5) printf(":");
+  }
+
+  printf("     %u   ", WlanFound[EntryNumber].Security);
+  printf("\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_producer(). */
+/* ============================================================================================================================================================= *\
+                  Body of a batch of the telemetry queue: JSON array of its records, read from flash as TCP has room for them (no copy in RAM).
+                            Records are JSON objects (see task_queue()). State is kept in QueueRecord, QueueOffset and QueueSeparator.
+                                                         NOTE: Called from lwIP context. Must not block.
+\* ============================================================================================================================================================= */
+INT32 queue_producer(UCHAR *Buffer, UINT16 Size, void *Context)
+{
+  UINT16 Chunk;
+  UINT16 Length;
+
+  const struct struct_queue_batch *Batch;
+
+
+  Batch  = (const struct struct_queue_batch *)Context;
+  Length = 0;
+
+  while ((Length < Size) && (QueueRecord <= Batch->Count))
+  {
+    /* '[' before the first record, ',' between records, ']' after the last one. */
+    if (QueueSeparator == FLAG_ON)
+    {
+      Buffer[Length++] = (QueueRecord == 0) ? '[' : (QueueRecord == Batch->Count) ? ']' : ',';
+      QueueSeparator   = FLAG_OFF;
+      if (QueueRecord == Batch->Count) ++QueueRecord;
+      continue;
+    }
+
+    Chunk = Batch->Length[QueueRecord] - QueueOffset;
+    if (Chunk > (Size - Length)) Chunk = Size - Length;
+    memcpy(&Buffer[Length], &Batch->Data[QueueRecord][QueueOffset], Chunk);
+    Length      += Chunk;
+    QueueOffset += Chunk;
+
+    if (QueueOffset == Batch->Length[QueueRecord])
+    {
+      ++QueueRecord;
+      QueueOffset    = 0;
+      QueueSeparator = FLAG_ON;
+    }
+  }
+
+  return (Length) ? Length : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_send(). */
+/* ============================================================================================================================================================= *\
+           Sender of the telemetry queue: post a batch to the HTTP server (tools/wifi_http_sink.py) as one chunked request on a kept-alive connection.
+                                                      The outcome is given to the queue by callback_queue().
+\* ============================================================================================================================================================= */
+INT16 queue_send(const struct struct_queue_batch *Batch, void *Context)
+{
+  struct struct_http_request Request;
+
+
+  memset(&Request, 0x00, sizeof(Request));
+  ip4addr_aton(HTTP_SERVER_IP, &Request.Address);
+  Request.Port     = HTTP_SERVER_PORT;
+  Request.Method   = "POST";
+  Request.Path     = "/telemetry";
+  Request.Headers  = "Content-Type: application/json\r\n";
+  Request.Producer = queue_producer;
+  Request.Callback = callback_queue;
+  Request.Context  = (void *)Batch;
+
+  QueueRecord    = 0;
+  QueueOffset    = 0;
+  QueueSeparator = FLAG_ON;
+
+  return (wifi_http_request(&Request) == 0) ? 0 : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=reverse_order(). */
+/* ============================================================================================================================================================= *\
+                                                                  Reverse order of two specific results.
+\* ============================================================================================================================================================= */
+void reverse_order(UINT16 Position1, UINT16 Position2)
+{
+  UCHAR *PointerFrom;
+  UCHAR *PointerTo;
+
+  UINT16 Loop1UInt16;
+
+
+  /* Use first vector position [0] for temporary storage. */
+  PointerFrom = (UCHAR *)&WlanFound[Position1];
+  PointerTo   = (UCHAR *)&WlanFound[0];
+  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
+    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
+
+  /* Transfer first member. */
+  PointerFrom = (UCHAR *)&WlanFound[Position2];
+  PointerTo   = (UCHAR *)&WlanFound[Position1];
+  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
+    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
+
+  /* Transfer other member. */
+  PointerFrom = (UCHAR *)&WlanFound[0];
+  PointerTo   = (UCHAR *)&WlanFound[Position2];
+  for (Loop1UInt16 = 0; Loop1UInt16 < sizeof(WlanFound[0]); ++Loop1UInt16)
+    PointerTo[Loop1UInt16] = PointerFrom[Loop1UInt16];
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=scan_result(). */
+/* ============================================================================================================================================================= *\
+                                                                  Retrieve results of the IP scan process.
+\* ============================================================================================================================================================= */
+static int scan_results(void *env, const cyw43_ev_scan_result_t *Result)
+{
+  UCHAR Row[SCAN_ROW_SIZE];
+
+  UINT8 Loop1UInt8;
+
+
+  if (Result)
+  {
+    format_scan_row(Row, APNumber, Result->ssid, Result->rssi, Result->channel, Result->bssid, Result->auth_mode);
+    log_info(__LINE__, __func__, "%s", Row);
+
+    strcpy(WlanFound[APNumber].NetworkName, Result->ssid);
+    WlanFound[APNumber].SignalStrength = Result->rssi;
+    WlanFound[APNumber].Channel        = Result->channel;
+    WlanFound[APNumber].Security       = Result->auth_mode;
+    for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(Result->bssid); ++Loop1UInt8)
+      WlanFound[APNumber].MacAddress[Loop1UInt8] = Result->bssid[Loop1UInt8];
+
+    // printf("[%5u] = %d\r", __LINE__, Result->auth_type);
+    // printf("[%5u] = %d\r", __LINE__, Result->hidden);
+    // printf("[%5u] = %d\r", __LINE__, Result->security);
+
+    ++APNumber;
+  }
+
+
+#if 0
+  if (Result->auth_mode == CYW43_AUTH_OPEN)           printf("CYW43_AUTH_OPEN\r");
+  if (Result->auth_mode == CYW43_AUTH_WPA_TKIP_PSK)   printf("CYW43_AUTH_WPA_TKIP_PSK\r");
+  if (Result->auth_mode == CYW43_AUTH_WPA2_AES_PSK)   printf("CYW43_AUTH_WPA2_AES_PSK\r");
+  if (Result->auth_mode == CYW43_AUTH_WPA2_MIXED_PSK) printf("CYW43_AUTH_WPA2_MIXED_PSK\r");
+
+
+
+    [CYW43_EV_SET_SSID] = "SET_SSID",
+    [CYW43_EV_JOIN] = "JOIN",
+    [CYW43_EV_AUTH] = "AUTH",
+    [CYW43_EV_DEAUTH_IND] = "DEAUTH_IND",
+    [CYW43_EV_ASSOC] = "ASSOC",
+    [CYW43_EV_DISASSOC] = "DISASSOC",
+    [CYW43_EV_DISASSOC_IND] = "DISASSOC_IND",
+    [CYW43_EV_LINK] = "LINK",
+    [CYW43_EV_PSK_SUP] = "PSK_SUP",
+    [CYW43_EV_ESCAN_RESULT] = "ESCAN_RESULT",
+    [CYW43_EV_CSA_COMPLETE_IND] = "CSA_COMPLETE_IND",
+    [CYW43_EV_ASSOC_REQ_IE] = "ASSOC_REQ_IE",
+    [CYW43_EV_ASSOC_RESP_IE] = "ASSOC_RESP_IE",
+
+
+
+
+  switch ((UINT32)Result->auth_mode)
+  {
+    case (CYW43_AUTH_OPEN):
+      printf("No authorisation required\r");
+    break;
+
+    case (CYW43_AUTH_WPA_TKIP_PSK):
+      printf(" WPA authorisation\r");
+    break;
+
+    case (CYW43_AUTH_WPA2_AES_PSK):
+      printf("WPA2 authorization\r");
+    break;
+
+    case (CYW43_AUTH_WPA2_MIXED_PSK):
+      printf("WPA2/WPA mixed (currently same as CYW43_AUTH_WPA2_AES_PSK)\r");
+    break;
+
+    default:
+      printf("Authorization mode tbd: %d\r", Result->auth_mode);
+    break;
+  }
+#endif  // 0
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sort_result(). */
+/* ============================================================================================================================================================= *\
+                                                                  Sort results of the IP scan process.
+\* ============================================================================================================================================================= */
+void sort_results(UINT8 SortOrder)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+  UINT8  MacPosition;
+
+
+  // log_info(__LINE__, __func__, "Entering sort_results().\r");
+
+  switch (SortOrder)
+  {
+    case (2):
+      /* Sort by MAC address. */
+      for (Loop1UInt16 = 1; WlanFound[Loop1UInt16].Channel; ++Loop1UInt16)
+      {
+        for (Loop2UInt16 = Loop1UInt16 + 1; WlanFound[Loop2UInt16].Channel; ++Loop2UInt16)
+        {
+          /***
+          printf("[%5u] - Comparing %u and %u\r", __LINE__, Loop1UInt16, Loop2UInt16);
+          print_single_entry(Loop1UInt16);
+          print_single_entry(Loop2UInt16);
+          ***/
+
+          MacPosition = 0;
+          while((WlanFound[Loop2UInt16].MacAddress[MacPosition] == WlanFound[Loop1UInt16].MacAddress[MacPosition]) && (MacPosition < 6)) ++MacPosition;
+          if ((MacPosition < 6) && (WlanFound[Loop2UInt16].MacAddress[MacPosition] < WlanFound[Loop1UInt16].MacAddress[MacPosition]))
+          {
+            // printf("[%5u] - Inverting\r", __LINE__);
+            reverse_order(Loop1UInt16, Loop2UInt16);
+          }
+        }
+      }
+
+    break;
+  }
+
+  // log_info(__LINE__, __func__, "Exiting sort_results().\r");
+
+  return;
+}
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_boot(). */
+/* ============================================================================================================================================================= *\
+        Boot task. With headless boot (WIFI_HEADLESS), start the connection to the network as soon as the scheduler runs, without waiting for a terminal.
+                In both modes, check for a terminal connected to CDC USB after start-up: the menu and the boot timeline are then displayed for it.
+                                   The task deletes itself once the connection has completed and a terminal has been detected.
+\* ============================================================================================================================================================= */
+void task_boot(struct struct_sched_task *Task, UINT32 Events)
+{
+  struct struct_wifi *StructWiFi;
+
+
+  StructWiFi = (struct struct_wifi *)Task->Context;
+
+  if (Events & SCHED_EVENT_START)
+  {
+    if (wifi_boot_time(WIFI_BOOT_CONSOLE) != 0) Task->State |= BOOT_STATE_CONSOLE;
+
+#if WIFI_HEADLESS && (WIFI_CORE1 == 0)
+    /* Network on core 1 (WIFI_CORE1) has been started by main(). */
+    log_info(__LINE__, __func__, "Headless boot: connecting to <%s>.\r", StructWiFi->NetworkName);
+    if (wifi_connect_start(StructWiFi, Task) == 0) Task->State |= BOOT_STATE_CONNECTING;
+#endif  // WIFI_HEADLESS
+  }
+
+  /* Connection started at boot has completed. */
+  if ((Task->State & BOOT_STATE_CONNECTING) && (Events & SCHED_EVENT_DONE))
+  {
+    Task->State &= ~BOOT_STATE_CONNECTING;
+    if (StructWiFi->FlagHealth == FLAG_ON)
+    {
+      FlagLogon = FLAG_ON;
+      log_info(__LINE__, __func__, "Headless boot: connected (%llu msec after reset).\r", wifi_boot_time(WIFI_BOOT_DHCP) / 1000);
+    }
+    else
+    {
+      log_info(__LINE__, __func__, "Headless boot: failed to connect, use menu option 2 to logon.\r");
+    }
+  }
+
+  /* Terminal connected after start-up: display the boot timeline, then the menu again (unless an option is in progress). */
+  if (((Task->State & BOOT_STATE_CONSOLE) == 0) && stdio_usb_connected())
+  {
+    Task->State |= BOOT_STATE_CONSOLE;
+    wifi_boot_mark(WIFI_BOOT_CONSOLE);
+    printf("\r\r");
+    log_info(__LINE__, __func__, "Terminal connected %llu msec after reset.\r", wifi_boot_time(WIFI_BOOT_CONSOLE) / 1000);
+    wifi_boot_display();
+    if (MenuTask->State == MENU_STATE_INPUT)
+    {
+      MenuTask->State = MENU_STATE_DISPLAY;
+      wifi_sched_post(MenuTask, SCHED_EVENT_LINE);
+    }
+  }
+
+  if ((Task->State & BOOT_STATE_CONSOLE) && ((Task->State & BOOT_STATE_CONNECTING) == 0))
+  {
+    wifi_sched_delete(Task);
+    return;
+  }
+
+  wifi_sched_wait(Task, SCHED_EVENT_DONE, BOOT_CONSOLE_POLL_MSEC);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_command_ping(). */
+/* ============================================================================================================================================================= *\
+          End of a ping started by the shell "ping" command: stop the ping engine, display statistics (copied to the session) and complete the command.
+\* ============================================================================================================================================================= */
+void task_command_ping(struct struct_sched_task *Task, UINT32 Events)
+{
+  if (Events & SCHED_EVENT_TIMER)
+  {
+    ping_stop();
+    ping_display_stats();
+    wifi_shell_release((struct struct_shell_session *)Task->Context);
+    wifi_sched_delete(Task);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_menu(). */
+/* ============================================================================================================================================================= *\
+              Terminal menu task. Lines are typed and edited by the console task (Pico-WiFi-Console), which notifies the menu with SCHED_EVENT_LINE.
+                  Options run as tasks (scan, logon) notify the menu with SCHED_EVENT_DONE. The other options run to completion in term_menu();
+                     while they wait for user input (input_string()) or for the network (wifi_sleep_ms()), the other tasks keep running too.
+\* ============================================================================================================================================================= */
+void task_menu(struct struct_sched_task *Task, UINT32 Events)
+{
+  struct struct_wifi *StructWiFi;
+
+
+  StructWiFi = (struct struct_wifi *)Task->Context;
+
+  /* Operation run as a task has completed. */
+  if ((Task->State == MENU_STATE_BUSY) && (Events & SCHED_EVENT_DONE))
+  {
+    if (MenuOption == 2) network_logon_done(StructWiFi);
+    if (MenuOption == 5)
+    {
+      if (StructWiFi->FlagHealth == FLAG_ON) FlagLogon = FLAG_ON;
+      wifi_recover_display();
+    }
+    printf("\r\r");
+    Task->State = MENU_STATE_DISPLAY;
+  }
+
+  while (1)
+  {
+    if (Task->State == MENU_STATE_DISPLAY)
+    {
+      term_menu_display();
+      Task->State = MENU_STATE_INPUT;
+    }
+    if (Task->State == MENU_STATE_BUSY) break;
+
+    if (wifi_console_get_line(MenuString, sizeof(MenuString)) < 0) break;
+
+    if (Task->State == MENU_STATE_PING)
+    {
+      /* <Enter> stops the ping. */
+      wifi_sched_delete(PingTask);
+      PingTask = NULL;
+      ping_stop();
+      ping_display_stats();
+      printf("\r\r");
+      Task->State = MENU_STATE_DISPLAY;
+    }
+    else if ((MenuString[0] == 0x0D) || (MenuString[0] == 0x1B))
+    {
+      /* <Enter> or <ESC> only: display menu again. */
+      printf("\r\r\r");
+      Task->State = MENU_STATE_DISPLAY;
+    }
+    else
+    {
+      /* User pressed a menu option, execute it. */
+      MenuOption  = atoi(MenuString);
+      Task->State = term_menu(StructWiFi, MenuOption);
+    }
+  }
+
+  /* Wait for next line typed, or for completion of the operation in progress. */
+  wifi_sched_wait(Task, (Task->State == MENU_STATE_BUSY) ? SCHED_EVENT_DONE : SCHED_EVENT_LINE, MENU_POLL_MSEC);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_ping(). */
+/* ============================================================================================================================================================= *\
+                     Display ping progress every PING_REPORT_MSEC while ping is running (full statistics are displayed when ping is stopped).
+\* ============================================================================================================================================================= */
+void task_ping(struct struct_sched_task *Task, UINT32 Events)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_ping_stats PingStats;
+
+
+  if (Events & SCHED_EVENT_TIMER)
+  {
+    for (Loop1UInt8 = 0; Loop1UInt8 < ping_target_count(); ++Loop1UInt8)
+    {
+      if (ping_get_stats(Loop1UInt8, &PingStats) != 0) continue;
+      log_info(__LINE__, __func__, "<%s>: %lu / %lu received   rtt average %lu.%1lu msec   max %lu.%1lu msec\r", ipaddr_ntoa(&PingStats.Address), PingStats.Received, PingStats.Sent,
+               PingStats.RttAverage / 1000, (PingStats.RttAverage / 100) % 10, PingStats.RttMax / 1000, (PingStats.RttMax / 100) % 10);
+    }
+  }
+
+  wifi_sched_wait(Task, SCHED_EVENT_TIMER, PING_REPORT_MSEC);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_queue(). */
+/* ============================================================================================================================================================= *\
+            Telemetry queue task. Loads the queue at start-up, enqueues a sample every QUEUE_SAMPLE_MSEC while sampling is on (option 25), and drains
+              the queue while the link is up: health events (SCHED_EVENT_NETWORK) start and stop draining, completion of a batch (SCHED_EVENT_DONE)
+                sends the next one, as the rate limit of Pico-WiFi-Queue allows. Samples are kept in flash until delivered, even across a restart.
+\* ============================================================================================================================================================= */
+void task_queue(struct struct_sched_task *Task, UINT32 Events)
+{
+  UCHAR Sample[96];
+
+  UINT32 Delay;
+
+  UINT64 Now;
+
+  struct struct_queue_stats QueueStats;
+  struct struct_wifi *StructWiFi;
+  struct struct_wifi_stats Stats;
+
+
+  StructWiFi = (struct struct_wifi *)Task->Context;
+
+  if (Events & SCHED_EVENT_START)
+  {
+    if (wifi_queue_init() != 0)
+    {
+      QueueTask = NULL;
+      wifi_sched_delete(Task);
+      return;
+    }
+    wifi_queue_get_stats(&QueueStats);
+    log_info(__LINE__, __func__, "Telemetry queue: %lu record(s) waiting to be sent, loaded from flash in %lu usec.\r", QueueStats.PendingRecords, QueueStats.LoadUsec);
+    QueueSampleTime = time_us_64() + (QUEUE_SAMPLE_MSEC * 1000ull);
+  }
+
+  /* Drain while the link is up. */
+  wifi_queue_get_stats(&QueueStats);
+  if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP)
+  {
+    if (QueueStats.FlagDraining == FLAG_OFF) wifi_queue_start(queue_send, NULL);
+  }
+  else
+  {
+    wifi_queue_stop();
+  }
+
+  /* Sample of the link state, sent now or later. */
+  Now = time_us_64();
+  if (Now >= QueueSampleTime)
+  {
+    QueueSampleTime = Now + (QUEUE_SAMPLE_MSEC * 1000ull);
+    if (QueueSampling == FLAG_ON)
+    {
+      wifi_stats_get(&Stats);
+      snprintf(Sample, sizeof(Sample), "{\"uptime\":%lu,\"rssi\":%ld,\"heap\":%lu,\"linkdown\":%lu}", to_ms_since_boot(get_absolute_time()), httpd_rssi(),
+               Stats.HeapUsed, StructWiFi->LinkDownCount);
+      wifi_queue_push(Sample, strlen(Sample));
+      wifi_queue_flush();
+    }
+  }
+
+  /* Wake up when the next batch is due, or to check the link and take the next sample. */
+  Delay = wifi_queue_service();
+  if ((Delay == 0) || (Delay > QUEUE_POLL_MSEC)) Delay = QUEUE_POLL_MSEC;
+  wifi_sched_wait(Task, SCHED_EVENT_NETWORK | SCHED_EVENT_DONE, Delay);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=task_scan(). */
+/* ============================================================================================================================================================= *\
+                                                       Scan Wi-Fi frequencies for available Access Points.
+                     The scan is started, then its end is checked every SCAN_POLL_MSEC. Results are displayed and the menu task is notified.
+\* ============================================================================================================================================================= */
+void task_scan(struct struct_sched_task *Task, UINT32 Events)
+{
+  INT16 ReturnCode;
+
+  cyw43_wifi_scan_options_t ScanOptions = {0};
+
+
+  switch (Task->State)
+  {
+    case (0):
+      APNumber = 1;
+
+      /* Wipe WlanFound structure on entry. */
+      log_info(__LINE__, __func__, "sizeof(WlanFound): %u\r", sizeof(WlanFound));
+      wipe_results();
+
+
+      /* Scan Wi-Fi frequency to find available Access Points. */
+      log_info(__LINE__, __func__, "========================================================================================\r");
+      log_info(__LINE__, __func__, "                  Scan Wi-Fi spectrum to find available Access Points.\r");
+      log_info(__LINE__, __func__, "                         Listed in the order they were scanned.\r");
+      log_info(__LINE__, __func__, "               Using frequencies used in the following country: %c%c Rev: %u\r", COUNTRY_CODE, (COUNTRY_CODE >> 8), (COUNTRY_CODE >> 16));
+      log_info(__LINE__, __func__, "========================================================================================\r");
+      log_info(__LINE__, __func__, "         Network                        Signal    Channel       MAC        Security\r");
+      log_info(__LINE__, __func__, "          name                         strength               address\r");
+      log_info(__LINE__, __func__, "========================================================================================\r");
+
+      ReturnCode = cyw43_wifi_scan(&cyw43_state, &ScanOptions, NULL, scan_results);
+      if (ReturnCode != 0)
+      {
+        log_info(__LINE__, __func__, "Error while trying to scan Wi-Fi spectrum...\r");
+        break;
+      }
+
+      /* Wait until the scan is over. */
+      Task->State = 1;
+      wifi_sched_wait(Task, SCHED_EVENT_TIMER, SCAN_POLL_MSEC);
+    return;
+
+    default:
+      if (cyw43_wifi_scan_active(&cyw43_state) == true)
+      {
+        wifi_sched_wait(Task, SCHED_EVENT_TIMER, SCAN_POLL_MSEC);
+        return;
+      }
+      log_info(__LINE__, __func__, "========================================================================================\r\r\r\r");
+
+      print_results(1);
+      sort_results(2);
+      print_results(2);
+      wipe_results();
+    break;
+  }
+
+  /* Complete the shell command which started the scan, or notify the menu. */
+  if (Task->Context != NULL)
+    wifi_shell_release((struct struct_shell_session *)Task->Context);
+  else
+    wifi_sched_post(MenuTask, SCHED_EVENT_DONE);
+  wifi_sched_delete(Task);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=term_menu()) */
+/* ============================================================================================================================================================= *\
+                                         Execute a terminal menu option (see task_menu()). Return the next state of the menu task.
+\* ============================================================================================================================================================= */
+UINT8 term_menu(struct struct_wifi *StructWiFi, UINT8 Menu)
+{
+  UCHAR String[33];
+  UCHAR Value[CONFIG_MAX_VALUE + 1];
 
-      case (2):
-        /* Logon to local network using credentials specified in environmental variables. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Logon to local network.\r");
-        log_info(__LINE__, __func__, "=======================\r");
-        network_logon(StructWiFi);
-        wifi_display_info(StructWiFi);
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-        printf("\r\r");
-      break;
+  INT16 Key;
 
-      case (3):
-        /* Display Wi-Fi network information. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Display Wi-Fi network information.\r");
-        log_info(__LINE__, __func__, "==================================\r");
-        if (FlagLogon == FLAG_OFF)
-        {
-          log_info(__LINE__, __func__, "NOTE: Logon to local network has not been done yet.\r");
-          log_info(__LINE__, __func__, "      Network information will be wrong / incomplete.\r");
-        }
+  UINT8 FlagLoad;
+  UINT8 Loop1UInt8;
+  UINT8 NextState;
+  UINT8 QoS;
+  UINT8 Tier;
+
+  UINT16 IntervalMsec;
+  UINT16 Loop1UInt16;
+  UINT16 MessageCount;
+  UINT16 RecordLength;
+
+  UINT32 ExportBytes;
+  UINT32 IdleLoops;
+  UINT32 LinesPerSecond[3];
+  UINT32 NsecPerRow[2];
+  UINT32 LoadLoops;
+  UINT32 RecordCount;
+
+  UINT64 TimeStamp;
+
+  ip_addr_t PingAddress;
+  ip_addr_t TestAddress;
+
+  struct struct_console_stats ConsoleStats;
+  struct struct_iperf_settings IperfSettings;
+  struct struct_mqtt_settings  MqttSettings;
+  struct struct_mqtt_stats     MqttStats;
+  struct struct_wifi_power_probe PowerProbe[WIFI_POWER_PROFILES];
+  struct struct_core1_jitter     Jitter;
+  struct struct_stream_bench   StreamBench;
+
+
+  NextState = MENU_STATE_DISPLAY;
+
+  switch(Menu)
+  {
+     case (1):
+      /* Scan Wi-Fi frequencies of specified country to find avaible Access Points. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "NOTE: For some obscur reason, the scan must be done just after cyw43 initialization.\r");
+      log_info(__LINE__, __func__, "      Some results will not be reported on further reports once network login has been done\r");
+      log_info(__LINE__, __func__, "      You can select the menu option to re-initialize the cyw43.\r");
+      log_info(__LINE__, __func__, "Press <Enter> to continue: ");
+      input_string(String, sizeof(String));
+
+      log_info(__LINE__, __func__, "Scan Wi-Fi frequencies to find available Access Points.\r");
+      log_info(__LINE__, __func__, "=======================================================\r\r");
+      if (wifi_sched_create("scan", task_scan, NULL) != NULL) NextState = MENU_STATE_BUSY;
+    break;
+
+    case (2):
+      /* Logon to local network using credentials specified in environmental variables. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Logon to local network.\r");
+      log_info(__LINE__, __func__, "=======================\r");
+      if (network_logon(StructWiFi) == 0) NextState = MENU_STATE_BUSY;
+    break;
+
+    case (3):
+      /* Display Wi-Fi network information. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Display Wi-Fi network information.\r");
+      log_info(__LINE__, __func__, "==================================\r");
+      if (FlagLogon == FLAG_OFF)
+      {
+        log_info(__LINE__, __func__, "NOTE: Logon to local network has not been done yet.\r");
+        log_info(__LINE__, __func__, "      Network information will be wrong / incomplete.\r");
+      }
+      if (wifi_export_get_mode() == EXPORT_MODE_TEXT)
+      {
         wifi_display_info(StructWiFi);
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-        printf("\r\r");
-      break;
+      }
+      else
+      {
+        wifi_export_begin();
+        wifi_export_status(StructWiFi);
+        wifi_export_end();
+      }
+      log_info(__LINE__, __func__, "Press <Enter> to continue: ");
+      input_string(String, sizeof(String));
+      printf("\r\r");
+    break;
 
-      case (4):
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Blink PicoW's LED.\r");
-        log_info(__LINE__, __func__, "==================\r");
-        wifi_blink(100, 200, 10);
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-        printf("\r\r");
-      break;
+    case (4):
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Blink PicoW's LED.\r");
+      log_info(__LINE__, __func__, "==================\r");
+      wifi_blink(100, 200, 10);
+      log_info(__LINE__, __func__, "Press <Enter> to continue: ");
+      input_string(String, sizeof(String));
+      printf("\r\r");
+    break;
 
-      case (5):
-        /* Re-init cyw43. */
+    case (5):
+      /* Recover the Wi-Fi link: cheapest tier first, full cyw43 re-init only as a last resort. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Recover Wi-Fi link.\r");
+      log_info(__LINE__, __func__, "===================\r");
+      for (Loop1UInt8 = 0; Loop1UInt8 < WIFI_RECOVER_TIERS; ++Loop1UInt8)
+        log_info(__LINE__, __func__, "Tier %u: %s.\r", Loop1UInt8 + 1, wifi_recover_tier_name(Loop1UInt8));
+      log_info(__LINE__, __func__, "A tier is only tried if the previous one failed to restore the link.\r");
+      log_info(__LINE__, __func__, "Enter first tier (<Enter> for tier 1, <ESC> to cancel): ");
+      input_string(String, sizeof(String));
+      if (String[0] == 0x1B)
+      {
+        log_info(__LINE__, __func__, "User pressed <ESC>. Wi-Fi link hasn't been recovered.\r");
         printf("\r\r");
-        log_info(__LINE__, __func__, "Re-init cyw43.\r");
-        log_info(__LINE__, __func__, "==============\r");
-        log_info(__LINE__, __func__, "Press <G> to proceed: ");
-        input_string(String);
-        if ((String[0] == 'G') || (String[0] == 'g'))
-        {
-          cyw43_arch_deinit();
-          log_info(__LINE__, __func__, "Re-initializing cyw43...\r");
-          if (wifi_init(StructWiFi))
-          {
-            log_info(__LINE__, __func__, "Failed to initialize cyw43\r");
-            return;
-          }
-          else
-          {
-            log_info(__LINE__, __func__, "Cyw43 initialization successful.\r");
-          }
-          
-          /* Set station mode. */
-          log_info(__LINE__, __func__, "Setting station mode\r\r\r");
-          cyw43_arch_enable_sta_mode();
-        }
-        else
+        break;
+      }
+
+      Tier = (String[0] == 0x0D) ? WIFI_RECOVER_REJOIN : (UINT8)(atoi(String) - 1);
+      if (Tier >= WIFI_RECOVER_TIERS)
+      {
+        log_info(__LINE__, __func__, "Invalid tier.\r\r");
+        break;
+      }
+
+      if (wifi_recover_start(StructWiFi, Tier, MenuTask) != 0)
+      {
+        log_info(__LINE__, __func__, "A Wi-Fi connection or recovery is already in progress.\r\r");
+        break;
+      }
+      NextState = MENU_STATE_BUSY;  // recovery statistics are displayed when it completes (see task_menu()).
+    break;
+
+    case (6):
+      /* Ping one or more IP addresses. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Ping one or more IP addresses.\r");
+      log_info(__LINE__, __func__, "==============================\r");
+
+      /* Enter delay between pings. */
+      IntervalMsec = PING_INTERVAL_MSEC;
+      log_info(__LINE__, __func__, "Enter delay between two pings to the same target (msec) or <Enter> to keep %u msec: ", IntervalMsec);
+      input_string(String, sizeof(String));
+      if ((String[0] != 0x0D) && (String[0] != 0x1B) && (atoi(String) > 0)) IntervalMsec = atoi(String);
+
+      /* Enter IP addresses to ping. */
+      ping_clear_targets();
+      log_info(__LINE__, __func__, "Enter up to %u IP addresses to ping, one per line, then <Enter> alone (default target is <%s>).\r", MAX_PING_TARGETS, PING_ADDRESS);
+      for (Loop1UInt8 = 0; Loop1UInt8 < MAX_PING_TARGETS; ++Loop1UInt8)
+      {
+        log_info(__LINE__, __func__, "Target %u: ", Loop1UInt8 + 1);
+        input_string(String, sizeof(String));
+        if ((String[0] == 0x0D) || (String[0] == 0x1B)) break;
+
+        if (!ip4addr_aton(String, &TestAddress))
+          log_info(__LINE__, __func__, "Invalid IP address entered... target has been ignored.\r");
+        else if (ping_target_add(&TestAddress, IntervalMsec, 0) < 0)
+          log_info(__LINE__, __func__, "Delay too short to ping one more target (echo requests would outlive the window)... target has been ignored.\r");
+      }
+
+      if (ping_target_count() == 0)
+      {
+        ip4addr_aton(PING_ADDRESS, &PingAddress);
+        if (ping_target_add(&PingAddress, IntervalMsec, 0) < 0)
         {
-          log_info(__LINE__, __func__, "User didn't press <G>. Cyw43 hasn't been re-initialized.\r");
+          log_info(__LINE__, __func__, "Delay of %u msec is too short for a %u msec time-out... aborting.\r", IntervalMsec, PING_TIMEOUT_MSEC);
+          break;
         }
-        log_info(__LINE__, __func__, "Press <Enter> to continue: ");
-        input_string(String);
-        printf("\r\r");
-      break;
+        log_info(__LINE__, __func__, "No target entered, using default IP address: <%s>.\r", ip4addr_ntoa(&PingAddress));
+      }
 
-      case (6):
-        /* Ping a apecific IP address. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Ping a specific IP address.\r");
-        log_info(__LINE__, __func__, "===========================\r");
+      printf("\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the ping procedure to work.\r\r");
+      log_info(__LINE__, __func__, "The Pico will ping all %u target(s) concurrently, every %u msec.\r", ping_target_count(), IntervalMsec);
+      log_info(__LINE__, __func__, "Loss, jitter and round-trip time statistics (p50 / p90 / p99) will be displayed when ping is stopped.\r");
+      log_info(__LINE__, __func__, "Press <G> to begin pinging: ");
+      input_string(String, sizeof(String));
+      if ((String[0] != 'G') && (String[0] != 'g'))
+      {
+        log_info(__LINE__, __func__, "User didn't press <G> to start ping procedure... aborting.\r");
+        break;
+      }
 
-        /* Enter IP address to ping. */
-        ip4addr_aton(PING_ADDRESS, &PingAddress);
-        log_info(__LINE__, __func__, "Current IP address to ping is:   <%s>\r", ip4addr_ntoa(&PingAddress));
-        log_info(__LINE__, __func__, "Enter new IP address to ping or <Enter> to keep current target IP address: ");
-        input_string(String);
-        if ((String[0] != 0x0D) && (String[0] != 0x1B))
+      if (ping_start() != 0)
+      {
+        log_info(__LINE__, __func__, "Failed to start the ping engine.\r");
+        break;
+      }
+      log_info(__LINE__, __func__, "Ping in progress... press <Enter> to stop it and display statistics.\r");
+      PingTask  = wifi_sched_create("ping", task_ping, NULL);
+      NextState = MENU_STATE_PING;
+    break;
+
+    case (7):
+      /* Start the Wi-Fi network health monitor. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Start the event-driven monitor of Wi-Fi network health.\r");
+      log_info(__LINE__, __func__, "========================================================\r");
+      log_info(__LINE__, __func__, "NOTE: Link drops and IP address changes will be displayed as soon as they occur\r");
+      log_info(__LINE__, __func__, "      and the monitor will automatically try to reconnect after a link drop.\r");
+      log_info(__LINE__, __func__, "      The monitor will blink Pico's LED as long as monitoring is active.\r");
+      log_info(__LINE__, __func__, "Press <G> to proceed: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 'G') || (String[0] == 'g'))
+      {
+        log_info(__LINE__, __func__, "Starting the monitor of Wi-Fi network health.\r");
+        log_info(__LINE__, __func__, "NOTE: Check Pico's LED for Wi-Fi status:\r");
+        log_info(__LINE__, __func__, "      1 blink  every 5 seconds means that Wi-Fi connection is OK.\r");
+        log_info(__LINE__, __func__, "      3 blinks every 5 seconds means that there is a problem with Wi-Fi connection.\r");
+        wifi_health_subscribe(callback_wifi_health, NULL);
+        wifi_health_start(StructWiFi);
+      }
+      else
+      {
+        log_info(__LINE__, __func__, "User didn't press <G>, do not launch the monitor...\r");
+      }
+      log_info(__LINE__, __func__, "Returning to terminal menu... Check Pico's LED for Wi-Fi status.\r");
+      printf("\r\r");
+    break;
+
+    case (8):
+      /* Throughput benchmark (iperf2 compatible). */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Throughput benchmark (iperf2 compatible).\r");
+      log_info(__LINE__, __func__, "=========================================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the benchmark to work.\r");
+      log_info(__LINE__, __func__, "          1) - TCP source (Pico -> PC)   PC runs: iperf -s\r");
+      log_info(__LINE__, __func__, "          2) - TCP sink   (PC -> Pico)   PC runs: iperf -c <Pico IP address>\r");
+      log_info(__LINE__, __func__, "          3) - UDP source (Pico -> PC)   PC runs: iperf -s -u\r");
+      log_info(__LINE__, __func__, "          4) - UDP sink   (PC -> Pico)   PC runs: iperf -c <Pico IP address> -u\r");
+      log_info(__LINE__, __func__, "Enter benchmark mode: ");
+      input_string(String, sizeof(String));
+      memset(&IperfSettings, 0x00, sizeof(IperfSettings));
+      IperfSettings.Mode = atoi(String);
+      if ((IperfSettings.Mode < IPERF_MODE_TCP_CLIENT) || (IperfSettings.Mode > IPERF_MODE_UDP_SERVER))
+      {
+        log_info(__LINE__, __func__, "Invalid benchmark mode... aborting.\r");
+        break;
+      }
+
+      if ((IperfSettings.Mode == IPERF_MODE_TCP_CLIENT) || (IperfSettings.Mode == IPERF_MODE_UDP_CLIENT))
+      {
+        ip4addr_aton(IPERF_ADDRESS, &IperfSettings.RemoteAddress);
+        log_info(__LINE__, __func__, "Enter IP address of the PC running iperf or <Enter> for <%s>: ", IPERF_ADDRESS);
+        input_string(String, sizeof(String));
+        if ((String[0] != 0x0D) && (String[0] != 0x1B) && !ip4addr_aton(String, &IperfSettings.RemoteAddress))
         {
-          if (!ip4addr_aton(String, &TestAddress))
-          {
-            log_info(__LINE__, __func__, "Invalid IP address entered... IP address has not been changed: <%s>.\r", ip4addr_ntoa(&PingAddress));
-          }
-          else
-          {
-            ip4addr_aton(String, &PingAddress);
-            log_info(__LINE__, __func__, "Ping IP address has been set to: <%s>\r", ip4addr_ntoa(&PingAddress));
-          }
+          log_info(__LINE__, __func__, "Invalid IP address entered... aborting.\r");
+          break;
         }
-        else
+
+        log_info(__LINE__, __func__, "Enter test duration in seconds or <Enter> for %u seconds: ", IPERF_DEFAULT_DURATION);
+        input_string(String, sizeof(String));
+        if ((String[0] != 0x0D) && (String[0] != 0x1B)) IperfSettings.DurationSec = atoi(String);
+
+        if (IperfSettings.Mode == IPERF_MODE_UDP_CLIENT)
         {
-          log_info(__LINE__, __func__, "No change to ping IP address: <%s>.\r", ip4addr_ntoa(&PingAddress));
+          log_info(__LINE__, __func__, "Enter UDP bandwidth in kbits/sec or <Enter> for %u kbits/sec: ", IPERF_DEFAULT_BANDWIDTH);
+          input_string(String, sizeof(String));
+          if ((String[0] != 0x0D) && (String[0] != 0x1B)) IperfSettings.BandwidthKbps = atoi(String);
         }
+      }
+
+      if (iperf_start(&IperfSettings) != 0)
+      {
+        log_info(__LINE__, __func__, "Failed to start the benchmark.\r");
+        break;
+      }
 
-        printf("\r");
-        log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the ping procedure to work.\r\r");
-        log_info(__LINE__, __func__, "The Pico will ping the specified IP address on local network.\r");
-        log_info(__LINE__, __func__, "If the target IP address is a 'pingable' system, you will see the ping sent and the answer\r");
-        log_info(__LINE__, __func__, "received from the target system, along with the number of msec (latency) between the send and the receive.\r");
-        log_info(__LINE__, __func__, "Press any key while ping is in progress to stop it and restart the firmware\r");
-        log_info(__LINE__, __func__, "Press <G> to begin pinging IP address %s: ", ip4addr_ntoa(&PingAddress));
-        input_string(String);
-        if ((String[0] == 'G') || (String[0] == 'g'))
+      if ((IperfSettings.Mode == IPERF_MODE_TCP_SERVER) || (IperfSettings.Mode == IPERF_MODE_UDP_SERVER))
+        log_info(__LINE__, __func__, "Waiting for iperf client on port %u... press <Enter> when the PC has finished to stop and display the report: ", IPERF_DEFAULT_PORT);
+      else
+        log_info(__LINE__, __func__, "Benchmark in progress... press <Enter> after %u seconds to display the report: ", IperfSettings.DurationSec ? IperfSettings.DurationSec : IPERF_DEFAULT_DURATION);
+      input_string(String, sizeof(String));
+      iperf_stop();
+      iperf_display_report();
+      printf("\r\r");
+    break;
+
+    case (9):
+      /* Display lwIP memory and link statistics. */
+      printf("\r\r");
+      wifi_stats_display();
+      log_info(__LINE__, __func__, "Press <R> to reset peak values and error counters, <B> to time pbuf allocations or <Enter> to return to menu: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 'R') || (String[0] == 'r'))
+      {
+        wifi_stats_reset();
+        log_info(__LINE__, __func__, "Peak values and error counters have been reset.\r");
+      }
+      else if ((String[0] == 'B') || (String[0] == 'b'))
+      {
+        /* 1000 pbuf pool allocations under the lwIP lock: only on request, not on every display. */
+        log_info(__LINE__, __func__, "pbuf alloc / free pair: %lu nsec (compare firmwares built with WIFI_LWIP_STATS=ON and OFF).\r", wifi_stats_benchmark());
+      }
+      printf("\r\r");
+    break;
+
+    case (10):
+      /* Zero-copy stream benchmark. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Zero-copy stream benchmark.\r");
+      log_info(__LINE__, __func__, "===========================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the benchmark to work.\r");
+      ip4addr_aton(IPERF_ADDRESS, &TestAddress);
+      log_info(__LINE__, __func__, "Enter IP address to send UDP datagrams to (discard port) or <Enter> for <%s>: ", IPERF_ADDRESS);
+      input_string(String, sizeof(String));
+      if ((String[0] != 0x0D) && (String[0] != 0x1B) && !ip4addr_aton(String, &TestAddress))
+      {
+        log_info(__LINE__, __func__, "Invalid IP address entered... aborting.\r");
+        break;
+      }
+
+      if (stream_benchmark(&TestAddress, &StreamBench) != 0)
+      {
+        log_info(__LINE__, __func__, "Failed to start the benchmark.\r");
+        break;
+      }
+      stream_display_benchmark(&StreamBench);
+      printf("\r\r");
+    break;
+
+    case (11):
+      /* MQTT publish test. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "MQTT publish test.\r");
+      log_info(__LINE__, __func__, "==================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the test to work.\r");
+      wifi_mqtt_get_stats(&MqttStats);
+      if (MqttStats.State == MQTT_STATE_IDLE)
+      {
+        /* Client is not running yet, start it. It then stays connected and reconnects by itself. */
+        memset(&MqttSettings, 0x00, sizeof(MqttSettings));
+        ip4addr_aton(MQTT_BROKER_IP, &MqttSettings.BrokerAddress);
+        log_info(__LINE__, __func__, "Enter IP address of the MQTT broker or <Enter> for <%s>: ", MQTT_BROKER_IP);
+        input_string(String, sizeof(String));
+        if ((String[0] != 0x0D) && (String[0] != 0x1B) && !ip4addr_aton(String, &MqttSettings.BrokerAddress))
         {
-          log_info(__LINE__, __func__, "Press any key to restart the firmware...\r");
-          ping_init(&PingAddress);
+          log_info(__LINE__, __func__, "Invalid IP address entered... aborting.\r");
+          break;
         }
-        else
+        MqttSettings.ClientId = (StructWiFi->ExtraHostName[0] != 0x00) ? StructWiFi->ExtraHostName : (UCHAR *)CYW43_HOST_NAME;
+        wifi_mqtt_start(&MqttSettings, NULL, NULL);
+      }
+
+      /* Wait for connection. */
+      TimeStamp = time_us_64();
+      while ((wifi_mqtt_is_connected() == FLAG_OFF) && ((time_us_64() - TimeStamp) < 10000000ull)) wifi_sleep_ms(100);
+      if (wifi_mqtt_is_connected() == FLAG_OFF)
+      {
+        log_info(__LINE__, __func__, "Not connected to the broker yet (client keeps trying in background).\r");
+        wifi_mqtt_display_stats();
+        break;
+      }
+
+      log_info(__LINE__, __func__, "Enter number of messages to publish or <Enter> for %u: ", MQTT_TEST_COUNT);
+      input_string(String, sizeof(String));
+      MessageCount = MQTT_TEST_COUNT;
+      if ((String[0] != 0x0D) && (String[0] != 0x1B)) MessageCount = atoi(String);
+
+      log_info(__LINE__, __func__, "Enter QoS (0 or 1) or <Enter> for 1: ");
+      input_string(String, sizeof(String));
+      QoS = 1;
+      if (String[0] == '0') QoS = 0;
+
+      /* Publish as fast as the queue accepts, then wait for the queue to drain. */
+      TimeStamp = time_us_64();
+      for (Loop1UInt16 = 0; Loop1UInt16 < MessageCount; ++Loop1UInt16)
+      {
+        sprintf(String, "Message %u", Loop1UInt16);
+        while (wifi_mqtt_publish(MQTT_TEST_TOPIC, String, strlen(String), QoS, FLAG_OFF) == -2) wifi_sleep_ms(1);
+      }
+      do
+      {
+        wifi_sleep_ms(1);
+        wifi_mqtt_get_stats(&MqttStats);
+      } while ((MqttStats.Pending != 0) && ((time_us_64() - TimeStamp) < 30000000ull));
+      TimeStamp = time_us_64() - TimeStamp;
+
+      log_info(__LINE__, __func__, "%u messages published on topic <%s> with QoS%u in %llu msec.\r", MessageCount, MQTT_TEST_TOPIC, QoS, TimeStamp / 1000);
+      wifi_mqtt_display_stats();
+      printf("\r\r");
+    break;
+
+    case (12):
+      /* Synchronize time (SNTP). */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Synchronize time (SNTP).\r");
+      log_info(__LINE__, __func__, "========================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for synchronization to work.\r");
+      if (wifi_sntp_start(SntpServer, SNTP_SERVER_COUNT) != 0)
+      {
+        /* Client already running, force a new synchronization. */
+        wifi_sntp_sync_now();
+      }
+
+      /* Wait for first synchronization (client keeps running in background). */
+      TimeStamp = time_us_64();
+      while ((wifi_sntp_is_synced() == FLAG_OFF) && ((time_us_64() - TimeStamp) < 10000000ull)) wifi_sleep_ms(10);
+      if (wifi_sntp_is_synced() == FLAG_ON)
+        log_info(__LINE__, __func__, "Time synchronized %llu msec after request.\r", (time_us_64() - TimeStamp) / 1000);
+      else
+        log_info(__LINE__, __func__, "Time not synchronized yet (client keeps trying in background).\r");
+      wifi_sntp_display_stats();
+      printf("\r\r");
+    break;
+
+    case (13):
+      /* DNS lookup and resolver cache statistics. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "DNS lookup and resolver cache statistics.\r");
+      log_info(__LINE__, __func__, "=========================================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the lookup to work.\r");
+      log_info(__LINE__, __func__, "Enter host name to look up or <Enter> for <%s>: ", DNS_TEST_NAME);
+      input_string(String, sizeof(String));
+      if ((String[0] == 0x0D) || (String[0] == 0x1B)) strcpy(String, DNS_TEST_NAME);
+
+      /* Look up twice: the second lookup should be answered from cache. */
+      for (Loop1UInt8 = 0; Loop1UInt8 < 2; ++Loop1UInt8)
+      {
+        DnsLookupDone = 0;
+        TimeStamp     = time_us_64();
+        switch (wifi_dns_resolve(String, &DnsLookupAddress, callback_dns_lookup, NULL))
         {
-          log_info(__LINE__, __func__, "User didn't press <G> to start ping procedure... aborting.\r");
+          case (0):
+            DnsLookupDone = 1;
+          break;
+
+          case (1):
+            while ((DnsLookupDone == 0) && ((time_us_64() - TimeStamp) < 10000000ull)) wifi_sleep_ms(1);
+          break;
+
+          default:
+            DnsLookupDone = 2;
           break;
         }
-        input_string(String);
+        TimeStamp = time_us_64() - TimeStamp;
+
+        if (DnsLookupDone == 1)
+          log_info(__LINE__, __func__, "<%s> is <%s> (lookup time: %llu usec).\r", String, ip4addr_ntoa(&DnsLookupAddress), TimeStamp);
+        else
+          log_info(__LINE__, __func__, "<%s> could not be resolved (lookup time: %llu usec).\r", String, TimeStamp);
+      }
+      wifi_dns_display_stats();
+      printf("\r\r");
+    break;
+
+    case (14):
+      /* Radio power profile and latency probe. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Radio power profile and latency probe.\r");
+      log_info(__LINE__, __func__, "======================================\r");
+      log_info(__LINE__, __func__, "Enter profile (0: performance, 1: balanced, 2: aggressive) or <P> to probe latency of all profiles: ");
+      input_string(String, sizeof(String));
+      if ((String[0] >= '0') && (String[0] < ('0' + WIFI_POWER_PROFILES)))
+      {
+        wifi_set_power_profile(String[0] - '0');
+        log_info(__LINE__, __func__, "Radio power profile set to <%s>.\r", wifi_power_profile_name(String[0] - '0'));
+        break;
+      }
+      if ((String[0] != 'P') && (String[0] != 'p')) break;
+
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) for the probe to work.\r");
+      log_info(__LINE__, __func__, "Enter IP address to ping or <Enter> for the gateway: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 0x0D) || (String[0] == 0x1B))
+      {
+        if (netif_default == NULL) break;
+        ip_addr_copy_from_ip4(TestAddress, *netif_ip4_gw(netif_default));
+      }
+      else if (!ip4addr_aton(String, &TestAddress))
+      {
+        log_info(__LINE__, __func__, "Invalid IP address entered... aborting.\r");
+        break;
+      }
+      log_info(__LINE__, __func__, "Probing %u echo requests per profile, %u msec apart (about %u sec)...\r", WIFI_POWER_PROBE_COUNT, WIFI_POWER_PROBE_MSEC,
+               (WIFI_POWER_PROFILES * ((WIFI_POWER_PROBE_COUNT * WIFI_POWER_PROBE_MSEC) + 1000)) / 1000);
+      if (wifi_power_probe(&TestAddress, WIFI_POWER_PROBE_COUNT, PowerProbe) != 0)
+        log_info(__LINE__, __func__, "Ping engine is busy (stop option 6 first).\r");
+      printf("\r\r");
+    break;
+
+    case (15):
+      /* Control-loop jitter benchmark. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Control-loop jitter benchmark.\r");
+      log_info(__LINE__, __func__, "==============================\r");
+      log_info(__LINE__, __func__, "A %u usec control loop runs on core 0 for %u cycles while the gateway is pinged every %u msec.\r", JITTER_PERIOD_USEC, JITTER_CYCLES, JITTER_PING_MSEC);
+      log_info(__LINE__, __func__, "Compare results of firmwares built with WIFI_CORE1=OFF and WIFI_CORE1=ON, and with each WIFI_ARCH (%s here).\r", wifi_arch_name());
+
+      /* Network load. */
+      FlagLoad = FLAG_OFF;
+      if ((FlagLogon == FLAG_ON) && (netif_default != NULL) && !ping_is_running())
+      {
+        ip_addr_copy_from_ip4(TestAddress, *netif_ip4_gw(netif_default));
+        ping_clear_targets();
+        ping_target_add(&TestAddress, JITTER_PING_MSEC, 0);
+        ping_start();
+        FlagLoad = FLAG_ON;
+        wifi_sleep_ms(500);
+      }
+      else
+      {
+        log_info(__LINE__, __func__, "NOTE: No network load (not logged on, or ping engine busy).\r");
+      }
+
+      wifi_core1_jitter(JITTER_PERIOD_USEC, JITTER_CYCLES, &Jitter);
+      if (FlagLoad == FLAG_ON) ping_stop();
+      wifi_core1_display_jitter(&Jitter);
+      printf("\r\r");
+    break;
+
+    case (16):
+      /* CPU used by networking. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "CPU used by networking.\r");
+      log_info(__LINE__, __func__, "=======================\r");
+      log_info(__LINE__, __func__, "An idle loop is counted during %u msec without traffic, then while the gateway is pinged every %u msec.\r", CPU_TEST_MSEC, CPU_PING_MSEC);
+      log_info(__LINE__, __func__, "Compare results of firmwares built with each WIFI_ARCH (%s here).\r", wifi_arch_name());
+
+      if ((FlagLogon == FLAG_OFF) || (netif_default == NULL) || ping_is_running())
+      {
+        log_info(__LINE__, __func__, "Must be logged on, with no ping in progress.\r\r");
+        break;
+      }
+
+      IdleLoops = wifi_cpu_loops(CPU_TEST_MSEC);
+
+      ip_addr_copy_from_ip4(TestAddress, *netif_ip4_gw(netif_default));
+      ping_clear_targets();
+      ping_target_add(&TestAddress, CPU_PING_MSEC, 0);
+      ping_start();
+      wifi_sleep_ms(500);
+      LoadLoops = wifi_cpu_loops(CPU_TEST_MSEC);
+      ping_stop();
+
+      if (LoadLoops > IdleLoops) LoadLoops = IdleLoops;
+      log_info(__LINE__, __func__, "Idle loops without traffic:  %10lu\r", IdleLoops);
+      log_info(__LINE__, __func__, "Idle loops with ping load:   %10lu\r", LoadLoops);
+      if (IdleLoops)
+        log_info(__LINE__, __func__, "CPU used by networking:      %7lu.%1lu %%\r", (UINT32)(((UINT64)(IdleLoops - LoadLoops) * 1000) / IdleLoops) / 10, (UINT32)(((UINT64)(IdleLoops - LoadLoops) * 1000) / IdleLoops) % 10);
+      printf("\r\r");
+    break;
+
+    case (17):
+      /* Cooperative scheduler statistics. */
+      printf("\r\r");
+      wifi_sched_display_stats();
+      printf("\r\r");
+    break;
+
+    case (18):
+      /* Console output benchmark. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Console output benchmark.\r");
+      log_info(__LINE__, __func__, "=========================\r");
+      if (WlanFound[1].Channel == 0)
+      {
+        log_info(__LINE__, __func__, "Scan table is empty: scan for Access Points first (option 1).\r\r");
+        break;
+      }
+      log_info(__LINE__, __func__, "The scan table is printed %u lines at a time, first as before, then one transfer per line, then batched.\r", CONSOLE_BENCH_LINES);
+      log_info(__LINE__, __func__, "Press <Enter> to start: ");
+      input_string(String, sizeof(String));
+
+      for (Loop1UInt8 = 0; Loop1UInt8 < 3; ++Loop1UInt8)
+        LinesPerSecond[Loop1UInt8] = print_bench(Loop1UInt8);
+
+      wifi_console_get_stats(&ConsoleStats);
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Lines per second, one printf() per field (before): %7lu\r", LinesPerSecond[0]);
+      log_info(__LINE__, __func__, "Lines per second, one transfer per line:           %7lu\r", LinesPerSecond[1]);
+      log_info(__LINE__, __func__, "Lines per second, batched (%u bytes):            %7lu\r", CONSOLE_OUT_SIZE, LinesPerSecond[2]);
+      log_info(__LINE__, __func__, "Console writes: %lu   transfers: %lu   bytes sent: %lu   bytes dropped (no terminal): %lu\r\r",
+               ConsoleStats.Writes, ConsoleStats.Transfers, ConsoleStats.BytesSent, ConsoleStats.BytesDropped);
+
+      /* Formatting alone, without output. */
+      for (Loop1UInt8 = 0; Loop1UInt8 < 2; ++Loop1UInt8)
+        NsecPerRow[Loop1UInt8] = format_bench(Loop1UInt8);
+      log_info(__LINE__, __func__, "Scan row formatting, snprintf():          %7lu nsec per row\r", NsecPerRow[0]);
+      log_info(__LINE__, __func__, "Scan row formatting, format_scan_row():   %7lu nsec per row\r\r", NsecPerRow[1]);
+    break;
+
+    case (19):
+      /* Select export mode and export scan table and status. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Export mode.\r");
+      log_info(__LINE__, __func__, "============\r");
+      log_info(__LINE__, __func__, "Current export mode: %s\r", wifi_export_mode_name(wifi_export_get_mode()));
+      for (Loop1UInt8 = 0; Loop1UInt8 < EXPORT_MODES; ++Loop1UInt8)
+        log_info(__LINE__, __func__, "   %u) - %s\r", Loop1UInt8, wifi_export_mode_name(Loop1UInt8));
+      log_info(__LINE__, __func__, "Enter new export mode (<Enter> to keep current mode): ");
+      input_string(String, sizeof(String));
+      if ((String[0] >= '0') && (String[0] <= '9') && (wifi_export_set_mode(atoi(String)) != 0))
+        log_info(__LINE__, __func__, "Invalid export mode.\r");
+      log_info(__LINE__, __func__, "Scan results (option 1) and network information (option 3) are now reported as: %s\r", wifi_export_mode_name(wifi_export_get_mode()));
+
+      /* Report scan table and status now, and the number of bytes it took (compare with text mode). */
+      log_info(__LINE__, __func__, "Press <G> to report scan table and status now, <Enter> to skip: ");
+      input_string(String, sizeof(String));
+      if ((String[0] != 'G') && (String[0] != 'g')) break;
+
+      wifi_console_get_stats(&ConsoleStats);
+      ExportBytes = ConsoleStats.BytesSent;
+      print_results(1);
+      wifi_console_get_stats(&ConsoleStats);
+      ExportBytes = ConsoleStats.BytesSent - ExportBytes;
+      if (wifi_export_get_mode() != EXPORT_MODE_TEXT)
+      {
+        wifi_export_begin();
+        wifi_export_status(StructWiFi);
+        wifi_export_end();
+      }
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Scan table (%s): %lu bytes sent to the console.\r\r", wifi_export_mode_name(wifi_export_get_mode()), ExportBytes);
+    break;
+
+    case (20):
+      /* Display the boot timeline. */
+      printf("\r\r");
+      wifi_boot_display();
+      printf("\r\r");
+    break;
+
+    case (21):
+      /* Display or change the configuration store. */
+      printf("\r\r");
+      wifi_config_display();
+      log_info(__LINE__, __func__, "Enter key to change (ssid, password, country, hostname, power, export or number), <format> to erase all, <Enter> to exit: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 0x0D) || (String[0] == 0x1B)) break;
+
+      if (strcmp(String, "format") == 0)
+      {
+        log_info(__LINE__, __func__, "Press <G> to erase all settings (compiled-in defaults apply at next start-up): ");
+        input_string(String, sizeof(String));
+        if ((String[0] == 'G') || (String[0] == 'g')) wifi_config_format();
+        break;
+      }
+
+      Key = wifi_config_key(String);
+      if (Key < 0)
+      {
+        log_info(__LINE__, __func__, "Invalid key <%s>.\r", String);
+        break;
+      }
+
+      log_info(__LINE__, __func__, "Enter new value for <%s> (<Enter> to erase it, compiled-in default then applies): ", wifi_config_key_name(Key));
+      input_string(Value, sizeof(Value));
+      if (Value[0] == 0x1B) break;
+      if (((Value[0] == 0x0D) ? wifi_config_erase(Key) : wifi_config_set_text(Key, Value)) != 0)
+        log_info(__LINE__, __func__, "Failed to save <%s> (invalid value or flash error).\r", wifi_config_key_name(Key));
+      else
+        log_info(__LINE__, __func__, "<%s> saved, applies at next start-up.\r", wifi_config_key_name(Key));
+    break;
+
+    case (22):
+      /* mDNS / DNS-SD responder. */
+      printf("\r\r");
+      wifi_mdns_display_stats();
+      log_info(__LINE__, __func__, "Press <A> to announce the records again, <Enter> to exit: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 'A') || (String[0] == 'a')) wifi_mdns_announce();
+    break;
+
+    case (23):
+      /* HTTP client benchmark. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "HTTP client benchmark.\r");
+      log_info(__LINE__, __func__, "======================\r");
+      log_info(__LINE__, __func__, "NOTE: You must be logged on the local network (option 2) and run tools/wifi_http_sink.py on the PC.\r");
+      ip4addr_aton(HTTP_SERVER_IP, &TestAddress);
+      log_info(__LINE__, __func__, "Enter IP address of the HTTP server (port %u) or <Enter> for <%s>: ", HTTP_SERVER_PORT, HTTP_SERVER_IP);
+      input_string(String, sizeof(String));
+      if ((String[0] != 0x0D) && (String[0] != 0x1B) && !ip4addr_aton(String, &TestAddress))
+      {
+        log_info(__LINE__, __func__, "Invalid IP address entered... aborting.\r");
+        break;
+      }
+
+      log_info(__LINE__, __func__, "Enter number of requests per pass or <Enter> for %u: ", HTTP_BENCH_COUNT);
+      input_string(String, sizeof(String));
+      MessageCount = HTTP_BENCH_COUNT;
+      if ((String[0] != 0x0D) && (String[0] != 0x1B)) MessageCount = atoi(String);
+      if (MessageCount == 0) break;
+
+      for (Loop1UInt8 = HTTP_BENCH_CLOSE; Loop1UInt8 <= HTTP_BENCH_PIPELINE; ++Loop1UInt8)
+      {
+        TimeStamp = http_bench(&TestAddress, Loop1UInt8, MessageCount);
+        log_info(__LINE__, __func__, "%-27s %4u requests in %6llu msec: %6llu usec per request (%u errors).\r", HttpBenchName[Loop1UInt8], MessageCount, TimeStamp / 1000, TimeStamp / MessageCount, HttpBenchErrors);
+      }
+
+      TimeStamp = http_bench(&TestAddress, HTTP_BENCH_STREAM, 1);
+      log_info(__LINE__, __func__, "%-27s %lu bytes in %llu msec: %llu kbytes/sec (%u errors).\r", "Chunked upload", HttpBenchProduced, TimeStamp / 1000, (HttpBenchProduced * 1000ull) / ((TimeStamp) ? TimeStamp : 1), HttpBenchErrors);
+
+      wifi_http_display_stats();
+      printf("\r\r");
+    break;
+
+    case (24):
+      /* HTTP status server statistics. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "HTTP status server.\r");
+      log_info(__LINE__, __func__, "===================\r");
+      if (WIFI_HTTPD_PORT == 0)
+      {
+        log_info(__LINE__, __func__, "HTTP status server is disabled (WIFI_HTTPD_PORT=0).\r");
+        break;
+      }
+      log_info(__LINE__, __func__, "Status page: http://%s:%u/ (requests per second: tools/wifi_httpd_bench.py on the PC).\r", wifi_format_ip(String, &StructWiFi->PicoIPAddress), WIFI_HTTPD_PORT);
+      wifi_httpd_display_stats();
+      printf("\r\r");
+    break;
+
+    case (25):
+      /* Telemetry queue. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Records are posted to <%s:%u> (tools/wifi_http_sink.py on the PC) while the link is up.\r", HTTP_SERVER_IP, HTTP_SERVER_PORT);
+      wifi_queue_display_stats();
+      log_info(__LINE__, __func__, "Sampling (one record every %u sec) is %s.\r", QUEUE_SAMPLE_MSEC / 1000, (QueueSampling == FLAG_ON) ? "on" : "off");
+      log_info(__LINE__, __func__, "Press <S> to toggle sampling, <B> for enqueue / drain benchmark, <C> to clear the queue, <Enter> to exit: ");
+      input_string(String, sizeof(String));
+
+      if ((String[0] == 'S') || (String[0] == 's'))
+      {
+        QueueSampling = (QueueSampling == FLAG_ON) ? FLAG_OFF : FLAG_ON;
+        log_info(__LINE__, __func__, "Sampling is now %s.\r", (QueueSampling == FLAG_ON) ? "on" : "off");
+      }
+
+      if ((String[0] == 'C') || (String[0] == 'c'))
+      {
+        if (wifi_queue_clear() != 0)
+          log_info(__LINE__, __func__, "Queue not cleared (batch being sent), try again.\r");
+        else
+          log_info(__LINE__, __func__, "Queue cleared.\r");
+      }
+
+      if ((String[0] == 'B') || (String[0] == 'b'))
+      {
+        log_info(__LINE__, __func__, "NOTE: records waiting to be sent are discarded by the benchmark.\r");
+        log_info(__LINE__, __func__, "Enter number of records or <Enter> for %u: ", QUEUE_BENCH_RECORDS);
+        input_string(String, sizeof(String));
+        if (String[0] == 0x1B) break;
+        RecordCount = (String[0] == 0x0D) ? QUEUE_BENCH_RECORDS : atoi(String);
+
+        log_info(__LINE__, __func__, "Enter record length (1 to %u) or <Enter> for %u: ", QUEUE_MAX_RECORD, QUEUE_BENCH_LENGTH);
+        input_string(String, sizeof(String));
+        if (String[0] == 0x1B) break;
+        RecordLength = (String[0] == 0x0D) ? QUEUE_BENCH_LENGTH : atoi(String);
+
+        wifi_queue_bench(RecordCount, RecordLength);
+      }
+      printf("\r\r");
+    break;
+
+    case (88):
+      /* Restart the Firmware. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Restart the Firmware.\r");
+      log_info(__LINE__, __func__, "=====================\r");
+      log_info(__LINE__, __func__, "Press <G> to proceed: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 'G') || (String[0] == 'g'))
+      {
         cyw43_arch_deinit();
         log_info(__LINE__, __func__, "Restarting the Firmware...\r");
-        sleep_ms(1000);
         watchdog_enable(1, 1);
-      break;
+      }
+      wifi_sleep_ms(3000);  // prevent beginning of menu redisplay.
+    break;
 
-      case (7):
-        /* Start a callback to monitor Wi-Fi network health. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Start a 5-seconds callback to monitor Wi-Fi network health.\r");
-        log_info(__LINE__, __func__, "===========================================================\r");
-        log_info(__LINE__, __func__, "NOTE: The callback will display Wi-Fi network health for the first 30 seconds,\r");
-        log_info(__LINE__, __func__, "      then will stop display network health but will continue monitoring.\r");
-        log_info(__LINE__, __func__, "      The callback will blink Pico's LED as long as monitoring is active.\r");
-        log_info(__LINE__, __func__, "Press <G> to proceed: ");
-        input_string(String);
-        if ((String[0] == 'G') || (String[0] == 'g'))
-        {
-          log_info(__LINE__, __func__, "Starting a 5-seconds callback to monitor Wi-Fi network health.\r");
-          log_info(__LINE__, __func__, "NOTE: For the first 30 seconds, a message will show up on the screen to indicate Wi-Fi connection health.\r");
-          log_info(__LINE__, __func__, "      Then, you must check Pico's LED:\r");
-          log_info(__LINE__, __func__, "      1 blink  every 5 seconds means that Wi-Fi connection is OK.\r");
-          log_info(__LINE__, __func__, "      3 blinks every 5 seconds means that there is a problem with Wi-Fi connection.\r");
-          sleep_ms(500);  ///
-          add_repeating_timer_ms(-5000, callback_5sec_timer, NULL, &Handle5SecTimer);
-          sleep_ms(20000);
-        }
-        else
-        {
-          log_info(__LINE__, __func__, "User didn't press <G>, do not launch the callback...\r");
-        }
-        log_info(__LINE__, __func__, "Returning to terminal menu... Check Pico's LED for Wi-Fi status.\r");
-        printf("\r\r");
-      break;
+    case (99):
+      /* Switch the Pico in upload mode. */
+      printf("\r\r");
+      log_info(__LINE__, __func__, "Switch Pico in upload mode.\r");
+      log_info(__LINE__, __func__, "===========================\r");
+      log_info(__LINE__, __func__, "Press <G> to proceed: ");
+      input_string(String, sizeof(String));
+      if ((String[0] == 'G') || (String[0] == 'g'))
+      {
+        cyw43_arch_deinit();
+        log_info(__LINE__, __func__, "Toggling Pico in upload mode...\r");
+        reset_usb_boot(0l, 0l);
+      }
+      printf("\r\r");
+    break;
 
-      case (88):
-        /* Restart the Firmware. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Restart the Firmware.\r");
-        log_info(__LINE__, __func__, "=====================\r");
-        log_info(__LINE__, __func__, "Press <G> to proceed: ");
-        input_string(String);
-        if ((String[0] == 'G') || (String[0] == 'g'))
-        {
-          cyw43_arch_deinit();
-          log_info(__LINE__, __func__, "Restarting the Firmware...\r");
-          watchdog_enable(1, 1);
-        }
-        sleep_ms(3000);  // prevent beginning of menu redisplay.
-      break;
+    default:
+      printf("\r\r");
+      log_info(__LINE__, __func__, "               Invalid choice... please re-enter [%s]  [%u]\r\r\r\r\r", MenuString, Menu);
+      printf("\r\r");
+    break;
+  }
 
-      case (99):
-        /* Switch the Pico in upload mode. */
-        printf("\r\r");
-        log_info(__LINE__, __func__, "Switch Pico in upload mode.\r");
-        log_info(__LINE__, __func__, "===========================\r");
-        log_info(__LINE__, __func__, "Press <G> to proceed: ");
-        input_string(String);
-        if ((String[0] == 'G') || (String[0] == 'g'))
-        {
-          cyw43_arch_deinit();
-          log_info(__LINE__, __func__, "Toggling Pico in upload mode...\r");
-          reset_usb_boot(0l, 0l);
-        }
-        printf("\r\r");
-      break;
+  return NextState;
+}
 
-      default:
-        printf("\r\r");
-        log_info(__LINE__, __func__, "               Invalid choice... please re-enter [%s]  [%u]\r\r\r\r\r", String, Menu);
-        printf("\r\r");
-      break;
-    }
+
+
+
+
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=term_menu_display(). */
+/* ============================================================================================================================================================= *\
+                                                                    Display the terminal menu.
+\* ============================================================================================================================================================= */
+void term_menu_display(void)
+{
+#if WIFI_CORE1
+  struct struct_core1_msg Core1Message;
+
+
+  /* Display events received from core 1 since last menu display. */
+  while (wifi_core1_get_event(&Core1Message) == 0)
+  {
+    if (Core1Message.Type == CORE1_EVENT_HEALTH)
+      log_info(__LINE__, __func__, "Wi-Fi event (core 1): %s.\r", wifi_event_name(Core1Message.Value));
   }
+#endif  // WIFI_CORE1
+
+  printf("\r\r\r");
+  log_info(__LINE__, __func__, "               Terminal menu\r");
+  log_info(__LINE__, __func__, "               =============\r");
+  log_info(__LINE__, __func__, "          1) - Scan Wi-Fi frequencies for available Access Points.\r");
+  log_info(__LINE__, __func__, "          2) - Logon to local network.\r");
+  log_info(__LINE__, __func__, "          3) - Display Wi-Fi network information.\r");
+  log_info(__LINE__, __func__, "          4) - Blink Picow's LED.\r");
+  log_info(__LINE__, __func__, "          5) - Recover Wi-Fi link (rejoin, netif restart, cyw43 re-init).\r");
+  log_info(__LINE__, __func__, "          6) - Ping one or more IP addresses.\r");
+  log_info(__LINE__, __func__, "          7) - Start monitoring Wi-Fi network health.\r");
+  log_info(__LINE__, __func__, "          8) - Throughput benchmark (iperf2 compatible).\r");
+  log_info(__LINE__, __func__, "          9) - Display lwIP memory and link statistics.\r");
+  log_info(__LINE__, __func__, "         10) - Zero-copy stream benchmark.\r");
+  log_info(__LINE__, __func__, "         11) - MQTT publish test.\r");
+  log_info(__LINE__, __func__, "         12) - Synchronize time (SNTP).\r");
+  log_info(__LINE__, __func__, "         13) - DNS lookup and resolver cache statistics.\r");
+  log_info(__LINE__, __func__, "         14) - Radio power profile and latency probe.\r");
+  log_info(__LINE__, __func__, "         15) - Control-loop jitter benchmark.\r");
+  log_info(__LINE__, __func__, "         16) - CPU used by networking.\r");
+  log_info(__LINE__, __func__, "         17) - Cooperative scheduler statistics.\r");
+  log_info(__LINE__, __func__, "         18) - Console output benchmark.\r");
+  log_info(__LINE__, __func__, "         19) - Export mode (text, binary, CSV, JSON).\r");
+  log_info(__LINE__, __func__, "         20) - Boot timeline.\r");
+  log_info(__LINE__, __func__, "         21) - Configuration store (settings saved in flash).\r");
+  log_info(__LINE__, __func__, "         22) - mDNS / DNS-SD responder statistics.\r");
+  log_info(__LINE__, __func__, "         23) - HTTP client benchmark (keep-alive, pipelining, chunked upload).\r");
+  log_info(__LINE__, __func__, "         24) - HTTP status server statistics (requests, RAM and flash footprint).\r");
+  log_info(__LINE__, __func__, "         25) - Telemetry queue (store-and-forward statistics, benchmark).\r");
+  log_info(__LINE__, __func__, "         88) - Restart the Firmware.\r");
+  log_info(__LINE__, __func__, "         99) - Switch Pico in upload mode\r\r");
+
+  log_info(__LINE__, __func__, "               Enter your choice: ");
 
   return;
 }
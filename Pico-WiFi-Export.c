@@ -0,0 +1,461 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Export.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Machine-readable export of scan results and Wi-Fi status snapshots, for host tooling that would otherwise screen-scrape log_info() output.
+   Records are streamed through the console writer (see Pico-WiFi-Console.c) in one of three formats:
+   - binary: EXPORT_SYNC, Type, Length, payload, CRC-8. Decoded on the host by tools/wifi_export_decode.py.
+   - CSV:    one line per record, first column is the record type.
+   - JSON:   one JSON object per line (JSON Lines).
+   While binary records are sent, stdio CR/LF translation is turned off so that bytes 0x0A go out unchanged.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+
+#include "Pico-WiFi-Console.h"
+#include "Pico-WiFi-Export.h"
+#include "Pico-WiFi-Module.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UINT8  Mode;
+  UINT8  Depth;                                        // nested wifi_export_begin() calls.
+  UINT32 Bytes;                                        // bytes exported since start-up.
+} Export = {WIFI_EXPORT_MODE, 0, 0};
+
+static const UCHAR *const ModeName[EXPORT_MODES] = {"text", "binary", "CSV", "JSON"};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Compute CRC-8 of a block of data. */
+static UINT8 export_crc8(UINT8 Crc, const UCHAR *Data, UINT16 Length);
+
+/* Copy a string, escaped for a CSV or JSON string value. */
+static void export_escape(UCHAR *Output, const UCHAR *Input, UINT8 Length);
+
+/* Store a 32-bit value, little-endian. */
+static void export_put_u32(UCHAR *Buffer, UINT32 Value);
+
+/* Send a binary record. */
+static void export_record(UINT8 Type, const UCHAR *Payload, UINT8 Length);
+
+/* Send exported data through the console writer. */
+static void export_write(const UCHAR *Data, UINT16 Length);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=export_crc8(). */
+/* ============================================================================================================================================================= *\
+                                   Compute CRC-8 (polynomial 0x07, initial value 0x00) of a block of data, continuing from Crc.
+\* ============================================================================================================================================================= */
+static UINT8 export_crc8(UINT8 Crc, const UCHAR *Data, UINT16 Length)
+{
+  UINT8 Loop1UInt8;
+
+  UINT16 Loop1UInt16;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Length; ++Loop1UInt16)
+  {
+    Crc ^= Data[Loop1UInt16];
+    for (Loop1UInt8 = 0; Loop1UInt8 < 8; ++Loop1UInt8)
+      Crc = (Crc & 0x80) ? ((Crc << 1) ^ 0x07) : (Crc << 1);
+  }
+
+  return Crc;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=export_escape(). */
+/* ============================================================================================================================================================= *\
+                   Copy Length characters of a string (an SSID may contain any byte), escaped for a CSV string (quote doubled) or a JSON string
+                (quote, backslash and control characters escaped), depending on export mode. Output must hold 6 bytes per input character, plus 1.
+\* ============================================================================================================================================================= */
+static void export_escape(UCHAR *Output, const UCHAR *Input, UINT8 Length)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Length; ++Loop1UInt8)
+  {
+    if (Input[Loop1UInt8] == '"')
+    {
+      *Output++ = (Export.Mode == EXPORT_MODE_CSV) ? '"' : '\\';
+      *Output++ = '"';
+    }
+    else if ((Export.Mode == EXPORT_MODE_JSON) && (Input[Loop1UInt8] == '\\'))
+    {
+      *Output++ = '\\';
+      *Output++ = '\\';
+    }
+    else if ((Export.Mode == EXPORT_MODE_JSON) && (Input[Loop1UInt8] < 0x20))
+    {
+      Output += sprintf(Output, "\\u%4.4X", Input[Loop1UInt8]);
+    }
+    else
+    {
+      *Output++ = Input[Loop1UInt8];
+    }
+  }
+  *Output = 0x00;  // end-of-string
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=export_put_u32(). */
+/* ============================================================================================================================================================= *\
+                                                               Store a 32-bit value, little-endian.
+\* ============================================================================================================================================================= */
+static void export_put_u32(UCHAR *Buffer, UINT32 Value)
+{
+  Buffer[0] = (UCHAR)Value;
+  Buffer[1] = (UCHAR)(Value >> 8);
+  Buffer[2] = (UCHAR)(Value >> 16);
+  Buffer[3] = (UCHAR)(Value >> 24);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=export_record(). */
+/* ============================================================================================================================================================= *\
+                                 Send a binary record: EXPORT_SYNC, Type, Length, payload, and CRC-8 of Type, Length and payload.
+\* ============================================================================================================================================================= */
+static void export_record(UINT8 Type, const UCHAR *Payload, UINT8 Length)
+{
+  UCHAR Record[EXPORT_MAX_PAYLOAD + 4];
+
+
+  if (Length > EXPORT_MAX_PAYLOAD) Length = EXPORT_MAX_PAYLOAD;
+
+  Record[0] = EXPORT_SYNC;
+  Record[1] = Type;
+  Record[2] = Length;
+  memcpy(&Record[3], Payload, Length);
+  Record[3 + Length] = export_crc8(0x00, &Record[1], Length + 2);
+
+  export_write(Record, Length + 4);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=export_write(). */
+/* ============================================================================================================================================================= *\
+                                                   Send exported data through the console writer, and count it.
+\* ============================================================================================================================================================= */
+static void export_write(const UCHAR *Data, UINT16 Length)
+{
+  Export.Bytes += Length;
+  wifi_console_write(Data, Length);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_begin(). */
+/* ============================================================================================================================================================= *\
+                       Start a group of records: they are batched by the console writer and sent by wifi_export_end(). Calls may be nested.
+                                        In binary mode, stdio CR/LF translation is turned off until the end of the group.
+\* ============================================================================================================================================================= */
+void wifi_export_begin(void)
+{
+  if (Export.Depth++ > 0) return;
+
+  wifi_console_batch_begin();
+  if (Export.Mode == EXPORT_MODE_BINARY) stdio_set_translate_crlf(&stdio_usb, false);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_bytes(). */
+/* ============================================================================================================================================================= *\
+                                                       Return the number of bytes exported since start-up.
+\* ============================================================================================================================================================= */
+UINT32 wifi_export_bytes(void)
+{
+  return Export.Bytes;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_end(). */
+/* ============================================================================================================================================================= *\
+                             End a group of records started with wifi_export_begin(), send them, and restore stdio CR/LF translation.
+\* ============================================================================================================================================================= */
+void wifi_export_end(void)
+{
+  if ((Export.Depth == 0) || (--Export.Depth > 0)) return;
+
+  wifi_console_batch_end();
+  if (Export.Mode == EXPORT_MODE_BINARY) stdio_set_translate_crlf(&stdio_usb, PICO_STDIO_DEFAULT_CRLF);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_get_mode(). */
+/* ============================================================================================================================================================= *\
+                                                                   Return current export mode.
+\* ============================================================================================================================================================= */
+UINT8 wifi_export_get_mode(void)
+{
+  return Export.Mode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_mode_name(). */
+/* ============================================================================================================================================================= *\
+                                                                Return the name of an export mode.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_export_mode_name(UINT8 Mode)
+{
+  if (Mode >= EXPORT_MODES) return "unknown";
+
+  return ModeName[Mode];
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_scan_begin(). */
+/* ============================================================================================================================================================= *\
+                                        Export the beginning of a scan table of Count entries. Does nothing in text mode.
+\* ============================================================================================================================================================= */
+void wifi_export_scan_begin(UINT8 Count)
+{
+  UCHAR Line[96];
+  UCHAR Payload[6];
+
+  UINT32 Uptime;
+
+
+  Uptime = to_ms_since_boot(get_absolute_time());
+
+  switch (Export.Mode)
+  {
+    case (EXPORT_MODE_BINARY):
+      Payload[0] = EXPORT_VERSION;
+      Payload[1] = Count;
+      export_put_u32(&Payload[2], Uptime);
+      export_record(EXPORT_RECORD_SCAN_BEGIN, Payload, sizeof(Payload));
+    break;
+
+    case (EXPORT_MODE_CSV):
+      export_write(Line, sprintf(Line, "scan_begin,%u,%u,%lu\n", EXPORT_VERSION, Count, Uptime));
+    break;
+
+    case (EXPORT_MODE_JSON):
+      export_write(Line, sprintf(Line, "{\"type\":\"scan_begin\",\"version\":%u,\"count\":%u,\"uptime_ms\":%lu}\n", EXPORT_VERSION, Count, Uptime));
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_scan_entry(). */
+/* ============================================================================================================================================================= *\
+                                                   Export one entry of a scan table. Does nothing in text mode.
+\* ============================================================================================================================================================= */
+void wifi_export_scan_entry(UINT8 Index, const UCHAR *Name, INT8 Rssi, UINT8 Channel, UINT8 Security, const UINT8 *MacAddress)
+{
+  UCHAR Escaped[(32 * 6) + 1];
+  UCHAR Line[320];
+  UCHAR Mac[WIFI_MAC_STRING_SIZE];
+  UCHAR Payload[10 + 32];
+
+  UINT8 Length;
+
+
+  for (Length = 0; (Length < 32) && Name[Length]; ++Length);
+
+  switch (Export.Mode)
+  {
+    case (EXPORT_MODE_BINARY):
+      Payload[0] = Index;
+      Payload[1] = (UCHAR)Rssi;
+      Payload[2] = Channel;
+      Payload[3] = Security;
+      memcpy(&Payload[4],  MacAddress, 6);
+      memcpy(&Payload[10], Name, Length);
+      export_record(EXPORT_RECORD_SCAN_ENTRY, Payload, 10 + Length);
+    break;
+
+    case (EXPORT_MODE_CSV):
+      export_escape(Escaped, Name, Length);
+      export_write(Line, sprintf(Line, "scan,%u,\"%s\",%d,%u,%u,%s\n", Index, Escaped, Rssi, Channel, Security, wifi_format_mac(Mac, MacAddress, ':')));
+    break;
+
+    case (EXPORT_MODE_JSON):
+      export_escape(Escaped, Name, Length);
+      export_write(Line, sprintf(Line, "{\"type\":\"scan\",\"index\":%u,\"ssid\":\"%s\",\"rssi\":%d,\"channel\":%u,\"security\":%u,\"mac\":\"%s\"}\n",
+                                 Index, Escaped, Rssi, Channel, Security, wifi_format_mac(Mac, MacAddress, ':')));
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_set_mode(). */
+/* ============================================================================================================================================================= *\
+                Select export mode (EXPORT_MODE_xxx). Must not be called between wifi_export_begin() and wifi_export_end(). Return -1 if invalid.
+\* ============================================================================================================================================================= */
+INT16 wifi_export_set_mode(UINT8 Mode)
+{
+  if ((Mode >= EXPORT_MODES) || (Export.Depth > 0)) return -1;
+
+  Export.Mode = Mode;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_export_status(). */
+/* ============================================================================================================================================================= *\
+                    Export a snapshot of Wi-Fi status: address, signal strength, link status, health and counters. Does nothing in text mode.
+\* ============================================================================================================================================================= */
+void wifi_export_status(struct struct_wifi *StructWiFi)
+{
+  UCHAR Escaped[(32 * 6) + 1];
+  UCHAR Ip[WIFI_IP_STRING_SIZE];
+  UCHAR Line[400];
+  UCHAR Mac[WIFI_MAC_STRING_SIZE];
+  UCHAR Payload[29 + 32];
+
+  INT Link;
+
+  UINT8 Length;
+
+  INT32 Rssi;
+  UINT32 Address;
+  UINT32 Uptime;
+
+
+  if (Export.Mode == EXPORT_MODE_TEXT) return;
+
+  Uptime = to_ms_since_boot(get_absolute_time());
+  Link   = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+  Rssi   = 0;
+  if (Link == CYW43_LINK_UP) cyw43_wifi_get_rssi(&cyw43_state, &Rssi);
+  Address = ip4_addr_get_u32(&StructWiFi->PicoIPAddress);  // network order: octets in address order.
+  for (Length = 0; (Length < 32) && StructWiFi->NetworkName[Length]; ++Length);
+
+  switch (Export.Mode)
+  {
+    case (EXPORT_MODE_BINARY):
+      export_put_u32(&Payload[0], Uptime);
+      memcpy(&Payload[4],  &Address, 4);
+      memcpy(&Payload[8],  StructWiFi->MacAddress, 6);
+      Payload[14] = (UCHAR)Rssi;
+      Payload[15] = (UCHAR)Link;
+      Payload[16] = StructWiFi->FlagHealth;
+      export_put_u32(&Payload[17], StructWiFi->TotalErrors);
+      export_put_u32(&Payload[21], StructWiFi->LinkDownCount);
+      export_put_u32(&Payload[25], StructWiFi->ReconnectCount);
+      memcpy(&Payload[29], StructWiFi->NetworkName, Length);
+      export_record(EXPORT_RECORD_STATUS, Payload, 29 + Length);
+    break;
+
+    case (EXPORT_MODE_CSV):
+      export_escape(Escaped, StructWiFi->NetworkName, Length);
+      export_write(Line, sprintf(Line, "status,%lu,%s,%s,%ld,%d,%u,%lu,%lu,%lu,\"%s\"\n", Uptime, wifi_format_ip(Ip, &StructWiFi->PicoIPAddress), wifi_format_mac(Mac, StructWiFi->MacAddress, ':'),
+                                 Rssi, Link, StructWiFi->FlagHealth, StructWiFi->TotalErrors, StructWiFi->LinkDownCount, StructWiFi->ReconnectCount, Escaped));
+    break;
+
+    case (EXPORT_MODE_JSON):
+      export_escape(Escaped, StructWiFi->NetworkName, Length);
+      export_write(Line, sprintf(Line, "{\"type\":\"status\",\"uptime_ms\":%lu,\"ip\":\"%s\",\"mac\":\"%s\",\"rssi\":%ld,\"link\":%d,\"health\":%u,\"total_errors\":%lu,"
+                                       "\"link_drops\":%lu,\"reconnects\":%lu,\"ssid\":\"%s\"}\n",
+                                 Uptime, wifi_format_ip(Ip, &StructWiFi->PicoIPAddress), wifi_format_mac(Mac, StructWiFi->MacAddress, ':'),
+                                 Rssi, Link, StructWiFi->FlagHealth, StructWiFi->TotalErrors, StructWiFi->LinkDownCount, StructWiFi->ReconnectCount, Escaped));
+    break;
+  }
+
+  return;
+}
@@ -0,0 +1,74 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Export.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Export.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_EXPORT_H
+#define _WIFI_EXPORT_H
+
+#include "baseline.h"
+#include "Pico-WiFi-Module.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Export modes (default given by WIFI_EXPORT in CMakeLists.txt). */
+#define EXPORT_MODE_TEXT                 0     // human-formatted text through log_info() (no export).
+#define EXPORT_MODE_BINARY               1     // length-prefixed binary records (see tools/wifi_export_decode.py).
+#define EXPORT_MODE_CSV                  2     // one CSV line per record.
+#define EXPORT_MODE_JSON                 3     // one JSON object per line (JSON Lines).
+#define EXPORT_MODES                     4
+
+#ifndef WIFI_EXPORT_MODE
+#define WIFI_EXPORT_MODE  EXPORT_MODE_TEXT
+#endif  // WIFI_EXPORT_MODE
+
+/* Binary record: EXPORT_SYNC, Type, Length (of payload), payload, CRC-8 (polynomial 0x07) of Type, Length and payload.
+   Multi-byte values are little-endian. */
+#define EXPORT_SYNC                   0xA5
+#define EXPORT_VERSION                   1     // payload layout version, sent in EXPORT_RECORD_SCAN_BEGIN.
+#define EXPORT_MAX_PAYLOAD              64
+
+/* Binary record types and payloads. */
+#define EXPORT_RECORD_SCAN_BEGIN      0x01     // Version u8, Count u8, Uptime msec u32.
+#define EXPORT_RECORD_SCAN_ENTRY      0x02     // Index u8, Rssi i8, Channel u8, Security u8, MAC 6 bytes, SSID (rest of payload, no end-of-string).
+#define EXPORT_RECORD_STATUS          0x03     // Uptime msec u32, IPv4 4 bytes, MAC 6 bytes, Rssi i8, Link i8, Health u8, TotalErrors u32,
+                                               // LinkDownCount u32, ReconnectCount u32, SSID (rest of payload).
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Start a group of records. */
+void wifi_export_begin(void);
+
+/* Return the number of bytes exported since start-up. */
+UINT32 wifi_export_bytes(void);
+
+/* End a group of records and send them. */
+void wifi_export_end(void);
+
+/* Return current export mode. */
+UINT8 wifi_export_get_mode(void);
+
+/* Return the name of an export mode. */
+const UCHAR *wifi_export_mode_name(UINT8 Mode);
+
+/* Export the beginning of a scan table. */
+void wifi_export_scan_begin(UINT8 Count);
+
+/* Export one entry of a scan table. */
+void wifi_export_scan_entry(UINT8 Index, const UCHAR *Name, INT8 Rssi, UINT8 Channel, UINT8 Security, const UINT8 *MacAddress);
+
+/* Select export mode. */
+INT16 wifi_export_set_mode(UINT8 Mode);
+
+/* Export a snapshot of Wi-Fi status. */
+void wifi_export_status(struct struct_wifi *StructWiFi);
+
+#endif  // _WIFI_EXPORT_H
@@ -0,0 +1,280 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Flash.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Flash layer shared by the modules that keep data in flash (Pico-WiFi-Config.c, Pico-WiFi-Queue.c). Each module owns a region of whole
+   sectors (see struct struct_flash_region) and addresses it from its first byte.
+   - Erase and program: a sector is erased at once, data is programmed by whole pages (bytes outside of the data are left to 0xFF, which
+     leaves flash unchanged) and read back to verify it.
+   - Sector header: Magic, generation and CRC-16 of both, the common first bytes of a configuration sector and of a queue segment.
+   - CRC-16 (CCITT polynomial 0x1021, initial value 0xFFFF), with a 16-entry table since every byte stored or sent goes through it.
+   On the PicoW, flash is written with flash_safe_execute(), which also holds the other core while XIP is disabled.
+   On a host, the region is a RAM image owned by the module, which behaves as flash (programming only clears bits), so that the modules
+   can be tested (power loss, corruption, rotation) and benchmarked.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release (erase, program and CRC-16 taken out of Pico-WiFi-Config.c and Pico-WiFi-Queue.c).
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "string.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/stdlib.h"
+#else   // PICO_ON_DEVICE
+#include <time.h>
+#endif  // PICO_ON_DEVICE
+
+#include "Pico-WiFi-Flash.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#if PICO_ON_DEVICE
+#define FLASH_SAFE_MSEC                100     // longest wait for the other core to be held during a flash operation.
+#endif  // PICO_ON_DEVICE
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+/* CRC-16 (CCITT polynomial 0x1021), four bits at a time. */
+static const UINT16 FlashCrcTable[16] =
+{
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+#if PICO_ON_DEVICE
+/* Flash operation run by flash_safe_execute(). */
+static struct
+{
+  UINT32 Offset;                                       // from the beginning of flash.
+  const UINT8 *Page;                                   // NULL: erase a sector.
+} FlashOperation;
+#endif  // PICO_ON_DEVICE
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+#if PICO_ON_DEVICE
+/* Flash operation run with the other core held and interrupts disabled. */
+static void flash_operation(void *Param);
+#endif  // PICO_ON_DEVICE
+
+
+
+
+
+#if PICO_ON_DEVICE
+/* $PAGE */
+/* $TITLE=flash_operation(). */
+/* ============================================================================================================================================================= *\
+                 Flash operation run by flash_safe_execute(), with the other core held and interrupts disabled: erase a sector or program a page.
+\* ============================================================================================================================================================= */
+static void flash_operation(void *Param)
+{
+  if (FlashOperation.Page == NULL)
+    flash_range_erase(FlashOperation.Offset, WIFI_FLASH_SECTOR_SIZE);
+  else
+    flash_range_program(FlashOperation.Offset, FlashOperation.Page, WIFI_FLASH_PAGE_SIZE);
+
+  return;
+}
+#endif  // PICO_ON_DEVICE
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_crc16(). */
+/* ============================================================================================================================================================= *\
+          Compute CRC-16 (CCITT polynomial 0x1021, initial value 0xFFFF) of a block of data, continuing from Crc. A 16-entry table gives the same result
+                                                       as the bitwise algorithm with two lookups per byte.
+\* ============================================================================================================================================================= */
+UINT16 wifi_flash_crc16(UINT16 Crc, const UINT8 *Data, UINT16 Length)
+{
+  UINT16 Loop1UInt16;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Length; ++Loop1UInt16)
+  {
+    Crc = (UINT16)(Crc << 4) ^ FlashCrcTable[(Crc >> 12) ^ (Data[Loop1UInt16] >> 4)];
+    Crc = (UINT16)(Crc << 4) ^ FlashCrcTable[(Crc >> 12) ^ (Data[Loop1UInt16] & 0x0F)];
+  }
+
+  return Crc;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_erase(). */
+/* ============================================================================================================================================================= *\
+                                                             Erase the sector at Offset of a region.
+\* ============================================================================================================================================================= */
+void wifi_flash_erase(const struct struct_flash_region *Region, UINT32 Offset)
+{
+#if PICO_ON_DEVICE
+  FlashOperation.Offset = Region->Offset + Offset;
+  FlashOperation.Page   = NULL;
+  flash_safe_execute(flash_operation, &FlashOperation, FLASH_SAFE_MSEC);
+#else   // PICO_ON_DEVICE
+  memset(&Region->Image[Offset], 0xFF, WIFI_FLASH_SECTOR_SIZE);
+#endif  // PICO_ON_DEVICE
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_get_u32(). */
+/* ============================================================================================================================================================= *\
+                                                Read a little-endian 32-bit value (flash data may not be aligned).
+\* ============================================================================================================================================================= */
+UINT32 wifi_flash_get_u32(const UINT8 *Data)
+{
+  return (UINT32)Data[0] | ((UINT32)Data[1] << 8) | ((UINT32)Data[2] << 16) | ((UINT32)Data[3] << 24);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_header(). */
+/* ============================================================================================================================================================= *\
+             Build a sector header in caller's buffer: Magic, Sequence (generation) and CRC-16 of both, little-endian (WIFI_FLASH_HEADER_SIZE bytes).
+\* ============================================================================================================================================================= */
+void wifi_flash_header(UINT8 *Header, UINT32 Magic, UINT32 Sequence)
+{
+  UINT16 Crc;
+
+
+  Header[0] = (UINT8)Magic;
+  Header[1] = (UINT8)(Magic >> 8);
+  Header[2] = (UINT8)(Magic >> 16);
+  Header[3] = (UINT8)(Magic >> 24);
+  Header[4] = (UINT8)Sequence;
+  Header[5] = (UINT8)(Sequence >> 8);
+  Header[6] = (UINT8)(Sequence >> 16);
+  Header[7] = (UINT8)(Sequence >> 24);
+  Crc = wifi_flash_crc16(0xFFFF, Header, 8);
+  Header[8] = (UINT8)Crc;
+  Header[9] = (UINT8)(Crc >> 8);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_header_valid(). */
+/* ============================================================================================================================================================= *\
+          Check a sector header (magic number and CRC) and return its generation. Return -1 if the sector does not hold a complete header of this Magic.
+\* ============================================================================================================================================================= */
+INT16 wifi_flash_header_valid(const UINT8 *Header, UINT32 Magic, UINT32 *Sequence)
+{
+  if (wifi_flash_get_u32(Header) != Magic) return -1;
+  if (wifi_flash_crc16(0xFFFF, Header, 8) != ((UINT16)Header[8] | ((UINT16)Header[9] << 8))) return -1;
+
+  *Sequence = wifi_flash_get_u32(&Header[4]);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_program(). */
+/* ============================================================================================================================================================= *\
+           Program data at Offset of a region, then verify it. Flash is programmed by whole pages: bytes outside of Data are left to 0xFF, which leaves
+          flash unchanged (programming only clears bits). On a host, the RAM image behaves the same way. Return -1 if flash does not read back as Data.
+\* ============================================================================================================================================================= */
+INT16 wifi_flash_program(const struct struct_flash_region *Region, UINT32 Offset, const UINT8 *Data, UINT16 Length)
+{
+  UINT8 Page[WIFI_FLASH_PAGE_SIZE];
+
+  UINT16 Chunk;
+  UINT16 Done;
+  UINT16 PageOffset;
+
+#if PICO_ON_DEVICE == 0
+  UINT16 Loop1UInt16;
+#endif  // PICO_ON_DEVICE
+
+
+  for (Done = 0; Done < Length; Done += Chunk)
+  {
+    PageOffset = (Offset + Done) % WIFI_FLASH_PAGE_SIZE;
+    Chunk      = WIFI_FLASH_PAGE_SIZE - PageOffset;
+    if (Chunk > (Length - Done)) Chunk = Length - Done;
+
+    memset(Page, 0xFF, sizeof(Page));
+    memcpy(&Page[PageOffset], &Data[Done], Chunk);
+
+#if PICO_ON_DEVICE
+    FlashOperation.Offset = Region->Offset + (Offset + Done - PageOffset);
+    FlashOperation.Page   = Page;
+    flash_safe_execute(flash_operation, &FlashOperation, FLASH_SAFE_MSEC);
+#else   // PICO_ON_DEVICE
+    for (Loop1UInt16 = 0; Loop1UInt16 < WIFI_FLASH_PAGE_SIZE; ++Loop1UInt16)
+      Region->Image[Offset + Done - PageOffset + Loop1UInt16] &= Page[Loop1UInt16];
+#endif  // PICO_ON_DEVICE
+  }
+
+  return (memcmp(WIFI_FLASH_DATA(Region, Offset), Data, Length) == 0) ? 0 : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_flash_time_us(). */
+/* ============================================================================================================================================================= *\
+                                         Return current time, in usec (load time and benchmarks of the modules in flash).
+\* ============================================================================================================================================================= */
+UINT64 wifi_flash_time_us(void)
+{
+#if PICO_ON_DEVICE
+  return time_us_64();
+#else   // PICO_ON_DEVICE
+  struct timespec TimeSpec;
+
+
+  clock_gettime(CLOCK_MONOTONIC, &TimeSpec);
+
+  return ((UINT64)TimeSpec.tv_sec * 1000000ull) + (TimeSpec.tv_nsec / 1000);
+#endif  // PICO_ON_DEVICE
+}
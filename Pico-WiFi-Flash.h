@@ -0,0 +1,68 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Flash.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Flash.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_FLASH_H
+#define _WIFI_FLASH_H
+
+#include "baseline.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/flash.h"
+#endif  // PICO_ON_DEVICE
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define WIFI_FLASH_SECTOR_SIZE        4096     // flash erase unit.
+#define WIFI_FLASH_PAGE_SIZE           256     // flash program unit.
+#define WIFI_FLASH_HEADER_SIZE          10     // sector header built by wifi_flash_header(): Magic u32, Sequence u32, CRC-16 of both.
+
+/* Read-only access to the data of a region: execute-in-place area on the PicoW, RAM image on a host. */
+#if PICO_ON_DEVICE
+#define WIFI_FLASH_DATA(Region, Position)  ((const UINT8 *)(XIP_BASE + (Region)->Offset + (Position)))
+#else   // PICO_ON_DEVICE
+#define WIFI_FLASH_DATA(Region, Position)  ((const UINT8 *)&(Region)->Image[Position])
+#endif  // PICO_ON_DEVICE
+
+
+/* Region of flash owned by a module (whole sectors). */
+struct struct_flash_region
+{
+  UINT32 Offset;                               // first byte of the region, from the beginning of flash (PicoW).
+  UINT32 Size;
+  UINT8 *Image;                                // RAM image replacing flash on a host (NULL on the PicoW).
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Compute CRC-16 of a block of data. */
+UINT16 wifi_flash_crc16(UINT16 Crc, const UINT8 *Data, UINT16 Length);
+
+/* Erase a sector of a region. */
+void wifi_flash_erase(const struct struct_flash_region *Region, UINT32 Offset);
+
+/* Read a little-endian 32-bit value. */
+UINT32 wifi_flash_get_u32(const UINT8 *Data);
+
+/* Build a sector header. */
+void wifi_flash_header(UINT8 *Header, UINT32 Magic, UINT32 Sequence);
+
+/* Check a sector header and return its generation. */
+INT16 wifi_flash_header_valid(const UINT8 *Header, UINT32 Magic, UINT32 *Sequence);
+
+/* Program data in a region, then verify it. */
+INT16 wifi_flash_program(const struct struct_flash_region *Region, UINT32 Offset, const UINT8 *Data, UINT16 Length);
+
+/* Return current time, in usec. */
+UINT64 wifi_flash_time_us(void);
+
+#endif  // _WIFI_FLASH_H
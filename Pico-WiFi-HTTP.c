@@ -0,0 +1,1333 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-HTTP.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Non-blocking HTTP/1.1 client built on the lwIP raw API, part of Pico-WiFi-Module.
+   wifi_http_request() only queues the request and returns; the response is given to a callback as it arrives:
+   - Keep-alive:  connections (HTTP_MAX_CONNECTIONS) stay open after a response and carry the next requests to the same
+     server, saving the TCP handshake of each post. An idle connection is closed after HTTP_IDLE_MSEC, or sooner when
+     the server announces a shorter Keep-Alive time-out. A request on a reused connection that the server closes before
+     answering is sent again once on a new connection.
+   - Pipelining:  up to HTTP_PIPELINE_MAX requests are written on a connection without waiting for the previous responses,
+     which come back in the same order. A streaming upload is never pipelined.
+   - Upload:      a fixed body is handed to TCP without copy (Content-Length). A streaming body is pulled from a producer
+     callback whenever TCP has room and sent with chunked transfer encoding, one chunk per tcp_write().
+   - Response:    status line, headers and body are parsed in place in the received pbufs; body fragments (Content-Length,
+     chunked or until close) are given to the callback without copy. Only a status or header line split across two pbufs
+     is reassembled in a small buffer.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port and
+   tested against a local server (for example tools/wifi_http_sink.py).
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "ctype.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "lwip/tcp.h"
+
+#include "Pico-WiFi-HTTP.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define HTTP_CHUNK_HEADER     6             // chunk size in hexadecimal (4 digits at most) and <CR><LF>.
+#define HTTP_OUT_SIZE         (HTTP_CHUNK_HEADER + HTTP_CHUNK_SIZE + 2)
+
+/* State of a request slot. */
+#define HTTP_SLOT_FREE        0
+#define HTTP_SLOT_QUEUED      1             // waiting for a connection.
+#define HTTP_SLOT_ASSIGNED    2             // in the pipeline of a connection, not written yet.
+#define HTTP_SLOT_SENDING     3             // head written, body in progress.
+#define HTTP_SLOT_SENT        4             // written, waiting for (or receiving) its response.
+
+/* State of a connection. */
+#define HTTP_CONN_FREE        0
+#define HTTP_CONN_CONNECTING  1
+#define HTTP_CONN_READY       2
+
+/* State of the response parser. */
+#define HTTP_PARSE_STATUS       0
+#define HTTP_PARSE_HEADER       1
+#define HTTP_PARSE_BODY         2           // Content-Length bytes.
+#define HTTP_PARSE_CHUNK_SIZE   3
+#define HTTP_PARSE_CHUNK_DATA   4
+#define HTTP_PARSE_CHUNK_END    5           // <CR><LF> after the chunk data.
+#define HTTP_PARSE_TRAILER      6
+#define HTTP_PARSE_UNTIL_CLOSE  7           // no length given, body ends with the connection.
+
+
+/* Request slot. */
+struct struct_http_slot
+{
+  UINT8  State;
+  UINT8  Retries;
+  UINT8  FlagEnd;                           // streaming upload: producer has no more data.
+  UINT32 Sequence;                          // order of arrival, requests are dispatched in this order.
+  UINT32 Sent;                              // fixed body: bytes handed to TCP.
+  UINT64 SendTime;                          // time stamp of the request head written.
+  struct struct_http_request  Request;
+  struct struct_http_response Response;
+};
+
+
+/* Connection. */
+struct struct_http_connection
+{
+  struct tcp_pcb *Pcb;
+  UINT8  State;
+  UINT8  Count;                             // requests in Pipeline[].
+  UINT8  Pipeline[HTTP_PIPELINE_MAX];       // request slots, in the order they are written; responses come back in this order.
+  UINT8  ParseState;
+  UINT8  FlagDigits;                        // chunk size: at least one hexadecimal digit received.
+  UINT8  FlagExtension;                     // chunk size: skipping a chunk extension.
+  UINT16 LineLength;                        // bytes of a split line held in Line[].
+  UINT16 OutOffset;                         // request head or chunk in Out[], not accepted by TCP yet.
+  UINT16 OutLength;
+  UINT16 Port;
+  ip_addr_t Address;
+  UINT32 Requests;                          // requests written on this connection.
+  UINT32 Remaining;                         // body or chunk bytes still expected.
+  UINT32 IdleMsec;                          // idle time-out, shortened by the Keep-Alive header of the server.
+  UINT64 ConnectTime;
+  UINT64 LastActivity;                      // last data received, acknowledged or written.
+  UCHAR  Line[HTTP_LINE_SIZE];
+  UCHAR  Out[HTTP_OUT_SIZE];
+};
+
+
+static struct
+{
+  UINT8  FlagTimer;                         // timer runs while connections are open or requests are pending.
+  UINT32 Sequence;
+  struct tcp_pcb *AbortedPcb;               // pcb aborted during a callback of lwIP, which must then return ERR_ABRT.
+  struct struct_http_slot       Slot[HTTP_QUEUE_SIZE];
+  struct struct_http_connection Conn[HTTP_MAX_CONNECTIONS];
+  struct struct_http_stats      Stats;
+} Http;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Give a queued request to a connection. */
+static INT16 http_assign(UINT8 Index);
+
+/* Close a connection and queue its unanswered requests again. */
+static INT16 http_close(struct struct_http_connection *Conn, UINT8 FlagError);
+
+/* Complete the response in progress on a connection. */
+static INT16 http_complete(struct struct_http_connection *Conn);
+
+/* Open a connection. */
+static INT16 http_connect(struct struct_http_connection *Conn, const ip_addr_t *Address, UINT16 Port);
+
+/* Give queued requests to connections, in order of arrival. */
+static void http_dispatch(void);
+
+/* Drop a connection after a protocol error or a time-out. */
+static INT16 http_drop(struct struct_http_connection *Conn);
+
+/* Fail a request. */
+static void http_fail(UINT8 Index);
+
+/* Return the decimal number at the start of a string which is not zero-terminated. */
+static UINT32 http_get_number(const UCHAR *Data, UINT16 Length);
+
+/* Tell if a header value contains a token. */
+static UINT8 http_has_token(const UCHAR *Value, UINT16 Length, const UCHAR *Token);
+
+/* Return the offset of the value of a header line, or -1 if the line is not this header. */
+static INT16 http_header_value(const UCHAR *Line, UINT16 Length, const UCHAR *Name);
+
+/* Process the status line or a header line of a response. */
+static INT16 http_line(struct struct_http_connection *Conn, const UCHAR *Line, UINT16 Length);
+
+/* Write the requests of a connection, as far as TCP accepts them. */
+static void http_output(struct struct_http_connection *Conn);
+
+/* Parse a segment of a response. */
+static INT16 http_parse(struct struct_http_connection *Conn, const UCHAR *Data, UINT16 Length);
+
+/* TCP: connection established. */
+static err_t http_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP: connection error (pcb already freed by lwIP). */
+static void http_tcp_error(void *Arg, err_t Error);
+
+/* TCP: data received from the server. */
+static err_t http_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged, more may be sent. */
+static err_t http_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+/* Time-out and keep-alive timer. */
+static void http_timer(void *Arg);
+
+/* Write the head and the body of a request. */
+static INT16 http_write_body(struct struct_http_connection *Conn, UINT8 Index);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_assign(). */
+/* ============================================================================================================================================================= *\
+                               Give a queued request to a connection: the least loaded connection to the same server, or a new one.
+                                    Return the connection number, or -1 if none is available yet (the request remains queued).
+\* ============================================================================================================================================================= */
+static INT16 http_assign(UINT8 Index)
+{
+  UINT8 Loop1UInt8;
+
+  INT16 Best;
+
+  struct struct_http_connection *Conn;
+  struct struct_http_request    *Request;
+
+
+  Request = &Http.Slot[Index].Request;
+
+  Best = -1;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+  {
+    Conn = &Http.Conn[Loop1UInt8];
+    if ((Conn->State == HTTP_CONN_FREE) || (Conn->Port != Request->Port) || !ip_addr_cmp(&Conn->Address, &Request->Address)) continue;
+    if (Conn->Count >= HTTP_PIPELINE_MAX) continue;
+
+    /* A streaming upload may take long: requests are not queued behind it, and it does not wait behind others. */
+    if ((Conn->Count) && ((Request->Producer != NULL) || (Http.Slot[Conn->Pipeline[Conn->Count - 1]].Request.Producer != NULL))) continue;
+
+    if ((Best < 0) || (Conn->Count < Http.Conn[Best].Count)) Best = Loop1UInt8;
+  }
+
+  if (Best < 0)
+  {
+    /* Open a new connection, in a free slot or in place of an idle connection to another server. */
+    for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+      if (Http.Conn[Loop1UInt8].State == HTTP_CONN_FREE) break;
+
+    if (Loop1UInt8 == HTTP_MAX_CONNECTIONS)
+    {
+      for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+        if ((Http.Conn[Loop1UInt8].State == HTTP_CONN_READY) && (Http.Conn[Loop1UInt8].Count == 0)) break;
+      if (Loop1UInt8 == HTTP_MAX_CONNECTIONS) return -1;
+      http_close(&Http.Conn[Loop1UInt8], FLAG_OFF);
+    }
+
+    if (http_connect(&Http.Conn[Loop1UInt8], &Request->Address, Request->Port) != 0) return -1;
+    Best = Loop1UInt8;
+  }
+
+  Conn = &Http.Conn[Best];
+  Conn->Pipeline[Conn->Count++] = Index;
+  Http.Slot[Index].State = HTTP_SLOT_ASSIGNED;
+  http_output(Conn);
+
+  return Best;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_close(). */
+/* ============================================================================================================================================================= *\
+                                                    Close a connection. Unanswered requests are queued again:
+                                   - on a graceful close (server asked for it, idle connection, client stopping), all of them;
+               - on an error, those not written yet, and once (HTTP_RETRIES) those written (a reused connection may have been closed by the server
+                     at the very moment the request was sent). A request partly answered, or whose streamed body was partly produced, fails.
+                                                             Return -1 if the pcb had to be aborted.
+\* ============================================================================================================================================================= */
+static INT16 http_close(struct struct_http_connection *Conn, UINT8 FlagError)
+{
+  UINT8 Count;
+  UINT8 FlagConnected;
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+  UINT8 Pipeline[HTTP_PIPELINE_MAX];
+
+  INT16 ReturnCode;
+
+  struct struct_http_slot *Slot;
+
+
+  ReturnCode = 0;
+  if (Conn->Pcb != NULL)
+  {
+    tcp_arg(Conn->Pcb,  NULL);
+    tcp_err(Conn->Pcb,  NULL);
+    tcp_recv(Conn->Pcb, NULL);
+    tcp_sent(Conn->Pcb, NULL);
+    if ((FlagError == FLAG_ON) || (tcp_close(Conn->Pcb) != ERR_OK))
+    {
+      Http.AbortedPcb = Conn->Pcb;
+      tcp_abort(Conn->Pcb);
+      ReturnCode = -1;
+    }
+    Conn->Pcb = NULL;
+  }
+
+  /* Connection is free before callbacks are called: they may queue new requests. */
+  FlagConnected = (Conn->State == HTTP_CONN_READY) ? FLAG_ON : FLAG_OFF;
+  Count         = Conn->Count;
+  memcpy(Pipeline, Conn->Pipeline, Count);
+  Conn->Count = 0;
+  Conn->State = HTTP_CONN_FREE;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Count; ++Loop1UInt8)
+  {
+    Index = Pipeline[Loop1UInt8];
+    Slot  = &Http.Slot[Index];
+
+    if ((Slot->State == HTTP_SLOT_ASSIGNED) && ((FlagError == FLAG_OFF) || (FlagConnected == FLAG_ON)))
+    {
+      /* Not written yet. */
+    }
+    else if ((FlagError == FLAG_OFF) && (Slot->Response.Status == 0) && (Slot->Request.Producer == NULL))
+    {
+      /* Written, the server closed the connection after answering a previous request. */
+    }
+    else if ((Slot->Response.Status == 0) && ((Slot->Request.Producer == NULL) || (Slot->State == HTTP_SLOT_ASSIGNED)) && (Slot->Retries < HTTP_RETRIES))
+    {
+      ++Slot->Retries;
+      ++Http.Stats.Retries;
+    }
+    else
+    {
+      http_fail(Index);
+      continue;
+    }
+
+    Slot->State   = HTTP_SLOT_QUEUED;
+    Slot->Sent    = 0;
+    Slot->FlagEnd = FLAG_OFF;
+    memset(&Slot->Response, 0x00, sizeof(Slot->Response));
+    Slot->Response.ContentLength = -1;
+  }
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_complete(). */
+/* ============================================================================================================================================================= *\
+                                    Complete the response in progress on a connection. Return -1 if the connection was closed.
+\* ============================================================================================================================================================= */
+static INT16 http_complete(struct struct_http_connection *Conn)
+{
+  UINT8 FlagClose;
+  UINT8 Index;
+
+  void *Context;
+
+  http_response_callback Callback;
+
+  struct struct_http_response Response;
+
+
+  Index = Conn->Pipeline[0];
+  --Conn->Count;
+  memmove(&Conn->Pipeline[0], &Conn->Pipeline[1], Conn->Count);
+  Conn->ParseState = HTTP_PARSE_STATUS;
+  Conn->LineLength = 0;
+
+  /* A response complete before its request was fully written leaves the connection out of step. */
+  FlagClose = ((Http.Slot[Index].Response.FlagClose == FLAG_ON) || (Http.Slot[Index].State != HTTP_SLOT_SENT)) ? FLAG_ON : FLAG_OFF;
+
+  Http.Slot[Index].Response.LatencyUs = WIFI_TIME_US() - Http.Slot[Index].SendTime;
+  Http.Stats.LatencyTotalUs += Http.Slot[Index].Response.LatencyUs;
+  if (Http.Slot[Index].Response.LatencyUs > Http.Stats.LatencyMaxUs) Http.Stats.LatencyMaxUs = Http.Slot[Index].Response.LatencyUs;
+  ++Http.Stats.Completed;
+
+  Response = Http.Slot[Index].Response;
+  Callback = Http.Slot[Index].Request.Callback;
+  Context  = Http.Slot[Index].Request.Context;
+  Http.Slot[Index].State = HTTP_SLOT_FREE;
+
+  /* Close first, so that a request queued by the callback does not go to this connection. */
+  if (FlagClose == FLAG_ON)
+  {
+    ++Http.Stats.ServerCloses;
+    http_close(Conn, FLAG_OFF);
+  }
+
+  if (Callback != NULL) Callback(HTTP_EVENT_DONE, &Response, NULL, 0, Context);
+
+  return (FlagClose == FLAG_ON) ? -1 : 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_connect(). */
+/* ============================================================================================================================================================= *\
+                                              Open a connection. Return 0 on success, or -1 if no pcb is available.
+\* ============================================================================================================================================================= */
+static INT16 http_connect(struct struct_http_connection *Conn, const ip_addr_t *Address, UINT16 Port)
+{
+  Conn->Pcb = tcp_new_ip_type(IP_GET_TYPE(Address));
+  if (Conn->Pcb == NULL) return -1;
+
+  ip_addr_copy(Conn->Address, *Address);
+  Conn->Port         = Port;
+  Conn->State        = HTTP_CONN_CONNECTING;
+  Conn->Count        = 0;
+  Conn->ParseState   = HTTP_PARSE_STATUS;
+  Conn->LineLength   = 0;
+  Conn->OutLength    = 0;
+  Conn->Requests     = 0;
+  Conn->IdleMsec     = HTTP_IDLE_MSEC;
+  Conn->ConnectTime  = WIFI_TIME_US();
+  Conn->LastActivity = Conn->ConnectTime;
+
+  /* Each request is handed to TCP in full before tcp_output(): there is nothing for Nagle to gather, only latency to add. */
+  tcp_nagle_disable(Conn->Pcb);
+  tcp_arg(Conn->Pcb,  Conn);
+  tcp_err(Conn->Pcb,  http_tcp_error);
+  tcp_recv(Conn->Pcb, http_tcp_receive);
+  tcp_sent(Conn->Pcb, http_tcp_sent);
+
+  if (tcp_connect(Conn->Pcb, Address, Port, http_tcp_connected) != ERR_OK)
+  {
+    tcp_err(Conn->Pcb, NULL);
+    tcp_abort(Conn->Pcb);
+    Conn->Pcb   = NULL;
+    Conn->State = HTTP_CONN_FREE;
+    return -1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_dispatch(). */
+/* ============================================================================================================================================================= *\
+                                                    Give queued requests to connections, in order of arrival.
+\* ============================================================================================================================================================= */
+static void http_dispatch(void)
+{
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+
+  UINT32 Last;
+
+
+  Last = 0;
+  while (1)
+  {
+    /* Oldest request not tried yet. */
+    Index = HTTP_QUEUE_SIZE;
+    for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+    {
+      if ((Http.Slot[Loop1UInt8].State != HTTP_SLOT_QUEUED) || (Http.Slot[Loop1UInt8].Sequence <= Last)) continue;
+      if ((Index == HTTP_QUEUE_SIZE) || (Http.Slot[Loop1UInt8].Sequence < Http.Slot[Index].Sequence)) Index = Loop1UInt8;
+    }
+    if (Index == HTTP_QUEUE_SIZE) break;
+
+    Last = Http.Slot[Index].Sequence;
+    http_assign(Index);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_drop(). */
+/* ============================================================================================================================================================= *\
+                     Drop a connection after a protocol error or a time-out: the request in progress fails (the server may have processed it)
+                                        and the requests behind it are queued again. Return -1 (the pcb has been aborted).
+\* ============================================================================================================================================================= */
+static INT16 http_drop(struct struct_http_connection *Conn)
+{
+  if (Conn->Count) Http.Slot[Conn->Pipeline[0]].Retries = HTTP_RETRIES;
+
+  return http_close(Conn, FLAG_ON);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_fail(). */
+/* ============================================================================================================================================================= *\
+                                                                Fail a request and free its slot.
+\* ============================================================================================================================================================= */
+static void http_fail(UINT8 Index)
+{
+  void *Context;
+
+  http_response_callback Callback;
+
+  struct struct_http_response Response;
+
+
+  ++Http.Stats.Errors;
+
+  Response = Http.Slot[Index].Response;
+  Callback = Http.Slot[Index].Request.Callback;
+  Context  = Http.Slot[Index].Request.Context;
+  Http.Slot[Index].State = HTTP_SLOT_FREE;
+
+  if (Callback != NULL) Callback(HTTP_EVENT_ERROR, &Response, NULL, 0, Context);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_get_number(). */
+/* ============================================================================================================================================================= *\
+                                         Return the decimal number at the start of a string which is not zero-terminated.
+\* ============================================================================================================================================================= */
+static UINT32 http_get_number(const UCHAR *Data, UINT16 Length)
+{
+  UINT16 Loop1UInt16;
+
+  UINT32 Number;
+
+
+  Number = 0;
+  for (Loop1UInt16 = 0; (Loop1UInt16 < Length) && isdigit(Data[Loop1UInt16]); ++Loop1UInt16)
+    Number = (Number * 10) + (Data[Loop1UInt16] - '0');
+
+  return Number;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_has_token(). */
+/* ============================================================================================================================================================= *\
+                                                    Tell if a header value contains a token (case is ignored).
+\* ============================================================================================================================================================= */
+static UINT8 http_has_token(const UCHAR *Value, UINT16 Length, const UCHAR *Token)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+  UINT16 TokenLength;
+
+
+  TokenLength = strlen(Token);
+  for (Loop1UInt16 = 0; (Loop1UInt16 + TokenLength) <= Length; ++Loop1UInt16)
+  {
+    for (Loop2UInt16 = 0; Loop2UInt16 < TokenLength; ++Loop2UInt16)
+      if (tolower(Value[Loop1UInt16 + Loop2UInt16]) != Token[Loop2UInt16]) break;
+    if (Loop2UInt16 == TokenLength) return FLAG_ON;
+  }
+
+  return FLAG_OFF;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_header_value(). */
+/* ============================================================================================================================================================= *\
+                       Return the offset of the value of a header line, or -1 if the line is not this header (case of the name is ignored).
+\* ============================================================================================================================================================= */
+static INT16 http_header_value(const UCHAR *Line, UINT16 Length, const UCHAR *Name)
+{
+  UINT16 Index;
+
+
+  for (Index = 0; Name[Index] != 0x00; ++Index)
+    if ((Index >= Length) || (tolower(Line[Index]) != tolower(Name[Index]))) return -1;
+
+  if ((Index >= Length) || (Line[Index] != ':')) return -1;
+
+  for (++Index; (Index < Length) && ((Line[Index] == ' ') || (Line[Index] == '\t')); ++Index);
+
+  return Index;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_line(). */
+/* ============================================================================================================================================================= *\
+                    Process the status line or a header line of a response (without its end-of-line). Return -1 if the connection was closed.
+\* ============================================================================================================================================================= */
+static INT16 http_line(struct struct_http_connection *Conn, const UCHAR *Line, UINT16 Length)
+{
+  UINT32 Timeout;
+
+  INT16 Value;
+
+  struct struct_http_slot *Slot;
+
+
+  Slot = &Http.Slot[Conn->Pipeline[0]];
+
+  if (Conn->ParseState == HTTP_PARSE_STATUS)
+  {
+    /* Tolerate empty lines before the status line. */
+    if (Length == 0) return 0;
+
+    if ((Length < 12) || (memcmp(Line, "HTTP/1.", 7) != 0) || !isdigit(Line[9]) || !isdigit(Line[10]) || !isdigit(Line[11])) return http_drop(Conn);
+
+    Slot->Response.Status        = http_get_number(&Line[9], 3);
+    Slot->Response.FlagChunked   = FLAG_OFF;
+    Slot->Response.FlagClose     = (Line[7] == '0') ? FLAG_ON : FLAG_OFF;   // HTTP/1.0 closes unless told otherwise.
+    Slot->Response.ContentLength = -1;
+    Conn->ParseState = HTTP_PARSE_HEADER;
+
+    if (Slot->Request.Callback != NULL) Slot->Request.Callback(HTTP_EVENT_STATUS, &Slot->Response, Line, Length, Slot->Request.Context);
+
+    return 0;
+  }
+
+  if (Conn->ParseState == HTTP_PARSE_TRAILER)
+  {
+    /* Trailer fields are ignored; an empty line ends the chunked body. */
+    if (Length == 0) return http_complete(Conn);
+    return 0;
+  }
+
+  if (Length == 0)
+  {
+    /* End of headers. An interim response (100 Continue) is followed by the real one. */
+    if ((Slot->Response.Status >= 100) && (Slot->Response.Status < 200))
+    {
+      Conn->ParseState = HTTP_PARSE_STATUS;
+      return 0;
+    }
+
+    if ((strcmp(Slot->Request.Method, "HEAD") == 0) || (Slot->Response.Status == 204) || (Slot->Response.Status == 304)) return http_complete(Conn);
+
+    if (Slot->Response.FlagChunked == FLAG_ON)
+    {
+      Conn->ParseState    = HTTP_PARSE_CHUNK_SIZE;
+      Conn->Remaining     = 0;
+      Conn->FlagDigits    = FLAG_OFF;
+      Conn->FlagExtension = FLAG_OFF;
+    }
+    else if (Slot->Response.ContentLength >= 0)
+    {
+      if (Slot->Response.ContentLength == 0) return http_complete(Conn);
+      Conn->ParseState = HTTP_PARSE_BODY;
+      Conn->Remaining  = Slot->Response.ContentLength;
+    }
+    else
+    {
+      Conn->ParseState = HTTP_PARSE_UNTIL_CLOSE;
+      Slot->Response.FlagClose = FLAG_ON;
+    }
+
+    return 0;
+  }
+
+  /* Headers driving the framing and the connection. */
+  if ((Value = http_header_value(Line, Length, "Content-Length")) >= 0)
+  {
+    Slot->Response.ContentLength = http_get_number(&Line[Value], Length - Value);
+  }
+  else if ((Value = http_header_value(Line, Length, "Transfer-Encoding")) >= 0)
+  {
+    if (http_has_token(&Line[Value], Length - Value, "chunked")) Slot->Response.FlagChunked = FLAG_ON;
+  }
+  else if ((Value = http_header_value(Line, Length, "Connection")) >= 0)
+  {
+    if (http_has_token(&Line[Value], Length - Value, "close"))      Slot->Response.FlagClose = FLAG_ON;
+    if (http_has_token(&Line[Value], Length - Value, "keep-alive")) Slot->Response.FlagClose = FLAG_OFF;
+  }
+  else if ((Value = http_header_value(Line, Length, "Keep-Alive")) >= 0)
+  {
+    /* Close an idle connection one second before the server does. */
+    for (; (Value < Length) && (tolower(Line[Value]) != 't'); ++Value);
+    if (((Length - Value) > 8) && (http_has_token(&Line[Value], 8, "timeout=")))
+    {
+      Timeout = http_get_number(&Line[Value + 8], Length - Value - 8) * 1000;
+      if (Timeout <= Conn->IdleMsec) Conn->IdleMsec = (Timeout > 1000) ? (Timeout - 1000) : 0;
+    }
+  }
+
+  if (Slot->Request.Callback != NULL) Slot->Request.Callback(HTTP_EVENT_HEADER, &Slot->Response, Line, Length, Slot->Request.Context);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_output(). */
+/* ============================================================================================================================================================= *\
+                       Write the requests of a connection, in order, as far as TCP accepts them, then push them with a single tcp_output().
+\* ============================================================================================================================================================= */
+static void http_output(struct struct_http_connection *Conn)
+{
+  UINT8 Index;
+  UINT8 Loop1UInt8;
+
+  UINT16 Available;
+
+  struct struct_http_request *Request;
+
+
+  if ((Conn->State != HTTP_CONN_READY) || (Conn->Pcb == NULL)) return;
+
+  Available = tcp_sndbuf(Conn->Pcb);
+  for (Loop1UInt8 = 0; Loop1UInt8 < Conn->Count; ++Loop1UInt8)
+  {
+    Index = Conn->Pipeline[Loop1UInt8];
+    if (Http.Slot[Index].State == HTTP_SLOT_SENT) continue;
+
+    if (Http.Slot[Index].State == HTTP_SLOT_ASSIGNED)
+    {
+      /* Build the head in the output buffer; it is written with the body. */
+      Request = &Http.Slot[Index].Request;
+      Conn->OutOffset = 0;
+      Conn->OutLength = sprintf(Conn->Out, "%s %s HTTP/1.1\r\nHost: ", Request->Method, Request->Path);
+      if (Request->Host != NULL)
+      {
+        Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], "%s", Request->Host);
+      }
+      else
+      {
+        ipaddr_ntoa_r(&Request->Address, &Conn->Out[Conn->OutLength], HTTP_OUT_SIZE - Conn->OutLength);
+        Conn->OutLength += strlen(&Conn->Out[Conn->OutLength]);
+        if (Request->Port != HTTP_DEFAULT_PORT) Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], ":%u", Request->Port);
+      }
+      if (Request->Producer != NULL)
+        Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], "\r\nTransfer-Encoding: chunked");
+      else if (Request->Body != NULL)
+        Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], "\r\nContent-Length: %lu", Request->BodyLength);
+      Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], "\r\n%s\r\n", (Request->Headers != NULL) ? Request->Headers : (const UCHAR *)"");
+
+      if (Conn->Requests) ++Http.Stats.Reused;
+      if (Loop1UInt8)
+      {
+        ++Http.Stats.Pipelined;
+        if ((Loop1UInt8 + 1) > Http.Stats.PipelineMax) Http.Stats.PipelineMax = Loop1UInt8 + 1;
+      }
+      ++Conn->Requests;
+      Http.Slot[Index].State    = HTTP_SLOT_SENDING;
+      Http.Slot[Index].SendTime = WIFI_TIME_US();
+    }
+
+    if (http_write_body(Conn, Index) != 0) break;
+    Http.Slot[Index].State = HTTP_SLOT_SENT;
+  }
+
+  /* Nothing written (no room, or producer not ready) is not activity: the response time-out keeps running. */
+  if (tcp_sndbuf(Conn->Pcb) != Available)
+  {
+    tcp_output(Conn->Pcb);
+    Conn->LastActivity = WIFI_TIME_US();
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_parse(). */
+/* ============================================================================================================================================================= *\
+                            Parse a segment of a response (one pbuf of the chain). Body fragments are given to the callback in place.
+                                                             Return -1 if the connection was closed.
+\* ============================================================================================================================================================= */
+static INT16 http_parse(struct struct_http_connection *Conn, const UCHAR *Data, UINT16 Length)
+{
+  const UCHAR *End;
+  const UCHAR *Line;
+
+  UINT16 Chunk;
+  UINT16 Index;
+  UINT16 LineLength;
+
+  struct struct_http_slot *Slot;
+
+
+  Index = 0;
+  while (Index < Length)
+  {
+    /* Data the client did not ask for. */
+    if (Conn->Count == 0) return http_drop(Conn);
+
+    Slot = &Http.Slot[Conn->Pipeline[0]];
+    if (Slot->State == HTTP_SLOT_ASSIGNED) return http_drop(Conn);
+
+    switch (Conn->ParseState)
+    {
+      case (HTTP_PARSE_STATUS):
+      case (HTTP_PARSE_HEADER):
+      case (HTTP_PARSE_TRAILER):
+        End = memchr(&Data[Index], '\n', Length - Index);
+        if (End == NULL)
+        {
+          /* Line continues in the next pbuf: keep its beginning. */
+          Chunk = Length - Index;
+          if (Chunk > (HTTP_LINE_SIZE - Conn->LineLength)) Chunk = HTTP_LINE_SIZE - Conn->LineLength;
+          memcpy(&Conn->Line[Conn->LineLength], &Data[Index], Chunk);
+          Conn->LineLength += Chunk;
+          Index = Length;
+          break;
+        }
+
+        LineLength = End - &Data[Index];
+        if (Conn->LineLength == 0)
+        {
+          Line = &Data[Index];
+        }
+        else
+        {
+          Chunk = LineLength;
+          if (Chunk > (HTTP_LINE_SIZE - Conn->LineLength)) Chunk = HTTP_LINE_SIZE - Conn->LineLength;
+          memcpy(&Conn->Line[Conn->LineLength], &Data[Index], Chunk);
+          Line       = Conn->Line;
+          LineLength = Conn->LineLength + Chunk;
+          ++Http.Stats.LinesCopied;
+        }
+        Index += (End - &Data[Index]) + 1;
+        Conn->LineLength = 0;
+        if ((LineLength) && (Line[LineLength - 1] == '\r')) --LineLength;
+
+        if (http_line(Conn, Line, LineLength) != 0) return -1;
+      break;
+
+      case (HTTP_PARSE_BODY):
+      case (HTTP_PARSE_CHUNK_DATA):
+      case (HTTP_PARSE_UNTIL_CLOSE):
+        Chunk = Length - Index;
+        if ((Conn->ParseState != HTTP_PARSE_UNTIL_CLOSE) && (Chunk > Conn->Remaining)) Chunk = Conn->Remaining;
+
+        Slot->Response.BodyBytes += Chunk;
+        Http.Stats.BytesReceived += Chunk;
+        if (Slot->Request.Callback != NULL) Slot->Request.Callback(HTTP_EVENT_BODY, &Slot->Response, &Data[Index], Chunk, Slot->Request.Context);
+        Index += Chunk;
+
+        if (Conn->ParseState == HTTP_PARSE_UNTIL_CLOSE) break;
+        Conn->Remaining -= Chunk;
+        if (Conn->Remaining) break;
+
+        if (Conn->ParseState == HTTP_PARSE_CHUNK_DATA)
+          Conn->ParseState = HTTP_PARSE_CHUNK_END;
+        else if (http_complete(Conn) != 0)
+          return -1;
+      break;
+
+      case (HTTP_PARSE_CHUNK_SIZE):
+        /* Hexadecimal size, optional extension, <CR><LF>. */
+        if (Data[Index] == '\n')
+        {
+          if (Conn->FlagDigits == FLAG_OFF) return http_drop(Conn);
+          Conn->ParseState    = (Conn->Remaining) ? HTTP_PARSE_CHUNK_DATA : HTTP_PARSE_TRAILER;
+          Conn->FlagDigits    = FLAG_OFF;
+          Conn->FlagExtension = FLAG_OFF;
+        }
+        else if ((Conn->FlagExtension == FLAG_OFF) && isxdigit(Data[Index]))
+        {
+          if (Conn->Remaining > 0x0FFFFFFF) return http_drop(Conn);
+          Conn->Remaining  = (Conn->Remaining << 4) | (isdigit(Data[Index]) ? (Data[Index] - '0') : (tolower(Data[Index]) - 'a' + 10));
+          Conn->FlagDigits = FLAG_ON;
+        }
+        else if ((Data[Index] == ';') || (Data[Index] == ' ') || (Data[Index] == '\t'))
+        {
+          Conn->FlagExtension = FLAG_ON;
+        }
+        else if ((Data[Index] != '\r') && (Conn->FlagExtension == FLAG_OFF))
+        {
+          return http_drop(Conn);
+        }
+        ++Index;
+      break;
+
+      case (HTTP_PARSE_CHUNK_END):
+        if (Data[Index] == '\n')
+        {
+          Conn->ParseState = HTTP_PARSE_CHUNK_SIZE;
+          Conn->Remaining  = 0;
+        }
+        else if (Data[Index] != '\r')
+        {
+          return http_drop(Conn);
+        }
+        ++Index;
+      break;
+    }
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_tcp_connected(). */
+/* ============================================================================================================================================================= *\
+                                                 TCP: connection established, write the requests waiting for it.
+\* ============================================================================================================================================================= */
+static err_t http_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  struct struct_http_connection *Conn;
+
+
+  Conn = (struct struct_http_connection *)Arg;
+
+  if (Error != ERR_OK)
+  {
+    http_close(Conn, FLAG_ON);
+    return ERR_ABRT;
+  }
+
+  Conn->State        = HTTP_CONN_READY;
+  Conn->LastActivity = WIFI_TIME_US();
+  Http.Stats.ConnectTimeTotalUs += (Conn->LastActivity - Conn->ConnectTime);
+  ++Http.Stats.Connects;
+
+  http_output(Conn);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                   TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void http_tcp_error(void *Arg, err_t Error)
+{
+  struct struct_http_connection *Conn;
+
+
+  Conn = (struct struct_http_connection *)Arg;
+  if (Conn == NULL) return;
+
+  /* Requests queued again are given a new connection by the timer, out of the error path of lwIP. */
+  Conn->Pcb = NULL;
+  http_close(Conn, FLAG_ON);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                          TCP: data received from the server. Each pbuf of the chain is parsed in place.
+\* ============================================================================================================================================================= */
+static err_t http_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  struct pbuf *Segment;
+
+  struct struct_http_connection *Conn;
+
+
+  Conn = (struct struct_http_connection *)Arg;
+  Http.AbortedPcb = NULL;
+
+  if (PBuf == NULL)
+  {
+    /* Connection closed by the server: this ends a body sent without length. */
+    if ((Conn->Count) && (Conn->ParseState == HTTP_PARSE_UNTIL_CLOSE))
+    {
+      http_complete(Conn);
+    }
+    else
+    {
+      ++Http.Stats.ServerCloses;
+      http_close(Conn, (Conn->Count) ? FLAG_ON : FLAG_OFF);
+    }
+    http_dispatch();
+
+    return (Http.AbortedPcb == Pcb) ? ERR_ABRT : ERR_OK;
+  }
+
+  tcp_recved(Pcb, PBuf->tot_len);
+  Conn->LastActivity = WIFI_TIME_US();
+
+  for (Segment = PBuf; (Segment != NULL) && (Conn->Pcb == Pcb); Segment = Segment->next)
+    if (http_parse(Conn, (const UCHAR *)Segment->payload, Segment->len) != 0) break;
+  pbuf_free(PBuf);
+
+  /* Connection free for the next requests, or closed: give them a connection. */
+  http_dispatch();
+
+  return (Http.AbortedPcb == Pcb) ? ERR_ABRT : ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP: data acknowledged, more may be sent.
+\* ============================================================================================================================================================= */
+static err_t http_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  struct struct_http_connection *Conn;
+
+
+  Conn = (struct struct_http_connection *)Arg;
+  Conn->LastActivity = WIFI_TIME_US();
+  http_output(Conn);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_timer(). */
+/* ============================================================================================================================================================= *\
+                     Connection time-out, response time-out and keep-alive timer (lwIP context). It only runs while there is something to do.
+\* ============================================================================================================================================================= */
+static void http_timer(void *Arg)
+{
+  UINT8 FlagActive;
+  UINT8 Loop1UInt8;
+
+  UINT64 TimeNow;
+
+  struct struct_http_connection *Conn;
+
+
+  TimeNow = WIFI_TIME_US();
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+  {
+    Conn = &Http.Conn[Loop1UInt8];
+
+    switch (Conn->State)
+    {
+      case (HTTP_CONN_CONNECTING):
+        if ((TimeNow - Conn->ConnectTime) > (HTTP_CONNECT_TIMEOUT_MSEC * 1000ull)) http_close(Conn, FLAG_ON);
+      break;
+
+      case (HTTP_CONN_READY):
+        if (Conn->Count == 0)
+        {
+          if ((TimeNow - Conn->LastActivity) > (Conn->IdleMsec * 1000ull))
+          {
+            ++Http.Stats.IdleCloses;
+            http_close(Conn, FLAG_OFF);
+          }
+        }
+        else if ((TimeNow - Conn->LastActivity) > (HTTP_RESPONSE_TIMEOUT_MSEC * 1000ull))
+        {
+          http_drop(Conn);
+        }
+        else
+        {
+          /* Producer of a streaming upload had nothing ready, or TCP had no room. */
+          http_output(Conn);
+        }
+      break;
+    }
+  }
+
+  http_dispatch();
+
+  /* Keep running while a connection is open or a request is pending. */
+  FlagActive = FLAG_OFF;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+    if (Http.Conn[Loop1UInt8].State != HTTP_CONN_FREE) FlagActive = FLAG_ON;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+    if (Http.Slot[Loop1UInt8].State != HTTP_SLOT_FREE) FlagActive = FLAG_ON;
+
+  if (FlagActive == FLAG_ON)
+    sys_timeout(HTTP_TICK_MSEC, http_timer, NULL);
+  else
+    Http.FlagTimer = FLAG_OFF;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=http_write_body(). */
+/* ============================================================================================================================================================= *\
+                     Write what is left of a request: pending head or chunk first, then the body. Return 0 once the request is fully written,
+                                                   or -1 if TCP has no room (or the producer no data) for now.
+\* ============================================================================================================================================================= */
+static INT16 http_write_body(struct struct_http_connection *Conn, UINT8 Index)
+{
+  UCHAR SizeString[8];
+
+  UINT8 HeaderLength;
+
+  UINT16 Size;
+
+  INT32 Length;
+
+  struct struct_http_request *Request;
+  struct struct_http_slot    *Slot;
+
+
+  Slot    = &Http.Slot[Index];
+  Request = &Slot->Request;
+
+  while (1)
+  {
+    /* Head or chunk built earlier and not accepted by TCP yet. */
+    if (Conn->OutLength)
+    {
+      if (tcp_sndbuf(Conn->Pcb) < Conn->OutLength) return -1;
+      if (tcp_write(Conn->Pcb, &Conn->Out[Conn->OutOffset], Conn->OutLength, TCP_WRITE_FLAG_COPY) != ERR_OK) return -1;
+      Conn->OutLength = 0;
+    }
+
+    if (Request->Producer == NULL)
+    {
+      /* Fixed body: referenced by lwIP until acknowledged, not copied. */
+      while (Slot->Sent < Request->BodyLength)
+      {
+        Length = Request->BodyLength - Slot->Sent;
+        if (Length > tcp_sndbuf(Conn->Pcb)) Length = tcp_sndbuf(Conn->Pcb);
+        if (Length == 0) return -1;
+        if (tcp_write(Conn->Pcb, (const UCHAR *)Request->Body + Slot->Sent, Length, 0) != ERR_OK) return -1;
+        Slot->Sent            += Length;
+        Http.Stats.BytesSent += Length;
+      }
+      return 0;
+    }
+
+    if (Slot->FlagEnd == FLAG_ON) return 0;
+
+    /* Streaming body: the chunk is produced in place, after room for its size, and written with a single tcp_write(). */
+    Size = tcp_sndbuf(Conn->Pcb);
+    if (Size <= (HTTP_CHUNK_HEADER + 2)) return -1;
+    Size -= (HTTP_CHUNK_HEADER + 2);
+    if (Size > HTTP_CHUNK_SIZE) Size = HTTP_CHUNK_SIZE;
+
+    Length = Request->Producer(&Conn->Out[HTTP_CHUNK_HEADER], Size, Request->Context);
+    if (Length == 0) return -1;
+
+    if (Length < 0)
+    {
+      /* Last chunk, empty trailer. */
+      Slot->FlagEnd   = FLAG_ON;
+      Conn->OutOffset = 0;
+      Conn->OutLength = sprintf(Conn->Out, "0\r\n\r\n");
+      continue;
+    }
+
+    if (Length > Size) Length = Size;
+    HeaderLength = sprintf(SizeString, "%lX\r\n", (UINT32)Length);
+    memcpy(&Conn->Out[HTTP_CHUNK_HEADER - HeaderLength], SizeString, HeaderLength);
+    Conn->Out[HTTP_CHUNK_HEADER + Length]     = '\r';
+    Conn->Out[HTTP_CHUNK_HEADER + Length + 1] = '\n';
+    Conn->OutOffset = HTTP_CHUNK_HEADER - HeaderLength;
+    Conn->OutLength = HeaderLength + Length + 2;
+    ++Http.Stats.Chunks;
+    Http.Stats.BytesSent += Length;
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_http_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                 Display HTTP client statistics.
+\* ============================================================================================================================================================= */
+void wifi_http_display_stats(void)
+{
+  struct struct_http_stats Stats;
+
+
+  wifi_http_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                       HTTP client statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Connections open:         %u / %u   established: %lu\r", Stats.Connections, HTTP_MAX_CONNECTIONS, Stats.Connects);
+  if (Stats.Connects)
+    log_info(__LINE__, __func__, "Average TCP handshake:    %llu usec\r", Stats.ConnectTimeTotalUs / Stats.Connects);
+  log_info(__LINE__, __func__, "Connections closed:       idle: %lu   by server: %lu\r", Stats.IdleCloses, Stats.ServerCloses);
+  log_info(__LINE__, __func__, "Requests:                 %lu   refused (queue full): %lu   pending: %u\r", Stats.Requests, Stats.QueueFull, Stats.Pending);
+  log_info(__LINE__, __func__, "Responses complete:       %lu   errors: %lu   retries: %lu\r", Stats.Completed, Stats.Errors, Stats.Retries);
+  log_info(__LINE__, __func__, "Reused connection:        %lu   pipelined: %lu   deepest pipeline: %u / %u\r", Stats.Reused, Stats.Pipelined, Stats.PipelineMax, HTTP_PIPELINE_MAX);
+  if (Stats.Completed)
+    log_info(__LINE__, __func__, "Average latency:          %llu usec   max: %lu usec\r", Stats.LatencyTotalUs / Stats.Completed, Stats.LatencyMaxUs);
+  log_info(__LINE__, __func__, "Body bytes sent:          %lu   (%lu chunks)   received: %lu\r", Stats.BytesSent, Stats.Chunks, Stats.BytesReceived);
+  log_info(__LINE__, __func__, "Header lines reassembled: %lu\r", Stats.LinesCopied);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_http_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                 Retrieve HTTP client statistics.
+\* ============================================================================================================================================================= */
+void wifi_http_get_stats(struct struct_http_stats *Stats)
+{
+  UINT8 Loop1UInt8;
+
+
+  WIFI_LWIP_BEGIN();
+  *Stats = Http.Stats;
+  Stats->Connections = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+    if (Http.Conn[Loop1UInt8].State != HTTP_CONN_FREE) ++Stats->Connections;
+  Stats->Pending = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+    if (Http.Slot[Loop1UInt8].State != HTTP_SLOT_FREE) ++Stats->Pending;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_http_request(). */
+/* ============================================================================================================================================================= *\
+               Queue a request. The request is written as soon as a connection to the server is available, and the callback receives the response.
+                    Return 0 on success, -1 on invalid parameter (or head too long for the output buffer), -2 if all request slots are in use.
+\* ============================================================================================================================================================= */
+INT16 wifi_http_request(const struct struct_http_request *Request)
+{
+  UINT8 Index;
+
+  UINT32 HeadLength;
+
+
+  if ((Request->Method == NULL) || (Request->Path == NULL)) return -1;
+
+  /* Head is built in the output buffer of the connection: request line, Host (address and port at most 56 bytes),
+     framing header, extra headers and blank line. */
+  HeadLength = strlen(Request->Method) + strlen(Request->Path) + ((Request->Host != NULL) ? strlen(Request->Host) : 56) + ((Request->Headers != NULL) ? strlen(Request->Headers) : 0) + 64;
+  if (HeadLength > HTTP_OUT_SIZE) return -1;
+
+  WIFI_LWIP_BEGIN();
+  for (Index = 0; Index < HTTP_QUEUE_SIZE; ++Index)
+    if (Http.Slot[Index].State == HTTP_SLOT_FREE) break;
+
+  if (Index == HTTP_QUEUE_SIZE)
+  {
+    ++Http.Stats.QueueFull;
+    WIFI_LWIP_END();
+    return -2;
+  }
+
+  memset(&Http.Slot[Index], 0x00, sizeof(Http.Slot[Index]));
+  Http.Slot[Index].Request = *Request;
+  if (Http.Slot[Index].Request.Port == 0)    Http.Slot[Index].Request.Port       = HTTP_DEFAULT_PORT;
+  if (Http.Slot[Index].Request.Body == NULL) Http.Slot[Index].Request.BodyLength = 0;
+  Http.Slot[Index].Response.ContentLength = -1;
+  Http.Slot[Index].Sequence = ++Http.Sequence;
+  Http.Slot[Index].State    = HTTP_SLOT_QUEUED;
+  ++Http.Stats.Requests;
+
+  http_dispatch();
+
+  if (Http.FlagTimer == FLAG_OFF)
+  {
+    Http.FlagTimer = FLAG_ON;
+    sys_timeout(HTTP_TICK_MSEC, http_timer, NULL);
+  }
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_http_stop(). */
+/* ============================================================================================================================================================= *\
+                                                Close all connections and fail the requests in progress or queued.
+\* ============================================================================================================================================================= */
+void wifi_http_stop(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  WIFI_LWIP_BEGIN();
+  sys_untimeout(http_timer, NULL);
+  Http.FlagTimer = FLAG_OFF;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_MAX_CONNECTIONS; ++Loop1UInt8)
+  {
+    if (Http.Conn[Loop1UInt8].State == HTTP_CONN_FREE) continue;
+
+    /* Requests are failed below rather than queued again. */
+    Http.Conn[Loop1UInt8].Count = 0;
+    http_close(&Http.Conn[Loop1UInt8], FLAG_OFF);
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+    if (Http.Slot[Loop1UInt8].State != HTTP_SLOT_FREE) http_fail(Loop1UInt8);
+  WIFI_LWIP_END();
+
+  return;
+}
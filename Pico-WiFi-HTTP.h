@@ -0,0 +1,119 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-HTTP.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-HTTP.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_HTTP_H
+#define _WIFI_HTTP_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define HTTP_DEFAULT_PORT                80
+#define HTTP_MAX_CONNECTIONS              2     // connections kept open (each one uses a TCP pcb, see MEMP_NUM_TCP_PCB).
+#define HTTP_QUEUE_SIZE                   8     // requests queued, being sent or waiting for their response.
+#define HTTP_PIPELINE_MAX                 4     // requests sent on a connection before the response to the first one is complete.
+#define HTTP_CHUNK_SIZE                 512     // largest chunk of a streaming upload; the request head, extra headers included, must also fit.
+#define HTTP_LINE_SIZE                  128     // status or header line split across two pbufs is reassembled here (longer ones are truncated).
+#define HTTP_TICK_MSEC                  250     // period of the time-out / keep-alive timer.
+#define HTTP_CONNECT_TIMEOUT_MSEC      5000     // TCP connection must be established within this delay.
+#define HTTP_RESPONSE_TIMEOUT_MSEC    10000     // a request in progress fails when nothing is received or acknowledged for this delay.
+#define HTTP_IDLE_MSEC                 4000     // idle connection closed by the client; shorter than common server time-outs (5 sec for Apache).
+#define HTTP_RETRIES                      1     // request sent again when a reused connection is closed before any answer.
+
+/* Events of the response callback. */
+#define HTTP_EVENT_STATUS                 0     // status line received (Response->Status).
+#define HTTP_EVENT_HEADER                 1     // Data is one header line, without <CR><LF>.
+#define HTTP_EVENT_BODY                   2     // Data is a fragment of the body, chunked framing removed.
+#define HTTP_EVENT_DONE                   3     // response complete.
+#define HTTP_EVENT_ERROR                  4     // request failed (connection, time-out or malformed response).
+
+
+/* Response, as known so far. */
+struct struct_http_response
+{
+  UINT16 Status;                               // 0 until the status line is received.
+  UINT8  FlagChunked;                          // body sent with chunked transfer encoding.
+  UINT8  FlagClose;                            // server closes the connection after this response.
+  INT32  ContentLength;                        // -1 if not given.
+  UINT32 BodyBytes;                            // body received so far.
+  UINT32 LatencyUs;                            // request head written to response complete (HTTP_EVENT_DONE only).
+};
+
+
+/* Response callback. Called from lwIP context, must not block. Data points into the received pbufs (nothing is copied)
+   and is only valid during the call. */
+typedef void (*http_response_callback)(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context);
+
+/* Body producer of a streaming upload. Called from lwIP context when TCP has room: fill Buffer with up to Size bytes and
+   return their number, 0 if nothing is ready yet (called again at the next acknowledgement or timer tick), or -1 at end of body. */
+typedef INT32 (*http_body_producer)(UCHAR *Buffer, UINT16 Size, void *Context);
+
+
+/* Request. The structure is copied by wifi_http_request(); strings and Body are referenced and must remain valid until
+   HTTP_EVENT_DONE or HTTP_EVENT_ERROR. */
+struct struct_http_request
+{
+  ip_addr_t Address;
+  UINT16 Port;                                 // 0 = HTTP_DEFAULT_PORT.
+  const UCHAR *Host;                           // Host header, NULL = address (and port).
+  const UCHAR *Method;                         // "GET", "POST", "PUT", "HEAD"...
+  const UCHAR *Path;
+  const UCHAR *Headers;                        // extra header lines, each one ending with <CR><LF>, NULL = none.
+  const void  *Body;                           // sent with Content-Length, without copy; NULL = no body.
+  UINT32 BodyLength;
+  http_body_producer Producer;                 // not NULL: body is produced on demand and sent with chunked transfer encoding.
+  http_response_callback Callback;             // may be NULL.
+  void  *Context;
+};
+
+
+/* Client statistics. */
+struct struct_http_stats
+{
+  UINT8  Connections;                          // connections open.
+  UINT8  Pending;                              // requests queued or in progress.
+  UINT8  PipelineMax;                          // most requests waiting for their response on one connection.
+  UINT32 Requests;                             // accepted by wifi_http_request().
+  UINT32 QueueFull;                            // refused because all request slots were in use.
+  UINT32 Completed;
+  UINT32 Errors;
+  UINT32 Retries;
+  UINT32 Connects;                             // TCP connections established.
+  UINT64 ConnectTimeTotalUs;                   // sum of TCP handshake durations.
+  UINT32 Reused;                               // requests sent on a connection that had already carried one.
+  UINT32 Pipelined;                            // requests sent while an earlier one was waiting for its response.
+  UINT32 IdleCloses;                           // connections closed by the client after HTTP_IDLE_MSEC.
+  UINT32 ServerCloses;                         // connections closed because the server asked for it (or ended the body with it).
+  UINT32 Chunks;                               // chunks sent by streaming uploads.
+  UINT32 BytesSent;                            // request bodies.
+  UINT32 BytesReceived;                        // response bodies.
+  UINT32 LinesCopied;                          // status / header lines reassembled because split across two pbufs.
+  UINT64 LatencyTotalUs;
+  UINT32 LatencyMaxUs;
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display HTTP client statistics. */
+void wifi_http_display_stats(void);
+
+/* Retrieve HTTP client statistics. */
+void wifi_http_get_stats(struct struct_http_stats *Stats);
+
+/* Queue a request. */
+INT16 wifi_http_request(const struct struct_http_request *Request);
+
+/* Close all connections and fail the requests in progress. */
+void wifi_http_stop(void);
+
+#endif  // _WIFI_HTTP_H
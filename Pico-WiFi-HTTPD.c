@@ -0,0 +1,1108 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-HTTPD.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Status web server built on the lwIP raw API, part of Pico-WiFi-Module, so that each unit may be checked from a browser.
+   - Flash content: files are gzip-compressed at build time by tools/wifi_httpd_content.py, each one stored with its complete response head.
+     A request is answered by handing the flash array to tcp_write() by reference (PBUF_ROM pbufs): no RAM buffer, no copy, no formatting.
+     ETag / If-None-Match revalidation is answered "304 Not Modified".
+   - Dynamic content: handlers given by the application render their output item by item (CGI-style paths such as "/status.json" and
+     server-side include tags <!--#tag--> in .shtml templates) into one bounded buffer per connection, sent with chunked transfer encoding.
+     The text between tags of a template is sent from flash by reference.
+   - Non-blocking: up to HTTPD_MAX_CONNECTIONS kept-alive connections; pipelined requests wait in their pbufs until the previous response
+     has been handed to lwIP. When all slots are in use, the oldest idle kept-alive connection is closed to accept a new one.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port and
+   exercised over a loopback interface with content and handlers of its own.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "ctype.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "lwip/tcp.h"
+
+#include "Pico-WiFi-HTTPD.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define HTTPD_CHUNK_HEADER     5             // chunk size in hexadecimal (3 digits at most, see HTTPD_OUT_SIZE) and <CR><LF>.
+
+/* State of a connection. */
+#define HTTPD_STATE_FREE          0
+#define HTTPD_STATE_REQUEST_LINE  1          // waiting for a request.
+#define HTTPD_STATE_HEADERS       2          // request line received, waiting for the end of the headers.
+#define HTTPD_STATE_RESPONSE      3          // response being handed to lwIP; input is held.
+
+/* Phase of a response. */
+#define HTTPD_PHASE_HEAD          0          // dynamic response head.
+#define HTTPD_PHASE_BODY          1          // handler items or template.
+#define HTTPD_PHASE_END           2          // last chunk.
+#define HTTPD_PHASE_DONE          3          // everything handed to lwIP once the buffers are empty.
+
+
+/* Connection slot. */
+struct struct_httpd_connection
+{
+  struct tcp_pcb *Pcb;
+  UINT8  State;
+  UINT8  Phase;
+  UINT8  FlagClose;                          // close once the response has been handed to lwIP.
+  UINT8  FlagChunked;                        // dynamic body sent with chunked transfer encoding.
+  UINT8  FlagHead;                           // HEAD request: response head only.
+  UINT8  FlagGzip;                           // client accepts gzip content encoding.
+  UINT8  FlagNotModified;                    // If-None-Match holds the ETag of File.
+  UINT16 Status;                             // error found in the request, 0 if none.
+  UCHAR  Line[HTTPD_LINE_SIZE];
+  UINT16 LineLength;
+  const struct struct_httpd_file *File;      // file requested (static or template).
+  const struct struct_httpd_handler *Handler;  // path handler requested, or tag handler of the template being rendered.
+  UINT16 Item;                               // next item of Handler.
+  UINT32 TemplateOffset;                     // next byte of the template to process.
+  const UCHAR *Rom;                          // flash data sent by reference.
+  UINT32 RomLength;
+  const UCHAR *Tail;                         // constant sent by reference after Rom (end of chunk).
+  UINT8  TailLength;
+  UCHAR  Out[HTTPD_OUT_SIZE];                // rendered output, sent with copy before Rom.
+  UINT16 OutOffset;
+  UINT16 OutLength;
+  struct pbuf *Input;                        // data received and not processed yet (pipelined requests wait here).
+  UINT16 InputOffset;
+  UINT32 Requests;
+  UINT64 LastActivity;
+  UINT64 RequestTime;                        // end of the request being answered.
+};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UINT8  FlagRunning;
+  UINT8  HandlerCount;
+  UINT16 Port;
+  const struct struct_httpd_handler *Handlers;  // handler table of the application.
+  void  *Context;
+  struct tcp_pcb *ListenPcb;
+  struct struct_httpd_stats Stats;
+  struct struct_httpd_connection Conn[HTTPD_MAX_CONNECTIONS];
+} Httpd;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Close a connection. */
+static err_t httpd_close(struct struct_httpd_connection *Conn);
+
+/* Build the error response of a request. */
+static void httpd_error(struct struct_httpd_connection *Conn);
+
+/* Produce the next part of a response. */
+static void httpd_fill(struct struct_httpd_connection *Conn);
+
+/* Tell if a header value contains a token (case is ignored). */
+static UINT8 httpd_has_token(const UCHAR *Value, const UCHAR *Token);
+
+/* Process a header line of a request. */
+static void httpd_header(struct struct_httpd_connection *Conn);
+
+/* Return the value of a header line, or NULL if the line is not this header. */
+static const UCHAR *httpd_header_value(const UCHAR *Line, const UCHAR *Name);
+
+/* Process the data received until a request is complete. */
+static err_t httpd_input(struct struct_httpd_connection *Conn);
+
+/* Render items of the current handler into the output buffer. */
+static void httpd_render(struct struct_httpd_connection *Conn);
+
+/* Process the request line. */
+static void httpd_request_line(struct struct_httpd_connection *Conn);
+
+/* Start the response to a complete request. */
+static err_t httpd_respond(struct struct_httpd_connection *Conn);
+
+/* Hand the response to lwIP, as far as the TCP send buffer allows. */
+static err_t httpd_send(struct struct_httpd_connection *Conn);
+
+/* TCP: new connection. */
+static err_t httpd_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error);
+
+/* TCP: connection error. */
+static void httpd_tcp_error(void *Arg, err_t Error);
+
+/* TCP: periodic poll. */
+static err_t httpd_tcp_poll(void *Arg, struct tcp_pcb *Pcb);
+
+/* TCP: data received. */
+static err_t httpd_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged by the peer. */
+static err_t httpd_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_close(). */
+/* ============================================================================================================================================================= *\
+                       Close a connection (data already given to lwIP is still sent). Return ERR_ABRT if the connection had to be aborted:
+                              a lwIP callback of this connection must then return ERR_ABRT. Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static err_t httpd_close(struct struct_httpd_connection *Conn)
+{
+  err_t ReturnCode;
+
+
+  ReturnCode = ERR_OK;
+  if (Conn->Pcb != NULL)
+  {
+    tcp_arg(Conn->Pcb,  NULL);
+    tcp_err(Conn->Pcb,  NULL);
+    tcp_recv(Conn->Pcb, NULL);
+    tcp_sent(Conn->Pcb, NULL);
+    tcp_poll(Conn->Pcb, NULL, 0);
+    if (tcp_close(Conn->Pcb) != ERR_OK)
+    {
+      tcp_abort(Conn->Pcb);
+      ReturnCode = ERR_ABRT;
+    }
+    Conn->Pcb = NULL;
+    --Httpd.Stats.Connections;
+  }
+
+  if (Conn->Input != NULL)
+  {
+    pbuf_free(Conn->Input);
+    Conn->Input = NULL;
+  }
+  Conn->State = HTTPD_STATE_FREE;
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_error(). */
+/* ============================================================================================================================================================= *\
+                         Build the error response of a request in the output buffer. The connection is closed after a malformed request,
+                                              since the rest of the input may not be trusted to start a new request.
+\* ============================================================================================================================================================= */
+static void httpd_error(struct struct_httpd_connection *Conn)
+{
+  const UCHAR *Text;
+
+
+  switch (Conn->Status)
+  {
+    case (404):
+      Text = "Not Found";
+    break;
+
+    case (405):
+      Text = "Method Not Allowed";
+    break;
+
+    case (406):
+      Text = "Not Acceptable";  // content is stored gzip-compressed only.
+    break;
+
+    case (414):
+      Text = "URI Too Long";
+      Conn->FlagClose = FLAG_ON;
+    break;
+
+    default:
+      Conn->Status    = 400;
+      Text            = "Bad Request";
+      Conn->FlagClose = FLAG_ON;
+    break;
+  }
+
+  Conn->OutLength = sprintf(Conn->Out, "HTTP/1.1 %u %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\n%s\r\n", Conn->Status, Text, strlen(Text) + 2,
+                            Conn->FlagClose ? "Connection: close\r\n" : "");
+  if (Conn->FlagHead == FLAG_OFF) Conn->OutLength += sprintf(&Conn->Out[Conn->OutLength], "%s\r\n", Text);
+  Conn->OutOffset = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_fill(). */
+/* ============================================================================================================================================================= *\
+                  Produce the next part of a response, once everything produced before has been handed to lwIP: the head of a dynamic response,
+                               items of a handler, or the next span of a template (sent from flash by reference, between two tags).
+\* ============================================================================================================================================================= */
+static void httpd_fill(struct struct_httpd_connection *Conn)
+{
+  const UCHAR *Template;
+
+  UINT8 Loop1UInt8;
+
+  UINT32 End;
+  UINT32 Length;
+  UINT32 Offset;
+
+
+  switch (Conn->Phase)
+  {
+    case (HTTPD_PHASE_HEAD):
+      Conn->OutLength = snprintf(Conn->Out, sizeof(Conn->Out), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nCache-Control: no-store\r\n%s\r\n",
+                                 (Conn->File != NULL) ? Conn->File->ContentType : Conn->Handler->ContentType,
+                                 Conn->FlagChunked ? "Transfer-Encoding: chunked\r\n" : "Connection: close\r\n");
+      Conn->OutOffset = 0;
+      Conn->Phase     = (Conn->FlagHead) ? HTTPD_PHASE_DONE : HTTPD_PHASE_BODY;
+    break;
+
+    case (HTTPD_PHASE_BODY):
+      if (Conn->Handler != NULL)
+      {
+        httpd_render(Conn);
+        break;
+      }
+
+      /* Template: send the text up to the next tag by reference, or start rendering the tag. */
+      Template = Conn->File->Data;
+      Length   = Conn->File->Length;
+      Offset   = Conn->TemplateOffset;
+      if (Offset >= Length)
+      {
+        Conn->Phase = HTTPD_PHASE_END;
+        break;
+      }
+
+      for (End = Offset; (End + 5) <= Length; ++End)
+        if ((Template[End] == '<') && (memcmp(&Template[End], "<!--#", 5) == 0)) break;
+      if ((End + 5) > Length) End = Length;
+
+      if (End == Offset)
+      {
+        /* Tag name ends with "-->"; a tag too long or not closed is sent as text. */
+        for (End = Offset + 5; ((End + 3) <= Length) && ((End - Offset - 5) <= HTTPD_TAG_SIZE); ++End)
+          if (memcmp(&Template[End], "-->", 3) == 0) break;
+        if (((End + 3) > Length) || ((End - Offset - 5) > HTTPD_TAG_SIZE))
+        {
+          End = Offset + 5;
+        }
+        else
+        {
+          Conn->TemplateOffset = End + 3;
+          for (Loop1UInt8 = 0; Loop1UInt8 < Httpd.HandlerCount; ++Loop1UInt8)
+          {
+            if ((Httpd.Handlers[Loop1UInt8].Name[0] != '/') && (strlen(Httpd.Handlers[Loop1UInt8].Name) == (End - Offset - 5)) &&
+                (memcmp(Httpd.Handlers[Loop1UInt8].Name, &Template[Offset + 5], End - Offset - 5) == 0))
+            {
+              Conn->Handler = &Httpd.Handlers[Loop1UInt8];
+              Conn->Item    = 0;
+              break;
+            }
+          }
+          /* Unknown tags render nothing. */
+          break;
+        }
+      }
+
+      Conn->Rom             = &Template[Offset];
+      Conn->RomLength       = End - Offset;
+      Conn->TemplateOffset  = End;
+      if (Conn->FlagChunked)
+      {
+        Conn->OutLength  = sprintf(Conn->Out, "%lX\r\n", Conn->RomLength);
+        Conn->OutOffset  = 0;
+        Conn->Tail       = "\r\n";
+        Conn->TailLength = 2;
+      }
+    break;
+
+    case (HTTPD_PHASE_END):
+      if (Conn->FlagChunked)
+      {
+        Conn->Tail       = "0\r\n\r\n";
+        Conn->TailLength = 5;
+      }
+      Conn->Phase = HTTPD_PHASE_DONE;
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_has_token(). */
+/* ============================================================================================================================================================= *\
+                                                    Tell if a header value contains a token (case is ignored).
+\* ============================================================================================================================================================= */
+static UINT8 httpd_has_token(const UCHAR *Value, const UCHAR *Token)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+
+
+  for (Loop1UInt16 = 0; Value[Loop1UInt16] != 0x00; ++Loop1UInt16)
+  {
+    for (Loop2UInt16 = 0; Token[Loop2UInt16] != 0x00; ++Loop2UInt16)
+      if (tolower(Value[Loop1UInt16 + Loop2UInt16]) != Token[Loop2UInt16]) break;
+    if (Token[Loop2UInt16] == 0x00) return FLAG_ON;
+  }
+
+  return FLAG_OFF;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_header(). */
+/* ============================================================================================================================================================= *\
+                   Process a header line of a request. Only the headers changing the response are looked at; lines longer than the line buffer
+                                                           are truncated, which keeps their beginning.
+\* ============================================================================================================================================================= */
+static void httpd_header(struct struct_httpd_connection *Conn)
+{
+  UCHAR ETag[11];
+
+  const UCHAR *Value;
+
+
+  if ((Value = httpd_header_value(Conn->Line, "Connection")) != NULL)
+  {
+    if (httpd_has_token(Value, "close")) Conn->FlagClose = FLAG_ON;
+  }
+  else if ((Value = httpd_header_value(Conn->Line, "Accept-Encoding")) != NULL)
+  {
+    if (httpd_has_token(Value, "gzip")) Conn->FlagGzip = FLAG_ON;
+  }
+  else if ((Value = httpd_header_value(Conn->Line, "If-None-Match")) != NULL)
+  {
+    if ((Conn->File != NULL) && ((Conn->File->Flags & HTTPD_FILE_SSI) == 0))
+    {
+      sprintf(ETag, "\"%08lx\"", Conn->File->ETag);
+      if (strstr(Value, ETag) != NULL) Conn->FlagNotModified = FLAG_ON;
+    }
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_header_value(). */
+/* ============================================================================================================================================================= *\
+                Return the value of a header line (leading blanks skipped), or NULL if the line is not this header (case of the name is ignored).
+\* ============================================================================================================================================================= */
+static const UCHAR *httpd_header_value(const UCHAR *Line, const UCHAR *Name)
+{
+  UINT16 Index;
+
+
+  for (Index = 0; Name[Index] != 0x00; ++Index)
+    if (tolower(Line[Index]) != tolower(Name[Index])) return NULL;
+
+  if (Line[Index] != ':') return NULL;
+
+  for (++Index; (Line[Index] == ' ') || (Line[Index] == '\t'); ++Index);
+
+  return &Line[Index];
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_input(). */
+/* ============================================================================================================================================================= *\
+                 Process the data received until a request is complete, then answer it. Input following a request (pipelining) stays in its pbufs
+                 until the response has been handed to lwIP, which also throttles the client through the TCP receive window. Lines end with <LF>
+                    (a <CR> before it is dropped). Return ERR_ABRT if the connection has been aborted. Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static err_t httpd_input(struct struct_httpd_connection *Conn)
+{
+  UCHAR Character;
+
+  err_t ReturnCode;
+
+
+  while ((Conn->Input != NULL) && (Conn->State != HTTPD_STATE_RESPONSE))
+  {
+    Character = pbuf_get_at(Conn->Input, Conn->InputOffset++);
+    if (Conn->InputOffset >= Conn->Input->tot_len)
+    {
+      /* Whole pbuf processed: open the receive window again. */
+      tcp_recved(Conn->Pcb, Conn->Input->tot_len);
+      pbuf_free(Conn->Input);
+      Conn->Input       = NULL;
+      Conn->InputOffset = 0;
+    }
+
+    if (Character == '\r') continue;
+
+    if (Character != '\n')
+    {
+      if (Conn->LineLength < (HTTPD_LINE_SIZE - 1))
+        Conn->Line[Conn->LineLength++] = Character;
+      else if ((Conn->State == HTTPD_STATE_REQUEST_LINE) && (Conn->Status == 0))
+        Conn->Status = 414;
+      continue;
+    }
+
+    Conn->Line[Conn->LineLength] = 0x00;
+    if (Conn->State == HTTPD_STATE_REQUEST_LINE)
+    {
+      /* Empty lines before a request are ignored. */
+      if (Conn->LineLength > 0)
+      {
+        httpd_request_line(Conn);
+        Conn->State = HTTPD_STATE_HEADERS;
+      }
+    }
+    else if (Conn->LineLength > 0)
+    {
+      httpd_header(Conn);
+    }
+    else
+    {
+      Conn->LineLength = 0;
+      ReturnCode = httpd_respond(Conn);
+      if ((ReturnCode != ERR_OK) || (Conn->Pcb == NULL)) return ReturnCode;
+    }
+    Conn->LineLength = 0;
+  }
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_render(). */
+/* ============================================================================================================================================================= *\
+               Render items of the current handler into the output buffer, as many as fit, framed as one chunk. An item that does not fit is asked
+                again with an empty buffer, then truncated. When the handler has no more item, the template goes on (tag) or the body ends (path).
+\* ============================================================================================================================================================= */
+static void httpd_render(struct struct_httpd_connection *Conn)
+{
+  UCHAR Header[HTTPD_CHUNK_HEADER + 1];
+
+  INT16 Length;
+  INT16 Room;
+
+  UINT8 FlagLast;
+
+  UINT16 Position;
+  UINT16 Start;
+
+
+  FlagLast = FLAG_OFF;
+  Start    = (Conn->FlagChunked) ? HTTPD_CHUNK_HEADER : 0;
+  Position = Start;
+  while ((Room = HTTPD_OUT_SIZE - Position - 2) > 1)
+  {
+    Length = Conn->Handler->Render(Conn->Handler->Name, Conn->Item, &Conn->Out[Position], Room, Httpd.Context);
+    if (Length < 0)
+    {
+      FlagLast = FLAG_ON;
+      break;
+    }
+    if (Length >= Room)
+    {
+      /* Send what has been rendered so far and ask again with the whole buffer. */
+      if (Position > Start) break;
+      Length = Room - 1;
+      ++Httpd.Stats.Truncated;
+    }
+    Position += Length;
+    ++Conn->Item;
+  }
+
+  if (FlagLast)
+  {
+    if (Conn->File != NULL)
+      Conn->Handler = NULL;  // end of tag, back to the template.
+    else
+      Conn->Phase = HTTPD_PHASE_END;
+  }
+
+  if (Position == Start) return;
+
+  Conn->OutOffset = 0;
+  if (Conn->FlagChunked)
+  {
+    Length = sprintf(Header, "%X\r\n", Position - Start);
+    Conn->OutOffset = Start - Length;
+    memcpy(&Conn->Out[Conn->OutOffset], Header, Length);
+    Conn->Out[Position++] = '\r';
+    Conn->Out[Position++] = '\n';
+  }
+  Conn->OutLength = Position;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_request_line(). */
+/* ============================================================================================================================================================= *\
+                  Process the request line: method, path (query string ignored) and version. The path is looked up at once in the handler table,
+                                 then in the flash content ("/" is "/index.html"), so that only the target is kept, not the path.
+\* ============================================================================================================================================================= */
+static void httpd_request_line(struct struct_httpd_connection *Conn)
+{
+  UCHAR *Path;
+  UCHAR *Pointer;
+  UCHAR *Version;
+
+  UINT8 Loop1UInt8;
+
+
+  if (Conn->Status != 0) return;
+
+  if (((Path = strchr(Conn->Line, ' ')) == NULL) || ((Version = strchr(Path + 1, ' ')) == NULL) || (strncmp(Version + 1, "HTTP/1.", 7) != 0))
+  {
+    Conn->Status = 400;
+    return;
+  }
+  *Path++    = 0x00;
+  *Version++ = 0x00;
+
+  /* HTTP/1.0 clients do not know chunked transfer encoding: dynamic content ends with the connection. */
+  if (strcmp(Version, "HTTP/1.0") == 0) Conn->FlagClose = FLAG_ON;
+
+  if (strcmp(Conn->Line, "HEAD") == 0)
+  {
+    Conn->FlagHead = FLAG_ON;
+  }
+  else if (strcmp(Conn->Line, "GET") != 0)
+  {
+    Conn->Status = 405;
+    return;
+  }
+
+  if ((Pointer = strchr(Path, '?')) != NULL) *Pointer = 0x00;
+  if (strcmp(Path, "/") == 0) Path = "/index.html";
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Httpd.HandlerCount; ++Loop1UInt8)
+  {
+    if (strcmp(Path, Httpd.Handlers[Loop1UInt8].Name) == 0)
+    {
+      Conn->Handler = &Httpd.Handlers[Loop1UInt8];
+      return;
+    }
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < HttpdFileCount; ++Loop1UInt8)
+  {
+    if (strcmp(Path, HttpdFile[Loop1UInt8].Name) == 0)
+    {
+      Conn->File = &HttpdFile[Loop1UInt8];
+      return;
+    }
+  }
+
+  Conn->Status = 404;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_respond(). */
+/* ============================================================================================================================================================= *\
+                   Start the response to a complete request. A static file is answered by its flash array alone (head and body, by reference).
+                                                             Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static err_t httpd_respond(struct struct_httpd_connection *Conn)
+{
+  Conn->State       = HTTPD_STATE_RESPONSE;
+  Conn->Phase       = HTTPD_PHASE_DONE;
+  Conn->RequestTime = WIFI_TIME_US();
+  Conn->OutLength   = 0;
+  Conn->OutOffset   = 0;
+  Conn->RomLength   = 0;
+  Conn->TailLength  = 0;
+  Conn->Item        = 0;
+  Conn->TemplateOffset = 0;
+  ++Httpd.Stats.Requests;
+  if (Conn->Requests++ > 0) ++Httpd.Stats.KeepAlive;
+
+  if ((Conn->Status == 0) && (Conn->File != NULL) && (Conn->File->Flags & HTTPD_FILE_GZIP) && (Conn->FlagGzip == FLAG_OFF)) Conn->Status = 406;
+
+  if (Conn->Status != 0)
+  {
+    ++Httpd.Stats.Errors;
+    httpd_error(Conn);
+  }
+  else if ((Conn->Handler != NULL) || (Conn->File->Flags & HTTPD_FILE_SSI))
+  {
+    ++Httpd.Stats.Dynamic;
+    Conn->FlagChunked = (Conn->FlagClose) ? FLAG_OFF : FLAG_ON;
+    Conn->Phase       = HTTPD_PHASE_HEAD;
+  }
+  else if (Conn->FlagNotModified)
+  {
+    ++Httpd.Stats.NotModified;
+    Conn->OutLength = sprintf(Conn->Out, "HTTP/1.1 304 Not Modified\r\nETag: \"%08lx\"\r\n\r\n", Conn->File->ETag);
+  }
+  else
+  {
+    ++Httpd.Stats.Static;
+    Conn->Rom       = Conn->File->Data;
+    Conn->RomLength = (Conn->FlagHead) ? Conn->File->HeadLength : Conn->File->Length;
+  }
+
+  return httpd_send(Conn);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_send(). */
+/* ============================================================================================================================================================= *\
+                Hand the response to lwIP, as far as the TCP send buffer allows: rendered output with copy, then flash data by reference, then the
+               end of chunk; then produce the next part. The rest is sent when the client acknowledges data (see httpd_tcp_sent()). Once the whole
+                response has been handed to lwIP, the connection waits for the next request, or is closed. Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static err_t httpd_send(struct struct_httpd_connection *Conn)
+{
+  UINT16 Length;
+
+  UINT32 Elapsed;
+
+
+  while (Conn->State == HTTPD_STATE_RESPONSE)
+  {
+    if (Conn->OutOffset < Conn->OutLength)
+    {
+      Length = Conn->OutLength - Conn->OutOffset;
+      if (Length > tcp_sndbuf(Conn->Pcb)) Length = tcp_sndbuf(Conn->Pcb);
+      if ((Length == 0) || (tcp_write(Conn->Pcb, &Conn->Out[Conn->OutOffset], Length, TCP_WRITE_FLAG_COPY) != ERR_OK)) break;
+      Conn->OutOffset += Length;
+      Httpd.Stats.BytesCopied += Length;
+      continue;
+    }
+    Conn->OutOffset = 0;
+    Conn->OutLength = 0;
+
+    if (Conn->RomLength > 0)
+    {
+      Length = (Conn->RomLength > tcp_sndbuf(Conn->Pcb)) ? tcp_sndbuf(Conn->Pcb) : Conn->RomLength;
+      if ((Length == 0) || (tcp_write(Conn->Pcb, Conn->Rom, Length, 0) != ERR_OK)) break;
+      Conn->Rom       += Length;
+      Conn->RomLength -= Length;
+      Httpd.Stats.BytesReferenced += Length;
+      continue;
+    }
+
+    if (Conn->TailLength > 0)
+    {
+      if ((tcp_sndbuf(Conn->Pcb) < Conn->TailLength) || (tcp_write(Conn->Pcb, Conn->Tail, Conn->TailLength, 0) != ERR_OK)) break;
+      Httpd.Stats.BytesReferenced += Conn->TailLength;
+      Conn->TailLength = 0;
+      continue;
+    }
+
+    if (Conn->Phase != HTTPD_PHASE_DONE)
+    {
+      httpd_fill(Conn);
+      continue;
+    }
+
+    /* Whole response handed to lwIP. */
+    Elapsed = WIFI_TIME_US() - Conn->RequestTime;
+    Httpd.Stats.ServiceTotalUs += Elapsed;
+    if (Elapsed > Httpd.Stats.ServiceMaxUs) Httpd.Stats.ServiceMaxUs = Elapsed;
+
+    Conn->State           = HTTPD_STATE_REQUEST_LINE;
+    Conn->Status          = 0;
+    Conn->File            = NULL;
+    Conn->Handler         = NULL;
+    Conn->FlagHead        = FLAG_OFF;
+    Conn->FlagGzip        = FLAG_OFF;
+    Conn->FlagChunked     = FLAG_OFF;
+    Conn->FlagNotModified = FLAG_OFF;
+    tcp_output(Conn->Pcb);
+    if (Conn->FlagClose) return httpd_close(Conn);
+
+    return ERR_OK;
+  }
+  tcp_output(Conn->Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tcp_accept(). */
+/* ============================================================================================================================================================= *\
+                   TCP: new connection. When all slots are in use, the oldest idle kept-alive connection is closed to make room (browsers keep
+                           several connections open); if none is idle, the connection is answered "503 Service Unavailable" and closed.
+\* ============================================================================================================================================================= */
+static err_t httpd_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_httpd_connection *Conn;
+  struct struct_httpd_connection *Idle;
+
+
+  if ((Error != ERR_OK) || (NewPcb == NULL)) return ERR_VAL;
+
+  Conn = NULL;
+  Idle = NULL;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTPD_MAX_CONNECTIONS; ++Loop1UInt8)
+  {
+    if (Httpd.Conn[Loop1UInt8].State == HTTPD_STATE_FREE)
+    {
+      Conn = &Httpd.Conn[Loop1UInt8];
+      break;
+    }
+    if ((Httpd.Conn[Loop1UInt8].State == HTTPD_STATE_REQUEST_LINE) && (Httpd.Conn[Loop1UInt8].LineLength == 0) && (Httpd.Conn[Loop1UInt8].Input == NULL) &&
+        (Httpd.Conn[Loop1UInt8].Requests > 0) && ((Idle == NULL) || (Httpd.Conn[Loop1UInt8].LastActivity < Idle->LastActivity)))
+      Idle = &Httpd.Conn[Loop1UInt8];
+  }
+
+  if ((Conn == NULL) && (Idle != NULL))
+  {
+    ++Httpd.Stats.Evicted;
+    httpd_close(Idle);
+    Conn = Idle;
+  }
+
+  if (Conn == NULL)
+  {
+    ++Httpd.Stats.Refused;
+    tcp_write(NewPcb, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+              sizeof("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n") - 1, 0);
+    if (tcp_close(NewPcb) != ERR_OK)
+    {
+      tcp_abort(NewPcb);
+      return ERR_ABRT;
+    }
+    return ERR_OK;
+  }
+
+  memset(Conn, 0x00, sizeof(*Conn));
+  Conn->Pcb          = NewPcb;
+  Conn->State        = HTTPD_STATE_REQUEST_LINE;
+  Conn->LastActivity = WIFI_TIME_US();
+  ++Httpd.Stats.Accepted;
+  ++Httpd.Stats.Connections;
+
+  tcp_setprio(NewPcb, TCP_PRIO_MIN);  // first to go if lwIP runs out of pcbs.
+  tcp_arg(NewPcb, Conn);
+  tcp_err(NewPcb, httpd_tcp_error);
+  tcp_recv(NewPcb, httpd_tcp_receive);
+  tcp_sent(NewPcb, httpd_tcp_sent);
+  tcp_poll(NewPcb, httpd_tcp_poll, HTTPD_POLL_TICKS);
+  tcp_nagle_disable(NewPcb);  // writes are already batched; the last segment of a response goes out at once.
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                   TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void httpd_tcp_error(void *Arg, err_t Error)
+{
+  struct struct_httpd_connection *Conn;
+
+
+  if ((Conn = (struct struct_httpd_connection *)Arg) == NULL) return;
+
+  Conn->Pcb = NULL;
+  --Httpd.Stats.Connections;
+  httpd_close(Conn);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tcp_poll(). */
+/* ============================================================================================================================================================= *\
+                       TCP: periodic poll. Retry output that lwIP could not queue, and close connections without traffic for HTTPD_IDLE_SEC
+                                   (idle kept-alive connections, clients that stopped sending a request or reading a response).
+\* ============================================================================================================================================================= */
+static err_t httpd_tcp_poll(void *Arg, struct tcp_pcb *Pcb)
+{
+  err_t ReturnCode;
+
+  struct struct_httpd_connection *Conn;
+
+
+  Conn = (struct struct_httpd_connection *)Arg;
+
+  if ((WIFI_TIME_US() - Conn->LastActivity) >= (HTTPD_IDLE_SEC * 1000000ull)) return httpd_close(Conn);
+
+  if (Conn->State == HTTPD_STATE_RESPONSE)
+  {
+    ReturnCode = httpd_send(Conn);
+    if ((ReturnCode != ERR_OK) || (Conn->Pcb == NULL)) return ReturnCode;
+    return httpd_input(Conn);
+  }
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                     TCP: data received. Data is kept as received (no copy) until processed by httpd_input().
+\* ============================================================================================================================================================= */
+static err_t httpd_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  struct struct_httpd_connection *Conn;
+
+
+  Conn = (struct struct_httpd_connection *)Arg;
+
+  /* Client closed the connection. */
+  if (PBuf == NULL) return httpd_close(Conn);
+
+  if (Conn->Input == NULL)
+  {
+    Conn->Input       = PBuf;
+    Conn->InputOffset = 0;
+  }
+  else
+  {
+    /* A response is in progress: keep the data for later. */
+    pbuf_cat(Conn->Input, PBuf);
+  }
+  Conn->LastActivity = WIFI_TIME_US();
+
+  return httpd_input(Conn);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=httpd_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                     TCP: data acknowledged by the client. Hand more of the response to lwIP; once it is complete, process the requests held.
+\* ============================================================================================================================================================= */
+static err_t httpd_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length)
+{
+  err_t ReturnCode;
+
+  struct struct_httpd_connection *Conn;
+
+
+  Conn = (struct struct_httpd_connection *)Arg;
+  Conn->LastActivity = WIFI_TIME_US();
+
+  if (Conn->State != HTTPD_STATE_RESPONSE) return ERR_OK;
+
+  ReturnCode = httpd_send(Conn);
+  if ((ReturnCode != ERR_OK) || (Conn->Pcb == NULL)) return ReturnCode;
+
+  return httpd_input(Conn);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_httpd_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                               Display status server statistics, with its RAM and flash footprint.
+\* ============================================================================================================================================================= */
+void wifi_httpd_display_stats(void)
+{
+  struct struct_httpd_stats Stats;
+
+
+  wifi_httpd_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                   HTTP status server statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Listening:                %s   port: %u\r", (Httpd.FlagRunning) ? "Yes" : "No", Httpd.Port);
+  log_info(__LINE__, __func__, "Connections open:         %u / %u   accepted: %lu\r", Stats.Connections, HTTPD_MAX_CONNECTIONS, Stats.Accepted);
+  log_info(__LINE__, __func__, "Connections refused:      %lu   idle closed to make room: %lu\r", Stats.Refused, Stats.Evicted);
+  log_info(__LINE__, __func__, "Requests:                 %lu   on kept-alive connections: %lu\r", Stats.Requests, Stats.KeepAlive);
+  log_info(__LINE__, __func__, "Answers:                  static: %lu   not modified: %lu   dynamic: %lu   errors: %lu\r", Stats.Static, Stats.NotModified,
+           Stats.Dynamic, Stats.Errors);
+  log_info(__LINE__, __func__, "Bytes sent from flash:    %lu   (by reference, no copy)\r", Stats.BytesReferenced);
+  log_info(__LINE__, __func__, "Bytes rendered:           %lu   (copied)   items truncated: %lu\r", Stats.BytesCopied, Stats.Truncated);
+  if (Stats.Requests)
+    log_info(__LINE__, __func__, "Service time:             average: %llu usec   max: %lu usec\r", Stats.ServiceTotalUs / Stats.Requests, Stats.ServiceMaxUs);
+  log_info(__LINE__, __func__, "RAM:                      %lu bytes   (%u connections of %u bytes)\r", Stats.RamBytes, HTTPD_MAX_CONNECTIONS,
+           sizeof(struct struct_httpd_connection));
+  log_info(__LINE__, __func__, "Flash content:            %lu bytes   (%u files)\r", Stats.FlashBytes, HttpdFileCount);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_httpd_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                Retrieve status server statistics.
+\* ============================================================================================================================================================= */
+void wifi_httpd_get_stats(struct struct_httpd_stats *Stats)
+{
+  UINT8 Loop1UInt8;
+
+
+  WIFI_LWIP_BEGIN();
+  *Stats = Httpd.Stats;
+  WIFI_LWIP_END();
+
+  Stats->RamBytes   = sizeof(Httpd);
+  Stats->FlashBytes = HttpdFileCount * sizeof(HttpdFile[0]);
+  for (Loop1UInt8 = 0; Loop1UInt8 < HttpdFileCount; ++Loop1UInt8)
+    Stats->FlashBytes += HttpdFile[Loop1UInt8].Length;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_httpd_start(). */
+/* ============================================================================================================================================================= *\
+                 Start listening for HTTP requests on Port (HTTPD_DEFAULT_PORT if 0). Handlers is the handler table of the application (paths and
+                         server-side include tags), and Context is given to its render functions. May be called before the network is up.
+\* ============================================================================================================================================================= */
+INT16 wifi_httpd_start(UINT16 Port, const struct struct_httpd_handler *Handlers, UINT8 HandlerCount, void *Context)
+{
+  err_t ReturnCode;
+
+  struct tcp_pcb *Pcb;
+
+
+  if (Httpd.FlagRunning) return -1;
+
+  WIFI_LWIP_BEGIN();
+  Httpd.Handlers     = Handlers;
+  Httpd.HandlerCount = HandlerCount;
+  Httpd.Context      = Context;
+  Httpd.Port         = (Port == 0) ? HTTPD_DEFAULT_PORT : Port;
+
+  ReturnCode = ERR_MEM;
+  if ((Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY)) != NULL)
+  {
+    if ((ReturnCode = tcp_bind(Pcb, IP_ANY_TYPE, Httpd.Port)) != ERR_OK)
+    {
+      tcp_close(Pcb);
+    }
+    else if ((Httpd.ListenPcb = tcp_listen_with_backlog(Pcb, HTTPD_MAX_CONNECTIONS)) == NULL)
+    {
+      tcp_close(Pcb);
+      ReturnCode = ERR_MEM;
+    }
+    else
+    {
+      tcp_accept(Httpd.ListenPcb, httpd_tcp_accept);
+      Httpd.FlagRunning = FLAG_ON;
+    }
+  }
+  WIFI_LWIP_END();
+
+  return (ReturnCode == ERR_OK) ? 0 : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_httpd_stop(). */
+/* ============================================================================================================================================================= *\
+                                        Stop listening and close all connections (for example before cyw43_arch_deinit()).
+\* ============================================================================================================================================================= */
+void wifi_httpd_stop(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  WIFI_LWIP_BEGIN();
+  if (Httpd.ListenPcb != NULL)
+  {
+    tcp_close(Httpd.ListenPcb);
+    Httpd.ListenPcb = NULL;
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTPD_MAX_CONNECTIONS; ++Loop1UInt8)
+    if (Httpd.Conn[Loop1UInt8].State != HTTPD_STATE_FREE) httpd_close(&Httpd.Conn[Loop1UInt8]);
+
+  Httpd.FlagRunning = FLAG_OFF;
+  WIFI_LWIP_END();
+
+  return;
+}
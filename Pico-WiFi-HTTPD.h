@@ -0,0 +1,103 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-HTTPD.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-HTTPD.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_HTTPD_H
+#define _WIFI_HTTPD_H
+
+#include "Pico-WiFi-Port.h"
+#include "lwip/tcp.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define HTTPD_DEFAULT_PORT              80     // TCP port of the status server (may be given by WIFI_HTTPD_PORT in CMakeLists.txt).
+#define HTTPD_MAX_CONNECTIONS            3     // concurrent connections (each one uses a TCP pcb, see MEMP_NUM_TCP_PCB).
+#define HTTPD_LINE_SIZE                 96     // request line (method, path and version) or start of a header line, plus end-of-string.
+#define HTTPD_OUT_SIZE                 512     // rendered output (response head, handler output) waiting for room in the TCP send buffer.
+#define HTTPD_TAG_SIZE                  16     // longest server-side include tag name (longer ones are sent as text).
+#define HTTPD_POLL_TICKS                 4     // lwIP poll of each connection, in 500 msec ticks.
+#define HTTPD_IDLE_SEC                   5     // idle kept-alive connections are closed after this delay.
+
+/* Flags of a file of the flash content (see tools/wifi_httpd_content.py). */
+#define HTTPD_FILE_GZIP               0x01     // body is gzip-compressed.
+#define HTTPD_FILE_SSI                0x02     // server-side include template: no response head, <!--#tag--> comments are rendered by handlers.
+
+
+/* Render handler. Writes item number Item of its output into Buffer (up to Size bytes, end-of-string included, as snprintf()) and returns
+   its length, or -1 when there is no more item. A length of Size or more means the item did not fit: it is asked again with an empty
+   buffer, then truncated. Name is the path or tag of the handler (one function may serve several). Called from lwIP context, must not block. */
+typedef INT16 (*httpd_renderer)(const UCHAR *Name, UINT16 Item, UCHAR *Buffer, UINT16 Size, void *Context);
+
+
+/* Entry of a handler table (see wifi_httpd_start()). A Name starting with '/' is a path answered by the handler with ContentType
+   (CGI-style, query string ignored); any other Name is a server-side include tag (<!--#Name--> in a template) and ContentType is unused. */
+struct struct_httpd_handler
+{
+  const UCHAR *Name;
+  const UCHAR *ContentType;
+  httpd_renderer Render;
+};
+
+
+/* File of the flash content, generated at build time by tools/wifi_httpd_content.py. */
+struct struct_httpd_file
+{
+  const UCHAR *Name;                           // path, "/index.html".
+  const UCHAR *ContentType;
+  const UCHAR *Data;                           // response head followed by the body (template only, for HTTPD_FILE_SSI).
+  UINT32 Length;
+  UINT16 HeadLength;                           // 0 for HTTPD_FILE_SSI.
+  UINT32 ETag;
+  UINT8  Flags;
+};
+
+extern const struct struct_httpd_file HttpdFile[];
+extern const UINT8 HttpdFileCount;
+
+
+/* Status server statistics. */
+struct struct_httpd_stats
+{
+  UINT8  Connections;                          // connections open.
+  UINT32 Accepted;
+  UINT32 Refused;                              // all slots busy with requests in progress.
+  UINT32 Evicted;                              // idle kept-alive connections closed to accept a new one.
+  UINT32 Requests;
+  UINT32 KeepAlive;                            // requests received on a connection that had already carried one.
+  UINT32 Static;                               // answered from the flash content.
+  UINT32 NotModified;                          // answered "304 Not Modified" (ETag matched).
+  UINT32 Dynamic;                              // answered by a handler or a template.
+  UINT32 Errors;                               // 4xx answers.
+  UINT32 Truncated;                            // items that did not fit in HTTPD_OUT_SIZE.
+  UINT32 BytesReferenced;                      // sent from flash by reference (no copy).
+  UINT32 BytesCopied;                          // rendered and copied to lwIP.
+  UINT64 ServiceTotalUs;                       // request received to response handed to lwIP, all requests.
+  UINT32 ServiceMaxUs;
+  UINT32 RamBytes;                             // static RAM of the server (connection slots included).
+  UINT32 FlashBytes;                           // flash content, response heads included.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display status server statistics. */
+void wifi_httpd_display_stats(void);
+
+/* Retrieve status server statistics. */
+void wifi_httpd_get_stats(struct struct_httpd_stats *Stats);
+
+/* Start listening for HTTP requests. */
+INT16 wifi_httpd_start(UINT16 Port, const struct struct_httpd_handler *Handlers, UINT8 HandlerCount, void *Context);
+
+/* Stop listening and close all connections. */
+void wifi_httpd_stop(void);
+
+#endif  // _WIFI_HTTPD_H
@@ -0,0 +1,988 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Iperf.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   iperf2-compatible TCP / UDP throughput benchmark built on the lwIP raw API, part of Pico-WiFi-Module.
+   A stock iperf2 on a PC may be used as the peer:
+      TCP source (Pico -> PC):  PC runs "iperf -s"            Pico runs IPERF_MODE_TCP_CLIENT.
+      TCP sink   (PC -> Pico):  PC runs "iperf -c <pico>"     Pico runs IPERF_MODE_TCP_SERVER.
+      UDP source (Pico -> PC):  PC runs "iperf -s -u"         Pico runs IPERF_MODE_UDP_CLIENT.
+      UDP sink   (PC -> Pico):  PC runs "iperf -c <pico> -u"  Pico runs IPERF_MODE_UDP_SERVER.
+   Besides throughput, the report gives TCP retransmits, memory errors and, when lwIP statistics are enabled, the
+   high-water marks of the pbuf pool, TCP segment pool and lwIP heap, showing how close lwipopts.h settings are to their limits.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port
+   for regression runs over a tap or loopback interface.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - TCP sessions end with tcp_close() (tcp_abort() only if it fails); send-queue backpressure is not counted as a memory error.
+                    - Client header is no longer counted in the bytes acknowledged by the TCP source.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-Iperf.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define IPERF_HEADER_VERSION1  0x80000000     // iperf2 client header flag.
+#define IPERF_TCP_CHUNK        TCP_MSS        // size of each tcp_write() of the TCP source.
+
+
+/* iperf2 UDP datagram header (network byte order). */
+struct iperf_udp_datagram
+{
+  INT32  Id;                                 // datagram number, negative for the final datagram.
+  UINT32 Sec;                                // send time stamp.
+  UINT32 Usec;
+};
+
+
+/* iperf2 client header (network byte order). Flags = 0 tells the server not to connect back. */
+struct iperf_client_header
+{
+  INT32 Flags;
+  INT32 NumThreads;
+  INT32 Port;
+  INT32 BufferLength;
+  INT32 WinBand;
+  INT32 Amount;                              // negative: test duration in hundredths of second.
+};
+
+
+/* iperf2 server report, sent back by the UDP sink after the final datagram (network byte order). */
+struct iperf_server_header
+{
+  INT32 Flags;
+  INT32 TotalLength1;                        // high 32 bits of total bytes received.
+  INT32 TotalLength2;                        // low 32 bits of total bytes received.
+  INT32 StopSec;
+  INT32 StopUsec;
+  INT32 ErrorCount;                          // datagrams lost.
+  INT32 OutOfOrder;
+  INT32 Datagrams;
+  INT32 Jitter1;                             // jitter seconds.
+  INT32 Jitter2;                             // jitter usec.
+};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+/* Payload of the TCP and UDP sources. Lives in flash and is sent without copy. */
+static const UCHAR IperfPayload[IPERF_TCP_CHUNK] =
+  "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789"
+  "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789";
+
+static struct
+{
+  UINT8  FlagRunning;
+  UINT8  FlagHeaderSent;                     // TCP source: client header has been queued.
+  UINT8  HeaderUnacked;                      // TCP source: bytes of the client header not acknowledged yet.
+  UINT8  FinCount;                           // UDP source: number of final datagrams sent.
+  INT32  NextId;                             // UDP: next datagram number expected (sink) or to send (source).
+  UINT8  LastNrtx;                           // TCP: last value of pcb->nrtx seen.
+  UINT32 MibRetransmits;                     // TCP: MIB2 retransmit counter at start of test.
+  INT64  LastTransit;                        // UDP sink: previous transit time, for jitter.
+  UINT64 StartTime;
+  UINT64 StopTime;
+  INT64  JitterAccumulator;                  // UDP sink: jitter in usec * 16.
+  struct struct_iperf_settings Settings;
+  struct struct_iperf_report   Report;
+  struct tcp_pcb *ListenPcb;
+  struct tcp_pcb *TcpPcb;
+  struct udp_pcb *UdpPcb;
+} Iperf;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Fill the report with throughput and lwIP memory statistics. */
+static void iperf_finalize(void);
+
+/* Sample TCP retransmissions. */
+static void iperf_sample_retransmits(struct tcp_pcb *Pcb);
+
+/* TCP: new connection on the sink. */
+static err_t iperf_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error);
+
+/* TCP: connection established by the source. */
+static err_t iperf_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP: end current session. */
+static err_t iperf_tcp_end(struct tcp_pcb *Pcb);
+
+/* TCP: connection error. */
+static void iperf_tcp_error(void *Arg, err_t Error);
+
+/* TCP: queue as much data as the send buffer allows. */
+static void iperf_tcp_fill(struct tcp_pcb *Pcb);
+
+/* TCP: periodic poll. */
+static err_t iperf_tcp_poll(void *Arg, struct tcp_pcb *Pcb);
+
+/* TCP: data received by the sink. */
+static err_t iperf_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged by the peer. */
+static err_t iperf_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length);
+
+/* UDP: datagram received (sink data or source server report). */
+static void iperf_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, u16_t Port);
+
+/* UDP: send one datagram. */
+static err_t iperf_udp_send(INT32 Id, UINT64 TimeStamp);
+
+/* UDP: pacing timer of the source. */
+static void iperf_udp_timer(void *Arg);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_display_report(). */
+/* ============================================================================================================================================================= *\
+                                                                   Display the report of the last benchmark.
+\* ============================================================================================================================================================= */
+void iperf_display_report(void)
+{
+  struct struct_iperf_report Report;
+
+
+  iperf_get_report(&Report);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  switch (Report.Mode)
+  {
+    case (IPERF_MODE_TCP_CLIENT):
+      log_info(__LINE__, __func__, "                 iperf TCP source (Pico -> %s)\r", ip4addr_ntoa(&Report.RemoteAddress));
+    break;
+
+    case (IPERF_MODE_TCP_SERVER):
+      log_info(__LINE__, __func__, "                 iperf TCP sink (%s -> Pico)\r", ip4addr_ntoa(&Report.RemoteAddress));
+    break;
+
+    case (IPERF_MODE_UDP_CLIENT):
+      log_info(__LINE__, __func__, "                 iperf UDP source (Pico -> %s)\r", ip4addr_ntoa(&Report.RemoteAddress));
+    break;
+
+    case (IPERF_MODE_UDP_SERVER):
+      log_info(__LINE__, __func__, "                 iperf UDP sink (%s -> Pico)\r", ip4addr_ntoa(&Report.RemoteAddress));
+    break;
+
+    default:
+      log_info(__LINE__, __func__, "No benchmark has been run yet.\r");
+      log_info(__LINE__, __func__, "======================================================================\r");
+    return;
+  }
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  if (Report.FlagComplete == FLAG_OFF) log_info(__LINE__, __func__, "NOTE: Test still in progress, values are partial.\r");
+  log_info(__LINE__, __func__, "Bytes transferred:        %llu\r",           Report.Bytes);
+  log_info(__LINE__, __func__, "Elapsed time:             %llu.%03llu sec\r", Report.ElapsedUs / 1000000, (Report.ElapsedUs % 1000000) / 1000);
+  log_info(__LINE__, __func__, "Throughput:               %lu kbits/sec\r",  Report.ThroughputKbps);
+
+  if ((Report.Mode == IPERF_MODE_TCP_CLIENT) || (Report.Mode == IPERF_MODE_TCP_SERVER))
+  {
+    log_info(__LINE__, __func__, "TCP retransmits:          %lu\r", Report.Retransmits);
+    if (Report.Mode == IPERF_MODE_TCP_CLIENT) log_info(__LINE__, __func__, "Lowest free send buffer:  %u bytes (TCP_SND_BUF: %u)\r", Report.SndBufMin, TCP_SND_BUF);
+  }
+  else
+  {
+    log_info(__LINE__, __func__, "Datagrams:                %lu\r", Report.Datagrams);
+    if ((Report.Mode == IPERF_MODE_UDP_SERVER) || Report.FlagServerReport)
+    {
+      log_info(__LINE__, __func__, "Datagrams lost:           %lu\r", Report.Lost);
+      log_info(__LINE__, __func__, "Out of order:             %lu\r", Report.OutOfOrder);
+      log_info(__LINE__, __func__, "Jitter:                   %lu.%03lu msec\r", Report.JitterUs / 1000, Report.JitterUs % 1000);
+    }
+    else
+    {
+      log_info(__LINE__, __func__, "No report received from iperf server (loss and jitter unknown).\r");
+    }
+  }
+
+  log_info(__LINE__, __func__, "Memory errors (write):    %lu\r", Report.WriteMemErrors);
+#if LWIP_STATS && MEMP_STATS
+  log_info(__LINE__, __func__, "pbuf pool high-water:     %u / %u (errors: %u)\r", Report.PbufPoolMax, PBUF_POOL_SIZE, Report.PbufPoolErrors);
+  log_info(__LINE__, __func__, "TCP segments high-water:  %u / %u\r", Report.TcpSegMax, MEMP_NUM_TCP_SEG);
+#endif  // LWIP_STATS && MEMP_STATS
+#if LWIP_STATS && MEM_STATS
+  log_info(__LINE__, __func__, "lwIP heap high-water:     %lu / %u (errors: %u)\r", Report.HeapMax, MEM_SIZE, Report.HeapErrors);
+#endif  // LWIP_STATS && MEM_STATS
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_finalize(). */
+/* ============================================================================================================================================================= *\
+                                                       Fill the report with throughput and lwIP memory statistics.
+\* ============================================================================================================================================================= */
+static void iperf_finalize(void)
+{
+  UINT64 StopTime;
+
+
+  StopTime = Iperf.StopTime ? Iperf.StopTime : WIFI_TIME_US();
+  Iperf.Report.ElapsedUs      = Iperf.StartTime ? (StopTime - Iperf.StartTime) : 0;
+  Iperf.Report.ThroughputKbps = Iperf.Report.ElapsedUs ? (UINT32)((Iperf.Report.Bytes * 8000ull) / Iperf.Report.ElapsedUs) : 0;
+
+#if LWIP_STATS && MIB2_STATS
+  if ((Iperf.Settings.Mode == IPERF_MODE_TCP_CLIENT) || (Iperf.Settings.Mode == IPERF_MODE_TCP_SERVER))
+    Iperf.Report.Retransmits = lwip_stats.mib2.tcpretranssegs - Iperf.MibRetransmits;
+#endif  // LWIP_STATS && MIB2_STATS
+
+#if LWIP_STATS && MEMP_STATS
+  Iperf.Report.PbufPoolMax    = lwip_stats.memp[MEMP_PBUF_POOL]->max;
+  Iperf.Report.PbufPoolErrors = lwip_stats.memp[MEMP_PBUF_POOL]->err;
+  Iperf.Report.TcpSegMax      = lwip_stats.memp[MEMP_TCP_SEG]->max;
+#endif  // LWIP_STATS && MEMP_STATS
+
+#if LWIP_STATS && MEM_STATS
+  Iperf.Report.HeapMax    = lwip_stats.mem.max;
+  Iperf.Report.HeapErrors = lwip_stats.mem.err;
+#endif  // LWIP_STATS && MEM_STATS
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_get_report(). */
+/* ============================================================================================================================================================= *\
+                                                            Retrieve the report of the current or last benchmark.
+\* ============================================================================================================================================================= */
+void iperf_get_report(struct struct_iperf_report *Report)
+{
+  WIFI_LWIP_BEGIN();
+  if (Iperf.Report.FlagComplete == FLAG_OFF) iperf_finalize();
+  *Report = Iperf.Report;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_is_running(). */
+/* ============================================================================================================================================================= *\
+                                                                     Tell if a benchmark is in progress.
+                                                  For sinks, returns FLAG_ON as long as the server is listening.
+\* ============================================================================================================================================================= */
+UINT8 iperf_is_running(void)
+{
+  return Iperf.FlagRunning;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_sample_retransmits(). */
+/* ============================================================================================================================================================= *\
+                      Sample TCP retransmissions. pcb->nrtx counts retransmissions of the oldest unacknowledged segment and is reset when it is acked.
+                                           Only used when lwIP MIB2 statistics are not available.
+\* ============================================================================================================================================================= */
+static void iperf_sample_retransmits(struct tcp_pcb *Pcb)
+{
+#if !(LWIP_STATS && MIB2_STATS)
+  if (Pcb->nrtx > Iperf.LastNrtx) Iperf.Report.Retransmits += (Pcb->nrtx - Iperf.LastNrtx);
+  Iperf.LastNrtx = Pcb->nrtx;
+#endif  // !(LWIP_STATS && MIB2_STATS)
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_start(). */
+/* ============================================================================================================================================================= *\
+                                                                           Start a benchmark.
+\* ============================================================================================================================================================= */
+INT16 iperf_start(struct struct_iperf_settings *Settings)
+{
+  err_t ReturnCode;
+
+
+  if (Iperf.FlagRunning) return -1;
+
+  WIFI_LWIP_BEGIN();
+  memset(&Iperf, 0x00, sizeof(Iperf));
+  Iperf.Settings = *Settings;
+  if (Iperf.Settings.Port == 0)          Iperf.Settings.Port          = IPERF_DEFAULT_PORT;
+  if (Iperf.Settings.DurationSec == 0)   Iperf.Settings.DurationSec   = IPERF_DEFAULT_DURATION;
+  if (Iperf.Settings.BandwidthKbps == 0) Iperf.Settings.BandwidthKbps = IPERF_DEFAULT_BANDWIDTH;
+  if ((Iperf.Settings.DatagramSize < (sizeof(struct iperf_udp_datagram) + sizeof(struct iperf_client_header))) || (Iperf.Settings.DatagramSize > IPERF_DEFAULT_DATAGRAM))
+    Iperf.Settings.DatagramSize = IPERF_DEFAULT_DATAGRAM;
+
+  Iperf.Report.Mode = Iperf.Settings.Mode;
+  Iperf.Report.RemoteAddress = Iperf.Settings.RemoteAddress;
+  Iperf.Report.SndBufMin = TCP_SND_BUF;
+#if LWIP_STATS && MIB2_STATS
+  Iperf.MibRetransmits = lwip_stats.mib2.tcpretranssegs;
+#endif  // LWIP_STATS && MIB2_STATS
+
+  /* High-water marks are reset so that the report reflects this test only. */
+#if LWIP_STATS && MEMP_STATS
+  lwip_stats.memp[MEMP_PBUF_POOL]->max = lwip_stats.memp[MEMP_PBUF_POOL]->used;
+  lwip_stats.memp[MEMP_TCP_SEG]->max   = lwip_stats.memp[MEMP_TCP_SEG]->used;
+#endif  // LWIP_STATS && MEMP_STATS
+#if LWIP_STATS && MEM_STATS
+  lwip_stats.mem.max = lwip_stats.mem.used;
+#endif  // LWIP_STATS && MEM_STATS
+
+  ReturnCode = ERR_VAL;
+  switch (Iperf.Settings.Mode)
+  {
+    case (IPERF_MODE_TCP_CLIENT):
+      if ((Iperf.TcpPcb = tcp_new_ip_type(IPADDR_TYPE_ANY)) == NULL) break;
+      tcp_arg(Iperf.TcpPcb, NULL);
+      tcp_err(Iperf.TcpPcb, iperf_tcp_error);
+      tcp_sent(Iperf.TcpPcb, iperf_tcp_sent);
+      tcp_recv(Iperf.TcpPcb, iperf_tcp_receive);
+      tcp_poll(Iperf.TcpPcb, iperf_tcp_poll, 1);
+      ReturnCode = tcp_connect(Iperf.TcpPcb, &Iperf.Settings.RemoteAddress, Iperf.Settings.Port, iperf_tcp_connected);
+      if (ReturnCode != ERR_OK)
+      {
+        tcp_abort(Iperf.TcpPcb);
+        Iperf.TcpPcb = NULL;
+      }
+    break;
+
+    case (IPERF_MODE_TCP_SERVER):
+      if ((Iperf.ListenPcb = tcp_new_ip_type(IPADDR_TYPE_ANY)) == NULL) break;
+      if ((ReturnCode = tcp_bind(Iperf.ListenPcb, IP_ANY_TYPE, Iperf.Settings.Port)) != ERR_OK)
+      {
+        tcp_close(Iperf.ListenPcb);
+        Iperf.ListenPcb = NULL;
+        break;
+      }
+      Iperf.ListenPcb = tcp_listen_with_backlog(Iperf.ListenPcb, 1);
+      tcp_accept(Iperf.ListenPcb, iperf_tcp_accept);
+    break;
+
+    case (IPERF_MODE_UDP_CLIENT):
+    case (IPERF_MODE_UDP_SERVER):
+      if ((Iperf.UdpPcb = udp_new_ip_type(IPADDR_TYPE_ANY)) == NULL) break;
+      if (Iperf.Settings.Mode == IPERF_MODE_UDP_SERVER)
+        ReturnCode = udp_bind(Iperf.UdpPcb, IP_ANY_TYPE, Iperf.Settings.Port);
+      else
+        ReturnCode = udp_connect(Iperf.UdpPcb, &Iperf.Settings.RemoteAddress, Iperf.Settings.Port);
+
+      if (ReturnCode != ERR_OK)
+      {
+        udp_remove(Iperf.UdpPcb);
+        Iperf.UdpPcb = NULL;
+        break;
+      }
+      udp_recv(Iperf.UdpPcb, iperf_udp_receive, NULL);
+
+      if (Iperf.Settings.Mode == IPERF_MODE_UDP_CLIENT)
+      {
+        Iperf.StartTime = WIFI_TIME_US();
+        sys_timeout(IPERF_UDP_TICK_MSEC, iperf_udp_timer, NULL);
+      }
+    break;
+  }
+
+  if (ReturnCode == ERR_OK) Iperf.FlagRunning = FLAG_ON;
+  WIFI_LWIP_END();
+
+  return (ReturnCode == ERR_OK) ? 0 : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_stop(). */
+/* ============================================================================================================================================================= *\
+                                                                      Stop the benchmark in progress.
+\* ============================================================================================================================================================= */
+void iperf_stop(void)
+{
+  WIFI_LWIP_BEGIN();
+  sys_untimeout(iperf_udp_timer, NULL);
+
+  if (Iperf.TcpPcb)
+  {
+    iperf_tcp_end(Iperf.TcpPcb);
+  }
+
+  if (Iperf.ListenPcb)
+  {
+    tcp_close(Iperf.ListenPcb);
+    Iperf.ListenPcb = NULL;
+  }
+
+  if (Iperf.UdpPcb)
+  {
+    udp_remove(Iperf.UdpPcb);
+    Iperf.UdpPcb = NULL;
+  }
+
+  if (Iperf.FlagRunning && (Iperf.Report.FlagComplete == FLAG_OFF))
+  {
+    iperf_finalize();
+    Iperf.Report.FlagComplete = FLAG_ON;
+  }
+  Iperf.FlagRunning = FLAG_OFF;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_accept(). */
+/* ============================================================================================================================================================= *\
+                                                      TCP: new connection on the sink. Only one session at a time is accepted.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error)
+{
+  if ((Error != ERR_OK) || (NewPcb == NULL)) return ERR_VAL;
+
+  if (Iperf.TcpPcb != NULL)
+  {
+    tcp_abort(NewPcb);
+    return ERR_ABRT;
+  }
+
+  /* Start a new session. */
+  Iperf.TcpPcb               = NewPcb;
+  Iperf.StartTime            = WIFI_TIME_US();
+  Iperf.StopTime             = 0;
+  Iperf.LastNrtx             = 0;
+  Iperf.Report.Bytes         = 0;
+  Iperf.Report.Retransmits   = 0;
+  Iperf.Report.FlagComplete  = FLAG_OFF;
+  Iperf.Report.RemoteAddress = NewPcb->remote_ip;
+#if LWIP_STATS && MIB2_STATS
+  Iperf.MibRetransmits = lwip_stats.mib2.tcpretranssegs;
+#endif  // LWIP_STATS && MIB2_STATS
+
+  tcp_arg(NewPcb, NULL);
+  tcp_err(NewPcb, iperf_tcp_error);
+  tcp_recv(NewPcb, iperf_tcp_receive);
+  tcp_poll(NewPcb, iperf_tcp_poll, 2);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_connected(). */
+/* ============================================================================================================================================================= *\
+                                                                 TCP: connection established by the source.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  if (Error != ERR_OK) return iperf_tcp_end(Pcb);
+
+  Iperf.StartTime = WIFI_TIME_US();
+  iperf_tcp_fill(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_end(). */
+/* ============================================================================================================================================================= *\
+                           TCP: end current session with a normal close (FIN), the connection is aborted (RST) only if the close fails.
+                       Returns ERR_ABRT if the pcb has been aborted, ERR_OK otherwise: a lwIP callback calling this must return that value.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_end(struct tcp_pcb *Pcb)
+{
+  err_t ReturnCode;
+
+
+
+  if (Iperf.StopTime == 0) Iperf.StopTime = WIFI_TIME_US();
+  iperf_sample_retransmits(Pcb);
+  iperf_finalize();
+  Iperf.Report.FlagComplete = FLAG_ON;
+
+  tcp_arg(Pcb,  NULL);
+  tcp_err(Pcb,  NULL);
+  tcp_recv(Pcb, NULL);
+  tcp_sent(Pcb, NULL);
+  tcp_poll(Pcb, NULL, 0);
+  ReturnCode = tcp_close(Pcb);
+  if (ReturnCode != ERR_OK)
+  {
+    /* Out of memory to queue the FIN. */
+    tcp_abort(Pcb);
+    ReturnCode = ERR_ABRT;
+  }
+  Iperf.TcpPcb = NULL;
+
+  /* The source is done once its connection is closed; the sink keeps listening for the next session. */
+  if (Iperf.Settings.Mode == IPERF_MODE_TCP_CLIENT) Iperf.FlagRunning = FLAG_OFF;
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void iperf_tcp_error(void *Arg, err_t Error)
+{
+  if (Iperf.StopTime == 0) Iperf.StopTime = WIFI_TIME_US();
+  iperf_finalize();
+  Iperf.Report.FlagComplete = FLAG_ON;
+  Iperf.TcpPcb = NULL;
+  if (Iperf.Settings.Mode == IPERF_MODE_TCP_CLIENT) Iperf.FlagRunning = FLAG_OFF;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_fill(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP: queue as much data as the send buffer allows.
+                                                     Data is referenced from flash (no TCP_WRITE_FLAG_COPY), so no RAM is copied.
+                    ERR_MEM while segments are still queued is normal backpressure (TCP_SND_QUEUELEN reached): the next sent callback resumes.
+                                    Only an ERR_MEM with an empty send queue is a real lack of memory, counted in the report.
+\* ============================================================================================================================================================= */
+static void iperf_tcp_fill(struct tcp_pcb *Pcb)
+{
+  static struct iperf_client_header ClientHeader;
+
+  UINT16 Length;
+
+  err_t ReturnCode;
+
+
+  if (Iperf.FlagHeaderSent == FLAG_OFF)
+  {
+    /* Header must remain valid until acknowledged, hence static. */
+    memset(&ClientHeader, 0x00, sizeof(ClientHeader));
+    ClientHeader.NumThreads = lwip_htonl(1);
+    ClientHeader.Port       = lwip_htonl(Iperf.Settings.Port);
+    ClientHeader.Amount     = lwip_htonl(-(INT32)(Iperf.Settings.DurationSec * 100));
+    if (tcp_write(Pcb, &ClientHeader, sizeof(ClientHeader), TCP_WRITE_FLAG_MORE) != ERR_OK)
+    {
+      if (tcp_sndqueuelen(Pcb) == 0) ++Iperf.Report.WriteMemErrors;
+      return;
+    }
+    Iperf.FlagHeaderSent = FLAG_ON;
+    Iperf.HeaderUnacked  = sizeof(ClientHeader);
+  }
+
+  if (tcp_sndbuf(Pcb) < Iperf.Report.SndBufMin) Iperf.Report.SndBufMin = tcp_sndbuf(Pcb);
+
+  while ((Length = LWIP_MIN(tcp_sndbuf(Pcb), IPERF_TCP_CHUNK)) > 0)
+  {
+    ReturnCode = tcp_write(Pcb, IperfPayload, Length, TCP_WRITE_FLAG_MORE);
+    if (ReturnCode != ERR_OK)
+    {
+      if ((ReturnCode == ERR_MEM) && (tcp_sndqueuelen(Pcb) == 0)) ++Iperf.Report.WriteMemErrors;
+      break;
+    }
+  }
+  tcp_output(Pcb);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_poll(). */
+/* ============================================================================================================================================================= *\
+                                                                            TCP: periodic poll.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_poll(void *Arg, struct tcp_pcb *Pcb)
+{
+  iperf_sample_retransmits(Pcb);
+
+  if (Iperf.Settings.Mode == IPERF_MODE_TCP_CLIENT)
+  {
+    if ((Iperf.StartTime != 0) && ((WIFI_TIME_US() - Iperf.StartTime) >= (Iperf.Settings.DurationSec * 1000000ull))) return iperf_tcp_end(Pcb);
+    iperf_tcp_fill(Pcb);
+  }
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                                                        TCP: data received by the sink.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  if (PBuf == NULL)
+  {
+    /* Peer closed the connection: end of test. */
+    return iperf_tcp_end(Pcb);
+  }
+
+  Iperf.Report.Bytes += PBuf->tot_len;
+  tcp_recved(Pcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                                                                   TCP: data acknowledged by the peer.
+\* ============================================================================================================================================================= */
+static err_t iperf_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length)
+{
+  UINT8 HeaderBytes;
+
+
+  /* Client header is not part of the payload count. */
+  HeaderBytes = (UINT8)LWIP_MIN(Length, Iperf.HeaderUnacked);
+  Iperf.HeaderUnacked -= HeaderBytes;
+  Iperf.Report.Bytes  += (Length - HeaderBytes);
+  iperf_sample_retransmits(Pcb);
+
+  if ((WIFI_TIME_US() - Iperf.StartTime) >= (Iperf.Settings.DurationSec * 1000000ull)) return iperf_tcp_end(Pcb);
+
+  iperf_tcp_fill(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_udp_receive(). */
+/* ============================================================================================================================================================= *\
+                                                       UDP: datagram received (sink data or source server report).
+\* ============================================================================================================================================================= */
+static void iperf_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, u16_t Port)
+{
+  INT32 Id;
+
+  INT64 Deviation;
+  INT64 Transit;
+
+  UINT64 Bytes;
+  UINT64 TimeStamp;
+
+  struct iperf_udp_datagram  Datagram;
+  struct iperf_server_header ServerHeader;
+  struct pbuf *Reply;
+
+
+  TimeStamp = WIFI_TIME_US();
+
+  if (pbuf_copy_partial(PBuf, &Datagram, sizeof(Datagram), 0) != sizeof(Datagram))
+  {
+    pbuf_free(PBuf);
+    return;
+  }
+  Id = (INT32)lwip_ntohl(Datagram.Id);
+
+  if (Iperf.Settings.Mode == IPERF_MODE_UDP_CLIENT)
+  {
+    /* Server report received in answer to our final datagram. */
+    if (pbuf_copy_partial(PBuf, &ServerHeader, sizeof(ServerHeader), sizeof(Datagram)) == sizeof(ServerHeader))
+    {
+      Iperf.Report.Lost       = lwip_ntohl(ServerHeader.ErrorCount);
+      Iperf.Report.OutOfOrder = lwip_ntohl(ServerHeader.OutOfOrder);
+      Iperf.Report.JitterUs   = (lwip_ntohl(ServerHeader.Jitter1) * 1000000) + lwip_ntohl(ServerHeader.Jitter2);
+      Iperf.Report.FlagServerReport = FLAG_ON;
+      sys_untimeout(iperf_udp_timer, NULL);
+      iperf_finalize();
+      Iperf.Report.FlagComplete = FLAG_ON;
+      Iperf.FlagRunning = FLAG_OFF;
+    }
+    pbuf_free(PBuf);
+    return;
+  }
+
+  /* UDP sink. A first datagram (or one after a completed session) starts a new session. */
+  if ((Id >= 0) && ((Iperf.StartTime == 0) || Iperf.Report.FlagComplete))
+  {
+    Iperf.StartTime            = TimeStamp;
+    Iperf.StopTime             = 0;
+    Iperf.NextId               = 0;
+    Iperf.LastTransit          = 0;
+    Iperf.JitterAccumulator    = 0;
+    Iperf.Report.Bytes         = 0;
+    Iperf.Report.Datagrams     = 0;
+    Iperf.Report.Lost          = 0;
+    Iperf.Report.OutOfOrder    = 0;
+    Iperf.Report.FlagComplete  = FLAG_OFF;
+    Iperf.Report.RemoteAddress = *Address;
+  }
+
+  if (Id >= 0)
+  {
+    Iperf.Report.Bytes += PBuf->tot_len;
+    ++Iperf.Report.Datagrams;
+
+    /* Loss and out-of-order, as done by iperf2. */
+    if (Id > Iperf.NextId)
+    {
+      Iperf.Report.Lost += (Id - Iperf.NextId);
+      Iperf.NextId = Id + 1;
+    }
+    else if (Id < Iperf.NextId)
+    {
+      ++Iperf.Report.OutOfOrder;
+      if (Iperf.Report.Lost) --Iperf.Report.Lost;
+    }
+    else
+    {
+      Iperf.NextId = Id + 1;
+    }
+
+    /* Jitter (RFC 1889): J += (|D| - J) / 16, kept in usec * 16. */
+    Transit = (INT64)TimeStamp - (((INT64)lwip_ntohl(Datagram.Sec) * 1000000) + lwip_ntohl(Datagram.Usec));
+    if (Iperf.Report.Datagrams > 1)
+    {
+      Deviation = Transit - Iperf.LastTransit;
+      if (Deviation < 0) Deviation = -Deviation;
+      Iperf.JitterAccumulator += Deviation - ((Iperf.JitterAccumulator + 8) >> 4);
+    }
+    Iperf.LastTransit = Transit;
+    Iperf.Report.JitterUs = (UINT32)(Iperf.JitterAccumulator >> 4);
+
+    pbuf_free(PBuf);
+    return;
+  }
+
+  /* Final datagram: send back the server report (each time, since the client may retry). */
+  if (Iperf.StartTime == 0)
+  {
+    pbuf_free(PBuf);
+    return;
+  }
+
+  if (Iperf.StopTime == 0)
+  {
+    Iperf.StopTime = TimeStamp;
+    iperf_finalize();
+    Iperf.Report.FlagComplete = FLAG_ON;
+  }
+
+  Bytes = Iperf.Report.Bytes;
+  memset(&ServerHeader, 0x00, sizeof(ServerHeader));
+  ServerHeader.Flags        = lwip_htonl(IPERF_HEADER_VERSION1);
+  ServerHeader.TotalLength1 = lwip_htonl((UINT32)(Bytes >> 32));
+  ServerHeader.TotalLength2 = lwip_htonl((UINT32)Bytes);
+  ServerHeader.StopSec      = lwip_htonl((UINT32)(Iperf.Report.ElapsedUs / 1000000));
+  ServerHeader.StopUsec     = lwip_htonl((UINT32)(Iperf.Report.ElapsedUs % 1000000));
+  ServerHeader.ErrorCount   = lwip_htonl(Iperf.Report.Lost);
+  ServerHeader.OutOfOrder   = lwip_htonl(Iperf.Report.OutOfOrder);
+  ServerHeader.Datagrams    = lwip_htonl((UINT32)-Id);
+  ServerHeader.Jitter1      = lwip_htonl(Iperf.Report.JitterUs / 1000000);
+  ServerHeader.Jitter2      = lwip_htonl(Iperf.Report.JitterUs % 1000000);
+
+  Reply = pbuf_alloc(PBUF_TRANSPORT, sizeof(Datagram) + sizeof(ServerHeader), PBUF_RAM);
+  if (Reply != NULL)
+  {
+    pbuf_take(Reply, &Datagram, sizeof(Datagram));
+    pbuf_take_at(Reply, &ServerHeader, sizeof(ServerHeader), sizeof(Datagram));
+    udp_sendto(Pcb, Reply, Address, Port);
+    pbuf_free(Reply);
+  }
+  pbuf_free(PBuf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_udp_send(). */
+/* ============================================================================================================================================================= *\
+                                                                         UDP: send one datagram.
+                                      Header is built in a small RAM pbuf chained to the payload referenced from flash (PBUF_ROM).
+\* ============================================================================================================================================================= */
+static err_t iperf_udp_send(INT32 Id, UINT64 TimeStamp)
+{
+  UINT16 PayloadSize;
+
+  err_t ReturnCode;
+
+  struct iperf_udp_datagram  *Datagram;
+  struct iperf_client_header *ClientHeader;
+  struct pbuf *Header;
+  struct pbuf *Payload;
+
+
+  PayloadSize = Iperf.Settings.DatagramSize - sizeof(struct iperf_udp_datagram) - sizeof(struct iperf_client_header);
+
+  Header = pbuf_alloc(PBUF_TRANSPORT, sizeof(struct iperf_udp_datagram) + sizeof(struct iperf_client_header), PBUF_RAM);
+  if (Header == NULL) return ERR_MEM;
+
+  Datagram     = (struct iperf_udp_datagram *)Header->payload;
+  ClientHeader = (struct iperf_client_header *)(Datagram + 1);
+  Datagram->Id   = lwip_htonl((UINT32)Id);
+  Datagram->Sec  = lwip_htonl((UINT32)(TimeStamp / 1000000));
+  Datagram->Usec = lwip_htonl((UINT32)(TimeStamp % 1000000));
+  memset(ClientHeader, 0x00, sizeof(*ClientHeader));
+
+  if (PayloadSize)
+  {
+    Payload = pbuf_alloc(PBUF_RAW, PayloadSize, PBUF_ROM);
+    if (Payload == NULL)
+    {
+      pbuf_free(Header);
+      return ERR_MEM;
+    }
+    Payload->payload = (void *)IperfPayload;
+    pbuf_cat(Header, Payload);
+  }
+
+  ReturnCode = udp_send(Iperf.UdpPcb, Header);
+  pbuf_free(Header);
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=iperf_udp_timer(). */
+/* ============================================================================================================================================================= *\
+                                                                     UDP: pacing timer of the source.
+                                     Sends as many datagrams as needed to stay on the requested bandwidth, then the final datagrams.
+\* ============================================================================================================================================================= */
+static void iperf_udp_timer(void *Arg)
+{
+  UINT8 Loop1UInt8;
+
+  UINT64 Elapsed;
+  UINT64 Target;
+  UINT64 TimeStamp;
+
+  err_t ReturnCode;
+
+
+  if (Iperf.FlagRunning == FLAG_OFF) return;
+
+  TimeStamp = WIFI_TIME_US();
+  Elapsed   = TimeStamp - Iperf.StartTime;
+
+  if (Elapsed < (Iperf.Settings.DurationSec * 1000000ull))
+  {
+    /* Number of bytes that should have been sent by now. */
+    Target = (Elapsed * Iperf.Settings.BandwidthKbps) / 8000;
+
+    for (Loop1UInt8 = 0; (Loop1UInt8 < 32) && (Iperf.Report.Bytes < Target); ++Loop1UInt8)
+    {
+      ReturnCode = iperf_udp_send(Iperf.NextId, TimeStamp);
+      if (ReturnCode == ERR_MEM)
+      {
+        ++Iperf.Report.WriteMemErrors;
+        break;
+      }
+      ++Iperf.NextId;
+      ++Iperf.Report.Datagrams;
+      Iperf.Report.Bytes += Iperf.Settings.DatagramSize;
+    }
+
+    sys_timeout(IPERF_UDP_TICK_MSEC, iperf_udp_timer, NULL);
+    return;
+  }
+
+  /* Test duration is over: send final datagram (negative id) until the server answers with its report. */
+  if (Iperf.FinCount == 0)
+  {
+    Iperf.StopTime = TimeStamp;
+    iperf_finalize();
+  }
+
+  if (Iperf.FinCount < IPERF_FIN_RETRIES)
+  {
+    ++Iperf.FinCount;
+    iperf_udp_send(-Iperf.NextId, TimeStamp);
+    sys_timeout(IPERF_FIN_INTERVAL_MSEC, iperf_udp_timer, NULL);
+    return;
+  }
+
+  /* No report received from the server. */
+  Iperf.Report.FlagComplete = FLAG_ON;
+  Iperf.FlagRunning = FLAG_OFF;
+
+  return;
+}
@@ -0,0 +1,89 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Iperf.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Iperf.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_IPERF_H
+#define _WIFI_IPERF_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define IPERF_DEFAULT_PORT         5001     // iperf2 default port.
+#define IPERF_DEFAULT_DURATION       10     // default test duration (seconds).
+#define IPERF_DEFAULT_BANDWIDTH    1000     // default UDP bandwidth (kbits / sec), same as iperf2.
+#define IPERF_DEFAULT_DATAGRAM     1470     // default UDP datagram size, same as iperf2.
+#define IPERF_FIN_RETRIES            10     // number of times the final UDP datagram is sent while waiting for the server report.
+#define IPERF_FIN_INTERVAL_MSEC     250     // delay between two final UDP datagrams.
+#define IPERF_UDP_TICK_MSEC           1     // pacing period of the UDP source.
+
+/* Benchmark modes. */
+#define IPERF_MODE_TCP_CLIENT         1     // TCP source, peer runs "iperf -s".
+#define IPERF_MODE_TCP_SERVER         2     // TCP sink,   peer runs "iperf -c <pico>".
+#define IPERF_MODE_UDP_CLIENT         3     // UDP source, peer runs "iperf -s -u".
+#define IPERF_MODE_UDP_SERVER         4     // UDP sink,   peer runs "iperf -c <pico> -u".
+
+
+/* Benchmark settings. */
+struct struct_iperf_settings
+{
+  UINT8  Mode;
+  ip_addr_t RemoteAddress;                   // peer address (client modes only).
+  UINT16 Port;
+  UINT16 DurationSec;                        // client modes only.
+  UINT32 BandwidthKbps;                      // UDP client only.
+  UINT16 DatagramSize;                       // UDP client only.
+};
+
+
+/* Benchmark report. */
+struct struct_iperf_report
+{
+  UINT8  Mode;
+  UINT8  FlagComplete;                       // test is over and report is final.
+  ip_addr_t RemoteAddress;
+  UINT64 Bytes;                              // bytes acknowledged (TCP source) or received (sinks) or sent (UDP source).
+  UINT64 ElapsedUs;
+  UINT32 ThroughputKbps;
+  UINT32 Retransmits;                        // TCP segments retransmitted (sampled from the pcb when MIB2 stats are not available).
+  UINT32 WriteMemErrors;                     // tcp_write() (empty send queue) / pbuf_alloc() / udp_send() failures due to lack of memory.
+  UINT16 SndBufMin;                          // lowest free TCP send buffer seen (TCP source).
+  UINT32 Datagrams;                          // UDP datagrams sent or received.
+  UINT32 Lost;                               // UDP datagrams lost (as seen by the sink).
+  UINT32 OutOfOrder;                         // UDP datagrams received out of order.
+  UINT32 JitterUs;                           // UDP jitter, as seen by the sink.
+  UINT8  FlagServerReport;                   // UDP client: report has been received from the iperf server.
+  UINT16 PbufPoolMax;                        // pbuf pool high-water mark (0 if MEMP_STATS is not enabled).
+  UINT16 PbufPoolErrors;
+  UINT16 TcpSegMax;
+  UINT32 HeapMax;                            // lwIP heap high-water mark (0 if MEM_STATS is not enabled).
+  UINT16 HeapErrors;
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display the report of the last benchmark. */
+void iperf_display_report(void);
+
+/* Retrieve the report of the current or last benchmark. */
+void iperf_get_report(struct struct_iperf_report *Report);
+
+/* Tell if a benchmark is in progress. */
+UINT8 iperf_is_running(void);
+
+/* Start a benchmark. */
+INT16 iperf_start(struct struct_iperf_settings *Settings);
+
+/* Stop the benchmark in progress. */
+void iperf_stop(void);
+
+#endif  // _WIFI_IPERF_H
@@ -0,0 +1,965 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-MDNS.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   mDNS responder (RFC 6762) with DNS-SD service records (RFC 6763) built on the lwIP raw API, part of Pico-WiFi-Module.
+   The host name given to the netif by wifi_connect() ("ExtraHostName", unique per device) is advertised, so that devices
+   are found at once by name ("<name>.local") or by browsing MDNS_SERVICE_TYPE, instead of sweeping the subnet.
+   - Records: A (<name>.local), PTR (service type -> instance), SRV (instance -> port and host), TXT (application items),
+     and the PTR of the service enumeration name (_services._dns-sd._udp.local) listing our service type.
+   - Announcements: all records are sent MDNS_ANNOUNCE_COUNT times when the link comes up with an address, and again when
+     the address or the host name changes. Goodbyes (TTL 0) are sent by wifi_mdns_stop() and before a host name change.
+   - Queries are answered from a fixed buffer, with name compression and the related records in the additional section.
+     Known-answer suppression is honoured, and one-shot (legacy unicast) queries are answered by unicast.
+   - Fixed memory: one UDP pcb, one multicast group and two static message buffers. Nothing is allocated besides the pbuf of
+     each response; the processing time of each message received is measured (see wifi_mdns_display_stats()).
+   The host name is derived from the MAC address, so the probing phase of RFC 6762 is not run; conflicts are only counted.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port.
+   Requires LWIP_IGMP (see lwipopts.h).
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+#include "strings.h"
+
+#include "lwip/igmp.h"
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-MDNS.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define MDNS_HEADER_SIZE        12
+#define MDNS_NAME_MAX          256          // longest name, dotted, plus end-of-string.
+#define MDNS_HOST_LENGTH        63          // longest host name (a single label).
+#define MDNS_QUESTIONS_MAX     128          // question section repeated in answers to legacy queries.
+#define MDNS_LABELS_MAX         16          // names written in a message, kept for compression.
+#define MDNS_TTL_RECORD 0xFFFFFFFF          // each record with its own TTL.
+
+/* DNS record types. */
+#define MDNS_TYPE_A              1
+#define MDNS_TYPE_PTR           12
+#define MDNS_TYPE_TXT           16
+#define MDNS_TYPE_SRV           33
+#define MDNS_TYPE_ANY          255
+
+/* Our records (bit masks). */
+#define MDNS_RECORD_A         0x01
+#define MDNS_RECORD_PTR       0x02
+#define MDNS_RECORD_SRV       0x04
+#define MDNS_RECORD_TXT       0x08
+#define MDNS_RECORD_ENUM      0x10
+#define MDNS_RECORDS             5
+
+static const UCHAR ServiceName[] = MDNS_SERVICE_TYPE ".local";
+static const UCHAR EnumName[]    = "_services._dns-sd._udp.local";
+static const ip_addr_t MdnsGroup = IPADDR4_INIT_BYTES(224, 0, 0, 251);
+
+
+static struct
+{
+  UINT8  FlagStarted;
+  UINT8  FlagActive;                        // records are valid on current link and address.
+  UINT8  AnnounceLeft;
+  UINT8  AnnounceWait;                      // ticks until next announcement.
+  UINT8  AnnounceInterval;
+  UINT8  LabelCount;
+  UINT16 Port;                              // 0: host name only, no service records.
+  UINT16 TxtLength;
+  UCHAR  Txt[MDNS_TXT_MAX];                 // TXT record data.
+  UCHAR  HostName[MDNS_HOST_LENGTH + 1];    // announced host name (netif host name).
+  UCHAR  HostFqdn[MDNS_HOST_LENGTH + 7];    // "<host>.local"
+  UCHAR  InstanceFqdn[MDNS_HOST_LENGTH + sizeof(ServiceName) + 1];  // "<host>.<service type>.local"
+  ip4_addr_t Address;                       // announced address.
+  struct netif *NetIf;                      // interface that joined the mDNS group.
+  struct
+  {
+    const UCHAR *Suffix;                    // name (or end of name) already written in the message.
+    UINT16 Offset;
+  } Label[MDNS_LABELS_MAX];
+  UCHAR  Query[MDNS_PACKET_MAX];            // message received (lwIP context only).
+  UCHAR  Response[MDNS_PACKET_MAX];         // message being built (lwIP context only).
+  struct udp_pcb *UdpPcb;
+  struct struct_mdns_stats Stats;
+} Mdns;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Return the records answering a question. */
+static UINT8 mdns_answers(const UCHAR *Name, UINT16 Type);
+
+/* Check the answers of a response from another host for a conflict with our host name. */
+static void mdns_check_conflict(UINT16 Length);
+
+/* Read a name from a message. */
+static UINT16 mdns_get_name(const UCHAR *Packet, UINT16 Length, UINT16 Offset, UCHAR *Name);
+
+/* Read a 16-bit big-endian value. */
+static UINT16 mdns_get_u16(const UCHAR *Data);
+
+/* Join the mDNS multicast group and take note of the names to announce. */
+static void mdns_join(struct netif *NetIf);
+
+/* Return the records a querier already knows (known-answer suppression). */
+static UINT8 mdns_known_answer(const UCHAR *Name, UINT16 Type, UINT32 Ttl, UINT16 DataOffset, UINT16 DataLength, UINT16 Length);
+
+/* Write a name in the response, compressed. */
+static UINT16 mdns_put_name(UINT16 Offset, const UCHAR *Name);
+
+/* Write one of our records in the response. */
+static UINT16 mdns_put_record(UINT16 Offset, UINT8 Record, UINT32 TtlMax, UINT8 FlagCacheFlush);
+
+/* Message received on the mDNS port. */
+static void mdns_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port);
+
+/* Return all our records. */
+static UINT8 mdns_records(void);
+
+/* Build and send a response. */
+static void mdns_send(UINT8 Answers, UINT8 Additional, UINT32 TtlMax, const ip_addr_t *Address, UINT16 Port, UINT16 Id, UINT16 QuestionLength, UINT16 QuestionCount);
+
+/* Link, address and announcement timer. */
+static void mdns_timer(void *Arg);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_answers(). */
+/* ============================================================================================================================================================= *\
+                                    Return the records answering a question (name and type), 0 if the question is not for us.
+\* ============================================================================================================================================================= */
+static UINT8 mdns_answers(const UCHAR *Name, UINT16 Type)
+{
+  if (strcasecmp(Name, Mdns.HostFqdn) == 0)
+    return ((Type == MDNS_TYPE_A) || (Type == MDNS_TYPE_ANY)) ? MDNS_RECORD_A : 0;
+
+  if (Mdns.Port == 0) return 0;
+
+  if (strcasecmp(Name, ServiceName) == 0)
+    return ((Type == MDNS_TYPE_PTR) || (Type == MDNS_TYPE_ANY)) ? MDNS_RECORD_PTR : 0;
+
+  if (strcasecmp(Name, Mdns.InstanceFqdn) == 0)
+  {
+    if (Type == MDNS_TYPE_SRV) return MDNS_RECORD_SRV;
+    if (Type == MDNS_TYPE_TXT) return MDNS_RECORD_TXT;
+    if (Type == MDNS_TYPE_ANY) return MDNS_RECORD_SRV | MDNS_RECORD_TXT;
+    return 0;
+  }
+
+  if (strcasecmp(Name, EnumName) == 0)
+    return ((Type == MDNS_TYPE_PTR) || (Type == MDNS_TYPE_ANY)) ? MDNS_RECORD_ENUM : 0;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_check_conflict(). */
+/* ============================================================================================================================================================= *\
+               Check the answers of a response from another host: another address given for our host name is a conflict (counted and logged once).
+\* ============================================================================================================================================================= */
+static void mdns_check_conflict(UINT16 Length)
+{
+  UCHAR Name[MDNS_NAME_MAX];
+
+  UINT16 DataLength;
+  UINT16 Loop1UInt16;
+  UINT16 Offset;
+  UINT16 Type;
+
+  UINT32 Address;
+
+
+  /* Skip questions (normally none in a response). */
+  Offset = MDNS_HEADER_SIZE;
+  for (Loop1UInt16 = mdns_get_u16(&Mdns.Query[4]); Loop1UInt16 > 0; --Loop1UInt16)
+  {
+    Offset = mdns_get_name(Mdns.Query, Length, Offset, Name);
+    if ((Offset == 0) || ((Offset + 4) > Length)) return;
+    Offset += 4;
+  }
+
+  Address = ip4_addr_get_u32(&Mdns.Address);
+  for (Loop1UInt16 = mdns_get_u16(&Mdns.Query[6]); Loop1UInt16 > 0; --Loop1UInt16)
+  {
+    Offset = mdns_get_name(Mdns.Query, Length, Offset, Name);
+    if ((Offset == 0) || ((Offset + 10) > Length)) return;
+    Type       = mdns_get_u16(&Mdns.Query[Offset]);
+    DataLength = mdns_get_u16(&Mdns.Query[Offset + 8]);
+    Offset += 10;
+    if ((Offset + DataLength) > Length) return;
+
+    if ((Type == MDNS_TYPE_A) && (DataLength == 4) && (strcasecmp(Name, Mdns.HostFqdn) == 0) && (memcmp(&Mdns.Query[Offset], &Address, 4) != 0))
+    {
+      if (Mdns.Stats.Conflicts++ == 0) log_info(__LINE__, __func__, "mDNS: another host answers for <%s>.\r", Mdns.HostFqdn);
+    }
+    Offset += DataLength;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_get_name(). */
+/* ============================================================================================================================================================= *\
+                    Read a name (labels and compression pointers) from a message, as a dotted string in caller's buffer (MDNS_NAME_MAX bytes).
+                                     Return the offset following the name at its original position, 0 if the name is invalid.
+\* ============================================================================================================================================================= */
+static UINT16 mdns_get_name(const UCHAR *Packet, UINT16 Length, UINT16 Offset, UCHAR *Name)
+{
+  UINT8 Jumps;
+  UINT8 LabelLength;
+
+  UINT16 End;
+  UINT16 NameLength;
+
+
+  End        = 0;
+  Jumps      = 0;
+  NameLength = 0;
+  while (Offset < Length)
+  {
+    LabelLength = Packet[Offset];
+    if (LabelLength == 0x00)
+    {
+      Name[NameLength] = 0x00;
+      return (End != 0) ? End : (Offset + 1);
+    }
+
+    if ((LabelLength & 0xC0) == 0xC0)
+    {
+      /* Compression pointer: a bounded number of jumps prevents loops. */
+      if (((Offset + 2) > Length) || (++Jumps > 16)) return 0;
+      if (End == 0) End = Offset + 2;
+      Offset = ((UINT16)(LabelLength & 0x3F) << 8) | Packet[Offset + 1];
+      continue;
+    }
+    if ((LabelLength & 0xC0) != 0x00) return 0;
+
+    if (((Offset + 1 + LabelLength) > Length) || ((NameLength + LabelLength + 2) > MDNS_NAME_MAX)) return 0;
+    if (NameLength != 0) Name[NameLength++] = '.';
+    memcpy(&Name[NameLength], &Packet[Offset + 1], LabelLength);
+    NameLength += LabelLength;
+    Offset     += LabelLength + 1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_get_u16(). */
+/* ============================================================================================================================================================= *\
+                                                                 Read a 16-bit big-endian value.
+\* ============================================================================================================================================================= */
+static UINT16 mdns_get_u16(const UCHAR *Data)
+{
+  return ((UINT16)Data[0] << 8) | Data[1];
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_join(). */
+/* ============================================================================================================================================================= *\
+                 Join the mDNS multicast group on a netif and take note of the host name and address to announce. The group is left first, since
+                                           the membership may have been lost with the netif (cyw43 re-initialization).
+\* ============================================================================================================================================================= */
+static void mdns_join(struct netif *NetIf)
+{
+  if (Mdns.NetIf != NULL) igmp_leavegroup_netif(Mdns.NetIf, ip_2_ip4(&MdnsGroup));
+  igmp_joingroup_netif(NetIf, ip_2_ip4(&MdnsGroup));
+
+  Mdns.NetIf   = NetIf;
+  Mdns.Address = *netif_ip4_addr(NetIf);
+  snprintf(Mdns.HostName,     sizeof(Mdns.HostName),     "%s", netif_get_hostname(NetIf));
+  snprintf(Mdns.HostFqdn,     sizeof(Mdns.HostFqdn),     "%s.local", Mdns.HostName);
+  snprintf(Mdns.InstanceFqdn, sizeof(Mdns.InstanceFqdn), "%s.%s", Mdns.HostName, ServiceName);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_known_answer(). */
+/* ============================================================================================================================================================= *\
+                      Return our records that a querier lists in the answer section of its query with more than half of their TTL remaining
+                                            (known-answer suppression, RFC 6762 section 7.1): they are not sent again.
+\* ============================================================================================================================================================= */
+static UINT8 mdns_known_answer(const UCHAR *Name, UINT16 Type, UINT32 Ttl, UINT16 DataOffset, UINT16 DataLength, UINT16 Length)
+{
+  UCHAR Data[MDNS_NAME_MAX];
+
+  UINT32 Address;
+
+
+  if ((Type == MDNS_TYPE_A) && (DataLength == 4) && (Ttl >= (MDNS_HOST_TTL_SEC / 2)) && (strcasecmp(Name, Mdns.HostFqdn) == 0))
+  {
+    Address = ip4_addr_get_u32(&Mdns.Address);
+    if (memcmp(&Mdns.Query[DataOffset], &Address, 4) == 0) return MDNS_RECORD_A;
+    return 0;
+  }
+
+  if ((Type != MDNS_TYPE_PTR) || (Ttl < (MDNS_SERVICE_TTL_SEC / 2))) return 0;
+  if (mdns_get_name(Mdns.Query, Length, DataOffset, Data) == 0) return 0;
+
+  if ((strcasecmp(Name, ServiceName) == 0) && (strcasecmp(Data, Mdns.InstanceFqdn) == 0)) return MDNS_RECORD_PTR;
+  if ((strcasecmp(Name, EnumName) == 0) && (strcasecmp(Data, ServiceName) == 0)) return MDNS_RECORD_ENUM;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_put_name(). */
+/* ============================================================================================================================================================= *\
+                  Write a name in the response. The longest end of the name already written in the message is replaced by a compression pointer.
+                                                              Return the offset following the name.
+\* ============================================================================================================================================================= */
+static UINT16 mdns_put_name(UINT16 Offset, const UCHAR *Name)
+{
+  UINT8 LabelLength;
+  UINT8 Loop1UInt8;
+
+  const UCHAR *Dot;
+
+
+  while (*Name != 0x00)
+  {
+    for (Loop1UInt8 = 0; Loop1UInt8 < Mdns.LabelCount; ++Loop1UInt8)
+    {
+      if (strcasecmp(Mdns.Label[Loop1UInt8].Suffix, Name) == 0)
+      {
+        Mdns.Response[Offset]     = 0xC0 | (UCHAR)(Mdns.Label[Loop1UInt8].Offset >> 8);
+        Mdns.Response[Offset + 1] = (UCHAR)Mdns.Label[Loop1UInt8].Offset;
+        return Offset + 2;
+      }
+    }
+
+    if (Mdns.LabelCount < MDNS_LABELS_MAX)
+    {
+      Mdns.Label[Mdns.LabelCount].Suffix = Name;
+      Mdns.Label[Mdns.LabelCount].Offset = Offset;
+      ++Mdns.LabelCount;
+    }
+
+    Dot = strchr(Name, '.');
+    LabelLength = (Dot != NULL) ? (UINT8)(Dot - Name) : (UINT8)strlen(Name);
+    Mdns.Response[Offset] = LabelLength;
+    memcpy(&Mdns.Response[Offset + 1], Name, LabelLength);
+    Offset += LabelLength + 1;
+    Name   += LabelLength;
+    if (*Name == '.') ++Name;
+  }
+  Mdns.Response[Offset++] = 0x00;
+
+  return Offset;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_put_record(). */
+/* ============================================================================================================================================================= *\
+               Write one of our records in the response, with its TTL lowered to TtlMax (0 for goodbyes). The cache-flush bit is set on the records
+                    that only we may own (A, SRV, TXT) unless FlagCacheFlush is off (legacy queries). Return the offset following the record.
+\* ============================================================================================================================================================= */
+static UINT16 mdns_put_record(UINT16 Offset, UINT8 Record, UINT32 TtlMax, UINT8 FlagCacheFlush)
+{
+  UINT8 FlagUnique;
+
+  UINT16 DataOffset;
+  UINT16 Type;
+
+  UINT32 Address;
+  UINT32 Ttl;
+
+  const UCHAR *Name;
+
+
+  switch (Record)
+  {
+    case (MDNS_RECORD_A):
+      Name = Mdns.HostFqdn;
+      Type = MDNS_TYPE_A;
+      Ttl  = MDNS_HOST_TTL_SEC;
+      FlagUnique = FLAG_ON;
+    break;
+
+    case (MDNS_RECORD_PTR):
+      Name = ServiceName;
+      Type = MDNS_TYPE_PTR;
+      Ttl  = MDNS_SERVICE_TTL_SEC;
+      FlagUnique = FLAG_OFF;
+    break;
+
+    case (MDNS_RECORD_SRV):
+      Name = Mdns.InstanceFqdn;
+      Type = MDNS_TYPE_SRV;
+      Ttl  = MDNS_HOST_TTL_SEC;
+      FlagUnique = FLAG_ON;
+    break;
+
+    case (MDNS_RECORD_TXT):
+      Name = Mdns.InstanceFqdn;
+      Type = MDNS_TYPE_TXT;
+      Ttl  = MDNS_SERVICE_TTL_SEC;
+      FlagUnique = FLAG_ON;
+    break;
+
+    default:
+      Name = EnumName;
+      Type = MDNS_TYPE_PTR;
+      Ttl  = MDNS_SERVICE_TTL_SEC;
+      FlagUnique = FLAG_OFF;
+    break;
+  }
+  if (Ttl > TtlMax) Ttl = TtlMax;
+
+  /* Name, type, class IN (with cache-flush bit), TTL. Data length is filled in once data is written. */
+  Offset = mdns_put_name(Offset, Name);
+  Mdns.Response[Offset]     = (UCHAR)(Type >> 8);
+  Mdns.Response[Offset + 1] = (UCHAR)Type;
+  Mdns.Response[Offset + 2] = ((FlagUnique == FLAG_ON) && (FlagCacheFlush == FLAG_ON)) ? 0x80 : 0x00;
+  Mdns.Response[Offset + 3] = 0x01;
+  Mdns.Response[Offset + 4] = (UCHAR)(Ttl >> 24);
+  Mdns.Response[Offset + 5] = (UCHAR)(Ttl >> 16);
+  Mdns.Response[Offset + 6] = (UCHAR)(Ttl >> 8);
+  Mdns.Response[Offset + 7] = (UCHAR)Ttl;
+  DataOffset = Offset + 10;
+
+  switch (Record)
+  {
+    case (MDNS_RECORD_A):
+      Address = ip4_addr_get_u32(&Mdns.Address);
+      memcpy(&Mdns.Response[DataOffset], &Address, 4);
+      Offset = DataOffset + 4;
+    break;
+
+    case (MDNS_RECORD_PTR):
+      Offset = mdns_put_name(DataOffset, Mdns.InstanceFqdn);
+    break;
+
+    case (MDNS_RECORD_SRV):
+      /* Priority 0, weight 0, port, target host. */
+      memset(&Mdns.Response[DataOffset], 0x00, 4);
+      Mdns.Response[DataOffset + 4] = (UCHAR)(Mdns.Port >> 8);
+      Mdns.Response[DataOffset + 5] = (UCHAR)Mdns.Port;
+      Offset = mdns_put_name(DataOffset + 6, Mdns.HostFqdn);
+    break;
+
+    case (MDNS_RECORD_TXT):
+      memcpy(&Mdns.Response[DataOffset], Mdns.Txt, Mdns.TxtLength);
+      Offset = DataOffset + Mdns.TxtLength;
+    break;
+
+    default:
+      Offset = mdns_put_name(DataOffset, ServiceName);
+    break;
+  }
+  Mdns.Response[DataOffset - 2] = (UCHAR)((Offset - DataOffset) >> 8);
+  Mdns.Response[DataOffset - 1] = (UCHAR)(Offset - DataOffset);
+
+  return Offset;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_receive(). */
+/* ============================================================================================================================================================= *\
+               Message received on the mDNS port (lwIP context). Questions for our names are answered at once, in a single response: by multicast,
+                         or by unicast if asked so (QU bit) or if the query comes from a one-shot resolver (source port other than 5353).
+\* ============================================================================================================================================================= */
+static void mdns_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port)
+{
+  UCHAR Name[MDNS_NAME_MAX];
+
+  UINT8 Answers;
+  UINT8 FlagUnicast;
+  UINT8 Known;
+  UINT8 Match;
+
+  UINT16 AnswerCount;
+  UINT16 Class;
+  UINT16 DataLength;
+  UINT16 Length;
+  UINT16 Loop1UInt16;
+  UINT16 Offset;
+  UINT16 QuestionCount;
+  UINT16 Type;
+
+  UINT32 Elapsed;
+  UINT32 Ttl;
+
+  UINT64 StartTime;
+
+
+  StartTime = WIFI_TIME_US();
+  Length    = pbuf_copy_partial(PBuf, Mdns.Query, MDNS_PACKET_MAX, 0);
+  pbuf_free(PBuf);
+
+  if ((Length < MDNS_HEADER_SIZE) || (Mdns.FlagActive == FLAG_OFF)) return;
+  ++Mdns.Stats.Messages;
+
+  if (Mdns.Query[2] & 0x80)
+  {
+    /* Response of another host. */
+    mdns_check_conflict(Length);
+  }
+  else if ((Mdns.Query[2] & 0x78) == 0x00)
+  {
+    ++Mdns.Stats.Queries;
+
+    /* Questions. */
+    QuestionCount = mdns_get_u16(&Mdns.Query[4]);
+    AnswerCount   = mdns_get_u16(&Mdns.Query[6]);
+    Answers       = 0;
+    FlagUnicast   = FLAG_OFF;
+    Offset        = MDNS_HEADER_SIZE;
+    for (Loop1UInt16 = 0; Loop1UInt16 < QuestionCount; ++Loop1UInt16)
+    {
+      Offset = mdns_get_name(Mdns.Query, Length, Offset, Name);
+      if ((Offset == 0) || ((Offset + 4) > Length)) break;
+      Type  = mdns_get_u16(&Mdns.Query[Offset]);
+      Class = mdns_get_u16(&Mdns.Query[Offset + 2]);
+      Offset += 4;
+
+      Match = mdns_answers(Name, Type);
+      if ((Match != 0) && (Class & 0x8000)) FlagUnicast = FLAG_ON;
+      Answers |= Match;
+    }
+
+    if ((Loop1UInt16 == QuestionCount) && (Answers != 0))
+    {
+      /* Known answers listed by the querier. */
+      Known = 0;
+      for (Loop1UInt16 = 0; Loop1UInt16 < AnswerCount; ++Loop1UInt16)
+      {
+        Offset = mdns_get_name(Mdns.Query, Length, Offset, Name);
+        if ((Offset == 0) || ((Offset + 10) > Length)) break;
+        Type       = mdns_get_u16(&Mdns.Query[Offset]);
+        Ttl        = ((UINT32)mdns_get_u16(&Mdns.Query[Offset + 4]) << 16) | mdns_get_u16(&Mdns.Query[Offset + 6]);
+        DataLength = mdns_get_u16(&Mdns.Query[Offset + 8]);
+        Offset += 10;
+        if ((Offset + DataLength) > Length) break;
+
+        Known |= mdns_known_answer(Name, Type, Ttl, Offset, DataLength, Length);
+        Offset += DataLength;
+      }
+
+      if ((Answers & ~Known) == 0)
+      {
+        ++Mdns.Stats.Suppressed;
+      }
+      else if (Port != MDNS_PORT)
+      {
+        /* One-shot query: the question section is repeated (copied as is, so that its compression pointers remain valid). */
+        ++Mdns.Stats.Legacy;
+        Offset = MDNS_HEADER_SIZE;
+        for (Loop1UInt16 = 0; Loop1UInt16 < QuestionCount; ++Loop1UInt16)
+          Offset = mdns_get_name(Mdns.Query, Length, Offset, Name) + 4;
+        if ((Offset - MDNS_HEADER_SIZE) <= MDNS_QUESTIONS_MAX)
+        {
+          mdns_send(Answers, 0, MDNS_LEGACY_TTL_SEC, Address, Port, mdns_get_u16(&Mdns.Query[0]), Offset - MDNS_HEADER_SIZE, QuestionCount);
+          ++Mdns.Stats.Answered;
+        }
+      }
+      else
+      {
+        mdns_send(Answers & ~Known, 0, MDNS_TTL_RECORD, (FlagUnicast == FLAG_ON) ? Address : &MdnsGroup, MDNS_PORT, 0, 0, 0);
+        ++Mdns.Stats.Answered;
+      }
+    }
+  }
+
+  Elapsed = (UINT32)(WIFI_TIME_US() - StartTime);
+  Mdns.Stats.ProcessUsTotal += Elapsed;
+  if (Elapsed > Mdns.Stats.ProcessUsMax) Mdns.Stats.ProcessUsMax = Elapsed;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_records(). */
+/* ============================================================================================================================================================= *\
+                                     Return all our records: the host name, and the service records if a port has been given.
+\* ============================================================================================================================================================= */
+static UINT8 mdns_records(void)
+{
+  if (Mdns.Port == 0) return MDNS_RECORD_A;
+
+  return MDNS_RECORD_A | MDNS_RECORD_PTR | MDNS_RECORD_SRV | MDNS_RECORD_TXT | MDNS_RECORD_ENUM;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_send(). */
+/* ============================================================================================================================================================= *\
+            Build and send a response. The records related to the answers (SRV, TXT and A for a PTR, A for a SRV) are added in the additional section,
+                 as DNS-SD browsers need them. Id and the question section are only given for legacy queries, which also get no cache-flush bit.
+\* ============================================================================================================================================================= */
+static void mdns_send(UINT8 Answers, UINT8 Additional, UINT32 TtlMax, const ip_addr_t *Address, UINT16 Port, UINT16 Id, UINT16 QuestionLength, UINT16 QuestionCount)
+{
+  UINT8 FlagCacheFlush;
+  UINT8 Loop1UInt8;
+  UINT8 Record;
+
+  UINT16 AdditionalCount;
+  UINT16 AnswerCount;
+  UINT16 Offset;
+
+  struct pbuf *PBuf;
+
+
+  if (Mdns.UdpPcb == NULL) return;
+
+  if (Answers & MDNS_RECORD_PTR) Additional |= MDNS_RECORD_SRV | MDNS_RECORD_TXT | MDNS_RECORD_A;
+  if (Answers & MDNS_RECORD_SRV) Additional |= MDNS_RECORD_A;
+  Additional &= ~Answers;
+  FlagCacheFlush = (QuestionCount == 0) ? FLAG_ON : FLAG_OFF;
+
+  /* Header: response, authoritative answer. */
+  memset(Mdns.Response, 0x00, MDNS_HEADER_SIZE);
+  Mdns.Response[0] = (UCHAR)(Id >> 8);
+  Mdns.Response[1] = (UCHAR)Id;
+  Mdns.Response[2] = 0x84;
+  Mdns.Response[4] = (UCHAR)(QuestionCount >> 8);
+  Mdns.Response[5] = (UCHAR)QuestionCount;
+  memcpy(&Mdns.Response[MDNS_HEADER_SIZE], &Mdns.Query[MDNS_HEADER_SIZE], QuestionLength);
+  Offset = MDNS_HEADER_SIZE + QuestionLength;
+
+  Mdns.LabelCount = 0;
+  AnswerCount     = 0;
+  AdditionalCount = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < (MDNS_RECORDS * 2); ++Loop1UInt8)
+  {
+    Record = 1 << (Loop1UInt8 % MDNS_RECORDS);
+    if (((Loop1UInt8 < MDNS_RECORDS) ? Answers : Additional) & Record)
+    {
+      Offset = mdns_put_record(Offset, Record, TtlMax, FlagCacheFlush);
+      if (Loop1UInt8 < MDNS_RECORDS) ++AnswerCount; else ++AdditionalCount;
+    }
+  }
+  Mdns.Response[6]  = (UCHAR)(AnswerCount >> 8);
+  Mdns.Response[7]  = (UCHAR)AnswerCount;
+  Mdns.Response[10] = (UCHAR)(AdditionalCount >> 8);
+  Mdns.Response[11] = (UCHAR)AdditionalCount;
+
+  PBuf = pbuf_alloc(PBUF_TRANSPORT, Offset, PBUF_RAM);
+  if (PBuf == NULL)
+  {
+    ++Mdns.Stats.SendErrors;
+    return;
+  }
+  pbuf_take(PBuf, Mdns.Response, Offset);
+
+  if (udp_sendto(Mdns.UdpPcb, PBuf, Address, Port) == ERR_OK)
+    Mdns.Stats.BytesSent += Offset;
+  else
+    ++Mdns.Stats.SendErrors;
+  pbuf_free(PBuf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mdns_timer(). */
+/* ============================================================================================================================================================= *\
+               Link, address and announcement timer (lwIP context, every MDNS_TICK_MSEC). Records become valid when the default netif is up with an
+                address and a host name; they are announced then, and again whenever the link comes back or the address or the host name changes.
+\* ============================================================================================================================================================= */
+static void mdns_timer(void *Arg)
+{
+  const char *HostName;
+
+  struct netif *NetIf;
+
+
+  NetIf    = netif_default;
+  HostName = (NetIf != NULL) ? netif_get_hostname(NetIf) : NULL;
+
+  if ((NetIf == NULL) || !netif_is_up(NetIf) || !netif_is_link_up(NetIf) || ip4_addr_isany_val(*netif_ip4_addr(NetIf)) || (HostName == NULL) || (HostName[0] == 0x00))
+  {
+    /* No link: announce again when it comes back. */
+    Mdns.FlagActive   = FLAG_OFF;
+    Mdns.AnnounceLeft = 0;
+  }
+  else if ((Mdns.FlagActive == FLAG_OFF) || (NetIf != Mdns.NetIf) || (ip4_addr_get_u32(netif_ip4_addr(NetIf)) != ip4_addr_get_u32(&Mdns.Address)) ||
+           (strncmp(HostName, Mdns.HostName, MDNS_HOST_LENGTH) != 0))
+  {
+    /* Same link and address, new host name: the records of the former name are withdrawn first. */
+    if ((Mdns.FlagActive == FLAG_ON) && (NetIf == Mdns.NetIf) && (ip4_addr_get_u32(netif_ip4_addr(NetIf)) == ip4_addr_get_u32(&Mdns.Address)))
+    {
+      mdns_send(mdns_records(), 0, 0, &MdnsGroup, MDNS_PORT, 0, 0, 0);
+      ++Mdns.Stats.Announcements;
+    }
+
+    mdns_join(NetIf);
+    Mdns.FlagActive       = FLAG_ON;
+    Mdns.AnnounceLeft     = MDNS_ANNOUNCE_COUNT;
+    Mdns.AnnounceWait     = 0;
+    Mdns.AnnounceInterval = 1;
+  }
+
+  if ((Mdns.AnnounceLeft > 0) && (Mdns.AnnounceWait-- == 0))
+  {
+    mdns_send(mdns_records(), 0, MDNS_TTL_RECORD, &MdnsGroup, MDNS_PORT, 0, 0, 0);
+    ++Mdns.Stats.Announcements;
+    --Mdns.AnnounceLeft;
+    Mdns.AnnounceWait      = Mdns.AnnounceInterval - 1;
+    Mdns.AnnounceInterval *= 2;
+  }
+
+  sys_timeout(MDNS_TICK_MSEC, mdns_timer, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mdns_announce(). */
+/* ============================================================================================================================================================= *\
+                       Announce our records again (e.g. after the TXT items of the application have changed meaning, or to test discovery).
+\* ============================================================================================================================================================= */
+void wifi_mdns_announce(void)
+{
+  WIFI_LWIP_BEGIN();
+  if (Mdns.FlagActive == FLAG_ON)
+  {
+    Mdns.AnnounceLeft     = MDNS_ANNOUNCE_COUNT;
+    Mdns.AnnounceWait     = 0;
+    Mdns.AnnounceInterval = 1;
+  }
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mdns_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                             Display responder state and statistics.
+\* ============================================================================================================================================================= */
+void wifi_mdns_display_stats(void)
+{
+  UCHAR Address[16];
+
+  struct struct_mdns_stats Stats;
+
+
+  wifi_mdns_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                     mDNS / DNS-SD responder\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  WIFI_LWIP_BEGIN();
+  if (Mdns.FlagActive == FLAG_ON)
+  {
+    ip4addr_ntoa_r(&Mdns.Address, Address, sizeof(Address));
+    log_info(__LINE__, __func__, "Host:                     %s -> %s\r", Mdns.HostFqdn, Address);
+    if (Mdns.Port != 0)
+      log_info(__LINE__, __func__, "Service:                  %s -> port %u\r", Mdns.InstanceFqdn, Mdns.Port);
+  }
+  else
+  {
+    log_info(__LINE__, __func__, "Responder %s (waiting for link, address and host name).\r", (Mdns.FlagStarted == FLAG_ON) ? "started" : "stopped");
+  }
+  WIFI_LWIP_END();
+  log_info(__LINE__, __func__, "Messages received:        %lu   queries: %lu   answered: %lu   legacy: %lu\r", Stats.Messages, Stats.Queries, Stats.Answered, Stats.Legacy);
+  log_info(__LINE__, __func__, "Known-answer suppressed:  %lu   announcements: %lu   conflicts: %lu\r", Stats.Suppressed, Stats.Announcements, Stats.Conflicts);
+  log_info(__LINE__, __func__, "Bytes sent:               %lu   send errors: %lu\r", Stats.BytesSent, Stats.SendErrors);
+  if (Stats.Messages)
+    log_info(__LINE__, __func__, "Processing per message:   average %llu usec   max %lu usec\r", Stats.ProcessUsTotal / Stats.Messages, Stats.ProcessUsMax);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mdns_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                  Retrieve responder statistics.
+\* ============================================================================================================================================================= */
+void wifi_mdns_get_stats(struct struct_mdns_stats *Stats)
+{
+  WIFI_LWIP_BEGIN();
+  *Stats = Mdns.Stats;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mdns_start(). */
+/* ============================================================================================================================================================= *\
+           Start the mDNS / DNS-SD responder. The host name of the default netif is advertised as "<name>.local" and, if Port is not 0, as an instance
+            of MDNS_SERVICE_TYPE on that port, with TxtItems ("key=value" strings) in its TXT record. Records are announced as soon as the link is up
+              with an address, so the responder may be started before the connection. Return -1 if TXT items are too long or if no pcb is available.
+\* ============================================================================================================================================================= */
+INT16 wifi_mdns_start(UINT16 Port, const UCHAR *const *TxtItems, UINT8 TxtCount)
+{
+  UINT8 Loop1UInt8;
+
+  UINT16 ItemLength;
+  UINT16 TxtLength;
+
+
+  /* TXT record: length-prefixed items, or a single empty string (RFC 6763 section 6.1). */
+  TxtLength = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < TxtCount; ++Loop1UInt8)
+  {
+    ItemLength = strlen(TxtItems[Loop1UInt8]);
+    if ((ItemLength > 255) || ((TxtLength + ItemLength + 1) > MDNS_TXT_MAX)) return -1;
+    TxtLength += ItemLength + 1;
+  }
+
+  WIFI_LWIP_BEGIN();
+  if (Mdns.FlagStarted == FLAG_ON)
+  {
+    WIFI_LWIP_END();
+    return 0;
+  }
+
+  Mdns.UdpPcb = udp_new_ip_type(IPADDR_TYPE_V4);
+  if ((Mdns.UdpPcb == NULL) || (udp_bind(Mdns.UdpPcb, IP4_ADDR_ANY, MDNS_PORT) != ERR_OK))
+  {
+    if (Mdns.UdpPcb != NULL) udp_remove(Mdns.UdpPcb);
+    Mdns.UdpPcb = NULL;
+    WIFI_LWIP_END();
+    return -1;
+  }
+  Mdns.UdpPcb->ttl = 255;  // RFC 6762 section 11.
+  udp_set_multicast_ttl(Mdns.UdpPcb, 255);
+  udp_recv(Mdns.UdpPcb, mdns_receive, NULL);
+
+  Mdns.Port      = Port;
+  Mdns.TxtLength = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < TxtCount; ++Loop1UInt8)
+  {
+    ItemLength = strlen(TxtItems[Loop1UInt8]);
+    Mdns.Txt[Mdns.TxtLength] = (UCHAR)ItemLength;
+    memcpy(&Mdns.Txt[Mdns.TxtLength + 1], TxtItems[Loop1UInt8], ItemLength);
+    Mdns.TxtLength += ItemLength + 1;
+  }
+  if (Mdns.TxtLength == 0) Mdns.Txt[Mdns.TxtLength++] = 0x00;
+
+  Mdns.FlagStarted = FLAG_ON;
+  Mdns.FlagActive  = FLAG_OFF;
+  Mdns.NetIf       = NULL;
+  mdns_timer(NULL);
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mdns_stop(). */
+/* ============================================================================================================================================================= *\
+                     Send goodbyes (records with TTL 0, so that caches drop them at once), leave the multicast group and stop the responder.
+\* ============================================================================================================================================================= */
+void wifi_mdns_stop(void)
+{
+  WIFI_LWIP_BEGIN();
+  if (Mdns.FlagStarted == FLAG_OFF)
+  {
+    WIFI_LWIP_END();
+    return;
+  }
+
+  sys_untimeout(mdns_timer, NULL);
+  if (Mdns.FlagActive == FLAG_ON)
+  {
+    mdns_send(mdns_records(), 0, 0, &MdnsGroup, MDNS_PORT, 0, 0, 0);
+    ++Mdns.Stats.Announcements;
+  }
+  if (Mdns.NetIf != NULL) igmp_leavegroup_netif(Mdns.NetIf, ip_2_ip4(&MdnsGroup));
+
+  udp_remove(Mdns.UdpPcb);
+  Mdns.UdpPcb      = NULL;
+  Mdns.NetIf       = NULL;
+  Mdns.FlagActive  = FLAG_OFF;
+  Mdns.FlagStarted = FLAG_OFF;
+  WIFI_LWIP_END();
+
+  return;
+}
@@ -0,0 +1,67 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-MDNS.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-MDNS.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_MDNS_H
+#define _WIFI_MDNS_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#ifndef MDNS_SERVICE_TYPE
+#define MDNS_SERVICE_TYPE     "_picowifi._tcp"   // DNS-SD service type advertised (browse with "avahi-browse _picowifi._tcp" or "dns-sd -B _picowifi._tcp").
+#endif  // MDNS_SERVICE_TYPE
+#define MDNS_PORT                     5353
+#define MDNS_PACKET_MAX                640     // largest message built or parsed (longer queries are parsed up to this size).
+#define MDNS_TXT_MAX                   128     // TXT record data (all items, with their length bytes).
+#define MDNS_HOST_TTL_SEC              120     // A and SRV records (records naming a host, RFC 6762 section 10).
+#define MDNS_SERVICE_TTL_SEC          4500     // PTR and TXT records.
+#define MDNS_LEGACY_TTL_SEC             10     // longest TTL in answers to one-shot (legacy unicast) queries.
+#define MDNS_ANNOUNCE_COUNT              3     // unsolicited announcements after link-up or address change, 1 then 2 seconds apart.
+#define MDNS_TICK_MSEC                1000     // period of the link / address check and announcement timer.
+
+
+/* Responder statistics. */
+struct struct_mdns_stats
+{
+  UINT32 Queries;                              // queries received.
+  UINT32 Answered;                             // queries answered (one response each).
+  UINT32 Suppressed;                           // queries not answered because the querier listed all our answers as known (known-answer suppression).
+  UINT32 Legacy;                               // one-shot queries (source port other than 5353), answered by unicast.
+  UINT32 Announcements;                        // unsolicited responses (announcements and goodbyes).
+  UINT32 Conflicts;                            // responses of another host giving another address for our host name.
+  UINT32 SendErrors;
+  UINT32 BytesSent;
+  UINT64 ProcessUsTotal;                       // time spent handling received messages, to check the cost of leaving the responder on.
+  UINT32 ProcessUsMax;
+  UINT32 Messages;                             // messages received (queries and responses of other hosts).
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Announce our records again. */
+void wifi_mdns_announce(void);
+
+/* Display responder state and statistics. */
+void wifi_mdns_display_stats(void);
+
+/* Retrieve responder statistics. */
+void wifi_mdns_get_stats(struct struct_mdns_stats *Stats);
+
+/* Start the mDNS / DNS-SD responder. */
+INT16 wifi_mdns_start(UINT16 Port, const UCHAR *const *TxtItems, UINT8 TxtCount);
+
+/* Send goodbyes and stop the responder. */
+void wifi_mdns_stop(void);
+
+#endif  // _WIFI_MDNS_H
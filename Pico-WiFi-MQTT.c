@@ -0,0 +1,1146 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-MQTT.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Non-blocking MQTT 3.1.1 client built on the lwIP raw API, part of Pico-WiFi-Module.
+   wifi_mqtt_publish() only encodes the message in a ring buffer and returns; the client sends it in the background:
+   - Pipelining: up to MQTT_INFLIGHT_MAX QoS1 messages are sent without waiting for their PUBACK. QoS0 messages are sent
+     as soon as TCP accepts them.
+   - Batching:   all queued messages are handed to TCP in a row before a single tcp_output(). While a segment is waiting for its
+     acknowledgement, lwIP appends the next small messages to the same unsent segment (Nagle), so a burst of small
+     publications leaves in a few full segments instead of one segment each.
+   - Session:    by default, the client asks for a persistent session (clean session = 0). Keepalive is handled with PINGREQ;
+     a broker silent for 1.5 keepalive period is considered gone.
+   - Reconnect:  on a connection loss, or as soon as the Wi-Fi link goes down, the connection is dropped. QoS1 messages not
+     yet acknowledged are sent again with the DUP flag after reconnection; messages published while disconnected
+     are kept in the queue. Reconnection is retried with a doubling back-off, immediately once the link is back.
+     Subscriptions are sent again when the broker did not keep the session.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port and
+   tested against a local broker (for example mosquitto -v).
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+
+#include "Pico-WiFi-MQTT.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+/* MQTT control packet types (first byte, high nibble). */
+#define MQTT_CONNECT       0x10
+#define MQTT_CONNACK       0x20
+#define MQTT_PUBLISH       0x30
+#define MQTT_PUBACK        0x40
+#define MQTT_SUBSCRIBE     0x82             // includes mandatory flags.
+#define MQTT_SUBACK        0x90
+#define MQTT_PINGREQ       0xC0
+#define MQTT_PINGRESP      0xD0
+#define MQTT_DISCONNECT    0xE0
+
+#define MQTT_FLAG_DUP      0x08             // PUBLISH: message sent again.
+
+/* State of a message slot. */
+#define MQTT_SLOT_QUEUED      1             // waiting to be handed to TCP.
+#define MQTT_SLOT_INFLIGHT    2             // QoS1, sent and waiting for PUBACK.
+#define MQTT_SLOT_DONE        3             // sent (QoS0) or acknowledged (QoS1), space will be reclaimed.
+
+/* Slot indexes wrap with a mask. */
+_Static_assert((MQTT_QUEUE_SIZE & (MQTT_QUEUE_SIZE - 1)) == 0, "MQTT_QUEUE_SIZE must be a power of 2");
+
+
+static struct
+{
+  UINT8  State;
+  UINT8  FlagPingPending;                   // PINGREQ sent, waiting for the broker.
+  UINT8  SlotHead;                          // oldest message still holding buffer space.
+  UINT8  SlotSend;                          // next message to hand to TCP.
+  UINT8  SlotTail;                          // next free slot.
+  UINT8  SubscriptionCount;
+  UINT16 BufferHead;                        // offset of the oldest packet in Buffer[].
+  UINT16 BufferTail;                        // first byte after the newest packet in Buffer[].
+  UINT16 NextPacketId;
+  UINT16 RxLength;                          // bytes of the current incoming packet held in RxBuffer[].
+  UINT32 RxDiscard;                         // bytes left to skip of an oversize incoming packet.
+  UINT32 ReconnectDelay;                    // msec.
+  UINT64 RetryTime;                         // time stamp of the next connection attempt.
+  UINT64 ConnectTime;                       // time stamp of the current connection attempt.
+  UINT64 LastRx;
+  UINT64 LastTx;
+  const UCHAR *Subscription[MQTT_MAX_SUBSCRIPTIONS];
+  UINT8  SubscriptionQoS[MQTT_MAX_SUBSCRIPTIONS];
+  struct struct_mqtt_settings Settings;
+  struct struct_mqtt_stats    Stats;
+  mqtt_message_callback Callback;
+  void *Context;
+  struct tcp_pcb *TcpPcb;
+  struct
+  {
+    UINT16 Offset;                          // encoded PUBLISH packet in Buffer[].
+    UINT16 Length;
+    UINT16 PacketId;
+    UINT8  QoS;
+    UINT8  State;
+    UINT64 SendTime;
+  } Slot[MQTT_QUEUE_SIZE];
+  UCHAR Buffer[MQTT_BUFFER_SIZE];
+  UCHAR RxBuffer[MQTT_RX_BUFFER];
+} Mqtt;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Reserve room for an encoded packet in the ring buffer. */
+static INT32 mqtt_alloc(UINT16 Length);
+
+/* Open the TCP connection to the broker. */
+static void mqtt_connect(void);
+
+/* Drop the connection and schedule a reconnection. */
+static void mqtt_drop(void);
+
+/* Process a complete packet received from the broker. */
+static INT16 mqtt_handle_packet(UCHAR *Packet, UINT16 Length);
+
+/* Hand queued messages to TCP. */
+static void mqtt_output(void);
+
+/* Return the total length of the packet at the start of RxBuffer[]. */
+static INT32 mqtt_packet_length(void);
+
+/* Encode a remaining length. */
+static UINT8 mqtt_put_length(UCHAR *Buffer, UINT32 Length);
+
+/* Reclaim buffer space of messages sent or acknowledged. */
+static void mqtt_release(void);
+
+/* Send a small control packet. */
+static INT16 mqtt_send_control(const UCHAR *Packet, UINT16 Length);
+
+/* Send the SUBSCRIBE packet of a stored subscription. */
+static INT16 mqtt_send_subscribe(UINT8 Index);
+
+/* TCP: connection established. */
+static err_t mqtt_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP: connection error (pcb already freed by lwIP). */
+static void mqtt_tcp_error(void *Arg, err_t Error);
+
+/* TCP: data received from the broker. */
+static err_t mqtt_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged, more may be sent. */
+static err_t mqtt_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+/* Keepalive, time-out and reconnection timer. */
+static void mqtt_timer(void *Arg);
+
+/* Write a length-prefixed string to TCP. */
+static err_t mqtt_write_string(const UCHAR *String);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_alloc(). */
+/* ============================================================================================================================================================= *\
+                                         Reserve room for an encoded packet in the ring buffer. Return its offset, or -1 if full.
+                                  A packet is never split: when it does not fit at the end of the buffer, it is placed at the start.
+\* ============================================================================================================================================================= */
+static INT32 mqtt_alloc(UINT16 Length)
+{
+  UINT16 Offset;
+
+
+  if ((UINT8)(Mqtt.SlotTail - Mqtt.SlotHead) >= MQTT_QUEUE_SIZE) return -1;
+
+  if (Mqtt.SlotHead == Mqtt.SlotTail)
+  {
+    Mqtt.BufferHead = 0;
+    Mqtt.BufferTail = 0;
+  }
+
+  if ((Mqtt.SlotHead == Mqtt.SlotTail) || (Mqtt.BufferTail > Mqtt.BufferHead))
+  {
+    /* Free space is [BufferTail, end of buffer) and [0, BufferHead). */
+    if ((MQTT_BUFFER_SIZE - Mqtt.BufferTail) >= Length)
+      Offset = Mqtt.BufferTail;
+    else if (Mqtt.BufferHead > Length)
+      Offset = 0;
+    else
+      return -1;
+  }
+  else
+  {
+    /* Buffer has wrapped, free space is [BufferTail, BufferHead). */
+    if ((Mqtt.BufferHead - Mqtt.BufferTail) > Length)
+      Offset = Mqtt.BufferTail;
+    else
+      return -1;
+  }
+
+  Mqtt.BufferTail = Offset + Length;
+
+  return Offset;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_connect(). */
+/* ============================================================================================================================================================= *\
+                                                               Open the TCP connection to the broker.
+\* ============================================================================================================================================================= */
+static void mqtt_connect(void)
+{
+  Mqtt.ConnectTime = WIFI_TIME_US();
+  Mqtt.State       = MQTT_STATE_CONNECTING;
+
+  Mqtt.TcpPcb = tcp_new_ip_type(IP_GET_TYPE(&Mqtt.Settings.BrokerAddress));
+  if (Mqtt.TcpPcb == NULL)
+  {
+    mqtt_drop();
+    return;
+  }
+
+  tcp_arg(Mqtt.TcpPcb,  NULL);
+  tcp_err(Mqtt.TcpPcb,  mqtt_tcp_error);
+  tcp_recv(Mqtt.TcpPcb, mqtt_tcp_receive);
+  tcp_sent(Mqtt.TcpPcb, mqtt_tcp_sent);
+
+  if (tcp_connect(Mqtt.TcpPcb, &Mqtt.Settings.BrokerAddress, Mqtt.Settings.Port, mqtt_tcp_connected) != ERR_OK) mqtt_drop();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_drop(). */
+/* ============================================================================================================================================================= *\
+                                                         Drop the connection and schedule a reconnection.
+                                          The caller must return ERR_ABRT if this is called from a lwIP callback of the pcb.
+\* ============================================================================================================================================================= */
+static void mqtt_drop(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  if (Mqtt.TcpPcb != NULL)
+  {
+    tcp_arg(Mqtt.TcpPcb,  NULL);
+    tcp_err(Mqtt.TcpPcb,  NULL);
+    tcp_recv(Mqtt.TcpPcb, NULL);
+    tcp_sent(Mqtt.TcpPcb, NULL);
+    tcp_abort(Mqtt.TcpPcb);
+    Mqtt.TcpPcb = NULL;
+  }
+
+  if (Mqtt.State == MQTT_STATE_CONNECTED)
+    ++Mqtt.Stats.ConnectionLosses;
+  else
+    ++Mqtt.Stats.ConnectFailures;
+
+  /* QoS1 messages not acknowledged will be sent again, with DUP flag, once reconnected. */
+  for (Loop1UInt8 = Mqtt.SlotHead; Loop1UInt8 != Mqtt.SlotSend; ++Loop1UInt8)
+  {
+    if (Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].State == MQTT_SLOT_INFLIGHT)
+    {
+      Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].State = MQTT_SLOT_QUEUED;
+      Mqtt.Buffer[Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].Offset] |= MQTT_FLAG_DUP;
+      ++Mqtt.Stats.Retransmits;
+    }
+  }
+  Mqtt.SlotSend        = Mqtt.SlotHead;
+  Mqtt.Stats.InFlight  = 0;
+  Mqtt.RxLength        = 0;
+  Mqtt.RxDiscard       = 0;
+  Mqtt.FlagPingPending = FLAG_OFF;
+
+  Mqtt.State     = MQTT_STATE_WAIT_RETRY;
+  Mqtt.RetryTime = WIFI_TIME_US() + (Mqtt.ReconnectDelay * 1000ull);
+  Mqtt.ReconnectDelay *= 2;
+  if (Mqtt.ReconnectDelay > MQTT_RECONNECT_MAX_MSEC) Mqtt.ReconnectDelay = MQTT_RECONNECT_MAX_MSEC;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_handle_packet(). */
+/* ============================================================================================================================================================= *\
+                                        Process a complete packet received from the broker. Return -1 if the connection was dropped.
+\* ============================================================================================================================================================= */
+static INT16 mqtt_handle_packet(UCHAR *Packet, UINT16 Length)
+{
+  UCHAR PubAck[4];
+
+  UINT8 Loop1UInt8;
+  UINT8 QoS;
+
+  UINT16 Index;
+  UINT16 PacketId;
+  UINT16 TopicLength;
+
+
+  /* Skip fixed header. */
+  for (Index = 1; Packet[Index] & 0x80; ++Index);
+  ++Index;
+
+  switch (Packet[0] & 0xF0)
+  {
+    case (MQTT_CONNACK):
+      if (((Length - Index) < 2) || (Packet[Index + 1] != 0))
+      {
+        /* Connection refused (bad credentials, client id rejected...). */
+        mqtt_drop();
+        return -1;
+      }
+
+      Mqtt.State                    = MQTT_STATE_CONNECTED;
+      Mqtt.ReconnectDelay           = MQTT_RECONNECT_MIN_MSEC;
+      Mqtt.Stats.FlagSessionPresent = (Packet[Index] & 0x01) ? FLAG_ON : FLAG_OFF;
+      ++Mqtt.Stats.Connects;
+
+      /* Broker did not keep our session: subscribe again. */
+      if (Mqtt.Stats.FlagSessionPresent == FLAG_OFF)
+        for (Loop1UInt8 = 0; Loop1UInt8 < Mqtt.SubscriptionCount; ++Loop1UInt8)
+          mqtt_send_subscribe(Loop1UInt8);
+
+      mqtt_output();
+    break;
+
+    case (MQTT_PUBLISH & 0xF0):
+      QoS = (Packet[0] >> 1) & 0x03;
+      if ((Index + 2) > Length) break;
+      TopicLength = (Packet[Index] << 8) | Packet[Index + 1];
+      Index      += 2;
+      if ((Index + TopicLength + ((QoS) ? 2 : 0)) > Length) break;
+
+      PacketId = 0;
+      if (QoS)
+      {
+        PacketId = (Packet[Index + TopicLength] << 8) | Packet[Index + TopicLength + 1];
+      }
+
+      ++Mqtt.Stats.Received;
+      if (Mqtt.Callback != NULL)
+        Mqtt.Callback(&Packet[Index], TopicLength, &Packet[Index + TopicLength + ((QoS) ? 2 : 0)], Length - (Index + TopicLength + ((QoS) ? 2 : 0)), Mqtt.Context);
+
+      /* Subscriptions are requested at QoS1 at most. */
+      if (QoS == 1)
+      {
+        PubAck[0] = MQTT_PUBACK;
+        PubAck[1] = 2;
+        PubAck[2] = PacketId >> 8;
+        PubAck[3] = PacketId & 0xFF;
+        mqtt_send_control(PubAck, sizeof(PubAck));
+      }
+    break;
+
+    case (MQTT_PUBACK):
+      if ((Length - Index) < 2) break;
+      PacketId = (Packet[Index] << 8) | Packet[Index + 1];
+
+      for (Loop1UInt8 = Mqtt.SlotHead; Loop1UInt8 != Mqtt.SlotSend; ++Loop1UInt8)
+      {
+        if ((Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].State == MQTT_SLOT_INFLIGHT) && (Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].PacketId == PacketId))
+        {
+          Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].State = MQTT_SLOT_DONE;
+          Mqtt.Stats.AckTimeTotalUs += (WIFI_TIME_US() - Mqtt.Slot[Loop1UInt8 % MQTT_QUEUE_SIZE].SendTime);
+          --Mqtt.Stats.InFlight;
+          ++Mqtt.Stats.Acked;
+          ++Mqtt.Stats.Published;
+          break;
+        }
+      }
+
+      /* A slot is free in the window, send what was waiting. */
+      mqtt_output();
+    break;
+
+    case (MQTT_SUBACK):
+    case (MQTT_PINGRESP):
+    default:
+      /* Nothing to do, reception time has already been recorded. */
+    break;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_output(). */
+/* ============================================================================================================================================================= *\
+                                    Hand queued messages to TCP, as many as the in-flight window and the TCP send buffer allow,
+                                                      then push them with a single tcp_output().
+\* ============================================================================================================================================================= */
+static void mqtt_output(void)
+{
+  UINT8 Index;
+
+  UINT16 Written;
+
+
+  if ((Mqtt.State != MQTT_STATE_CONNECTED) || (Mqtt.TcpPcb == NULL)) return;
+
+  Written = 0;
+  while (Mqtt.SlotSend != Mqtt.SlotTail)
+  {
+    Index = Mqtt.SlotSend % MQTT_QUEUE_SIZE;
+
+    /* QoS0 message already sent before a reconnection. */
+    if (Mqtt.Slot[Index].State != MQTT_SLOT_QUEUED)
+    {
+      ++Mqtt.SlotSend;
+      continue;
+    }
+
+    if ((Mqtt.Slot[Index].QoS) && (Mqtt.Stats.InFlight >= MQTT_INFLIGHT_MAX)) break;
+    if (tcp_sndbuf(Mqtt.TcpPcb) < Mqtt.Slot[Index].Length) break;
+    if (tcp_write(Mqtt.TcpPcb, &Mqtt.Buffer[Mqtt.Slot[Index].Offset], Mqtt.Slot[Index].Length, TCP_WRITE_FLAG_COPY) != ERR_OK) break;
+
+    if (Mqtt.Slot[Index].QoS)
+    {
+      Mqtt.Slot[Index].State    = MQTT_SLOT_INFLIGHT;
+      Mqtt.Slot[Index].SendTime = WIFI_TIME_US();
+      ++Mqtt.Stats.InFlight;
+      if (Mqtt.Stats.InFlight > Mqtt.Stats.InFlightMax) Mqtt.Stats.InFlightMax = Mqtt.Stats.InFlight;
+    }
+    else
+    {
+      Mqtt.Slot[Index].State = MQTT_SLOT_DONE;
+      ++Mqtt.Stats.Published;
+    }
+    ++Mqtt.SlotSend;
+    ++Written;
+  }
+
+  if (Written)
+  {
+    tcp_output(Mqtt.TcpPcb);
+    Mqtt.LastTx = WIFI_TIME_US();
+    Mqtt.Stats.Written += Written;
+    ++Mqtt.Stats.Flushes;
+  }
+
+  mqtt_release();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_packet_length(). */
+/* ============================================================================================================================================================= *\
+                                        Return the total length of the packet at the start of RxBuffer[],
+                                        0 if its fixed header is not complete yet, or -1 if the header is malformed.
+\* ============================================================================================================================================================= */
+static INT32 mqtt_packet_length(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 Multiplier;
+  UINT32 Remaining;
+
+
+  Multiplier = 1;
+  Remaining  = 0;
+  for (Loop1UInt8 = 1; Loop1UInt8 < 5; ++Loop1UInt8)
+  {
+    if (Loop1UInt8 >= Mqtt.RxLength) return 0;
+
+    Remaining += (Mqtt.RxBuffer[Loop1UInt8] & 0x7F) * Multiplier;
+    if ((Mqtt.RxBuffer[Loop1UInt8] & 0x80) == 0) return (Loop1UInt8 + 1 + Remaining);
+    Multiplier *= 128;
+  }
+
+  return -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_put_length(). */
+/* ============================================================================================================================================================= *\
+                                                      Encode a remaining length. Return the number of bytes used.
+\* ============================================================================================================================================================= */
+static UINT8 mqtt_put_length(UCHAR *Buffer, UINT32 Length)
+{
+  UINT8 Count;
+
+
+  Count = 0;
+  do
+  {
+    Buffer[Count] = Length % 128;
+    Length /= 128;
+    if (Length) Buffer[Count] |= 0x80;
+    ++Count;
+  } while (Length);
+
+  return Count;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_release(). */
+/* ============================================================================================================================================================= *\
+                                              Reclaim buffer space of messages sent (QoS0) or acknowledged (QoS1), in order.
+\* ============================================================================================================================================================= */
+static void mqtt_release(void)
+{
+  while ((Mqtt.SlotHead != Mqtt.SlotSend) && (Mqtt.Slot[Mqtt.SlotHead % MQTT_QUEUE_SIZE].State == MQTT_SLOT_DONE))
+    ++Mqtt.SlotHead;
+
+  if (Mqtt.SlotHead == Mqtt.SlotTail)
+  {
+    Mqtt.BufferHead = 0;
+    Mqtt.BufferTail = 0;
+  }
+  else
+  {
+    Mqtt.BufferHead = Mqtt.Slot[Mqtt.SlotHead % MQTT_QUEUE_SIZE].Offset;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_send_control(). */
+/* ============================================================================================================================================================= *\
+                                                    Send a small control packet (PUBACK, PINGREQ, DISCONNECT).
+\* ============================================================================================================================================================= */
+static INT16 mqtt_send_control(const UCHAR *Packet, UINT16 Length)
+{
+  if (Mqtt.TcpPcb == NULL) return -1;
+
+  if (tcp_write(Mqtt.TcpPcb, Packet, Length, TCP_WRITE_FLAG_COPY) != ERR_OK) return -1;
+  tcp_output(Mqtt.TcpPcb);
+  Mqtt.LastTx = WIFI_TIME_US();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_send_subscribe(). */
+/* ============================================================================================================================================================= *\
+                                                         Send the SUBSCRIBE packet of a stored subscription.
+\* ============================================================================================================================================================= */
+static INT16 mqtt_send_subscribe(UINT8 Index)
+{
+  UCHAR Header[8];
+
+  UINT8 Length;
+
+
+  if (Mqtt.TcpPcb == NULL) return -1;
+
+  if (++Mqtt.NextPacketId == 0) Mqtt.NextPacketId = 1;
+
+  Header[0] = MQTT_SUBSCRIBE;
+  Length    = 1 + mqtt_put_length(&Header[1], 2 + 2 + strlen(Mqtt.Subscription[Index]) + 1);
+  Header[Length++] = Mqtt.NextPacketId >> 8;
+  Header[Length++] = Mqtt.NextPacketId & 0xFF;
+
+  if (tcp_write(Mqtt.TcpPcb, Header, Length, TCP_WRITE_FLAG_COPY) != ERR_OK) return -1;
+  if (mqtt_write_string(Mqtt.Subscription[Index]) != ERR_OK) return -1;
+  if (tcp_write(Mqtt.TcpPcb, &Mqtt.SubscriptionQoS[Index], 1, TCP_WRITE_FLAG_COPY) != ERR_OK) return -1;
+  tcp_output(Mqtt.TcpPcb);
+  Mqtt.LastTx = WIFI_TIME_US();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_tcp_connected(). */
+/* ============================================================================================================================================================= *\
+                                                         TCP: connection established, send the CONNECT packet.
+\* ============================================================================================================================================================= */
+static err_t mqtt_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  UCHAR Header[16];
+
+  UINT8 Flags;
+  UINT8 Length;
+
+  UINT32 Remaining;
+
+
+  if (Error != ERR_OK)
+  {
+    mqtt_drop();
+    return ERR_ABRT;
+  }
+
+  Flags     = 0;
+  Remaining = 10 + 2 + strlen(Mqtt.Settings.ClientId);
+  if (Mqtt.Settings.FlagCleanSession == FLAG_ON) Flags |= 0x02;
+  if (Mqtt.Settings.UserName != NULL)
+  {
+    Flags     |= 0x80;
+    Remaining += 2 + strlen(Mqtt.Settings.UserName);
+  }
+  if (Mqtt.Settings.Password != NULL)
+  {
+    Flags     |= 0x40;
+    Remaining += 2 + strlen(Mqtt.Settings.Password);
+  }
+
+  Header[0] = MQTT_CONNECT;
+  Length    = 1 + mqtt_put_length(&Header[1], Remaining);
+  Header[Length++] = 0x00;                                  // protocol name.
+  Header[Length++] = 0x04;
+  Header[Length++] = 'M';
+  Header[Length++] = 'Q';
+  Header[Length++] = 'T';
+  Header[Length++] = 'T';
+  Header[Length++] = 0x04;                                  // protocol level (3.1.1).
+  Header[Length++] = Flags;
+  Header[Length++] = Mqtt.Settings.KeepAliveSec >> 8;
+  Header[Length++] = Mqtt.Settings.KeepAliveSec & 0xFF;
+
+  if ((tcp_write(Pcb, Header, Length, TCP_WRITE_FLAG_COPY) != ERR_OK) ||
+      (mqtt_write_string(Mqtt.Settings.ClientId) != ERR_OK) ||
+      ((Mqtt.Settings.UserName != NULL) && (mqtt_write_string(Mqtt.Settings.UserName) != ERR_OK)) ||
+      ((Mqtt.Settings.Password != NULL) && (mqtt_write_string(Mqtt.Settings.Password) != ERR_OK)))
+  {
+    mqtt_drop();
+    return ERR_ABRT;
+  }
+  tcp_output(Pcb);
+
+  Mqtt.State  = MQTT_STATE_WAIT_CONNACK;
+  Mqtt.LastTx = WIFI_TIME_US();
+  Mqtt.LastRx = Mqtt.LastTx;
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void mqtt_tcp_error(void *Arg, err_t Error)
+{
+  Mqtt.TcpPcb = NULL;
+  mqtt_drop();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                       TCP: data received from the broker. Bytes are accumulated until a packet is complete.
+\* ============================================================================================================================================================= */
+static err_t mqtt_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  UINT16 Chunk;
+  UINT16 Offset;
+
+  INT32 Total;
+
+
+  /* Connection closed by the broker. */
+  if (PBuf == NULL)
+  {
+    mqtt_drop();
+    return ERR_ABRT;
+  }
+
+  Mqtt.LastRx          = WIFI_TIME_US();
+  Mqtt.FlagPingPending = FLAG_OFF;
+  tcp_recved(Pcb, PBuf->tot_len);
+
+  Offset = 0;
+  while (Offset < PBuf->tot_len)
+  {
+    /* Skip the rest of an oversize packet. */
+    if (Mqtt.RxDiscard)
+    {
+      Chunk = PBuf->tot_len - Offset;
+      if (Chunk > Mqtt.RxDiscard) Chunk = Mqtt.RxDiscard;
+      Mqtt.RxDiscard -= Chunk;
+      Offset         += Chunk;
+      continue;
+    }
+
+    Chunk = PBuf->tot_len - Offset;
+    if (Chunk > (MQTT_RX_BUFFER - Mqtt.RxLength)) Chunk = MQTT_RX_BUFFER - Mqtt.RxLength;
+    pbuf_copy_partial(PBuf, &Mqtt.RxBuffer[Mqtt.RxLength], Chunk, Offset);
+    Mqtt.RxLength += Chunk;
+    Offset        += Chunk;
+
+    /* Process all complete packets. */
+    while (Mqtt.RxLength)
+    {
+      Total = mqtt_packet_length();
+      if (Total < 0)
+      {
+        pbuf_free(PBuf);
+        mqtt_drop();
+        return ERR_ABRT;
+      }
+      if (Total == 0) break;
+
+      if (Total > MQTT_RX_BUFFER)
+      {
+        ++Mqtt.Stats.RxOversize;
+        Mqtt.RxDiscard = Total - Mqtt.RxLength;
+        Mqtt.RxLength  = 0;
+        break;
+      }
+      if (Total > Mqtt.RxLength) break;
+
+      if (mqtt_handle_packet(Mqtt.RxBuffer, Total) != 0)
+      {
+        pbuf_free(PBuf);
+        return ERR_ABRT;
+      }
+
+      Mqtt.RxLength -= Total;
+      memmove(Mqtt.RxBuffer, &Mqtt.RxBuffer[Total], Mqtt.RxLength);
+    }
+  }
+  pbuf_free(PBuf);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                                                              TCP: data acknowledged, more may be sent.
+\* ============================================================================================================================================================= */
+static err_t mqtt_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  mqtt_output();
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_timer(). */
+/* ============================================================================================================================================================= *\
+                                                        Keepalive, time-out and reconnection timer (lwIP context).
+\* ============================================================================================================================================================= */
+static void mqtt_timer(void *Arg)
+{
+  UCHAR PingReq[2];
+
+  UINT8 FlagLinkUp;
+
+  UINT64 KeepAlive;
+  UINT64 TimeNow;
+
+
+  if (Mqtt.State == MQTT_STATE_IDLE) return;
+
+  TimeNow    = WIFI_TIME_US();
+  KeepAlive  = Mqtt.Settings.KeepAliveSec * 1000000ull;
+  FlagLinkUp = ((netif_default != NULL) && netif_is_link_up(netif_default) && !ip_addr_isany(&netif_default->ip_addr)) ? FLAG_ON : FLAG_OFF;
+
+  switch (Mqtt.State)
+  {
+    case (MQTT_STATE_WAIT_RETRY):
+      if (FlagLinkUp == FLAG_OFF)
+      {
+        /* Reconnect as soon as the link is back. */
+        Mqtt.RetryTime      = 0;
+        Mqtt.ReconnectDelay = MQTT_RECONNECT_MIN_MSEC;
+      }
+      else if (TimeNow >= Mqtt.RetryTime)
+      {
+        mqtt_connect();
+      }
+    break;
+
+    case (MQTT_STATE_CONNECTING):
+    case (MQTT_STATE_WAIT_CONNACK):
+      if ((FlagLinkUp == FLAG_OFF) || ((TimeNow - Mqtt.ConnectTime) > (MQTT_CONNECT_TIMEOUT_MSEC * 1000ull))) mqtt_drop();
+    break;
+
+    case (MQTT_STATE_CONNECTED):
+      /* Link lost or broker silent for 1.5 keepalive period: no need to wait for TCP to give up. */
+      if ((FlagLinkUp == FLAG_OFF) || ((TimeNow - Mqtt.LastRx) > ((KeepAlive * 3) / 2)))
+      {
+        mqtt_drop();
+        break;
+      }
+
+      /* Keep the session alive, and make sure the broker answers from time to time. */
+      if ((Mqtt.FlagPingPending == FLAG_OFF) && (((TimeNow - Mqtt.LastTx) >= KeepAlive) || ((TimeNow - Mqtt.LastRx) >= KeepAlive)))
+      {
+        PingReq[0] = MQTT_PINGREQ;
+        PingReq[1] = 0;
+        if (mqtt_send_control(PingReq, sizeof(PingReq)) == 0)
+        {
+          Mqtt.FlagPingPending = FLAG_ON;
+          ++Mqtt.Stats.PingSent;
+        }
+      }
+
+      /* Retry what could not be written for lack of TCP memory. */
+      mqtt_output();
+    break;
+  }
+
+  sys_timeout(MQTT_TICK_MSEC, mqtt_timer, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=mqtt_write_string(). */
+/* ============================================================================================================================================================= *\
+                                                              Write a length-prefixed string to TCP.
+\* ============================================================================================================================================================= */
+static err_t mqtt_write_string(const UCHAR *String)
+{
+  UCHAR Length[2];
+
+  err_t ReturnCode;
+
+
+  Length[0] = strlen(String) >> 8;
+  Length[1] = strlen(String) & 0xFF;
+
+  ReturnCode = tcp_write(Mqtt.TcpPcb, Length, 2, TCP_WRITE_FLAG_COPY);
+  if (ReturnCode != ERR_OK) return ReturnCode;
+
+  return tcp_write(Mqtt.TcpPcb, String, strlen(String), TCP_WRITE_FLAG_COPY);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                     Display MQTT client statistics.
+\* ============================================================================================================================================================= */
+void wifi_mqtt_display_stats(void)
+{
+  static const UCHAR *StateName[] = {"idle", "waiting to reconnect", "connecting", "waiting for CONNACK", "connected"};
+
+  struct struct_mqtt_stats Stats;
+
+
+  wifi_mqtt_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                       MQTT client statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "State:                    %s (session present: %s)\r", StateName[Stats.State], Stats.FlagSessionPresent ? "yes" : "no");
+  log_info(__LINE__, __func__, "Connections:              %lu   failures: %lu   losses: %lu\r", Stats.Connects, Stats.ConnectFailures, Stats.ConnectionLosses);
+  log_info(__LINE__, __func__, "Messages queued:          %lu   refused (queue full): %lu\r", Stats.Queued, Stats.QueueFull);
+  log_info(__LINE__, __func__, "Messages published:       %lu   pending: %u\r", Stats.Published, Stats.Pending);
+  log_info(__LINE__, __func__, "QoS1 acknowledged:        %lu   retransmitted: %lu\r", Stats.Acked, Stats.Retransmits);
+  log_info(__LINE__, __func__, "QoS1 in flight:           %u   peak: %u / %u\r", Stats.InFlight, Stats.InFlightMax, MQTT_INFLIGHT_MAX);
+  if (Stats.Acked)
+    log_info(__LINE__, __func__, "Average PUBACK delay:     %llu usec\r", Stats.AckTimeTotalUs / Stats.Acked);
+  if (Stats.Flushes)
+    log_info(__LINE__, __func__, "Messages per flush:       %lu.%lu\r", Stats.Written / Stats.Flushes, ((Stats.Written * 10) / Stats.Flushes) % 10);
+  log_info(__LINE__, __func__, "Messages received:        %lu   oversize: %lu\r", Stats.Received, Stats.RxOversize);
+  log_info(__LINE__, __func__, "PINGREQ sent:             %lu\r", Stats.PingSent);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                    Retrieve MQTT client statistics.
+\* ============================================================================================================================================================= */
+void wifi_mqtt_get_stats(struct struct_mqtt_stats *Stats)
+{
+  WIFI_LWIP_BEGIN();
+  *Stats = Mqtt.Stats;
+  Stats->State   = Mqtt.State;
+  Stats->Pending = (UINT8)(Mqtt.SlotTail - Mqtt.SlotHead);
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_is_connected(). */
+/* ============================================================================================================================================================= *\
+                                                              Tell if the client is connected to the broker.
+\* ============================================================================================================================================================= */
+UINT8 wifi_mqtt_is_connected(void)
+{
+  return (Mqtt.State == MQTT_STATE_CONNECTED) ? FLAG_ON : FLAG_OFF;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_publish(). */
+/* ============================================================================================================================================================= *\
+                                   Queue a message for publication (QoS 0 or 1). The message is copied and the function returns at once.
+                                  Messages may be queued while disconnected; they are sent once connected.
+                                  Return 0 on success, -1 on invalid parameter, -2 if the queue is full.
+\* ============================================================================================================================================================= */
+INT16 wifi_mqtt_publish(const UCHAR *Topic, const void *Payload, UINT16 Length, UINT8 QoS, UINT8 FlagRetain)
+{
+  UCHAR *Packet;
+
+  UINT16 Index;
+  UINT16 TopicLength;
+
+  UINT32 Remaining;
+  UINT32 Total;
+
+  INT32 Offset;
+
+
+  if ((QoS > 1) || (Mqtt.State == MQTT_STATE_IDLE)) return -1;
+
+  TopicLength = strlen(Topic);
+  Remaining   = 2 + TopicLength + ((QoS) ? 2 : 0) + Length;
+  Total       = 1 + ((Remaining < 128) ? 1 : (Remaining < 16384) ? 2 : 3) + Remaining;
+  if (Total > MQTT_BUFFER_SIZE) return -1;
+
+  WIFI_LWIP_BEGIN();
+  Offset = mqtt_alloc(Total);
+  if (Offset < 0)
+  {
+    ++Mqtt.Stats.QueueFull;
+    WIFI_LWIP_END();
+    return -2;
+  }
+
+  Packet    = &Mqtt.Buffer[Offset];
+  Packet[0] = MQTT_PUBLISH | (QoS << 1) | ((FlagRetain == FLAG_ON) ? 0x01 : 0x00);
+  Index     = 1 + mqtt_put_length(&Packet[1], Remaining);
+  Packet[Index++] = TopicLength >> 8;
+  Packet[Index++] = TopicLength & 0xFF;
+  memcpy(&Packet[Index], Topic, TopicLength);
+  Index += TopicLength;
+
+  Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].PacketId = 0;
+  if (QoS)
+  {
+    if (++Mqtt.NextPacketId == 0) Mqtt.NextPacketId = 1;
+    Packet[Index++] = Mqtt.NextPacketId >> 8;
+    Packet[Index++] = Mqtt.NextPacketId & 0xFF;
+    Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].PacketId = Mqtt.NextPacketId;
+  }
+  memcpy(&Packet[Index], Payload, Length);
+
+  Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].Offset = Offset;
+  Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].Length = Total;
+  Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].QoS    = QoS;
+  Mqtt.Slot[Mqtt.SlotTail % MQTT_QUEUE_SIZE].State  = MQTT_SLOT_QUEUED;
+  ++Mqtt.SlotTail;
+  ++Mqtt.Stats.Queued;
+
+  mqtt_output();
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_start(). */
+/* ============================================================================================================================================================= *\
+                                        Start the client: connect, then keep the session alive and reconnect automatically.
+                                                Callback (may be NULL) receives messages of subscribed topics.
+\* ============================================================================================================================================================= */
+INT16 wifi_mqtt_start(struct struct_mqtt_settings *Settings, mqtt_message_callback Callback, void *Context)
+{
+  if ((Mqtt.State != MQTT_STATE_IDLE) || (Settings->ClientId == NULL)) return -1;
+
+  memset(&Mqtt, 0x00, sizeof(Mqtt));
+  Mqtt.Settings = *Settings;
+  if (Mqtt.Settings.Port == 0)         Mqtt.Settings.Port         = MQTT_DEFAULT_PORT;
+  if (Mqtt.Settings.KeepAliveSec == 0) Mqtt.Settings.KeepAliveSec = MQTT_DEFAULT_KEEPALIVE;
+  Mqtt.Callback       = Callback;
+  Mqtt.Context        = Context;
+  Mqtt.ReconnectDelay = MQTT_RECONNECT_MIN_MSEC;
+  Mqtt.RetryTime      = 0;
+
+  WIFI_LWIP_BEGIN();
+  Mqtt.State = MQTT_STATE_WAIT_RETRY;
+  mqtt_timer(NULL);
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_stop(). */
+/* ============================================================================================================================================================= *\
+                                                  Stop the client (clean DISCONNECT) and discard queued messages.
+\* ============================================================================================================================================================= */
+void wifi_mqtt_stop(void)
+{
+  UCHAR Disconnect[2];
+
+
+  WIFI_LWIP_BEGIN();
+  sys_untimeout(mqtt_timer, NULL);
+
+  if (Mqtt.TcpPcb != NULL)
+  {
+    if (Mqtt.State == MQTT_STATE_CONNECTED)
+    {
+      Disconnect[0] = MQTT_DISCONNECT;
+      Disconnect[1] = 0;
+      mqtt_send_control(Disconnect, sizeof(Disconnect));
+    }
+
+    tcp_arg(Mqtt.TcpPcb,  NULL);
+    tcp_err(Mqtt.TcpPcb,  NULL);
+    tcp_recv(Mqtt.TcpPcb, NULL);
+    tcp_sent(Mqtt.TcpPcb, NULL);
+    if (tcp_close(Mqtt.TcpPcb) != ERR_OK) tcp_abort(Mqtt.TcpPcb);
+    Mqtt.TcpPcb = NULL;
+  }
+
+  Mqtt.State    = MQTT_STATE_IDLE;
+  Mqtt.SlotHead = Mqtt.SlotTail;
+  Mqtt.SlotSend = Mqtt.SlotTail;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_mqtt_subscribe(). */
+/* ============================================================================================================================================================= *\
+                                      Subscribe to a topic filter (QoS 0 or 1). The string is referenced and must remain valid.
+                                     The subscription is sent now if connected, and again after any reconnect without session.
+\* ============================================================================================================================================================= */
+INT16 wifi_mqtt_subscribe(const UCHAR *TopicFilter, UINT8 QoS)
+{
+  UINT8 Index;
+
+
+  if ((QoS > 1) || (Mqtt.State == MQTT_STATE_IDLE)) return -1;
+
+  WIFI_LWIP_BEGIN();
+  for (Index = 0; Index < Mqtt.SubscriptionCount; ++Index)
+    if (strcmp(Mqtt.Subscription[Index], TopicFilter) == 0) break;
+
+  if (Index == Mqtt.SubscriptionCount)
+  {
+    if (Mqtt.SubscriptionCount >= MQTT_MAX_SUBSCRIPTIONS)
+    {
+      WIFI_LWIP_END();
+      return -1;
+    }
+    ++Mqtt.SubscriptionCount;
+  }
+  Mqtt.Subscription[Index]    = TopicFilter;
+  Mqtt.SubscriptionQoS[Index] = QoS;
+
+  if (Mqtt.State == MQTT_STATE_CONNECTED) mqtt_send_subscribe(Index);
+  WIFI_LWIP_END();
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-MQTT.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-MQTT.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_MQTT_H
+#define _WIFI_MQTT_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define MQTT_DEFAULT_PORT              1883     // MQTT over plain TCP.
+#define MQTT_DEFAULT_KEEPALIVE           60     // keepalive interval (seconds) when none is given.
+#define MQTT_BUFFER_SIZE               2048     // bytes reserved for encoded PUBLISH packets waiting to be sent or acknowledged.
+#define MQTT_QUEUE_SIZE                  32     // maximum number of messages waiting to be sent or acknowledged (must be a power of 2).
+#define MQTT_INFLIGHT_MAX                 8     // maximum number of QoS1 messages sent and not yet acknowledged.
+#define MQTT_RX_BUFFER                  512     // largest packet received from the broker (larger ones are skipped).
+#define MQTT_MAX_SUBSCRIPTIONS            4     // topic filters re-subscribed automatically after a reconnect.
+#define MQTT_TICK_MSEC                  250     // period of the keepalive / reconnect timer.
+#define MQTT_CONNECT_TIMEOUT_MSEC     10000     // TCP connection + CONNACK must complete within this delay.
+#define MQTT_RECONNECT_MIN_MSEC         500     // first reconnect delay after a connection loss (doubled after each failure).
+#define MQTT_RECONNECT_MAX_MSEC       30000     // upper bound of the reconnect delay.
+
+/* Client states. */
+#define MQTT_STATE_IDLE                   0     // client not started.
+#define MQTT_STATE_WAIT_RETRY             1     // waiting before next connection attempt.
+#define MQTT_STATE_CONNECTING             2     // TCP connection in progress.
+#define MQTT_STATE_WAIT_CONNACK           3     // CONNECT sent, waiting for the broker's answer.
+#define MQTT_STATE_CONNECTED              4
+
+
+/* Client settings. Strings are referenced, not copied: they must remain valid while the client runs. */
+struct struct_mqtt_settings
+{
+  ip_addr_t BrokerAddress;
+  UINT16 Port;                                 // 0 = MQTT_DEFAULT_PORT.
+  const UCHAR *ClientId;
+  const UCHAR *UserName;                       // NULL = no user name.
+  const UCHAR *Password;                       // NULL = no password.
+  UINT16 KeepAliveSec;                         // 0 = MQTT_DEFAULT_KEEPALIVE.
+  UINT8  FlagCleanSession;                     // FLAG_OFF = persistent session: broker keeps subscriptions and QoS1 state across reconnects.
+};
+
+
+/* Client statistics. */
+struct struct_mqtt_stats
+{
+  UINT8  State;
+  UINT8  FlagSessionPresent;                   // broker had a session for this client at last connection.
+  UINT32 Connects;                             // successful connections (CONNACK accepted).
+  UINT32 ConnectFailures;                      // TCP failures, CONNACK refusals and timeouts.
+  UINT32 ConnectionLosses;                     // established connections that were lost.
+  UINT32 Queued;                               // messages accepted by wifi_mqtt_publish().
+  UINT32 QueueFull;                            // messages refused because the queue or buffer was full.
+  UINT32 Published;                            // QoS0 messages sent and QoS1 messages acknowledged.
+  UINT32 Retransmits;                          // QoS1 messages sent again (DUP) after a reconnect.
+  UINT16 Pending;                              // messages currently queued or in flight.
+  UINT16 InFlight;                             // QoS1 messages currently waiting for PUBACK.
+  UINT16 InFlightMax;
+  UINT32 Flushes;                              // calls to tcp_output() after queuing messages.
+  UINT32 Written;                              // messages handed to TCP (Written / Flushes = messages per batch).
+  UINT32 Acked;                                // QoS1 messages acknowledged by the broker.
+  UINT64 AckTimeTotalUs;                       // sum of QoS1 send-to-PUBACK delays.
+  UINT32 Received;                             // PUBLISH packets received on subscriptions.
+  UINT32 RxOversize;                           // packets skipped because larger than MQTT_RX_BUFFER.
+  UINT32 PingSent;
+};
+
+
+/* Callback for messages received on subscribed topics. Called from lwIP context, must not block.
+   Topic and payload are not zero-terminated and are only valid during the call. */
+typedef void (*mqtt_message_callback)(const UCHAR *Topic, UINT16 TopicLength, const UCHAR *Payload, UINT16 PayloadLength, void *Context);
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Display MQTT client statistics. */
+void wifi_mqtt_display_stats(void);
+
+/* Retrieve MQTT client statistics. */
+void wifi_mqtt_get_stats(struct struct_mqtt_stats *Stats);
+
+/* Tell if the client is connected to the broker. */
+UINT8 wifi_mqtt_is_connected(void);
+
+/* Queue a message for publication (QoS 0 or 1). */
+INT16 wifi_mqtt_publish(const UCHAR *Topic, const void *Payload, UINT16 Length, UINT8 QoS, UINT8 FlagRetain);
+
+/* Start the client: connect, then keep the session alive and reconnect automatically. */
+INT16 wifi_mqtt_start(struct struct_mqtt_settings *Settings, mqtt_message_callback Callback, void *Context);
+
+/* Stop the client and discard queued messages. */
+void wifi_mqtt_stop(void);
+
+/* Subscribe to a topic filter (QoS 0 or 1). */
+INT16 wifi_mqtt_subscribe(const UCHAR *TopicFilter, UINT8 QoS);
+
+#endif  // _WIFI_MQTT_H
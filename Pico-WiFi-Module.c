@@ -2,9 +2,9 @@
    Pico-WiFi-Module.c
    St-Louys Andre - September 2024
    astlouys@gmail.com
-   Revision 14-MAY-2025
+   Revision 18-OCT-2026
    Langage: C
-   Version 1.01
+   Version 1.02
 
    Raspberry Pi Pico C-language add-on module to access a Wi-Fi network from a user program / project.
 
@@ -17,6 +17,17 @@
    02-SEP-2024 1.00 - Initial release.
    14-MAY-2025 1.01 - Rework some sections of code.
                     - Cleanup, cosmetic and optimisation changes.
+   18-OCT-2026 1.02 - Add an event-driven Wi-Fi health monitor based on lwIP netif extended status callbacks.
+                    - Report lwIP profile and lwIP RAM footprint.
+                    - Add always-on lwIP memory pool, heap and link statistics.
+                    - Add radio power-management profiles and a round-trip latency probe.
+                    - Support poll and FreeRTOS cyw43 architectures: wifi_poll() / wifi_sleep_ms() replace blocking sleeps.
+                    - Add non-blocking wifi_connect_start() running as a task of the cooperative scheduler; wifi_sleep_ms() runs other tasks.
+                    - MAC address is printed in a single log_info() line.
+                    - Add reentrant table-driven formatters for MAC, IPv4, RSSI and channel (wifi_format_xxx()).
+                    - Add boot timeline: cyw43 firmware load, join, DHCP and first application packet are time stamped (wifi_boot_xxx()).
+                    - Add tiered recovery of the Wi-Fi link (rejoin, netif restart with DHCP, cyw43 re-init as a last resort), timed and counted per tier.
+                    - Host name may be changed at run time (wifi_set_host_name()), e.g. from the configuration store.
 \* ============================================================================================================================================================= */
 
 
@@ -27,7 +38,12 @@
 #include "baseline.h"
 #include "stdio.h"
 
+#include "lwip/dhcp.h"
+#include "lwip/ip.h"
+#include "lwip/memp.h"
+
 #include "Pico-WiFi-Module.h"
+#include "Pico-WiFi-Ping.h"
 
 
 
@@ -41,6 +57,102 @@
 /* ============================================================================================================================================================= *\
                                                                               Global variables.
 \* ============================================================================================================================================================= */
+/* Wi-Fi health monitor state. Only accessed from lwIP context (or with lwIP lock held). */
+static struct
+{
+  UINT8  FlagActive;
+  UINT8  LedPhase;                                     // current step of the LED heartbeat sequence.
+  UINT8  FlagEscalated;                                // tiered recovery already started for the current link drop.
+  UINT32 ReconnectDelay;                               // current reconnection back-off, in msec.
+  ip4_addr_t LastIPAddress;                            // last IP address seen on the station interface.
+  struct struct_wifi *StructWiFi;
+  netif_ext_callback_t NetifCallback;                  // lwIP list entry of wifi_health_netif_callback().
+  async_at_time_worker_t FallbackWorker;
+  async_at_time_worker_t LedWorker;
+  async_at_time_worker_t ReconnectWorker;
+  struct
+  {
+    wifi_health_callback Callback;
+    void *Context;
+  } Subscriber[MAX_HEALTH_SUBSCRIBERS];
+} HealthMonitor;
+
+/* Link counters, maintained by wrapping the input / linkoutput functions of the cyw43 station netif. */
+static struct
+{
+  UINT32 RxPackets;
+  UINT32 TxPackets;
+  UINT64 RxBytes;
+  UINT64 TxBytes;
+  UINT32 RxDrops;
+  UINT32 TxErrors;
+  netif_input_fn      Input;                           // original netif functions.
+  netif_linkoutput_fn LinkOutput;
+} LinkStats;
+
+/* Non-blocking connection started by wifi_connect_start(). */
+static struct
+{
+  UINT16 Checks;                                       // link status checks done.
+  INT16  ReturnCode;                                   // last cyw43 link status.
+  struct struct_wifi *StructWiFi;
+  struct struct_sched_task *Notify;                    // task receiving SCHED_EVENT_DONE.
+  struct struct_sched_task *Task;                      // NULL: no connection in progress.
+} Connect;
+
+/* Tiered recovery started by wifi_recover_start(). */
+static struct
+{
+  UINT8  Tier;                                         // tier in progress.
+  UINT64 TierStart;                                    // time stamp of the beginning of the tier in progress.
+  struct struct_wifi *StructWiFi;
+  struct struct_sched_task *Notify;                    // task receiving SCHED_EVENT_DONE.
+  struct struct_sched_task *Task;                      // NULL: no recovery in progress.
+  struct struct_wifi_recover_stats Stats;
+} Recover;
+
+static const UINT32 RecoverTimeout[WIFI_RECOVER_TIERS] = {WIFI_RECOVER_REJOIN_MSEC, WIFI_RECOVER_NETIF_MSEC, WIFI_RECOVER_REINIT_MSEC};
+
+/* Boot timeline. Milestones of the network are recorded by the module, the others by the application. */
+static struct
+{
+  UINT64 Time[WIFI_BOOT_MILESTONES];                   // usec since reset, 0: not reached yet.
+  UINT8  FlagHooked;                                   // NetifCallback is in lwIP's list.
+  netif_ext_callback_t NetifCallback;                  // lwIP list entry of wifi_boot_netif_callback() (removed once the address is known).
+} BootTimeline;
+
+static const UCHAR *const BootName[WIFI_BOOT_MILESTONES] =
+{
+  "Clocks and runtime (main)",
+  "stdio initialized",
+  "cyw43 init started",
+  "cyw43 firmware loaded",
+  "Join request sent",
+  "Joined (link up)",
+  "DHCP (IP address)",
+  "First application packet",
+  "Terminal connected"
+};
+
+/* Host name selected by wifi_set_host_name(), used at next connection. */
+static UCHAR HostNameBase[WIFI_HOST_NAME_SIZE] = CYW43_HOST_NAME;
+
+/* Radio power profile selected by wifi_set_power_profile(), applied again after each connection (cyw43 re-initialization resets it). */
+static UINT8 PowerProfile = WIFI_POWER_DRIVER;
+static const UINT32 PowerValue[WIFI_POWER_PROFILES] = {WIFI_PM_PERFORMANCE, WIFI_PM_BALANCED, WIFI_PM_AGGRESSIVE};
+
+/* Tables of the formatters (wifi_format_xxx()). */
+static const UCHAR HexDigit[16] = "0123456789ABCDEF";
+static const UCHAR DecimalPair[201] =
+  "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+  "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/* Name of each lwIP memory pool, in memp_t order. */
+static const UCHAR *const PoolName[MEMP_MAX] =
+{
+#define LWIP_MEMPOOL(Name, Number, Size, Description) Description,
+#include "lwip/priv/memp_std.h"
+};
 
 
 
@@ -50,6 +162,60 @@
 /* Log data to log file. */
 extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
 
+/* Follow join and DHCP through an lwIP netif extended callback. */
+static void wifi_boot_hook(void);
+
+/* lwIP netif extended callback of the boot timeline. */
+static void wifi_boot_netif_callback(struct netif *NetIf, netif_nsc_reason_t Reason, const netif_ext_callback_args_t *Args);
+
+/* Remove the netif extended callback of the boot timeline. */
+static void wifi_boot_unhook(void *Arg);
+
+/* Keep track of MAC address, host name and IP address once connected. */
+static void wifi_connect_complete(struct struct_wifi *StructWiFi);
+
+/* Task of the non-blocking connection. */
+static void wifi_connect_task(struct struct_sched_task *Task, UINT32 Events);
+
+/* Compare current IP address with the last one seen and publish the corresponding event. */
+static void wifi_health_check_address(struct netif *NetIf);
+
+/* Slow fallback poll of cyw43 link status, in case an event has been missed. */
+static void wifi_health_fallback_worker(async_context_t *Context, async_at_time_worker_t *Worker);
+
+/* Non-blocking LED heartbeat reflecting Wi-Fi health. */
+static void wifi_health_led_worker(async_context_t *Context, async_at_time_worker_t *Worker);
+
+/* Association with the Access Point gained or lost. */
+static void wifi_health_link_callback(struct netif *NetIf);
+
+/* lwIP netif extended status callback. */
+static void wifi_health_netif_callback(struct netif *NetIf, netif_nsc_reason_t Reason, const netif_ext_callback_args_t *Args);
+
+/* Publish an event to all subscribers. */
+static void wifi_health_publish(UINT8 Event);
+
+/* Reconnection logic launched after a link drop. */
+static void wifi_health_reconnect_worker(async_context_t *Context, async_at_time_worker_t *Worker);
+
+/* Escalate to tiered recovery when rejoin keeps failing (deferred call of the cooperative scheduler). */
+static void wifi_health_recover(void *Arg);
+
+/* Task of the tiered recovery. */
+static void wifi_recover_task(struct struct_sched_task *Task, UINT32 Events);
+
+/* Start one tier of the recovery. */
+static INT16 wifi_recover_tier(UINT8 Tier);
+
+/* Wrap cyw43 station netif functions to count link traffic. */
+static void wifi_stats_hook(void);
+
+/* Counting wrapper of netif->input. */
+static err_t wifi_stats_input(struct pbuf *PBuf, struct netif *NetIf);
+
+/* Counting wrapper of netif->linkoutput. */
+static err_t wifi_stats_linkoutput(struct netif *NetIf, struct pbuf *PBuf);
+
 
 
 
@@ -74,6 +240,26 @@ static void wait_ms(UINT16 WaitMSec)
 
 
 
+/* $PAGE */
+/* $TITLE=wifi_arch_name(). */
+/* ============================================================================================================================================================= *\
+                                           Return the name of the cyw43 architecture the firmware has been built with.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_arch_name(void)
+{
+#if PICO_CYW43_ARCH_POLL
+  return "poll";
+#elif PICO_CYW43_ARCH_FREERTOS
+  return "FreeRTOS";
+#else
+  return "threadsafe background";
+#endif
+}
+
+
+
+
+
 /* $PAGE */
 /* $TITLE=wifi_blink() */
 /* ============================================================================================================================================================= *\
@@ -108,6 +294,184 @@ void wifi_blink(UINT16 OnTimeMsec, UINT16 OffTimeMsec, UINT8 Repeat)
 
 
 
+/* $PAGE */
+/* $TITLE=wifi_boot_display(). */
+/* ============================================================================================================================================================= *\
+                          Display the boot timeline: time of each milestone since reset and delay since the previous milestone reached.
+\* ============================================================================================================================================================= */
+void wifi_boot_display(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT64 Previous;
+
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                            Boot timeline\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Milestone                     Since reset (msec)   Since previous (msec)\r");
+
+  Previous = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < WIFI_BOOT_MILESTONES; ++Loop1UInt8)
+  {
+    if (BootTimeline.Time[Loop1UInt8] == 0)
+    {
+      log_info(__LINE__, __func__, "%-28s           -\r", BootName[Loop1UInt8]);
+      continue;
+    }
+
+    /* The terminal may connect at any time: it is not part of the network sequence. */
+    if ((Loop1UInt8 == WIFI_BOOT_CONSOLE) || (BootTimeline.Time[Loop1UInt8] < Previous))
+    {
+      log_info(__LINE__, __func__, "%-28s %8llu.%03llu\r", BootName[Loop1UInt8], BootTimeline.Time[Loop1UInt8] / 1000, BootTimeline.Time[Loop1UInt8] % 1000);
+      continue;
+    }
+
+    log_info(__LINE__, __func__, "%-28s %8llu.%03llu          %8llu.%03llu\r", BootName[Loop1UInt8], BootTimeline.Time[Loop1UInt8] / 1000, BootTimeline.Time[Loop1UInt8] % 1000,
+             (BootTimeline.Time[Loop1UInt8] - Previous) / 1000, (BootTimeline.Time[Loop1UInt8] - Previous) % 1000);
+    Previous = BootTimeline.Time[Loop1UInt8];
+  }
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_hook(). */
+/* ============================================================================================================================================================= *\
+                Follow join and DHCP of the first connection through an lwIP netif extended callback (time stamps are exact, instead of depending
+             on the period of link status checks). Must be called with lwIP lock held. The callback is removed once the IP address has been assigned.
+\* ============================================================================================================================================================= */
+static void wifi_boot_hook(void)
+{
+  if (BootTimeline.Time[WIFI_BOOT_DHCP] != 0)
+  {
+    /* Address already known: remove the callback if its deferred removal could not be queued. */
+    if (BootTimeline.FlagHooked == FLAG_ON)
+    {
+      netif_remove_ext_callback(&BootTimeline.NetifCallback);
+      BootTimeline.FlagHooked = FLAG_OFF;
+    }
+    return;
+  }
+
+  if (BootTimeline.FlagHooked == FLAG_OFF)
+  {
+    netif_add_ext_callback(&BootTimeline.NetifCallback, wifi_boot_netif_callback);
+    BootTimeline.FlagHooked = FLAG_ON;
+  }
+
+  /* First packet of the timeline is detected by the linkoutput wrapper of link statistics: installed here, not left to the application. */
+  wifi_stats_hook();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_mark(). */
+/* ============================================================================================================================================================= *\
+                 Record the time of a boot milestone. Only the first occurrence is kept, so that later reconnections do not change the timeline.
+                                                                 May be called from any context.
+\* ============================================================================================================================================================= */
+void wifi_boot_mark(UINT8 Milestone)
+{
+  if ((Milestone < WIFI_BOOT_MILESTONES) && (BootTimeline.Time[Milestone] == 0)) BootTimeline.Time[Milestone] = time_us_64();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_name(). */
+/* ============================================================================================================================================================= *\
+                                                               Return the name of a boot milestone.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_boot_name(UINT8 Milestone)
+{
+  if (Milestone >= WIFI_BOOT_MILESTONES) return "?";
+
+  return BootName[Milestone];
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_netif_callback(). */
+/* ============================================================================================================================================================= *\
+                     lwIP netif extended callback of the boot timeline: association with the Access Point, then IP address assigned by DHCP.
+                  Once the address is known, the callback is removed out of lwIP context (it must not unlink itself while lwIP walks the list).
+\* ============================================================================================================================================================= */
+static void wifi_boot_netif_callback(struct netif *NetIf, netif_nsc_reason_t Reason, const netif_ext_callback_args_t *Args)
+{
+  if ((NetIf != &cyw43_state.netif[CYW43_ITF_STA]) || (BootTimeline.Time[WIFI_BOOT_DHCP] != 0)) return;
+
+  if ((Reason & LWIP_NSC_LINK_CHANGED) && netif_is_link_up(NetIf)) wifi_boot_mark(WIFI_BOOT_JOINED);
+
+  if ((Reason & (LWIP_NSC_STATUS_CHANGED | LWIP_NSC_IPV4_ADDRESS_CHANGED | LWIP_NSC_IPV4_SETTINGS_CHANGED)) && netif_is_up(NetIf) && !ip4_addr_isany_val(*netif_ip4_addr(NetIf)))
+  {
+    wifi_boot_mark(WIFI_BOOT_DHCP);
+    wifi_stats_hook();  // netif may have been re-created since the join started: linkoutput wrapper must be in place for the first packet.
+    wifi_sched_call(wifi_boot_unhook, NULL);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_time(). */
+/* ============================================================================================================================================================= *\
+                                     Return the time of a boot milestone, in usec since reset (0: milestone not reached yet).
+\* ============================================================================================================================================================= */
+UINT64 wifi_boot_time(UINT8 Milestone)
+{
+  if (Milestone >= WIFI_BOOT_MILESTONES) return 0;
+
+  return BootTimeline.Time[Milestone];
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_boot_unhook(). */
+/* ============================================================================================================================================================= *\
+                    Remove the netif extended callback of the boot timeline (deferred call of the cooperative scheduler, out of lwIP context).
+\* ============================================================================================================================================================= */
+static void wifi_boot_unhook(void *Arg)
+{
+  cyw43_arch_lwip_begin();
+  if (BootTimeline.FlagHooked == FLAG_ON)
+  {
+    netif_remove_ext_callback(&BootTimeline.NetifCallback);
+    BootTimeline.FlagHooked = FLAG_OFF;
+  }
+  cyw43_arch_lwip_end();
+
+  return;
+}
+
+
+
+
+
 /* $PAGE */
 /* $TITLE=wifi_connect() */
 /* ============================================================================================================================================================= *\
@@ -121,7 +485,6 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
   UINT8 FlagLocalDebug = FLAG_ON;   // may be turned On for debug purposes.
 #endif  // RELEASE_VERSION
 
-  UINT8 Loop1UInt8;
   UINT8 RetryCount;
 
   INT16 ReturnCode;
@@ -144,7 +507,11 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
 
   /* Enable Wi-Fi Station mode. */
   cyw43_arch_enable_sta_mode();              // initialize Wi-Fi as a client (not as Access Point).
-  if (stdio_usb_connected()) sleep_ms(400);  // to keep log display clean on screen.
+  cyw43_arch_lwip_begin();
+  wifi_boot_hook();
+  cyw43_arch_lwip_end();
+  wifi_boot_mark(WIFI_BOOT_JOIN_START);
+  if (stdio_usb_connected()) wifi_sleep_ms(400);  // to keep log display clean on screen.
 
 
   /* The time-out next line may be increased or reduced, depending on your Wi-Fi infrastructure response speed. */
@@ -207,7 +574,7 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
       }
 
       /* No connection yet, wait and check again. */
-      sleep_ms(600);
+      wifi_sleep_ms(600);
     } while ((ReturnCode = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA)) != CYW43_LINK_UP);
 
 
@@ -225,26 +592,55 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
     }
   }
 
+  wifi_connect_complete(StructWiFi);
+
+  /* Fast blink Pico's LED 5 times to indicate wi-fi successful connection. */
+  wifi_blink(100, 100, 5);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_connect_complete(). */
+/* ============================================================================================================================================================= *\
+                                  Wi-Fi connection successful: keep track of device MAC address, host name and Pico IP address.
+\* ============================================================================================================================================================= */
+static void wifi_connect_complete(struct struct_wifi *StructWiFi)
+{
+#ifdef RELEASE_VERSION
+  UINT8 FlagLocalDebug = FLAG_OFF;  // must remain OFF all time.
+#else   // RELEASE_VERSION
+  UINT8 FlagLocalDebug = FLAG_ON;   // may be turned On for debug purposes.
+#endif  // RELEASE_VERSION
+
+  UCHAR String[WIFI_MAC_STRING_SIZE];
+
+  UINT8 Loop1UInt8;
+
+
+  /* Check if there is a monitor connected to stdout. */
+  if (!stdio_usb_connected()) FlagLocalDebug = FLAG_OFF;
+
 
   /* --------------------------------------------------------------------------------------------------------------------------- *\
-                                    Wi-Fi connection successful. Keep track of device MAC address.
+                                                   Keep track of device MAC address.
   \* --------------------------------------------------------------------------------------------------------------------------- */
   StructWiFi->FlagHealth = FLAG_ON;
   cyw43_wifi_get_mac(&cyw43_state, CYW43_ITF_STA, StructWiFi->MacAddress);
+
+  cyw43_arch_lwip_begin();
+  wifi_stats_hook();
+  if (PowerProfile != WIFI_POWER_DRIVER) cyw43_wifi_pm(&cyw43_state, PowerValue[PowerProfile]);
+  cyw43_arch_lwip_end();
   // cyw43_hal_get_mac(CYW43_HAL_MAC_WLAN0, StructWiFi->MacAddress);
 
   if (FlagLocalDebug)
   {
-    log_info(__LINE__, __func__, "Wi-Fi connection succeeded (Number of retries: %u).\r", RetryCount + 1);
-    log_info(__LINE__, __func__, "Device MAC address: ");
-    for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->MacAddress); ++Loop1UInt8)
-    {
-      printf("%2.2X", StructWiFi->MacAddress[Loop1UInt8]);
-      if (Loop1UInt8 < (sizeof(StructWiFi->MacAddress) - 1))
-        printf(":");
-      else 
-        printf("\r");
-    }
+    log_info(__LINE__, __func__, "Device MAC address: %s\r", wifi_format_mac(String, StructWiFi->MacAddress, ':'));
   }
 
 
@@ -261,8 +657,8 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
 
 
   /* Then copy "plain" host name to both variables. */
-  memcpy(&StructWiFi->HostName[0],      CYW43_HOST_NAME, sizeof(CYW43_HOST_NAME) - 1);
-  memcpy(&StructWiFi->ExtraHostName[0], CYW43_HOST_NAME, sizeof(CYW43_HOST_NAME) - 1);
+  memcpy(&StructWiFi->HostName[0],      HostNameBase, strlen(HostNameBase));
+  memcpy(&StructWiFi->ExtraHostName[0], HostNameBase, strlen(HostNameBase));
   
   
   /***
@@ -309,10 +705,30 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
                                                      Keep track of Pico IP address.
   \* --------------------------------------------------------------------------------------------------------------------------- */
   StructWiFi->PicoIPAddress = *netif_ip4_addr(netif_list);
-  log_info(__LINE__, __func__, "Pico IP Address:    <%s>\r", ip4addr_ntoa(&StructWiFi->PicoIPAddress));
+  log_info(__LINE__, __func__, "Pico IP Address:    <%s>\r", wifi_format_ip(String, &StructWiFi->PicoIPAddress));
 
-  /* Fast blink Pico's LED 5 times to indicate wi-fi successful connection. */
-  wifi_blink(100, 100, 5);
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_connect_start(). */
+/* ============================================================================================================================================================= *\
+                  Start a Wi-Fi connection without blocking: the connection runs as a task of the cooperative scheduler (see Pico-WiFi-Sched.c).
+                     When it completes, SCHED_EVENT_DONE is posted to Notify (may be NULL), and StructWiFi->FlagHealth tells if it succeeded.
+                       Return -1 if a connection or a recovery is already in progress or if the scheduler has not been initialized.
+\* ============================================================================================================================================================= */
+INT16 wifi_connect_start(struct struct_wifi *StructWiFi, struct struct_sched_task *Notify)
+{
+  if ((Connect.Task != NULL) || (Recover.Task != NULL)) return -1;
+
+  Connect.StructWiFi = StructWiFi;
+  Connect.Notify     = Notify;
+  Connect.Task       = wifi_sched_create("connect", wifi_connect_task, NULL);
+  if (Connect.Task == NULL) return -1;
 
   return 0;
 }
@@ -321,6 +737,99 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
 
 
 
+/* $PAGE */
+/* $TITLE=wifi_connect_task(). */
+/* ============================================================================================================================================================= *\
+                     Task of the non-blocking connection. The join request is sent, then link status is checked every WIFI_CONNECT_CHECK_MSEC
+                      until the link is up with an IP address. A join failure (bad credentials, network not found) sends a new join request.
+                 Gives up after WIFI_CONNECT_TIMEOUT_MSEC. Unlike wifi_connect(), the LED is not blinked (blinking would block the other tasks).
+\* ============================================================================================================================================================= */
+static void wifi_connect_task(struct struct_sched_task *Task, UINT32 Events)
+{
+  switch (Task->State)
+  {
+    case (0):
+      /* Send join request. */
+      Connect.StructWiFi->FlagHealth = FLAG_OFF;  // assume failure on entry.
+      Connect.Checks = 0;
+      cyw43_arch_enable_sta_mode();
+      cyw43_arch_lwip_begin();
+      wifi_boot_hook();
+      cyw43_arch_lwip_end();
+      wifi_boot_mark(WIFI_BOOT_JOIN_START);
+      cyw43_arch_wifi_connect_async(Connect.StructWiFi->NetworkName, Connect.StructWiFi->NetworkPassword, CYW43_AUTH_WPA2_MIXED_PSK);
+      Task->State = 1;
+      wifi_sched_wait(Task, SCHED_EVENT_TIMER, WIFI_CONNECT_CHECK_MSEC);
+    return;
+
+    default:
+      /* Check link status. */
+      Connect.ReturnCode = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+      if (Connect.ReturnCode == CYW43_LINK_UP)
+      {
+        log_info(__LINE__, __func__, "Wi-Fi connection succeeded after %lu msec.\r", (UINT32)(Connect.Checks + 1) * WIFI_CONNECT_CHECK_MSEC);
+        wifi_connect_complete(Connect.StructWiFi);
+        break;
+      }
+
+      if (++Connect.Checks >= (WIFI_CONNECT_TIMEOUT_MSEC / WIFI_CONNECT_CHECK_MSEC))
+      {
+        if (stdio_usb_connected()) log_info(__LINE__, __func__, "Failed to establish a Wi-Fi connection (link status: %d).\r", Connect.ReturnCode);
+        ++Connect.StructWiFi->TotalErrors;
+        break;
+      }
+
+      /* Join failed: send a new join request. */
+      if (Connect.ReturnCode < 0)
+      {
+        if (stdio_usb_connected()) log_info(__LINE__, __func__, "Wi-Fi join failure (link status: %d), retrying...\r", Connect.ReturnCode);
+        cyw43_arch_wifi_connect_async(Connect.StructWiFi->NetworkName, Connect.StructWiFi->NetworkPassword, CYW43_AUTH_WPA2_MIXED_PSK);
+      }
+      wifi_sched_wait(Task, SCHED_EVENT_TIMER, WIFI_CONNECT_CHECK_MSEC);
+    return;
+  }
+
+  /* Connection completed or failed. */
+  wifi_sched_post(Connect.Notify, SCHED_EVENT_DONE);
+  Connect.Task = NULL;
+  wifi_sched_delete(Task);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_cpu_loops(). */
+/* ============================================================================================================================================================= *\
+                        Count the iterations of an idle loop during DurationMsec, servicing the Wi-Fi stack with wifi_poll() at each turn.
+                Time spent by the stack (interrupts, cyw43 / lwIP tasks or polling) is not available to the loop, so comparing the count with and
+                 without network traffic gives the share of CPU used by networking with the cyw43 architecture the firmware has been built with.
+\* ============================================================================================================================================================= */
+UINT32 wifi_cpu_loops(UINT32 DurationMsec)
+{
+  UINT32 Loops;
+
+  UINT64 TimeOut;
+
+
+  Loops   = 0;
+  TimeOut = time_us_64() + (DurationMsec * 1000ull);
+  while (time_us_64() < TimeOut)
+  {
+    wifi_poll();
+    ++Loops;
+  }
+
+  return Loops;
+}
+
+
+
+
+
 /* $PAGE */
 /* $TITLE=wifi_display_info(). */
 /* ============================================================================================================================================================= *\
@@ -328,12 +837,12 @@ INT16 wifi_connect(struct struct_wifi *StructWiFi)
 \* ============================================================================================================================================================= */
 void wifi_display_info(struct struct_wifi *StructWiFi)
 {
+  UCHAR Bssid[WIFI_MAC_STRING_SIZE];
   UCHAR String[35];
 
   INT ReturnCode;
 
   UINT8 BSSID[6];
-  UINT8 Loop1UInt8;
 
   INT32 RssiValue;
 
@@ -386,35 +895,28 @@ void wifi_display_info(struct struct_wifi *StructWiFi)
       printf("- Undefined error number\r");
     break;
   }
-  sleep_ms(50);
+  wifi_sleep_ms(50);
 
   ReturnCode = cyw43_wifi_get_rssi(&cyw43_state, &RssiValue);
   log_info(__LINE__, __func__, "cyw43_wifi_get_rssi()  returned rssi value: %3ld\r", RssiValue);
-  sleep_ms(50);
+  wifi_sleep_ms(50);
 
   ReturnCode = cyw43_wifi_get_bssid(&cyw43_state, BSSID);
-  log_info(__LINE__, __func__, "cyw43_wifi_get_bssid() returned bssid:       %2.2X-%2.2X-%2.2X-%2.2X-%2.2X-%2.2X\r", BSSID[0], BSSID[1], BSSID[2], BSSID[3], BSSID[4], BSSID[5]);
-  sleep_ms(50);
+  log_info(__LINE__, __func__, "cyw43_wifi_get_bssid() returned bssid:       %s\r", wifi_format_mac(Bssid, BSSID, '-'));
+  wifi_sleep_ms(50);
 
   log_info(__LINE__, __func__, "Wi-Fi health:        %s\r",   String);
   log_info(__LINE__, __func__, "Wi-Fi total errors:  %lu\r",  StructWiFi->TotalErrors);
   log_info(__LINE__, __func__, "Network name (SSID): <%s>\r", StructWiFi->NetworkName);
   log_info(__LINE__, __func__, "Network password:    <%s>\r", StructWiFi->NetworkPassword);
-  log_info(__LINE__, __func__, "Pico IP address:     <%s>\r",  ip4addr_ntoa(&StructWiFi->PicoIPAddress));
-  log_info(__LINE__, __func__, "Device MAC address:  <");
-
-  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->MacAddress); ++Loop1UInt8)
-  {
-    printf("%2.2X", StructWiFi->MacAddress[Loop1UInt8]);
-    if (Loop1UInt8 < (sizeof(StructWiFi->MacAddress) - 1))
-      printf(":");
-    else
-      printf(">\r");
-  }
+  log_info(__LINE__, __func__, "Pico IP address:     <%s>\r",  wifi_format_ip(String, &StructWiFi->PicoIPAddress));
+  log_info(__LINE__, __func__, "Device MAC address:  <%s>\r",  wifi_format_mac(String, StructWiFi->MacAddress, ':'));
 
   log_info(__LINE__, __func__, "Host name:           %s\r",           StructWiFi->HostName);
   log_info(__LINE__, __func__, "Extra host name:     %s\r",           StructWiFi->ExtraHostName);
   log_info(__LINE__, __func__, "Country code:        %c%c Rev: %u\r", StructWiFi->CountryCode, (StructWiFi->CountryCode >> 8), (StructWiFi->CountryCode >> 16));
+  log_info(__LINE__, __func__, "lwIP profile:        %s (%lu bytes of RAM)\r", wifi_lwip_profile(), wifi_lwip_ram());
+  log_info(__LINE__, __func__, "cyw43 architecture:  %s\r", wifi_arch_name());
   log_info(__LINE__, __func__, "======================================================================\r", __LINE__);
 
   return;
@@ -423,50 +925,1461 @@ void wifi_display_info(struct struct_wifi *StructWiFi)
 
 
 
-
 /* $PAGE */
-/* $TITLE=wifi_init() */
+/* $TITLE=wifi_event_name(). */
 /* ============================================================================================================================================================= *\
-                                                        Initialize PicoW's integrated cyw43 (WiFi electronic module).
+                                                               Return a string describing a Wi-Fi health event.
 \* ============================================================================================================================================================= */
-INT16 wifi_init(struct struct_wifi *StructWiFi)
+const UCHAR *wifi_event_name(UINT8 Event)
 {
-#ifdef RELEASE_VERSION
-  UINT8 FlagLocalDebug = FLAG_OFF;  // must remain OFF all time.
-#else   // RELEASE_VERSION
-  UINT8 FlagLocalDebug = FLAG_OFF;   // may be turned On for debug purposes.
-#endif  // RELEASE_VERSION
+  switch (Event)
+  {
+    case (WIFI_EVENT_LINK_DOWN):
+      return "Link down";
 
-  UINT8 Loop1UInt8;
+    case (WIFI_EVENT_LINK_UP):
+      return "Link up";
 
-  INT16 ReturnCode;
+    case (WIFI_EVENT_IP_ACQUIRED):
+      return "IP address acquired";
 
+    case (WIFI_EVENT_IP_CHANGED):
+      return "IP address changed";
 
-  /* Check if there is a terminal connected to stdout. */
+    case (WIFI_EVENT_IP_LOST):
+      return "IP address lost";
+
+    case (WIFI_EVENT_RECONNECTING):
+      return "Reconnecting";
+
+    case (WIFI_EVENT_REINIT_START):
+      return "cyw43 re-initialization";
+
+    case (WIFI_EVENT_REINIT_DONE):
+      return "cyw43 re-initialized";
+
+    default:
+      return "Undefined event";
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_format_channel(). */
+/* ============================================================================================================================================================= *\
+                         Format a channel number into caller's buffer (at least WIFI_CHANNEL_STRING_SIZE bytes), as printf("%3u") would.
+                                                                          Return Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *wifi_format_channel(UCHAR *Buffer, UINT8 Channel)
+{
+  return wifi_format_int(Buffer, Channel, 3);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_format_int(). */
+/* ============================================================================================================================================================= *\
+                        Format an integer into caller's buffer, right-aligned on Width characters (0: no padding), as printf("%*d") would.
+                     Digits are converted two at a time with a table: no division by 10 per digit, no printf(), no static buffer (reentrant).
+                        Buffer must hold the larger of Width and 11 characters, plus end-of-string (WIFI_INT_STRING_SIZE). Return Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *wifi_format_int(UCHAR *Buffer, INT32 Value, UINT8 Width)
+{
+  UCHAR Digits[11];
+  UCHAR *Pos;
+
+  UINT8 Count;
+  UINT8 Length;
+  UINT8 Pair;
+
+  UINT32 Magnitude;
+
+
+  Magnitude = (Value < 0) ? (UINT32)(-(INT64)Value) : (UINT32)Value;
+
+  /* Digits from the right, two at a time. */
+  Count = sizeof(Digits);
+  while (Magnitude >= 100)
+  {
+    Pair = Magnitude % 100;
+    Magnitude /= 100;
+    Digits[--Count] = DecimalPair[(Pair * 2) + 1];
+    Digits[--Count] = DecimalPair[Pair * 2];
+  }
+  if (Magnitude >= 10)
+  {
+    Digits[--Count] = DecimalPair[(Magnitude * 2) + 1];
+    Digits[--Count] = DecimalPair[Magnitude * 2];
+  }
+  else
+  {
+    Digits[--Count] = '0' + Magnitude;
+  }
+  if (Value < 0) Digits[--Count] = '-';
+
+  /* Right-align on Width characters. */
+  Length = sizeof(Digits) - Count;
+  Pos    = Buffer;
+  if (Width > Length)
+  {
+    memset(Pos, ' ', Width - Length);
+    Pos += Width - Length;
+  }
+  memcpy(Pos, &Digits[Count], Length);
+  Pos[Length] = 0x00;  // end-of-string
+
+  return Buffer;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_format_ip(). */
+/* ============================================================================================================================================================= *\
+                                        Format an IPv4 address into caller's buffer (at least WIFI_IP_STRING_SIZE bytes).
+                 Unlike ip4addr_ntoa(), which returns a shared static buffer, it may be used several times in the same statement. Return Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *wifi_format_ip(UCHAR *Buffer, const ip4_addr_t *Address)
+{
+  UCHAR *Pos;
+
+  UINT8 Loop1UInt8;
+  UINT8 Octet;
+
+  UINT32 Value;
+
+
+  Value = lwip_ntohl(ip4_addr_get_u32(Address));
+  Pos   = Buffer;
+  for (Loop1UInt8 = 0; Loop1UInt8 < 4; ++Loop1UInt8)
+  {
+    Octet = (UINT8)(Value >> (24 - (Loop1UInt8 * 8)));
+    if (Octet >= 100)
+    {
+      *Pos++ = '0' + (Octet / 100);
+      Octet %= 100;
+      *Pos++ = DecimalPair[Octet * 2];
+      *Pos++ = DecimalPair[(Octet * 2) + 1];
+    }
+    else if (Octet >= 10)
+    {
+      *Pos++ = DecimalPair[Octet * 2];
+      *Pos++ = DecimalPair[(Octet * 2) + 1];
+    }
+    else
+    {
+      *Pos++ = '0' + Octet;
+    }
+    *Pos++ = (Loop1UInt8 < 3) ? '.' : 0x00;
+  }
+
+  return Buffer;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_format_mac(). */
+/* ============================================================================================================================================================= *\
+                         Format a MAC address into caller's buffer (at least WIFI_MAC_STRING_SIZE bytes), with two upper-case hex digits
+                                         per byte and the specified separator between bytes (':' or '-'). Return Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *wifi_format_mac(UCHAR *Buffer, const UINT8 *MacAddress, UCHAR Separator)
+{
+  UCHAR *Pos;
+
+  UINT8 Loop1UInt8;
+
+
+  Pos = Buffer;
+  for (Loop1UInt8 = 0; Loop1UInt8 < 6; ++Loop1UInt8)
+  {
+    *Pos++ = HexDigit[MacAddress[Loop1UInt8] >> 4];
+    *Pos++ = HexDigit[MacAddress[Loop1UInt8] & 0x0F];
+    *Pos++ = (Loop1UInt8 < 5) ? Separator : 0x00;
+  }
+
+  return Buffer;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_format_rssi(). */
+/* ============================================================================================================================================================= *\
+                   Format a signal strength (RSSI, in dBm) into caller's buffer (at least WIFI_RSSI_STRING_SIZE bytes), as printf("%4d") would.
+                                            Values are limited to -999 .. 9999 so that they always fit. Return Buffer.
+\* ============================================================================================================================================================= */
+UCHAR *wifi_format_rssi(UCHAR *Buffer, INT16 Rssi)
+{
+  if (Rssi < -999) Rssi = -999;
+  if (Rssi > 9999) Rssi = 9999;
+
+  return wifi_format_int(Buffer, Rssi, 4);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_check_address(). */
+/* ============================================================================================================================================================= *\
+                                             Compare current IP address with the last one seen and publish the corresponding event.
+\* ============================================================================================================================================================= */
+static void wifi_health_check_address(struct netif *NetIf)
+{
+  ip4_addr_t IPAddress;
+
+
+  IPAddress = *netif_ip4_addr(NetIf);
+  if (!netif_is_up(NetIf) || !netif_is_link_up(NetIf)) ip4_addr_set_u32(&IPAddress, 0);
+
+  /* Nothing changed. */
+  if (ip4_addr_cmp(&IPAddress, &HealthMonitor.LastIPAddress)) return;
+
+  if (ip4_addr_isany_val(IPAddress))
+  {
+    HealthMonitor.LastIPAddress = IPAddress;
+    HealthMonitor.StructWiFi->FlagHealth = FLAG_OFF;
+    wifi_health_publish(WIFI_EVENT_IP_LOST);
+  }
+  else
+  {
+    HealthMonitor.StructWiFi->PicoIPAddress = IPAddress;
+    HealthMonitor.StructWiFi->FlagHealth    = FLAG_ON;
+
+    /* Link is fully operational, cancel reconnection logic. */
+    async_context_remove_at_time_worker(cyw43_arch_async_context(), &HealthMonitor.ReconnectWorker);
+    HealthMonitor.ReconnectDelay = WIFI_RECONNECT_MIN_MSEC;
+    HealthMonitor.FlagEscalated  = FLAG_OFF;
+
+    if (ip4_addr_isany_val(HealthMonitor.LastIPAddress))
+    {
+      HealthMonitor.LastIPAddress = IPAddress;
+      wifi_health_publish(WIFI_EVENT_IP_ACQUIRED);
+    }
+    else
+    {
+      HealthMonitor.LastIPAddress = IPAddress;
+      wifi_health_publish(WIFI_EVENT_IP_CHANGED);
+    }
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_fallback_worker(). */
+/* ============================================================================================================================================================= *\
+                                         Slow fallback poll of cyw43 link status, in case an event has been missed.
+     NOTE: cyw43 re-creates its netif when station mode is brought up, which restores its input / linkoutput functions. Counting wrappers are
+                        re-applied here if needed (extended status callbacks are kept by lwIP outside of the netif and survive it).
+\* ============================================================================================================================================================= */
+static void wifi_health_fallback_worker(async_context_t *Context, async_at_time_worker_t *Worker)
+{
+  INT ReturnCode;
+
+  struct netif *NetIf;
+
+
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  NetIf = &cyw43_state.netif[CYW43_ITF_STA];
+
+  wifi_stats_hook();
+
+  /* Synthesize the event that may have been missed. */
+  ReturnCode = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+  if ((ReturnCode == CYW43_LINK_UP) && (HealthMonitor.StructWiFi->FlagHealth == FLAG_OFF))
+  {
+    wifi_health_check_address(NetIf);
+  }
+  else if ((ReturnCode != CYW43_LINK_UP) && (ReturnCode != CYW43_LINK_JOIN) && (ReturnCode != CYW43_LINK_NOIP) && (HealthMonitor.StructWiFi->FlagHealth == FLAG_ON))
+  {
+    wifi_health_link_callback(NetIf);
+  }
+
+  async_context_add_at_time_worker_in_ms(Context, Worker, WIFI_HEALTH_POLL_MSEC);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_led_worker(). */
+/* ============================================================================================================================================================= *\
+                                                         Non-blocking LED heartbeat reflecting Wi-Fi health.
+                            Blink Pico's LED once every WIFI_HEALTH_LED_MSEC when Wi-Fi is healthy and three times when it is not.
+\* ============================================================================================================================================================= */
+static void wifi_health_led_worker(async_context_t *Context, async_at_time_worker_t *Worker)
+{
+  UINT8 BlinkCount;
+
+
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  BlinkCount = (HealthMonitor.StructWiFi->FlagHealth == FLAG_ON) ? 1 : 3;
+
+  if (HealthMonitor.LedPhase < (BlinkCount * 2))
+  {
+    /* Even phases turn the LED On for 50 msec, odd phases turn it Off for 200 msec. */
+    cyw43_gpio_set(&cyw43_state, LED_GPIO, ((HealthMonitor.LedPhase % 2) == 0));
+    async_context_add_at_time_worker_in_ms(Context, Worker, ((HealthMonitor.LedPhase % 2) == 0) ? 50 : 200);
+    ++HealthMonitor.LedPhase;
+  }
+  else
+  {
+    /* Sequence completed, wait for next heartbeat. */
+    cyw43_gpio_set(&cyw43_state, LED_GPIO, false);
+    HealthMonitor.LedPhase = 0;
+    async_context_add_at_time_worker_in_ms(Context, Worker, WIFI_HEALTH_LED_MSEC - (BlinkCount * 250));
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_link_callback(). */
+/* ============================================================================================================================================================= *\
+                 Association with the Access Point gained or lost: reported by cyw43 through wifi_health_netif_callback(), or synthesized by the fallback poll.
+\* ============================================================================================================================================================= */
+static void wifi_health_link_callback(struct netif *NetIf)
+{
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  if (netif_is_link_up(NetIf))
+  {
+    wifi_health_publish(WIFI_EVENT_LINK_UP);
+
+    /* The IP address may have been kept by lwIP while the link was down, in which case no status callback will follow. */
+    wifi_health_check_address(NetIf);
+  }
+  else
+  {
+    ip4_addr_set_u32(&HealthMonitor.LastIPAddress, 0);
+    HealthMonitor.StructWiFi->FlagHealth = FLAG_OFF;
+    ++HealthMonitor.StructWiFi->LinkDownCount;
+    ++HealthMonitor.StructWiFi->TotalErrors;
+    wifi_health_publish(WIFI_EVENT_LINK_DOWN);
+
+    /* Hand off to reconnection logic. */
+    HealthMonitor.ReconnectDelay = WIFI_RECONNECT_MIN_MSEC;
+    async_context_remove_at_time_worker(cyw43_arch_async_context(), &HealthMonitor.ReconnectWorker);
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &HealthMonitor.ReconnectWorker, HealthMonitor.ReconnectDelay);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_netif_callback(). */
+/* ============================================================================================================================================================= *\
+                lwIP netif extended status callback, called for every netif as soon as its link, its state (up / down) or its IP address changes.
+      Registered in the list of lwIP (netif_add_ext_callback()): other users of the netif events are not displaced, and nothing is left behind when stopped.
+\* ============================================================================================================================================================= */
+static void wifi_health_netif_callback(struct netif *NetIf, netif_nsc_reason_t Reason, const netif_ext_callback_args_t *Args)
+{
+  if ((HealthMonitor.FlagActive == FLAG_OFF) || (NetIf != &cyw43_state.netif[CYW43_ITF_STA])) return;
+
+  if (Reason & LWIP_NSC_LINK_CHANGED) wifi_health_link_callback(NetIf);
+
+  /* The IP address is compared with the last one seen, so an event already handled by the link change is not published twice. */
+  if (Reason & (LWIP_NSC_STATUS_CHANGED | LWIP_NSC_IPV4_ADDRESS_CHANGED | LWIP_NSC_IPV4_SETTINGS_CHANGED)) wifi_health_check_address(NetIf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_publish(). */
+/* ============================================================================================================================================================= *\
+                                                                  Publish an event to all subscribers.
+\* ============================================================================================================================================================= */
+static void wifi_health_publish(UINT8 Event)
+{
+  UINT8 Loop1UInt8;
+
+
+  HealthMonitor.StructWiFi->LastEventTime = time_us_64();
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < MAX_HEALTH_SUBSCRIBERS; ++Loop1UInt8)
+  {
+    if (HealthMonitor.Subscriber[Loop1UInt8].Callback)
+      HealthMonitor.Subscriber[Loop1UInt8].Callback(Event, HealthMonitor.StructWiFi, HealthMonitor.Subscriber[Loop1UInt8].Context);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_reconnect_worker(). */
+/* ============================================================================================================================================================= *\
+                                   Reconnection logic launched after a link drop. Rejoin asynchronously with an exponential back-off.
+                    Once the back-off has reached its maximum, escalate (once per link drop) to the next tiers of the recovery (see wifi_recover_start()).
+\* ============================================================================================================================================================= */
+static void wifi_health_reconnect_worker(async_context_t *Context, async_at_time_worker_t *Worker)
+{
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  /* Nothing to do if link came back in the meantime. */
+  if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP) return;
+
+  /* Tiered recovery in progress: it sends its own join requests. */
+  if (Recover.Task != NULL)
+  {
+    async_context_add_at_time_worker_in_ms(Context, Worker, HealthMonitor.ReconnectDelay);
+    return;
+  }
+
+#if (WIFI_CORE1 == 0)
+  /* Rejoin keeps failing. Recovery must run out of lwIP context (with WIFI_CORE1, the scheduler does not run on the core of the Wi-Fi stack). */
+  if ((HealthMonitor.ReconnectDelay >= WIFI_RECONNECT_MAX_MSEC) && (HealthMonitor.FlagEscalated == FLAG_OFF))
+  {
+    /* Try again on next pass if the call could not be queued (scheduler not started yet or queue full). */
+    if (wifi_sched_call(wifi_health_recover, NULL) == 0) HealthMonitor.FlagEscalated = FLAG_ON;
+    async_context_add_at_time_worker_in_ms(Context, Worker, HealthMonitor.ReconnectDelay);
+    return;
+  }
+#endif  // WIFI_CORE1
+
+  ++HealthMonitor.StructWiFi->ReconnectCount;
+  wifi_health_publish(WIFI_EVENT_RECONNECTING);
+  cyw43_arch_wifi_connect_async(HealthMonitor.StructWiFi->NetworkName, HealthMonitor.StructWiFi->NetworkPassword, CYW43_AUTH_WPA2_MIXED_PSK);
+
+  /* Check again later, in case this attempt fails. */
+  HealthMonitor.ReconnectDelay *= 2;
+  if (HealthMonitor.ReconnectDelay > WIFI_RECONNECT_MAX_MSEC) HealthMonitor.ReconnectDelay = WIFI_RECONNECT_MAX_MSEC;
+  async_context_add_at_time_worker_in_ms(Context, Worker, HealthMonitor.ReconnectDelay);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_recover(). */
+/* ============================================================================================================================================================= *\
+                     Escalate to tiered recovery when rejoin keeps failing (deferred call of the cooperative scheduler, out of lwIP context).
+                                   Rejoin has already been tried by the reconnection logic: recovery starts with the next tier.
+\* ============================================================================================================================================================= */
+static void wifi_health_recover(void *Arg)
+{
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP) return;
+
+  wifi_recover_start(HealthMonitor.StructWiFi, WIFI_RECOVER_NETIF, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_start(). */
+/* ============================================================================================================================================================= *\
+                                                             Start the event-driven Wi-Fi health monitor.
+       Link and IP address changes are reported by lwIP netif extended status callbacks within milliseconds; cyw43 link status is only polled as a slow fallback.
+\* ============================================================================================================================================================= */
+INT16 wifi_health_start(struct struct_wifi *StructWiFi)
+{
+  struct netif *NetIf;
+
+
+  if (HealthMonitor.FlagActive == FLAG_ON) return 0;
+
+  NetIf = &cyw43_state.netif[CYW43_ITF_STA];
+
+  cyw43_arch_lwip_begin();
+  HealthMonitor.StructWiFi     = StructWiFi;
+  HealthMonitor.LastIPAddress  = *netif_ip4_addr(NetIf);
+  HealthMonitor.LedPhase       = 0;
+  HealthMonitor.ReconnectDelay = WIFI_RECONNECT_MIN_MSEC;
+  HealthMonitor.FallbackWorker.do_work  = wifi_health_fallback_worker;
+  HealthMonitor.LedWorker.do_work       = wifi_health_led_worker;
+  HealthMonitor.ReconnectWorker.do_work = wifi_health_reconnect_worker;
+  HealthMonitor.FlagActive     = FLAG_ON;
+
+  StructWiFi->FlagHealth = (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP) ? FLAG_ON : FLAG_OFF;
+  if (StructWiFi->FlagHealth == FLAG_OFF) ip4_addr_set_u32(&HealthMonitor.LastIPAddress, 0);
+
+  /* Events of the station interface are received through the list of extended status callbacks of lwIP. */
+  netif_add_ext_callback(&HealthMonitor.NetifCallback, wifi_health_netif_callback);
+  cyw43_arch_lwip_end();
+
+  async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &HealthMonitor.FallbackWorker, WIFI_HEALTH_POLL_MSEC);
+  async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &HealthMonitor.LedWorker, 0);
+
+  /* If link is already down when we start, hand off to reconnection logic right away. */
+  if (StructWiFi->FlagHealth == FLAG_OFF)
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &HealthMonitor.ReconnectWorker, HealthMonitor.ReconnectDelay);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_stop(). */
+/* ============================================================================================================================================================= *\
+                                                                   Stop the Wi-Fi health monitor.
+\* ============================================================================================================================================================= */
+void wifi_health_stop(void)
+{
+  if (HealthMonitor.FlagActive == FLAG_OFF) return;
+
+  async_context_remove_at_time_worker(cyw43_arch_async_context(), &HealthMonitor.FallbackWorker);
+  async_context_remove_at_time_worker(cyw43_arch_async_context(), &HealthMonitor.LedWorker);
+  async_context_remove_at_time_worker(cyw43_arch_async_context(), &HealthMonitor.ReconnectWorker);
+
+  cyw43_arch_lwip_begin();
+  HealthMonitor.FlagActive = FLAG_OFF;
+  netif_remove_ext_callback(&HealthMonitor.NetifCallback);
+  cyw43_gpio_set(&cyw43_state, LED_GPIO, false);
+  cyw43_arch_lwip_end();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_subscribe(). */
+/* ============================================================================================================================================================= *\
+                                                        Subscribe an application callback to Wi-Fi health events.
+\* ============================================================================================================================================================= */
+INT16 wifi_health_subscribe(wifi_health_callback Callback, void *Context)
+{
+  UINT8 Loop1UInt8;
+
+
+  cyw43_arch_lwip_begin();
+
+  /* Callback already subscribed with the same context. */
+  for (Loop1UInt8 = 0; Loop1UInt8 < MAX_HEALTH_SUBSCRIBERS; ++Loop1UInt8)
+  {
+    if ((HealthMonitor.Subscriber[Loop1UInt8].Callback == Callback) && (HealthMonitor.Subscriber[Loop1UInt8].Context == Context))
+    {
+      cyw43_arch_lwip_end();
+
+      return 0;
+    }
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < MAX_HEALTH_SUBSCRIBERS; ++Loop1UInt8)
+  {
+    if (HealthMonitor.Subscriber[Loop1UInt8].Callback == NULL)
+    {
+      HealthMonitor.Subscriber[Loop1UInt8].Callback = Callback;
+      HealthMonitor.Subscriber[Loop1UInt8].Context  = Context;
+      cyw43_arch_lwip_end();
+
+      return 0;
+    }
+  }
+  cyw43_arch_lwip_end();
+
+  /* No more room for a new subscriber. */
+  return -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_health_unsubscribe(). */
+/* ============================================================================================================================================================= *\
+                                                       Unsubscribe an application callback from Wi-Fi health events.
+\* ============================================================================================================================================================= */
+void wifi_health_unsubscribe(wifi_health_callback Callback, void *Context)
+{
+  UINT8 Loop1UInt8;
+
+
+  cyw43_arch_lwip_begin();
+  for (Loop1UInt8 = 0; Loop1UInt8 < MAX_HEALTH_SUBSCRIBERS; ++Loop1UInt8)
+  {
+    if ((HealthMonitor.Subscriber[Loop1UInt8].Callback == Callback) && (HealthMonitor.Subscriber[Loop1UInt8].Context == Context))
+    {
+      HealthMonitor.Subscriber[Loop1UInt8].Callback = NULL;
+      HealthMonitor.Subscriber[Loop1UInt8].Context  = NULL;
+    }
+  }
+  cyw43_arch_lwip_end();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_init() */
+/* ============================================================================================================================================================= *\
+                                                        Initialize PicoW's integrated cyw43 (WiFi electronic module).
+\* ============================================================================================================================================================= */
+INT16 wifi_init(struct struct_wifi *StructWiFi)
+{
+#ifdef RELEASE_VERSION
+  UINT8 FlagLocalDebug = FLAG_OFF;  // must remain OFF all time.
+#else   // RELEASE_VERSION
+  UINT8 FlagLocalDebug = FLAG_OFF;   // may be turned On for debug purposes.
+#endif  // RELEASE_VERSION
+
+  UINT8 Loop1UInt8;
+
+  INT16 ReturnCode;
+
+
+  /* Check if there is a terminal connected to stdout. */
   if (!stdio_usb_connected()) FlagLocalDebug = FLAG_OFF;
 
-  if (FlagLocalDebug) log_info(__LINE__, __func__, "Entering wifi_init().\r");
+  if (FlagLocalDebug) log_info(__LINE__, __func__, "Entering wifi_init().\r");
+
+  wifi_boot_mark(WIFI_BOOT_CYW43_START);
+  if ((ReturnCode = cyw43_arch_init_with_country(StructWiFi->CountryCode)) != 0)
+  {
+    if (stdio_usb_connected()) log_info(__LINE__, __func__, "Error %d while trying to initialize cyw43 on the PicoW.\r", ReturnCode);
+  }
+  else
+  {
+    wifi_boot_mark(WIFI_BOOT_CYW43_READY);
+    if (FlagLocalDebug) log_info(__LINE__, __func__, "cyw43 initialization was successful.\r");
+  }
+
+  
+  /* Initialize both host name and extra host name as null string. */
+  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->HostName); ++Loop1UInt8)
+    StructWiFi->HostName[Loop1UInt8] = 0x00;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->ExtraHostName); ++Loop1UInt8)
+    StructWiFi->ExtraHostName[Loop1UInt8] = 0x00;
+
+  StructWiFi->TotalErrors = 0l;
+
+  if (FlagLocalDebug) log_info(__LINE__, __func__, "Exiting wifi_init().\r");
+
+  return ReturnCode;
+}
+
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_lwip_profile(). */
+/* ============================================================================================================================================================= *\
+                                                   Return the name of the lwIP profile the firmware has been built with.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_lwip_profile(void)
+{
+#if (LWIP_PROFILE == LWIP_PROFILE_LOW_MEMORY)
+  return "low-memory";
+#elif (LWIP_PROFILE == LWIP_PROFILE_HIGH_THROUGHPUT)
+  return "high-throughput";
+#elif (LWIP_PROFILE == LWIP_PROFILE_LOW_LATENCY)
+  return "low-latency";
+#else
+  return "balanced";
+#endif
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_lwip_ram(). */
+/* ============================================================================================================================================================= *\
+                                                       Return the RAM statically reserved by lwIP (heap and memory pools).
+                                                 Sizes are read from lwIP's own pool descriptors, so this is the real footprint.
+\* ============================================================================================================================================================= */
+UINT32 wifi_lwip_ram(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 Total;
+
+
+#if MEM_LIBC_MALLOC
+  Total = 0;  // heap comes from C library malloc().
+#else   // MEM_LIBC_MALLOC
+  Total = MEM_SIZE;
+#endif  // MEM_LIBC_MALLOC
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < MEMP_MAX; ++Loop1UInt8)
+    Total += (UINT32)memp_pools[Loop1UInt8]->num * memp_pools[Loop1UInt8]->size;
+
+  return Total;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_poll(). */
+/* ============================================================================================================================================================= *\
+                                                     Service the Wi-Fi stack from the application main loop.
+             With the poll architecture, cyw43 and lwIP only run when this function is called, so it must be called often (at least every few msec).
+                         With threadsafe background (interrupt driven) and FreeRTOS (cyw43 / lwIP tasks) architectures, this is a no-op.
+\* ============================================================================================================================================================= */
+void wifi_poll(void)
+{
+#if PICO_CYW43_ARCH_POLL
+  cyw43_arch_poll();
+#endif  // PICO_CYW43_ARCH_POLL
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_power_probe(). */
+/* ============================================================================================================================================================= *\
+                        Measure round-trip latency with each radio power profile, by pinging Target (typically the gateway) Count times per profile.
+                  Echo requests are sent WIFI_POWER_PROBE_MSEC apart, so each one finds the radio asleep, as sporadic application traffic would.
+               Result must have room for WIFI_POWER_PROFILES entries. The profile in use on entry is restored. Return -1 if the ping engine is busy.
+                                                    NOTE: Blocks for about Count x WIFI_POWER_PROBE_MSEC per profile.
+\* ============================================================================================================================================================= */
+INT16 wifi_power_probe(const ip_addr_t *Target, UINT16 Count, struct struct_wifi_power_probe *Result)
+{
+  UINT8 Loop1UInt8;
+  UINT8 SavedProfile;
+
+  UINT64 TimeOut;
+
+  struct struct_ping_stats PingStats;
+
+
+  if (ping_is_running()) return -1;
+  if (Count == 0) Count = WIFI_POWER_PROBE_COUNT;
+
+  SavedProfile = PowerProfile;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < WIFI_POWER_PROFILES; ++Loop1UInt8)
+  {
+    wifi_set_power_profile(Loop1UInt8);
+    wifi_sleep_ms(1000);  // let the radio settle in its new mode.
+
+    ping_clear_targets();
+    ping_target_add(Target, WIFI_POWER_PROBE_MSEC, Count);
+    ping_start();
+
+    TimeOut = time_us_64() + (((UINT64)Count * WIFI_POWER_PROBE_MSEC) + 5000) * 1000ull;
+    while (ping_is_running() && (time_us_64() < TimeOut)) wifi_sleep_ms(50);
+    ping_stop();
+
+    memset(&Result[Loop1UInt8], 0x00, sizeof(Result[Loop1UInt8]));
+    Result[Loop1UInt8].Profile = Loop1UInt8;
+    if (ping_get_stats(0, &PingStats) == 0)
+    {
+      Result[Loop1UInt8].Sent       = PingStats.Sent;
+      Result[Loop1UInt8].Received   = PingStats.Received;
+      Result[Loop1UInt8].RttAverage = PingStats.RttAverage;
+      Result[Loop1UInt8].RttP50     = PingStats.RttP50;
+      Result[Loop1UInt8].RttP90     = PingStats.RttP90;
+      Result[Loop1UInt8].RttMax     = PingStats.RttMax;
+    }
+  }
+  ping_clear_targets();
+
+  /* Restore profile in use on entry. */
+  if (SavedProfile == WIFI_POWER_DRIVER)
+  {
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_pm(&cyw43_state, CYW43_DEFAULT_PM);
+    cyw43_arch_lwip_end();
+    PowerProfile = WIFI_POWER_DRIVER;
+  }
+  else
+  {
+    wifi_set_power_profile(SavedProfile);
+  }
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "       Round-trip latency to <%s> per power profile\r", ipaddr_ntoa(Target));
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Profile        Received   Average       P50       P90       Max (msec)\r");
+  for (Loop1UInt8 = 0; Loop1UInt8 < WIFI_POWER_PROFILES; ++Loop1UInt8)
+  {
+    log_info(__LINE__, __func__, "%-12s    %3lu/%-3lu %6lu.%1lu %7lu.%1lu %7lu.%1lu %7lu.%1lu\r", wifi_power_profile_name(Loop1UInt8), Result[Loop1UInt8].Received, Result[Loop1UInt8].Sent,
+             Result[Loop1UInt8].RttAverage / 1000, (Result[Loop1UInt8].RttAverage / 100) % 10, Result[Loop1UInt8].RttP50 / 1000, (Result[Loop1UInt8].RttP50 / 100) % 10,
+             Result[Loop1UInt8].RttP90 / 1000, (Result[Loop1UInt8].RttP90 / 100) % 10, Result[Loop1UInt8].RttMax / 1000, (Result[Loop1UInt8].RttMax / 100) % 10);
+  }
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_power_profile_name(). */
+/* ============================================================================================================================================================= *\
+                                                                 Return the name of a radio power profile.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_power_profile_name(UINT8 Profile)
+{
+  switch (Profile)
+  {
+    case (WIFI_POWER_PERFORMANCE):
+      return "performance";
+
+    case (WIFI_POWER_BALANCED):
+      return "balanced";
+
+    case (WIFI_POWER_AGGRESSIVE):
+      return "aggressive";
+
+    default:
+      return "driver default";
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_display(). */
+/* ============================================================================================================================================================= *\
+                Display Wi-Fi link recovery statistics: how often each tier has been needed, how often it restored the link and how long it took.
+\* ============================================================================================================================================================= */
+void wifi_recover_display(void)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_wifi_recover_tier *Tier;
+
+
+  log_info(__LINE__, __func__, "======================================================================================\r");
+  log_info(__LINE__, __func__, "                              Wi-Fi link recovery\r");
+  log_info(__LINE__, __func__, "======================================================================================\r");
+  log_info(__LINE__, __func__, "Recoveries: %lu   Failures (all tiers tried): %lu   Last one restored by: %s\r",
+           Recover.Stats.Runs, Recover.Stats.Failures, (Recover.Stats.Runs == 0) ? (UCHAR *)"-" : (UCHAR *)wifi_recover_tier_name(Recover.Stats.LastTier));
+  log_info(__LINE__, __func__, "Tier                            Attempts  Successes   Last msec  Average msec    Max msec\r");
+  for (Loop1UInt8 = 0; Loop1UInt8 < WIFI_RECOVER_TIERS; ++Loop1UInt8)
+  {
+    Tier = &Recover.Stats.Tier[Loop1UInt8];
+    log_info(__LINE__, __func__, "%u) %-27s %9lu  %9lu  %10lu  %12lu  %10lu\r", Loop1UInt8 + 1, wifi_recover_tier_name(Loop1UInt8), Tier->Attempts, Tier->Successes,
+             Tier->LastMsec, (Tier->Attempts == 0) ? 0 : (Tier->TotalMsec / Tier->Attempts), Tier->MaxMsec);
+  }
+  log_info(__LINE__, __func__, "======================================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                             Retrieve Wi-Fi link recovery statistics.
+\* ============================================================================================================================================================= */
+void wifi_recover_get_stats(struct struct_wifi_recover_stats *Stats)
+{
+  *Stats = Recover.Stats;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_start(). */
+/* ============================================================================================================================================================= *\
+          Start a tiered recovery of the Wi-Fi link without blocking: the recovery runs as a task of the cooperative scheduler (see Pico-WiFi-Sched.c).
+              Tiers are tried from FirstTier on, cheapest first: rejoin, netif restart with DHCP, and cyw43 re-initialization only as a last resort.
+              When it completes, SCHED_EVENT_DONE is posted to Notify (may be NULL), and StructWiFi->FlagHealth tells if the link has been restored.
+                           Return -1 if a connection or a recovery is already in progress or if the scheduler has not been initialized.
+\* ============================================================================================================================================================= */
+INT16 wifi_recover_start(struct struct_wifi *StructWiFi, UINT8 FirstTier, struct struct_sched_task *Notify)
+{
+  if ((FirstTier >= WIFI_RECOVER_TIERS) || (Recover.Task != NULL) || (Connect.Task != NULL)) return -1;
+
+  /* Subscribers are told about cyw43 re-initialization, even if the health monitor is not running. */
+  cyw43_arch_lwip_begin();
+  if (HealthMonitor.FlagActive == FLAG_OFF) HealthMonitor.StructWiFi = StructWiFi;
+  cyw43_arch_lwip_end();
 
-  if ((ReturnCode = cyw43_arch_init_with_country(StructWiFi->CountryCode)) != 0)
+  Recover.StructWiFi = StructWiFi;
+  Recover.Notify     = Notify;
+  Recover.Tier       = FirstTier;
+  Recover.Task       = wifi_sched_create("recover", wifi_recover_task, NULL);
+  if (Recover.Task == NULL) return -1;
+
+  ++Recover.Stats.Runs;
+  StructWiFi->FlagHealth = FLAG_OFF;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_task(). */
+/* ============================================================================================================================================================= *\
+              Task of the tiered recovery. Each tier is given RecoverTimeout[] to bring the link up with an IP address; link status is checked every
+         WIFI_CONNECT_CHECK_MSEC. When a tier fails, the next one is started at once. Duration of each tier is accounted for, whether it succeeds or not.
+\* ============================================================================================================================================================= */
+static void wifi_recover_task(struct struct_sched_task *Task, UINT32 Events)
+{
+  UINT8 FlagFailed;
+  UINT8 FlagUp;
+
+  UINT32 DurationMsec;
+
+  struct struct_wifi_recover_tier *Tier;
+
+
+  FlagFailed = FLAG_OFF;
+  if (Task->State == 0)
   {
-    if (stdio_usb_connected()) log_info(__LINE__, __func__, "Error %d while trying to initialize cyw43 on the PicoW.\r", ReturnCode);
+    /* Start first tier. */
+    Task->State = 1;
+    if (wifi_recover_tier(Recover.Tier) != 0) FlagFailed = FLAG_ON;
+  }
+
+  while (1)
+  {
+    FlagUp       = ((FlagFailed == FLAG_OFF) && (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP)) ? FLAG_ON : FLAG_OFF;
+    DurationMsec = (UINT32)((time_us_64() - Recover.TierStart) / 1000);
+
+    /* Tier in progress. */
+    if ((FlagUp == FLAG_OFF) && (FlagFailed == FLAG_OFF) && (DurationMsec < RecoverTimeout[Recover.Tier]))
+    {
+      wifi_sched_wait(Task, SCHED_EVENT_TIMER, WIFI_CONNECT_CHECK_MSEC);
+      return;
+    }
+
+    /* Tier completed. */
+    Tier = &Recover.Stats.Tier[Recover.Tier];
+    Tier->LastMsec   = DurationMsec;
+    Tier->TotalMsec += DurationMsec;
+    if (DurationMsec > Tier->MaxMsec) Tier->MaxMsec = DurationMsec;
+
+    if (FlagUp == FLAG_ON)
+    {
+      ++Tier->Successes;
+      Recover.Stats.LastTier = Recover.Tier;
+      log_info(__LINE__, __func__, "Wi-Fi link restored by recovery tier %u (%s) after %lu msec.\r", Recover.Tier + 1, wifi_recover_tier_name(Recover.Tier), DurationMsec);
+      wifi_connect_complete(Recover.StructWiFi);
+      break;
+    }
+
+    log_info(__LINE__, __func__, "Wi-Fi recovery tier %u (%s) failed after %lu msec.\r", Recover.Tier + 1, wifi_recover_tier_name(Recover.Tier), DurationMsec);
+    if (++Recover.Tier >= WIFI_RECOVER_TIERS)
+    {
+      ++Recover.Stats.Failures;
+      ++Recover.StructWiFi->TotalErrors;
+      Recover.Stats.LastTier = WIFI_RECOVER_TIERS;
+      log_info(__LINE__, __func__, "Wi-Fi recovery failed, all tiers have been tried.\r");
+      break;
+    }
+
+    /* Escalate to next tier. */
+    FlagFailed = (wifi_recover_tier(Recover.Tier) != 0) ? FLAG_ON : FLAG_OFF;
+  }
+
+  /* Recovery completed or failed. */
+  wifi_sched_post(Recover.Notify, SCHED_EVENT_DONE);
+  Recover.Task = NULL;
+  wifi_sched_delete(Task);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_tier(). */
+/* ============================================================================================================================================================= *\
+          Start one tier of the recovery, then send a join request (unless the association is still there). Return -1 if the tier could not be started.
+          Only the last tier reloads cyw43 firmware; subscribers to Wi-Fi health events are told before and after, since all lwIP connections are lost.
+\* ============================================================================================================================================================= */
+static INT16 wifi_recover_tier(UINT8 Tier)
+{
+  INT16 ReturnCode;
+
+  UINT8 FlagMonitor;
+
+  UINT32 TotalErrors;
+
+  struct netif *NetIf;
+
+
+  Recover.Tier      = Tier;
+  Recover.TierStart = time_us_64();
+  ++Recover.Stats.Tier[Tier].Attempts;
+  log_info(__LINE__, __func__, "Wi-Fi recovery tier %u: %s.\r", Tier + 1, wifi_recover_tier_name(Tier));
+
+  NetIf = &cyw43_state.netif[CYW43_ITF_STA];
+
+  switch (Tier)
+  {
+    case (WIFI_RECOVER_REJOIN):
+      /* Leave the Access Point and join again; radio, netif and lwIP connections are kept. */
+      cyw43_arch_lwip_begin();
+      cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+      cyw43_arch_lwip_end();
+    break;
+
+    case (WIFI_RECOVER_NETIF):
+      /* Restart the interface and DHCP from scratch (stale lease, ARP cache). */
+      cyw43_arch_lwip_begin();
+      dhcp_release_and_stop(NetIf);
+      netif_set_down(NetIf);
+      netif_set_up(NetIf);
+      dhcp_start(NetIf);
+      cyw43_arch_lwip_end();
+
+      /* Association is still there, DHCP is enough. */
+      if (cyw43_wifi_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_JOIN) return 0;
+    break;
+
+    case (WIFI_RECOVER_REINIT):
+      /* Last resort: reload cyw43 firmware. The health monitor is restarted, since its workers belong to the async context of cyw43. */
+      FlagMonitor = HealthMonitor.FlagActive;
+      wifi_health_publish(WIFI_EVENT_REINIT_START);
+      wifi_health_stop();
+      cyw43_arch_deinit();
+
+      /* wifi_init() clears TotalErrors for a new session: keep the cumulative count across the re-initialization
+         (the other counters of StructWiFi, of the link and of the recovery are not touched by wifi_init()). */
+      TotalErrors = Recover.StructWiFi->TotalErrors;
+      ReturnCode  = wifi_init(Recover.StructWiFi);
+      Recover.StructWiFi->TotalErrors = TotalErrors;
+      if (ReturnCode != 0)
+      {
+        wifi_health_publish(WIFI_EVENT_REINIT_DONE);
+        return -1;
+      }
+      cyw43_arch_enable_sta_mode();
+      if (FlagMonitor == FLAG_ON) wifi_health_start(Recover.StructWiFi);
+      wifi_health_publish(WIFI_EVENT_REINIT_DONE);
+    break;
   }
+
+  cyw43_arch_wifi_connect_async(Recover.StructWiFi->NetworkName, Recover.StructWiFi->NetworkPassword, CYW43_AUTH_WPA2_MIXED_PSK);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_recover_tier_name(). */
+/* ============================================================================================================================================================= *\
+                                                               Return the name of a recovery tier.
+\* ============================================================================================================================================================= */
+const UCHAR *wifi_recover_tier_name(UINT8 Tier)
+{
+  switch (Tier)
+  {
+    case (WIFI_RECOVER_REJOIN):
+      return "rejoin";
+
+    case (WIFI_RECOVER_NETIF):
+      return "netif restart and DHCP";
+
+    case (WIFI_RECOVER_REINIT):
+      return "cyw43 re-initialization";
+
+    default:
+      return "none";
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_set_host_name(). */
+/* ============================================================================================================================================================= *\
+                  Select the host name used at next connection (the last 4 hex digits of the MAC address are appended to make "ExtraHostName").
+                                An empty name selects the default host name (CYW43_HOST_NAME). Return -1 if the name is too long.
+\* ============================================================================================================================================================= */
+INT16 wifi_set_host_name(const UCHAR *Name)
+{
+  if (strlen(Name) >= WIFI_HOST_NAME_SIZE) return -1;
+
+  if (Name[0] == 0x00)
+    strcpy(HostNameBase, CYW43_HOST_NAME);
   else
+    strcpy(HostNameBase, Name);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_set_power_profile(). */
+/* ============================================================================================================================================================= *\
+                                 Select the radio power-management profile (WIFI_POWER_PERFORMANCE, _BALANCED or _AGGRESSIVE).
+                          The profile is applied at once if cyw43 is initialized, and again after each connection made by wifi_connect().
+\* ============================================================================================================================================================= */
+INT16 wifi_set_power_profile(UINT8 Profile)
+{
+  INT16 ReturnCode;
+
+
+  if (Profile >= WIFI_POWER_PROFILES) return -1;
+
+  PowerProfile = Profile;
+  if (!cyw43_is_initialized(&cyw43_state)) return 0;
+
+  cyw43_arch_lwip_begin();
+  ReturnCode = cyw43_wifi_pm(&cyw43_state, PowerValue[Profile]);
+  cyw43_arch_lwip_end();
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sleep_ms(). */
+/* ============================================================================================================================================================= *\
+                Pause the calling code for specified number of msec while the Wi-Fi stack and the tasks of the cooperative scheduler keep running.
+                    Ready tasks are run (except the caller, if it is a task), then the CPU sleeps until next event or time-out (no busy wait).
+                                With the poll architecture, the stack is polled during the pause. Must not be used in a callback.
+\* ============================================================================================================================================================= */
+void wifi_sleep_ms(UINT32 Msec)
+{
+  absolute_time_t Deadline;
+
+
+  Deadline = make_timeout_time_ms(Msec);
+  while (!time_reached(Deadline))
   {
-    if (FlagLocalDebug) log_info(__LINE__, __func__, "cyw43 initialization was successful.\r");
+    wifi_poll();
+    if (wifi_sched_yield() == 0) wifi_sched_idle(Deadline);
   }
 
-  
-  /* Initialize both host name and extra host name as null string. */
-  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->HostName); ++Loop1UInt8)
-    StructWiFi->HostName[Loop1UInt8] = 0x00;
+  return;
+}
 
-  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(StructWiFi->ExtraHostName); ++Loop1UInt8)
-    StructWiFi->ExtraHostName[Loop1UInt8] = 0x00;
 
-  StructWiFi->TotalErrors = 0l;
 
-  if (FlagLocalDebug) log_info(__LINE__, __func__, "Exiting wifi_init().\r");
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_benchmark(). */
+/* ============================================================================================================================================================= *\
+                                               Measure the cost of a pbuf allocation / release pair, to evaluate statistics overhead.
+                             Compare the value returned by a firmware built with WIFI_LWIP_STATS=1 (default) with one built with WIFI_LWIP_STATS=0.
+\* ============================================================================================================================================================= */
+UINT32 wifi_stats_benchmark(void)
+{
+  UINT16 Loop1UInt16;
+
+  UINT64 TimeStamp;
+
+  struct pbuf *PBuf;
+
+
+  cyw43_arch_lwip_begin();
+  TimeStamp = time_us_64();
+  for (Loop1UInt16 = 0; Loop1UInt16 < 1000; ++Loop1UInt16)
+  {
+    PBuf = pbuf_alloc(PBUF_RAW, 64, PBUF_POOL);
+    if (PBuf) pbuf_free(PBuf);
+  }
+  TimeStamp = time_us_64() - TimeStamp;
+  cyw43_arch_lwip_end();
+
+  /* 1000 iterations: elapsed usec is also the number of nsec per iteration. */
+  return (UINT32)TimeStamp;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_display(). */
+/* ============================================================================================================================================================= *\
+                                                                 Display lwIP memory and link statistics.
+\* ============================================================================================================================================================= */
+void wifi_stats_display(void)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_wifi_stats Stats;
+
+
+  wifi_stats_get(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                   lwIP memory and link statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+#if LWIP_STATS && MEMP_STATS
+  log_info(__LINE__, __func__, "Pool                    Size    Used    Peak   Failed\r");
+  for (Loop1UInt8 = 0; Loop1UInt8 < MEMP_MAX; ++Loop1UInt8)
+    log_info(__LINE__, __func__, "%-20s  %6u  %6u  %6u   %6u\r", Stats.Pool[Loop1UInt8].Name, Stats.Pool[Loop1UInt8].Size, Stats.Pool[Loop1UInt8].Used, Stats.Pool[Loop1UInt8].Max, Stats.Pool[Loop1UInt8].Errors);
+#else   // LWIP_STATS && MEMP_STATS
+  log_info(__LINE__, __func__, "Memory pool statistics are not compiled in (WIFI_LWIP_STATS=0).\r");
+#endif  // LWIP_STATS && MEMP_STATS
+  log_info(__LINE__, __func__, "Heap:                 size: %lu   used: %lu   peak: %lu   failed: %u\r", Stats.HeapSize, Stats.HeapUsed, Stats.HeapMax, Stats.HeapErrors);
+  log_info(__LINE__, __func__, "Link received:        %lu packets   %llu bytes   %lu dropped\r", Stats.LinkRxPackets, Stats.LinkRxBytes, Stats.LinkRxDrops);
+  log_info(__LINE__, __func__, "Link sent:            %lu packets   %llu bytes   %lu errors\r", Stats.LinkTxPackets, Stats.LinkTxBytes, Stats.LinkTxErrors);
+  log_info(__LINE__, __func__, "Link memory errors:   %u\r", Stats.LinkMemErrors);
+#if LWIP_STATS
+  log_info(__LINE__, __func__, "Statistics overhead:  %u bytes of RAM (see wifi_stats_benchmark() for CPU)\r", sizeof(lwip_stats) + sizeof(LinkStats));
+#else   // LWIP_STATS
+  log_info(__LINE__, __func__, "Statistics overhead:  %u bytes of RAM (see wifi_stats_benchmark() for CPU)\r", sizeof(LinkStats));
+#endif  // LWIP_STATS
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_get(). */
+/* ============================================================================================================================================================= *\
+                                                                 Retrieve lwIP memory and link statistics.
+\* ============================================================================================================================================================= */
+INT16 wifi_stats_get(struct struct_wifi_stats *Stats)
+{
+  UINT8 Loop1UInt8;
+
+
+  memset(Stats, 0x00, sizeof(*Stats));
+
+  cyw43_arch_lwip_begin();
+  wifi_stats_hook();
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < MEMP_MAX; ++Loop1UInt8)
+  {
+    Stats->Pool[Loop1UInt8].Name = PoolName[Loop1UInt8];
+    Stats->Pool[Loop1UInt8].Size = memp_pools[Loop1UInt8]->num;
+#if LWIP_STATS && MEMP_STATS
+    Stats->Pool[Loop1UInt8].Used   = lwip_stats.memp[Loop1UInt8]->used;
+    Stats->Pool[Loop1UInt8].Max    = lwip_stats.memp[Loop1UInt8]->max;
+    Stats->Pool[Loop1UInt8].Errors = lwip_stats.memp[Loop1UInt8]->err;
+#endif  // LWIP_STATS && MEMP_STATS
+  }
+
+#if !MEM_LIBC_MALLOC
+  Stats->HeapSize = MEM_SIZE;
+#endif  // !MEM_LIBC_MALLOC
+#if LWIP_STATS && MEM_STATS
+  Stats->HeapUsed   = lwip_stats.mem.used;
+  Stats->HeapMax    = lwip_stats.mem.max;
+  Stats->HeapErrors = lwip_stats.mem.err;
+#endif  // LWIP_STATS && MEM_STATS
+
+  Stats->LinkRxPackets = LinkStats.RxPackets;
+  Stats->LinkTxPackets = LinkStats.TxPackets;
+  Stats->LinkRxBytes   = LinkStats.RxBytes;
+  Stats->LinkTxBytes   = LinkStats.TxBytes;
+  Stats->LinkRxDrops   = LinkStats.RxDrops;
+  Stats->LinkTxErrors  = LinkStats.TxErrors;
+#if LWIP_STATS && LINK_STATS
+  Stats->LinkRxDrops  += lwip_stats.link.drop;
+  Stats->LinkMemErrors = lwip_stats.link.memerr;
+#endif  // LWIP_STATS && LINK_STATS
+  cyw43_arch_lwip_end();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_hook(). */
+/* ============================================================================================================================================================= *\
+                                                       Wrap cyw43 station netif functions to count link traffic.
+                              Must be called with lwIP lock held. cyw43 re-creates its netif when station mode is brought up, so this is re-checked.
+\* ============================================================================================================================================================= */
+static void wifi_stats_hook(void)
+{
+  struct netif *NetIf;
+
+
+  NetIf = &cyw43_state.netif[CYW43_ITF_STA];
+
+  if ((NetIf->input != NULL) && (NetIf->input != wifi_stats_input))
+  {
+    LinkStats.Input = NetIf->input;
+    NetIf->input    = wifi_stats_input;
+  }
+
+  if ((NetIf->linkoutput != NULL) && (NetIf->linkoutput != wifi_stats_linkoutput))
+  {
+    LinkStats.LinkOutput = NetIf->linkoutput;
+    NetIf->linkoutput    = wifi_stats_linkoutput;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_input(). */
+/* ============================================================================================================================================================= *\
+                                                                     Counting wrapper of netif->input.
+\* ============================================================================================================================================================= */
+static err_t wifi_stats_input(struct pbuf *PBuf, struct netif *NetIf)
+{
+  err_t ReturnCode;
+
+
+  ++LinkStats.RxPackets;
+  LinkStats.RxBytes += PBuf->tot_len;
+
+  ReturnCode = LinkStats.Input(PBuf, NetIf);
+  if (ReturnCode != ERR_OK) ++LinkStats.RxDrops;
 
   return ReturnCode;
 }
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_linkoutput(). */
+/* ============================================================================================================================================================= *\
+                                                                   Counting wrapper of netif->linkoutput.
+\* ============================================================================================================================================================= */
+static err_t wifi_stats_linkoutput(struct netif *NetIf, struct pbuf *PBuf)
+{
+  err_t ReturnCode;
+
+
+  ++LinkStats.TxPackets;
+  LinkStats.TxBytes += PBuf->tot_len;
+
+  /* Boot timeline: first IPv4 packet once the address is known, other than DHCP (Ethernet type at offset 12, IP protocol at 23, UDP port at 36). */
+  if ((BootTimeline.Time[WIFI_BOOT_FIRST_PACKET] == 0) && (BootTimeline.Time[WIFI_BOOT_DHCP] != 0) && (PBuf->tot_len >= 38) &&
+      (pbuf_get_at(PBuf, 12) == 0x08) && (pbuf_get_at(PBuf, 13) == 0x00) &&
+      !((pbuf_get_at(PBuf, 23) == IP_PROTO_UDP) && (pbuf_get_at(PBuf, 36) == 0x00) && ((pbuf_get_at(PBuf, 37) == 67) || (pbuf_get_at(PBuf, 37) == 68))))
+    wifi_boot_mark(WIFI_BOOT_FIRST_PACKET);
+
+  ReturnCode = LinkStats.LinkOutput(NetIf, PBuf);
+  if (ReturnCode != ERR_OK) ++LinkStats.TxErrors;
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_stats_reset(). */
+/* ============================================================================================================================================================= *\
+                                                          Reset peak values and error counters of the statistics.
+\* ============================================================================================================================================================= */
+void wifi_stats_reset(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  cyw43_arch_lwip_begin();
+#if LWIP_STATS && MEMP_STATS
+  for (Loop1UInt8 = 0; Loop1UInt8 < MEMP_MAX; ++Loop1UInt8)
+  {
+    lwip_stats.memp[Loop1UInt8]->max = lwip_stats.memp[Loop1UInt8]->used;
+    lwip_stats.memp[Loop1UInt8]->err = 0;
+  }
+#endif  // LWIP_STATS && MEMP_STATS
+
+#if LWIP_STATS && MEM_STATS
+  lwip_stats.mem.max = lwip_stats.mem.used;
+  lwip_stats.mem.err = 0;
+#endif  // LWIP_STATS && MEM_STATS
+
+#if LWIP_STATS && LINK_STATS
+  lwip_stats.link.drop   = 0;
+  lwip_stats.link.memerr = 0;
+#endif  // LWIP_STATS && LINK_STATS
+
+  LinkStats.RxPackets = 0;
+  LinkStats.TxPackets = 0;
+  LinkStats.RxBytes   = 0;
+  LinkStats.TxBytes   = 0;
+  LinkStats.RxDrops   = 0;
+  LinkStats.TxErrors  = 0;
+  cyw43_arch_lwip_end();
+
+  return;
+}
\ No newline at end of file
@@ -2,7 +2,7 @@
    Pico-WiFi-Module.h
    St-Louys Andre - September 2024
    astlouys@gmail.com
-   Revision 20-OCT-2024
+   Revision 18-OCT-2026
 
    Include file for Pico-WiFi-Module.c
 \* ============================================================================================================================================================= */
@@ -10,9 +10,11 @@
 #define _WIFI_MODULE_H
 
 #include "lwipopts.h"
+#include "lwip/memp.h"
 #include "pico/cyw43_arch.h"
 #include "pico/stdlib.h"
 #include "pico/unique_id.h"
+#include "Pico-WiFi-Sched.h"
 
 
 /* --------------------------------------------------------------------------------------------------------------------------- *\
@@ -21,6 +23,71 @@
 #define COUNTRY_CODE CYW43_COUNTRY_CANADA  // determine the WiFi frequencies allocated in each specific country.
 #define LED_GPIO             0
 #define MAX_NETWORK_RETRIES 10
+#define WIFI_HOST_NAME_SIZE 33     // longest host name (see wifi_set_host_name()), plus end-of-string.
+
+/* Non-blocking connection (wifi_connect_start()). */
+#define WIFI_CONNECT_CHECK_MSEC      500     // period of link status checks.
+#define WIFI_CONNECT_TIMEOUT_MSEC  20000     // give up after this delay.
+
+/* Wi-Fi health monitor. */
+#define MAX_HEALTH_SUBSCRIBERS         4     // maximum number of application callbacks notified of Wi-Fi health events.
+#define WIFI_HEALTH_POLL_MSEC      30000     // slow fallback poll of cyw43 link status (events normally come from lwIP netif extended status callbacks).
+#define WIFI_HEALTH_LED_MSEC        5000     // period of the LED heartbeat (1 blink: Wi-Fi OK, 3 blinks: Wi-Fi problems).
+#define WIFI_RECONNECT_MIN_MSEC      500     // first reconnection attempt after a link drop.
+#define WIFI_RECONNECT_MAX_MSEC    30000     // reconnection back-off is doubled after each failure, up to this value.
+
+/* Tiers of the Wi-Fi link recovery (wifi_recover_start()), cheapest first. */
+#define WIFI_RECOVER_REJOIN            0     // leave the Access Point and join again.
+#define WIFI_RECOVER_NETIF             1     // bring the netif down / up and restart DHCP.
+#define WIFI_RECOVER_REINIT            2     // de-initialize and re-initialize cyw43 (firmware reloaded over SPI).
+#define WIFI_RECOVER_TIERS             3
+#define WIFI_RECOVER_REJOIN_MSEC   10000     // time given to each tier to bring the link up with an IP address.
+#define WIFI_RECOVER_NETIF_MSEC    10000
+#define WIFI_RECOVER_REINIT_MSEC   20000
+
+/* Radio power-management profiles (see wifi_set_power_profile() and README). */
+#define WIFI_POWER_PERFORMANCE         0     // power save off: lowest latency, highest consumption.
+#define WIFI_POWER_BALANCED            1     // PM2 fast power save: radio sleeps 20 msec after last packet and wakes at every beacon.
+#define WIFI_POWER_AGGRESSIVE          2     // PM1 (PS-Poll): radio sleeps at once and only listens to every 3rd DTIM beacon.
+#define WIFI_POWER_PROFILES            3
+#define WIFI_POWER_DRIVER           0xFF     // cyw43 driver default (PM2, 200 msec), left untouched by the module.
+
+/* cyw43_pm_value(Mode, SleepReturnMsec, BeaconPeriod, DtimPeriod, AssocListenInterval) of each profile. */
+#define WIFI_PM_PERFORMANCE         cyw43_pm_value(CYW43_NO_POWERSAVE_MODE,  20, 1, 1,  1)
+#define WIFI_PM_BALANCED            cyw43_pm_value(CYW43_PM2_POWERSAVE_MODE, 20, 1, 1,  1)
+#define WIFI_PM_AGGRESSIVE          cyw43_pm_value(CYW43_PM1_POWERSAVE_MODE, 10, 1, 3, 10)
+
+#define WIFI_POWER_PROBE_COUNT        40     // echo requests sent with each profile by wifi_power_probe().
+#define WIFI_POWER_PROBE_MSEC        500     // delay between two echo requests, longer than the PM2 sleep return delay so that the radio is back asleep.
+
+/* Buffer sizes for the formatters (end-of-string included). */
+#define WIFI_CHANNEL_STRING_SIZE       4     // wifi_format_channel(): "%3u".
+#define WIFI_INT_STRING_SIZE          12     // wifi_format_int() with Width up to 11.
+#define WIFI_IP_STRING_SIZE           16     // wifi_format_ip(): "255.255.255.255".
+#define WIFI_MAC_STRING_SIZE          18     // wifi_format_mac(): "01:23:45:67:89:AB".
+#define WIFI_RSSI_STRING_SIZE          5     // wifi_format_rssi(): "%4d".
+
+/* Events published by the Wi-Fi health monitor. */
+#define WIFI_EVENT_LINK_DOWN           1     // association with the Access Point has been lost.
+#define WIFI_EVENT_LINK_UP             2     // association with the Access Point has been (re)established.
+#define WIFI_EVENT_IP_ACQUIRED         3     // an IP address has been assigned (DHCP bound).
+#define WIFI_EVENT_IP_CHANGED          4     // IP address has been changed to a different one.
+#define WIFI_EVENT_IP_LOST             5     // IP address has been removed.
+#define WIFI_EVENT_RECONNECTING        6     // monitor is handing off to the reconnection logic.
+#define WIFI_EVENT_REINIT_START        7     // link recovery is about to re-initialize cyw43: all lwIP connections will be lost.
+#define WIFI_EVENT_REINIT_DONE         8     // cyw43 has been re-initialized, lwIP connections may be opened again.
+
+/* Boot milestones, recorded with wifi_boot_mark() (see wifi_boot_display()). */
+#define WIFI_BOOT_MAIN                 0     // main() entered: clocks and C runtime initialized.
+#define WIFI_BOOT_STDIO                1     // stdio initialized.
+#define WIFI_BOOT_CYW43_START          2     // cyw43 initialization started (firmware download over SPI).
+#define WIFI_BOOT_CYW43_READY          3     // cyw43 firmware loaded and running.
+#define WIFI_BOOT_JOIN_START           4     // first join request sent.
+#define WIFI_BOOT_JOINED               5     // associated with the Access Point (link up).
+#define WIFI_BOOT_DHCP                 6     // IP address assigned.
+#define WIFI_BOOT_FIRST_PACKET         7     // first application packet sent (other than ARP and DHCP).
+#define WIFI_BOOT_CONSOLE              8     // terminal connected to CDC USB.
+#define WIFI_BOOT_MILESTONES           9
 
 struct struct_wifi
 {
@@ -30,12 +97,72 @@ struct struct_wifi
   UINT8  FlagHealth;
   UINT32 TotalErrors;          // cumulative number of errors in Wi-Fi connection.
   ip_addr_t PicoIPAddress;
-  UCHAR  HostName[sizeof(CYW43_HOST_NAME)];
-  UCHAR  ExtraHostName[sizeof(CYW43_HOST_NAME) + 4];
+  UCHAR  HostName[WIFI_HOST_NAME_SIZE];
+  UCHAR  ExtraHostName[WIFI_HOST_NAME_SIZE + 4];
   UINT8  InterfaceMode;        // either CYW43_ITF_STA (station mode) or CYW43_ITF_AP (access point). This module assumes STA mode (client mode, not Access Point).
   UINT8  MacAddress[6];
+  UINT32 LinkDownCount;        // number of link drops detected by the health monitor.
+  UINT32 ReconnectCount;       // number of reconnection attempts launched by the health monitor.
+  UINT64 LastEventTime;        // time stamp (in usec since boot) of the last event published by the health monitor.
+};
+
+/* lwIP memory and link statistics, as returned by wifi_stats_get(). */
+struct struct_wifi_stats
+{
+  struct
+  {
+    const UCHAR *Name;
+    UINT16 Size;                 // number of elements in the pool.
+    UINT16 Used;                 // elements currently allocated.
+    UINT16 Max;                  // peak number of elements allocated.
+    UINT16 Errors;               // failed allocations (pool exhausted).
+  } Pool[MEMP_MAX];
+  UINT32 HeapSize;
+  UINT32 HeapUsed;
+  UINT32 HeapMax;                // peak heap usage.
+  UINT16 HeapErrors;             // failed heap allocations.
+  UINT32 LinkRxPackets;          // packets received from cyw43.
+  UINT32 LinkTxPackets;          // packets handed to cyw43.
+  UINT64 LinkRxBytes;
+  UINT64 LinkTxBytes;
+  UINT32 LinkRxDrops;            // packets rejected by lwIP input, plus lwIP link drops.
+  UINT32 LinkTxErrors;           // packets refused by cyw43.
+  UINT16 LinkMemErrors;          // lwIP link memory errors.
+};
+
+/* Round-trip times measured with each power profile by wifi_power_probe(). All times are in usec. */
+struct struct_wifi_power_probe
+{
+  UINT8  Profile;
+  UINT32 Sent;
+  UINT32 Received;
+  UINT32 RttAverage;
+  UINT32 RttP50;
+  UINT32 RttP90;
+  UINT32 RttMax;
+};
+
+/* Wi-Fi link recovery statistics, as returned by wifi_recover_get_stats(). All times are in msec. */
+struct struct_wifi_recover_tier
+{
+  UINT32 Attempts;
+  UINT32 Successes;              // link restored by this tier.
+  UINT32 LastMsec;               // duration of the last attempt.
+  UINT32 MaxMsec;
+  UINT32 TotalMsec;
+};
+
+struct struct_wifi_recover_stats
+{
+  UINT32 Runs;                   // recoveries started.
+  UINT32 Failures;               // recoveries where all tiers failed.
+  UINT8  LastTier;               // tier that restored the link in the last recovery (WIFI_RECOVER_TIERS: none).
+  struct struct_wifi_recover_tier Tier[WIFI_RECOVER_TIERS];
 };
 
+/* Callback type for applications subscribing to Wi-Fi health events. Called from lwIP context, must not block. */
+typedef void (*wifi_health_callback)(UINT8 Event, struct struct_wifi *StructWiFi, void *Context);
+
 
 
 /* --------------------------------------------------------------------------------------------------------------------------- *\
@@ -47,16 +174,115 @@ extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format,
 /* Pause for specified number of msec. */
 static void wait_ms(UINT16 WaitMSec);
 
+/* Return the name of the cyw43 architecture the firmware has been built with. */
+const UCHAR *wifi_arch_name(void);
+
 /* Blink Pico's LED through CYW43. */
 void wifi_blink(UINT16 OnTimeMsec, UINT16 OffTimeMsec, UINT8 Repeat);
 
+/* Display the boot timeline. */
+void wifi_boot_display(void);
+
+/* Record the time of a boot milestone (first occurrence only). */
+void wifi_boot_mark(UINT8 Milestone);
+
+/* Return the name of a boot milestone. */
+const UCHAR *wifi_boot_name(UINT8 Milestone);
+
+/* Return the time of a boot milestone, in usec since reset (0: not reached yet). */
+UINT64 wifi_boot_time(UINT8 Milestone);
+
 /* Initialize Wi-Fi connection. */
 INT16 wifi_connect(struct struct_wifi *StructWiFi);
 
+/* Start a Wi-Fi connection without blocking (task of the cooperative scheduler). */
+INT16 wifi_connect_start(struct struct_wifi *StructWiFi, struct struct_sched_task *Notify);
+
+/* Count the iterations of an idle loop, to evaluate CPU used by networking. */
+UINT32 wifi_cpu_loops(UINT32 DurationMsec);
+
 /* Display Wi-Fi information. */
 void wifi_display_info(struct struct_wifi *StructWiFi);
 
+/* Return a string describing a Wi-Fi health event. */
+const UCHAR *wifi_event_name(UINT8 Event);
+
+/* Format a channel number into caller's buffer. */
+UCHAR *wifi_format_channel(UCHAR *Buffer, UINT8 Channel);
+
+/* Format an integer, right-aligned on Width characters, into caller's buffer. */
+UCHAR *wifi_format_int(UCHAR *Buffer, INT32 Value, UINT8 Width);
+
+/* Format an IPv4 address into caller's buffer. */
+UCHAR *wifi_format_ip(UCHAR *Buffer, const ip4_addr_t *Address);
+
+/* Format a MAC address into caller's buffer. */
+UCHAR *wifi_format_mac(UCHAR *Buffer, const UINT8 *MacAddress, UCHAR Separator);
+
+/* Format a signal strength (RSSI) into caller's buffer. */
+UCHAR *wifi_format_rssi(UCHAR *Buffer, INT16 Rssi);
+
+/* Start the event-driven Wi-Fi health monitor. */
+INT16 wifi_health_start(struct struct_wifi *StructWiFi);
+
+/* Stop the Wi-Fi health monitor. */
+void wifi_health_stop(void);
+
+/* Subscribe an application callback to Wi-Fi health events. */
+INT16 wifi_health_subscribe(wifi_health_callback Callback, void *Context);
+
+/* Unsubscribe an application callback from Wi-Fi health events. */
+void wifi_health_unsubscribe(wifi_health_callback Callback, void *Context);
+
 /* Initialize the cyw43 on PicoW. */
 INT16 wifi_init(struct struct_wifi *StructWiFi);
 
+/* Return the name of the lwIP profile the firmware has been built with. */
+const UCHAR *wifi_lwip_profile(void);
+
+/* Return the RAM statically reserved by lwIP (heap and memory pools). */
+UINT32 wifi_lwip_ram(void);
+
+/* Service the Wi-Fi stack from the application main loop (poll architecture). */
+void wifi_poll(void);
+
+/* Measure round-trip latency with each radio power profile. */
+INT16 wifi_power_probe(const ip_addr_t *Target, UINT16 Count, struct struct_wifi_power_probe *Result);
+
+/* Return the name of a radio power profile. */
+const UCHAR *wifi_power_profile_name(UINT8 Profile);
+
+/* Display Wi-Fi link recovery statistics. */
+void wifi_recover_display(void);
+
+/* Retrieve Wi-Fi link recovery statistics. */
+void wifi_recover_get_stats(struct struct_wifi_recover_stats *Stats);
+
+/* Start a tiered recovery of the Wi-Fi link without blocking (task of the cooperative scheduler). */
+INT16 wifi_recover_start(struct struct_wifi *StructWiFi, UINT8 FirstTier, struct struct_sched_task *Notify);
+
+/* Return the name of a recovery tier. */
+const UCHAR *wifi_recover_tier_name(UINT8 Tier);
+
+/* Select the host name used at next connection. */
+INT16 wifi_set_host_name(const UCHAR *Name);
+
+/* Select the radio power-management profile. */
+INT16 wifi_set_power_profile(UINT8 Profile);
+
+/* Pause for specified number of msec while the Wi-Fi stack keeps running. */
+void wifi_sleep_ms(UINT32 Msec);
+
+/* Measure the cost of a pbuf allocation / release pair, to evaluate statistics overhead. */
+UINT32 wifi_stats_benchmark(void);
+
+/* Display lwIP memory and link statistics. */
+void wifi_stats_display(void);
+
+/* Retrieve lwIP memory and link statistics. */
+INT16 wifi_stats_get(struct struct_wifi_stats *Stats);
+
+/* Reset peak values and error counters of the statistics. */
+void wifi_stats_reset(void);
+
 #endif  // _WIFI_MODULE_H
\ No newline at end of file
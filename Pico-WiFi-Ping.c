@@ -0,0 +1,602 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Ping.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   ICMP echo (ping) engine built on the lwIP raw API, part of Pico-WiFi-Module.
+   Pings up to MAX_PING_TARGETS targets concurrently, each one at its own rate, and keeps per-target loss, jitter and
+   round-trip time statistics in fixed-size histograms from which p50 / p90 / p99 are derived.
+   The engine runs entirely from a single lwIP timeout and may be stopped at any time without resetting the Pico.
+   It only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against lwIP's loopback netif.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Outstanding echo requests kept in a pool shared by the targets, each target's window sized from its interval.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+
+#include "lwip/icmp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/ip.h"
+#include "lwip/raw.h"
+
+#include "Pico-WiFi-Ping.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define PING_ECHO_SIZE  (sizeof(struct icmp_echo_hdr) + PING_DATA_SIZE)
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+/* Upper limit (in usec) of each bin of the round-trip time histogram. Last bin catches everything else. */
+static const UINT32 PingBinLimit[PING_HISTOGRAM_BINS] =
+{
+      250,     500,    1000,    1500,    2000,    3000,    4000,    5000,
+     7500,   10000,   15000,   20000,   30000,   40000,   50000,   75000,
+   100000,  150000,  200000,  300000,  500000,  750000, 1000000, 0xFFFFFFFF
+};
+
+static struct
+{
+  UINT8  FlagRunning;
+  UINT8  TargetCount;
+  UINT16 SlotCount;                          // slots of SendTime[] / SendSequence[] given to the targets.
+  struct raw_pcb *Pcb;
+  struct struct_ping_target Target[MAX_PING_TARGETS];
+  UINT64 SendTime[PING_SLOTS];
+  UINT16 SendSequence[PING_SLOTS];
+} PingEngine;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Return the round-trip time corresponding to the specified percentile (in tenths of percent). */
+static UINT32 ping_percentile(struct struct_ping_target *Target, UINT16 PerMille);
+
+/* lwIP raw callback receiving ICMP packets. */
+static u8_t ping_receive(void *Arg, struct raw_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address);
+
+/* Send one echo request to a target. */
+static void ping_send(UINT8 TargetNumber, UINT64 TimeStamp);
+
+/* lwIP timeout handling sends and time-outs of all targets. */
+static void ping_timer(void *Arg);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_clear_targets(). */
+/* ============================================================================================================================================================= *\
+                                                               Remove all targets (ping engine must be stopped).
+\* ============================================================================================================================================================= */
+void ping_clear_targets(void)
+{
+  if (PingEngine.FlagRunning) return;
+
+  memset(PingEngine.Target, 0x00, sizeof(PingEngine.Target));
+  PingEngine.TargetCount = 0;
+  PingEngine.SlotCount   = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                   Display statistics of all targets.
+\* ============================================================================================================================================================= */
+void ping_display_stats(void)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_ping_stats Stats;
+
+
+  log_info(__LINE__, __func__, "=================================================================================================================\r");
+  log_info(__LINE__, __func__, "      Target          Sent   Recv   Lost   Late  Loss     Min      Avg      p50      p90      p99      Max   Jitter\r");
+  log_info(__LINE__, __func__, "                                                   %%      msec     msec     msec     msec     msec     msec     msec\r");
+  log_info(__LINE__, __func__, "=================================================================================================================\r");
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < PingEngine.TargetCount; ++Loop1UInt8)
+  {
+    ping_get_stats(Loop1UInt8, &Stats);
+    log_info(__LINE__, __func__, "%-15s  %5lu  %5lu  %5lu  %5lu %3u.%u %5lu.%02lu %5lu.%02lu %5lu.%02lu %5lu.%02lu %5lu.%02lu %5lu.%02lu %5lu.%02lu\r",
+             ip4addr_ntoa(&Stats.Address), Stats.Sent, Stats.Received, Stats.Lost, Stats.Late, Stats.LossPercent10 / 10, Stats.LossPercent10 % 10,
+             Stats.RttMin     / 1000, (Stats.RttMin     % 1000) / 10,
+             Stats.RttAverage / 1000, (Stats.RttAverage % 1000) / 10,
+             Stats.RttP50     / 1000, (Stats.RttP50     % 1000) / 10,
+             Stats.RttP90     / 1000, (Stats.RttP90     % 1000) / 10,
+             Stats.RttP99     / 1000, (Stats.RttP99     % 1000) / 10,
+             Stats.RttMax     / 1000, (Stats.RttMax     % 1000) / 10,
+             Stats.Jitter     / 1000, (Stats.Jitter     % 1000) / 10);
+  }
+
+  log_info(__LINE__, __func__, "=================================================================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                    Retrieve statistics of a target.
+\* ============================================================================================================================================================= */
+INT16 ping_get_stats(UINT8 TargetNumber, struct struct_ping_stats *Stats)
+{
+  UINT32 Completed;
+
+  struct struct_ping_target *Target;
+
+
+  if (TargetNumber >= PingEngine.TargetCount) return -1;
+
+  Target = &PingEngine.Target[TargetNumber];
+
+  WIFI_LWIP_BEGIN();
+  Stats->Address    = Target->Address;
+  Stats->Sent       = Target->Sent;
+  Stats->Received   = Target->Received;
+  Stats->Lost       = Target->Lost;
+  Stats->Late       = Target->Late;
+  Stats->SendErrors = Target->SendErrors;
+  Stats->RttMin     = Target->Received ? Target->RttMin : 0;
+  Stats->RttMax     = Target->RttMax;
+  Stats->RttAverage = Target->Received ? (UINT32)(Target->RttSum / Target->Received) : 0;
+  Stats->RttP50     = ping_percentile(Target, 500);
+  Stats->RttP90     = ping_percentile(Target, 900);
+  Stats->RttP99     = ping_percentile(Target, 990);
+  Stats->Jitter     = Target->Jitter;
+
+  /* Loss is computed on echo requests that are either answered or timed out (not the ones still in flight). */
+  Completed = Target->Received + Target->Lost;
+  Stats->LossPercent10 = Completed ? (UINT16)((Target->Lost * 1000ull) / Completed) : 0;
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_is_running(). */
+/* ============================================================================================================================================================= *\
+                                                                    Tell if the ping engine is running.
+\* ============================================================================================================================================================= */
+UINT8 ping_is_running(void)
+{
+  return PingEngine.FlagRunning;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_percentile(). */
+/* ============================================================================================================================================================= *\
+                                       Return the round-trip time corresponding to the specified percentile (in tenths of percent).
+                                             Value is interpolated linearly inside the histogram bin where the percentile falls.
+\* ============================================================================================================================================================= */
+static UINT32 ping_percentile(struct struct_ping_target *Target, UINT16 PerMille)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 Cumulative;
+  UINT32 Lower;
+  UINT32 Rank;
+  UINT32 Upper;
+  UINT32 Value;
+
+
+  if (Target->Received == 0) return 0;
+
+  /* Rank of the sample corresponding to the percentile (rounded up). */
+  Rank = (UINT32)(((UINT64)Target->Received * PerMille + 999) / 1000);
+  if (Rank == 0) Rank = 1;
+
+  Cumulative = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < PING_HISTOGRAM_BINS; ++Loop1UInt8)
+  {
+    if ((Cumulative + Target->Histogram[Loop1UInt8]) >= Rank) break;
+    Cumulative += Target->Histogram[Loop1UInt8];
+  }
+  if (Loop1UInt8 >= PING_HISTOGRAM_BINS) return Target->RttMax;
+
+  Lower = (Loop1UInt8 == 0) ? 0 : PingBinLimit[Loop1UInt8 - 1];
+  Upper = (Loop1UInt8 == (PING_HISTOGRAM_BINS - 1)) ? Target->RttMax : PingBinLimit[Loop1UInt8];
+  Value = Lower + (UINT32)(((UINT64)(Upper - Lower) * (Rank - Cumulative)) / Target->Histogram[Loop1UInt8]);
+
+  /* Bins are coarse, keep result within the values really observed. */
+  if (Value < Target->RttMin) Value = Target->RttMin;
+  if (Value > Target->RttMax) Value = Target->RttMax;
+
+  return Value;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_receive(). */
+/* ============================================================================================================================================================= *\
+                                                           lwIP raw callback receiving ICMP packets.
+                                          Returns 1 if the packet is an echo reply for one of our targets (packet is then eaten).
+\* ============================================================================================================================================================= */
+static u8_t ping_receive(void *Arg, struct raw_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address)
+{
+  UINT16 HeaderLength;
+  UINT16 Identifier;
+  UINT16 Sequence;
+  UINT16 Slot;
+
+  UINT32 Deviation;
+  UINT32 Rtt;
+
+  UINT64 TimeStamp;
+
+  struct icmp_echo_hdr EchoHeader;
+  struct struct_ping_target *Target;
+
+
+  TimeStamp = WIFI_TIME_US();
+
+  /* Raw IPv4 pcbs receive the IP header too. */
+  if (PBuf->len < sizeof(struct ip_hdr)) return 0;
+  HeaderLength = IPH_HL_BYTES((struct ip_hdr *)PBuf->payload);
+  if (PBuf->tot_len < (HeaderLength + sizeof(EchoHeader))) return 0;
+  pbuf_copy_partial(PBuf, &EchoHeader, sizeof(EchoHeader), HeaderLength);
+
+  if (ICMPH_TYPE(&EchoHeader) != ICMP_ER) return 0;
+
+  Identifier = lwip_ntohs(EchoHeader.id);
+  if ((Identifier < PING_ID_BASE) || (Identifier >= (PING_ID_BASE + PingEngine.TargetCount))) return 0;
+
+  Target   = &PingEngine.Target[Identifier - PING_ID_BASE];
+  Sequence = lwip_ntohs(EchoHeader.seqno);
+  Slot     = Sequence & (Target->Window - 1);
+
+  if ((Target->SendTime[Slot] == 0) || (Target->SendSequence[Slot] != Sequence))
+  {
+    /* Reply to an echo request already counted as lost, or duplicate. */
+    ++Target->Late;
+  }
+  else
+  {
+    Rtt = (UINT32)(TimeStamp - Target->SendTime[Slot]);
+    Target->SendTime[Slot] = 0;
+
+    /* Inter-arrival jitter (RFC 3550): J += (|D| - J) / 16. */
+    if (Target->Received)
+    {
+      Deviation = (Rtt > Target->RttLast) ? (Rtt - Target->RttLast) : (Target->RttLast - Rtt);
+      Target->Jitter = (UINT32)((INT32)Target->Jitter + (((INT32)Deviation - (INT32)Target->Jitter) / 16));
+    }
+
+    if ((Target->Received == 0) || (Rtt < Target->RttMin)) Target->RttMin = Rtt;
+    if (Rtt > Target->RttMax) Target->RttMax = Rtt;
+    Target->RttLast = Rtt;
+    Target->RttSum += Rtt;
+    ++Target->Received;
+
+    for (Slot = 0; Rtt > PingBinLimit[Slot]; ++Slot);
+    ++Target->Histogram[Slot];
+  }
+
+  pbuf_free(PBuf);
+
+  return 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_send(). */
+/* ============================================================================================================================================================= *\
+                                                                  Send one echo request to a target.
+\* ============================================================================================================================================================= */
+static void ping_send(UINT8 TargetNumber, UINT64 TimeStamp)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Slot;
+
+  struct icmp_echo_hdr *EchoHeader;
+  struct pbuf *PBuf;
+  struct struct_ping_target *Target;
+
+
+  Target = &PingEngine.Target[TargetNumber];
+  Slot   = Target->Sequence & (Target->Window - 1);
+
+  /* Window wrapped around while a request was still outstanding: count it as lost now.
+     ping_target_add() sizes the window so that this only happens if ping_timer() was held off for a while. */
+  if (Target->SendTime[Slot] != 0)
+  {
+    Target->SendTime[Slot] = 0;
+    ++Target->Lost;
+  }
+
+  PBuf = pbuf_alloc(PBUF_IP, (UINT16)PING_ECHO_SIZE, PBUF_RAM);
+  if (PBuf == NULL)
+  {
+    ++Target->SendErrors;
+    return;
+  }
+
+  EchoHeader = (struct icmp_echo_hdr *)PBuf->payload;
+  ICMPH_TYPE_SET(EchoHeader, ICMP_ECHO);
+  ICMPH_CODE_SET(EchoHeader, 0);
+  EchoHeader->chksum = 0;
+  EchoHeader->id     = lwip_htons(PING_ID_BASE + TargetNumber);
+  EchoHeader->seqno  = lwip_htons(Target->Sequence);
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < PING_DATA_SIZE; ++Loop1UInt16)
+    ((UCHAR *)PBuf->payload)[sizeof(struct icmp_echo_hdr) + Loop1UInt16] = (UCHAR)Loop1UInt16;
+
+  EchoHeader->chksum = inet_chksum(EchoHeader, (UINT16)PING_ECHO_SIZE);
+
+  Target->SendTime[Slot]     = TimeStamp;
+  Target->SendSequence[Slot] = Target->Sequence;
+  if (raw_sendto(PingEngine.Pcb, PBuf, &Target->Address) == ERR_OK)
+  {
+    ++Target->Sent;
+  }
+  else
+  {
+    Target->SendTime[Slot] = 0;
+    ++Target->SendErrors;
+  }
+  ++Target->Sequence;
+
+  pbuf_free(PBuf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_start(). */
+/* ============================================================================================================================================================= *\
+                                                                         Start pinging all targets.
+\* ============================================================================================================================================================= */
+INT16 ping_start(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT64 TimeStamp;
+
+  struct struct_ping_target *Target;
+
+
+  if (PingEngine.FlagRunning) return 0;
+  if (PingEngine.TargetCount == 0) return -1;
+
+  WIFI_LWIP_BEGIN();
+  PingEngine.Pcb = raw_new(IP_PROTO_ICMP);
+  if (PingEngine.Pcb == NULL)
+  {
+    WIFI_LWIP_END();
+    return -1;
+  }
+  raw_recv(PingEngine.Pcb, ping_receive, NULL);
+  raw_bind(PingEngine.Pcb, IP_ADDR_ANY);
+
+  /* Reset statistics and spread first echo requests of each target a few msec apart. */
+  TimeStamp = WIFI_TIME_US();
+  for (Loop1UInt8 = 0; Loop1UInt8 < PingEngine.TargetCount; ++Loop1UInt8)
+  {
+    Target = &PingEngine.Target[Loop1UInt8];
+    memset(&Target->Sequence, 0x00, sizeof(struct struct_ping_target) - offsetof(struct struct_ping_target, Sequence));
+    memset(Target->SendTime, 0x00, Target->Window * sizeof(Target->SendTime[0]));
+    Target->NextSend = TimeStamp + (Loop1UInt8 * 5000ull);
+  }
+
+  PingEngine.FlagRunning = FLAG_ON;
+  sys_timeout(1, ping_timer, NULL);
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_stop(). */
+/* ============================================================================================================================================================= *\
+                                                                     Stop pinging, keeping statistics.
+\* ============================================================================================================================================================= */
+void ping_stop(void)
+{
+  WIFI_LWIP_BEGIN();
+  if (PingEngine.FlagRunning)
+  {
+    sys_untimeout(ping_timer, NULL);
+    raw_remove(PingEngine.Pcb);
+    PingEngine.Pcb         = NULL;
+    PingEngine.FlagRunning = FLAG_OFF;
+  }
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_target_add(). */
+/* ============================================================================================================================================================= *\
+                                                                           Add a target to ping.
+                                 Returns -1 if the slots left in the pool can't cover PING_TIMEOUT_MSEC at this interval (interval too short).
+\* ============================================================================================================================================================= */
+INT16 ping_target_add(const ip_addr_t *Address, UINT16 IntervalMsec, UINT16 Count)
+{
+  UINT16 Needed;
+  UINT16 Window;
+
+  struct struct_ping_target *Target;
+
+
+  if (PingEngine.FlagRunning) return -1;
+  if (PingEngine.TargetCount >= MAX_PING_TARGETS) return -1;
+  if (IntervalMsec == 0) IntervalMsec = 1;
+
+  /* A slot must not be reused before its echo request has timed out: window covers PING_TIMEOUT_MSEC, plus one interval of margin. */
+  Needed = (PING_TIMEOUT_MSEC / IntervalMsec) + 2;
+  for (Window = PING_WINDOW_MIN; Window < Needed; Window <<= 1);
+  if ((PingEngine.SlotCount + Window) > PING_SLOTS) return -1;
+
+  Target = &PingEngine.Target[PingEngine.TargetCount];
+  memset(Target, 0x00, sizeof(*Target));
+  ip_addr_copy(Target->Address, *Address);
+  Target->IntervalMsec = IntervalMsec;
+  Target->Count        = Count;
+  Target->Window       = Window;
+  Target->SendTime     = &PingEngine.SendTime[PingEngine.SlotCount];
+  Target->SendSequence = &PingEngine.SendSequence[PingEngine.SlotCount];
+  PingEngine.SlotCount += Window;
+
+  return PingEngine.TargetCount++;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_target_count(). */
+/* ============================================================================================================================================================= *\
+                                                                       Return the number of targets.
+\* ============================================================================================================================================================= */
+UINT8 ping_target_count(void)
+{
+  return PingEngine.TargetCount;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ping_timer(). */
+/* ============================================================================================================================================================= *\
+                                                         lwIP timeout handling sends and time-outs of all targets.
+                                         Re-arms itself for the earliest upcoming deadline, so only one lwIP timeout is ever used.
+\* ============================================================================================================================================================= */
+static void ping_timer(void *Arg)
+{
+  UINT8 FlagPending;
+  UINT8 Loop1UInt8;
+
+  UINT16 Slot;
+
+  UINT64 Deadline;
+  UINT64 NextWakeUp;
+  UINT64 TimeStamp;
+
+  struct struct_ping_target *Target;
+
+
+  if (PingEngine.FlagRunning == FLAG_OFF) return;
+
+  TimeStamp   = WIFI_TIME_US();
+  NextWakeUp  = TimeStamp + (PING_TIMEOUT_MSEC * 1000ull);
+  FlagPending = FLAG_OFF;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < PingEngine.TargetCount; ++Loop1UInt8)
+  {
+    Target = &PingEngine.Target[Loop1UInt8];
+
+    /* Count echo requests without reply as lost. */
+    for (Slot = 0; Slot < Target->Window; ++Slot)
+    {
+      if (Target->SendTime[Slot] == 0) continue;
+
+      Deadline = Target->SendTime[Slot] + (PING_TIMEOUT_MSEC * 1000ull);
+      if (TimeStamp >= Deadline)
+      {
+        Target->SendTime[Slot] = 0;
+        ++Target->Lost;
+      }
+      else
+      {
+        FlagPending = FLAG_ON;
+        if (Deadline < NextWakeUp) NextWakeUp = Deadline;
+      }
+    }
+
+    /* Target is done once the requested number of echo requests has been sent. */
+    if ((Target->Count != 0) && (Target->Sequence >= Target->Count)) continue;
+
+    if (TimeStamp >= Target->NextSend)
+    {
+      ping_send(Loop1UInt8, TimeStamp);
+      Target->NextSend += (Target->IntervalMsec * 1000ull);
+
+      /* Don't try to catch up with missed sends (in case we were held off for a while). */
+      if (Target->NextSend <= TimeStamp) Target->NextSend = TimeStamp + (Target->IntervalMsec * 1000ull);
+
+      if (Target->SendTime[(Target->Sequence - 1) & (Target->Window - 1)]) FlagPending = FLAG_ON;
+      if ((Target->Count != 0) && (Target->Sequence >= Target->Count)) continue;
+    }
+
+    FlagPending = FLAG_ON;
+    if (Target->NextSend < NextWakeUp) NextWakeUp = Target->NextSend;
+  }
+
+  /* All targets done and no more reply expected: stop by ourselves. */
+  if (FlagPending == FLAG_OFF)
+  {
+    raw_remove(PingEngine.Pcb);
+    PingEngine.Pcb         = NULL;
+    PingEngine.FlagRunning = FLAG_OFF;
+    return;
+  }
+
+  sys_timeout((UINT32)((NextWakeUp - TimeStamp + 999) / 1000), ping_timer, NULL);
+
+  return;
+}
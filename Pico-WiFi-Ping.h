@@ -0,0 +1,100 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Ping.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Ping.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_PING_H
+#define _WIFI_PING_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define MAX_PING_TARGETS          8     // maximum number of targets pinged concurrently.
+#define PING_DATA_SIZE           32     // size of the ICMP echo payload.
+#define PING_HISTOGRAM_BINS      24     // number of bins in the round-trip time histogram of each target.
+#define PING_ID_BASE         0xAF00     // ICMP identifier of target 0 (target n uses PING_ID_BASE + n).
+#define PING_TIMEOUT_MSEC      1000     // an echo request without reply after this delay is counted as lost.
+#define PING_SLOTS              256     // outstanding echo requests of all targets together (pool shared by the targets).
+#define PING_WINDOW_MIN           4     // smallest window of a target (in slots, must be a power of 2).
+
+
+/* Per-target configuration and statistics. All times are in usec. */
+struct struct_ping_target
+{
+  ip_addr_t Address;
+  UINT16 IntervalMsec;                       // delay between two echo requests.
+  UINT16 Count;                              // number of echo requests to send (0 = until ping_stop()).
+  UINT16 Window;                             // number of slots of the target, covering PING_TIMEOUT_MSEC at IntervalMsec (power of 2).
+  UINT64 *SendTime;                          // time stamp of each outstanding echo request (0 = not outstanding), in PingEngine's pool.
+  UINT16 *SendSequence;                      // sequence number of each outstanding echo request, in PingEngine's pool.
+  UINT16 Sequence;                           // sequence number of the next echo request.
+  UINT32 Sent;
+  UINT32 Received;
+  UINT32 Lost;                               // echo requests without reply after PING_TIMEOUT_MSEC.
+  UINT32 Late;                               // replies received after having been counted as lost, or duplicates.
+  UINT32 SendErrors;                         // echo requests that could not be sent (no route, out of memory).
+  UINT32 RttMin;
+  UINT32 RttMax;
+  UINT64 RttSum;
+  UINT32 RttLast;
+  UINT32 Jitter;                             // inter-arrival jitter estimate, as in RFC 3550.
+  UINT64 NextSend;                           // time stamp of the next echo request.
+  UINT32 Histogram[PING_HISTOGRAM_BINS];     // round-trip time histogram (see PingBinLimit[] in Pico-WiFi-Ping.c).
+};
+
+
+/* Summary of a target's statistics, as returned by ping_get_stats(). */
+struct struct_ping_stats
+{
+  ip_addr_t Address;
+  UINT32 Sent;
+  UINT32 Received;
+  UINT32 Lost;
+  UINT32 Late;
+  UINT32 SendErrors;
+  UINT16 LossPercent10;                      // loss in tenths of percent.
+  UINT32 RttMin;
+  UINT32 RttAverage;
+  UINT32 RttMax;
+  UINT32 RttP50;
+  UINT32 RttP90;
+  UINT32 RttP99;
+  UINT32 Jitter;
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Remove all targets (ping engine must be stopped). */
+void ping_clear_targets(void);
+
+/* Display statistics of all targets. */
+void ping_display_stats(void);
+
+/* Retrieve statistics of a target. */
+INT16 ping_get_stats(UINT8 TargetNumber, struct struct_ping_stats *Stats);
+
+/* Tell if the ping engine is running. */
+UINT8 ping_is_running(void);
+
+/* Start pinging all targets. */
+INT16 ping_start(void);
+
+/* Stop pinging, keeping statistics. */
+void ping_stop(void);
+
+/* Add a target to ping. */
+INT16 ping_target_add(const ip_addr_t *Address, UINT16 IntervalMsec, UINT16 Count);
+
+/* Return the number of targets. */
+UINT8 ping_target_count(void);
+
+#endif  // _WIFI_PING_H
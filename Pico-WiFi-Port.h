@@ -0,0 +1,66 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Port.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Portability layer for the network applications of Pico-WiFi-Module which only rely on the lwIP raw API.
+   On the PicoW, they run in lwIP context and must hold the cyw43 lwIP lock when called from user code.
+   On a host (lwIP unix port, loopback or tap interface), the lock is a no-op and time is read from the system monotonic clock.
+   Work that must not run in lwIP context is deferred to the cooperative scheduler on the PicoW, and run at once on a host.
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_PORT_H
+#define _WIFI_PORT_H
+
+#include "baseline.h"
+
+#if PICO_ON_DEVICE
+#include "pico/cyw43_arch.h"
+#include "pico/stdlib.h"
+#include "Pico-WiFi-Sched.h"
+#else   // PICO_ON_DEVICE
+#include <time.h>
+#endif  // PICO_ON_DEVICE
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/timeouts.h"
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#if PICO_ON_DEVICE
+#define WIFI_LWIP_BEGIN()  cyw43_arch_lwip_begin()
+#define WIFI_LWIP_END()    cyw43_arch_lwip_end()
+#define WIFI_TIME_US()     time_us_64()
+#define WIFI_DEFER(Function, Arg)  wifi_sched_call(Function, Arg)    // 0 if the call has been queued.
+#define WIFI_IN_INTERRUPT()        (__get_current_exception() != 0)
+#else   // PICO_ON_DEVICE
+#define WIFI_LWIP_BEGIN()
+#define WIFI_LWIP_END()
+#define WIFI_TIME_US()     wifi_host_time_us()
+#define WIFI_DEFER(Function, Arg)  ((Function)(Arg), 0)
+#define WIFI_IN_INTERRUPT()        0
+
+/* Host replacement for the Pico's time_us_64(). */
+static inline UINT64 wifi_host_time_us(void)
+{
+  struct timespec TimeSpec;
+
+  clock_gettime(CLOCK_MONOTONIC, &TimeSpec);
+
+  return ((UINT64)TimeSpec.tv_sec * 1000000ull) + (TimeSpec.tv_nsec / 1000);
+}
+#endif  // PICO_ON_DEVICE
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Log info to log file through Pico's UART or CDC USB (provided by user program). */
+extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+#endif  // _WIFI_PORT_H
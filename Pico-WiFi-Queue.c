@@ -0,0 +1,1087 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Queue.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Store-and-forward telemetry queue in flash: records given by the application while the network is down (or while earlier records are still
+   waiting) are kept in flash and survive a reboot, then drained in batches once the link is back. QUEUE_SECTORS sectors are reserved just below
+   the configuration store (see Pico-WiFi-Config.c).
+   - Append-only log: each sector is a segment with a header (Magic, generation, CRC-16, acknowledge slots) followed by records (Magic, Length,
+     Data, CRC-16). A record cut short by a power loss fails its CRC check and is skipped. Records are gathered in a RAM page and programmed
+     one flash page at a time (or when wifi_queue_flush() is called), so that small records do not cost one flash operation each.
+   - Wear-aware rotation: segments are used in turn around the ring, each one being erased only when the writer comes back to it, so that all
+     sectors wear evenly. Emptying the queue does not erase anything: segments are only marked as drained. When the ring is full, the oldest
+     segment is discarded to make room for new records (newest telemetry is kept).
+   - Drain: once wifi_queue_start() has been called (link is up), wifi_queue_service() hands batches of up to QUEUE_BATCH_RECORDS records
+     (QUEUE_BATCH_BYTES) to the sender of the application, read in place from flash. A token bucket limits the drain to QUEUE_DRAIN_RATE bytes
+     per second, so that live traffic is not starved. Only one batch is in flight; a failed batch is sent again after a growing delay.
+   - Acknowledgement: the position reached after each delivered batch is written to a slot of the segment header, and a segment sent completely
+     is marked as drained. After a reboot, sending resumes there. When the slots of a segment are used up, its last batches may be sent again
+     after a reboot (delivery is at least once).
+   Flash is only written from the caller's context: wifi_queue_push(), wifi_queue_service() and the others must not be called from interrupt
+   or lwIP context. wifi_queue_done() may be called from anywhere.
+   Flash is erased, programmed and verified through Pico-WiFi-Flash.c, which also provides the CRC-16.
+   On a host, flash is replaced by a RAM image (see wifi_queue_image()), so that the queue can be tested and benchmarked (see wifi_queue_bench()).
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Flash access, segment header and CRC-16 moved to Pico-WiFi-Flash.c (shared with Pico-WiFi-Config.c).
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "Pico-WiFi-Config.h"
+#include "Pico-WiFi-Flash.h"
+#include "Pico-WiFi-Queue.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define QUEUE_MAGIC             0x31515457     // "WTQ1", first word of a valid segment header.
+#define QUEUE_HEADER_SIZE              128     // Magic u32, Sequence u32, CRC-16 of both, 2 bytes of padding, acknowledge slots.
+#define QUEUE_ACK_OFFSET                12     // first acknowledge slot (UINT16: offset where sending resumes).
+#define QUEUE_ACK_SLOTS                 58     // the last one only receives the "drained" mark.
+#define QUEUE_ACK_DRAINED  QUEUE_SECTOR_SIZE   // value of the last slot once the segment has been sent completely.
+#define QUEUE_RECORD_MAGIC            0xA5     // first byte of a record; 0xFF is free space.
+#define QUEUE_RECORD_OVERHEAD            5     // Magic, Length (2 bytes), then CRC-16 after the data.
+#define QUEUE_RECORD_SIZE(Length)  (((Length) + QUEUE_RECORD_OVERHEAD + 3) & ~3)    // records are aligned on 4 bytes.
+#define QUEUE_NO_SEGMENT   QUEUE_SECTORS
+#define QUEUE_NEXT(Segment)  (((Segment) + 1) % QUEUE_SECTORS)
+
+/* Outcome of the batch in flight (see wifi_queue_done()). */
+#define QUEUE_RESULT_NONE                0
+#define QUEUE_RESULT_OK                  1
+#define QUEUE_RESULT_FAILED              2
+
+#define QUEUE_FLASH_DATA(Offset)  WIFI_FLASH_DATA(&QueueFlash, Offset)
+
+#if PICO_ON_DEVICE
+#define QUEUE_FLASH_OFFSET  (PICO_FLASH_SIZE_BYTES - ((CONFIG_SECTORS + QUEUE_SECTORS) * QUEUE_SECTOR_SIZE))
+#else   // PICO_ON_DEVICE
+#define QUEUE_SIM_PROGRAM_USEC         400     // typical page program time of the PicoW flash, to model flash time of the benchmark on a host.
+#define QUEUE_SIM_ERASE_USEC         45000     // typical sector erase time.
+#endif  // PICO_ON_DEVICE
+
+_Static_assert((QUEUE_SECTORS >= 2) && (QUEUE_SECTORS < 255), "QUEUE_SECTORS must be between 2 and 254");
+_Static_assert(WIFI_FLASH_HEADER_SIZE <= QUEUE_ACK_OFFSET, "acknowledge slots overlap the sector header");
+_Static_assert(QUEUE_ACK_OFFSET + (QUEUE_ACK_SLOTS * 2) <= QUEUE_HEADER_SIZE, "acknowledge slots do not fit in the segment header");
+_Static_assert(QUEUE_HEADER_SIZE + QUEUE_RECORD_SIZE(QUEUE_MAX_RECORD) <= QUEUE_SECTOR_SIZE, "QUEUE_MAX_RECORD does not fit in a segment");
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UINT8  FlagInit;
+  UINT8  FlagDraining;                                 // wifi_queue_start() has been called.
+  UINT8  FlagInFlight;                                 // Batch has been handed to the sender, its outcome is awaited.
+  UINT8  FlagUnlimited;                                // no rate limit (benchmark).
+  volatile UINT8 Result;                               // outcome of the batch in flight, QUEUE_RESULT_xxx.
+  UINT8  Head;                                         // segment being written, QUEUE_NO_SEGMENT: nothing written yet.
+  UINT16 HeadOffset;                                   // free space of Head.
+  UINT32 Sequence;                                     // generation of Head.
+  UINT8  Tail;                                         // oldest segment holding records to send.
+  UINT16 TailOffset;                                   // next record to send.
+  UINT8  TailAck;                                      // next free acknowledge slot of Tail.
+  UINT8  BatchEnd;                                     // segment and offset following the last record of Batch.
+  UINT16 BatchEndOffset;
+  UINT16 PageBase;                                     // offset in Head of the page being filled.
+  UINT16 PageFrom;                                     // first byte of Page not programmed yet (PageFrom == HeadOffset: nothing to program).
+  UINT8  Page[QUEUE_PAGE_SIZE];
+  UINT32 Tokens;                                       // payload bytes that may be sent now (rate limit).
+  UINT64 TokenTime;
+  UINT64 BatchTime;                                    // Batch handed to the sender.
+  UINT64 RetryTime;                                    // failed batch is sent again at this time.
+  UINT32 RetryMsec;
+  queue_sender Sender;
+  void  *Context;
+  struct struct_queue_batch Batch;
+  struct struct_queue_stats Stats;
+} Queue;
+
+#if PICO_ON_DEVICE
+/* End of the Firmware in flash (linker script). */
+extern char __flash_binary_end;
+
+/* QUEUE_SECTORS sectors just below the configuration store. */
+static const struct struct_flash_region QueueFlash = {QUEUE_FLASH_OFFSET, QUEUE_SECTORS * QUEUE_SECTOR_SIZE, NULL};
+#else   // PICO_ON_DEVICE
+static UINT8 QueueImage[QUEUE_SECTORS * QUEUE_SECTOR_SIZE];
+static UINT8 FlagImage;                                // image has been erased (0xFF) once.
+static const struct struct_flash_region QueueFlash = {0, sizeof(QueueImage), QueueImage};
+#endif  // PICO_ON_DEVICE
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log data to log file. */
+extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Write an acknowledge slot of a segment header. */
+static INT16 queue_ack(UINT8 Segment, UINT8 Slot, UINT16 Value);
+
+/* Move Tail past the segments sent completely and the records that are not valid. */
+static void queue_advance(void);
+
+/* Sender of the benchmark: every batch is delivered at once. */
+static INT16 queue_bench_sender(const struct struct_queue_batch *Batch, void *Context);
+
+/* Check the record at an offset of a segment and return its length. */
+static INT16 queue_check(UINT8 Segment, UINT16 Offset);
+
+/* Discard the records of the oldest segment to make room. */
+static void queue_drop(void);
+
+/* Open the next segment of the ring for writing. */
+static INT16 queue_open(void);
+
+/* Program data in the queue and count the flash pages. */
+static INT16 queue_program(UINT32 Offset, const UINT8 *Data, UINT16 Length);
+
+/* Return the offset where sending resumes in a segment. */
+static UINT16 queue_resume(UINT8 Segment, UINT8 *Slot);
+
+/* Append bytes to Head through the page buffer. */
+static INT16 queue_write(const UINT8 *Data, UINT16 Length);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_ack(). */
+/* ============================================================================================================================================================= *\
+                       Write an acknowledge slot of a segment header: offset where sending resumes, or QUEUE_ACK_DRAINED in the last slot.
+\* ============================================================================================================================================================= */
+static INT16 queue_ack(UINT8 Segment, UINT8 Slot, UINT16 Value)
+{
+  UINT8 Data[2];
+
+
+  Data[0] = (UINT8)Value;
+  Data[1] = (UINT8)(Value >> 8);
+  if (queue_program((Segment * QUEUE_SECTOR_SIZE) + QUEUE_ACK_OFFSET + (Slot * 2), Data, sizeof(Data)) != 0)
+  {
+    ++Queue.Stats.Errors;
+    return -1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_advance(). */
+/* ============================================================================================================================================================= *\
+                 Move Tail past the segments that have been sent completely (they are marked as drained) and past the records that are not valid.
+            A record that fails its check ends its segment: the bytes that follow can not be trusted. Records buffered in RAM must have been flushed.
+\* ============================================================================================================================================================= */
+static void queue_advance(void)
+{
+  INT16 Length;
+
+
+  while (Queue.Tail != QUEUE_NO_SEGMENT)
+  {
+    if ((Queue.Tail == Queue.Head) && (Queue.TailOffset >= Queue.HeadOffset)) break;
+
+    Length = queue_check(Queue.Tail, Queue.TailOffset);
+    if (Length > 0) return;
+    if (Length < 0) ++Queue.Stats.Corrupted;
+
+    if (Queue.Tail == Queue.Head)
+    {
+      Queue.TailOffset = Queue.HeadOffset;
+      break;
+    }
+
+    queue_ack(Queue.Tail, QUEUE_ACK_SLOTS - 1, QUEUE_ACK_DRAINED);
+    Queue.Tail       = QUEUE_NEXT(Queue.Tail);
+    Queue.TailOffset = queue_resume(Queue.Tail, &Queue.TailAck);
+  }
+
+  /* Nothing left to send: counters can not drift, even if records have been lost. */
+  Queue.Stats.PendingRecords = 0;
+  Queue.Stats.PendingBytes   = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_bench_sender(). */
+/* ============================================================================================================================================================= *\
+                             Sender of the benchmark: every batch is delivered at once. The records are read, as a real sender would.
+\* ============================================================================================================================================================= */
+static INT16 queue_bench_sender(const struct struct_queue_batch *Batch, void *Context)
+{
+  UINT16 Loop1UInt16;
+
+  UINT32 Sum;
+
+
+  Sum = 0;
+  for (Loop1UInt16 = 0; Loop1UInt16 < Batch->Count; ++Loop1UInt16)
+    Sum += wifi_flash_crc16(0xFFFF, Batch->Data[Loop1UInt16], Batch->Length[Loop1UInt16]);
+  *(UINT32 *)Context += Sum;
+
+  wifi_queue_done(0);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_check(). */
+/* ============================================================================================================================================================= *\
+                  Check the record at an offset of a segment. Return its length, 0 at free space (or end of segment), or -1 if it is not valid.
+\* ============================================================================================================================================================= */
+static INT16 queue_check(UINT8 Segment, UINT16 Offset)
+{
+  UINT16 Length;
+
+  const UINT8 *Record;
+
+
+  if ((Offset + QUEUE_RECORD_OVERHEAD) > QUEUE_SECTOR_SIZE) return 0;
+
+  Record = QUEUE_FLASH_DATA((Segment * QUEUE_SECTOR_SIZE) + Offset);
+  if (Record[0] == 0xFF) return 0;
+
+  Length = (UINT16)Record[1] | ((UINT16)Record[2] << 8);
+  if ((Record[0] != QUEUE_RECORD_MAGIC) || (Length == 0) || (Length > QUEUE_MAX_RECORD) || ((Offset + QUEUE_RECORD_SIZE(Length)) > QUEUE_SECTOR_SIZE) ||
+      (wifi_flash_crc16(0xFFFF, Record, Length + 3) != ((UINT16)Record[Length + 3] | ((UINT16)Record[Length + 4] << 8))))
+    return -1;
+
+  return (INT16)Length;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_drop(). */
+/* ============================================================================================================================================================= *\
+                           Discard the records of the oldest segment, so that the writer may erase it. Tail moves to the next segment.
+\* ============================================================================================================================================================= */
+static void queue_drop(void)
+{
+  INT16 Length;
+
+  UINT16 Offset;
+
+
+  for (Offset = Queue.TailOffset; (Length = queue_check(Queue.Tail, Offset)) > 0; Offset += QUEUE_RECORD_SIZE(Length))
+  {
+    ++Queue.Stats.Dropped;
+    if (Queue.Stats.PendingRecords) --Queue.Stats.PendingRecords;
+    Queue.Stats.PendingBytes -= (Queue.Stats.PendingBytes < Length) ? Queue.Stats.PendingBytes : Length;
+  }
+
+  Queue.Tail       = QUEUE_NEXT(Queue.Tail);
+  Queue.TailOffset = queue_resume(Queue.Tail, &Queue.TailAck);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_open(). */
+/* ============================================================================================================================================================= *\
+             Open the next segment of the ring for writing: the records buffered in RAM are programmed, the segment is erased and its header written.
+            When the ring is full, the records of the oldest segment are discarded first, unless they are being sent (the new record is then refused).
+\* ============================================================================================================================================================= */
+static INT16 queue_open(void)
+{
+  UINT8 Header[QUEUE_ACK_OFFSET];
+  UINT8 Next;
+
+  UINT32 Sequence;
+
+
+  wifi_queue_flush();
+
+  Next = (Queue.Head == QUEUE_NO_SEGMENT) ? 0 : QUEUE_NEXT(Queue.Head);
+  if ((Queue.Head != QUEUE_NO_SEGMENT) && (Next == Queue.Tail))
+  {
+    if (Queue.FlagInFlight) return -1;
+    queue_drop();
+  }
+
+  wifi_flash_erase(&QueueFlash, Next * QUEUE_SECTOR_SIZE);
+  ++Queue.Stats.Erases;
+
+  Sequence = Queue.Sequence + 1;
+  memset(Header, 0xFF, sizeof(Header));
+  wifi_flash_header(Header, QUEUE_MAGIC, Sequence);
+  if (queue_program(Next * QUEUE_SECTOR_SIZE, Header, sizeof(Header)) != 0)
+  {
+    ++Queue.Stats.Errors;
+    return -1;
+  }
+
+  if (Queue.Head == QUEUE_NO_SEGMENT)
+  {
+    Queue.Tail       = Next;
+    Queue.TailOffset = QUEUE_HEADER_SIZE;
+    Queue.TailAck    = 0;
+  }
+  Queue.Head       = Next;
+  Queue.HeadOffset = QUEUE_HEADER_SIZE;
+  Queue.Sequence   = Sequence;
+  Queue.PageBase   = QUEUE_HEADER_SIZE & ~(QUEUE_PAGE_SIZE - 1);
+  Queue.PageFrom   = QUEUE_HEADER_SIZE;
+  memset(Queue.Page, 0xFF, sizeof(Queue.Page));
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_program(). */
+/* ============================================================================================================================================================= *\
+           Program data at Offset of the queue region, then verify it (see wifi_flash_program()). Flash pages programmed are counted for the statistics
+                                                and the benchmark. Return -1 if flash does not read back as Data.
+\* ============================================================================================================================================================= */
+static INT16 queue_program(UINT32 Offset, const UINT8 *Data, UINT16 Length)
+{
+  if (Length == 0) return 0;
+
+  Queue.Stats.Programs += ((Offset + Length - 1) / QUEUE_PAGE_SIZE) - (Offset / QUEUE_PAGE_SIZE) + 1;
+
+  return wifi_flash_program(&QueueFlash, Offset, Data, Length);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_resume(). */
+/* ============================================================================================================================================================= *\
+             Return the offset where sending resumes in a segment (last acknowledge slot written, or first record), QUEUE_ACK_DRAINED if the segment
+                                      has been sent completely. Slot receives the number of the next free acknowledge slot.
+\* ============================================================================================================================================================= */
+static UINT16 queue_resume(UINT8 Segment, UINT8 *Slot)
+{
+  UINT8 Loop1UInt8;
+
+  UINT16 Offset;
+  UINT16 Value;
+
+  const UINT8 *Header;
+
+
+  Header = QUEUE_FLASH_DATA(Segment * QUEUE_SECTOR_SIZE);
+  *Slot  = QUEUE_ACK_SLOTS - 1;
+
+  Value = (UINT16)Header[QUEUE_ACK_OFFSET + ((QUEUE_ACK_SLOTS - 1) * 2)] | ((UINT16)Header[QUEUE_ACK_OFFSET + ((QUEUE_ACK_SLOTS - 1) * 2) + 1] << 8);
+  if (Value == QUEUE_ACK_DRAINED) return QUEUE_ACK_DRAINED;
+
+  Offset = QUEUE_HEADER_SIZE;
+  for (Loop1UInt8 = 0; Loop1UInt8 < (QUEUE_ACK_SLOTS - 1); ++Loop1UInt8)
+  {
+    Value = (UINT16)Header[QUEUE_ACK_OFFSET + (Loop1UInt8 * 2)] | ((UINT16)Header[QUEUE_ACK_OFFSET + (Loop1UInt8 * 2) + 1] << 8);
+    if (Value == 0xFFFF)
+    {
+      *Slot = Loop1UInt8;
+      break;
+    }
+
+    /* A slot that does not hold a record boundary has been cut short by a power loss: the previous one stands. */
+    if ((Value >= Offset) && (Value <= QUEUE_SECTOR_SIZE) && ((Value & 3) == 0)) Offset = Value;
+  }
+
+  return Offset;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=queue_write(). */
+/* ============================================================================================================================================================= *\
+           Append bytes to Head through the page buffer. A page is programmed as soon as it is full. Return -1 in case of flash error: the rest of Head
+                          is then given up, so that the next record goes to a fresh segment (the record cut short fails its CRC check).
+\* ============================================================================================================================================================= */
+static INT16 queue_write(const UINT8 *Data, UINT16 Length)
+{
+  UINT16 Chunk;
+
+
+  while (Length > 0)
+  {
+    Chunk = Queue.PageBase + QUEUE_PAGE_SIZE - Queue.HeadOffset;
+    if (Chunk > Length) Chunk = Length;
+
+    memcpy(&Queue.Page[Queue.HeadOffset - Queue.PageBase], Data, Chunk);
+    Queue.HeadOffset += Chunk;
+    Data             += Chunk;
+    Length           -= Chunk;
+
+    if (Queue.HeadOffset == (Queue.PageBase + QUEUE_PAGE_SIZE))
+      if (wifi_queue_flush() != 0) return -1;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_bench(). */
+/* ============================================================================================================================================================= *\
+            Enqueue and drain benchmark: Records records of Length bytes are pushed and flushed, then drained without rate limit through a sender that
+           delivers every batch at once. Time, flash page programs and sector erases of both phases are displayed (on a host, with the flash time they
+                     would take on the PicoW). The records waiting to be sent are discarded first, and the ones of the benchmark at the end.
+\* ============================================================================================================================================================= */
+void wifi_queue_bench(UINT32 Records, UINT16 Length)
+{
+  UINT8 Data[QUEUE_MAX_RECORD];
+  UINT8 FlagDraining;
+
+  UINT32 Batches;
+  UINT32 Dropped;
+  UINT32 Erases;
+  UINT32 Loop1UInt32;
+  UINT32 Programs;
+  UINT32 Pushed;
+  UINT32 Sent;
+  UINT32 Sum;
+
+  UINT64 DrainUs;
+  UINT64 EnqueueUs;
+  UINT64 StartTime;
+
+  void  *Context;
+
+  queue_sender Sender;
+
+
+  if ((Queue.FlagInit == FLAG_OFF) || Queue.FlagInFlight || (Records == 0) || (Length == 0) || (Length > QUEUE_MAX_RECORD))
+  {
+    log_info(__LINE__, __func__, "Benchmark not run (queue not loaded, batch in flight, or invalid record length).\r");
+    return;
+  }
+
+  FlagDraining = Queue.FlagDraining;
+  Sender       = Queue.Sender;
+  Context      = Queue.Context;
+  wifi_queue_clear();
+
+  /* Enqueue. */
+  for (Loop1UInt32 = 0; Loop1UInt32 < Length; ++Loop1UInt32)
+    Data[Loop1UInt32] = (UINT8)('A' + (Loop1UInt32 % 26));
+  Programs  = Queue.Stats.Programs;
+  Erases    = Queue.Stats.Erases;
+  Dropped   = Queue.Stats.Dropped;
+  Pushed    = 0;
+  StartTime = wifi_flash_time_us();
+  for (Loop1UInt32 = 0; Loop1UInt32 < Records; ++Loop1UInt32)
+  {
+    memcpy(Data, &Loop1UInt32, sizeof(Loop1UInt32) < Length ? sizeof(Loop1UInt32) : Length);
+    if (wifi_queue_push(Data, Length) != 0) break;
+    ++Pushed;
+  }
+  wifi_queue_flush();
+  EnqueueUs = wifi_flash_time_us() - StartTime;
+  Programs  = Queue.Stats.Programs - Programs;
+  Erases    = Queue.Stats.Erases   - Erases;
+  Dropped   = Queue.Stats.Dropped  - Dropped;
+
+  log_info(__LINE__, __func__, "Enqueue: %lu records of %u bytes in %llu usec: %llu records/sec, %llu kbytes/sec.\r", Pushed, Length, EnqueueUs,
+           (Pushed * 1000000ull) / (EnqueueUs ? EnqueueUs : 1), ((UINT64)Pushed * Length * 1000ull) / (EnqueueUs ? EnqueueUs : 1));
+  log_info(__LINE__, __func__, "         %lu page programs, %lu sector erases, %lu oldest records dropped (ring holds about %lu records).\r", Programs, Erases,
+           Dropped, (UINT32)(QUEUE_SECTORS - 1) * ((QUEUE_SECTOR_SIZE - QUEUE_HEADER_SIZE) / QUEUE_RECORD_SIZE(Length)));
+#if PICO_ON_DEVICE == 0
+  log_info(__LINE__, __func__, "         Flash time on the PicoW: about %llu msec (%u usec per page program, %u usec per sector erase).\r",
+           (((UINT64)Programs * QUEUE_SIM_PROGRAM_USEC) + ((UINT64)Erases * QUEUE_SIM_ERASE_USEC)) / 1000, QUEUE_SIM_PROGRAM_USEC, QUEUE_SIM_ERASE_USEC);
+#endif  // PICO_ON_DEVICE
+
+  /* Drain. */
+  Programs = Queue.Stats.Programs;
+  Erases   = Queue.Stats.Erases;
+  Batches  = Queue.Stats.Batches;
+  Sent     = Queue.Stats.Sent;
+  Sum      = 0;
+  Queue.FlagUnlimited = FLAG_ON;
+  wifi_queue_start(queue_bench_sender, &Sum);
+  StartTime = wifi_flash_time_us();
+  while (Queue.Stats.PendingRecords && (wifi_queue_service() <= 1));
+  DrainUs  = wifi_flash_time_us() - StartTime;
+  Programs = Queue.Stats.Programs - Programs;
+  Erases   = Queue.Stats.Erases   - Erases;
+  Batches  = Queue.Stats.Batches  - Batches;
+  Sent     = Queue.Stats.Sent     - Sent;
+  Queue.FlagUnlimited = FLAG_OFF;
+
+  log_info(__LINE__, __func__, "Drain:   %lu records in %lu batches in %llu usec: %llu records/sec, %llu kbytes/sec.\r", Sent, Batches, DrainUs,
+           (Sent * 1000000ull) / (DrainUs ? DrainUs : 1), ((UINT64)Sent * Length * 1000ull) / (DrainUs ? DrainUs : 1));
+  log_info(__LINE__, __func__, "         %lu acknowledge writes (page programs), %lu sector erases, CRC of records read: %4.4lX.\r", Programs, Erases, Sum & 0xFFFF);
+#if PICO_ON_DEVICE == 0
+  log_info(__LINE__, __func__, "         Flash time on the PicoW: about %llu msec.\r", (((UINT64)Programs * QUEUE_SIM_PROGRAM_USEC) + ((UINT64)Erases * QUEUE_SIM_ERASE_USEC)) / 1000);
+#endif  // PICO_ON_DEVICE
+
+  /* Back to the application's sender. */
+  wifi_queue_clear();
+  if (FlagDraining)
+    wifi_queue_start(Sender, Context);
+  else
+    wifi_queue_stop();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_clear(). */
+/* ============================================================================================================================================================= *\
+           Discard all records waiting to be sent. Nothing is erased: the segments are marked as drained (the one being written keeps receiving records
+                        after the position reached), so that rotation and generation numbers go on. Return -1 while a batch is in flight.
+\* ============================================================================================================================================================= */
+INT16 wifi_queue_clear(void)
+{
+  if ((Queue.FlagInit == FLAG_OFF) || Queue.FlagInFlight) return -1;
+  if (Queue.Head == QUEUE_NO_SEGMENT) return 0;
+
+  wifi_queue_flush();
+
+  while (Queue.Tail != Queue.Head)
+  {
+    queue_ack(Queue.Tail, QUEUE_ACK_SLOTS - 1, QUEUE_ACK_DRAINED);
+    Queue.Tail = QUEUE_NEXT(Queue.Tail);
+  }
+  queue_resume(Queue.Head, &Queue.TailAck);
+  Queue.TailOffset = Queue.HeadOffset;
+
+  /* No acknowledge slot left: Head is marked as drained and records written after this point go to a fresh segment. */
+  if (Queue.TailAck < (QUEUE_ACK_SLOTS - 1))
+  {
+    queue_ack(Queue.Head, Queue.TailAck++, Queue.HeadOffset);
+  }
+  else
+  {
+    queue_ack(Queue.Head, QUEUE_ACK_SLOTS - 1, QUEUE_ACK_DRAINED);
+    Queue.HeadOffset = QUEUE_SECTOR_SIZE;
+    Queue.PageFrom   = QUEUE_SECTOR_SIZE;
+    Queue.TailOffset = QUEUE_SECTOR_SIZE;
+  }
+
+  Queue.Stats.PendingRecords = 0;
+  Queue.Stats.PendingBytes   = 0;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                               Display telemetry queue statistics.
+\* ============================================================================================================================================================= */
+void wifi_queue_display_stats(void)
+{
+  struct struct_queue_stats Stats;
+
+
+  wifi_queue_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "==============================================================================\r");
+  log_info(__LINE__, __func__, "                    Telemetry queue (store-and-forward)\r");
+  log_info(__LINE__, __func__, "==============================================================================\r");
+  if (Queue.FlagInit == FLAG_OFF)
+  {
+    log_info(__LINE__, __func__, "Queue not loaded (see wifi_queue_init()).\r");
+    return;
+  }
+  log_info(__LINE__, __func__, "Flash:    %u segments of %u bytes   Generation: %lu (each segment erased about %lu times)\r", QUEUE_SECTORS, QUEUE_SECTOR_SIZE,
+           Stats.Sequence, Stats.Sequence / QUEUE_SECTORS);
+  log_info(__LINE__, __func__, "Pending:  %lu records (%lu bytes) in %u segments   Draining: %s   Batch in flight: %s\r", Stats.PendingRecords, Stats.PendingBytes,
+           Stats.Segments, (Stats.FlagDraining) ? "Yes" : "No", (Queue.FlagInFlight) ? "Yes" : "No");
+  log_info(__LINE__, __func__, "Pushed:   %lu records (%lu bytes)   Rejected: %lu   Dropped (ring full): %lu   Corrupted: %lu\r", Stats.Pushed, Stats.PushedBytes,
+           Stats.Rejected, Stats.Dropped, Stats.Corrupted);
+  log_info(__LINE__, __func__, "Sent:     %lu records (%lu bytes) in %lu batches   Failed batches: %lu   Longest batch: %lu usec\r", Stats.Sent, Stats.SentBytes,
+           Stats.Batches, Stats.BatchFailures, Stats.BatchMaxUsec);
+  log_info(__LINE__, __func__, "Flash:    %lu page programs   %lu sector erases   %lu errors   Loaded in %lu usec\r", Stats.Programs, Stats.Erases, Stats.Errors,
+           Stats.LoadUsec);
+  log_info(__LINE__, __func__, "Drain:    batches of up to %u records / %u bytes, at most %u bytes/sec\r", QUEUE_BATCH_RECORDS, QUEUE_BATCH_BYTES, QUEUE_DRAIN_RATE);
+  log_info(__LINE__, __func__, "==============================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_done(). */
+/* ============================================================================================================================================================= *\
+         Give the outcome of the batch being sent (0: delivered, the records are removed from the queue; any other value: the batch is sent again later).
+           May be called from any context (lwIP callback, interrupt), even before the sender returns: it is processed by the next wifi_queue_service().
+\* ============================================================================================================================================================= */
+void wifi_queue_done(INT16 Result)
+{
+  if (Queue.FlagInFlight) Queue.Result = (Result == 0) ? QUEUE_RESULT_OK : QUEUE_RESULT_FAILED;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_flush(). */
+/* ============================================================================================================================================================= *\
+             Program the records buffered in RAM (part of a flash page) to flash, so that they survive a power loss. Records are otherwise programmed
+                                                      one page at a time. Return -1 in case of flash error.
+\* ============================================================================================================================================================= */
+INT16 wifi_queue_flush(void)
+{
+  if ((Queue.Head == QUEUE_NO_SEGMENT) || (Queue.PageFrom >= Queue.HeadOffset)) return 0;
+
+  if (queue_program((Queue.Head * QUEUE_SECTOR_SIZE) + Queue.PageFrom, &Queue.Page[Queue.PageFrom - Queue.PageBase], Queue.HeadOffset - Queue.PageFrom) != 0)
+  {
+    ++Queue.Stats.Errors;
+    Queue.HeadOffset = QUEUE_SECTOR_SIZE;
+    Queue.PageFrom   = QUEUE_SECTOR_SIZE;
+    return -1;
+  }
+  Queue.PageFrom = Queue.HeadOffset;
+
+  /* Page complete: start the next one. */
+  if (Queue.HeadOffset == (Queue.PageBase + QUEUE_PAGE_SIZE))
+  {
+    Queue.PageBase += QUEUE_PAGE_SIZE;
+    memset(Queue.Page, 0xFF, sizeof(Queue.Page));
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                               Retrieve telemetry queue statistics.
+\* ============================================================================================================================================================= */
+void wifi_queue_get_stats(struct struct_queue_stats *Stats)
+{
+  *Stats = Queue.Stats;
+  Stats->FlagDraining = Queue.FlagDraining;
+  Stats->Sequence     = Queue.Sequence;
+  Stats->Segments     = 0;
+  if (Stats->PendingRecords) Stats->Segments = ((Queue.Head + QUEUE_SECTORS - Queue.Tail) % QUEUE_SECTORS) + 1;
+
+  return;
+}
+
+
+
+
+
+#if PICO_ON_DEVICE == 0
+/* $PAGE */
+/* $TITLE=wifi_queue_image(). */
+/* ============================================================================================================================================================= *\
+             Return the RAM image replacing flash on a host (QUEUE_SECTORS x QUEUE_SECTOR_SIZE bytes). A test may save it to a file and load it back,
+                             corrupt it or truncate a record to simulate a power loss, then call wifi_queue_init() again to "reboot".
+\* ============================================================================================================================================================= */
+UINT8 *wifi_queue_image(void)
+{
+  if (FlagImage == FLAG_OFF)
+  {
+    memset(QueueImage, 0xFF, sizeof(QueueImage));
+    FlagImage = FLAG_ON;
+  }
+
+  return QueueImage;
+}
+#endif  // PICO_ON_DEVICE
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_init(). */
+/* ============================================================================================================================================================= *\
+           Load the queue: the segment with the highest generation is the one being written, and its records are scanned to find free space. Going back
+        around the ring, the oldest segment not drained yet gives the next record to send (last acknowledge slot). Records waiting to be sent are counted.
+     Nothing is written to flash. Must be called once at start-up, before any other wifi_queue_xxx() function. Return -1 if the Firmware overlaps the queue.
+\* ============================================================================================================================================================= */
+INT16 wifi_queue_init(void)
+{
+  UINT8 Loop1UInt8;
+  UINT8 Segment;
+
+  INT16 Length;
+
+  UINT16 Offset;
+
+  UINT32 Sequence;
+  UINT32 TailSequence;
+
+  UINT64 StartTime;
+
+
+  StartTime = wifi_flash_time_us();
+
+#if PICO_ON_DEVICE
+  if (((UINT32)&__flash_binary_end - XIP_BASE) > QUEUE_FLASH_OFFSET)
+  {
+    log_info(__LINE__, __func__, "Firmware overlaps the telemetry queue (flash offset 0x%8.8X): reduce QUEUE_SECTORS.\r", QUEUE_FLASH_OFFSET);
+    return -1;
+  }
+#else   // PICO_ON_DEVICE
+  wifi_queue_image();
+#endif  // PICO_ON_DEVICE
+
+  memset(&Queue, 0x00, sizeof(Queue));
+  Queue.Head = QUEUE_NO_SEGMENT;
+  Queue.Tail = QUEUE_NO_SEGMENT;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < QUEUE_SECTORS; ++Loop1UInt8)
+  {
+    if (wifi_flash_header_valid(QUEUE_FLASH_DATA(Loop1UInt8 * QUEUE_SECTOR_SIZE), QUEUE_MAGIC, &Sequence) != 0) continue;
+
+    if ((Queue.Head == QUEUE_NO_SEGMENT) || (Sequence > Queue.Sequence))
+    {
+      Queue.Head     = Loop1UInt8;
+      Queue.Sequence = Sequence;
+    }
+  }
+
+  if (Queue.Head != QUEUE_NO_SEGMENT)
+  {
+    /* Free space of the segment being written. A record that is not valid ends it, as does the drained mark (wifi_queue_clear()):
+       the next record goes to a fresh segment. */
+    for (Offset = QUEUE_HEADER_SIZE; (Length = queue_check(Queue.Head, Offset)) > 0; Offset += QUEUE_RECORD_SIZE(Length));
+    Queue.HeadOffset = ((Length < 0) || (queue_resume(Queue.Head, &Queue.TailAck) == QUEUE_ACK_DRAINED)) ? QUEUE_SECTOR_SIZE : Offset;
+    Queue.PageBase   = Queue.HeadOffset & ~(QUEUE_PAGE_SIZE - 1);
+    Queue.PageFrom   = Queue.HeadOffset;
+    memset(Queue.Page, 0xFF, sizeof(Queue.Page));
+
+    /* Oldest segment not drained yet: previous generations, going back around the ring. */
+    Queue.Tail   = Queue.Head;
+    TailSequence = Queue.Sequence;
+    for (Loop1UInt8 = 1; Loop1UInt8 < QUEUE_SECTORS; ++Loop1UInt8)
+    {
+      Segment = (Queue.Tail + QUEUE_SECTORS - 1) % QUEUE_SECTORS;
+      if ((wifi_flash_header_valid(QUEUE_FLASH_DATA(Segment * QUEUE_SECTOR_SIZE), QUEUE_MAGIC, &Sequence) != 0) || (Sequence != (TailSequence - 1))) break;
+      if (queue_resume(Segment, &Queue.TailAck) == QUEUE_ACK_DRAINED) break;
+      Queue.Tail   = Segment;
+      TailSequence = Sequence;
+    }
+    Queue.TailOffset = queue_resume(Queue.Tail, &Queue.TailAck);
+    if ((Queue.Tail == Queue.Head) && (Queue.TailOffset > Queue.HeadOffset)) Queue.TailOffset = Queue.HeadOffset;
+
+    /* Records waiting to be sent. */
+    Segment = Queue.Tail;
+    Offset  = Queue.TailOffset;
+    while ((Segment != Queue.Head) || (Offset < Queue.HeadOffset))
+    {
+      Length = queue_check(Segment, Offset);
+      if (Length > 0)
+      {
+        ++Queue.Stats.PendingRecords;
+        Queue.Stats.PendingBytes += Length;
+        Offset += QUEUE_RECORD_SIZE(Length);
+        continue;
+      }
+      if (Segment == Queue.Head) break;
+      Segment = QUEUE_NEXT(Segment);
+      Offset  = QUEUE_HEADER_SIZE;
+    }
+  }
+
+  Queue.RetryMsec      = QUEUE_RETRY_MSEC;
+  Queue.FlagInit       = FLAG_ON;
+  Queue.Stats.LoadUsec = (UINT32)(wifi_flash_time_us() - StartTime);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_push(). */
+/* ============================================================================================================================================================= *\
+           Append a record to the queue (it goes to flash with the page, or at the next wifi_queue_flush()). When the ring is full, the oldest records
+     are discarded. Return -1 if Length is 0 or above QUEUE_MAX_RECORD, in case of flash error, or if the ring is full and its oldest segment is being sent.
+\* ============================================================================================================================================================= */
+INT16 wifi_queue_push(const void *Data, UINT16 Length)
+{
+  UINT8 Record[3];
+  UINT8 Trailer[5];
+
+  UINT16 Crc;
+
+
+  if ((Queue.FlagInit == FLAG_OFF) || (Length == 0) || (Length > QUEUE_MAX_RECORD))
+  {
+    ++Queue.Stats.Rejected;
+    return -1;
+  }
+
+  if ((Queue.Head == QUEUE_NO_SEGMENT) || ((Queue.HeadOffset + QUEUE_RECORD_SIZE(Length)) > QUEUE_SECTOR_SIZE))
+  {
+    if (queue_open() != 0)
+    {
+      ++Queue.Stats.Rejected;
+      return -1;
+    }
+  }
+
+  /* Magic, Length, Data, CRC-16 of all previous bytes, 0xFF up to the next 4-byte boundary. */
+  Record[0] = QUEUE_RECORD_MAGIC;
+  Record[1] = (UINT8)Length;
+  Record[2] = (UINT8)(Length >> 8);
+  Crc = wifi_flash_crc16(0xFFFF, Record, sizeof(Record));
+  Crc = wifi_flash_crc16(Crc, Data, Length);
+  memset(Trailer, 0xFF, sizeof(Trailer));
+  Trailer[0] = (UINT8)Crc;
+  Trailer[1] = (UINT8)(Crc >> 8);
+
+  if ((queue_write(Record, sizeof(Record)) != 0) || (queue_write(Data, Length) != 0) ||
+      (queue_write(Trailer, QUEUE_RECORD_SIZE(Length) - Length - sizeof(Record)) != 0))
+  {
+    ++Queue.Stats.Rejected;
+    return -1;
+  }
+
+  ++Queue.Stats.Pushed;
+  ++Queue.Stats.PendingRecords;
+  Queue.Stats.PushedBytes  += Length;
+  Queue.Stats.PendingBytes += Length;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_service(). */
+/* ============================================================================================================================================================= *\
+               Process the outcome of the batch in flight, then hand the next batch to the sender when draining is on and the rate limit allows it.
+             Must be called by the application after wifi_queue_start(), after wifi_queue_done(), and after the delay it returns (msec); 0 means that
+                                  nothing is due before one of those happens (queue empty, draining stopped or batch in flight).
+\* ============================================================================================================================================================= */
+UINT32 wifi_queue_service(void)
+{
+  INT16 Length;
+
+  UINT8  Segment;
+
+  UINT16 Offset;
+
+  UINT32 Need;
+  UINT32 Tokens;
+
+  UINT64 Now;
+
+
+  if (Queue.FlagInit == FLAG_OFF) return 0;
+
+  Now = wifi_flash_time_us();
+
+  /* Outcome of the batch in flight. */
+  if (Queue.FlagInFlight && (Queue.Result != QUEUE_RESULT_NONE))
+  {
+    if ((Now - Queue.BatchTime) > Queue.Stats.BatchMaxUsec) Queue.Stats.BatchMaxUsec = (UINT32)(Now - Queue.BatchTime);
+
+    if (Queue.Result == QUEUE_RESULT_OK)
+    {
+      ++Queue.Stats.Batches;
+      Queue.Stats.Sent      += Queue.Batch.Count;
+      Queue.Stats.SentBytes += Queue.Batch.Bytes;
+      Queue.Stats.PendingRecords -= (Queue.Stats.PendingRecords < Queue.Batch.Count) ? Queue.Stats.PendingRecords : Queue.Batch.Count;
+      Queue.Stats.PendingBytes   -= (Queue.Stats.PendingBytes   < Queue.Batch.Bytes) ? Queue.Stats.PendingBytes   : Queue.Batch.Bytes;
+
+      /* Segments sent completely are marked as drained, then the position reached is saved. */
+      while (Queue.Tail != Queue.BatchEnd)
+      {
+        queue_ack(Queue.Tail, QUEUE_ACK_SLOTS - 1, QUEUE_ACK_DRAINED);
+        Queue.Tail    = QUEUE_NEXT(Queue.Tail);
+        Queue.TailAck = 0;
+      }
+      Queue.TailOffset = Queue.BatchEndOffset;
+      if (Queue.TailAck < (QUEUE_ACK_SLOTS - 1)) queue_ack(Queue.Tail, Queue.TailAck++, Queue.TailOffset);
+      Queue.RetryMsec = QUEUE_RETRY_MSEC;
+    }
+    else
+    {
+      ++Queue.Stats.BatchFailures;
+      Queue.RetryTime = Now + (Queue.RetryMsec * 1000ull);
+      Queue.RetryMsec = (Queue.RetryMsec * 2 > QUEUE_RETRY_MAX_MSEC) ? QUEUE_RETRY_MAX_MSEC : Queue.RetryMsec * 2;
+    }
+
+    Queue.Result       = QUEUE_RESULT_NONE;
+    Queue.FlagInFlight = FLAG_OFF;
+  }
+
+  if ((Queue.FlagDraining == FLAG_OFF) || Queue.FlagInFlight || (Queue.Stats.PendingRecords == 0)) return 0;
+  if (Now < Queue.RetryTime) return (UINT32)((Queue.RetryTime - Now) / 1000) + 1;
+
+  /* Rate limit: token bucket holding at most one batch. Time is only consumed for whole bytes, so that no credit is lost to rounding. */
+  if (Queue.FlagUnlimited == FLAG_OFF)
+  {
+    Tokens = (UINT32)(((Now - Queue.TokenTime) * QUEUE_DRAIN_RATE) / 1000000ull);
+    if ((Queue.Tokens + Tokens) >= QUEUE_BATCH_BYTES)
+    {
+      Queue.Tokens    = QUEUE_BATCH_BYTES;
+      Queue.TokenTime = Now;
+    }
+    else
+    {
+      Queue.Tokens    += Tokens;
+      Queue.TokenTime += ((UINT64)Tokens * 1000000ull) / QUEUE_DRAIN_RATE;
+    }
+
+    Need = (Queue.Stats.PendingBytes < QUEUE_BATCH_BYTES) ? Queue.Stats.PendingBytes : QUEUE_BATCH_BYTES;
+    if (Queue.Tokens < Need) return (((Need - Queue.Tokens) * 1000) / QUEUE_DRAIN_RATE) + 1;
+  }
+
+  /* Batch read in place from flash. */
+  if (wifi_queue_flush() != 0) return QUEUE_RETRY_MSEC;
+  queue_advance();
+
+  Queue.Batch.Count = 0;
+  Queue.Batch.Bytes = 0;
+  Segment = Queue.Tail;
+  Offset  = Queue.TailOffset;
+  while ((Queue.Batch.Count < QUEUE_BATCH_RECORDS) && (Segment != QUEUE_NO_SEGMENT))
+  {
+    if ((Segment == Queue.Head) && (Offset >= Queue.HeadOffset)) break;
+
+    Length = queue_check(Segment, Offset);
+    if (Length < 0) break;  // skipped by queue_advance() once it is at Tail.
+    if (Length == 0)
+    {
+      if (Segment == Queue.Head) break;
+      Segment = QUEUE_NEXT(Segment);
+      Offset  = QUEUE_HEADER_SIZE;
+      continue;
+    }
+
+    if ((Queue.Batch.Count > 0) && ((Queue.Batch.Bytes + Length) > QUEUE_BATCH_BYTES)) break;
+    Queue.Batch.Data[Queue.Batch.Count]   = QUEUE_FLASH_DATA((Segment * QUEUE_SECTOR_SIZE) + Offset + 3);
+    Queue.Batch.Length[Queue.Batch.Count] = Length;
+    ++Queue.Batch.Count;
+    Queue.Batch.Bytes += Length;
+    Offset += QUEUE_RECORD_SIZE(Length);
+  }
+  if (Queue.Batch.Count == 0) return 0;
+
+  Queue.BatchEnd       = Segment;
+  Queue.BatchEndOffset = Offset;
+  Queue.Tokens        -= (Queue.Tokens < Queue.Batch.Bytes) ? Queue.Tokens : Queue.Batch.Bytes;
+  Queue.BatchTime      = Now;
+  Queue.Result         = QUEUE_RESULT_NONE;
+  Queue.FlagInFlight   = FLAG_ON;
+
+  if (Queue.Sender(&Queue.Batch, Queue.Context) != 0)
+  {
+    Queue.FlagInFlight = FLAG_OFF;
+    ++Queue.Stats.BatchFailures;
+    Queue.RetryTime = Now + (QUEUE_RETRY_MSEC * 1000ull);
+    return QUEUE_RETRY_MSEC;
+  }
+
+  /* The sender may already have given the outcome. */
+  return (Queue.Result != QUEUE_RESULT_NONE) ? 1 : 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_start(). */
+/* ============================================================================================================================================================= *\
+                   Start draining the queue through a sender (link is up). The first batch may go at once, the next ones follow the rate limit.
+\* ============================================================================================================================================================= */
+void wifi_queue_start(queue_sender Sender, void *Context)
+{
+  if (Sender == NULL) return;
+
+  Queue.Sender       = Sender;
+  Queue.Context      = Context;
+  Queue.Tokens       = QUEUE_BATCH_BYTES;
+  Queue.TokenTime    = wifi_flash_time_us();
+  Queue.RetryTime    = 0;
+  Queue.RetryMsec    = QUEUE_RETRY_MSEC;
+  Queue.FlagDraining = FLAG_ON;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_queue_stop(). */
+/* ============================================================================================================================================================= *\
+                           Stop draining the queue (link is down). A batch in flight still gets its outcome through wifi_queue_done().
+\* ============================================================================================================================================================= */
+void wifi_queue_stop(void)
+{
+  Queue.FlagDraining = FLAG_OFF;
+
+  return;
+}
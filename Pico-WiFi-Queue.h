@@ -0,0 +1,119 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Queue.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Queue.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_QUEUE_H
+#define _WIFI_QUEUE_H
+
+#include "baseline.h"
+#include "Pico-WiFi-Flash.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#ifndef QUEUE_SECTORS
+#define QUEUE_SECTORS                   32     // flash sectors (segments) reserved just below the configuration store, used in turn.
+#endif  // QUEUE_SECTORS
+#define QUEUE_SECTOR_SIZE   WIFI_FLASH_SECTOR_SIZE
+#define QUEUE_PAGE_SIZE     WIFI_FLASH_PAGE_SIZE
+#define QUEUE_MAX_RECORD              1024     // longest record, in bytes.
+#define QUEUE_BATCH_RECORDS             32     // most records handed to the sender at once.
+#ifndef QUEUE_BATCH_BYTES
+#define QUEUE_BATCH_BYTES             4096     // most payload bytes handed to the sender at once (a longer single record is sent alone).
+#endif  // QUEUE_BATCH_BYTES
+#ifndef QUEUE_DRAIN_RATE
+#define QUEUE_DRAIN_RATE              8192     // payload bytes per second drained at most, so that live traffic is not starved.
+#endif  // QUEUE_DRAIN_RATE
+#define QUEUE_RETRY_MSEC              2000     // delay before a failed batch is sent again (doubled up to QUEUE_RETRY_MAX_MSEC).
+#define QUEUE_RETRY_MAX_MSEC         60000
+
+
+/* Batch of records handed to the sender (see wifi_queue_start()). Records are read in place from flash
+   and remain valid until the result of the batch has been given to wifi_queue_done(). */
+struct struct_queue_batch
+{
+  UINT16 Count;
+  UINT32 Bytes;                                // payload bytes of all records.
+  const UINT8 *Data[QUEUE_BATCH_RECORDS];
+  UINT16 Length[QUEUE_BATCH_RECORDS];
+};
+
+
+/* Sender of the application. Starts sending a batch and returns 0, or returns -1 if it can not be sent now (it is tried again after
+   QUEUE_RETRY_MSEC). The outcome must then be given to wifi_queue_done(), from any context, possibly before the sender returns. */
+typedef INT16 (*queue_sender)(const struct struct_queue_batch *Batch, void *Context);
+
+
+/* Telemetry queue statistics. */
+struct struct_queue_stats
+{
+  UINT8  FlagDraining;                         // link is up, records are sent (see wifi_queue_start()).
+  UINT8  Segments;                             // segments holding records waiting to be sent.
+  UINT32 Sequence;                             // generation of the segment being written (segments opened since the region was first used).
+  UINT32 PendingRecords;                       // records waiting to be sent.
+  UINT32 PendingBytes;                         // their payload bytes.
+  UINT32 Pushed;
+  UINT32 PushedBytes;
+  UINT32 Rejected;                             // invalid length, flash error, or queue full while its oldest segment is being sent.
+  UINT32 Dropped;                              // oldest records discarded to make room.
+  UINT32 Corrupted;                            // records failing their CRC check (skipped).
+  UINT32 Batches;                              // batches acknowledged.
+  UINT32 BatchFailures;
+  UINT32 Sent;                                 // records acknowledged.
+  UINT32 SentBytes;
+  UINT32 BatchMaxUsec;                         // longest time from sender call to wifi_queue_done().
+  UINT32 Programs;                             // flash pages programmed.
+  UINT32 Erases;                               // flash sectors erased.
+  UINT32 Errors;                               // flash verify failures.
+  UINT32 LoadUsec;                             // duration of wifi_queue_init().
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Enqueue and drain benchmark (the records waiting to be sent are lost). */
+void wifi_queue_bench(UINT32 Records, UINT16 Length);
+
+/* Discard all records waiting to be sent. */
+INT16 wifi_queue_clear(void);
+
+/* Display telemetry queue statistics. */
+void wifi_queue_display_stats(void);
+
+/* Give the outcome of the batch being sent (0: delivered). */
+void wifi_queue_done(INT16 Result);
+
+/* Program the records buffered in RAM to flash. */
+INT16 wifi_queue_flush(void);
+
+/* Retrieve telemetry queue statistics. */
+void wifi_queue_get_stats(struct struct_queue_stats *Stats);
+
+#if PICO_ON_DEVICE == 0
+/* Return the RAM image replacing flash on a host. */
+UINT8 *wifi_queue_image(void);
+#endif  // PICO_ON_DEVICE
+
+/* Load the queue from flash. */
+INT16 wifi_queue_init(void);
+
+/* Append a record to the queue. */
+INT16 wifi_queue_push(const void *Data, UINT16 Length);
+
+/* Send the next batch when the rate limit allows it. Return the delay before it should be called again (msec, 0: when something changes). */
+UINT32 wifi_queue_service(void);
+
+/* Start draining the queue through a sender (link is up). */
+void wifi_queue_start(queue_sender Sender, void *Context);
+
+/* Stop draining the queue (link is down). */
+void wifi_queue_stop(void);
+
+#endif  // _WIFI_QUEUE_H
@@ -0,0 +1,744 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-SNTP.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   SNTP client and disciplined software clock built on the lwIP raw API, part of Pico-WiFi-Module.
+   - Fast first synchronization: up to SNTP_MAX_SERVERS servers are queried in parallel, SNTP_FIRST_ROUNDS times each, 50 msec apart.
+     The reply with the lowest round-trip delay is retained, as it is the one least affected by queuing in the network.
+     The synchronization completes as soon as all replies are in, typically well under a second.
+   - Software clock: UTC is computed from time_us_64() and a reference point (local time, UTC) set at each synchronization.
+     It does not depend on Wi-Fi: once set, the time remains available across link drops and reconnections.
+   - Drift compensation: at each re-synchronization, the residual offset of the clock divided by the time elapsed since the
+     previous one gives the frequency error of the Pico's crystal. The correction is applied continuously to the clock,
+     so that the re-synchronization interval may be doubled (up to SNTP_MAX_INTERVAL_SEC) while the clock stays within SNTP_STEADY_USEC.
+   Each query carries the local send time in its transmit time stamp; servers echo it back, which both identifies the reply and
+   gives its send time without any table look-up by address.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - Resolve server names through the DNS cache of Pico-WiFi-DNS.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+#include "time.h"
+
+#include "lwip/netif.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-DNS.h"
+#include "Pico-WiFi-SNTP.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define SNTP_PACKET_SIZE         48
+#define SNTP_MAX_REQUESTS        (SNTP_MAX_SERVERS * SNTP_FIRST_ROUNDS)
+#define SNTP_UNIX_OFFSET         2208988800ull      // seconds between 1900-01-01 (NTP era 0) and 1970-01-01.
+
+
+static struct
+{
+  UINT8  State;
+  UINT8  ServerCount;
+  UINT8  Round;                             // rounds of queries sent in current synchronization.
+  UINT8  RoundCount;                        // rounds of queries to send in current synchronization.
+  UINT8  RequestCount;
+  UINT8  FlagSynced;
+  UINT8  FlagDriftKnown;                    // drift has been estimated at least once.
+  UINT8  FlagResolved[SNTP_MAX_SERVERS];
+  volatile UINT32 Sequence;                 // odd while the clock reference is being updated.
+  INT32  DriftPpb;
+  UINT64 RefLocal;                          // time_us_64() at the clock reference point.
+  UINT64 RefUnix;                           // UTC (usec since 1970-01-01) at the clock reference point.
+  UINT64 LastCookie;
+  UINT64 StateTime;                         // time stamp of the last state change.
+  ip_addr_t Address[SNTP_MAX_SERVERS];
+  const UCHAR *Server[SNTP_MAX_SERVERS];
+  struct
+  {
+    UINT64 T1;                              // local send time (also used as cookie).
+    UINT64 T2;                              // server receive time (UTC).
+    UINT64 T3;                              // server transmit time (UTC).
+    UINT64 T4;                              // local receive time.
+    UINT8  Server;
+    UINT8  FlagReply;
+  } Request[SNTP_MAX_REQUESTS];
+  struct struct_sntp_stats Stats;
+  struct udp_pcb *UdpPcb;
+} Sntp;
+
+static const UCHAR *const MonthName[12] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Convert a local time stamp to UTC with the disciplined clock. */
+static UINT64 sntp_clock(UINT64 LocalUs);
+
+/* Server name has been resolved. */
+static void sntp_dns_found(const char *Name, const ip_addr_t *Address, void *Arg);
+
+/* Retain the best sample and discipline the clock. */
+static void sntp_evaluate(void);
+
+/* Convert an NTP time stamp to UTC usec since 1970. */
+static UINT64 sntp_ntp_to_unix(const UCHAR *TimeStamp);
+
+/* Reply received from a server. */
+static void sntp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port);
+
+/* Run the state machine again after a delay. */
+static void sntp_schedule(UINT32 DelayMsec);
+
+/* Send one query to each server. */
+static void sntp_send_round(void);
+
+/* SNTP client state machine. */
+static void sntp_timer(void *Arg);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_clock(). */
+/* ============================================================================================================================================================= *\
+                                                    Convert a local time stamp to UTC with the disciplined clock (lwIP context).
+\* ============================================================================================================================================================= */
+static UINT64 sntp_clock(UINT64 LocalUs)
+{
+  INT64 Elapsed;
+
+
+  Elapsed = (INT64)(LocalUs - Sntp.RefLocal);
+
+  return Sntp.RefUnix + Elapsed + ((Elapsed * Sntp.DriftPpb) / 1000000000ll);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_dns_found(). */
+/* ============================================================================================================================================================= *\
+                                                                     Server name has been resolved.
+\* ============================================================================================================================================================= */
+static void sntp_dns_found(const char *Name, const ip_addr_t *Address, void *Arg)
+{
+  UINT8 Index;
+
+
+  Index = (UINT8)(uintptr_t)Arg;
+
+  if ((Address != NULL) && (Index < Sntp.ServerCount))
+  {
+    Sntp.Address[Index]      = *Address;
+    Sntp.FlagResolved[Index] = FLAG_ON;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_evaluate(). */
+/* ============================================================================================================================================================= *\
+                                             Retain the sample with the lowest round-trip delay and discipline the clock with it.
+\* ============================================================================================================================================================= */
+static void sntp_evaluate(void)
+{
+  UINT8 Best;
+  UINT8 Loop1UInt8;
+
+  INT32 Correction;
+
+  INT64 BestDelay;
+  INT64 Delay;
+  INT64 Elapsed;
+  INT64 Offset;
+
+  UINT64 NewUnix;
+
+
+  /* Find the reply that spent the least time in the network. */
+  Best      = 0xFF;
+  BestDelay = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.RequestCount; ++Loop1UInt8)
+  {
+    if (Sntp.Request[Loop1UInt8].FlagReply == FLAG_OFF) continue;
+
+    Delay = (INT64)(Sntp.Request[Loop1UInt8].T4 - Sntp.Request[Loop1UInt8].T1) - (INT64)(Sntp.Request[Loop1UInt8].T3 - Sntp.Request[Loop1UInt8].T2);
+    if (Delay < 0) Delay = 0;
+    if ((Best == 0xFF) || (Delay < BestDelay))
+    {
+      Best      = Loop1UInt8;
+      BestDelay = Delay;
+    }
+  }
+
+  Sntp.State     = SNTP_STATE_SLEEPING;
+  Sntp.StateTime = WIFI_TIME_US();
+
+  if (Best == 0xFF)
+  {
+    ++Sntp.Stats.Failures;
+    sntp_schedule(SNTP_RETRY_MSEC);
+
+    return;
+  }
+
+  if (Sntp.FlagSynced == FLAG_OFF)
+  {
+    /* First synchronization: set the clock. */
+    Offset  = ((INT64)(Sntp.Request[Best].T2 - Sntp.Request[Best].T1) + (INT64)(Sntp.Request[Best].T3 - Sntp.Request[Best].T4)) / 2;
+    NewUnix = Sntp.Request[Best].T4 + Offset;
+    Sntp.Stats.LastOffset  = 0;
+    Sntp.Stats.IntervalSec = SNTP_MIN_INTERVAL_SEC;
+  }
+  else
+  {
+    /* Residual offset of the disciplined clock. */
+    Offset  = ((INT64)(Sntp.Request[Best].T2 - sntp_clock(Sntp.Request[Best].T1)) + (INT64)(Sntp.Request[Best].T3 - sntp_clock(Sntp.Request[Best].T4))) / 2;
+    NewUnix = sntp_clock(Sntp.Request[Best].T4) + Offset;
+    Elapsed = (INT64)(Sntp.Request[Best].T4 - Sntp.RefLocal);
+
+    /* Offsets of more than one second are not drift: the clock is simply stepped. */
+    if ((Elapsed > 0) && (Offset > -1000000ll) && (Offset < 1000000ll))
+    {
+      /* Frequency error since last synchronization. Later estimates are averaged with previous ones. */
+      Correction = (INT32)((Offset * 1000000000ll) / Elapsed);
+      if (Sntp.FlagDriftKnown == FLAG_ON) Correction /= 2;
+      Sntp.FlagDriftKnown = FLAG_ON;
+
+      Sntp.Sequence++;
+      __sync_synchronize();
+      Sntp.DriftPpb += Correction;
+      if (Sntp.DriftPpb >  SNTP_MAX_DRIFT_PPB) Sntp.DriftPpb =  SNTP_MAX_DRIFT_PPB;
+      if (Sntp.DriftPpb < -SNTP_MAX_DRIFT_PPB) Sntp.DriftPpb = -SNTP_MAX_DRIFT_PPB;
+      __sync_synchronize();
+      Sntp.Sequence++;
+    }
+
+    /* Stretch the interval while the clock holds, shrink it when it does not. */
+    if ((Offset > -SNTP_STEADY_USEC) && (Offset < SNTP_STEADY_USEC))
+    {
+      if (Sntp.Stats.IntervalSec < SNTP_MAX_INTERVAL_SEC) Sntp.Stats.IntervalSec *= 2;
+    }
+    else
+    {
+      if (Sntp.Stats.IntervalSec > SNTP_MIN_INTERVAL_SEC) Sntp.Stats.IntervalSec /= 2;
+    }
+    Sntp.Stats.LastOffset = Offset;
+  }
+
+  /* New reference point. Readers from other contexts retry if they see an odd sequence. */
+  Sntp.Sequence++;
+  __sync_synchronize();
+  Sntp.RefLocal   = Sntp.Request[Best].T4;
+  Sntp.RefUnix    = NewUnix;
+  Sntp.FlagSynced = FLAG_ON;
+  __sync_synchronize();
+  Sntp.Sequence++;
+
+  Sntp.Stats.LastDelay  = (UINT32)BestDelay;
+  Sntp.Stats.LastServer = Sntp.Request[Best].Server;
+  Sntp.Stats.LastSync   = Sntp.Request[Best].T4;
+  ++Sntp.Stats.Syncs;
+
+  sntp_schedule(Sntp.Stats.IntervalSec * 1000);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_ntp_to_unix(). */
+/* ============================================================================================================================================================= *\
+                                   Convert an NTP time stamp to UTC usec since 1970. Seconds below 2^31 are taken as NTP era 1 (after 2036).
+\* ============================================================================================================================================================= */
+static UINT64 sntp_ntp_to_unix(const UCHAR *TimeStamp)
+{
+  UINT32 Fraction;
+  UINT32 Seconds;
+
+  UINT64 UnixSeconds;
+
+
+  Seconds  = ((UINT32)TimeStamp[0] << 24) | ((UINT32)TimeStamp[1] << 16) | ((UINT32)TimeStamp[2] << 8) | TimeStamp[3];
+  Fraction = ((UINT32)TimeStamp[4] << 24) | ((UINT32)TimeStamp[5] << 16) | ((UINT32)TimeStamp[6] << 8) | TimeStamp[7];
+
+  UnixSeconds = (UINT64)Seconds + ((Seconds & 0x80000000) ? 0 : 0x100000000ull) - SNTP_UNIX_OFFSET;
+
+  return (UnixSeconds * 1000000ull) + (((UINT64)Fraction * 1000000ull) >> 32);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_receive(). */
+/* ============================================================================================================================================================= *\
+                                                                      Reply received from a server.
+\* ============================================================================================================================================================= */
+static void sntp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port)
+{
+  UCHAR Packet[SNTP_PACKET_SIZE];
+
+  UINT8 Loop1UInt8;
+  UINT8 Pending;
+
+  UINT64 Cookie;
+  UINT64 TimeNow;
+
+
+  TimeNow = WIFI_TIME_US();
+
+  if (pbuf_copy_partial(PBuf, Packet, SNTP_PACKET_SIZE, 0) != SNTP_PACKET_SIZE)
+  {
+    pbuf_free(PBuf);
+    ++Sntp.Stats.RepliesRejected;
+
+    return;
+  }
+  pbuf_free(PBuf);
+
+  /* Originate time stamp is the cookie we sent. */
+  Cookie = 0;
+  for (Loop1UInt8 = 24; Loop1UInt8 < 32; ++Loop1UInt8)
+    Cookie = (Cookie << 8) | Packet[Loop1UInt8];
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.RequestCount; ++Loop1UInt8)
+    if ((Sntp.Request[Loop1UInt8].T1 == Cookie) && (Sntp.Request[Loop1UInt8].FlagReply == FLAG_OFF)) break;
+
+  /* Reject stale or unknown replies, replies other than server mode, unsynchronized servers and "kiss-of-death" (stratum 0). */
+  if ((Loop1UInt8 == Sntp.RequestCount) || ((Packet[0] & 0x07) != 4) || ((Packet[0] >> 6) == 3) || (Packet[1] == 0) || (Packet[1] > 15))
+  {
+    ++Sntp.Stats.RepliesRejected;
+
+    return;
+  }
+
+  Sntp.Request[Loop1UInt8].T2        = sntp_ntp_to_unix(&Packet[32]);
+  Sntp.Request[Loop1UInt8].T3        = sntp_ntp_to_unix(&Packet[40]);
+  Sntp.Request[Loop1UInt8].T4        = TimeNow;
+  Sntp.Request[Loop1UInt8].FlagReply = FLAG_ON;
+  ++Sntp.Stats.RepliesReceived;
+
+  /* Do not wait for the time-out once every reply is in. */
+  if (Sntp.State == SNTP_STATE_COLLECTING)
+  {
+    Pending = 0;
+    for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.RequestCount; ++Loop1UInt8)
+      if (Sntp.Request[Loop1UInt8].FlagReply == FLAG_OFF) ++Pending;
+
+    if (Pending == 0) sntp_schedule(0);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_schedule(). */
+/* ============================================================================================================================================================= *\
+                                                                  Run the state machine again after a delay.
+\* ============================================================================================================================================================= */
+static void sntp_schedule(UINT32 DelayMsec)
+{
+  sys_untimeout(sntp_timer, NULL);
+  sys_timeout(DelayMsec, sntp_timer, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_send_round(). */
+/* ============================================================================================================================================================= *\
+                                                               Send one query to each server whose address is known.
+\* ============================================================================================================================================================= */
+static void sntp_send_round(void)
+{
+  UCHAR *Packet;
+
+  UINT8 Loop1UInt8;
+  UINT8 Loop2UInt8;
+
+  UINT64 Cookie;
+
+  struct pbuf *PBuf;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.ServerCount; ++Loop1UInt8)
+  {
+    if ((Sntp.FlagResolved[Loop1UInt8] == FLAG_OFF) || (Sntp.RequestCount >= SNTP_MAX_REQUESTS)) continue;
+
+    PBuf = pbuf_alloc(PBUF_TRANSPORT, SNTP_PACKET_SIZE, PBUF_RAM);
+    if (PBuf == NULL) continue;
+
+    /* Client mode, version 4. The transmit time stamp carries the local send time, echoed back by the server. */
+    Packet = (UCHAR *)PBuf->payload;
+    memset(Packet, 0x00, SNTP_PACKET_SIZE);
+    Packet[0] = 0x23;
+
+    Cookie = WIFI_TIME_US();
+    if (Cookie <= Sntp.LastCookie) Cookie = Sntp.LastCookie + 1;
+    Sntp.LastCookie = Cookie;
+    for (Loop2UInt8 = 0; Loop2UInt8 < 8; ++Loop2UInt8)
+      Packet[47 - Loop2UInt8] = (UCHAR)(Cookie >> (Loop2UInt8 * 8));
+
+    Sntp.Request[Sntp.RequestCount].T1        = Cookie;
+    Sntp.Request[Sntp.RequestCount].Server    = Loop1UInt8;
+    Sntp.Request[Sntp.RequestCount].FlagReply = FLAG_OFF;
+    if (udp_sendto(Sntp.UdpPcb, PBuf, &Sntp.Address[Loop1UInt8], SNTP_PORT) == ERR_OK)
+    {
+      ++Sntp.RequestCount;
+      ++Sntp.Stats.QueriesSent;
+    }
+    pbuf_free(PBuf);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sntp_timer(). */
+/* ============================================================================================================================================================= *\
+                                                                  SNTP client state machine (lwIP context).
+\* ============================================================================================================================================================= */
+static void sntp_timer(void *Arg)
+{
+  UINT8 Loop1UInt8;
+  UINT8 Resolved;
+
+
+  switch (Sntp.State)
+  {
+    case (SNTP_STATE_SLEEPING):
+      /* Time to synchronize. Wait for the network if it is not available. */
+      if ((netif_default == NULL) || !netif_is_link_up(netif_default) || ip_addr_isany(&netif_default->ip_addr))
+      {
+        sntp_schedule(SNTP_RETRY_MSEC);
+        break;
+      }
+
+      Sntp.Round        = 0;
+      Sntp.RoundCount   = (Sntp.FlagSynced == FLAG_ON) ? SNTP_RESYNC_ROUNDS : SNTP_FIRST_ROUNDS;
+      Sntp.RequestCount = 0;
+      for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.ServerCount; ++Loop1UInt8)
+      {
+        Sntp.FlagResolved[Loop1UInt8] = FLAG_OFF;
+        if (wifi_dns_resolve(Sntp.Server[Loop1UInt8], &Sntp.Address[Loop1UInt8], sntp_dns_found, (void *)(uintptr_t)Loop1UInt8) == 0)
+          Sntp.FlagResolved[Loop1UInt8] = FLAG_ON;
+      }
+      Sntp.State     = SNTP_STATE_RESOLVING;
+      Sntp.StateTime = WIFI_TIME_US();
+      /* No break, servers may already be resolved (cached or numeric addresses). */
+
+    case (SNTP_STATE_RESOLVING):
+      Resolved = 0;
+      for (Loop1UInt8 = 0; Loop1UInt8 < Sntp.ServerCount; ++Loop1UInt8)
+        if (Sntp.FlagResolved[Loop1UInt8] == FLAG_ON) ++Resolved;
+
+      if ((Resolved < Sntp.ServerCount) && ((WIFI_TIME_US() - Sntp.StateTime) < (SNTP_DNS_TIMEOUT_MSEC * 1000ull)))
+      {
+        sntp_schedule(SNTP_ROUND_MSEC);
+        break;
+      }
+
+      if (Resolved == 0)
+      {
+        sntp_evaluate();  // no sample: counted as a failure and retried later.
+        break;
+      }
+      Sntp.State = SNTP_STATE_QUERYING;
+      /* No break, send first round now. */
+
+    case (SNTP_STATE_QUERYING):
+      sntp_send_round();
+      if (++Sntp.Round < Sntp.RoundCount)
+      {
+        sntp_schedule(SNTP_ROUND_MSEC);
+        break;
+      }
+      Sntp.State     = SNTP_STATE_COLLECTING;
+      Sntp.StateTime = WIFI_TIME_US();
+      sntp_schedule(SNTP_REPLY_TIMEOUT_MSEC);
+    break;
+
+    case (SNTP_STATE_COLLECTING):
+      sntp_evaluate();
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_date_stamp(). */
+/* ============================================================================================================================================================= *\
+                                              Format current UTC date and time as "DD-MMM-YYYY HH:MM:SS.mmm" (25 bytes with terminator).
+                                                            Return -1 (and an empty string) if time is not known yet.
+\* ============================================================================================================================================================= */
+INT16 wifi_sntp_date_stamp(UCHAR *String)
+{
+  UINT64 UnixUs;
+
+  time_t Seconds;
+
+  struct tm Tm;
+
+
+  String[0] = 0x00;
+  if (wifi_sntp_get_time(&UnixUs) != 0) return -1;
+
+  Seconds = (time_t)(UnixUs / 1000000ull);
+  gmtime_r(&Seconds, &Tm);
+  sprintf(String, "%2.2u-%s-%4.4u %2.2u:%2.2u:%2.2u.%3.3u", Tm.tm_mday, MonthName[Tm.tm_mon], Tm.tm_year + 1900, Tm.tm_hour, Tm.tm_min, Tm.tm_sec, (UINT16)((UnixUs / 1000) % 1000));
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                     Display SNTP client statistics.
+\* ============================================================================================================================================================= */
+void wifi_sntp_display_stats(void)
+{
+  static const UCHAR *StateName[] = {"idle", "resolving servers", "querying", "collecting replies", "sleeping"};
+
+  UCHAR String[32];
+
+  struct struct_sntp_stats Stats;
+
+
+  wifi_sntp_get_stats(&Stats);
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                       SNTP client statistics\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "State:                    %s\r", StateName[Stats.State]);
+  if (wifi_sntp_date_stamp(String) == 0)
+    log_info(__LINE__, __func__, "Current UTC time:         %s\r", String);
+  else
+    log_info(__LINE__, __func__, "Current UTC time:         not synchronized yet\r");
+  log_info(__LINE__, __func__, "Synchronizations:         %lu   failures: %lu\r", Stats.Syncs, Stats.Failures);
+  log_info(__LINE__, __func__, "Queries sent:             %lu   replies: %lu   rejected: %lu\r", Stats.QueriesSent, Stats.RepliesReceived, Stats.RepliesRejected);
+  if (Stats.FlagSynced)
+  {
+    log_info(__LINE__, __func__, "Last server:              %s (round-trip delay: %lu usec)\r", (Sntp.Server[Stats.LastServer] != NULL) ? Sntp.Server[Stats.LastServer] : (const UCHAR *)"?", Stats.LastDelay);
+    log_info(__LINE__, __func__, "Last correction:          %lld usec, %llu sec ago\r", Stats.LastOffset, (WIFI_TIME_US() - Stats.LastSync) / 1000000ull);
+    log_info(__LINE__, __func__, "Estimated drift:          %ld.%03lu ppm\r", Stats.DriftPpb / 1000, (UINT32)((Stats.DriftPpb < 0) ? -Stats.DriftPpb : Stats.DriftPpb) % 1000);
+    log_info(__LINE__, __func__, "Re-synchronization every: %lu sec\r", Stats.IntervalSec);
+  }
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                    Retrieve SNTP client statistics.
+\* ============================================================================================================================================================= */
+void wifi_sntp_get_stats(struct struct_sntp_stats *Stats)
+{
+  WIFI_LWIP_BEGIN();
+  *Stats = Sntp.Stats;
+  Stats->State      = Sntp.State;
+  Stats->FlagSynced = Sntp.FlagSynced;
+  Stats->DriftPpb   = Sntp.DriftPpb;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_get_time(). */
+/* ============================================================================================================================================================= *\
+                                             Retrieve current UTC time, in usec since 1970-01-01. Return -1 if time is not known yet.
+                                          Lock-free: may be called from any context, including log_info() from lwIP callbacks.
+\* ============================================================================================================================================================= */
+INT16 wifi_sntp_get_time(UINT64 *UnixUs)
+{
+  INT32 DriftPpb;
+
+  INT64 Elapsed;
+
+  UINT32 Sequence;
+
+  UINT64 RefLocal;
+  UINT64 RefUnix;
+
+
+  if (Sntp.FlagSynced == FLAG_OFF) return -1;
+
+  do
+  {
+    Sequence = Sntp.Sequence;
+    __sync_synchronize();
+    RefLocal = Sntp.RefLocal;
+    RefUnix  = Sntp.RefUnix;
+    DriftPpb = Sntp.DriftPpb;
+    __sync_synchronize();
+  } while ((Sequence & 1) || (Sequence != Sntp.Sequence));
+
+  Elapsed = (INT64)(WIFI_TIME_US() - RefLocal);
+  *UnixUs = RefUnix + Elapsed + ((Elapsed * DriftPpb) / 1000000000ll);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_is_synced(). */
+/* ============================================================================================================================================================= *\
+                                                             Tell if the software clock has been synchronized.
+\* ============================================================================================================================================================= */
+UINT8 wifi_sntp_is_synced(void)
+{
+  return Sntp.FlagSynced;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_start(). */
+/* ============================================================================================================================================================= *\
+                                      Start the SNTP client on a list of server names (e.g. "0.pool.ntp.org") or dotted addresses.
+                                 Strings are referenced and must remain valid. The first synchronization starts immediately.
+                                      A clock already synchronized by a previous run keeps running and is refined.
+\* ============================================================================================================================================================= */
+INT16 wifi_sntp_start(const UCHAR *const *Servers, UINT8 Count)
+{
+  UINT8 Loop1UInt8;
+
+
+  if ((Sntp.State != SNTP_STATE_IDLE) || (Count == 0)) return -1;
+  if (Count > SNTP_MAX_SERVERS) Count = SNTP_MAX_SERVERS;
+
+  WIFI_LWIP_BEGIN();
+  Sntp.UdpPcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+  if (Sntp.UdpPcb == NULL)
+  {
+    WIFI_LWIP_END();
+    return -1;
+  }
+  udp_recv(Sntp.UdpPcb, sntp_receive, NULL);
+
+  memset(&Sntp.Stats, 0x00, sizeof(Sntp.Stats));
+  Sntp.Stats.IntervalSec = SNTP_MIN_INTERVAL_SEC;
+  Sntp.ServerCount       = Count;
+  for (Loop1UInt8 = 0; Loop1UInt8 < Count; ++Loop1UInt8)
+    Sntp.Server[Loop1UInt8] = Servers[Loop1UInt8];
+
+  Sntp.State = SNTP_STATE_SLEEPING;
+  sntp_schedule(0);
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_stop(). */
+/* ============================================================================================================================================================= *\
+                                                           Stop the SNTP client (the software clock keeps running).
+\* ============================================================================================================================================================= */
+void wifi_sntp_stop(void)
+{
+  WIFI_LWIP_BEGIN();
+  sys_untimeout(sntp_timer, NULL);
+  if (Sntp.UdpPcb != NULL)
+  {
+    udp_remove(Sntp.UdpPcb);
+    Sntp.UdpPcb = NULL;
+  }
+  Sntp.ServerCount = 0;
+  Sntp.State       = SNTP_STATE_IDLE;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sntp_sync_now(). */
+/* ============================================================================================================================================================= *\
+                                                          Force a synchronization as soon as possible.
+\* ============================================================================================================================================================= */
+void wifi_sntp_sync_now(void)
+{
+  WIFI_LWIP_BEGIN();
+  if (Sntp.State == SNTP_STATE_SLEEPING) sntp_schedule(0);
+  WIFI_LWIP_END();
+
+  return;
+}
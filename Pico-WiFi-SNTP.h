@@ -0,0 +1,86 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-SNTP.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-SNTP.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_SNTP_H
+#define _WIFI_SNTP_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define SNTP_PORT                      123     // NTP server port.
+#define SNTP_MAX_SERVERS                 4     // servers queried in parallel.
+#define SNTP_FIRST_ROUNDS                4     // queries sent to each server for the first synchronization.
+#define SNTP_RESYNC_ROUNDS               2     // queries sent to each server for later synchronizations.
+#define SNTP_ROUND_MSEC                 50     // delay between two rounds of queries.
+#define SNTP_DNS_TIMEOUT_MSEC         3000     // maximum wait for server names to be resolved.
+#define SNTP_REPLY_TIMEOUT_MSEC       1000     // replies are collected for this delay after the last round.
+#define SNTP_RETRY_MSEC              15000     // next attempt after a failed synchronization (no reply, no network).
+#define SNTP_MIN_INTERVAL_SEC           64     // first re-synchronization interval.
+#define SNTP_MAX_INTERVAL_SEC        16384     // re-synchronization interval is doubled while the clock stays within SNTP_STEADY_USEC.
+#define SNTP_STEADY_USEC              2000     // residual offset under which the clock is considered well disciplined.
+#define SNTP_MAX_DRIFT_PPB          500000     // clamp of the drift correction (500 ppm).
+
+/* Client states. */
+#define SNTP_STATE_IDLE                  0     // client not started.
+#define SNTP_STATE_RESOLVING             1     // waiting for server names to be resolved.
+#define SNTP_STATE_QUERYING              2     // sending rounds of queries.
+#define SNTP_STATE_COLLECTING            3     // waiting for the last replies.
+#define SNTP_STATE_SLEEPING              4     // waiting for next synchronization.
+
+
+/* Client statistics. Offsets and delays are in usec. */
+struct struct_sntp_stats
+{
+  UINT8  State;
+  UINT8  FlagSynced;                           // software clock has been set at least once.
+  UINT32 Syncs;                                // successful synchronizations.
+  UINT32 Failures;                             // synchronizations without any usable reply.
+  UINT32 QueriesSent;
+  UINT32 RepliesReceived;
+  UINT32 RepliesRejected;                      // unexpected, unsynchronized or "kiss-of-death" replies.
+  UINT32 LastDelay;                            // round-trip delay of the sample retained at last synchronization.
+  INT64  LastOffset;                           // offset corrected at last synchronization (first one: 0).
+  INT32  DriftPpb;                             // estimated drift of the Pico clock, in parts per billion.
+  UINT32 IntervalSec;                          // current re-synchronization interval.
+  UINT64 LastSync;                             // time stamp (time_us_64()) of last synchronization.
+  UINT8  LastServer;                           // server that provided the retained sample.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Format current UTC date and time as "DD-MMM-YYYY HH:MM:SS.mmm". */
+INT16 wifi_sntp_date_stamp(UCHAR *String);
+
+/* Display SNTP client statistics. */
+void wifi_sntp_display_stats(void);
+
+/* Retrieve SNTP client statistics. */
+void wifi_sntp_get_stats(struct struct_sntp_stats *Stats);
+
+/* Retrieve current UTC time, in usec since 1970-01-01. */
+INT16 wifi_sntp_get_time(UINT64 *UnixUs);
+
+/* Tell if the software clock has been synchronized. */
+UINT8 wifi_sntp_is_synced(void);
+
+/* Start the SNTP client on a list of server names or addresses. */
+INT16 wifi_sntp_start(const UCHAR *const *Servers, UINT8 Count);
+
+/* Stop the SNTP client (the software clock keeps running). */
+void wifi_sntp_stop(void);
+
+/* Force a synchronization as soon as possible. */
+void wifi_sntp_sync_now(void);
+
+#endif  // _WIFI_SNTP_H
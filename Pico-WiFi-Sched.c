@@ -0,0 +1,556 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Sched.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Small cooperative run-to-completion scheduler for Pico-WiFi-Module and the user program.
+   A task is a handler called with the events that made it ready (start, timer, stdin input, completion of an operation, user events).
+   It runs to completion and returns, after selecting with wifi_sched_wait() the events it waits for next, with an optional time-out.
+   Task timers are one-shot alarms of a single alarm pool. Events may be posted from interrupt or lwIP context, or from the other core,
+   and deferred function calls may be queued from there with wifi_sched_call(). Both wake the scheduler with __sev().
+   While a blocking function waits in wifi_sleep_ms(), other ready tasks run (a task is never re-entered), so legacy blocking code
+   keeps working while the device does useful work.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+                    - wifi_sched_call() refuses (and counts) calls made before wifi_sched_init().
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+#include "Pico-WiFi-Module.h"
+#include "Pico-WiFi-Sched.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  struct struct_sched_task Task[SCHED_MAX_TASKS];
+  struct
+  {
+    sched_function Function;
+    void *Arg;
+  } Call[SCHED_MAX_CALLS];                             // deferred calls, circular buffer.
+  UINT8 CallHead;
+  UINT8 CallTail;
+  UINT8 CallCount;
+  UINT8 Core;                                          // core running the scheduler.
+  UINT8 FlagInit;
+  alarm_pool_t *AlarmPool;
+  spin_lock_t  *Lock;                                  // protects events and deferred calls against interrupts and the other core.
+  struct struct_sched_task *StdinTask;
+  struct struct_sched_stats Stats;
+} Sched;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info to log file through Pico's UART or CDC USB. */
+extern void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Timer of a task expired (alarm pool interrupt). */
+static int64_t sched_alarm_callback(alarm_id_t AlarmId, void *UserData);
+
+/* Characters received on stdin (stdio interrupt). */
+static void sched_stdin_callback(void *Param);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sched_alarm_callback(). */
+/* ============================================================================================================================================================= *\
+                                                                     Timer of a task expired.
+                                                           NOTE: Called from the alarm pool interrupt.
+\* ============================================================================================================================================================= */
+static int64_t sched_alarm_callback(alarm_id_t AlarmId, void *UserData)
+{
+  struct struct_sched_task *Task;
+
+
+  Task = (struct struct_sched_task *)UserData;
+
+  /* The timer may have been cancelled or re-armed by the task in the meantime. */
+  if (Task->FlagTimer == FLAG_ON)
+  {
+    Task->FlagTimer = FLAG_OFF;
+    wifi_sched_post(Task, SCHED_EVENT_TIMER);
+  }
+
+  return 0;  // one-shot.
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sched_stdin_callback(). */
+/* ============================================================================================================================================================= *\
+                                          Characters received on stdin: wake the task selected with wifi_sched_stdin().
+                                                            NOTE: Called from stdio interrupt context.
+\* ============================================================================================================================================================= */
+static void sched_stdin_callback(void *Param)
+{
+  wifi_sched_post(Sched.StdinTask, SCHED_EVENT_INPUT);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_call(). */
+/* ============================================================================================================================================================= *\
+                          Queue a function call to be run by the scheduler, outside of interrupt and lwIP context, as soon as possible.
+         May be called from interrupt or lwIP context, or from the other core. Return -1 if the queue is full or if wifi_sched_init() was not called yet.
+\* ============================================================================================================================================================= */
+INT16 wifi_sched_call(sched_function Function, void *Arg)
+{
+  UINT32 SavedIrq;
+
+
+  /* Module callbacks may fire before the application starts the scheduler: no spinlock claimed yet. */
+  if (Sched.FlagInit == FLAG_OFF)
+  {
+    ++Sched.Stats.CallsLost;
+    return -1;
+  }
+
+  SavedIrq = spin_lock_blocking(Sched.Lock);
+  if (Sched.CallCount >= SCHED_MAX_CALLS)
+  {
+    ++Sched.Stats.CallsLost;
+    spin_unlock(Sched.Lock, SavedIrq);
+    return -1;
+  }
+
+  Sched.Call[Sched.CallHead].Function = Function;
+  Sched.Call[Sched.CallHead].Arg      = Arg;
+  Sched.CallHead = (Sched.CallHead + 1) % SCHED_MAX_CALLS;
+  ++Sched.CallCount;
+  if (Sched.CallCount > Sched.Stats.CallsHighWater) Sched.Stats.CallsHighWater = Sched.CallCount;
+  spin_unlock(Sched.Lock, SavedIrq);
+
+  __sev();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_create(). */
+/* ============================================================================================================================================================= *\
+                   Create a task. Its handler receives SCHED_EVENT_START as soon as the scheduler runs, and then all events posted to it until
+                            the task selects the events it waits for with wifi_sched_wait(). Return NULL if all task slots are in use.
+\* ============================================================================================================================================================= */
+struct struct_sched_task *wifi_sched_create(const UCHAR *Name, sched_handler Handler, void *Context)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 SavedIrq;
+
+  struct struct_sched_task *Task;
+
+
+  if (Sched.FlagInit == FLAG_OFF) return NULL;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < SCHED_MAX_TASKS; ++Loop1UInt8)
+  {
+    Task = &Sched.Task[Loop1UInt8];
+    if ((Task->Handler != NULL) || (Task->FlagRunning == FLAG_ON)) continue;
+
+    memset(Task, 0x00, sizeof(*Task));
+    Task->Name     = Name;
+    Task->Context  = Context;
+    Task->WaitMask = SCHED_EVENT_ALL;
+
+    SavedIrq = spin_lock_blocking(Sched.Lock);
+    Task->Pending = SCHED_EVENT_START;
+    Task->Handler = Handler;                   // slot is in use from now on.
+    spin_unlock(Sched.Lock, SavedIrq);
+
+    ++Sched.Stats.Tasks;
+    if (Sched.Stats.Tasks > Sched.Stats.TasksHighWater) Sched.Stats.TasksHighWater = Sched.Stats.Tasks;
+    __sev();
+
+    return Task;
+  }
+
+  return NULL;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_delete(). */
+/* ============================================================================================================================================================= *\
+                                                Delete a task. May be called by the task itself, from its handler.
+\* ============================================================================================================================================================= */
+void wifi_sched_delete(struct struct_sched_task *Task)
+{
+  UINT32 SavedIrq;
+
+
+  if ((Task == NULL) || (Task->Handler == NULL)) return;
+
+  wifi_sched_timer(Task, 0);
+  if (Sched.StdinTask == Task) wifi_sched_stdin(NULL);
+
+  SavedIrq = spin_lock_blocking(Sched.Lock);
+  Task->Handler = NULL;
+  Task->Pending = 0;
+  spin_unlock(Sched.Lock, SavedIrq);
+
+  --Sched.Stats.Tasks;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_display_stats(). */
+/* ============================================================================================================================================================= *\
+                                                              Display scheduler and task statistics.
+\* ============================================================================================================================================================= */
+void wifi_sched_display_stats(void)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_sched_task *Task;
+
+
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                      Cooperative scheduler\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "Task              State       Runs    Average (usec)    Max (usec)\r");
+  for (Loop1UInt8 = 0; Loop1UInt8 < SCHED_MAX_TASKS; ++Loop1UInt8)
+  {
+    Task = &Sched.Task[Loop1UInt8];
+    if (Task->Handler == NULL) continue;
+
+    log_info(__LINE__, __func__, "%-16s   %3u %10lu %17lu %13lu\r", Task->Name, Task->State, Task->Runs,
+             Task->Runs ? (UINT32)(Task->TotalUsec / Task->Runs) : 0, Task->MaxUsec);
+  }
+  log_info(__LINE__, __func__, "Tasks:               %u (peak %u / %u)\r", Sched.Stats.Tasks, Sched.Stats.TasksHighWater, SCHED_MAX_TASKS);
+  log_info(__LINE__, __func__, "Deferred calls:      %lu run, peak %u / %u waiting, %lu lost\r", Sched.Stats.CallsRun, Sched.Stats.CallsHighWater, SCHED_MAX_CALLS, Sched.Stats.CallsLost);
+  log_info(__LINE__, __func__, "Timers lost:         %lu\r", Sched.Stats.TimersLost);
+  log_info(__LINE__, __func__, "Idle periods:        %lu\r", Sched.Stats.Idles);
+  log_info(__LINE__, __func__, "NOTE: Times of a task include other tasks run while it waits in wifi_sleep_ms().\r");
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                  Retrieve scheduler statistics.
+\* ============================================================================================================================================================= */
+void wifi_sched_get_stats(struct struct_sched_stats *Stats)
+{
+  *Stats = Sched.Stats;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_idle(). */
+/* ============================================================================================================================================================= *\
+                         Sleep until next event (interrupt, posted event, deferred call) or until specified time, whichever comes first.
+                     With the poll architecture, cyw43 work also ends the sleep, and scheduler events are checked every SCHED_IDLE_POLL_USEC.
+                             With FreeRTOS, the calling task sleeps for at most one tick at a time, letting other FreeRTOS tasks run.
+\* ============================================================================================================================================================= */
+void wifi_sched_idle(absolute_time_t Until)
+{
+#if PICO_CYW43_ARCH_POLL || PICO_CYW43_ARCH_FREERTOS
+  absolute_time_t Limit;
+
+
+  Limit = make_timeout_time_us(SCHED_IDLE_POLL_USEC);
+  if (absolute_time_diff_us(Limit, Until) > 0) Until = Limit;
+#endif  // PICO_CYW43_ARCH_POLL || PICO_CYW43_ARCH_FREERTOS
+
+  ++Sched.Stats.Idles;
+
+#if PICO_CYW43_ARCH_POLL
+  cyw43_arch_wait_for_work_until(Until);
+#elif PICO_CYW43_ARCH_FREERTOS
+  sleep_until(Until);
+#else   // threadsafe background
+  best_effort_wfe_or_timeout(Until);
+#endif  // PICO_CYW43_ARCH_POLL
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_init(). */
+/* ============================================================================================================================================================= *\
+                                Initialize the scheduler on the calling core: its tasks and deferred calls only run on this core.
+\* ============================================================================================================================================================= */
+INT16 wifi_sched_init(void)
+{
+  if (Sched.FlagInit == FLAG_ON) return 0;
+
+  Sched.Lock      = spin_lock_instance(spin_lock_claim_unused(true));
+  Sched.AlarmPool = alarm_pool_create_with_unused_hardware_alarm(SCHED_MAX_TASKS);
+  if (Sched.AlarmPool == NULL) return -1;
+
+  Sched.Core     = get_core_num();
+  Sched.FlagInit = FLAG_ON;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_post(). */
+/* ============================================================================================================================================================= *\
+                            Post events to a task. They are delivered when the task is not running and waits for at least one of them.
+                                              May be called from interrupt or lwIP context, or from the other core.
+\* ============================================================================================================================================================= */
+void wifi_sched_post(struct struct_sched_task *Task, UINT32 Events)
+{
+  UINT32 SavedIrq;
+
+
+  if (Task == NULL) return;
+
+  SavedIrq = spin_lock_blocking(Sched.Lock);
+  if (Task->Handler != NULL) Task->Pending |= Events;
+  spin_unlock(Sched.Lock, SavedIrq);
+
+  __sev();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_run(). */
+/* ============================================================================================================================================================= *\
+                  Run the scheduler forever: service the Wi-Fi stack, run deferred calls and ready tasks, and sleep when there is nothing to do.
+\* ============================================================================================================================================================= */
+void wifi_sched_run(void)
+{
+  while (1)
+  {
+    wifi_poll();
+    if (wifi_sched_yield() == 0) wifi_sched_idle(at_the_end_of_time);
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_stdin(). */
+/* ============================================================================================================================================================= *\
+                                    Send SCHED_EVENT_INPUT to a task each time characters are received on stdin (NULL: stop).
+\* ============================================================================================================================================================= */
+void wifi_sched_stdin(struct struct_sched_task *Task)
+{
+  Sched.StdinTask = Task;
+  stdio_set_chars_available_callback((Task == NULL) ? NULL : sched_stdin_callback, NULL);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_timer(). */
+/* ============================================================================================================================================================= *\
+                     Arm the one-shot timer of a task: SCHED_EVENT_TIMER is posted after DelayMsec. A timer already armed is cancelled first,
+                      and a timer event not delivered yet is discarded. DelayMsec = 0 only cancels. Must be called from the scheduler core.
+\* ============================================================================================================================================================= */
+void wifi_sched_timer(struct struct_sched_task *Task, UINT32 DelayMsec)
+{
+  alarm_id_t AlarmId;
+
+  UINT32 SavedIrq;
+
+
+  /* Cancel timer in progress and forget its event. */
+  if (Task->FlagTimer == FLAG_ON)
+  {
+    Task->FlagTimer = FLAG_OFF;
+    alarm_pool_cancel_alarm(Sched.AlarmPool, Task->AlarmId);
+  }
+  SavedIrq = spin_lock_blocking(Sched.Lock);
+  Task->Pending &= ~SCHED_EVENT_TIMER;
+  spin_unlock(Sched.Lock, SavedIrq);
+
+  if (DelayMsec == 0) return;
+
+  Task->FlagTimer = FLAG_ON;
+  AlarmId = alarm_pool_add_alarm_in_ms(Sched.AlarmPool, DelayMsec, sched_alarm_callback, Task, true);
+  if (AlarmId < 0)
+  {
+    /* Alarm pool full: wake the task at once rather than never. */
+    Task->FlagTimer = FLAG_OFF;
+    ++Sched.Stats.TimersLost;
+    wifi_sched_post(Task, SCHED_EVENT_TIMER);
+  }
+  Task->AlarmId = AlarmId;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_wait(). */
+/* ============================================================================================================================================================= *\
+               Select the events that make a task ready. With TimeoutMsec, the task timer is also armed and SCHED_EVENT_TIMER is added to the mask.
+                                         Events posted while the task waits for others are kept until it waits for them.
+\* ============================================================================================================================================================= */
+void wifi_sched_wait(struct struct_sched_task *Task, UINT32 EventMask, UINT32 TimeoutMsec)
+{
+  Task->WaitMask = EventMask;
+
+  if (TimeoutMsec)
+  {
+    Task->WaitMask |= SCHED_EVENT_TIMER;
+    wifi_sched_timer(Task, TimeoutMsec);
+  }
+  __sev();  // some of the new events may already be pending.
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_sched_yield(). */
+/* ============================================================================================================================================================= *\
+                      Run waiting deferred calls, then each ready task once. Tasks already running (waiting in wifi_sleep_ms()) are skipped.
+                     Return the number of calls and tasks run (0: nothing to do). Does nothing on the other core or before wifi_sched_init().
+\* ============================================================================================================================================================= */
+UINT8 wifi_sched_yield(void)
+{
+  UINT8 Loop1UInt8;
+  UINT8 Ran;
+
+  UINT32 Events;
+  UINT32 SavedIrq;
+
+  UINT64 Elapsed;
+
+  void *Arg;
+
+  sched_function Function;
+
+  struct struct_sched_task *Task;
+
+
+  if ((Sched.FlagInit == FLAG_OFF) || (get_core_num() != Sched.Core)) return 0;
+
+  Ran = 0;
+
+  /* Deferred calls first, in order. At most one queue full per pass, so that calls posting calls don't starve the tasks. */
+  for (Loop1UInt8 = 0; Loop1UInt8 < SCHED_MAX_CALLS; ++Loop1UInt8)
+  {
+    SavedIrq = spin_lock_blocking(Sched.Lock);
+    if (Sched.CallCount == 0)
+    {
+      spin_unlock(Sched.Lock, SavedIrq);
+      break;
+    }
+    Function = Sched.Call[Sched.CallTail].Function;
+    Arg      = Sched.Call[Sched.CallTail].Arg;
+    Sched.CallTail = (Sched.CallTail + 1) % SCHED_MAX_CALLS;
+    --Sched.CallCount;
+    spin_unlock(Sched.Lock, SavedIrq);
+
+    Function(Arg);
+    ++Sched.Stats.CallsRun;
+    ++Ran;
+  }
+
+  /* Then each ready task. */
+  for (Loop1UInt8 = 0; Loop1UInt8 < SCHED_MAX_TASKS; ++Loop1UInt8)
+  {
+    Task = &Sched.Task[Loop1UInt8];
+    if ((Task->Handler == NULL) || (Task->FlagRunning == FLAG_ON)) continue;
+
+    SavedIrq = spin_lock_blocking(Sched.Lock);
+    Events = Task->Pending & Task->WaitMask;
+    Task->Pending &= ~Events;
+    spin_unlock(Sched.Lock, SavedIrq);
+    if (Events == 0) continue;
+
+    Task->FlagRunning = FLAG_ON;
+    Elapsed = time_us_64();
+    Task->Handler(Task, Events);
+    Elapsed = time_us_64() - Elapsed;
+    Task->FlagRunning = FLAG_OFF;
+
+    ++Task->Runs;
+    Task->TotalUsec += Elapsed;
+    if (Elapsed > Task->MaxUsec) Task->MaxUsec = (UINT32)Elapsed;
+    ++Ran;
+  }
+
+  return Ran;
+}
@@ -0,0 +1,117 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Sched.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Sched.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_SCHED_H
+#define _WIFI_SCHED_H
+
+#include "baseline.h"
+#include "pico/stdlib.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define SCHED_MAX_TASKS                 12     // tasks that may exist at the same time (also the number of timers of the alarm pool).
+#define SCHED_MAX_CALLS                  8     // deferred function calls waiting to be run.
+#define SCHED_IDLE_POLL_USEC          1000     // poll architecture: longest sleep between two checks of scheduler events.
+
+/* Events delivered to tasks. */
+#define SCHED_EVENT_START       0x00000001     // posted when the task is created.
+#define SCHED_EVENT_TIMER       0x00000002     // timer of the task expired (wifi_sched_timer() / wifi_sched_wait() time-out).
+#define SCHED_EVENT_INPUT       0x00000004     // characters available on stdin (see wifi_sched_stdin()).
+#define SCHED_EVENT_DONE        0x00000008     // an operation started by the task has completed.
+#define SCHED_EVENT_NETWORK     0x00000010     // Wi-Fi health event.
+#define SCHED_EVENT_LINE        0x00000020     // a complete line has been typed on the console (see Pico-WiFi-Console.c).
+#define SCHED_EVENT_USER        0x00000100     // first event free for the application (up to 0x80000000).
+#define SCHED_EVENT_ALL         0xFFFFFFFF
+
+
+struct struct_sched_task;
+
+/* Task handler: called with the events that made the task ready. Must return quickly (run to completion) and never sleep. */
+typedef void (*sched_handler)(struct struct_sched_task *Task, UINT32 Events);
+
+/* Deferred function call (see wifi_sched_call()). */
+typedef void (*sched_function)(void *Arg);
+
+
+/* Task of the cooperative scheduler. */
+struct struct_sched_task
+{
+  const UCHAR *Name;
+  sched_handler Handler;                       // NULL: slot is free.
+  void  *Context;                              // free for the application.
+  UINT8  State;                                // free for the task's own state machine (0 on creation).
+  UINT8  FlagRunning;                          // handler is on the stack (it is never re-entered).
+  UINT8  FlagTimer;                            // timer is armed.
+  volatile UINT32 Pending;                     // events posted but not delivered yet.
+  UINT32 WaitMask;                             // events that make the task ready.
+  INT32  AlarmId;
+  UINT32 Runs;
+  UINT32 MaxUsec;                              // longest run: a long run delays all other tasks.
+  UINT64 TotalUsec;
+};
+
+
+/* Scheduler statistics. */
+struct struct_sched_stats
+{
+  UINT8  Tasks;                                // tasks in use.
+  UINT8  TasksHighWater;
+  UINT8  CallsHighWater;                       // highest number of deferred calls waiting.
+  UINT32 CallsRun;
+  UINT32 CallsLost;                            // deferred calls refused because the queue was full.
+  UINT32 TimersLost;                           // timers that could not be armed (alarm pool full).
+  UINT32 Idles;                                // times the scheduler went to sleep with nothing to do.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Queue a function call to be run by the scheduler (may be called from interrupt or lwIP context). */
+INT16 wifi_sched_call(sched_function Function, void *Arg);
+
+/* Create a task. It receives SCHED_EVENT_START as soon as the scheduler runs. */
+struct struct_sched_task *wifi_sched_create(const UCHAR *Name, sched_handler Handler, void *Context);
+
+/* Delete a task (may be called by the task itself). */
+void wifi_sched_delete(struct struct_sched_task *Task);
+
+/* Display scheduler and task statistics. */
+void wifi_sched_display_stats(void);
+
+/* Retrieve scheduler statistics. */
+void wifi_sched_get_stats(struct struct_sched_stats *Stats);
+
+/* Sleep until next event or specified time. */
+void wifi_sched_idle(absolute_time_t Until);
+
+/* Initialize the scheduler on the calling core. */
+INT16 wifi_sched_init(void);
+
+/* Post events to a task (may be called from interrupt or lwIP context, or from the other core). */
+void wifi_sched_post(struct struct_sched_task *Task, UINT32 Events);
+
+/* Run the scheduler forever. */
+void wifi_sched_run(void);
+
+/* Send SCHED_EVENT_INPUT to a task when characters are received on stdin. */
+void wifi_sched_stdin(struct struct_sched_task *Task);
+
+/* Arm (or cancel, with 0) the one-shot timer of a task. */
+void wifi_sched_timer(struct struct_sched_task *Task, UINT32 DelayMsec);
+
+/* Select the events that make a task ready, with an optional time-out. */
+void wifi_sched_wait(struct struct_sched_task *Task, UINT32 EventMask, UINT32 TimeoutMsec);
+
+/* Run deferred calls and ready tasks once. */
+UINT8 wifi_sched_yield(void);
+
+#endif  // _WIFI_SCHED_H
@@ -0,0 +1,909 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Shell.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Network command shell built on the lwIP raw API, part of Pico-WiFi-Module, so that units without a USB host may still be managed.
+   Line protocol over TCP: any telnet or netcat client may be used ("nc <pico> 2323").
+   - Non-blocking: data is processed in lwIP callbacks, output waits in a per-session buffer for room in the TCP send buffer.
+   - Commands come from a table given by the application (plus the built-in "help", "quit" and "who"), there is no switch statement to extend.
+   - Up to SHELL_MAX_SESSIONS concurrent sessions. A command runs out of lwIP context (deferred to the cooperative scheduler on the PicoW);
+     input of its session is held until it completes, which also throttles the peer through the TCP receive window.
+   - Console output (log_info()) produced while a command runs is copied to its session (see wifi_shell_mirror()), so existing display
+     functions need no change to be used as shell commands.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port
+   and exercised over a loopback interface with a command table of its own.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdarg.h"
+#include "stdio.h"
+#include "string.h"
+
+#include "lwip/tcp.h"
+
+#include "Pico-WiFi-Shell.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+/* Telnet negotiation (RFC 854), skipped by the line editor. */
+#define TELNET_IAC     0xFF                  // "interpret as command".
+#define TELNET_SB      0xFA                  // sub-negotiation begins, up to TELNET_IAC TELNET_SE.
+#define TELNET_SE      0xF0
+#define TELNET_WILL    0xFB                  // TELNET_WILL to TELNET_DONT are followed by one option byte.
+#define TELNET_DONT    0xFE
+
+/* States of the telnet negotiation filter. */
+#define TELNET_STATE_DATA      0
+#define TELNET_STATE_COMMAND   1             // TELNET_IAC received.
+#define TELNET_STATE_OPTION    2             // option byte expected.
+#define TELNET_STATE_SUB       3             // inside sub-negotiation.
+#define TELNET_STATE_SUB_IAC   4             // TELNET_IAC received inside sub-negotiation.
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static struct
+{
+  UINT8  FlagRunning;
+  UINT8  CommandCount;
+  const struct struct_shell_command *Commands;  // command table of the application.
+  void  *Context;
+  struct tcp_pcb *ListenPcb;
+  struct struct_shell_stats   Stats;
+  struct struct_shell_session Session[SHELL_MAX_SESSIONS];
+} Shell;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* End the command in progress: display the prompt and process the input held. */
+static void shell_command_done(struct struct_shell_session *Session);
+
+/* Run a command line (deferred call). */
+static void shell_execute(void *Arg);
+
+/* Built-in command: list the commands. */
+static void shell_help(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Queue output for a session and send as much as possible. */
+static void shell_output(struct struct_shell_session *Session, const UCHAR *Data, UINT16 Length);
+
+/* Built-in command: close the session. */
+static void shell_quit(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Close the connection of a session. */
+static err_t shell_session_close(struct struct_shell_session *Session);
+
+/* Send output waiting in the session buffer. */
+static void shell_session_flush(struct struct_shell_session *Session);
+
+/* Process the data received until a command line is complete. */
+static void shell_session_input(struct struct_shell_session *Session);
+
+/* TCP: new connection. */
+static err_t shell_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error);
+
+/* TCP: connection error. */
+static void shell_tcp_error(void *Arg, err_t Error);
+
+/* TCP: periodic poll. */
+static err_t shell_tcp_poll(void *Arg, struct tcp_pcb *Pcb);
+
+/* TCP: data received. */
+static err_t shell_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged by the peer. */
+static err_t shell_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length);
+
+/* Built-in command: list the sessions. */
+static void shell_who(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+
+/* Built-in commands, looked up before the command table of the application. */
+static const struct struct_shell_command ShellBuiltin[] =
+{
+  {"help", "List the commands.",                 shell_help},
+  {"quit", "Close the session.",                 shell_quit},
+  {"who",  "List the sessions and statistics.",  shell_who}
+};
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_command_done(). */
+/* ============================================================================================================================================================= *\
+                            End the command in progress: display the prompt and process the input held while the command was running.
+                                      If the connection has been closed in the meantime, the session slot may now be reused.
+\* ============================================================================================================================================================= */
+static void shell_command_done(struct struct_shell_session *Session)
+{
+  WIFI_LWIP_BEGIN();
+  Session->FlagBusy    = FLAG_OFF;
+  Session->FlagHeld    = FLAG_OFF;
+  Session->FlagCapture = FLAG_OFF;
+  Session->LineLength  = 0;
+
+  if (Session->Pcb == NULL)
+  {
+    Session->FlagInUse = FLAG_OFF;
+  }
+  else if (Session->FlagClosing)
+  {
+    /* Close at once if all output fits in the send buffer, or else once it has been acknowledged (see shell_tcp_sent()). */
+    shell_session_flush(Session);
+    if (Session->OutCount == 0) shell_session_close(Session);
+  }
+  else
+  {
+    shell_output(Session, SHELL_PROMPT, sizeof(SHELL_PROMPT) - 1);
+    shell_session_input(Session);
+  }
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_execute(). */
+/* ============================================================================================================================================================= *\
+          Run a command line (deferred call, out of lwIP context). The line is split in words and its first word is looked up in the built-in commands,
+                      then in the command table of the application. Console output produced while the command runs is copied to the session.
+\* ============================================================================================================================================================= */
+static void shell_execute(void *Arg)
+{
+  UCHAR *Argv[SHELL_MAX_ARGS];
+  UCHAR *Pointer;
+
+  UINT8 Argc;
+  UINT8 Loop1UInt8;
+
+  const struct struct_shell_command *Command;
+  struct struct_shell_session *Session;
+
+
+  Session = (struct struct_shell_session *)Arg;
+
+  /* Split the line in words. */
+  Argc    = 0;
+  Pointer = Session->Line;
+  while (Argc < SHELL_MAX_ARGS)
+  {
+    while (*Pointer == ' ') *Pointer++ = 0x00;
+    if (*Pointer == 0x00) break;
+    Argv[Argc++] = Pointer;
+    while ((*Pointer != ' ') && (*Pointer != 0x00)) ++Pointer;
+  }
+
+  if ((Argc > 0) && (Session->Pcb != NULL))
+  {
+    Command = NULL;
+    for (Loop1UInt8 = 0; (Command == NULL) && (Loop1UInt8 < (sizeof(ShellBuiltin) / sizeof(ShellBuiltin[0]))); ++Loop1UInt8)
+      if (strcmp(Argv[0], ShellBuiltin[Loop1UInt8].Name) == 0) Command = &ShellBuiltin[Loop1UInt8];
+    for (Loop1UInt8 = 0; (Command == NULL) && (Loop1UInt8 < Shell.CommandCount); ++Loop1UInt8)
+      if (strcmp(Argv[0], Shell.Commands[Loop1UInt8].Name) == 0) Command = &Shell.Commands[Loop1UInt8];
+
+    ++Session->Commands;
+    ++Shell.Stats.Commands;
+    Session->FlagCapture = FLAG_ON;
+    if (Command == NULL)
+      wifi_shell_printf(Session, "Unknown command <%s>, type \"help\" for the list of commands.\r", Argv[0]);
+    else
+      Command->Handler(Session, Argc, Argv);
+  }
+
+  if (Session->FlagHeld == FLAG_OFF) shell_command_done(Session);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_help(). */
+/* ============================================================================================================================================================= *\
+                                                               Built-in command: list the commands.
+\* ============================================================================================================================================================= */
+static void shell_help(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Shell.CommandCount; ++Loop1UInt8)
+    wifi_shell_printf(Session, "  %-10s %s\r", Shell.Commands[Loop1UInt8].Name, Shell.Commands[Loop1UInt8].Help);
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < (sizeof(ShellBuiltin) / sizeof(ShellBuiltin[0])); ++Loop1UInt8)
+    wifi_shell_printf(Session, "  %-10s %s\r", ShellBuiltin[Loop1UInt8].Name, ShellBuiltin[Loop1UInt8].Help);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_output(). */
+/* ============================================================================================================================================================= *\
+              Queue output for a session and send as much as the TCP send buffer allows. End-of-lines (<CR> as used by log_info(), <LF> or <CR><LF>)
+                are sent as <CR><LF>. Output that does not fit in the session buffer is dropped and counted: the caller never waits for the peer.
+                                                             Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static void shell_output(struct struct_shell_session *Session, const UCHAR *Data, UINT16 Length)
+{
+  UCHAR Character;
+
+  UINT16 Loop1UInt16;
+  UINT16 Needed;
+  UINT16 Tail;
+
+
+  if (Session->Pcb == NULL) return;
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Length; ++Loop1UInt16)
+  {
+    Character = Data[Loop1UInt16];
+
+    /* <LF> of a <CR><LF> pair has already been sent. */
+    if ((Character == '\n') && (Session->LastOut == '\r'))
+    {
+      Session->LastOut = Character;
+      continue;
+    }
+
+    Needed = ((Character == '\r') || (Character == '\n')) ? 2 : 1;
+    if ((Session->OutCount + Needed) > SHELL_OUT_SIZE) shell_session_flush(Session);
+    if ((Session->OutCount + Needed) > SHELL_OUT_SIZE)
+    {
+      ++Session->BytesDropped;
+      ++Shell.Stats.BytesDropped;
+      continue;
+    }
+
+    Tail = (Session->OutHead + Session->OutCount) % SHELL_OUT_SIZE;
+    if (Needed == 2)
+    {
+      Session->Out[Tail] = '\r';
+      Session->Out[(Tail + 1) % SHELL_OUT_SIZE] = '\n';
+    }
+    else
+    {
+      Session->Out[Tail] = Character;
+    }
+    Session->OutCount += Needed;
+    Session->LastOut   = Character;
+  }
+
+  shell_session_flush(Session);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_quit(). */
+/* ============================================================================================================================================================= *\
+                                            Built-in command: close the session once the output pending has been sent.
+\* ============================================================================================================================================================= */
+static void shell_quit(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  wifi_shell_printf(Session, "Bye.\r");
+  Session->FlagClosing = FLAG_ON;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_session_close(). */
+/* ============================================================================================================================================================= *\
+               Close the connection of a session (output already given to lwIP is still sent). Return ERR_ABRT if the connection had to be aborted:
+                              a lwIP callback of this connection must then return ERR_ABRT. Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static err_t shell_session_close(struct struct_shell_session *Session)
+{
+  err_t ReturnCode;
+
+
+  ReturnCode = ERR_OK;
+  if (Session->Pcb != NULL)
+  {
+    tcp_arg(Session->Pcb,  NULL);
+    tcp_err(Session->Pcb,  NULL);
+    tcp_recv(Session->Pcb, NULL);
+    tcp_sent(Session->Pcb, NULL);
+    tcp_poll(Session->Pcb, NULL, 0);
+    if (tcp_close(Session->Pcb) != ERR_OK)
+    {
+      tcp_abort(Session->Pcb);
+      ReturnCode = ERR_ABRT;
+    }
+    Session->Pcb = NULL;
+    --Shell.Stats.Sessions;
+  }
+
+  if (Session->Input != NULL)
+  {
+    pbuf_free(Session->Input);
+    Session->Input = NULL;
+  }
+  Session->OutCount = 0;
+
+  /* A command still running keeps the slot until it completes (see shell_command_done()). */
+  if (Session->FlagBusy == FLAG_OFF) Session->FlagInUse = FLAG_OFF;
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_session_flush(). */
+/* ============================================================================================================================================================= *\
+                Send output waiting in the session buffer, as much as the TCP send buffer allows. The rest is sent when the peer acknowledges data
+                                                 (see shell_tcp_sent()). Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static void shell_session_flush(struct struct_shell_session *Session)
+{
+  UINT16 Length;
+
+
+  if (Session->Pcb == NULL) return;
+
+  while (Session->OutCount > 0)
+  {
+    /* Contiguous part of the circular buffer. */
+    Length = Session->OutCount;
+    if (Length > (SHELL_OUT_SIZE - Session->OutHead)) Length = SHELL_OUT_SIZE - Session->OutHead;
+    if (Length > tcp_sndbuf(Session->Pcb))            Length = tcp_sndbuf(Session->Pcb);
+    if (Length == 0) break;
+
+    if (tcp_write(Session->Pcb, &Session->Out[Session->OutHead], Length, TCP_WRITE_FLAG_COPY) != ERR_OK) break;
+    Session->OutHead   = (Session->OutHead + Length) % SHELL_OUT_SIZE;
+    Session->OutCount -= Length;
+  }
+  tcp_output(Session->Pcb);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_session_input(). */
+/* ============================================================================================================================================================= *\
+             Process the data received until a command line is complete, then defer the command and stop: the rest of the data is processed when the
+         command completes. Telnet negotiation is skipped (clients stay in their default line mode, with local echo). <CR>, <LF> or <CR><LF> end a line,
+                     <Backspace> erases the last character and other control characters are ignored. Must be called with the lwIP lock held.
+\* ============================================================================================================================================================= */
+static void shell_session_input(struct struct_shell_session *Session)
+{
+  UCHAR Character;
+
+
+  while ((Session->Input != NULL) && (Session->FlagBusy == FLAG_OFF))
+  {
+    Character = pbuf_get_at(Session->Input, Session->InputOffset++);
+    if (Session->InputOffset >= Session->Input->tot_len)
+    {
+      /* Whole pbuf processed: open the receive window again. */
+      if (Session->Pcb != NULL) tcp_recved(Session->Pcb, Session->Input->tot_len);
+      pbuf_free(Session->Input);
+      Session->Input       = NULL;
+      Session->InputOffset = 0;
+    }
+
+    /* Skip telnet negotiation. */
+    if (Session->TelnetState != TELNET_STATE_DATA)
+    {
+      switch (Session->TelnetState)
+      {
+        case (TELNET_STATE_COMMAND):
+          if ((Character >= TELNET_WILL) && (Character <= TELNET_DONT)) Session->TelnetState = TELNET_STATE_OPTION;
+          else if (Character == TELNET_SB)                              Session->TelnetState = TELNET_STATE_SUB;
+          else                                                          Session->TelnetState = TELNET_STATE_DATA;
+        break;
+
+        case (TELNET_STATE_SUB):
+          if (Character == TELNET_IAC) Session->TelnetState = TELNET_STATE_SUB_IAC;
+        break;
+
+        case (TELNET_STATE_SUB_IAC):
+          Session->TelnetState = (Character == TELNET_SE) ? TELNET_STATE_DATA : TELNET_STATE_SUB;
+        break;
+
+        default:
+          Session->TelnetState = TELNET_STATE_DATA;
+        break;
+      }
+      continue;
+    }
+    if (Character == TELNET_IAC)
+    {
+      Session->TelnetState = TELNET_STATE_COMMAND;
+      continue;
+    }
+
+    /* <LF> of a <CR><LF> pair. */
+    if ((Character == '\n') && (Session->LastIn == '\r'))
+    {
+      Session->LastIn = Character;
+      continue;
+    }
+    Session->LastIn = Character;
+
+    if ((Character == '\r') || (Character == '\n'))
+    {
+      Session->Line[Session->LineLength] = 0x00;
+      Session->FlagBusy = FLAG_ON;
+      if (WIFI_DEFER(shell_execute, Session) != 0)
+      {
+        Session->FlagBusy   = FLAG_OFF;
+        Session->LineLength = 0;
+        shell_output(Session, "Busy, command ignored.\r" SHELL_PROMPT, sizeof("Busy, command ignored.\r" SHELL_PROMPT) - 1);
+        continue;
+      }
+      /* On a host, the command has already run and processed the rest of the input. */
+      return;
+    }
+
+    if ((Character == 0x08) || (Character == 0x7F))
+    {
+      if (Session->LineLength > 0) --Session->LineLength;
+    }
+    else if ((Character >= 0x20) && (Session->LineLength < (SHELL_LINE_SIZE - 1)))
+    {
+      Session->Line[Session->LineLength++] = Character;
+    }
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_tcp_accept(). */
+/* ============================================================================================================================================================= *\
+                                              TCP: new connection. It is refused when all session slots are in use.
+\* ============================================================================================================================================================= */
+static err_t shell_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_shell_session *Session;
+
+
+  if ((Error != ERR_OK) || (NewPcb == NULL)) return ERR_VAL;
+
+  Session = NULL;
+  for (Loop1UInt8 = 0; Loop1UInt8 < SHELL_MAX_SESSIONS; ++Loop1UInt8)
+  {
+    if (Shell.Session[Loop1UInt8].FlagInUse == FLAG_OFF)
+    {
+      Session = &Shell.Session[Loop1UInt8];
+      break;
+    }
+  }
+
+  if (Session == NULL)
+  {
+    ++Shell.Stats.Refused;
+    tcp_write(NewPcb, "All shell sessions are in use.\r\n", sizeof("All shell sessions are in use.\r\n") - 1, 0);
+    if (tcp_close(NewPcb) != ERR_OK)
+    {
+      tcp_abort(NewPcb);
+      return ERR_ABRT;
+    }
+    return ERR_OK;
+  }
+
+  memset(Session, 0x00, sizeof(*Session));
+  Session->Pcb           = NewPcb;
+  Session->Context       = Shell.Context;
+  Session->FlagInUse     = FLAG_ON;
+  Session->RemoteAddress = NewPcb->remote_ip;
+  Session->RemotePort    = NewPcb->remote_port;
+  Session->LastActivity  = WIFI_TIME_US();
+  ++Shell.Stats.Accepted;
+  ++Shell.Stats.Sessions;
+
+  tcp_arg(NewPcb, Session);
+  tcp_err(NewPcb, shell_tcp_error);
+  tcp_recv(NewPcb, shell_tcp_receive);
+  tcp_sent(NewPcb, shell_tcp_sent);
+  tcp_poll(NewPcb, shell_tcp_poll, SHELL_POLL_TICKS);
+  tcp_nagle_disable(NewPcb);  // interactive: prompt and short replies go out at once.
+
+  shell_output(Session, "Pico-WiFi shell, type \"help\" for the list of commands.\r" SHELL_PROMPT, sizeof("Pico-WiFi shell, type \"help\" for the list of commands.\r" SHELL_PROMPT) - 1);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                   TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void shell_tcp_error(void *Arg, err_t Error)
+{
+  struct struct_shell_session *Session;
+
+
+  if ((Session = (struct struct_shell_session *)Arg) == NULL) return;
+
+  Session->Pcb = NULL;
+  --Shell.Stats.Sessions;
+  shell_session_close(Session);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_tcp_poll(). */
+/* ============================================================================================================================================================= *\
+                     TCP: periodic poll. Retry output that did not fit in the send buffer, complete a pending close and close idle sessions.
+\* ============================================================================================================================================================= */
+static err_t shell_tcp_poll(void *Arg, struct tcp_pcb *Pcb)
+{
+  struct struct_shell_session *Session;
+
+
+  Session = (struct struct_shell_session *)Arg;
+
+  shell_session_flush(Session);
+
+  if (Session->FlagBusy == FLAG_OFF)
+  {
+    if (Session->FlagClosing && (Session->OutCount == 0)) return shell_session_close(Session);
+
+    if ((WIFI_TIME_US() - Session->LastActivity) >= (SHELL_IDLE_SEC * 1000000ull))
+    {
+      shell_output(Session, "\rIdle time-out, closing session.\r", sizeof("\rIdle time-out, closing session.\r") - 1);
+      return shell_session_close(Session);
+    }
+  }
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                    TCP: data received. Data is kept as received (no copy) until processed by the line editor.
+\* ============================================================================================================================================================= */
+static err_t shell_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  struct struct_shell_session *Session;
+
+
+  Session = (struct struct_shell_session *)Arg;
+
+  /* Peer closed the connection. */
+  if (PBuf == NULL) return shell_session_close(Session);
+
+  if (Session->Input == NULL)
+  {
+    Session->Input       = PBuf;
+    Session->InputOffset = 0;
+  }
+  else
+  {
+    /* A command is in progress: keep the data for later. */
+    pbuf_cat(Session->Input, PBuf);
+  }
+  Session->LastActivity = WIFI_TIME_US();
+
+  shell_session_input(Session);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                                TCP: data acknowledged by the peer. Send more of the output waiting, and complete a pending close.
+\* ============================================================================================================================================================= */
+static err_t shell_tcp_sent(void *Arg, struct tcp_pcb *Pcb, u16_t Length)
+{
+  struct struct_shell_session *Session;
+
+
+  Session = (struct struct_shell_session *)Arg;
+
+  shell_session_flush(Session);
+  if (Session->FlagClosing && (Session->OutCount == 0) && (Session->FlagBusy == FLAG_OFF)) return shell_session_close(Session);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=shell_who(). */
+/* ============================================================================================================================================================= *\
+                                                    Built-in command: list the sessions and shell statistics.
+\* ============================================================================================================================================================= */
+static void shell_who(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  UINT8 Loop1UInt8;
+
+  struct struct_shell_session *Other;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < SHELL_MAX_SESSIONS; ++Loop1UInt8)
+  {
+    Other = &Shell.Session[Loop1UInt8];
+    if ((Other->FlagInUse == FLAG_OFF) || (Other->Pcb == NULL)) continue;
+    wifi_shell_printf(Session, "  %u) %s:%u   commands: %lu   output dropped: %lu bytes%s\r", Loop1UInt8 + 1, ipaddr_ntoa(&Other->RemoteAddress), Other->RemotePort,
+                      Other->Commands, Other->BytesDropped, (Other == Session) ? "   (this session)" : "");
+  }
+  wifi_shell_printf(Session, "Sessions accepted: %lu   refused: %lu   commands: %lu   output dropped: %lu bytes\r", Shell.Stats.Accepted, Shell.Stats.Refused,
+                    Shell.Stats.Commands, Shell.Stats.BytesDropped);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_get_stats(). */
+/* ============================================================================================================================================================= *\
+                                                                    Retrieve shell statistics.
+\* ============================================================================================================================================================= */
+void wifi_shell_get_stats(struct struct_shell_stats *Stats)
+{
+  WIFI_LWIP_BEGIN();
+  *Stats = Shell.Stats;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_hold(). */
+/* ============================================================================================================================================================= *\
+                Tell the shell that the command in progress completes later, for example when it starts a task. Console output keeps being copied
+                                      to the session and its input stays held until the command calls wifi_shell_release().
+\* ============================================================================================================================================================= */
+void wifi_shell_hold(struct struct_shell_session *Session)
+{
+  Session->FlagHeld = FLAG_ON;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_mirror(). */
+/* ============================================================================================================================================================= *\
+                    Copy console output to the sessions running a command (called by log_info()). Nothing is done while no command is running,
+                                                nor from interrupt context, where the lwIP lock may not be taken.
+\* ============================================================================================================================================================= */
+void wifi_shell_mirror(const UCHAR *Data, UINT16 Length)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < SHELL_MAX_SESSIONS; ++Loop1UInt8)
+    if (Shell.Session[Loop1UInt8].FlagCapture) break;
+  if ((Loop1UInt8 >= SHELL_MAX_SESSIONS) || WIFI_IN_INTERRUPT()) return;
+
+  WIFI_LWIP_BEGIN();
+  for (Loop1UInt8 = 0; Loop1UInt8 < SHELL_MAX_SESSIONS; ++Loop1UInt8)
+    if (Shell.Session[Loop1UInt8].FlagCapture) shell_output(&Shell.Session[Loop1UInt8], Data, Length);
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_printf(). */
+/* ============================================================================================================================================================= *\
+                                                    Send formatted output to a session (up to 255 characters).
+\* ============================================================================================================================================================= */
+void wifi_shell_printf(struct struct_shell_session *Session, const UCHAR *Format, ...)
+{
+  UCHAR String[256];
+
+  INT16 Length;
+
+  va_list argp;
+
+
+  va_start(argp, Format);
+  Length = vsnprintf(String, sizeof(String), Format, argp);
+  va_end(argp);
+
+  if (Length < 0) return;
+  if (Length >= sizeof(String)) Length = sizeof(String) - 1;
+  wifi_shell_write(Session, String, Length);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_release(). */
+/* ============================================================================================================================================================= *\
+                               Complete a command held with wifi_shell_hold(): the prompt is displayed and input held is processed.
+\* ============================================================================================================================================================= */
+void wifi_shell_release(struct struct_shell_session *Session)
+{
+  shell_command_done(Session);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_start(). */
+/* ============================================================================================================================================================= *\
+           Start listening for shell sessions on Port (SHELL_DEFAULT_PORT if 0). Commands is the command table of the application, and Context is given
+                                        to its handlers through Session->Context. May be called before the network is up.
+\* ============================================================================================================================================================= */
+INT16 wifi_shell_start(UINT16 Port, const struct struct_shell_command *Commands, UINT8 CommandCount, void *Context)
+{
+  err_t ReturnCode;
+
+  struct tcp_pcb *Pcb;
+
+
+  if (Shell.FlagRunning) return -1;
+
+  WIFI_LWIP_BEGIN();
+  Shell.Commands     = Commands;
+  Shell.CommandCount = CommandCount;
+  Shell.Context      = Context;
+  if (Port == 0) Port = SHELL_DEFAULT_PORT;
+
+  ReturnCode = ERR_MEM;
+  if ((Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY)) != NULL)
+  {
+    if ((ReturnCode = tcp_bind(Pcb, IP_ANY_TYPE, Port)) != ERR_OK)
+    {
+      tcp_close(Pcb);
+    }
+    else if ((Shell.ListenPcb = tcp_listen_with_backlog(Pcb, SHELL_MAX_SESSIONS)) == NULL)
+    {
+      tcp_close(Pcb);
+      ReturnCode = ERR_MEM;
+    }
+    else
+    {
+      tcp_accept(Shell.ListenPcb, shell_tcp_accept);
+      Shell.FlagRunning = FLAG_ON;
+    }
+  }
+  WIFI_LWIP_END();
+
+  return (ReturnCode == ERR_OK) ? 0 : -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_stop(). */
+/* ============================================================================================================================================================= *\
+            Stop listening and close all sessions (for example before cyw43_arch_deinit()). A command in progress runs to completion, without output.
+\* ============================================================================================================================================================= */
+void wifi_shell_stop(void)
+{
+  UINT8 Loop1UInt8;
+
+
+  WIFI_LWIP_BEGIN();
+  if (Shell.ListenPcb != NULL)
+  {
+    tcp_close(Shell.ListenPcb);
+    Shell.ListenPcb = NULL;
+  }
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < SHELL_MAX_SESSIONS; ++Loop1UInt8)
+    if (Shell.Session[Loop1UInt8].FlagInUse) shell_session_close(&Shell.Session[Loop1UInt8]);
+
+  Shell.FlagRunning = FLAG_OFF;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=wifi_shell_write(). */
+/* ============================================================================================================================================================= *\
+                         Send data to a session. It never waits: output the peer is too slow to take is dropped and counted (see "who").
+\* ============================================================================================================================================================= */
+void wifi_shell_write(struct struct_shell_session *Session, const UCHAR *Data, UINT16 Length)
+{
+  WIFI_LWIP_BEGIN();
+  shell_output(Session, Data, Length);
+  WIFI_LWIP_END();
+
+  return;
+}
@@ -0,0 +1,113 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Shell.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Shell.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_SHELL_H
+#define _WIFI_SHELL_H
+
+#include "Pico-WiFi-Port.h"
+#include "lwip/tcp.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define SHELL_DEFAULT_PORT            2323     // TCP port of the shell (may be given by WIFI_SHELL_PORT in CMakeLists.txt).
+#define SHELL_MAX_SESSIONS               3     // concurrent sessions (each one uses a TCP pcb, see MEMP_NUM_TCP_PCB).
+#define SHELL_LINE_SIZE                129     // longest command line, plus end-of-string.
+#define SHELL_MAX_ARGS                   8     // command name included.
+#define SHELL_OUT_SIZE                2048     // output waiting for room in the TCP send buffer, per session.
+#define SHELL_POLL_TICKS                 4     // lwIP poll of each session, in 500 msec ticks.
+#ifndef SHELL_IDLE_SEC
+#define SHELL_IDLE_SEC                 600     // idle sessions are closed after this delay (may be given at build time, see tests/CMakeLists.txt).
+#endif  // SHELL_IDLE_SEC
+#define SHELL_PROMPT               "pico> "
+
+
+struct struct_shell_session;
+
+/* Command handler. Argv[0] is the command name; Argv[] is only valid until the handler returns. */
+typedef void (*shell_handler)(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+
+/* Entry of a command table (see wifi_shell_start()). */
+struct struct_shell_command
+{
+  const UCHAR *Name;
+  const UCHAR *Help;                           // one line, displayed by "help".
+  shell_handler Handler;
+};
+
+
+/* Shell session (one per TCP connection). */
+struct struct_shell_session
+{
+  struct tcp_pcb *Pcb;                         // NULL once the connection is closed.
+  void  *Context;                              // given to wifi_shell_start(), free for the command handlers.
+  UINT8  FlagInUse;                            // slot is kept until the command in progress completes, even if the connection is closed.
+  UINT8  FlagBusy;                             // a command is in progress; input is held until it completes.
+  UINT8  FlagHeld;                             // command completes later (see wifi_shell_hold()).
+  UINT8  FlagCapture;                          // console output is copied to the session (see wifi_shell_mirror()).
+  UINT8  FlagClosing;                          // close once pending output has been sent.
+  UINT8  TelnetState;                          // telnet negotiation bytes are skipped.
+  UCHAR  LastIn;                               // last character received (<CR><LF> is one end-of-line).
+  UCHAR  LastOut;                              // last character sent (<CR><LF> is not doubled).
+  UCHAR  Line[SHELL_LINE_SIZE];
+  UINT16 LineLength;
+  struct pbuf *Input;                          // data received and not processed yet.
+  UINT16 InputOffset;
+  UCHAR  Out[SHELL_OUT_SIZE];
+  UINT16 OutHead;
+  UINT16 OutCount;
+  UINT64 LastActivity;
+  ip_addr_t RemoteAddress;
+  UINT16 RemotePort;
+  UINT32 Commands;
+  UINT32 BytesDropped;                         // output lost because the peer did not read fast enough.
+};
+
+
+/* Shell statistics. */
+struct struct_shell_stats
+{
+  UINT8  Sessions;                             // sessions open.
+  UINT32 Accepted;
+  UINT32 Refused;                              // connections refused because all session slots were in use.
+  UINT32 Commands;
+  UINT32 BytesDropped;                         // output lost, all sessions.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Retrieve shell statistics. */
+void wifi_shell_get_stats(struct struct_shell_stats *Stats);
+
+/* Tell the shell that the command in progress completes later (see wifi_shell_release()). */
+void wifi_shell_hold(struct struct_shell_session *Session);
+
+/* Copy console output to the sessions running a command. */
+void wifi_shell_mirror(const UCHAR *Data, UINT16 Length);
+
+/* Send formatted output to a session. */
+void wifi_shell_printf(struct struct_shell_session *Session, const UCHAR *Format, ...);
+
+/* Complete a command held with wifi_shell_hold(). */
+void wifi_shell_release(struct struct_shell_session *Session);
+
+/* Start listening for shell sessions. */
+INT16 wifi_shell_start(UINT16 Port, const struct struct_shell_command *Commands, UINT8 CommandCount, void *Context);
+
+/* Stop listening and close all sessions. */
+void wifi_shell_stop(void);
+
+/* Send data to a session. */
+void wifi_shell_write(struct struct_shell_session *Session, const UCHAR *Data, UINT16 Length);
+
+#endif  // _WIFI_SHELL_H
@@ -0,0 +1,809 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Stream.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Zero-copy TCP / UDP streaming API built on the lwIP raw API, part of Pico-WiFi-Module.
+   Receive: the pbuf chains delivered by lwIP are queued as is and handed to the application by stream_receive(). The application
+            walks the chain in place (q = p; q != NULL; q = q->next: q->payload, q->len) and gives it back with stream_release().
+            For TCP, the receive window is only re-opened when the chain is released, so a slow consumer throttles the peer
+            instead of exhausting the pbuf pool.
+   Send:    stream_send_ref() sends without copy.
+            UDP: the payload is referenced by a PBUF_ROM pbuf when it lives in flash (lwIP never copies it), or by a PBUF_REF
+                 pbuf when it lives in RAM (lwIP only copies it if the datagram must be queued while waiting for ARP).
+                 The data may be reused as soon as the function returns.
+            TCP: the payload is referenced by lwIP until it is acknowledged by the peer; the data must remain unchanged until
+                 TxUnacked of the stream goes back to 0 (STREAM_EVENT_SENT). Flash and static data satisfy this naturally.
+            stream_send_copy() is the traditional copy-based path, kept for small or volatile payloads and for comparison.
+   stream_benchmark() measures both paths on the same payloads.
+   The code only relies on lwIP (see Pico-WiFi-Port.h), so it may also be built on a host against the lwIP unix port.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include "stdio.h"
+#include "string.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/regs/addressmap.h"
+#endif  // PICO_ON_DEVICE
+
+#include "lwip/stats.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-Stream.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+/* Tell if a payload lives in flash (execute-in-place area), in which case it may be referenced by a PBUF_ROM pbuf. */
+#if PICO_ON_DEVICE
+#define STREAM_IS_FLASH(Data)  ((uintptr_t)(Data) < SRAM_BASE)
+#else   // PICO_ON_DEVICE
+#define STREAM_IS_FLASH(Data)  (0)
+#endif  // PICO_ON_DEVICE
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+/* Benchmark payload. Lives in flash. */
+static const UCHAR StreamBenchPayload[STREAM_BENCH_SIZE] = "Pico-WiFi-Stream benchmark payload.";
+
+/* Destination of the copy-based receive path of the benchmark. */
+static UCHAR StreamBenchBuffer[STREAM_BENCH_SIZE];
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Consume a payload (benchmark). */
+static UINT32 stream_checksum(const UCHAR *Data, UINT16 Length, UINT32 Sum);
+
+/* Report an event to the application. */
+static void stream_notify(struct struct_stream *Stream, UINT8 Event);
+
+/* Queue a received pbuf chain. */
+static INT16 stream_queue(struct struct_stream *Stream, struct pbuf *PBuf);
+
+/* Common send path. */
+static INT16 stream_send(struct struct_stream *Stream, const void *Data, UINT16 Length, UINT8 FlagCopy);
+
+/* TCP: incoming connection. */
+static err_t stream_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error);
+
+/* TCP: connection established. */
+static err_t stream_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP: connection error (pcb already freed by lwIP). */
+static void stream_tcp_error(void *Arg, err_t Error);
+
+/* TCP: data received. */
+static err_t stream_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP: data acknowledged. */
+static err_t stream_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+/* UDP: datagram received. */
+static void stream_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_benchmark(). */
+/* ============================================================================================================================================================= *\
+                                              Compare zero-copy and copy-based send / receive paths on the same payloads.
+                             Send: STREAM_BENCH_COUNT datagrams of STREAM_BENCH_SIZE bytes are sent to the UDP discard port of Address,
+                                   first by reference, then by copy. The peer does not need to listen (datagrams are simply dropped).
+                          Receive: the same payload, held in a chain of pool pbufs as delivered by the driver, is consumed in place,
+                                   then copied to a buffer and consumed, STREAM_BENCH_COUNT times each.
+\* ============================================================================================================================================================= */
+INT16 stream_benchmark(const ip_addr_t *Address, struct struct_stream_bench *Bench)
+{
+  UINT16 Loop1UInt16;
+
+  UINT32 Sum;
+
+  UINT64 TimeStamp;
+
+  struct pbuf *PBuf;
+  struct pbuf *Segment;
+  struct struct_stream Stream;
+
+
+  memset(Bench, 0x00, sizeof(*Bench));
+
+  if (stream_open_udp(&Stream, 0, Address, STREAM_DISCARD_PORT, NULL, NULL) != 0) return -1;
+
+  WIFI_LWIP_BEGIN();
+
+  /* Zero-copy send. */
+#if LWIP_STATS && MEM_STATS
+  lwip_stats.mem.max = lwip_stats.mem.used;
+#endif  // LWIP_STATS && MEM_STATS
+  TimeStamp = WIFI_TIME_US();
+  for (Loop1UInt16 = 0; Loop1UInt16 < STREAM_BENCH_COUNT; ++Loop1UInt16)
+    if (stream_send(&Stream, StreamBenchPayload, STREAM_BENCH_SIZE, FLAG_OFF) != 0) ++Bench->SendRefErrors;
+  Bench->SendRefUs = (UINT32)(WIFI_TIME_US() - TimeStamp);
+#if LWIP_STATS && MEM_STATS
+  Bench->HeapRefMax = lwip_stats.mem.max;
+#endif  // LWIP_STATS && MEM_STATS
+
+  /* Copy-based send. */
+#if LWIP_STATS && MEM_STATS
+  lwip_stats.mem.max = lwip_stats.mem.used;
+#endif  // LWIP_STATS && MEM_STATS
+  TimeStamp = WIFI_TIME_US();
+  for (Loop1UInt16 = 0; Loop1UInt16 < STREAM_BENCH_COUNT; ++Loop1UInt16)
+    if (stream_send(&Stream, StreamBenchPayload, STREAM_BENCH_SIZE, FLAG_ON) != 0) ++Bench->SendCopyErrors;
+  Bench->SendCopyUs = (UINT32)(WIFI_TIME_US() - TimeStamp);
+#if LWIP_STATS && MEM_STATS
+  Bench->HeapCopyMax = lwip_stats.mem.max;
+#endif  // LWIP_STATS && MEM_STATS
+
+  /* Receive paths, on a pool pbuf chain. */
+  PBuf = pbuf_alloc(PBUF_RAW, STREAM_BENCH_SIZE, PBUF_POOL);
+  if (PBuf != NULL)
+  {
+    pbuf_take(PBuf, StreamBenchPayload, STREAM_BENCH_SIZE);
+
+    Sum       = 0;
+    TimeStamp = WIFI_TIME_US();
+    for (Loop1UInt16 = 0; Loop1UInt16 < STREAM_BENCH_COUNT; ++Loop1UInt16)
+      for (Segment = PBuf; Segment != NULL; Segment = Segment->next)
+        Sum = stream_checksum(Segment->payload, Segment->len, Sum);
+    Bench->ReceiveInPlaceUs = (UINT32)(WIFI_TIME_US() - TimeStamp);
+
+    TimeStamp = WIFI_TIME_US();
+    for (Loop1UInt16 = 0; Loop1UInt16 < STREAM_BENCH_COUNT; ++Loop1UInt16)
+    {
+      pbuf_copy_partial(PBuf, StreamBenchBuffer, STREAM_BENCH_SIZE, 0);
+      Sum = stream_checksum(StreamBenchBuffer, STREAM_BENCH_SIZE, Sum);
+    }
+    Bench->ReceiveCopyUs = (UINT32)(WIFI_TIME_US() - TimeStamp);
+
+    pbuf_free(PBuf);
+
+    /* Keep the compiler from optimizing the consumers away. */
+    if (Sum == 0) ++Bench->ReceiveCopyUs;
+  }
+
+  WIFI_LWIP_END();
+
+  stream_close(&Stream);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_checksum(). */
+/* ============================================================================================================================================================= *\
+                                                  Consume a payload (benchmark). Stands for the application parsing received data.
+\* ============================================================================================================================================================= */
+static UINT32 stream_checksum(const UCHAR *Data, UINT16 Length, UINT32 Sum)
+{
+  UINT16 Loop1UInt16;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Length; ++Loop1UInt16)
+    Sum = (Sum << 1) + Data[Loop1UInt16] + (Sum >> 31);
+
+  return Sum;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_close(). */
+/* ============================================================================================================================================================= *\
+                                                               Close a stream and release all queued pbuf chains.
+\* ============================================================================================================================================================= */
+void stream_close(struct struct_stream *Stream)
+{
+  WIFI_LWIP_BEGIN();
+  if (Stream->ListenPcb != NULL)
+  {
+    tcp_arg(Stream->ListenPcb, NULL);
+    tcp_accept(Stream->ListenPcb, NULL);
+    tcp_close(Stream->ListenPcb);
+    Stream->ListenPcb = NULL;
+  }
+
+  if (Stream->TcpPcb != NULL)
+  {
+    tcp_arg(Stream->TcpPcb,  NULL);
+    tcp_err(Stream->TcpPcb,  NULL);
+    tcp_recv(Stream->TcpPcb, NULL);
+    tcp_sent(Stream->TcpPcb, NULL);
+    if (tcp_close(Stream->TcpPcb) != ERR_OK) tcp_abort(Stream->TcpPcb);
+    Stream->TcpPcb = NULL;
+  }
+
+  if (Stream->UdpPcb != NULL)
+  {
+    udp_remove(Stream->UdpPcb);
+    Stream->UdpPcb = NULL;
+  }
+
+  /* Free what the application did not consume. */
+  while (Stream->RxHead != Stream->RxTail)
+  {
+    pbuf_free(Stream->RxQueue[Stream->RxHead % STREAM_RX_QUEUE]);
+    ++Stream->RxHead;
+  }
+
+  Stream->State     = STREAM_STATE_CLOSED;
+  Stream->TxUnacked = 0;
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_display_benchmark(). */
+/* ============================================================================================================================================================= *\
+                                                                  Display the result of stream_benchmark().
+\* ============================================================================================================================================================= */
+void stream_display_benchmark(struct struct_stream_bench *Bench)
+{
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "          Zero-copy vs copy (%u payloads of %u bytes)\r", STREAM_BENCH_COUNT, STREAM_BENCH_SIZE);
+  log_info(__LINE__, __func__, "======================================================================\r");
+  log_info(__LINE__, __func__, "                         Zero-copy        Copy\r");
+  log_info(__LINE__, __func__, "UDP send (usec):        %10lu  %10lu\r", Bench->SendRefUs, Bench->SendCopyUs);
+  log_info(__LINE__, __func__, "UDP send errors:        %10u  %10u\r", Bench->SendRefErrors, Bench->SendCopyErrors);
+#if LWIP_STATS && MEM_STATS
+  log_info(__LINE__, __func__, "lwIP heap peak (bytes): %10lu  %10lu\r", Bench->HeapRefMax, Bench->HeapCopyMax);
+#endif  // LWIP_STATS && MEM_STATS
+  log_info(__LINE__, __func__, "Receive (usec):         %10lu  %10lu\r", Bench->ReceiveInPlaceUs, Bench->ReceiveCopyUs);
+  log_info(__LINE__, __func__, "======================================================================\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_listen(). */
+/* ============================================================================================================================================================= *\
+                                                  Wait for one incoming TCP connection on a port. Further connections are refused.
+\* ============================================================================================================================================================= */
+INT16 stream_listen(struct struct_stream *Stream, UINT16 Port, stream_callback Callback, void *Context)
+{
+  struct tcp_pcb *Pcb;
+
+
+  memset(Stream, 0x00, sizeof(*Stream));
+  Stream->Type     = STREAM_TYPE_TCP;
+  Stream->Callback = Callback;
+  Stream->Context  = Context;
+
+  WIFI_LWIP_BEGIN();
+  Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  if (Pcb == NULL)
+  {
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  if (tcp_bind(Pcb, IP_ANY_TYPE, Port) != ERR_OK)
+  {
+    tcp_close(Pcb);
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  Stream->ListenPcb = tcp_listen_with_backlog(Pcb, 1);
+  if (Stream->ListenPcb == NULL)
+  {
+    tcp_close(Pcb);
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  tcp_arg(Stream->ListenPcb, Stream);
+  tcp_accept(Stream->ListenPcb, stream_tcp_accept);
+  Stream->State = STREAM_STATE_LISTEN;
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_notify(). */
+/* ============================================================================================================================================================= *\
+                                                                     Report an event to the application.
+\* ============================================================================================================================================================= */
+static void stream_notify(struct struct_stream *Stream, UINT8 Event)
+{
+  if (Stream->Callback != NULL) Stream->Callback(Stream, Event, Stream->Context);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_open_tcp(). */
+/* ============================================================================================================================================================= *\
+                                                 Open a TCP connection to a peer. STREAM_EVENT_CONNECTED is reported once established.
+\* ============================================================================================================================================================= */
+INT16 stream_open_tcp(struct struct_stream *Stream, const ip_addr_t *Address, UINT16 Port, stream_callback Callback, void *Context)
+{
+  memset(Stream, 0x00, sizeof(*Stream));
+  Stream->Type          = STREAM_TYPE_TCP;
+  Stream->RemoteAddress = *Address;
+  Stream->RemotePort    = Port;
+  Stream->Callback      = Callback;
+  Stream->Context       = Context;
+
+  WIFI_LWIP_BEGIN();
+  Stream->TcpPcb = tcp_new_ip_type(IP_GET_TYPE(Address));
+  if (Stream->TcpPcb == NULL)
+  {
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  tcp_arg(Stream->TcpPcb,  Stream);
+  tcp_err(Stream->TcpPcb,  stream_tcp_error);
+  tcp_recv(Stream->TcpPcb, stream_tcp_receive);
+  tcp_sent(Stream->TcpPcb, stream_tcp_sent);
+
+  Stream->State = STREAM_STATE_CONNECTING;
+  if (tcp_connect(Stream->TcpPcb, Address, Port, stream_tcp_connected) != ERR_OK)
+  {
+    tcp_abort(Stream->TcpPcb);
+    Stream->TcpPcb = NULL;
+    Stream->State  = STREAM_STATE_CLOSED;
+    WIFI_LWIP_END();
+    return -1;
+  }
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_open_udp(). */
+/* ============================================================================================================================================================= *\
+                                                      Open a UDP stream, bound to a local port (0 = any) and sending to a peer.
+\* ============================================================================================================================================================= */
+INT16 stream_open_udp(struct struct_stream *Stream, UINT16 LocalPort, const ip_addr_t *Address, UINT16 RemotePort, stream_callback Callback, void *Context)
+{
+  memset(Stream, 0x00, sizeof(*Stream));
+  Stream->Type          = STREAM_TYPE_UDP;
+  Stream->RemoteAddress = *Address;
+  Stream->RemotePort    = RemotePort;
+  Stream->Callback      = Callback;
+  Stream->Context       = Context;
+
+  WIFI_LWIP_BEGIN();
+  Stream->UdpPcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+  if (Stream->UdpPcb == NULL)
+  {
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  if (udp_bind(Stream->UdpPcb, IP_ANY_TYPE, LocalPort) != ERR_OK)
+  {
+    udp_remove(Stream->UdpPcb);
+    Stream->UdpPcb = NULL;
+    WIFI_LWIP_END();
+    return -1;
+  }
+
+  udp_recv(Stream->UdpPcb, stream_udp_receive, Stream);
+  Stream->State = STREAM_STATE_OPEN;
+  WIFI_LWIP_END();
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_queue(). */
+/* ============================================================================================================================================================= *\
+                                                          Queue a received pbuf chain. Return -1 if the queue is full.
+\* ============================================================================================================================================================= */
+static INT16 stream_queue(struct struct_stream *Stream, struct pbuf *PBuf)
+{
+  if ((UINT8)(Stream->RxTail - Stream->RxHead) >= STREAM_RX_QUEUE) return -1;
+
+  Stream->RxQueue[Stream->RxTail % STREAM_RX_QUEUE] = PBuf;
+  ++Stream->RxTail;
+  Stream->RxBytes += PBuf->tot_len;
+
+  stream_notify(Stream, STREAM_EVENT_DATA);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_receive(). */
+/* ============================================================================================================================================================= *\
+                                   Take the next received pbuf chain, or NULL. The chain belongs to the caller until stream_release().
+\* ============================================================================================================================================================= */
+struct pbuf *stream_receive(struct struct_stream *Stream)
+{
+  struct pbuf *PBuf;
+
+
+  PBuf = NULL;
+
+  WIFI_LWIP_BEGIN();
+  if (Stream->RxHead != Stream->RxTail)
+  {
+    PBuf = Stream->RxQueue[Stream->RxHead % STREAM_RX_QUEUE];
+    ++Stream->RxHead;
+  }
+  WIFI_LWIP_END();
+
+  return PBuf;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_release(). */
+/* ============================================================================================================================================================= *\
+                                        Give back a chain obtained from stream_receive(). For TCP, this opens the receive window.
+\* ============================================================================================================================================================= */
+void stream_release(struct struct_stream *Stream, struct pbuf *PBuf)
+{
+  WIFI_LWIP_BEGIN();
+  if ((Stream->Type == STREAM_TYPE_TCP) && (Stream->TcpPcb != NULL)) tcp_recved(Stream->TcpPcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+  WIFI_LWIP_END();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_send(). */
+/* ============================================================================================================================================================= *\
+                                            Common send path. Must be called with lwIP lock held.
+                                   Return 0 on success, -1 if the stream is not open, -2 if memory or send buffer is not available.
+\* ============================================================================================================================================================= */
+static INT16 stream_send(struct struct_stream *Stream, const void *Data, UINT16 Length, UINT8 FlagCopy)
+{
+  err_t ReturnCode;
+
+  struct pbuf *PBuf;
+
+
+  if (Stream->State != STREAM_STATE_OPEN) return -1;
+
+  if (Stream->Type == STREAM_TYPE_TCP)
+  {
+    if (tcp_write(Stream->TcpPcb, Data, Length, (FlagCopy == FLAG_ON) ? TCP_WRITE_FLAG_COPY : 0) != ERR_OK) return -2;
+    tcp_output(Stream->TcpPcb);
+    Stream->TxUnacked += Length;
+    Stream->TxBytes   += Length;
+
+    return 0;
+  }
+
+  if (FlagCopy == FLAG_ON)
+  {
+    PBuf = pbuf_alloc(PBUF_TRANSPORT, Length, PBUF_RAM);
+    if (PBuf == NULL) return -2;
+    memcpy(PBuf->payload, Data, Length);
+  }
+  else
+  {
+    PBuf = pbuf_alloc(PBUF_TRANSPORT, Length, STREAM_IS_FLASH(Data) ? PBUF_ROM : PBUF_REF);
+    if (PBuf == NULL) return -2;
+    PBuf->payload = (void *)Data;
+  }
+
+  ReturnCode = udp_sendto(Stream->UdpPcb, PBuf, &Stream->RemoteAddress, Stream->RemotePort);
+  pbuf_free(PBuf);
+  if (ReturnCode != ERR_OK) return -2;
+
+  Stream->TxBytes += Length;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_send_copy(). */
+/* ============================================================================================================================================================= *\
+                                         Send a payload through a copy (data may be reused as soon as the function returns).
+\* ============================================================================================================================================================= */
+INT16 stream_send_copy(struct struct_stream *Stream, const void *Data, UINT16 Length)
+{
+  INT16 ReturnCode;
+
+
+  WIFI_LWIP_BEGIN();
+  ReturnCode = stream_send(Stream, Data, Length, FLAG_ON);
+  WIFI_LWIP_END();
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_send_ref(). */
+/* ============================================================================================================================================================= *\
+                                       Send a payload by reference, without copy (see file header for how long data must stay valid).
+\* ============================================================================================================================================================= */
+INT16 stream_send_ref(struct struct_stream *Stream, const void *Data, UINT16 Length)
+{
+  INT16 ReturnCode;
+
+
+  WIFI_LWIP_BEGIN();
+  ReturnCode = stream_send(Stream, Data, Length, FLAG_OFF);
+  WIFI_LWIP_END();
+
+  return ReturnCode;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_send_space(). */
+/* ============================================================================================================================================================= *\
+                                              Return the number of bytes that may be sent right now (free TCP send buffer).
+\* ============================================================================================================================================================= */
+UINT16 stream_send_space(struct struct_stream *Stream)
+{
+  UINT16 Space;
+
+
+  Space = 0;
+
+  WIFI_LWIP_BEGIN();
+  if (Stream->State == STREAM_STATE_OPEN)
+  {
+    if (Stream->Type == STREAM_TYPE_TCP)
+      Space = tcp_sndbuf(Stream->TcpPcb);
+    else
+      Space = 0xFFFF;
+  }
+  WIFI_LWIP_END();
+
+  return Space;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_tcp_accept(). */
+/* ============================================================================================================================================================= *\
+                                                    TCP: incoming connection. Only one connection is accepted per stream.
+\* ============================================================================================================================================================= */
+static err_t stream_tcp_accept(void *Arg, struct tcp_pcb *NewPcb, err_t Error)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+
+  if ((Error != ERR_OK) || (NewPcb == NULL)) return ERR_VAL;
+
+  if (Stream->TcpPcb != NULL)
+  {
+    tcp_abort(NewPcb);
+    return ERR_ABRT;
+  }
+
+  Stream->TcpPcb        = NewPcb;
+  Stream->RemoteAddress = NewPcb->remote_ip;
+  Stream->RemotePort    = NewPcb->remote_port;
+  Stream->State         = STREAM_STATE_OPEN;
+
+  tcp_arg(NewPcb,  Stream);
+  tcp_err(NewPcb,  stream_tcp_error);
+  tcp_recv(NewPcb, stream_tcp_receive);
+  tcp_sent(NewPcb, stream_tcp_sent);
+
+  stream_notify(Stream, STREAM_EVENT_CONNECTED);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_tcp_connected(). */
+/* ============================================================================================================================================================= *\
+                                                                       TCP: connection established.
+\* ============================================================================================================================================================= */
+static err_t stream_tcp_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+
+  if (Error != ERR_OK) return Error;
+
+  Stream->State = STREAM_STATE_OPEN;
+  stream_notify(Stream, STREAM_EVENT_CONNECTED);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_tcp_error(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP: connection error (pcb has already been freed by lwIP).
+\* ============================================================================================================================================================= */
+static void stream_tcp_error(void *Arg, err_t Error)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+  if (Stream == NULL) return;
+
+  Stream->TcpPcb    = NULL;
+  Stream->State     = STREAM_STATE_CLOSED;
+  Stream->TxUnacked = 0;
+  stream_notify(Stream, STREAM_EVENT_ERROR);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_tcp_receive(). */
+/* ============================================================================================================================================================= *\
+                                                TCP: data received. When the queue is full, the chain is refused (ERR_MEM) and lwIP
+                                                         holds it and delivers it again later, so nothing is lost.
+\* ============================================================================================================================================================= */
+static err_t stream_tcp_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+
+  /* Connection closed by peer. Queued data remains available until stream_close(). */
+  if (PBuf == NULL)
+  {
+    Stream->State = STREAM_STATE_CLOSED;
+    stream_notify(Stream, STREAM_EVENT_CLOSED);
+
+    return ERR_OK;
+  }
+
+  if (stream_queue(Stream, PBuf) != 0) return ERR_MEM;
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_tcp_sent(). */
+/* ============================================================================================================================================================= *\
+                                                                         TCP: data acknowledged.
+\* ============================================================================================================================================================= */
+static err_t stream_tcp_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+
+  if (Length > Stream->TxUnacked)
+    Stream->TxUnacked = 0;
+  else
+    Stream->TxUnacked -= Length;
+
+  stream_notify(Stream, STREAM_EVENT_SENT);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=stream_udp_receive(). */
+/* ============================================================================================================================================================= *\
+                                                 UDP: datagram received. It is dropped when the queue is full.
+\* ============================================================================================================================================================= */
+static void stream_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, UINT16 Port)
+{
+  struct struct_stream *Stream;
+
+
+  Stream = (struct struct_stream *)Arg;
+
+  Stream->RemoteAddress = *Address;
+  Stream->RemotePort    = Port;
+
+  if (stream_queue(Stream, PBuf) != 0)
+  {
+    ++Stream->RxDrops;
+    pbuf_free(PBuf);
+  }
+
+  return;
+}
@@ -0,0 +1,120 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Stream.h
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+
+   Include file for Pico-WiFi-Stream.c
+\* ============================================================================================================================================================= */
+#ifndef _WIFI_STREAM_H
+#define _WIFI_STREAM_H
+
+#include "Pico-WiFi-Port.h"
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                          Definitions.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+#define STREAM_RX_QUEUE           8     // received pbuf chains held per stream until released (must be a power of 2).
+#define STREAM_BENCH_COUNT      200     // number of payloads sent / parsed by each pass of the benchmark.
+#define STREAM_BENCH_SIZE      1024     // size of each benchmark payload.
+#define STREAM_DISCARD_PORT       9     // UDP "discard" port, used as destination by the benchmark.
+
+/* Stream types. */
+#define STREAM_TYPE_TCP           1
+#define STREAM_TYPE_UDP           2
+
+/* Stream states. */
+#define STREAM_STATE_CLOSED       0
+#define STREAM_STATE_LISTEN       1     // TCP: waiting for a connection.
+#define STREAM_STATE_CONNECTING   2     // TCP: connection request sent.
+#define STREAM_STATE_OPEN         3
+
+/* Events reported to the stream callback (from lwIP context). */
+#define STREAM_EVENT_CONNECTED    1     // TCP connection established (or accepted).
+#define STREAM_EVENT_DATA         2     // a pbuf chain is available from stream_receive().
+#define STREAM_EVENT_SENT         3     // TCP data has been acknowledged, more data may be sent.
+#define STREAM_EVENT_CLOSED       4     // TCP connection closed by peer (queued data remains available).
+#define STREAM_EVENT_ERROR        5     // TCP connection aborted or reset.
+
+
+struct struct_stream;
+
+/* Stream event callback. Called from lwIP context, must not block. */
+typedef void (*stream_callback)(struct struct_stream *Stream, UINT8 Event, void *Context);
+
+
+/* Stream control block, allocated by the application (one per connection). */
+struct struct_stream
+{
+  UINT8  Type;
+  UINT8  State;
+  ip_addr_t RemoteAddress;                   // TCP: peer. UDP: destination of sends, then sender of the last datagram received.
+  UINT16 RemotePort;
+  UINT16 TxUnacked;                          // TCP: bytes queued by reference and not yet acknowledged (their data must stay valid).
+  UINT32 RxBytes;
+  UINT32 TxBytes;
+  UINT32 RxDrops;                            // UDP datagrams dropped because the receive queue was full.
+  UINT8  RxHead;                             // next chain to be returned by stream_receive().
+  UINT8  RxTail;                             // next free entry of RxQueue[].
+  struct pbuf *RxQueue[STREAM_RX_QUEUE];
+  struct tcp_pcb *ListenPcb;
+  struct tcp_pcb *TcpPcb;
+  struct udp_pcb *UdpPcb;
+  stream_callback Callback;
+  void *Context;
+};
+
+
+/* Result of stream_benchmark(). Times are totals in usec for STREAM_BENCH_COUNT payloads. */
+struct struct_stream_bench
+{
+  UINT32 SendRefUs;                          // UDP send, payload referenced from flash (PBUF_ROM).
+  UINT32 SendCopyUs;                         // UDP send, payload copied into a PBUF_RAM pbuf.
+  UINT16 SendRefErrors;
+  UINT16 SendCopyErrors;
+  UINT32 HeapRefMax;                         // lwIP heap high-water mark during each send pass (0 if MEM_STATS is not enabled).
+  UINT32 HeapCopyMax;
+  UINT32 ReceiveInPlaceUs;                   // consume a pbuf chain in place.
+  UINT32 ReceiveCopyUs;                      // copy the same chain to a buffer first, then consume it.
+};
+
+
+
+/* --------------------------------------------------------------------------------------------------------------------------- *\
+                                                       Functions prototype.
+\* --------------------------------------------------------------------------------------------------------------------------- */
+/* Compare zero-copy and copy-based send / receive paths on the same payloads. */
+INT16 stream_benchmark(const ip_addr_t *Address, struct struct_stream_bench *Bench);
+
+/* Close a stream and release all queued pbuf chains. */
+void stream_close(struct struct_stream *Stream);
+
+/* Display the result of stream_benchmark(). */
+void stream_display_benchmark(struct struct_stream_bench *Bench);
+
+/* Wait for one incoming TCP connection on a port. */
+INT16 stream_listen(struct struct_stream *Stream, UINT16 Port, stream_callback Callback, void *Context);
+
+/* Open a TCP connection to a peer. */
+INT16 stream_open_tcp(struct struct_stream *Stream, const ip_addr_t *Address, UINT16 Port, stream_callback Callback, void *Context);
+
+/* Open a UDP stream, bound to a local port and sending to a peer. */
+INT16 stream_open_udp(struct struct_stream *Stream, UINT16 LocalPort, const ip_addr_t *Address, UINT16 RemotePort, stream_callback Callback, void *Context);
+
+/* Take the next received pbuf chain, or NULL. The chain belongs to the caller until stream_release(). */
+struct pbuf *stream_receive(struct struct_stream *Stream);
+
+/* Give back a chain obtained from stream_receive(). For TCP, this opens the receive window. */
+void stream_release(struct struct_stream *Stream, struct pbuf *PBuf);
+
+/* Send a payload through a copy (data may be reused as soon as the function returns). */
+INT16 stream_send_copy(struct struct_stream *Stream, const void *Data, UINT16 Length);
+
+/* Send a payload by reference, without copy (data must stay valid, see Pico-WiFi-Stream.c). */
+INT16 stream_send_ref(struct struct_stream *Stream, const void *Data, UINT16 Length);
+
+/* Return the number of bytes that may be sent right now. */
+UINT16 stream_send_space(struct struct_stream *Stream);
+
+#endif  // _WIFI_STREAM_H
@@ -0,0 +1,35 @@
+// Status page of Pico-WiFi-Example: fetch the JSON endpoints of Pico-WiFi-HTTPD and fill the tables.
+"use strict";
+
+function rows(table, items) {
+  table.innerHTML = items.map(([name, value]) => "<tr><th>" + name + "</th><td class=\"n\">" + value + "</td></tr>").join("");
+}
+
+function escape(text) {
+  return String(text).replace(/[&<>"]/g, (c) => "&#" + c.charCodeAt(0) + ";");
+}
+
+async function refresh() {
+  try {
+    const status = await (await fetch("/status.json")).json();
+    document.getElementById("host").textContent = status.host;
+    document.title = status.host;
+    rows(document.getElementById("link"), [
+      ["Network", escape(status.ssid)], ["IP address", status.ip], ["MAC address", status.mac],
+      ["Link", status.link], ["RSSI", status.rssi + " dBm"], ["Health", status.health ? "OK" : "<span class=\"bad\">degraded</span>"],
+      ["Uptime", (status.uptime / 1000).toFixed(0) + " sec"]]);
+    rows(document.getElementById("counters"), [
+      ["Wi-Fi errors", status.errors], ["Link drops", status.linkdown], ["Reconnections", status.reconnect],
+      ["lwIP heap used", status.heap + " / " + status.heapsize + " bytes"], ["HTTP requests", status.requests]]);
+
+    const scan = await (await fetch("/scan.json")).json();
+    document.querySelector("#scan tbody").innerHTML = scan.networks.map((n) =>
+      "<tr><td>" + escape(n.ssid) + "</td><td class=\"n\">" + n.rssi + "</td><td class=\"n\">" + n.channel + "</td><td class=\"n\">" + n.mac +
+      "</td><td class=\"n\">" + n.security + "</td></tr>").join("");
+  } catch (error) {
+    document.getElementById("host").textContent = "Pico-WiFi (not responding)";
+  }
+  setTimeout(refresh, 5000);
+}
+
+refresh();
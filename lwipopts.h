@@ -20,27 +20,72 @@
 #define MEM_LIBC_MALLOC             0
 #endif
 #define MEM_ALIGNMENT               4
-#define MEM_SIZE                    4000
-#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL+1) 
-#define MEMP_NUM_TCP_SEG            32
-#define MEMP_NUM_ARP_QUEUE          10
-#define PBUF_POOL_SIZE              24
+#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL+7)   // ping, iperf, MQTT, SNTP, DNS cache, mDNS and HTTP client timers.
+#define MEMP_NUM_PBUF               24                                  // PBUF_ROM / PBUF_REF of data sent without copy (stream, iperf, status server).
+#define MEMP_NUM_UDP_PCB            8                                   // DHCP, DNS, DNS cache, SNTP, mDNS, iperf and stream UDP.
 #define LWIP_ARP                    1
 #define LWIP_ETHERNET               1
 #define LWIP_ICMP                   1
 #define LWIP_RAW                    1
-#define TCP_WND                     (8 * TCP_MSS)
 #define TCP_MSS                     1460
-#define TCP_SND_BUF                 (8 * TCP_MSS)
 #define TCP_SND_QUEUELEN            ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+
+// Memory / throughput profiles, selected with the WIFI_LWIP_PROFILE CMake option (see README).
+// Buffers are sized together so that lwIP sanity checks hold:
+// MEMP_NUM_TCP_SEG >= TCP_SND_QUEUELEN and PBUF_POOL_SIZE >= TCP_WND / TCP_MSS.
+#define LWIP_PROFILE_LOW_MEMORY      1
+#define LWIP_PROFILE_BALANCED        2
+#define LWIP_PROFILE_HIGH_THROUGHPUT 3
+#define LWIP_PROFILE_LOW_LATENCY     4
+#ifndef LWIP_PROFILE
+#define LWIP_PROFILE                LWIP_PROFILE_BALANCED
+#endif
+
+#if (LWIP_PROFILE == LWIP_PROFILE_LOW_MEMORY)
+// Smallest footprint, one TCP connection at a time at low rate (e.g. MQTT telemetry).
+#define MEM_SIZE                    2048
+#define PBUF_POOL_SIZE              8
+#define TCP_WND                     (2 * TCP_MSS)
+#define TCP_SND_BUF                 (2 * TCP_MSS)
+#define MEMP_NUM_TCP_SEG            8
+#define MEMP_NUM_TCP_PCB            3
+#define MEMP_NUM_ARP_QUEUE          4
+#elif (LWIP_PROFILE == LWIP_PROFILE_BALANCED)
+// Original configuration of Pico-WiFi-Module.
+#define MEM_SIZE                    4000
+#define PBUF_POOL_SIZE              24
+#define TCP_WND                     (8 * TCP_MSS)
+#define TCP_SND_BUF                 (8 * TCP_MSS)
+#define MEMP_NUM_TCP_SEG            32
+#define MEMP_NUM_ARP_QUEUE          10
+#elif (LWIP_PROFILE == LWIP_PROFILE_HIGH_THROUGHPUT)
+// Large windows to keep the air busy on bulk transfers.
+#define MEM_SIZE                    16000
+#define PBUF_POOL_SIZE              48
+#define TCP_WND                     (16 * TCP_MSS)
+#define TCP_SND_BUF                 (16 * TCP_MSS)
+#define MEMP_NUM_TCP_SEG            64
+#define MEMP_NUM_ARP_QUEUE          10
+#elif (LWIP_PROFILE == LWIP_PROFILE_LOW_LATENCY)
+// Small windows bound the data queued in lwIP and cyw43, keeping round-trip times short under load.
+// Applications should also disable Nagle (tcp_nagle_disable()) on interactive connections.
+#define MEM_SIZE                    4000
+#define PBUF_POOL_SIZE              16
+#define TCP_WND                     (4 * TCP_MSS)
+#define TCP_SND_BUF                 (4 * TCP_MSS)
+#define MEMP_NUM_TCP_SEG            16
+#define MEMP_NUM_ARP_QUEUE          10
+#else
+#error "Unknown LWIP_PROFILE (see WIFI_LWIP_PROFILE in CMakeLists.txt)"
+#endif
+#ifndef MEMP_NUM_TCP_PCB
+#define MEMP_NUM_TCP_PCB            11                                  // shell sessions, MQTT, HTTP client and status server connections, iperf.
+#endif
 #define LWIP_NETIF_STATUS_CALLBACK  1
 #define LWIP_NETIF_LINK_CALLBACK    1
+#define LWIP_NETIF_EXT_STATUS_CALLBACK  1                               // netif events of the health monitor and boot timeline (list of callbacks).
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
-#define SYS_STATS                   0
-#define MEMP_STATS                  0
-#define LINK_STATS                  0
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM       3
 #define LWIP_DHCP                   1
@@ -48,15 +93,51 @@
 #define LWIP_TCP                    1
 #define LWIP_UDP                    1
 #define LWIP_DNS                    1
+#define LWIP_IGMP                   1                                   // mDNS multicast group (cyw43 multicast filter is updated by the driver).
 #define LWIP_TCP_KEEPALIVE          1
-#define LWIP_NETIF_TX_SINGLE_PBUF   1
+#define LWIP_NETIF_TX_SINGLE_PBUF   0                                   // 1 forces TCP_WRITE_FLAG_COPY; cyw43 copies pbuf chains to its own buffer anyway.
 #define DHCP_DOES_ARP_CHECK         0
 #define LWIP_DHCP_DOES_ACD_CHECK    0
 
+// FreeRTOS (pico_cyw43_arch_lwip_sys_freertos, NO_SYS=0): lwIP runs in its own tcpip thread.
+// Core locking lets cyw43 and the raw API callers of Pico-WiFi-Module take the lwIP lock (cyw43_arch_lwip_begin())
+// instead of posting every packet and call to the tcpip thread.
+#if !NO_SYS
+#define TCPIP_THREAD_STACKSIZE      1024
+#define DEFAULT_THREAD_STACKSIZE    1024
+#define DEFAULT_RAW_RECVMBOX_SIZE   8
+#define DEFAULT_UDP_RECVMBOX_SIZE   8
+#define DEFAULT_TCP_RECVMBOX_SIZE   8
+#define DEFAULT_ACCEPTMBOX_SIZE     8
+#define TCPIP_MBOX_SIZE             8
+#define LWIP_TIMEVAL_PRIVATE        0
+#define LWIP_TCPIP_CORE_LOCKING_INPUT 1
+#endif  // !NO_SYS
+
+// Memory pool, heap and link statistics are always on (a few increments per allocation / packet), so that
+// pool exhaustion can be watched in production with wifi_stats_get(). Build with WIFI_LWIP_STATS=0 to compare.
+// Protocol statistics and stats_display() are only compiled in debug builds.
+#ifndef WIFI_LWIP_STATS
+#define WIFI_LWIP_STATS             1
+#endif
+#define SYS_STATS                   0
+#define MEM_STATS                   WIFI_LWIP_STATS
+#define MEMP_STATS                  WIFI_LWIP_STATS
+#define LINK_STATS                  WIFI_LWIP_STATS
+
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
 #define LWIP_STATS                  1
 #define LWIP_STATS_DISPLAY          1
+#else
+#define LWIP_STATS                  WIFI_LWIP_STATS
+#define ETHARP_STATS                0
+#define IP_STATS                    0
+#define IPFRAG_STATS                0
+#define ICMP_STATS                  0
+#define IGMP_STATS                  0
+#define UDP_STATS                   0
+#define TCP_STATS                   0
 #endif
 
 #define ETHARP_DEBUG                LWIP_DBG_OFF
@@ -0,0 +1,219 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-Config.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the configuration store (Pico-WiFi-Config.c) on its RAM image (see wifi_config_image()), built by tests/CMakeLists.txt.
+   Each "reboot" is a call to wifi_config_init(), which rebuilds the store from the image only.
+   - Append: values set before a reboot must be read back after it; an unchanged value must not be written again.
+   - CRC rejection: a corrupted record must be ignored (previous value of the key wins) and counted as an error; the next write must move
+     the valid records to a fresh sector.
+   - Power cut during compaction: a new sector whose header has not been written yet must be ignored, the previous sector remaining
+     the active one with all its values; the next compaction must then complete.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#define _GNU_SOURCE  // memmem().
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Pico-WiFi-Config.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_HEADER_SIZE      12     // sector header (CONFIG_HEADER_SIZE, private to Pico-WiFi-Config.c), written last by a compaction.
+#define TEST_KEY_COUNTER      (CONFIG_KEY_USER)       // number rewritten until the active sector is full.
+#define TEST_KEY_LABEL        (CONFIG_KEY_USER + 1)   // string set once, that must survive every compaction.
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the module under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Return TRUE if a key holds the expected string. */
+static UINT8 test_string_is(UINT8 Key, const UCHAR *Expected);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                             Log info (used by the module under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UINT8 *Image;
+  UINT8 OldSector;
+
+  UINT32 Counter;
+  UINT32 Errors;
+  UINT32 Value;
+  UINT32 Writes;
+
+  struct struct_config_stats Stats;
+
+
+  Image = wifi_config_image();
+  wifi_config_init();
+  wifi_config_format();
+
+  /* Append, then reboot. */
+  test_check(wifi_config_set_string(CONFIG_KEY_SSID, "alpha") == 0, "SSID saved");
+  test_check(wifi_config_set_u32(TEST_KEY_COUNTER, 1234) == 0, "number saved");
+  test_check(wifi_config_set_string(TEST_KEY_LABEL, "label") == 0, "label saved");
+  wifi_config_get_stats(&Stats);
+  Writes = Stats.Writes;
+  test_check(wifi_config_set_string(CONFIG_KEY_SSID, "alpha") == 0, "unchanged SSID accepted");
+  wifi_config_get_stats(&Stats);
+  test_check((Stats.Writes == Writes) && (Stats.WritesSkipped > 0), "unchanged SSID not written again");
+  test_check(wifi_config_set_string(CONFIG_KEY_SSID, "bravo") == 0, "new SSID appended");
+
+  wifi_config_init();
+  test_check(test_string_is(CONFIG_KEY_SSID, "bravo"), "latest SSID read back after reboot");
+  test_check((wifi_config_get_u32(TEST_KEY_COUNTER, &Value) == 0) && (Value == 1234), "number read back after reboot");
+  test_check(test_string_is(TEST_KEY_LABEL, "label"), "label read back after reboot");
+
+  /* CRC rejection: corrupt the value of the latest SSID record. */
+  wifi_config_get_stats(&Stats);
+  Errors    = Stats.Errors;
+  OldSector = Stats.ActiveSector;
+  ((UINT8 *)memmem(Image, CONFIG_SECTORS * CONFIG_SECTOR_SIZE, "bravo", 5))[0] ^= 0x01;
+  wifi_config_init();
+  wifi_config_get_stats(&Stats);
+  test_check(Stats.Errors > Errors, "corrupted record counted as an error");
+  test_check(test_string_is(CONFIG_KEY_SSID, "alpha"), "corrupted record ignored, previous SSID wins");
+  test_check(test_string_is(TEST_KEY_LABEL, "label"), "records before the corrupted one kept");
+  test_check(wifi_config_set_string(CONFIG_KEY_SSID, "charlie") == 0, "SSID saved after corruption");
+  wifi_config_get_stats(&Stats);
+  test_check(Stats.ActiveSector != OldSector, "write after corruption moved to a fresh sector");
+  wifi_config_init();
+  test_check(test_string_is(CONFIG_KEY_SSID, "charlie"), "SSID read back from the fresh sector");
+  test_check(test_string_is(TEST_KEY_LABEL, "label"), "label copied to the fresh sector");
+
+  /* Fill the active sector until the next write compacts it. */
+  wifi_config_get_stats(&Stats);
+  OldSector = Stats.ActiveSector;
+  for (Counter = 1; Stats.ActiveSector == OldSector; ++Counter)
+  {
+    if (wifi_config_set_u32(TEST_KEY_COUNTER, Counter) != 0) break;
+    wifi_config_get_stats(&Stats);
+  }
+  --Counter;  // value whose write triggered the compaction.
+  test_check(Stats.ActiveSector == ((OldSector + 1) % CONFIG_SECTORS), "full sector compacted to the next one of the ring");
+
+  /* Power cut during compaction: records copied, header not written yet. */
+  memset(&Image[Stats.ActiveSector * CONFIG_SECTOR_SIZE], 0xFF, TEST_HEADER_SIZE);
+  wifi_config_init();
+  wifi_config_get_stats(&Stats);
+  test_check(Stats.ActiveSector == OldSector, "sector without header ignored, previous sector still active");
+  test_check((wifi_config_get_u32(TEST_KEY_COUNTER, &Value) == 0) && (Value == (Counter - 1)), "last value before the power cut kept");
+  test_check(test_string_is(CONFIG_KEY_SSID, "charlie"), "SSID kept after the power cut");
+
+  /* Write again: compaction completes this time. */
+  test_check(wifi_config_set_u32(TEST_KEY_COUNTER, Counter) == 0, "number saved after the power cut");
+  wifi_config_init();
+  wifi_config_get_stats(&Stats);
+  test_check(Stats.ActiveSector == ((OldSector + 1) % CONFIG_SECTORS), "compaction completed after the power cut");
+  test_check((wifi_config_get_u32(TEST_KEY_COUNTER, &Value) == 0) && (Value == Counter), "number read back after compaction");
+  test_check(test_string_is(TEST_KEY_LABEL, "label"), "label survived every compaction");
+
+  wifi_config_display();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_string_is(). */
+/* ============================================================================================================================================================= *\
+                                                              Return TRUE if a key holds the expected string.
+\* ============================================================================================================================================================= */
+static UINT8 test_string_is(UINT8 Key, const UCHAR *Expected)
+{
+  UCHAR String[CONFIG_MAX_VALUE + 1];
+
+
+  if (wifi_config_get_string(Key, String, sizeof(String)) < 0) return FALSE;
+
+  return (strcmp(String, Expected) == 0);
+}
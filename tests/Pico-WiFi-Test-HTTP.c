@@ -0,0 +1,611 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-HTTP.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the HTTP client (Pico-WiFi-HTTP.c) against a small HTTP/1.1 server of its own, on lwIP's loopback netif (127.0.0.1),
+   built by tests/CMakeLists.txt. The server answers each request as soon as it is complete, so pipelined requests are answered in order.
+   - Pipeline slot accounting: HTTP_QUEUE_SIZE requests queued at once fill the pipelines of HTTP_MAX_CONNECTIONS connections, one more is
+     refused, and every slot is free again once all responses are complete. The next request reuses an open connection.
+   - Response parser: Content-Length and chunked bodies (chunk extension and trailer included), and a header line split across two segments.
+   - Chunked encoder: a streaming upload is decoded by the server, which checks its length, its content and its number of chunks.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#define _GNU_SOURCE  // memmem().
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+
+#include "Pico-WiFi-HTTP.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_PORT           8080     // port of the test server.
+#define TEST_PEERS             4     // connections accepted by the test server at the same time.
+#define TEST_BUFFER_SIZE    4096     // request being received by the test server (head and body).
+#define TEST_UPLOAD_SIZE    2000     // bytes of the streaming upload.
+#define TEST_UPLOAD_STEP     300     // most bytes given by the producer at each call (several chunks per upload).
+#define TEST_WAIT_MSEC      5000     // longest wait for the pending requests.
+
+
+/* Response received by the client. */
+struct struct_test_result
+{
+  UINT8  FlagDone;
+  UINT8  FlagError;
+  UINT16 Status;
+  UINT16 Length;
+  UCHAR  Body[64];
+};
+
+
+/* Connection accepted by the test server. */
+struct struct_test_peer
+{
+  struct tcp_pcb *Pcb;
+  UINT16 Length;                               // bytes received in Buffer[], not answered yet.
+  const UCHAR *Pending;                        // end of a response, written once its beginning has been acknowledged.
+  UCHAR  Buffer[TEST_BUFFER_SIZE];
+};
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+static UINT32 UploadOffset;                    // bytes given by the producer.
+
+static struct
+{
+  struct tcp_pcb *Listen;
+  UINT8  FlagUploadOk;                         // content of the last upload as produced.
+  UINT32 UploadLength;                         // decoded length of the last upload.
+  UINT32 UploadChunks;                         // chunks of the last upload, last chunk excluded.
+  struct struct_test_peer Peer[TEST_PEERS];
+} Server;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the modules under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Response callback of the client. */
+static void test_client_callback(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context);
+
+/* Body producer of the streaming upload. */
+static INT32 test_producer(UCHAR *Buffer, UINT16 Size, void *Context);
+
+/* Service lwIP (loopback netif and timeouts) until no request is pending or the specified time has elapsed. */
+static void test_run(UINT32 Msec);
+
+/* Test server: connection accepted. */
+static err_t test_server_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* Test server: connection reset (pcb already freed by lwIP). */
+static void test_server_error(void *Arg, err_t Error);
+
+/* Test server: data received. */
+static err_t test_server_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* Test server: answer the first request of the buffer if it is complete. */
+static UINT16 test_server_request(struct struct_test_peer *Peer);
+
+/* Test server: data acknowledged. */
+static err_t test_server_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                            Log info (used by the modules under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UINT8 FlagOk;
+  UINT8 Loop1UInt8;
+
+  UINT32 Chunks;
+  UINT32 LinesCopied;
+  UINT32 Reused;
+
+  struct tcp_pcb *Pcb;
+
+  struct struct_http_request Request;
+  struct struct_http_stats   Stats;
+  struct struct_test_result  Result[HTTP_QUEUE_SIZE];
+
+
+  lwip_init();
+
+  Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  tcp_bind(Pcb, IP_ANY_TYPE, TEST_PORT);
+  Server.Listen = tcp_listen(Pcb);
+  tcp_accept(Server.Listen, test_server_accept);
+
+  memset(&Request, 0x00, sizeof(Request));
+  ip_addr_set_loopback(0, &Request.Address);
+  Request.Port     = TEST_PORT;
+  Request.Method   = "GET";
+  Request.Callback = test_client_callback;
+
+  /* Fill every request slot at once: the pipelines of all connections are used, one more request is refused. */
+  memset(Result, 0x00, sizeof(Result));
+  FlagOk = FLAG_ON;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+  {
+    Request.Path    = (Loop1UInt8 & 1) ? "/chunked" : "/fixed";
+    Request.Context = &Result[Loop1UInt8];
+    if (wifi_http_request(&Request) != 0) FlagOk = FLAG_OFF;
+  }
+  test_check(FlagOk, "HTTP_QUEUE_SIZE requests queued");
+  test_check(wifi_http_request(&Request) == -2, "one more request refused while all slots are in use");
+  wifi_http_get_stats(&Stats);
+  test_check((Stats.QueueFull == 1) && (Stats.Pending == HTTP_QUEUE_SIZE), "refused request counted, every slot pending");
+
+  test_run(TEST_WAIT_MSEC);
+  FlagOk = FLAG_ON;
+  for (Loop1UInt8 = 0; Loop1UInt8 < HTTP_QUEUE_SIZE; ++Loop1UInt8)
+  {
+    if ((Result[Loop1UInt8].FlagDone == FLAG_OFF) || (Result[Loop1UInt8].Status != 200)) FlagOk = FLAG_OFF;
+    if (strcmp(Result[Loop1UInt8].Body, (Loop1UInt8 & 1) ? "hello world" : "hello") != 0) FlagOk = FLAG_OFF;
+  }
+  test_check(FlagOk, "every response complete, Content-Length and chunked bodies as sent by the server");
+  wifi_http_get_stats(&Stats);
+  test_check((Stats.Completed == HTTP_QUEUE_SIZE) && (Stats.Errors == 0) && (Stats.Pending == 0), "every slot free again, no error");
+  test_check((Stats.Connects == HTTP_MAX_CONNECTIONS) && (Stats.Connections == HTTP_MAX_CONNECTIONS), "HTTP_MAX_CONNECTIONS connections opened and kept open");
+  test_check(Stats.PipelineMax == HTTP_PIPELINE_MAX, "pipeline filled up to HTTP_PIPELINE_MAX");
+  test_check(Stats.Pipelined == (HTTP_QUEUE_SIZE - HTTP_MAX_CONNECTIONS), "every request but the first of each connection pipelined");
+
+  /* Keep-alive: next request reuses an open connection. */
+  Reused = Stats.Reused;
+  memset(Result, 0x00, sizeof(Result));
+  Request.Path    = "/fixed";
+  Request.Context = &Result[0];
+  wifi_http_request(&Request);
+  test_run(TEST_WAIT_MSEC);
+  wifi_http_get_stats(&Stats);
+  test_check(Result[0].FlagDone && (strcmp(Result[0].Body, "hello") == 0), "response on a reused connection");
+  test_check((Stats.Reused == (Reused + 1)) && (Stats.Connects == HTTP_MAX_CONNECTIONS), "connection reused, no new handshake");
+
+  /* Header line split across two segments. */
+  LinesCopied = Stats.LinesCopied;
+  memset(Result, 0x00, sizeof(Result));
+  Request.Path    = "/split";
+  Request.Context = &Result[0];
+  wifi_http_request(&Request);
+  test_run(TEST_WAIT_MSEC);
+  wifi_http_get_stats(&Stats);
+  test_check(Result[0].FlagDone && (strcmp(Result[0].Body, "ok") == 0), "response with a header line split across two segments");
+  test_check(Stats.LinesCopied > LinesCopied, "split header line reassembled");
+
+  /* Streaming upload, sent with chunked transfer encoding. */
+  Chunks = Stats.Chunks;
+  memset(Result, 0x00, sizeof(Result));
+  Request.Method   = "POST";
+  Request.Path     = "/upload";
+  Request.Producer = test_producer;
+  Request.Context  = &Result[0];
+  UploadOffset     = 0;
+  wifi_http_request(&Request);
+  test_run(TEST_WAIT_MSEC);
+  wifi_http_get_stats(&Stats);
+  log_info(__LINE__, __func__, "Upload: %lu bytes in %lu chunks (server decoded %lu bytes in %lu chunks).", (unsigned long)TEST_UPLOAD_SIZE,
+           (unsigned long)(Stats.Chunks - Chunks), (unsigned long)Server.UploadLength, (unsigned long)Server.UploadChunks);
+  test_check(Result[0].FlagDone && (Result[0].Status == 200), "streaming upload answered");
+  test_check((Server.UploadLength == TEST_UPLOAD_SIZE) && (Server.FlagUploadOk == FLAG_ON), "chunked body decoded by the server as produced");
+  test_check((Server.UploadChunks > 1) && (Server.UploadChunks == (Stats.Chunks - Chunks)), "one chunk per producer call");
+
+  /* Stop: connections closed, nothing pending. */
+  wifi_http_stop();
+  wifi_http_get_stats(&Stats);
+  test_check((Stats.Connections == 0) && (Stats.Pending == 0) && (Stats.Errors == 0), "client stopped, no error");
+  test_run(100);
+
+  wifi_http_display_stats();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_callback(). */
+/* ============================================================================================================================================================= *\
+                                      Response callback of the client: keep the beginning of the body and the final status.
+\* ============================================================================================================================================================= */
+static void test_client_callback(UINT8 Event, const struct struct_http_response *Response, const UCHAR *Data, UINT16 Length, void *Context)
+{
+  struct struct_test_result *Result;
+
+
+  Result = (struct struct_test_result *)Context;
+
+  switch (Event)
+  {
+    case (HTTP_EVENT_BODY):
+      if (Length > (sizeof(Result->Body) - 1 - Result->Length)) Length = sizeof(Result->Body) - 1 - Result->Length;
+      memcpy(&Result->Body[Result->Length], Data, Length);
+      Result->Length += Length;
+    break;
+
+    case (HTTP_EVENT_DONE):
+      Result->Status   = Response->Status;
+      Result->FlagDone = FLAG_ON;
+    break;
+
+    case (HTTP_EVENT_ERROR):
+      Result->FlagError = FLAG_ON;
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_producer(). */
+/* ============================================================================================================================================================= *\
+                           Body producer of the streaming upload: TEST_UPLOAD_SIZE letters, at most TEST_UPLOAD_STEP bytes at each call.
+\* ============================================================================================================================================================= */
+static INT32 test_producer(UCHAR *Buffer, UINT16 Size, void *Context)
+{
+  UINT16 Loop1UInt16;
+
+
+  if (UploadOffset >= TEST_UPLOAD_SIZE) return -1;
+
+  if (Size > TEST_UPLOAD_STEP) Size = TEST_UPLOAD_STEP;
+  if (Size > (TEST_UPLOAD_SIZE - UploadOffset)) Size = TEST_UPLOAD_SIZE - UploadOffset;
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Size; ++Loop1UInt16)
+    Buffer[Loop1UInt16] = 'A' + ((UploadOffset + Loop1UInt16) % 26);
+  UploadOffset += Size;
+
+  return Size;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_run(). */
+/* ============================================================================================================================================================= *\
+                               Service lwIP (loopback netif and timeouts) until no request is pending or the specified time has elapsed.
+\* ============================================================================================================================================================= */
+static void test_run(UINT32 Msec)
+{
+  UINT64 EndTime;
+
+  struct timespec Delay = {0, 1000000};
+
+  struct struct_http_stats Stats;
+
+
+  EndTime = WIFI_TIME_US() + (Msec * 1000ull);
+  while (WIFI_TIME_US() < EndTime)
+  {
+    netif_poll_all();
+    sys_check_timeouts();
+    nanosleep(&Delay, NULL);
+
+    wifi_http_get_stats(&Stats);
+    if (Stats.Pending == 0) break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_server_accept(). */
+/* ============================================================================================================================================================= *\
+                                                               Test server: connection accepted.
+\* ============================================================================================================================================================= */
+static err_t test_server_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  UINT8 Loop1UInt8;
+
+
+  if ((Error != ERR_OK) || (Pcb == NULL)) return ERR_VAL;
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < TEST_PEERS; ++Loop1UInt8)
+    if (Server.Peer[Loop1UInt8].Pcb == NULL) break;
+
+  if (Loop1UInt8 == TEST_PEERS)
+  {
+    tcp_abort(Pcb);
+    return ERR_ABRT;
+  }
+
+  Server.Peer[Loop1UInt8].Pcb     = Pcb;
+  Server.Peer[Loop1UInt8].Length  = 0;
+  Server.Peer[Loop1UInt8].Pending = NULL;
+  tcp_arg(Pcb,  &Server.Peer[Loop1UInt8]);
+  tcp_err(Pcb,  test_server_error);
+  tcp_recv(Pcb, test_server_receive);
+  tcp_sent(Pcb, test_server_sent);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_server_error(). */
+/* ============================================================================================================================================================= *\
+                                                    Test server: connection reset (pcb already freed by lwIP).
+\* ============================================================================================================================================================= */
+static void test_server_error(void *Arg, err_t Error)
+{
+  ((struct struct_test_peer *)Arg)->Pcb = NULL;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_server_receive(). */
+/* ============================================================================================================================================================= *\
+                                   Test server: data received. Requests are answered as soon as they are complete, in order.
+\* ============================================================================================================================================================= */
+static err_t test_server_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  UINT16 Used;
+
+  struct struct_test_peer *Peer;
+
+
+  Peer = (struct struct_test_peer *)Arg;
+
+  if (PBuf == NULL)
+  {
+    /* Closed by the client. */
+    tcp_arg(Pcb, NULL);
+    tcp_err(Pcb, NULL);
+    tcp_recv(Pcb, NULL);
+    tcp_sent(Pcb, NULL);
+    tcp_close(Pcb);
+    Peer->Pcb = NULL;
+    return ERR_OK;
+  }
+
+  if ((Peer->Length + PBuf->tot_len) > TEST_BUFFER_SIZE)
+  {
+    test_check(FALSE, "request fits in the buffer of the test server");
+    pbuf_free(PBuf);
+    tcp_abort(Pcb);
+    Peer->Pcb = NULL;
+    return ERR_ABRT;
+  }
+
+  pbuf_copy_partial(PBuf, &Peer->Buffer[Peer->Length], PBuf->tot_len, 0);
+  Peer->Length += PBuf->tot_len;
+  tcp_recved(Pcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+
+  while ((Used = test_server_request(Peer)) != 0)
+  {
+    Peer->Length -= Used;
+    memmove(Peer->Buffer, &Peer->Buffer[Used], Peer->Length);
+  }
+  tcp_output(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_server_request(). */
+/* ============================================================================================================================================================= *\
+                  Test server: answer the first request of the buffer if it is complete (head, and body with Content-Length or chunked encoding).
+                                                      Return the size of the request, or 0 if it is not complete yet.
+\* ============================================================================================================================================================= */
+static UINT16 test_server_request(struct struct_test_peer *Peer)
+{
+  UCHAR *End;
+  UCHAR *Path;
+  UCHAR Response[128];
+
+  UINT8 FlagUploadOk;
+
+  UINT16 HeadLength;
+  UINT16 Offset;
+
+  UINT32 Chunks;
+  UINT32 Size;
+  UINT32 UploadLength;
+
+
+  End = memmem(Peer->Buffer, Peer->Length, "\r\n\r\n", 4);
+  if (End == NULL) return 0;
+  HeadLength = (End - Peer->Buffer) + 4;
+  Offset     = HeadLength;
+
+  Chunks       = 0;
+  UploadLength = 0;
+  FlagUploadOk = FLAG_ON;
+  if (memmem(Peer->Buffer, HeadLength, "\r\nTransfer-Encoding: chunked\r\n", 30) != NULL)
+  {
+    /* Chunked body: hexadecimal size, <CR><LF>, data, <CR><LF>; last chunk of size 0 followed by an empty trailer. */
+    while (1)
+    {
+      End = memmem(&Peer->Buffer[Offset], Peer->Length - Offset, "\r\n", 2);
+      if (End == NULL) return 0;
+      Size   = strtoul(&Peer->Buffer[Offset], NULL, 16);
+      Offset = (End - Peer->Buffer) + 2;
+      if ((Offset + Size + 2) > Peer->Length) return 0;
+      if (Size == 0) break;
+
+      for (; Size; --Size, ++Offset, ++UploadLength)
+        if (Peer->Buffer[Offset] != ('A' + (UploadLength % 26))) FlagUploadOk = FLAG_OFF;
+      if (memcmp(&Peer->Buffer[Offset], "\r\n", 2) != 0) FlagUploadOk = FLAG_OFF;
+      Offset += 2;
+      ++Chunks;
+    }
+    if (memcmp(&Peer->Buffer[Offset], "\r\n", 2) != 0) FlagUploadOk = FLAG_OFF;
+    Offset += 2;
+
+    Server.UploadLength = UploadLength;
+    Server.UploadChunks = Chunks;
+    Server.FlagUploadOk = FlagUploadOk;
+  }
+  else if ((End = memmem(Peer->Buffer, HeadLength, "\r\nContent-Length: ", 18)) != NULL)
+  {
+    Size = strtoul(&End[18], NULL, 10);
+    if ((Offset + Size) > Peer->Length) return 0;
+    Offset += Size;
+  }
+
+  /* Path of the request line. */
+  Path = memchr(Peer->Buffer, ' ', HeadLength);
+  if (Path == NULL) return Offset;
+  ++Path;
+
+  if (memcmp(Path, "/fixed ", 7) == 0)
+  {
+    strcpy(Response, "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello");
+  }
+  else if (memcmp(Path, "/chunked ", 9) == 0)
+  {
+    strcpy(Response, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n");
+  }
+  else if (memcmp(Path, "/split ", 7) == 0)
+  {
+    /* End of the response is written once this segment has been acknowledged. */
+    strcpy(Response, "HTTP/1.1 200 OK\r\nContent-Le");
+    Peer->Pending = "ngth: 2\r\n\r\nok";
+  }
+  else if (memcmp(Path, "/upload ", 8) == 0)
+  {
+    strcpy(Response, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+  }
+  else
+  {
+    strcpy(Response, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+  }
+  tcp_write(Peer->Pcb, Response, strlen(Response), TCP_WRITE_FLAG_COPY);
+
+  return Offset;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_server_sent(). */
+/* ============================================================================================================================================================= *\
+                                              Test server: data acknowledged, write the end of a split response.
+\* ============================================================================================================================================================= */
+static err_t test_server_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  struct struct_test_peer *Peer;
+
+
+  Peer = (struct struct_test_peer *)Arg;
+
+  if (Peer->Pending != NULL)
+  {
+    tcp_write(Pcb, Peer->Pending, strlen(Peer->Pending), TCP_WRITE_FLAG_COPY);
+    tcp_output(Pcb);
+    Peer->Pending = NULL;
+  }
+
+  return ERR_OK;
+}
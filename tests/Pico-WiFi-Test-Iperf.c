@@ -0,0 +1,637 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-Iperf.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the iperf2 benchmark (Pico-WiFi-Iperf.c) on lwIP's loopback netif (127.0.0.1), built by tests/CMakeLists.txt.
+   The test plays the part of the stock iperf2 peer for each of the four modes:
+   - TCP source: a sink of the test checks the client header, counts the bytes received and sees a normal close (FIN, no RST).
+     Bytes acknowledged in the report must all have reached the sink, at most one send buffer behind it.
+   - TCP sink: a source of the test sends a known number of bytes then closes; the report must count them all and the sink must
+     close its side normally, then keep listening for the next session.
+   - UDP source: a sink of the test counts the datagrams, then answers the final datagram with a server report, which must be
+     decoded into the report of the source (loss and jitter).
+   - UDP sink: a source of the test sends numbered datagrams with two of them missing and one out of order; the report and the server
+     report sent back in answer to the final datagram must agree with what was sent.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+
+#include "Pico-WiFi-Iperf.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_PORT_TCP_SOURCE   5001     // sink of the test, for the TCP source.
+#define TEST_PORT_TCP_SINK     5002     // iperf TCP sink.
+#define TEST_PORT_UDP_SOURCE   5003     // sink of the test, for the UDP source.
+#define TEST_PORT_UDP_SINK     5004     // iperf UDP sink.
+#define TEST_DURATION_SEC         1     // duration of the source tests.
+#define TEST_BANDWIDTH_KBPS    2000     // bandwidth of the UDP source.
+#define TEST_UPLOAD_SIZE     100000     // bytes sent by the source of the test to the TCP sink.
+#define TEST_DATAGRAMS           50     // datagrams sent by the source of the test to the UDP sink (final datagram excluded).
+#define TEST_DATAGRAM_SIZE      100     // size of these datagrams.
+#define TEST_REPORT_LOST          3     // datagrams lost, as given by the server report of the test.
+#define TEST_REPORT_JITTER_US  2000     // jitter, as given by the server report of the test.
+#define TEST_WAIT_MSEC         5000     // longest wait for the end of a test.
+
+/* iperf2 wire format (private to Pico-WiFi-Iperf.c): datagram header, client header and server report, 32-bit fields in network byte order. */
+#define TEST_DATAGRAM_HEADER     12     // Id, Sec, Usec.
+#define TEST_CLIENT_HEADER       24     // Flags, NumThreads, Port, BufferLength, WinBand, Amount.
+#define TEST_SERVER_HEADER       40     // Flags, TotalLength1, TotalLength2, StopSec, StopUsec, ErrorCount, OutOfOrder, Datagrams, Jitter1, Jitter2.
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+/* Chunk written by the TCP source of the test. */
+static const UCHAR TestChunk[1000] = {'i'};
+
+/* Peer of the benchmark, played by the test. */
+static struct
+{
+  UINT8  FlagDone;                             // peer has seen the end of the test.
+  UINT8  FlagFin;                              // connection closed normally by the benchmark.
+  UINT8  FlagReset;                            // connection reset.
+  UINT8  FlagShut;                             // TCP source of the test: FIN sent.
+  UINT8  HeaderLength;                         // bytes of the client header received.
+  UINT32 Header[TEST_CLIENT_HEADER / 4];       // client header received (network byte order).
+  UINT32 Received;                             // TCP bytes received, client header excluded.
+  UINT32 Sent;                                 // TCP bytes written by the source of the test.
+  UINT32 Datagrams;                            // UDP datagrams received, final datagram excluded.
+  UINT32 DatagramBytes;
+  INT32  FinalId;                              // id of the last final datagram received.
+  UINT32 ServerReport[TEST_SERVER_HEADER / 4];  // server report received (host byte order).
+  struct tcp_pcb *Listen;
+  struct tcp_pcb *Pcb;
+  struct udp_pcb *Udp;
+} Peer;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the module under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Tell if both the peer and the benchmark have seen the end of the test. */
+static UINT8 test_finished(void);
+
+/* Peer: TCP connection reset (pcb already freed by lwIP). */
+static void test_peer_error(void *Arg, err_t Error);
+
+/* Service lwIP (loopback netif and timeouts) until the test is finished or the specified time has elapsed. */
+static void test_run(UINT32 Msec);
+
+/* TCP sink of the test: connection accepted. */
+static err_t test_sink_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP sink of the test: data received. */
+static err_t test_sink_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP source of the test: connection established. */
+static err_t test_source_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* TCP source of the test: queue as much data as the send buffer allows, then close the sending side. */
+static void test_source_fill(struct tcp_pcb *Pcb);
+
+/* TCP source of the test: data (or end of connection) received. */
+static err_t test_source_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* TCP source of the test: data acknowledged. */
+static err_t test_source_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+/* UDP peer of the test: datagram received. */
+static void test_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, u16_t Port);
+
+/* UDP source of the test: send one datagram to the UDP sink. */
+static void test_udp_send(INT32 Id);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                            Log info (used by the module under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UINT8 Loop1UInt8;
+
+  UINT32 Bytes;
+  UINT32 Expected;
+
+  /* Order in which the UDP source of the test sends its datagrams: 10 and 20 are lost, 30 comes after 31. */
+  static const UINT8 Order[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 18, 19, 21, 22, 23, 24, 25, 26, 27, 28, 29, 31, 30,
+                                32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49};
+
+  struct struct_iperf_report   Report;
+  struct struct_iperf_settings Settings;
+
+
+  lwip_init();
+
+  /* TCP source, to a sink of the test. */
+  memset(&Peer, 0x00, sizeof(Peer));
+  Peer.Listen = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  tcp_bind(Peer.Listen, IP_ANY_TYPE, TEST_PORT_TCP_SOURCE);
+  Peer.Listen = tcp_listen(Peer.Listen);
+  tcp_accept(Peer.Listen, test_sink_accept);
+
+  memset(&Settings, 0x00, sizeof(Settings));
+  Settings.Mode = IPERF_MODE_TCP_CLIENT;
+  ip_addr_set_loopback(0, &Settings.RemoteAddress);
+  Settings.Port        = TEST_PORT_TCP_SOURCE;
+  Settings.DurationSec = TEST_DURATION_SEC;
+  test_check(iperf_start(&Settings) == 0, "TCP source started");
+  test_check(iperf_start(&Settings) != 0, "second benchmark refused while one is running");
+  test_run(TEST_WAIT_MSEC + (TEST_DURATION_SEC * 1000));
+  iperf_get_report(&Report);
+  iperf_display_report();
+  test_check(Report.FlagComplete && !iperf_is_running(), "TCP source complete after its duration");
+  test_check(Peer.FlagFin && !Peer.FlagReset, "TCP source closed its connection normally (FIN, no RST)");
+  test_check((Peer.HeaderLength == TEST_CLIENT_HEADER) && (lwip_ntohl(Peer.Header[5]) == (UINT32)-(TEST_DURATION_SEC * 100)) &&
+             (lwip_ntohl(Peer.Header[2]) == TEST_PORT_TCP_SOURCE), "client header received first, with duration and port");
+  log_info(__LINE__, __func__, "TCP source: %llu bytes acknowledged, %lu received by the sink.", Report.Bytes, (unsigned long)Peer.Received);
+  test_check((Report.Bytes > 0) && (Peer.Received >= Report.Bytes) && ((Peer.Received - Report.Bytes) <= TCP_SND_BUF),
+             "bytes acknowledged all received by the sink, at most one send buffer behind");
+  test_check((Report.ElapsedUs >= (TEST_DURATION_SEC * 1000000ull)) && (Report.ThroughputKbps == (UINT32)((Report.Bytes * 8000ull) / Report.ElapsedUs)),
+             "elapsed time and throughput of the report");
+  test_check(Report.WriteMemErrors == 0, "send-queue backpressure not counted as memory errors");
+  tcp_close(Peer.Listen);
+
+  /* TCP sink, from a source of the test. */
+  memset(&Peer, 0x00, sizeof(Peer));
+  memset(&Settings, 0x00, sizeof(Settings));
+  Settings.Mode = IPERF_MODE_TCP_SERVER;
+  Settings.Port = TEST_PORT_TCP_SINK;
+  test_check(iperf_start(&Settings) == 0, "TCP sink listening");
+  Peer.Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  tcp_err(Peer.Pcb, test_peer_error);
+  tcp_recv(Peer.Pcb, test_source_receive);
+  tcp_sent(Peer.Pcb, test_source_sent);
+  tcp_connect(Peer.Pcb, &Settings.RemoteAddress, TEST_PORT_TCP_SINK, test_source_connected);
+  test_run(TEST_WAIT_MSEC);
+  iperf_get_report(&Report);
+  iperf_display_report();
+  test_check(Report.FlagComplete && (Report.Bytes == TEST_UPLOAD_SIZE), "TCP sink counted every byte sent");
+  test_check(Peer.FlagFin && !Peer.FlagReset, "TCP sink closed its side normally (FIN, no RST)");
+  test_check(iperf_is_running(), "TCP sink still listening for the next session");
+  iperf_stop();
+  test_check(!iperf_is_running(), "TCP sink stopped");
+
+  /* UDP source, to a sink of the test that sends back a server report. */
+  memset(&Peer, 0x00, sizeof(Peer));
+  Peer.Udp = udp_new_ip_type(IPADDR_TYPE_ANY);
+  udp_bind(Peer.Udp, IP_ANY_TYPE, TEST_PORT_UDP_SOURCE);
+  udp_recv(Peer.Udp, test_udp_receive, NULL);
+
+  memset(&Settings, 0x00, sizeof(Settings));
+  Settings.Mode = IPERF_MODE_UDP_CLIENT;
+  ip_addr_set_loopback(0, &Settings.RemoteAddress);
+  Settings.Port          = TEST_PORT_UDP_SOURCE;
+  Settings.DurationSec   = TEST_DURATION_SEC;
+  Settings.BandwidthKbps = TEST_BANDWIDTH_KBPS;
+  test_check(iperf_start(&Settings) == 0, "UDP source started");
+  test_run(TEST_WAIT_MSEC + (TEST_DURATION_SEC * 1000));
+  iperf_get_report(&Report);
+  iperf_display_report();
+  Expected = (TEST_BANDWIDTH_KBPS * 1000 / 8) * TEST_DURATION_SEC;
+  test_check(Report.FlagComplete && Report.FlagServerReport && !iperf_is_running(), "UDP source complete, server report received");
+  test_check((Report.Datagrams == Peer.Datagrams) && (Report.Bytes == Peer.DatagramBytes), "datagrams and bytes sent all received by the sink");
+  test_check(Peer.FinalId == -(INT32)Report.Datagrams, "final datagram numbered after the last one");
+  test_check((Report.Bytes >= (Expected / 2)) && (Report.Bytes <= (Expected + IPERF_DEFAULT_DATAGRAM)), "bytes sent paced on the requested bandwidth");
+  test_check((Report.Lost == TEST_REPORT_LOST) && (Report.OutOfOrder == 1) && (Report.JitterUs == TEST_REPORT_JITTER_US), "loss and jitter taken from the server report");
+  udp_remove(Peer.Udp);
+
+  /* UDP sink, from a source of the test. */
+  memset(&Peer, 0x00, sizeof(Peer));
+  Peer.Udp = udp_new_ip_type(IPADDR_TYPE_ANY);
+  udp_recv(Peer.Udp, test_udp_receive, NULL);
+  memset(&Settings, 0x00, sizeof(Settings));
+  Settings.Mode = IPERF_MODE_UDP_SERVER;
+  Settings.Port = TEST_PORT_UDP_SINK;
+  test_check(iperf_start(&Settings) == 0, "UDP sink listening");
+  for (Loop1UInt8 = 0; Loop1UInt8 < sizeof(Order); ++Loop1UInt8)
+  {
+    test_udp_send(Order[Loop1UInt8]);
+    test_run(1);
+  }
+  test_udp_send(-TEST_DATAGRAMS);
+  test_run(TEST_WAIT_MSEC);
+  iperf_get_report(&Report);
+  iperf_display_report();
+  Bytes = sizeof(Order) * TEST_DATAGRAM_SIZE;
+  test_check(Report.FlagComplete && (Report.Datagrams == sizeof(Order)) && (Report.Bytes == Bytes), "UDP sink counted every datagram received");
+  test_check((Report.Lost == (TEST_DATAGRAMS - sizeof(Order))) && (Report.OutOfOrder == 1), "missing and out-of-order datagrams detected");
+  test_check(Peer.FlagDone && (Peer.ServerReport[2] == Bytes) && (Peer.ServerReport[5] == (TEST_DATAGRAMS - sizeof(Order))) &&
+             (Peer.ServerReport[6] == 1) && (Peer.ServerReport[7] == TEST_DATAGRAMS), "server report sent back in answer to the final datagram");
+  iperf_stop();
+  udp_remove(Peer.Udp);
+  test_check(!iperf_is_running(), "UDP sink stopped");
+
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_finished(). */
+/* ============================================================================================================================================================= *\
+                                              Tell if both the peer and the benchmark have seen the end of the test.
+\* ============================================================================================================================================================= */
+static UINT8 test_finished(void)
+{
+  struct struct_iperf_report Report;
+
+
+  iperf_get_report(&Report);
+
+  return (Peer.FlagDone && Report.FlagComplete);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_peer_error(). */
+/* ============================================================================================================================================================= *\
+                                                     Peer: TCP connection reset (pcb already freed by lwIP).
+\* ============================================================================================================================================================= */
+static void test_peer_error(void *Arg, err_t Error)
+{
+  Peer.FlagReset = FLAG_ON;
+  Peer.FlagDone  = FLAG_ON;
+  Peer.Pcb       = NULL;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_run(). */
+/* ============================================================================================================================================================= *\
+                             Service lwIP (loopback netif and timeouts) until the test is finished or the specified time has elapsed.
+\* ============================================================================================================================================================= */
+static void test_run(UINT32 Msec)
+{
+  UINT64 EndTime;
+
+  struct timespec Delay = {0, 1000000};
+
+
+  EndTime = WIFI_TIME_US() + (Msec * 1000ull);
+  while (WIFI_TIME_US() < EndTime)
+  {
+    netif_poll_all();
+    sys_check_timeouts();
+    nanosleep(&Delay, NULL);
+
+    if (test_finished()) break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_sink_accept(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP sink of the test: connection accepted.
+\* ============================================================================================================================================================= */
+static err_t test_sink_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  if ((Error != ERR_OK) || (Pcb == NULL)) return ERR_VAL;
+
+  Peer.Pcb = Pcb;
+  tcp_err(Pcb, test_peer_error);
+  tcp_recv(Pcb, test_sink_receive);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_sink_receive(). */
+/* ============================================================================================================================================================= *\
+                          TCP sink of the test: data received. The client header is kept aside, the end of the connection ends the test.
+\* ============================================================================================================================================================= */
+static err_t test_sink_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  UINT16 Offset;
+
+
+  if (PBuf == NULL)
+  {
+    Peer.FlagFin  = FLAG_ON;
+    Peer.FlagDone = FLAG_ON;
+    Peer.Pcb      = NULL;
+    tcp_err(Pcb, NULL);
+    tcp_recv(Pcb, NULL);
+    tcp_close(Pcb);
+    return ERR_OK;
+  }
+
+  Offset = 0;
+  if (Peer.HeaderLength < TEST_CLIENT_HEADER)
+  {
+    Offset = pbuf_copy_partial(PBuf, (UCHAR *)Peer.Header + Peer.HeaderLength, TEST_CLIENT_HEADER - Peer.HeaderLength, 0);
+    Peer.HeaderLength += Offset;
+  }
+  Peer.Received += (PBuf->tot_len - Offset);
+  tcp_recved(Pcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_source_connected(). */
+/* ============================================================================================================================================================= *\
+                                                         TCP source of the test: connection established.
+\* ============================================================================================================================================================= */
+static err_t test_source_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  test_source_fill(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_source_fill(). */
+/* ============================================================================================================================================================= *\
+               TCP source of the test: queue as much data as the send buffer allows, then close the sending side once everything has been written.
+                                             The receiving side stays open, to see how the sink ends the connection.
+\* ============================================================================================================================================================= */
+static void test_source_fill(struct tcp_pcb *Pcb)
+{
+  UINT16 Length;
+
+
+  while (Peer.Sent < TEST_UPLOAD_SIZE)
+  {
+    Length = LWIP_MIN(LWIP_MIN(tcp_sndbuf(Pcb), sizeof(TestChunk)), TEST_UPLOAD_SIZE - Peer.Sent);
+    if ((Length == 0) || (tcp_write(Pcb, TestChunk, Length, 0) != ERR_OK)) break;
+    Peer.Sent += Length;
+  }
+  tcp_output(Pcb);
+
+  if ((Peer.Sent == TEST_UPLOAD_SIZE) && (Peer.FlagShut == FLAG_OFF) && (tcp_shutdown(Pcb, 0, 1) == ERR_OK)) Peer.FlagShut = FLAG_ON;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_source_receive(). */
+/* ============================================================================================================================================================= *\
+                           TCP source of the test: data (or end of connection) received. The sink sends nothing, its FIN ends the test.
+\* ============================================================================================================================================================= */
+static err_t test_source_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  if (PBuf != NULL)
+  {
+    tcp_recved(Pcb, PBuf->tot_len);
+    pbuf_free(PBuf);
+    return ERR_OK;
+  }
+
+  Peer.FlagFin  = FLAG_ON;
+  Peer.FlagDone = FLAG_ON;
+  Peer.Pcb      = NULL;
+  tcp_err(Pcb, NULL);
+  tcp_recv(Pcb, NULL);
+  tcp_sent(Pcb, NULL);
+  tcp_close(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_source_sent(). */
+/* ============================================================================================================================================================= *\
+                                                            TCP source of the test: data acknowledged.
+\* ============================================================================================================================================================= */
+static err_t test_source_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  test_source_fill(Pcb);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_udp_receive(). */
+/* ============================================================================================================================================================= *\
+             UDP peer of the test: datagram received. As the sink of the UDP source, datagrams are counted and the final datagram is answered with a
+                                        server report. As the source of the UDP sink, only the server report is received.
+\* ============================================================================================================================================================= */
+static void test_udp_receive(void *Arg, struct udp_pcb *Pcb, struct pbuf *PBuf, const ip_addr_t *Address, u16_t Port)
+{
+  UINT8 Loop1UInt8;
+
+  INT32 Id;
+
+  UINT32 Fields[TEST_SERVER_HEADER / 4];
+
+  struct pbuf *Reply;
+
+
+  if (pbuf_copy_partial(PBuf, &Id, sizeof(Id), 0) != sizeof(Id))
+  {
+    pbuf_free(PBuf);
+    return;
+  }
+  Id = (INT32)lwip_ntohl(Id);
+
+  /* Source of the UDP sink: server report. */
+  if (Port == TEST_PORT_UDP_SINK)
+  {
+    if (pbuf_copy_partial(PBuf, Fields, sizeof(Fields), TEST_DATAGRAM_HEADER) == sizeof(Fields))
+    {
+      for (Loop1UInt8 = 0; Loop1UInt8 < (TEST_SERVER_HEADER / 4); ++Loop1UInt8) Peer.ServerReport[Loop1UInt8] = lwip_ntohl(Fields[Loop1UInt8]);
+      Peer.FlagDone = FLAG_ON;
+    }
+    pbuf_free(PBuf);
+    return;
+  }
+
+  /* Sink of the UDP source. */
+  if (Id >= 0)
+  {
+    ++Peer.Datagrams;
+    Peer.DatagramBytes += PBuf->tot_len;
+    pbuf_free(PBuf);
+    return;
+  }
+
+  Peer.FinalId = Id;
+  memset(Fields, 0x00, sizeof(Fields));
+  Fields[0] = lwip_htonl(0x80000000);
+  Fields[2] = lwip_htonl(Peer.DatagramBytes);
+  Fields[5] = lwip_htonl(TEST_REPORT_LOST);
+  Fields[6] = lwip_htonl(1);
+  Fields[7] = lwip_htonl(Peer.Datagrams);
+  Fields[8] = lwip_htonl(TEST_REPORT_JITTER_US / 1000000);
+  Fields[9] = lwip_htonl(TEST_REPORT_JITTER_US % 1000000);
+
+  Reply = pbuf_alloc(PBUF_TRANSPORT, TEST_DATAGRAM_HEADER + TEST_SERVER_HEADER, PBUF_RAM);
+  if (Reply != NULL)
+  {
+    pbuf_copy_partial(PBuf, Reply->payload, TEST_DATAGRAM_HEADER, 0);
+    pbuf_take_at(Reply, Fields, sizeof(Fields), TEST_DATAGRAM_HEADER);
+    udp_sendto(Pcb, Reply, Address, Port);
+    pbuf_free(Reply);
+    Peer.FlagDone = FLAG_ON;
+  }
+  pbuf_free(PBuf);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_udp_send(). */
+/* ============================================================================================================================================================= *\
+                                  UDP source of the test: send one datagram to the UDP sink, time stamped with the current time.
+\* ============================================================================================================================================================= */
+static void test_udp_send(INT32 Id)
+{
+  UINT32 Header[TEST_DATAGRAM_HEADER / 4];
+
+  UINT64 TimeStamp;
+
+  ip_addr_t Address;
+
+  struct pbuf *PBuf;
+
+
+  PBuf = pbuf_alloc(PBUF_TRANSPORT, TEST_DATAGRAM_SIZE, PBUF_RAM);
+  if (PBuf == NULL) return;
+
+  TimeStamp = WIFI_TIME_US();
+  Header[0] = lwip_htonl((UINT32)Id);
+  Header[1] = lwip_htonl((UINT32)(TimeStamp / 1000000));
+  Header[2] = lwip_htonl((UINT32)(TimeStamp % 1000000));
+  memset(PBuf->payload, 0x00, TEST_DATAGRAM_SIZE);
+  pbuf_take(PBuf, Header, sizeof(Header));
+
+  ip_addr_set_loopback(0, &Address);
+  udp_sendto(Peer.Udp, PBuf, &Address, TEST_PORT_UDP_SINK);
+  pbuf_free(PBuf);
+
+  return;
+}
@@ -0,0 +1,598 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-MQTT.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the MQTT client (Pico-WiFi-MQTT.c) against a minimal broker of its own, on lwIP's loopback netif (127.0.0.1),
+   built by tests/CMakeLists.txt. The broker decodes every packet it receives and answers as told by the test.
+   - CONNECT / CONNACK: protocol name and level, flags, keepalive and client id as given in the settings; the client is connected once
+     the CONNACK is received, not before.
+   - PUBLISH: a QoS0 message arrives with its topic and payload and no packet id; QoS1 messages carry distinct packet ids and are
+     released once the broker sends their PUBACK.
+   - Queue full: MQTT_QUEUE_SIZE messages are accepted while the broker holds back its PUBACKs, one more is refused and counted;
+     no more than MQTT_INFLIGHT_MAX QoS1 messages are in flight. Every message is published once the PUBACKs are sent.
+   - PINGREQ timing: an idle client sends its PINGREQ one keepalive period after the last exchange (within one timer tick), and every
+     keepalive period after that while the broker answers. A broker that stops answering is dropped after 1.5 keepalive period of
+     silence, and the client connects again.
+   - Stop: a DISCONNECT is sent before the connection is closed.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+
+#include "Pico-WiFi-MQTT.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_PORT             1883     // port of the test broker.
+#define TEST_CLIENT_ID     "pico-test"
+#define TEST_KEEPALIVE_SEC       1     // keepalive of the client (shortest possible, to keep the test short).
+#define TEST_SLACK_MSEC         50     // tolerance of the timing checks, on top of one timer tick.
+#define TEST_WAIT_MSEC        5000     // longest wait for an event.
+#define TEST_BUFFER_SIZE      1024     // bytes of an incoming packet held by the broker.
+#define TEST_MAX_UNACKED        64     // QoS1 packet ids held back by the broker.
+
+/* MQTT control packet types (first byte, high nibble). */
+#define TEST_CONNECT          0x10
+#define TEST_PUBLISH          0x30
+#define TEST_PUBACK           0x40
+#define TEST_PINGREQ          0xC0
+#define TEST_DISCONNECT       0xE0
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+/* Test broker. Counters are compared to targets by test_run(). */
+static struct
+{
+  UINT8  FlagHoldConnack;                      // do not answer CONNECT (yet).
+  UINT8  FlagHoldPuback;                       // hold back PUBACKs (packet ids are kept in Unacked[]).
+  UINT8  FlagMute;                             // do not answer PINGREQ.
+  UINT8  FlagConnectOk;                        // last CONNECT as expected.
+  UINT8  ConnectFlags;                         // connect flags of the last CONNECT.
+  UINT8  LastQoS;                              // QoS of the last PUBLISH.
+  UINT16 LastPacketId;                         // packet id of the last PUBLISH (0 for QoS0).
+  UINT16 Length;                               // bytes of the current packet in Buffer[].
+  UINT16 UnackedCount;
+  UINT16 Unacked[TEST_MAX_UNACKED];
+  UINT32 Connects;                             // CONNECT packets received.
+  UINT32 Publishes;                            // PUBLISH packets received.
+  UINT32 PingReqs;
+  UINT32 Disconnects;                          // DISCONNECT packets received.
+  UINT32 Closes;                               // connections closed or reset by the client.
+  UINT64 PingTime[2];                          // time stamps of the last two PINGREQs.
+  UINT64 RxTime;                               // time stamp of the last packet received.
+  UINT64 TxTime;                               // time stamp of the last packet sent.
+  UCHAR  LastTopic[32];                        // topic and payload of the last PUBLISH.
+  UCHAR  LastPayload[32];
+  UCHAR  Buffer[TEST_BUFFER_SIZE];
+  struct tcp_pcb *Listen;
+  struct tcp_pcb *Pcb;
+} Broker;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the module under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Test broker: connection accepted. */
+static err_t test_broker_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* Test broker: connection reset by the client (pcb already freed by lwIP). */
+static void test_broker_error(void *Arg, err_t Error);
+
+/* Test broker: process a complete packet. */
+static void test_broker_packet(UCHAR *Packet, UINT16 Length);
+
+/* Test broker: data received. */
+static err_t test_broker_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* Test broker: send a packet to the client. */
+static err_t test_broker_send(const UCHAR *Packet, UINT16 Length);
+
+/* Test broker: send the PUBACKs held back. */
+static void test_broker_send_pubacks(void);
+
+/* Test broker: data acknowledged, PUBACKs that could not be written may be sent. */
+static err_t test_broker_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Service lwIP (loopback netif and timeouts) until a counter reaches its target or the specified time has elapsed. */
+static void test_run(UINT32 Msec, UINT32 *Counter, UINT32 Target);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                            Log info (used by the module under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UCHAR Payload[16];
+
+  UINT8 FlagOk;
+  UINT8 Loop1UInt8;
+
+  UINT16 FirstId;
+
+  UINT32 PingReqs;
+  UINT32 Publishes;
+
+  UINT64 Delay;
+  UINT64 KeepAlive;
+  UINT64 LastExchange;
+  UINT64 Tolerance;
+
+  struct tcp_pcb *Pcb;
+
+  struct struct_mqtt_settings Settings;
+  struct struct_mqtt_stats    Stats;
+
+
+  lwip_init();
+  netif_set_default(netif_list);  // loopback netif: the client needs a link up with an address.
+
+  memset(&Broker, 0x00, sizeof(Broker));
+  Pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  tcp_bind(Pcb, IP_ANY_TYPE, TEST_PORT);
+  Broker.Listen = tcp_listen(Pcb);
+  tcp_accept(Broker.Listen, test_broker_accept);
+
+  KeepAlive = TEST_KEEPALIVE_SEC * 1000000ull;
+  Tolerance = (MQTT_TICK_MSEC + TEST_SLACK_MSEC) * 1000ull;
+
+  /* CONNECT / CONNACK. */
+  memset(&Settings, 0x00, sizeof(Settings));
+  ip_addr_set_loopback(0, &Settings.BrokerAddress);
+  Settings.Port             = TEST_PORT;
+  Settings.ClientId         = TEST_CLIENT_ID;
+  Settings.KeepAliveSec     = TEST_KEEPALIVE_SEC;
+  Settings.FlagCleanSession = FLAG_ON;
+  Broker.FlagHoldConnack    = FLAG_ON;
+  test_check(wifi_mqtt_start(&Settings, NULL, NULL) == 0, "client started");
+  test_run(TEST_WAIT_MSEC, &Broker.Connects, 1);
+  test_check(Broker.FlagConnectOk && (Broker.ConnectFlags == 0x02), "CONNECT received: MQTT 3.1.1, clean session, keepalive and client id as set");
+  test_check(!wifi_mqtt_is_connected(), "client not connected before the CONNACK");
+
+  /* Messages published while waiting for the CONNACK fill the queue. */
+  FlagOk = FLAG_ON;
+  for (Loop1UInt8 = 0; Loop1UInt8 < MQTT_QUEUE_SIZE; ++Loop1UInt8)
+  {
+    sprintf(Payload, "msg %u", Loop1UInt8);
+    if (wifi_mqtt_publish("pico/queue", Payload, strlen(Payload), 1, FLAG_OFF) != 0) FlagOk = FLAG_OFF;
+  }
+  test_check(FlagOk, "MQTT_QUEUE_SIZE messages queued while connecting");
+  test_check(wifi_mqtt_publish("pico/queue", "full", 4, 1, FLAG_OFF) == -2, "one more message refused");
+  wifi_mqtt_get_stats(&Stats);
+  test_check((Stats.QueueFull == 1) && (Stats.Pending == MQTT_QUEUE_SIZE), "refused message counted, every slot pending");
+
+  /* CONNACK: the window of in-flight messages is filled, PUBACKs are held back. */
+  Broker.FlagHoldPuback  = FLAG_ON;
+  Broker.FlagHoldConnack = FLAG_OFF;
+  test_broker_send((const UCHAR *)"\x20\x02\x00\x00", 4);
+  test_run(TEST_WAIT_MSEC, &Broker.Publishes, MQTT_INFLIGHT_MAX);
+  test_run(100, NULL, 0);
+  wifi_mqtt_get_stats(&Stats);
+  test_check(wifi_mqtt_is_connected() && (Stats.Connects == 1), "client connected once the CONNACK is received");
+  test_check((Broker.Publishes == MQTT_INFLIGHT_MAX) && (Stats.InFlight == MQTT_INFLIGHT_MAX), "no more than MQTT_INFLIGHT_MAX QoS1 messages in flight");
+
+  /* PUBACKs: the rest of the queue is sent, every message is published. */
+  FirstId = Broker.Unacked[0];
+  Broker.FlagHoldPuback = FLAG_OFF;
+  test_broker_send_pubacks();
+  test_run(TEST_WAIT_MSEC, &Broker.Publishes, MQTT_QUEUE_SIZE);
+  test_run(100, NULL, 0);
+  wifi_mqtt_get_stats(&Stats);
+  test_check((Broker.Publishes == MQTT_QUEUE_SIZE) && (Broker.LastPacketId == (FirstId + MQTT_QUEUE_SIZE - 1)), "whole queue sent, one packet id per message");
+  test_check((Stats.Acked == MQTT_QUEUE_SIZE) && (Stats.Published == MQTT_QUEUE_SIZE) && (Stats.Pending == 0) && (Stats.InFlight == 0),
+             "every message acknowledged, every slot free again");
+  test_check(Stats.InFlightMax == MQTT_INFLIGHT_MAX, "in-flight peak is MQTT_INFLIGHT_MAX");
+
+  /* QoS0 and QoS1 PUBLISH. */
+  Publishes = Broker.Publishes;
+  wifi_mqtt_publish("pico/qos0", "zero", 4, 0, FLAG_OFF);
+  test_run(TEST_WAIT_MSEC, &Broker.Publishes, Publishes + 1);
+  test_check((Broker.LastQoS == 0) && (Broker.LastPacketId == 0) && (strcmp(Broker.LastTopic, "pico/qos0") == 0) && (strcmp(Broker.LastPayload, "zero") == 0),
+             "QoS0 PUBLISH: topic and payload, no packet id");
+  wifi_mqtt_publish("pico/qos1", "one", 3, 1, FLAG_OFF);
+  test_run(TEST_WAIT_MSEC, &Broker.Publishes, Publishes + 2);
+  test_run(100, NULL, 0);
+  wifi_mqtt_get_stats(&Stats);
+  test_check((Broker.LastQoS == 1) && (Broker.LastPacketId == (FirstId + MQTT_QUEUE_SIZE)) && (strcmp(Broker.LastTopic, "pico/qos1") == 0) &&
+             (strcmp(Broker.LastPayload, "one") == 0), "QoS1 PUBLISH: topic, payload and next packet id");
+  test_check((Stats.Acked == (MQTT_QUEUE_SIZE + 1)) && (Stats.Pending == 0), "QoS1 message released by its PUBACK");
+
+  /* PINGREQ timing, idle client: one keepalive period after the last exchange, then every keepalive period. */
+  LastExchange = (Broker.RxTime < Broker.TxTime) ? Broker.RxTime : Broker.TxTime;
+  PingReqs     = Broker.PingReqs;
+  test_run(TEST_WAIT_MSEC, &Broker.PingReqs, PingReqs + 1);
+  Delay = Broker.PingTime[1] - LastExchange;
+  log_info(__LINE__, __func__, "First PINGREQ %llu msec after the last exchange.", Delay / 1000);
+  test_check((Broker.PingReqs == (PingReqs + 1)) && (Delay + (TEST_SLACK_MSEC * 1000ull) >= KeepAlive) && (Delay <= (KeepAlive + Tolerance)), "first PINGREQ one keepalive period after the last exchange");
+  test_run(TEST_WAIT_MSEC, &Broker.PingReqs, PingReqs + 2);
+  Delay = Broker.PingTime[1] - Broker.PingTime[0];
+  log_info(__LINE__, __func__, "Next PINGREQ %llu msec later.", Delay / 1000);
+  test_check((Broker.PingReqs == (PingReqs + 2)) && (Delay + (TEST_SLACK_MSEC * 1000ull) >= KeepAlive) && (Delay <= (KeepAlive + Tolerance)), "next PINGREQ one keepalive period later");
+
+  /* Silent broker: dropped after 1.5 keepalive period, then the client connects again. */
+  Broker.FlagMute = FLAG_ON;
+  test_run(TEST_WAIT_MSEC, &Broker.Closes, 1);
+  Delay = WIFI_TIME_US() - Broker.TxTime;
+  log_info(__LINE__, __func__, "Silent broker dropped after %llu msec.", Delay / 1000);
+  wifi_mqtt_get_stats(&Stats);
+  test_check((Broker.Closes == 1) && (Stats.ConnectionLosses == 1), "silent broker dropped");
+  test_check((Delay + (TEST_SLACK_MSEC * 1000ull) >= ((KeepAlive * 3) / 2)) && (Delay <= (((KeepAlive * 3) / 2) + Tolerance)), "drop after 1.5 keepalive period of silence");
+  Broker.FlagMute = FLAG_OFF;
+  test_run(TEST_WAIT_MSEC, &Broker.Connects, 2);
+  test_run(100, NULL, 0);
+  wifi_mqtt_get_stats(&Stats);
+  test_check(wifi_mqtt_is_connected() && (Stats.Connects == 2), "client connected again");
+
+  /* Stop: DISCONNECT, then close. */
+  wifi_mqtt_stop();
+  test_run(TEST_WAIT_MSEC, &Broker.Closes, 2);
+  test_check((Broker.Disconnects == 1) && (Broker.Closes == 2), "DISCONNECT sent before the connection is closed");
+  test_check(wifi_mqtt_publish("pico/qos0", "zero", 4, 0, FLAG_OFF) == -1, "publish refused once stopped");
+
+  wifi_mqtt_display_stats();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_accept(). */
+/* ============================================================================================================================================================= *\
+                                                     Test broker: connection accepted. One client at a time.
+\* ============================================================================================================================================================= */
+static err_t test_broker_accept(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  if ((Error != ERR_OK) || (Pcb == NULL)) return ERR_VAL;
+
+  Broker.Pcb    = Pcb;
+  Broker.Length = 0;
+  tcp_err(Pcb, test_broker_error);
+  tcp_recv(Pcb, test_broker_receive);
+  tcp_sent(Pcb, test_broker_sent);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_error(). */
+/* ============================================================================================================================================================= *\
+                                             Test broker: connection reset by the client (pcb already freed by lwIP).
+\* ============================================================================================================================================================= */
+static void test_broker_error(void *Arg, err_t Error)
+{
+  Broker.Pcb = NULL;
+  ++Broker.Closes;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_packet(). */
+/* ============================================================================================================================================================= *\
+                                                             Test broker: process a complete packet.
+\* ============================================================================================================================================================= */
+static void test_broker_packet(UCHAR *Packet, UINT16 Length)
+{
+  static const UCHAR ConnectHeader[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+
+  UCHAR Answer[4];
+
+  UINT8 QoS;
+
+  UINT16 Index;
+  UINT16 PayloadLength;
+  UINT16 TopicLength;
+
+
+  Broker.RxTime = WIFI_TIME_US();
+
+  /* Skip fixed header. */
+  for (Index = 1; Packet[Index] & 0x80; ++Index);
+  ++Index;
+
+  switch (Packet[0] & 0xF0)
+  {
+    case (TEST_CONNECT):
+      ++Broker.Connects;
+      Broker.ConnectFlags  = Packet[Index + 7];
+      Broker.FlagConnectOk = (memcmp(&Packet[Index], ConnectHeader, sizeof(ConnectHeader)) == 0) &&
+                             (((Packet[Index + 8] << 8) | Packet[Index + 9]) == TEST_KEEPALIVE_SEC) &&
+                             (((Packet[Index + 10] << 8) | Packet[Index + 11]) == strlen(TEST_CLIENT_ID)) &&
+                             (memcmp(&Packet[Index + 12], TEST_CLIENT_ID, strlen(TEST_CLIENT_ID)) == 0);
+      if (Broker.FlagHoldConnack == FLAG_OFF) test_broker_send((const UCHAR *)"\x20\x02\x00\x00", 4);
+    break;
+
+    case (TEST_PUBLISH):
+      ++Broker.Publishes;
+      QoS         = (Packet[0] >> 1) & 0x03;
+      TopicLength = (Packet[Index] << 8) | Packet[Index + 1];
+      Index      += 2;
+      memset(Broker.LastTopic, 0x00, sizeof(Broker.LastTopic));
+      memcpy(Broker.LastTopic, &Packet[Index], LWIP_MIN(TopicLength, sizeof(Broker.LastTopic) - 1));
+      Index += TopicLength;
+
+      Broker.LastQoS      = QoS;
+      Broker.LastPacketId = 0;
+      if (QoS)
+      {
+        Broker.LastPacketId = (Packet[Index] << 8) | Packet[Index + 1];
+        Index += 2;
+      }
+      PayloadLength = Length - Index;
+      memset(Broker.LastPayload, 0x00, sizeof(Broker.LastPayload));
+      memcpy(Broker.LastPayload, &Packet[Index], LWIP_MIN(PayloadLength, sizeof(Broker.LastPayload) - 1));
+
+      /* PUBACKs are sent by test_broker_receive(), once every packet of the segment has been processed. */
+      if ((QoS) && (Broker.UnackedCount < TEST_MAX_UNACKED)) Broker.Unacked[Broker.UnackedCount++] = Broker.LastPacketId;
+    break;
+
+    case (TEST_PINGREQ):
+      ++Broker.PingReqs;
+      Broker.PingTime[0] = Broker.PingTime[1];
+      Broker.PingTime[1] = Broker.RxTime;
+      if (Broker.FlagMute == FLAG_OFF)
+      {
+        Answer[0] = 0xD0;
+        Answer[1] = 0x00;
+        test_broker_send(Answer, 2);
+      }
+    break;
+
+    case (TEST_DISCONNECT):
+      ++Broker.Disconnects;
+    break;
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_receive(). */
+/* ============================================================================================================================================================= *\
+             Test broker: data received. Bytes are accumulated until a packet is complete, PUBACKs are sent once all complete packets are processed.
+\* ============================================================================================================================================================= */
+static err_t test_broker_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  UINT8 Index;
+
+  UINT32 Multiplier;
+  UINT32 Total;
+
+
+  if (PBuf == NULL)
+  {
+    Broker.Pcb = NULL;
+    ++Broker.Closes;
+    tcp_err(Pcb, NULL);
+    tcp_recv(Pcb, NULL);
+    tcp_close(Pcb);
+    return ERR_OK;
+  }
+
+  Broker.Length += pbuf_copy_partial(PBuf, &Broker.Buffer[Broker.Length], LWIP_MIN(PBuf->tot_len, TEST_BUFFER_SIZE - Broker.Length), 0);
+  tcp_recved(Pcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+
+  /* Process all complete packets (remaining length is at most 4 bytes long). */
+  while (Broker.Length >= 2)
+  {
+    Multiplier = 1;
+    Total      = 0;
+    for (Index = 1; (Index < Broker.Length) && (Index < 5); ++Index)
+    {
+      Total += (Broker.Buffer[Index] & 0x7F) * Multiplier;
+      if ((Broker.Buffer[Index] & 0x80) == 0) break;
+      Multiplier *= 128;
+    }
+    if ((Index >= Broker.Length) || (Index == 5)) break;
+
+    Total += Index + 1;
+    if (Total > Broker.Length) break;
+
+    test_broker_packet(Broker.Buffer, Total);
+    Broker.Length -= Total;
+    memmove(Broker.Buffer, &Broker.Buffer[Total], Broker.Length);
+  }
+  if (Broker.FlagHoldPuback == FLAG_OFF) test_broker_send_pubacks();
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_send(). */
+/* ============================================================================================================================================================= *\
+                                                            Test broker: send a packet to the client.
+\* ============================================================================================================================================================= */
+static err_t test_broker_send(const UCHAR *Packet, UINT16 Length)
+{
+  err_t ReturnCode;
+
+
+  if (Broker.Pcb == NULL) return ERR_CONN;
+
+  ReturnCode = tcp_write(Broker.Pcb, Packet, Length, TCP_WRITE_FLAG_COPY);
+  if (ReturnCode != ERR_OK) return ReturnCode;
+  tcp_output(Broker.Pcb);
+  Broker.TxTime = WIFI_TIME_US();
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_send_pubacks(). */
+/* ============================================================================================================================================================= *\
+            Test broker: send the PUBACKs held back, in the order of the PUBLISH packets, in a single write. They are kept if TCP can't take them yet.
+\* ============================================================================================================================================================= */
+static void test_broker_send_pubacks(void)
+{
+  UCHAR PubAck[TEST_MAX_UNACKED * 4];
+
+  UINT16 Loop1UInt16;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Broker.UnackedCount; ++Loop1UInt16)
+  {
+    PubAck[(Loop1UInt16 * 4)]     = TEST_PUBACK;
+    PubAck[(Loop1UInt16 * 4) + 1] = 2;
+    PubAck[(Loop1UInt16 * 4) + 2] = Broker.Unacked[Loop1UInt16] >> 8;
+    PubAck[(Loop1UInt16 * 4) + 3] = Broker.Unacked[Loop1UInt16] & 0xFF;
+  }
+  if ((Broker.UnackedCount) && (test_broker_send(PubAck, Broker.UnackedCount * 4) == ERR_OK)) Broker.UnackedCount = 0;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_broker_sent(). */
+/* ============================================================================================================================================================= *\
+                                          Test broker: data acknowledged, PUBACKs that could not be written may be sent.
+\* ============================================================================================================================================================= */
+static err_t test_broker_sent(void *Arg, struct tcp_pcb *Pcb, UINT16 Length)
+{
+  if (Broker.FlagHoldPuback == FLAG_OFF) test_broker_send_pubacks();
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_run(). */
+/* ============================================================================================================================================================= *\
+                         Service lwIP (loopback netif and timeouts) until a counter reaches its target or the specified time has elapsed.
+                                                           Without a counter, runs for the whole time.
+\* ============================================================================================================================================================= */
+static void test_run(UINT32 Msec, UINT32 *Counter, UINT32 Target)
+{
+  UINT64 EndTime;
+
+  struct timespec Delay = {0, 1000000};
+
+
+  EndTime = WIFI_TIME_US() + (Msec * 1000ull);
+  while (WIFI_TIME_US() < EndTime)
+  {
+    netif_poll_all();
+    sys_check_timeouts();
+    nanosleep(&Delay, NULL);
+
+    if ((Counter != NULL) && (*Counter >= Target)) break;
+  }
+
+  return;
+}
@@ -0,0 +1,196 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-Ping.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the ping engine (Pico-WiFi-Ping.c) against lwIP's loopback netif (127.0.0.1), built by tests/CMakeLists.txt.
+   - 127.0.0.1 answers every echo request: all of them must be received, none lost.
+   - 127.0.0.2 is routed to the loopback netif but nobody answers: requests must only be counted as lost once PING_TIMEOUT_MSEC has elapsed,
+     even when many more requests than PING_WINDOW_MIN are in flight (short interval).
+   - Targets whose interval needs more slots than what is left in the pool must be refused.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+
+#include "Pico-WiFi-Ping.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_COUNT            50     // echo requests sent to each target.
+#define TEST_INTERVAL_MSEC    10     // delay between two echo requests (PING_TIMEOUT_MSEC covers 100 of them).
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the modules under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Service lwIP (loopback netif and timeouts) for the specified time or until the ping engine stops. */
+static void test_run(UINT32 Msec);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                            Log info (used by the modules under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  ip_addr_t Address;
+
+  struct struct_ping_stats Stats;
+
+
+  lwip_init();
+
+  /* Pool must refuse a target whose interval would need more slots than what is left. */
+  ip_addr_set_loopback(0, &Address);
+  ping_clear_targets();
+  test_check(ping_target_add(&Address, 1, 0) < 0, "1 msec interval refused (window would exceed the pool)");
+  test_check(ping_target_add(&Address, 5, 0) == 0, "5 msec interval accepted (whole pool)");
+  test_check(ping_target_add(&Address, 1000, 0) < 0, "second target refused once the pool is used up");
+
+  /* One target answering, one not answering. */
+  ping_clear_targets();
+  ping_target_add(&Address, TEST_INTERVAL_MSEC, TEST_COUNT);
+  IP_ADDR4(&Address, 127, 0, 0, 2);
+  ping_target_add(&Address, TEST_INTERVAL_MSEC, TEST_COUNT);
+  test_check(ping_start() == 0, "ping engine started");
+
+  /* All requests to 127.0.0.2 are in flight but none has timed out yet. */
+  test_run(TEST_COUNT * TEST_INTERVAL_MSEC + 100);
+  ping_get_stats(1, &Stats);
+  test_check(Stats.Sent == TEST_COUNT, "all echo requests sent to 127.0.0.2");
+  test_check(Stats.Lost == 0, "no echo request to 127.0.0.2 lost before PING_TIMEOUT_MSEC");
+
+  /* Engine stops by itself once the last request has timed out. */
+  test_run(PING_TIMEOUT_MSEC + 1000);
+  test_check(ping_is_running() == FLAG_OFF, "ping engine stopped by itself");
+
+  ping_get_stats(0, &Stats);
+  log_info(__LINE__, __func__, "127.0.0.1: sent %lu  received %lu  lost %lu  late %lu  p50 %lu usec  p99 %lu usec",
+           (unsigned long)Stats.Sent, (unsigned long)Stats.Received, (unsigned long)Stats.Lost, (unsigned long)Stats.Late,
+           (unsigned long)Stats.RttP50, (unsigned long)Stats.RttP99);
+  test_check(Stats.Sent == TEST_COUNT, "all echo requests sent to 127.0.0.1");
+  test_check(Stats.Received == TEST_COUNT, "all echo replies received from 127.0.0.1");
+  test_check((Stats.Lost == 0) && (Stats.Late == 0), "no loss from 127.0.0.1");
+  test_check(Stats.RttMin <= Stats.RttP50 && Stats.RttP50 <= Stats.RttP99 && Stats.RttP99 <= Stats.RttMax, "percentiles ordered");
+
+  ping_get_stats(1, &Stats);
+  test_check(Stats.Lost == TEST_COUNT, "all echo requests to 127.0.0.2 lost after PING_TIMEOUT_MSEC");
+  test_check(Stats.Received == 0, "no echo reply from 127.0.0.2");
+
+  ping_display_stats();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_run(). */
+/* ============================================================================================================================================================= *\
+                                Service lwIP (loopback netif and timeouts) for the specified time or until the ping engine stops.
+\* ============================================================================================================================================================= */
+static void test_run(UINT32 Msec)
+{
+  UINT64 EndTime;
+
+  struct timespec Delay = {0, 1000000};
+
+
+  EndTime = WIFI_TIME_US() + (Msec * 1000ull);
+  while ((WIFI_TIME_US() < EndTime) && ping_is_running())
+  {
+    netif_poll_all();
+    sys_check_timeouts();
+    nanosleep(&Delay, NULL);
+  }
+
+  return;
+}
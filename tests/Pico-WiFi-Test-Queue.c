@@ -0,0 +1,360 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-Queue.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the telemetry queue (Pico-WiFi-Queue.c) on its RAM image (see wifi_queue_image()), built by tests/CMakeLists.txt with
+   QUEUE_DRAIN_RATE raised so that the ring drains at once. Each "reboot" is a call to wifi_queue_init(), which rebuilds the queue from the image only.
+   Every record holds its number, then bytes derived from it; the sender of the test checks them and that numbers follow each other.
+   - Benchmark: every record pushed is either sent or dropped (ring full), nothing is left pending, no CRC or flash error.
+   - Recovery after reopen: records acknowledged before a reboot are not sent again, the others are sent in order after it; a batch in flight
+     (not acknowledged) at the reboot is sent again.
+   - Sector rotation: pushing twice the ring erases every segment, the oldest records are dropped, the ring holds all its segments, and
+     the newest records survive a reboot and are sent in order.
+   - Torn write: a record cut short in mid-record (power loss while it was programmed) fails its CRC check, the records before it are sent,
+     and the next record goes to a fresh segment.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#define _GNU_SOURCE  // memmem().
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Pico-WiFi-Queue.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_FIRST_NUMBER     100000     // first record number (the benchmark numbers its records from 0).
+#define TEST_RECOVERY_RECORDS    100     // records of the recovery check (a little more than three batches).
+#define TEST_ROTATION_LENGTH     200     // record length of the rotation check (208 bytes with its overhead and alignment).
+#define TEST_ROTATION_RECORDS     19     // records of TEST_ROTATION_LENGTH bytes in a segment (4096 bytes, less a header of 128).
+#define TEST_TORN_RECORDS         10     // records of the torn write check, the last one being cut short.
+#define TEST_DRAIN_MSEC         2000     // longest time allowed to drain the queue.
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+/* Records received by the sender of the test. */
+static struct
+{
+  UINT8  FlagHold;                             // batches are taken but not acknowledged (connection lost before the outcome).
+  UINT32 Batches;                              // batches handed to the sender.
+  UINT32 Expected;                             // number of the next record expected.
+  UINT32 Records;                              // records received.
+  UINT32 Errors;                               // records out of order, or whose content does not match their number.
+} Receiver;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the module under test). */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Drain the queue through the sender of the test, expecting a given record first. */
+static void test_drain(UINT32 Expected, UINT32 Batches);
+
+/* Push numbered records and return the number of records accepted. */
+static UINT32 test_push(UINT32 Number, UINT32 Count, UINT16 Length);
+
+/* Sender of the test: check the records of a batch, then acknowledge it. */
+static INT16 test_sender(const struct struct_queue_batch *Batch, void *Context);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                                                            Log info (used by the module under test).
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  va_list Arguments;
+
+
+  printf("[%5u] %s() - ", LineNumber, FunctionName);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UINT8 *Image;
+  UINT8 Needle[7];
+  UINT8 *Record;
+
+  UINT32 Dropped;
+  UINT32 Erases;
+  UINT32 Last;
+  UINT32 Number;
+  UINT32 Pending;
+  UINT32 Pushed;
+
+  struct struct_queue_stats Before;
+  struct struct_queue_stats Stats;
+
+
+  Image = wifi_queue_image();
+  test_check(wifi_queue_init() == 0, "queue loaded from a blank image");
+  wifi_queue_get_stats(&Stats);
+  test_check((Stats.PendingRecords == 0) && (Stats.Sequence == 0), "blank image holds no record");
+
+  /* Benchmark: more records than the ring holds. */
+  wifi_queue_get_stats(&Before);
+  wifi_queue_bench(2000, 100);
+  wifi_queue_get_stats(&Stats);
+  test_check((Stats.Pushed - Before.Pushed) == 2000, "benchmark pushed every record");
+  test_check(((Stats.Sent - Before.Sent) + (Stats.Dropped - Before.Dropped)) == 2000, "benchmark records all sent or dropped");
+  test_check((Stats.PendingRecords == 0) && (Stats.Corrupted == 0) && (Stats.Errors == 0), "benchmark left nothing pending, no CRC or flash error");
+
+  /* Recovery after reopen: one batch acknowledged, one in flight, then reboot. */
+  Number = TEST_FIRST_NUMBER;
+  test_check(test_push(Number, TEST_RECOVERY_RECORDS, 40) == TEST_RECOVERY_RECORDS, "records pushed");
+  wifi_queue_flush();
+  wifi_queue_init();
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.PendingRecords == TEST_RECOVERY_RECORDS, "records pending after reboot");
+  test_drain(Number, 1);
+  test_check((Receiver.Records == QUEUE_BATCH_RECORDS) && (Receiver.Errors == 0), "first batch sent in order");
+  Receiver.FlagHold = TRUE;
+  test_drain(Number + QUEUE_BATCH_RECORDS, 1);
+  Receiver.FlagHold = FALSE;
+  test_check(Receiver.Batches == 1, "second batch handed to the sender, never acknowledged");
+
+  wifi_queue_init();
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.PendingRecords == (TEST_RECOVERY_RECORDS - QUEUE_BATCH_RECORDS), "acknowledged records not pending after reboot");
+  test_drain(Number + QUEUE_BATCH_RECORDS, 0);
+  test_check((Receiver.Records == (TEST_RECOVERY_RECORDS - QUEUE_BATCH_RECORDS)) && (Receiver.Errors == 0),
+             "batch in flight at reboot sent again, then the others in order");
+  wifi_queue_init();
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.PendingRecords == 0, "nothing sent again after a complete drain and reboot");
+  Number += TEST_RECOVERY_RECORDS;
+
+  /* Sector rotation: twice the ring, draining stopped. */
+  wifi_queue_get_stats(&Before);
+  Pushed = TEST_ROTATION_RECORDS * QUEUE_SECTORS * 2;
+  test_check(test_push(Number, Pushed, TEST_ROTATION_LENGTH) == Pushed, "every record accepted while the ring is full");
+  wifi_queue_flush();
+  wifi_queue_get_stats(&Stats);
+  Erases  = Stats.Erases  - Before.Erases;
+  Dropped = Stats.Dropped - Before.Dropped;
+  test_check((Erases >= (QUEUE_SECTORS * 2) - 1) && ((Stats.Sequence - Before.Sequence) == Erases), "every segment erased in turn, generation follows");
+  test_check((Dropped > 0) && ((Stats.PendingRecords + Dropped) == Pushed), "oldest records dropped to make room");
+  test_check(Stats.Segments == QUEUE_SECTORS, "records pending in every segment of the ring");
+  Pending = Stats.PendingRecords;
+
+  wifi_queue_init();
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.PendingRecords == Pending, "newest records pending after reboot");
+  test_drain(Number + Dropped, 0);
+  test_check((Receiver.Records == Pending) && (Receiver.Errors == 0) && (Receiver.Expected == (Number + Pushed)), "newest records sent in order, last one included");
+  Number += Pushed;
+
+  /* Torn write: the last record is cut short in mid-record. */
+  wifi_queue_get_stats(&Before);
+  test_check(test_push(Number, TEST_TORN_RECORDS, 100) == TEST_TORN_RECORDS, "records pushed before the power loss");
+  wifi_queue_flush();
+  Needle[0] = 0xA5;  // record magic, then length and the start of the data.
+  Needle[1] = 100;
+  Needle[2] = 0;
+  Last      = Number + TEST_TORN_RECORDS - 1;
+  memcpy(&Needle[3], &Last, sizeof(Last));
+  Record = memmem(Image, QUEUE_SECTORS * QUEUE_SECTOR_SIZE, Needle, sizeof(Needle));
+  test_check(Record != NULL, "last record found in the image");
+  if (Record != NULL) memset(Record + 3 + 50, 0xFF, 50 + 2);  // second half of the data and CRC-16 still erased.
+
+  wifi_queue_init();
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.PendingRecords == (TEST_TORN_RECORDS - 1), "record cut short not pending after reboot");
+  test_drain(Number, 0);
+  test_check((Receiver.Records == (TEST_TORN_RECORDS - 1)) && (Receiver.Errors == 0), "records before the one cut short sent in order");
+  Number += TEST_TORN_RECORDS;
+
+  wifi_queue_get_stats(&Before);
+  test_check(test_push(Number, 1, 100) == 1, "record pushed after the power loss");
+  wifi_queue_get_stats(&Stats);
+  test_check(Stats.Sequence == (Before.Sequence + 1), "next record written to a fresh segment");
+  test_drain(Number, 0);
+  wifi_queue_get_stats(&Stats);
+  test_check((Receiver.Records == 1) && (Receiver.Errors == 0), "record after the power loss sent");
+  test_check(Stats.Corrupted == (Before.Corrupted + 1), "record cut short rejected by its CRC check and counted");
+
+  wifi_queue_display_stats();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_drain(). */
+/* ============================================================================================================================================================= *\
+          Drain the queue through the sender of the test, the first record expected being Expected. Stop once nothing is pending, after Batches batches
+           handed to the sender (0: no limit), or after TEST_DRAIN_MSEC. Draining is stopped on return, the outcome of the last batch being processed.
+\* ============================================================================================================================================================= */
+static void test_drain(UINT32 Expected, UINT32 Batches)
+{
+  UINT64 StartTime;
+
+  struct struct_queue_stats Stats;
+
+
+  Receiver.Batches  = 0;
+  Receiver.Expected = Expected;
+  Receiver.Records  = 0;
+  Receiver.Errors   = 0;
+
+  wifi_queue_start(test_sender, NULL);
+  StartTime = wifi_flash_time_us();
+  do
+  {
+    wifi_queue_service();
+    wifi_queue_get_stats(&Stats);
+  } while (Stats.PendingRecords && ((Batches == 0) || (Receiver.Batches < Batches)) && ((wifi_flash_time_us() - StartTime) < (TEST_DRAIN_MSEC * 1000ull)));
+
+  /* Outcome of the last batch, without handing a new one. */
+  wifi_queue_stop();
+  wifi_queue_service();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_push(). */
+/* ============================================================================================================================================================= *\
+        Push Count records of Length bytes, numbered from Number: the number (4 bytes), then bytes derived from it. Return the number of records accepted.
+\* ============================================================================================================================================================= */
+static UINT32 test_push(UINT32 Number, UINT32 Count, UINT16 Length)
+{
+  UINT8 Data[QUEUE_MAX_RECORD];
+
+  UINT16 Loop1UInt16;
+
+  UINT32 Loop1UInt32;
+
+
+  for (Loop1UInt32 = 0; Loop1UInt32 < Count; ++Loop1UInt32, ++Number)
+  {
+    memcpy(Data, &Number, sizeof(Number));
+    for (Loop1UInt16 = sizeof(Number); Loop1UInt16 < Length; ++Loop1UInt16)
+      Data[Loop1UInt16] = (UINT8)(Number + Loop1UInt16);
+
+    if (wifi_queue_push(Data, Length) != 0) break;
+  }
+
+  return Loop1UInt32;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_sender(). */
+/* ============================================================================================================================================================= *\
+         Sender of the test: check that the records of a batch follow the last one received and that their content matches their number, then acknowledge
+                        the batch at once. With FlagHold, the batch is taken but its outcome never given, as when the connection is lost.
+\* ============================================================================================================================================================= */
+static INT16 test_sender(const struct struct_queue_batch *Batch, void *Context)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+
+  UINT32 Number;
+
+
+  ++Receiver.Batches;
+  if (Receiver.FlagHold) return 0;
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Batch->Count; ++Loop1UInt16)
+  {
+    memcpy(&Number, Batch->Data[Loop1UInt16], sizeof(Number));
+    if (Number != Receiver.Expected) ++Receiver.Errors;
+
+    for (Loop2UInt16 = sizeof(Number); Loop2UInt16 < Batch->Length[Loop1UInt16]; ++Loop2UInt16)
+    {
+      if (Batch->Data[Loop1UInt16][Loop2UInt16] != (UINT8)(Number + Loop2UInt16))
+      {
+        ++Receiver.Errors;
+        break;
+      }
+    }
+
+    Receiver.Expected = Number + 1;
+    ++Receiver.Records;
+  }
+
+  wifi_queue_done(0);
+
+  return 0;
+}
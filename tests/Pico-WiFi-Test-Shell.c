@@ -0,0 +1,486 @@
+/* ============================================================================================================================================================= *\
+   Pico-WiFi-Test-Shell.c
+   St-Louys Andre - October 2026
+   astlouys@gmail.com
+   Revision 18-OCT-2026
+   Langage: C
+   Version 1.00
+
+   Host test of the network command shell (Pico-WiFi-Shell.c) over lwIP's loopback netif (127.0.0.1), built by tests/CMakeLists.txt
+   with a short SHELL_IDLE_SEC. The test connects as a client and runs a command table of its own ("echo" and "log").
+   - Line editing: telnet negotiation is skipped, <Backspace> and <Del> erase the last character, words are split on spaces and
+     <CR><LF> ends one line only (a single prompt). Lines sent in one segment run one after the other.
+   - Unknown command: answered with a message and a new prompt.
+   - Output mirroring: log_info() output produced while a command runs reaches the session (<CR> sent as <CR><LF>); nothing is
+     sent outside of a command.
+   - Disconnect: "quit" says goodbye and closes the connection; a peer closing its side frees the session.
+   - Idle time-out: a silent session is closed, not before SHELL_IDLE_SEC and within one poll interval after it.
+   Returns 0 when all checks pass.
+
+   NOTE:
+   This program is provided without any warranty of any kind. It is provided
+   simply to help the user develop his own program.
+
+   REVISION HISTORY:
+   =================
+   18-OCT-2026 1.00 - Initial release.
+\* ============================================================================================================================================================= */
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                               Include files.
+\* ============================================================================================================================================================= */
+#include "baseline.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+
+#include "Pico-WiFi-Shell.h"
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                                Definitions.
+\* ============================================================================================================================================================= */
+#define TEST_PORT             2323     // port of the shell under test.
+#define TEST_WAIT_MSEC        5000     // longest wait for a reply.
+#define TEST_QUIET_MSEC        200     // wait for output that must not come.
+#define TEST_BUFFER_SIZE      4096     // output of the shell kept by the test client.
+#define TEST_POLL_MSEC       (SHELL_POLL_TICKS * 500)  // lwIP poll interval of a session (idle sessions are closed from the poll).
+#define TEST_SLOW_MSEC        1000     // tolerance of the idle time-out, on top of one poll interval (lwIP slow timer ticks).
+#define TEST_COMMANDS        (sizeof(TestCommand) / sizeof(TestCommand[0]))
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                              Global variables.
+\* ============================================================================================================================================================= */
+static UINT16 Failures;
+
+/* Test client: output of the shell since the last test_client_clear(). */
+static struct
+{
+  UINT8  FlagConnected;
+  UINT16 Length;
+  UINT32 Closes;                               // connections closed or reset by the shell.
+  UCHAR  Buffer[TEST_BUFFER_SIZE + 1];         // always NUL-terminated.
+  struct tcp_pcb *Pcb;
+} Client;
+
+
+
+/* ============================================================================================================================================================= *\
+                                                                             Function prototypes.
+\* ============================================================================================================================================================= */
+/* Log info (used by the module under test), copied to the shell sessions running a command. */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...);
+
+/* Count and report a failed check. */
+static void test_check(UINT8 Condition, UCHAR *Text);
+
+/* Test client: forget the output received so far. */
+static void test_client_clear(void);
+
+/* Test client: connect to the shell. */
+static void test_client_connect(void);
+
+/* Test client: connection established. */
+static err_t test_client_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error);
+
+/* Test client: count the occurrences of a text in the output received. */
+static UINT16 test_client_count(const UCHAR *Text);
+
+/* Test client: connection reset by the shell (pcb already freed by lwIP). */
+static void test_client_error(void *Arg, err_t Error);
+
+/* Test client: data received. */
+static err_t test_client_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error);
+
+/* Test client: send a text to the shell. */
+static void test_client_send(const UCHAR *Text, UINT16 Length);
+
+/* Test command: display each argument between brackets. */
+static void test_echo(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Test command: display a line with log_info(). */
+static void test_log(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv);
+
+/* Service lwIP (loopback netif and timeouts) until a text is received, a counter reaches its target or the specified time has elapsed. */
+static void test_run(UINT32 Msec, const UCHAR *Text, UINT32 *Counter, UINT32 Target);
+
+
+/* Command table given to the shell. */
+static const struct struct_shell_command TestCommand[] =
+{
+  {"echo", "echo <words>: display each word between brackets.",  test_echo},
+  {"log",  "log <word>: display a line with log_info().",        test_log}
+};
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=log_info(). */
+/* ============================================================================================================================================================= *\
+                   Log info (used by the module under test). As on the PicoW, the line is also copied to the shell sessions running a command.
+\* ============================================================================================================================================================= */
+void log_info(UINT LineNumber, const UCHAR *FunctionName, UCHAR *Format, ...)
+{
+  UCHAR Line[256];
+
+  INT16 Length;
+
+  va_list Arguments;
+
+
+  va_start(Arguments, Format);
+  Length = vsnprintf(Line, sizeof(Line), Format, Arguments);
+  va_end(Arguments);
+  if (Length < 0) return;
+  if (Length >= sizeof(Line)) Length = sizeof(Line) - 1;
+
+  printf("[%5u] %s() - %s\n", LineNumber, FunctionName, Line);
+  wifi_shell_mirror(Line, Length);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main(). */
+/* ============================================================================================================================================================= *\
+                                                                    Main program entry point.
+\* ============================================================================================================================================================= */
+int main(void)
+{
+  UINT32 Closes;
+
+  UINT64 Elapsed;
+  UINT64 StartTime;
+
+  struct struct_shell_stats Stats;
+
+
+  lwip_init();
+  netif_set_default(netif_list);
+
+  test_check(wifi_shell_start(TEST_PORT, TestCommand, TEST_COMMANDS, NULL) == 0, "shell listening");
+
+  /* Connection: banner and prompt. */
+  test_client_connect();
+  test_check(Client.FlagConnected && (strstr(Client.Buffer, "Pico-WiFi shell") != NULL) && (strstr(Client.Buffer, SHELL_PROMPT) != NULL), "banner and prompt received");
+
+  /* Line editing: telnet negotiation, <Backspace>, <Del>, extra spaces, <CR><LF>. */
+  test_client_clear();
+  test_client_send("\xFF\xFD\x03" "echp\bo ab\x7F\x7Fxy  z\r\n", 0);
+  test_run(TEST_WAIT_MSEC, "<xy><z>\r\n" SHELL_PROMPT, NULL, 0);
+  test_check(strcmp(Client.Buffer, "<xy><z>\r\n" SHELL_PROMPT) == 0, "line edited: telnet bytes skipped, characters erased, words split");
+  test_run(TEST_QUIET_MSEC, NULL, NULL, 0);
+  test_check(test_client_count(SHELL_PROMPT) == 1, "<CR><LF> ends one line only");
+
+  /* Two lines in one segment. */
+  test_client_clear();
+  test_client_send("echo 1\recho 2\r", 0);
+  test_run(TEST_WAIT_MSEC, "<2>\r\n" SHELL_PROMPT, NULL, 0);
+  test_check(strcmp(Client.Buffer, "<1>\r\n" SHELL_PROMPT "<2>\r\n" SHELL_PROMPT) == 0, "lines of one segment run in order");
+
+  /* Unknown command. */
+  test_client_clear();
+  test_client_send("bogus 1 2\r", 0);
+  test_run(TEST_WAIT_MSEC, SHELL_PROMPT, NULL, 0);
+  test_check((strstr(Client.Buffer, "Unknown command <bogus>") != NULL) && (test_client_count(SHELL_PROMPT) == 1), "unknown command answered, new prompt");
+
+  /* Output mirroring: only while a command runs. */
+  test_client_clear();
+  test_client_send("log 42\r", 0);
+  test_run(TEST_WAIT_MSEC, SHELL_PROMPT, NULL, 0);
+  test_check(strcmp(Client.Buffer, "mirrored 42\r\n" SHELL_PROMPT) == 0, "log_info() output of a command copied to the session");
+  test_client_clear();
+  log_info(__LINE__, __func__, "not a command\r");
+  test_run(TEST_QUIET_MSEC, NULL, NULL, 0);
+  test_check(Client.Length == 0, "log_info() output outside of a command not copied");
+
+  /* "quit" closes the connection. */
+  test_client_clear();
+  Closes = Client.Closes;
+  test_client_send("quit\r", 0);
+  test_run(TEST_WAIT_MSEC, NULL, &Client.Closes, Closes + 1);
+  test_check((strstr(Client.Buffer, "Bye.") != NULL) && (Client.Closes == (Closes + 1)), "quit: goodbye, then connection closed by the shell");
+  wifi_shell_get_stats(&Stats);
+  test_check((Stats.Sessions == 0) && (Stats.Accepted == 1) && (Stats.Commands == 6), "quit: session freed, commands counted");
+
+  /* Peer closes its side. */
+  test_client_connect();
+  tcp_recv(Client.Pcb, NULL);
+  tcp_err(Client.Pcb,  NULL);
+  tcp_close(Client.Pcb);
+  Client.Pcb = NULL;
+  test_run(TEST_QUIET_MSEC, NULL, NULL, 0);
+  wifi_shell_get_stats(&Stats);
+  test_check((Stats.Sessions == 0) && (Stats.Accepted == 2), "peer close: session freed");
+
+  /* Idle time-out. */
+  test_client_connect();
+  test_client_clear();
+  Closes    = Client.Closes;
+  StartTime = WIFI_TIME_US();
+  test_run((SHELL_IDLE_SEC * 1000) + TEST_POLL_MSEC + TEST_WAIT_MSEC, NULL, &Client.Closes, Closes + 1);
+  Elapsed = WIFI_TIME_US() - StartTime;
+  log_info(__LINE__, __func__, "Idle session closed after %llu msec (SHELL_IDLE_SEC %u).", Elapsed / 1000, SHELL_IDLE_SEC);
+  test_check((strstr(Client.Buffer, "Idle time-out") != NULL) && (Client.Closes == (Closes + 1)), "idle session closed by the shell");
+  test_check((Elapsed >= (SHELL_IDLE_SEC * 1000000ull)) && (Elapsed <= (((SHELL_IDLE_SEC * 1000ull) + TEST_POLL_MSEC + TEST_SLOW_MSEC) * 1000)), "idle time-out within one poll interval");
+  wifi_shell_get_stats(&Stats);
+  test_check(Stats.Sessions == 0, "idle time-out: session freed");
+
+  wifi_shell_stop();
+  log_info(__LINE__, __func__, "%u failure(s).", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_check(). */
+/* ============================================================================================================================================================= *\
+                                                                 Count and report a failed check.
+\* ============================================================================================================================================================= */
+static void test_check(UINT8 Condition, UCHAR *Text)
+{
+  log_info(__LINE__, __func__, "%s: %s", Condition ? "PASS" : "FAIL", Text);
+  if (!Condition) ++Failures;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_clear(). */
+/* ============================================================================================================================================================= *\
+                                                         Test client: forget the output received so far.
+\* ============================================================================================================================================================= */
+static void test_client_clear(void)
+{
+  Client.Length    = 0;
+  Client.Buffer[0] = 0x00;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_connect(). */
+/* ============================================================================================================================================================= *\
+                                                    Test client: connect to the shell and wait for its prompt.
+\* ============================================================================================================================================================= */
+static void test_client_connect(void)
+{
+  ip_addr_t Address;
+
+
+  test_client_clear();
+  Client.FlagConnected = FLAG_OFF;
+  ip_addr_set_loopback(0, &Address);
+
+  Client.Pcb = tcp_new_ip_type(IPADDR_TYPE_V4);
+  tcp_recv(Client.Pcb, test_client_receive);
+  tcp_err(Client.Pcb,  test_client_error);
+  tcp_connect(Client.Pcb, &Address, TEST_PORT, test_client_connected);
+  test_run(TEST_WAIT_MSEC, SHELL_PROMPT, NULL, 0);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_connected(). */
+/* ============================================================================================================================================================= *\
+                                                               Test client: connection established.
+\* ============================================================================================================================================================= */
+static err_t test_client_connected(void *Arg, struct tcp_pcb *Pcb, err_t Error)
+{
+  Client.FlagConnected = FLAG_ON;
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_count(). */
+/* ============================================================================================================================================================= *\
+                                               Test client: count the occurrences of a text in the output received.
+\* ============================================================================================================================================================= */
+static UINT16 test_client_count(const UCHAR *Text)
+{
+  UCHAR *Pointer;
+
+  UINT16 Count;
+
+
+  Count = 0;
+  for (Pointer = strstr(Client.Buffer, Text); Pointer != NULL; Pointer = strstr(Pointer + strlen(Text), Text)) ++Count;
+
+  return Count;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_error(). */
+/* ============================================================================================================================================================= *\
+                                             Test client: connection reset by the shell (pcb already freed by lwIP).
+\* ============================================================================================================================================================= */
+static void test_client_error(void *Arg, err_t Error)
+{
+  Client.Pcb = NULL;
+  ++Client.Closes;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_receive(). */
+/* ============================================================================================================================================================= *\
+                 Test client: data received, appended to the output. The shell closing the connection is counted and the client closes its side.
+\* ============================================================================================================================================================= */
+static err_t test_client_receive(void *Arg, struct tcp_pcb *Pcb, struct pbuf *PBuf, err_t Error)
+{
+  UINT16 Length;
+
+
+  if (PBuf == NULL)
+  {
+    ++Client.Closes;
+    Client.Pcb = NULL;
+    tcp_close(Pcb);
+    return ERR_OK;
+  }
+
+  Length = PBuf->tot_len;
+  if (Length > (TEST_BUFFER_SIZE - Client.Length)) Length = TEST_BUFFER_SIZE - Client.Length;
+  Client.Length += pbuf_copy_partial(PBuf, &Client.Buffer[Client.Length], Length, 0);
+  Client.Buffer[Client.Length] = 0x00;
+
+  tcp_recved(Pcb, PBuf->tot_len);
+  pbuf_free(PBuf);
+
+  return ERR_OK;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_client_send(). */
+/* ============================================================================================================================================================= *\
+                                                 Test client: send a text to the shell (Length 0: up to its end).
+\* ============================================================================================================================================================= */
+static void test_client_send(const UCHAR *Text, UINT16 Length)
+{
+  if (Client.Pcb == NULL) return;
+
+  if (Length == 0) Length = strlen(Text);
+  tcp_write(Client.Pcb, Text, Length, TCP_WRITE_FLAG_COPY);
+  tcp_output(Client.Pcb);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_echo(). */
+/* ============================================================================================================================================================= *\
+                                                      Test command: display each argument between brackets.
+\* ============================================================================================================================================================= */
+static void test_echo(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  UINT8 Loop1UInt8;
+
+
+  for (Loop1UInt8 = 1; Loop1UInt8 < Argc; ++Loop1UInt8)
+    wifi_shell_printf(Session, "<%s>", Argv[Loop1UInt8]);
+  wifi_shell_printf(Session, "\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_log(). */
+/* ============================================================================================================================================================= *\
+                                  Test command: display a line with log_info(), as the display functions of the application do.
+\* ============================================================================================================================================================= */
+static void test_log(struct struct_shell_session *Session, UINT8 Argc, UCHAR **Argv)
+{
+  log_info(__LINE__, __func__, "mirrored %s\r", (Argc > 1) ? Argv[1] : (UCHAR *)"");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=test_run(). */
+/* ============================================================================================================================================================= *\
+               Service lwIP (loopback netif and timeouts) until a text is received, a counter reaches its target or the specified time has elapsed.
+\* ============================================================================================================================================================= */
+static void test_run(UINT32 Msec, const UCHAR *Text, UINT32 *Counter, UINT32 Target)
+{
+  UINT64 EndTime;
+
+  struct timespec Delay = {0, 1000000};
+
+
+  EndTime = WIFI_TIME_US() + (Msec * 1000ull);
+  while (WIFI_TIME_US() < EndTime)
+  {
+    netif_poll_all();
+    sys_check_timeouts();
+    nanosleep(&Delay, NULL);
+
+    if ((Text != NULL) && (strstr(Client.Buffer, Text) != NULL)) break;
+    if ((Counter != NULL) && (*Counter >= Target)) break;
+  }
+
+  return;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+# ==========================================================================================================================================
+# wifi_export_decode.py
+# St-Louys Andre - October 2026
+# astlouys@gmail.com
+# Revision 18-OCT-2026
+#
+# Host-side decoder of the binary export stream of Pico-WiFi-Export.c (export mode "binary", menu option 19 or WIFI_EXPORT=binary).
+# Reads a raw capture of the Pico USB serial output (file or stdin), skips the text lines mixed with the records,
+# checks the CRC-8 of each record and prints the records as CSV (same columns as export mode "csv") or as JSON Lines.
+#
+# Usage:  python3 wifi_export_decode.py [--json] [capture_file]
+#         (for example, capture with:  cat /dev/ttyACM0 > capture.bin)
+#
+# REVISION HISTORY:
+# =================
+# 18-OCT-2026 1.00 - Initial release.
+# ==========================================================================================================================================
+import argparse
+import json
+import struct
+import sys
+
+EXPORT_SYNC = 0xA5
+
+RECORD_SCAN_BEGIN = 0x01
+RECORD_SCAN_ENTRY = 0x02
+RECORD_STATUS     = 0x03
+
+
+def crc8(data):
+    """CRC-8, polynomial 0x07, initial value 0x00 (same as export_crc8())."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def mac_string(data):
+    return ":".join("%02X" % byte for byte in data)
+
+
+def decode_record(record_type, payload):
+    """Return a dictionary for a record, or None for an unknown type or a payload too short."""
+    if record_type == RECORD_SCAN_BEGIN and len(payload) >= 6:
+        version, count, uptime = struct.unpack_from("<BBI", payload)
+        return {"type": "scan_begin", "version": version, "count": count, "uptime_ms": uptime}
+
+    if record_type == RECORD_SCAN_ENTRY and len(payload) >= 10:
+        index, rssi, channel, security = struct.unpack_from("<BbBB", payload)
+        return {"type": "scan", "index": index, "ssid": payload[10:].decode("utf-8", "replace"), "rssi": rssi,
+                "channel": channel, "security": security, "mac": mac_string(payload[4:10])}
+
+    if record_type == RECORD_STATUS and len(payload) >= 29:
+        uptime = struct.unpack_from("<I", payload, 0)[0]
+        rssi, link, health, total_errors, link_drops, reconnects = struct.unpack_from("<bbBIII", payload, 14)
+        return {"type": "status", "uptime_ms": uptime, "ip": ".".join(str(byte) for byte in payload[4:8]),
+                "mac": mac_string(payload[8:14]), "rssi": rssi, "link": link, "health": health, "total_errors": total_errors,
+                "link_drops": link_drops, "reconnects": reconnects, "ssid": payload[29:].decode("utf-8", "replace")}
+
+    return None
+
+
+def records(stream):
+    """Yield (type, payload) of each valid record found in the byte stream."""
+    position = 0
+    while True:
+        position = stream.find(bytes([EXPORT_SYNC]), position)
+        if position < 0 or position + 4 > len(stream):
+            return
+        record_type = stream[position + 1]
+        length      = stream[position + 2]
+        end         = position + 3 + length
+        if end < len(stream) and crc8(stream[position + 1:end]) == stream[end]:
+            yield record_type, stream[position + 3:end]
+            position = end + 1
+        else:
+            position += 1  # not a record (0xA5 in text, or corrupted record): resynchronize on next sync byte.
+
+
+def csv_line(record):
+    def quoted(text):
+        return '"' + text.replace('"', '""') + '"'
+
+    if record["type"] == "scan_begin":
+        return "scan_begin,%u,%u,%u" % (record["version"], record["count"], record["uptime_ms"])
+    if record["type"] == "scan":
+        return "scan,%u,%s,%d,%u,%u,%s" % (record["index"], quoted(record["ssid"]), record["rssi"], record["channel"],
+                                           record["security"], record["mac"])
+    return "status,%u,%s,%s,%d,%d,%u,%u,%u,%u,%s" % (record["uptime_ms"], record["ip"], record["mac"], record["rssi"], record["link"],
+                                                     record["health"], record["total_errors"], record["link_drops"],
+                                                     record["reconnects"], quoted(record["ssid"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary export stream of Pico-WiFi-Export.")
+    parser.add_argument("--json", action="store_true", help="print JSON Lines instead of CSV")
+    parser.add_argument("capture", nargs="?", help="raw capture of the Pico serial output (default: stdin)")
+    arguments = parser.parse_args()
+
+    if arguments.capture:
+        with open(arguments.capture, "rb") as capture:
+            stream = capture.read()
+    else:
+        stream = sys.stdin.buffer.read()
+
+    for record_type, payload in records(stream):
+        record = decode_record(record_type, payload)
+        if record is None:
+            continue
+        print(json.dumps(record) if arguments.json else csv_line(record))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# ==========================================================================================================================================
+# wifi_http_sink.py
+# St-Louys Andre - October 2026
+# astlouys@gmail.com
+# Revision 18-OCT-2026
+#
+# Host-side HTTP/1.1 server for the HTTP client benchmark of Pico-WiFi-Example (menu option 23, Pico-WiFi-HTTP.c).
+# Accepts any request, reads the body (Content-Length or chunked transfer encoding) and answers "204 No Content",
+# keeping the connection alive unless the client asks otherwise. Pipelined requests are answered in order.
+# One line is printed per connection when it ends: requests carried, body bytes received, chunks and duration.
+#
+# Usage:  python3 wifi_http_sink.py [--port 8080] [--verbose]
+#
+# REVISION HISTORY:
+# =================
+# 18-OCT-2026 1.00 - Initial release.
+# ==========================================================================================================================================
+import argparse
+import http.server
+import socketserver
+import time
+
+
+class SinkHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # keep-alive by default.
+
+    def setup(self):
+        super().setup()
+        self.requests = 0
+        self.bytes    = 0
+        self.chunks   = 0
+        self.start    = time.monotonic()
+
+    def finish(self):
+        super().finish()
+        print("%s:%u  %u requests, %u body bytes (%u chunks) in %.1f sec" % (self.client_address[0], self.client_address[1], self.requests,
+                                                                             self.bytes, self.chunks, time.monotonic() - self.start))
+
+    def read_body(self):
+        """Read the request body, return its length."""
+        if "chunked" in self.headers.get("Transfer-Encoding", "").lower():
+            length = 0
+            while True:
+                size = int(self.rfile.readline().split(b";")[0].strip(), 16)
+                if size == 0:
+                    while self.rfile.readline() not in (b"\r\n", b"\n", b""):
+                        pass   # trailer.
+                    return length
+                self.rfile.read(size)
+                self.rfile.readline()
+                length      += size
+                self.chunks += 1
+        length = int(self.headers.get("Content-Length", 0))
+        self.rfile.read(length)
+        return length
+
+    def handle_any(self):
+        self.requests += 1
+        self.bytes    += self.read_body()
+        self.send_response(204)
+        self.send_header("Keep-Alive", "timeout=5")
+        self.end_headers()
+
+    do_GET    = handle_any
+    do_HEAD   = handle_any
+    do_POST   = handle_any
+    do_PUT    = handle_any
+    do_DELETE = handle_any
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+
+class SinkServer(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads      = True
+    allow_reuse_address = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP/1.1 sink for the HTTP client benchmark of Pico-WiFi-Example.")
+    parser.add_argument("--port", type=int, default=8080, help="TCP port to listen on (default: 8080)")
+    parser.add_argument("--verbose", action="store_true", help="print one line per request")
+    arguments = parser.parse_args()
+
+    server = SinkServer(("", arguments.port), SinkHandler)
+    server.verbose = arguments.verbose
+    print("Listening on port %u (Ctrl-C to stop)." % arguments.port)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
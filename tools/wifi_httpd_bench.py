@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# ==========================================================================================================================================
+# wifi_httpd_bench.py
+# St-Louys Andre - October 2026
+# astlouys@gmail.com
+# Revision 18-OCT-2026
+#
+# Host-side load generator for the HTTP status server of Pico-WiFi-Example (Pico-WiFi-HTTPD.c, menu option 24).
+# Each client sends the given paths in turn for the given duration, on one kept-alive connection (or a new connection per request
+# with --close), and the requests per second, latency and status codes of all clients are printed at the end.
+# Compare the result with the service time and byte counters shown by option 24 (or shell "httpd").
+#
+# Usage:  python3 wifi_httpd_bench.py <Pico IP address> [--port 80] [--clients 1] [--seconds 10] [--close] [path ...]
+#         (default paths: / /style.css /status.js /status.json /scan.json)
+#
+# REVISION HISTORY:
+# =================
+# 18-OCT-2026 1.00 - Initial release.
+# ==========================================================================================================================================
+import argparse
+import collections
+import http.client
+import threading
+import time
+
+
+def client(arguments, results, lock):
+    """Send requests until the end of the test, add counters to results."""
+    status     = collections.Counter()
+    latency    = []
+    received   = 0
+    connection = None
+    end        = time.monotonic() + arguments.seconds
+    number     = 0
+    while time.monotonic() < end:
+        path = arguments.paths[number % len(arguments.paths)]
+        number += 1
+        try:
+            if connection is None:
+                connection = http.client.HTTPConnection(arguments.host, arguments.port, timeout=5)
+            headers = {"Accept-Encoding": "gzip"}
+            if arguments.close:
+                headers["Connection"] = "close"
+            start = time.monotonic()
+            connection.request("GET", path, headers=headers)
+            response = connection.getresponse()
+            received += len(response.read())
+            latency.append(time.monotonic() - start)
+            status[response.status] += 1
+            if arguments.close or response.will_close:
+                connection.close()
+                connection = None
+        except (OSError, http.client.HTTPException) as error:
+            status[type(error).__name__] += 1
+            if connection is not None:
+                connection.close()
+            connection = None
+    if connection is not None:
+        connection.close()
+
+    with lock:
+        results["status"].update(status)
+        results["latency"].extend(latency)
+        results["bytes"] += received
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Requests per second of the HTTP status server of Pico-WiFi-Example.")
+    parser.add_argument("host", help="IP address of the Pico")
+    parser.add_argument("--port", type=int, default=80, help="TCP port of the status server (default: 80)")
+    parser.add_argument("--clients", type=int, default=1, help="concurrent connections (default: 1, the server has 3)")
+    parser.add_argument("--seconds", type=float, default=10, help="duration of the test (default: 10)")
+    parser.add_argument("--close", action="store_true", help="new connection for each request instead of keep-alive")
+    parser.add_argument("paths", nargs="*", default=["/", "/style.css", "/status.js", "/status.json", "/scan.json"])
+    arguments = parser.parse_intermixed_args()
+
+    results = {"status": collections.Counter(), "latency": [], "bytes": 0}
+    lock    = threading.Lock()
+    threads = [threading.Thread(target=client, args=(arguments, results, lock)) for _ in range(arguments.clients)]
+    start   = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+
+    latency = sorted(results["latency"])
+    print("%u requests in %.1f sec: %.1f requests/sec, %.1f kbytes/sec (%s)" %
+          (len(latency), elapsed, len(latency) / elapsed, results["bytes"] / elapsed / 1000,
+           "new connection per request" if arguments.close else "keep-alive"))
+    if latency:
+        print("Latency: average %.1f msec, median %.1f msec, max %.1f msec" %
+              (1000 * sum(latency) / len(latency), 1000 * latency[len(latency) // 2], 1000 * latency[-1]))
+    print("Status: " + ", ".join("%s: %u" % (key, count) for key, count in sorted(results["status"].items(), key=str)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# ==========================================================================================================================================
+# wifi_httpd_content.py
+# St-Louys Andre - October 2026
+# astlouys@gmail.com
+# Revision 18-OCT-2026
+#
+# Build-time generator of the content served from flash by Pico-WiFi-HTTPD.c (run by CMakeLists.txt, pico_httpd_content library).
+# Each file becomes one constant array holding its complete HTTP response: head (Content-Type, Content-Length, ETag...) followed by the
+# body, gzip-compressed when that makes it smaller. The server hands the array to TCP by reference, so nothing is copied to RAM.
+# Server-side include templates (.shtml) are stored as is: their <!--#tag--> comments are replaced by the server while sending.
+#
+# Usage:  python3 wifi_httpd_content.py --output httpd_content.c [--max-age 300] file ...
+#         (files are served under their base name: httpd/index.html is "/index.html")
+#
+# REVISION HISTORY:
+# =================
+# 18-OCT-2026 1.00 - Initial release.
+# ==========================================================================================================================================
+import argparse
+import gzip
+import os
+import zlib
+
+CONTENT_TYPES = {
+    ".css":   "text/css",
+    ".html":  "text/html",
+    ".ico":   "image/x-icon",
+    ".js":    "text/javascript",
+    ".json":  "application/json",
+    ".png":   "image/png",
+    ".shtml": "text/html",
+    ".svg":   "image/svg+xml",
+    ".txt":   "text/plain",
+}
+
+HTTPD_FILE_GZIP = 0x01
+HTTPD_FILE_SSI  = 0x02
+
+
+def c_array(name, data):
+    """Return the C definition of a constant byte array."""
+    lines = ["static const UCHAR %s[%u] =\n{" % (name, len(data))]
+    for offset in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02X" % byte for byte in data[offset:offset + 16]) + ",")
+    lines.append("};\n")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the flash content of Pico-WiFi-HTTPD.")
+    parser.add_argument("--output", required=True, help="C file to generate")
+    parser.add_argument("--max-age", type=int, default=300, help="Cache-Control max-age of static files, in seconds (default: 300)")
+    parser.add_argument("files", nargs="+")
+    arguments = parser.parse_args()
+
+    arrays  = []
+    entries = []
+    total   = [0, 0]   # original size, size in flash.
+    for number, path in enumerate(sorted(arguments.files, key=os.path.basename)):
+        name      = "/" + os.path.basename(path)
+        extension = os.path.splitext(path)[1].lower()
+        with open(path, "rb") as file:
+            body = file.read()
+        content_type = CONTENT_TYPES.get(extension, "application/octet-stream")
+
+        if extension == ".shtml":
+            flags = HTTPD_FILE_SSI
+            head  = b""
+            data  = body
+            etag  = 0      # templates are rendered at each request.
+            comment = "%u bytes, server-side include template" % len(body)
+        else:
+            flags      = 0
+            compressed = gzip.compress(body, compresslevel=9, mtime=0)
+            encoding   = ""
+            if len(compressed) < len(body):
+                flags    = HTTPD_FILE_GZIP
+                encoding = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n"
+                comment  = "%u bytes, %u gzip" % (len(body), len(compressed))
+                body     = compressed
+            else:
+                comment  = "%u bytes, not compressed" % len(body)
+            etag = zlib.crc32(body)
+            head = ("HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %u\r\n%sCache-Control: max-age=%u\r\nETag: \"%08x\"\r\n\r\n" %
+                    (content_type, len(body), encoding, arguments.max_age, etag)).encode()
+            data = head + body
+        total[0] += os.path.getsize(path)
+        total[1] += len(data)
+
+        arrays.append("/* %s: %s. */\n" % (name, comment) + c_array("HttpdData%u" % number, data))
+        entries.append("  {\"%s\", %-20s HttpdData%u, sizeof(HttpdData%u), %3u, 0x%08XUL, 0x%02X}" %
+                       (name, "\"%s\"," % content_type, number, number, len(head), etag, flags))
+
+    with open(arguments.output, "w") as output:
+        output.write("/* Generated by tools/wifi_httpd_content.py from %u files (%u bytes, %u in flash, response heads included). Do not edit. */\n" %
+                     (len(entries), total[0], total[1]))
+        output.write("#include \"Pico-WiFi-HTTPD.h\"\n\n\n")
+        output.write("\n\n".join(arrays))
+        output.write("\n\nconst struct struct_httpd_file HttpdFile[] =\n{\n%s\n};\n\n" % ",\n".join(entries))
+        output.write("const UINT8 HttpdFileCount = %u;\n" % len(entries))
+
+
+if __name__ == "__main__":
+    main()